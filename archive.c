@@ -0,0 +1,513 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "archive.h"
+
+// The fields of a tar header, by offset and length.
+#define INCALESCENT_ARCHIVE_TAR_NAME 0
+#define INCALESCENT_ARCHIVE_TAR_NAME_LENGTH 100
+#define INCALESCENT_ARCHIVE_TAR_SIZE 124
+#define INCALESCENT_ARCHIVE_TAR_MTIME 136
+#define INCALESCENT_ARCHIVE_TAR_NUMBER_LENGTH 12
+#define INCALESCENT_ARCHIVE_TAR_CHECKSUM 148
+#define INCALESCENT_ARCHIVE_TAR_CHECKSUM_LENGTH 8
+#define INCALESCENT_ARCHIVE_TAR_TYPE 156
+#define INCALESCENT_ARCHIVE_TAR_MAGIC 257
+#define INCALESCENT_ARCHIVE_TAR_PREFIX 345
+#define INCALESCENT_ARCHIVE_TAR_PREFIX_LENGTH 155
+
+// The types of tar members that matter here. Every other type is skipped.
+#define INCALESCENT_ARCHIVE_TAR_TYPE_FILE '0'
+#define INCALESCENT_ARCHIVE_TAR_TYPE_OLD_FILE '\0'
+#define INCALESCENT_ARCHIVE_TAR_TYPE_CONTIGUOUS '7'
+#define INCALESCENT_ARCHIVE_TAR_TYPE_LONG_NAME 'L'
+#define INCALESCENT_ARCHIVE_TAR_TYPE_PAX 'x'
+
+#define INCALESCENT_ARCHIVE_GZIP_HEADER_SIZE 10
+#define INCALESCENT_ARCHIVE_GZIP_METHOD_DEFLATE 8
+#define INCALESCENT_ARCHIVE_GZIP_FLAG_HCRC 0x02
+#define INCALESCENT_ARCHIVE_GZIP_FLAG_EXTRA 0x04
+#define INCALESCENT_ARCHIVE_GZIP_FLAG_NAME 0x08
+#define INCALESCENT_ARCHIVE_GZIP_FLAG_COMMENT 0x10
+
+#define INCALESCENT_ARCHIVE_BAD_FORMAT HRESULT_FROM_WIN32(ERROR_BAD_FORMAT)
+
+// Reads a little-endian integer of up to 8 bytes.
+static ULONGLONG INCALESCENT_Archive_Read(const BYTE *data, DWORD width) {
+    ULONGLONG value = 0;
+    for (DWORD index = 0; index < width; index++) {
+        value |= (ULONGLONG) data[index] << (8 * index);
+    }
+    return value;
+}
+
+static BOOL INCALESCENT_Archive_InRange(SIZE_T size, ULONGLONG offset, ULONGLONG length) {
+    return offset <= size && length <= size - offset;
+}
+
+static BOOL INCALESCENT_Archive_EndsWith(PCWSTR path, SIZE_T pathLength, PCWSTR extension) {
+    SIZE_T extensionLength = lstrlenW(extension);
+    return pathLength > extensionLength &&
+           CompareStringOrdinal(path + (pathLength - extensionLength), (INT) extensionLength, extension, (INT) extensionLength, TRUE) == CSTR_EQUAL;
+}
+
+// Implementation for INCALESCENT_Archive_KindOf
+INCALESCENT_Archive_Kind INCALESCENT_Archive_KindOf(PCWSTR path) {
+    SIZE_T length = lstrlenW(path);
+    if (INCALESCENT_Archive_EndsWith(path, length, INCALESCENT_ARCHIVE_ZIP_EXTENSION)) {
+        return INCALESCENT_ARCHIVE_KIND_ZIP;
+    }
+    if (INCALESCENT_Archive_EndsWith(path, length, INCALESCENT_ARCHIVE_TAR_EXTENSION)) {
+        return INCALESCENT_ARCHIVE_KIND_TAR;
+    }
+    if (INCALESCENT_Archive_EndsWith(path, length, INCALESCENT_ARCHIVE_TAR_GZIP_EXTENSION) ||
+        INCALESCENT_Archive_EndsWith(path, length, INCALESCENT_ARCHIVE_TGZ_EXTENSION)) {
+        return INCALESCENT_ARCHIVE_KIND_TAR_GZIP;
+    }
+    return INCALESCENT_ARCHIVE_KIND_NONE;
+}
+
+// Takes the sizes and offset that didn't fit into a central directory entry from its Zip64 extra
+// field, where they are stored in that order, each only if it didn't fit.
+static HRESULT INCALESCENT_Archive_ReadZip64Extra(const BYTE *extra, SIZE_T extraLength, INCALESCENT_Archive_Member *member) {
+    for (SIZE_T offset = 0; offset + 4 <= extraLength;) {
+        DWORD id = (DWORD) INCALESCENT_Archive_Read(extra + offset, 2);
+        SIZE_T length = (SIZE_T) INCALESCENT_Archive_Read(extra + offset + 2, 2);
+        const BYTE *field = extra + offset + 4;
+        if (!INCALESCENT_Archive_InRange(extraLength, offset + 4, length)) {
+            return INCALESCENT_ARCHIVE_BAD_FORMAT;
+        }
+
+        if (id == INCALESCENT_ARCHIVE_ZIP64_EXTRA_ID) {
+            ULONGLONG *values[] = {&member->size, &member->compressedSize, &member->localHeaderOffset};
+            SIZE_T used = 0;
+            for (DWORD index = 0; index < ARRAYSIZE(values); index++) {
+                if (*values[index] != MAXDWORD) {
+                    continue;
+                }
+                if (used + 8 > length) {
+                    return INCALESCENT_ARCHIVE_BAD_FORMAT;
+                }
+                *values[index] = INCALESCENT_Archive_Read(field + used, 8);
+                used += 8;
+            }
+            return S_OK;
+        }
+        offset += 4 + length;
+    }
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Archive_ListZip
+HRESULT INCALESCENT_Archive_ListZip(const BYTE *data, SIZE_T size, INCALESCENT_Archive_MemberCallback callback, PVOID context) {
+    HRESULT result = S_OK;
+
+    // The end record is the last thing in the archive, but may be followed by a comment, so it is
+    // searched for backward.
+    if (size < 22) {
+        result = INCALESCENT_ARCHIVE_BAD_FORMAT;
+        goto cleanup;
+    }
+    SIZE_T end = size - 22;
+    SIZE_T lowest = end > INCALESCENT_ARCHIVE_ZIP_MAX_COMMENT ? end - INCALESCENT_ARCHIVE_ZIP_MAX_COMMENT : 0;
+    while (INCALESCENT_Archive_Read(data + end, 4) != INCALESCENT_ARCHIVE_ZIP_END_SIGNATURE) {
+        if (end == lowest) {
+            result = INCALESCENT_ARCHIVE_BAD_FORMAT;
+            goto cleanup;
+        }
+        end--;
+    }
+    ULONGLONG entryCount = INCALESCENT_Archive_Read(data + end + 10, 2);
+    ULONGLONG directorySize = INCALESCENT_Archive_Read(data + end + 12, 4);
+    ULONGLONG directoryOffset = INCALESCENT_Archive_Read(data + end + 16, 4);
+
+    // A Zip64 archive keeps the numbers that don't fit in a record of its own, found through a
+    // locator right in front of the end record.
+    if ((entryCount == 0xFFFF || directorySize == MAXDWORD || directoryOffset == MAXDWORD) && end >= 20 &&
+        INCALESCENT_Archive_Read(data + end - 20, 4) == INCALESCENT_ARCHIVE_ZIP64_LOCATOR_SIGNATURE) {
+        ULONGLONG zip64End = INCALESCENT_Archive_Read(data + end - 20 + 8, 8);
+        if (!INCALESCENT_Archive_InRange(size, zip64End, 56) ||
+            INCALESCENT_Archive_Read(data + zip64End, 4) != INCALESCENT_ARCHIVE_ZIP64_END_SIGNATURE) {
+            result = INCALESCENT_ARCHIVE_BAD_FORMAT;
+            goto cleanup;
+        }
+        entryCount = INCALESCENT_Archive_Read(data + zip64End + 32, 8);
+        directorySize = INCALESCENT_Archive_Read(data + zip64End + 40, 8);
+        directoryOffset = INCALESCENT_Archive_Read(data + zip64End + 48, 8);
+    }
+    if (!INCALESCENT_Archive_InRange(size, directoryOffset, directorySize)) {
+        result = INCALESCENT_ARCHIVE_BAD_FORMAT;
+        goto cleanup;
+    }
+
+    const BYTE *directory = data + directoryOffset;
+    SIZE_T offset = 0;
+    for (ULONGLONG index = 0; index < entryCount; index++) {
+        const BYTE *entry = directory + offset;
+        if (!INCALESCENT_Archive_InRange(directorySize, offset, 46) ||
+            INCALESCENT_Archive_Read(entry, 4) != INCALESCENT_ARCHIVE_ZIP_CENTRAL_SIGNATURE) {
+            result = INCALESCENT_ARCHIVE_BAD_FORMAT;
+            goto cleanup;
+        }
+        DWORD flags = (DWORD) INCALESCENT_Archive_Read(entry + 8, 2);
+        SIZE_T nameLength = (SIZE_T) INCALESCENT_Archive_Read(entry + 28, 2);
+        SIZE_T extraLength = (SIZE_T) INCALESCENT_Archive_Read(entry + 30, 2);
+        SIZE_T commentLength = (SIZE_T) INCALESCENT_Archive_Read(entry + 32, 2);
+        if (!INCALESCENT_Archive_InRange(directorySize, offset + 46, nameLength + extraLength + commentLength)) {
+            result = INCALESCENT_ARCHIVE_BAD_FORMAT;
+            goto cleanup;
+        }
+
+        INCALESCENT_Archive_Member member = {
+                .name = entry + 46,
+                .nameLength = nameLength,
+                .utf8 = (flags & INCALESCENT_ARCHIVE_ZIP_FLAG_UTF8) != 0,
+                .size = INCALESCENT_Archive_Read(entry + 24, 4),
+                .localHeaderOffset = INCALESCENT_Archive_Read(entry + 42, 4),
+                .compressedSize = INCALESCENT_Archive_Read(entry + 20, 4),
+                .method = (DWORD) INCALESCENT_Archive_Read(entry + 10, 2),
+                .crc = (DWORD) INCALESCENT_Archive_Read(entry + 16, 4),
+                .encrypted = (flags & INCALESCENT_ARCHIVE_ZIP_FLAG_ENCRYPTED) != 0,
+        };
+        FILETIME lastWriteTime = {0};
+        DosDateTimeToFileTime((WORD) INCALESCENT_Archive_Read(entry + 14, 2), (WORD) INCALESCENT_Archive_Read(entry + 12, 2), &lastWriteTime);
+        member.lastWriteTime = ((ULONGLONG) lastWriteTime.dwHighDateTime << 32) | lastWriteTime.dwLowDateTime;
+
+        result = INCALESCENT_Archive_ReadZip64Extra(entry + 46 + nameLength, extraLength, &member);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = callback(context, &member);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = S_OK;
+        offset += 46 + nameLength + extraLength + commentLength;
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Archive_ZipData
+HRESULT INCALESCENT_Archive_ZipData(const BYTE *data, SIZE_T size, const INCALESCENT_Archive_Member *member, const BYTE **memberData) {
+    ULONGLONG offset = member->localHeaderOffset;
+    if (!INCALESCENT_Archive_InRange(size, offset, 30) || INCALESCENT_Archive_Read(data + offset, 4) != INCALESCENT_ARCHIVE_ZIP_LOCAL_SIGNATURE) {
+        return INCALESCENT_ARCHIVE_BAD_FORMAT;
+    }
+
+    // The local header repeats the name, but its extra field may differ from the central one.
+    offset += 30 + INCALESCENT_Archive_Read(data + offset + 26, 2) + INCALESCENT_Archive_Read(data + offset + 28, 2);
+    if (!INCALESCENT_Archive_InRange(size, offset, member->compressedSize)) {
+        return INCALESCENT_ARCHIVE_BAD_FORMAT;
+    }
+    *memberData = data + offset;
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Archive_BeginTar
+void INCALESCENT_Archive_BeginTar(INCALESCENT_Archive_Tar *tar, INCALESCENT_Archive_MemberCallback onMember,
+                                  INCALESCENT_Archive_DataCallback onData, INCALESCENT_Archive_EndCallback onEnd, PVOID context) {
+    ZeroMemory(tar, sizeof(INCALESCENT_Archive_Tar));
+    tar->onMember = onMember;
+    tar->onData = onData;
+    tar->onEnd = onEnd;
+    tar->context = context;
+}
+
+// Parses a number of a tar header, which is octal text, or a big-endian binary number behind a byte
+// with its highest bit set if it doesn't fit.
+static ULONGLONG INCALESCENT_Archive_TarNumber(const BYTE *field, SIZE_T length) {
+    ULONGLONG value = 0;
+    if (field[0] & 0x80) {
+        for (SIZE_T index = 1; index < length; index++) {
+            value = (value << 8) | field[index];
+        }
+        return value;
+    }
+    for (SIZE_T index = 0; index < length && field[index] != '\0'; index++) {
+        if (field[index] >= '0' && field[index] <= '7') {
+            value = (value << 3) | (field[index] - '0');
+        }
+    }
+    return value;
+}
+
+static SIZE_T INCALESCENT_Archive_FieldLength(const BYTE *field, SIZE_T length) {
+    SIZE_T used = 0;
+    while (used < length && field[used] != '\0') {
+        used++;
+    }
+    return used;
+}
+
+// Takes the name out of the data of an extended header. A GNU long name is the data itself, while a
+// pax header is a list of "<length> <key>=<value>\n" records, one of which may be the path.
+static void INCALESCENT_Archive_ParseExtended(INCALESCENT_Archive_Tar *tar) {
+    const BYTE *data = tar->extendedData;
+    SIZE_T size = tar->extendedUsed;
+
+    if (tar->extendedType == INCALESCENT_ARCHIVE_TAR_TYPE_LONG_NAME) {
+        SIZE_T length = INCALESCENT_Archive_FieldLength(data, size);
+        tar->longNameLength = length < INCALESCENT_ARCHIVE_MAX_NAME ? length : 0;
+        CopyMemory(tar->longName, data, tar->longNameLength);
+        return;
+    }
+
+    for (SIZE_T offset = 0; offset < size;) {
+        SIZE_T recordLength = 0;
+        SIZE_T cursor = offset;
+        while (cursor < size && data[cursor] >= '0' && data[cursor] <= '9') {
+            recordLength = (recordLength * 10) + (data[cursor++] - '0');
+        }
+        if (recordLength == 0 || recordLength > size - offset || cursor == size || data[cursor] != ' ') {
+            return;
+        }
+
+        const BYTE *key = data + cursor + 1;
+        const BYTE *recordEnd = data + offset + recordLength - 1;
+        if (recordEnd - key > 5 && RtlEqualMemory(key, "path=", 5)) {
+            SIZE_T length = recordEnd - (key + 5);
+            if (length < INCALESCENT_ARCHIVE_MAX_NAME) {
+                CopyMemory(tar->longName, key + 5, length);
+                tar->longNameLength = length;
+            }
+        }
+        offset += recordLength;
+    }
+}
+
+// Ends the data of the current member.
+static HRESULT INCALESCENT_Archive_EndTarMember(INCALESCENT_Archive_Tar *tar) {
+    HRESULT result = S_OK;
+    if (tar->extendedType != 0) {
+        INCALESCENT_Archive_ParseExtended(tar);
+        tar->extendedType = 0;
+    } else if (tar->taken) {
+        result = tar->onEnd(tar->context);
+    }
+    tar->taken = FALSE;
+    tar->passing = FALSE;
+    return result;
+}
+
+// Parses a complete header block and starts its member.
+static HRESULT INCALESCENT_Archive_StartTarMember(INCALESCENT_Archive_Tar *tar) {
+    HRESULT result = S_OK;
+    const BYTE *header = tar->header;
+    BYTE name[INCALESCENT_ARCHIVE_TAR_PREFIX_LENGTH + 1 + INCALESCENT_ARCHIVE_TAR_NAME_LENGTH];
+
+    // The end of the archive is marked by blocks of zeros.
+    DWORD sum = 0;
+    for (SIZE_T index = 0; index < INCALESCENT_ARCHIVE_TAR_BLOCK_SIZE; index++) {
+        BOOL checksum = index >= INCALESCENT_ARCHIVE_TAR_CHECKSUM && index < INCALESCENT_ARCHIVE_TAR_CHECKSUM + INCALESCENT_ARCHIVE_TAR_CHECKSUM_LENGTH;
+        sum += checksum ? ' ' : header[index];
+    }
+    if (sum == ' ' * INCALESCENT_ARCHIVE_TAR_CHECKSUM_LENGTH) {
+        tar->finished = TRUE;
+        return S_FALSE;
+    }
+    if (sum != INCALESCENT_Archive_TarNumber(header + INCALESCENT_ARCHIVE_TAR_CHECKSUM, INCALESCENT_ARCHIVE_TAR_CHECKSUM_LENGTH)) {
+        return INCALESCENT_ARCHIVE_BAD_FORMAT;
+    }
+
+    ULONGLONG size = INCALESCENT_Archive_TarNumber(header + INCALESCENT_ARCHIVE_TAR_SIZE, INCALESCENT_ARCHIVE_TAR_NUMBER_LENGTH);
+    BYTE type = header[INCALESCENT_ARCHIVE_TAR_TYPE];
+    tar->remaining = size;
+    tar->padding = (INCALESCENT_ARCHIVE_TAR_BLOCK_SIZE - (size % INCALESCENT_ARCHIVE_TAR_BLOCK_SIZE)) % INCALESCENT_ARCHIVE_TAR_BLOCK_SIZE;
+
+    if (type == INCALESCENT_ARCHIVE_TAR_TYPE_LONG_NAME || type == INCALESCENT_ARCHIVE_TAR_TYPE_PAX) {
+        tar->extendedType = type;
+        tar->extendedUsed = 0;
+        goto cleanup;
+    }
+    if (type != INCALESCENT_ARCHIVE_TAR_TYPE_FILE && type != INCALESCENT_ARCHIVE_TAR_TYPE_OLD_FILE && type != INCALESCENT_ARCHIVE_TAR_TYPE_CONTIGUOUS) {
+        tar->longNameLength = 0;
+        goto cleanup;
+    }
+
+    // A name from an extended header takes precedence. Otherwise a ustar header may split a long
+    // name into a prefix and the name.
+    INCALESCENT_Archive_Member member = {
+            .utf8 = TRUE,
+            .size = size,
+            .lastWriteTime = (INCALESCENT_Archive_TarNumber(header + INCALESCENT_ARCHIVE_TAR_MTIME, INCALESCENT_ARCHIVE_TAR_NUMBER_LENGTH) +
+                              INCALESCENT_ARCHIVE_UNIX_EPOCH) * INCALESCENT_ARCHIVE_TICKS_PER_SECOND,
+            .method = INCALESCENT_ARCHIVE_METHOD_STORED,
+            .compressedSize = size,
+    };
+    if (tar->longNameLength != 0) {
+        member.name = tar->longName;
+        member.nameLength = tar->longNameLength;
+    } else {
+        SIZE_T prefixLength = 0;
+        if (RtlEqualMemory(header + INCALESCENT_ARCHIVE_TAR_MAGIC, "ustar", 5)) {
+            prefixLength = INCALESCENT_Archive_FieldLength(header + INCALESCENT_ARCHIVE_TAR_PREFIX, INCALESCENT_ARCHIVE_TAR_PREFIX_LENGTH);
+        }
+        if (prefixLength != 0) {
+            CopyMemory(name, header + INCALESCENT_ARCHIVE_TAR_PREFIX, prefixLength);
+            name[prefixLength++] = '/';
+        }
+        SIZE_T nameLength = INCALESCENT_Archive_FieldLength(header + INCALESCENT_ARCHIVE_TAR_NAME, INCALESCENT_ARCHIVE_TAR_NAME_LENGTH);
+        CopyMemory(name + prefixLength, header + INCALESCENT_ARCHIVE_TAR_NAME, nameLength);
+        member.name = name;
+        member.nameLength = prefixLength + nameLength;
+    }
+
+    result = tar->onMember(tar->context, &member);
+    tar->longNameLength = 0;
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    tar->taken = result == S_OK;
+    tar->passing = tar->taken;
+    result = S_OK;
+    if (size == 0) {
+        result = INCALESCENT_Archive_EndTarMember(tar);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Archive_FeedTar
+HRESULT INCALESCENT_Archive_FeedTar(INCALESCENT_Archive_Tar *tar, const BYTE *data, SIZE_T size) {
+    HRESULT result = S_OK;
+
+    while (size != 0 && !tar->finished) {
+        if (tar->remaining != 0) {
+            SIZE_T length = tar->remaining < size ? (SIZE_T) tar->remaining : size;
+            if (tar->extendedType != 0) {
+                SIZE_T room = INCALESCENT_ARCHIVE_TAR_EXTENDED_SIZE - tar->extendedUsed;
+                SIZE_T copied = length < room ? length : room;
+                CopyMemory(tar->extendedData + tar->extendedUsed, data, copied);
+                tar->extendedUsed += copied;
+            } else if (tar->passing) {
+                result = tar->onData(tar->context, data, length);
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+                tar->passing = result == S_OK;
+                result = S_OK;
+            }
+            data += length;
+            size -= length;
+            tar->remaining -= length;
+            if (tar->remaining == 0) {
+                result = INCALESCENT_Archive_EndTarMember(tar);
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+            }
+            continue;
+        }
+
+        if (tar->padding != 0) {
+            SIZE_T length = tar->padding < size ? (SIZE_T) tar->padding : size;
+            data += length;
+            size -= length;
+            tar->padding -= length;
+            continue;
+        }
+
+        SIZE_T length = INCALESCENT_ARCHIVE_TAR_BLOCK_SIZE - tar->headerUsed;
+        length = length < size ? length : size;
+        CopyMemory(tar->header + tar->headerUsed, data, length);
+        tar->headerUsed += length;
+        data += length;
+        size -= length;
+        if (tar->headerUsed == INCALESCENT_ARCHIVE_TAR_BLOCK_SIZE) {
+            tar->headerUsed = 0;
+            result = INCALESCENT_Archive_StartTarMember(tar);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+    }
+
+    cleanup:
+    if (SUCCEEDED(result)) {
+        result = tar->finished ? S_FALSE : S_OK;
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Archive_GzipData
+HRESULT INCALESCENT_Archive_GzipData(const BYTE *data, SIZE_T size, SIZE_T *headerSize) {
+    if (size < INCALESCENT_ARCHIVE_GZIP_HEADER_SIZE || INCALESCENT_Archive_Read(data, 2) != INCALESCENT_ARCHIVE_GZIP_MAGIC ||
+        data[2] != INCALESCENT_ARCHIVE_GZIP_METHOD_DEFLATE) {
+        return INCALESCENT_ARCHIVE_BAD_FORMAT;
+    }
+
+    // Optional fields may follow the fixed part of the header, in this order.
+    BYTE flags = data[3];
+    SIZE_T offset = INCALESCENT_ARCHIVE_GZIP_HEADER_SIZE;
+    if (flags & INCALESCENT_ARCHIVE_GZIP_FLAG_EXTRA) {
+        if (offset + 2 > size) {
+            return INCALESCENT_ARCHIVE_BAD_FORMAT;
+        }
+        offset += 2 + (SIZE_T) INCALESCENT_Archive_Read(data + offset, 2);
+    }
+    if (flags & INCALESCENT_ARCHIVE_GZIP_FLAG_NAME) {
+        while (offset < size && data[offset] != '\0') {
+            offset++;
+        }
+        offset++;
+    }
+    if (flags & INCALESCENT_ARCHIVE_GZIP_FLAG_COMMENT) {
+        while (offset < size && data[offset] != '\0') {
+            offset++;
+        }
+        offset++;
+    }
+    if (flags & INCALESCENT_ARCHIVE_GZIP_FLAG_HCRC) {
+        offset += 2;
+    }
+    if (offset > size) {
+        return INCALESCENT_ARCHIVE_BAD_FORMAT;
+    }
+    *headerSize = offset;
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Archive_GzipTrailer
+HRESULT INCALESCENT_Archive_GzipTrailer(const BYTE *data, SIZE_T size, DWORD crc, ULONGLONG dataSize) {
+    if (size < INCALESCENT_ARCHIVE_GZIP_TRAILER_SIZE) {
+        return INCALESCENT_ARCHIVE_BAD_FORMAT;
+    }
+    if ((DWORD) INCALESCENT_Archive_Read(data, 4) != crc || (DWORD) INCALESCENT_Archive_Read(data + 4, 4) != (DWORD) dataSize) {
+        return HRESULT_FROM_WIN32(ERROR_CRC);
+    }
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Archive_IsPadding
+BOOL INCALESCENT_Archive_IsPadding(const BYTE *data, SIZE_T size) {
+    for (SIZE_T index = 0; index < size; index++) {
+        if (data[index] != 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
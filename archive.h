@@ -0,0 +1,214 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_ARCHIVE_H
+#define INCALESCENT_ARCHIVE_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef int BOOL;
+typedef void* PVOID;
+typedef unsigned char BYTE;
+typedef unsigned short WCHAR;
+typedef const WCHAR* PCWSTR;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+#define INCALESCENT_ARCHIVE_ZIP_EXTENSION L".zip"
+#define INCALESCENT_ARCHIVE_TAR_EXTENSION L".tar"
+#define INCALESCENT_ARCHIVE_TAR_GZIP_EXTENSION L".tar.gz"
+#define INCALESCENT_ARCHIVE_TGZ_EXTENSION L".tgz"
+
+// The signatures of the zip records, and the longest comment the end record can be followed by.
+#define INCALESCENT_ARCHIVE_ZIP_LOCAL_SIGNATURE 0x04034B50
+#define INCALESCENT_ARCHIVE_ZIP_CENTRAL_SIGNATURE 0x02014B50
+#define INCALESCENT_ARCHIVE_ZIP_END_SIGNATURE 0x06054B50
+#define INCALESCENT_ARCHIVE_ZIP64_LOCATOR_SIGNATURE 0x07064B50
+#define INCALESCENT_ARCHIVE_ZIP64_END_SIGNATURE 0x06064B50
+#define INCALESCENT_ARCHIVE_ZIP_MAX_COMMENT 0xFFFF
+#define INCALESCENT_ARCHIVE_ZIP64_EXTRA_ID 0x0001
+
+// The general purpose flags of a zip entry that matter here.
+#define INCALESCENT_ARCHIVE_ZIP_FLAG_ENCRYPTED 0x0001
+#define INCALESCENT_ARCHIVE_ZIP_FLAG_UTF8 0x0800
+
+// The only code page a zip entry's name can be in other than UTF-8.
+#define INCALESCENT_ARCHIVE_ZIP_CODE_PAGE 437
+
+// A tar archive is a sequence of blocks, a header block for every member followed by its data.
+#define INCALESCENT_ARCHIVE_TAR_BLOCK_SIZE 512
+
+// The longest name of a tar member, which is longer than a header can hold only if an extended
+// header carries it.
+#define INCALESCENT_ARCHIVE_MAX_NAME 1024
+#define INCALESCENT_ARCHIVE_TAR_EXTENDED_SIZE 4096
+
+#define INCALESCENT_ARCHIVE_GZIP_MAGIC 0x8B1F
+#define INCALESCENT_ARCHIVE_GZIP_TRAILER_SIZE 8
+
+// Seconds from the start of 1601, where file times start, to the start of 1970, where Unix times do.
+#define INCALESCENT_ARCHIVE_UNIX_EPOCH 11644473600ULL
+#define INCALESCENT_ARCHIVE_TICKS_PER_SECOND 10000000ULL
+
+typedef enum INCALESCENT_Archive_Kind {
+    INCALESCENT_ARCHIVE_KIND_NONE = 0,
+    INCALESCENT_ARCHIVE_KIND_ZIP = 1,
+    INCALESCENT_ARCHIVE_KIND_TAR = 2,
+    INCALESCENT_ARCHIVE_KIND_TAR_GZIP = 3,
+} INCALESCENT_Archive_Kind;
+
+typedef enum INCALESCENT_Archive_Method {
+    INCALESCENT_ARCHIVE_METHOD_STORED = 0,
+    INCALESCENT_ARCHIVE_METHOD_DEFLATED = 8,
+} INCALESCENT_Archive_Method;
+
+// A member of an archive. The name points into the archive or the parser and is only valid during
+// the callback it is passed to.
+typedef struct INCALESCENT_Archive_Member {
+    const BYTE *name;
+    SIZE_T nameLength;
+
+    // Whether the name is UTF-8, or else in INCALESCENT_ARCHIVE_ZIP_CODE_PAGE.
+    BOOL utf8;
+
+    // The size of the member's data and its last write time as a file time.
+    ULONGLONG size;
+    ULONGLONG lastWriteTime;
+
+    // Where the member of a zip archive is, to be passed to INCALESCENT_Archive_ZipData, how it is
+    // compressed, and the CRC-32 of its data. A tar member's data follows through the callbacks
+    // instead, and the gzip trailer checks it.
+    ULONGLONG localHeaderOffset;
+    ULONGLONG compressedSize;
+    DWORD method;
+    DWORD crc;
+    BOOL encrypted;
+} INCALESCENT_Archive_Member;
+
+/**
+ * @brief Receives a member of an archive.
+ *
+ * @return S_OK to take the data of a tar member, S_FALSE to skip it, or a failure to abort.
+ */
+typedef HRESULT (*INCALESCENT_Archive_MemberCallback)(PVOID context, const INCALESCENT_Archive_Member *member);
+
+/**
+ * @brief Receives a piece of the data of a tar member that was taken.
+ *
+ * @return S_OK to go on, S_FALSE to skip the rest of the member, or a failure to abort.
+ */
+typedef HRESULT (*INCALESCENT_Archive_DataCallback)(PVOID context, const BYTE *data, SIZE_T size);
+
+/**
+ * @brief Receives the end of the data of a tar member that was taken.
+ */
+typedef HRESULT (*INCALESCENT_Archive_EndCallback)(PVOID context);
+
+/**
+ * @brief The state of a tar archive that is read as a stream, so it can be fed any pieces of it.
+ *
+ * Members are recognized by their headers in the ustar, GNU and pax formats, including the long
+ * names of the latter two. Only regular files are passed on. The data of a skipped member is
+ * stepped over without being looked at, so none of it is touched when the archive is mapped.
+ */
+typedef struct INCALESCENT_Archive_Tar {
+    INCALESCENT_Archive_MemberCallback onMember;
+    INCALESCENT_Archive_DataCallback onData;
+    INCALESCENT_Archive_EndCallback onEnd;
+    PVOID context;
+
+    // The header block collected so far.
+    BYTE header[INCALESCENT_ARCHIVE_TAR_BLOCK_SIZE];
+    SIZE_T headerUsed;
+
+    // The bytes of data left in the current member and the padding up to the next block, and what
+    // is done with the data.
+    ULONGLONG remaining;
+    ULONGLONG padding;
+    BOOL taken;
+    BOOL passing;
+
+    // The type of the extended header whose data is being collected, or 0 for a member.
+    BYTE extendedType;
+
+    // The extended header of the next member, which may carry its name.
+    BYTE extendedData[INCALESCENT_ARCHIVE_TAR_EXTENDED_SIZE];
+    SIZE_T extendedUsed;
+    BYTE longName[INCALESCENT_ARCHIVE_MAX_NAME];
+    SIZE_T longNameLength;
+
+    BOOL finished;
+} INCALESCENT_Archive_Tar;
+
+// The kind of archive a path is, judging by its extension.
+INCALESCENT_Archive_Kind INCALESCENT_Archive_KindOf(PCWSTR path);
+
+/**
+ * @brief Passes on every entry of the central directory of a zip archive in memory.
+ *
+ * Only the central directory at the end of the archive is read, so none of the members' data is
+ * touched. Zip64 archives are understood.
+ *
+ * @return S_OK if successful, HRESULT_FROM_WIN32(ERROR_BAD_FORMAT) if the data isn't a zip
+ *         archive, or the failure of the callback.
+ */
+HRESULT INCALESCENT_Archive_ListZip(const BYTE *data, SIZE_T size, INCALESCENT_Archive_MemberCallback callback, PVOID context);
+
+/**
+ * @brief Finds the data of a zip member in the archive, which follows its local header.
+ *
+ * @return S_OK if successful, or HRESULT_FROM_WIN32(ERROR_BAD_FORMAT) if the member isn't where
+ *         the central directory says.
+ */
+HRESULT INCALESCENT_Archive_ZipData(const BYTE *data, SIZE_T size, const INCALESCENT_Archive_Member *member, const BYTE **memberData);
+
+void INCALESCENT_Archive_BeginTar(INCALESCENT_Archive_Tar *tar, INCALESCENT_Archive_MemberCallback onMember,
+                                  INCALESCENT_Archive_DataCallback onData, INCALESCENT_Archive_EndCallback onEnd, PVOID context);
+
+/**
+ * @brief Feeds the next piece of a tar archive.
+ *
+ * @return S_OK to be fed more, S_FALSE once the end of the archive has been reached,
+ *         HRESULT_FROM_WIN32(ERROR_BAD_FORMAT) for a corrupt header, or the failure of a callback.
+ */
+HRESULT INCALESCENT_Archive_FeedTar(INCALESCENT_Archive_Tar *tar, const BYTE *data, SIZE_T size);
+
+/**
+ * @brief Finds the deflate data of a gzip member, right after its header.
+ *
+ * @return S_OK if successful, or HRESULT_FROM_WIN32(ERROR_BAD_FORMAT) if the data isn't gzip data.
+ */
+HRESULT INCALESCENT_Archive_GzipData(const BYTE *data, SIZE_T size, SIZE_T *headerSize);
+
+/**
+ * @brief Checks the trailer of a gzip member against the data that was inflated from it.
+ *
+ * @return S_OK if successful, HRESULT_FROM_WIN32(ERROR_BAD_FORMAT) if the trailer is cut off, or
+ *         HRESULT_FROM_WIN32(ERROR_CRC) if the CRC-32 or the size modulo 2^32 doesn't match.
+ */
+HRESULT INCALESCENT_Archive_GzipTrailer(const BYTE *data, SIZE_T size, DWORD crc, ULONGLONG dataSize);
+
+// Whether the rest of a gzip stream is only zeros, which some tools pad it with after the last member.
+BOOL INCALESCENT_Archive_IsPadding(const BYTE *data, SIZE_T size);
+
+#endif //INCALESCENT_ARCHIVE_H
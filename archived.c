@@ -0,0 +1,490 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include "archived.h"
+#include "table.h"
+#include "log.h"
+#include "pool.h"
+#include "inflate.h"
+#include "crc.h"
+#include "string.h"
+#include "perf.h"
+#include "generated_error.h"
+
+// What a member of an archive needs to be read, stored directly in front of the information of its
+// name. The slot is the member's place in the order the archive was read in, where its values are.
+typedef struct INCALESCENT_Archived_Member {
+    SIZE_T slot;
+    const BYTE *data;
+    ULONGLONG compressedSize;
+    DWORD method;
+    DWORD crc;
+} INCALESCENT_Archived_Member;
+
+#define INCALESCENT_ARCHIVED_MEMBER(name) (((INCALESCENT_Archived_Member *) INCALESCENT_FILE_NAME_INFO(name)) - 1)
+
+typedef struct INCALESCENT_Archived_Context {
+    INCALESCENT_File_Session *session;
+    INCALESCENT_File_Names *names;
+    PCWSTR archivePath;
+
+    // The values and numbers of every member by slot, which grow as the members are found.
+    INCALESCENT_Arena *valueArena;
+    INCALESCENT_Arena *numberArena;
+    BOOL columnar;
+    INCALESCENT_Table *table;
+
+    // The mapped zip archive, and a decoder for every worker.
+    const BYTE *view;
+    SIZE_T size;
+    INCALESCENT_Inflate *inflates;
+
+    // The member of a tar archive being read, and whether all of its fields have been found.
+    INCALESCENT_File_Extraction extraction;
+    PWSTR current;
+    BOOL done;
+
+    volatile LONG64 readDone;
+    SIZE_T readTotal;
+} INCALESCENT_Archived_Context;
+
+// The CRC-32 of the data inflated so far, which is only checked if a member is inflated in full.
+typedef struct INCALESCENT_Archived_InflateFeed {
+    const INCALESCENT_Match *match;
+    INCALESCENT_File_Extraction *extraction;
+    DWORD crc;
+} INCALESCENT_Archived_InflateFeed;
+
+// A tar archive inflated from a gzip member, with the CRC-32 and size of the member's data so far.
+typedef struct INCALESCENT_Archived_GzipFeed {
+    INCALESCENT_Archive_Tar *tar;
+    DWORD crc;
+    ULONGLONG size;
+} INCALESCENT_Archived_GzipFeed;
+
+// Whether the raw name of a member ends with the suffix of the data files, which is plain ASCII, so
+// it can be matched before the name is converted.
+static BOOL INCALESCENT_Archived_MemberMatches(const INCALESCENT_Archive_Member *member, PCWSTR suffix) {
+    SIZE_T suffixLength = lstrlenW(suffix);
+    if (member->nameLength <= suffixLength) {
+        return FALSE;
+    }
+
+    const BYTE *end = member->name + (member->nameLength - suffixLength);
+    for (SIZE_T index = 0; index < suffixLength; index++) {
+        BYTE character = end[index];
+        if (character >= 'A' && character <= 'Z') {
+            character += 'a' - 'A';
+        }
+        WCHAR expected = suffix[index];
+        if (expected >= L'A' && expected <= L'Z') {
+            expected += L'a' - L'A';
+        }
+        if (character != expected) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Adds a member to the list of names, converting its name to a path with backslashes, and makes
+// room for its values in the next slot.
+static HRESULT INCALESCENT_Archived_AppendMemberName(INCALESCENT_Archived_Context *context, const INCALESCENT_Archive_Member *member,
+                                                     const BYTE *data) {
+    HRESULT result = S_OK;
+    INCALESCENT_File_Names *names = context->names;
+    INCALESCENT_Archived_Member *archiveMember = NULL;
+    PWSTR *entry = NULL;
+    PVOID slotValues = NULL;
+    WCHAR name[INCALESCENT_ARCHIVE_MAX_NAME];
+    DWORD fieldCount = context->session->fieldCount;
+
+    INT nameLength = MultiByteToWideChar(member->utf8 ? CP_UTF8 : INCALESCENT_ARCHIVE_ZIP_CODE_PAGE, 0, (LPCCH) member->name,
+                                         (INT) member->nameLength, name, INCALESCENT_ARCHIVE_MAX_NAME - 1);
+    if (nameLength == 0) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    for (INT index = 0; index < nameLength; index++) {
+        if (name[index] == L'/') {
+            name[index] = L'\\';
+        }
+    }
+
+    result = INCALESCENT_Arena_Allocate(names->arena, sizeof(INCALESCENT_Archived_Member) + sizeof(INCALESCENT_File_NameInfo) +
+                                                      sizeof(WCHAR) * (nameLength + 1), sizeof(ULONGLONG), (PVOID *) &archiveMember);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    archiveMember->slot = names->count;
+    archiveMember->data = data;
+    archiveMember->compressedSize = member->compressedSize;
+    archiveMember->method = member->method;
+    archiveMember->crc = member->crc;
+
+    INCALESCENT_File_NameInfo *info = (INCALESCENT_File_NameInfo *) (archiveMember + 1);
+    info->size = member->size;
+    info->lastWriteTime = member->lastWriteTime;
+    info->length = nameLength;
+    CopyMemory(info + 1, name, sizeof(WCHAR) * nameLength);
+    ((PWSTR) (info + 1))[nameLength] = L'\0';
+
+    result = INCALESCENT_Arena_Allocate(&names->index, sizeof(PWSTR), sizeof(PWSTR), (PVOID *) &entry);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    *entry = (PWSTR) (info + 1);
+    names->entries = (PWSTR *) names->index.base;
+    names->count++;
+
+    result = INCALESCENT_Arena_Allocate(context->valueArena, sizeof(INCALESCENT_File_Value) * fieldCount, sizeof(WCHAR), &slotValues);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    if (context->columnar) {
+        result = INCALESCENT_Arena_Allocate(context->numberArena, sizeof(DOUBLE) * fieldCount, sizeof(DOUBLE), &slotValues);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Finishes the extraction of a member into its slot and counts it as read, adding its values to a
+// set of statistics unless that is NULL.
+static HRESULT INCALESCENT_Archived_FinishMember(INCALESCENT_Archived_Context *context, PWSTR name, const INCALESCENT_File_Extraction *extraction,
+                                                 INCALESCENT_Stats *statistics) {
+    WCHAR joined[INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH];
+    DWORD fieldCount = context->session->fieldCount;
+    SIZE_T slot = INCALESCENT_ARCHIVED_MEMBER(name)->slot;
+    INCALESCENT_File_Value *values = (INCALESCENT_File_Value *) context->valueArena->base + (slot * fieldCount);
+    DOUBLE *numbers = context->columnar ? (DOUBLE *) context->numberArena->base + (slot * fieldCount) : NULL;
+
+    HRESULT result = INCALESCENT_File_FinishExtraction(context->session->match, extraction, TRUE, values, numbers);
+    if (FAILED(result)) {
+        return result;
+    }
+    if (statistics != NULL) {
+        INCALESCENT_File_AddStatistics(statistics, values, numbers, fieldCount);
+    }
+    INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_FILES_READ, 1);
+    INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_BYTES_READ, INCALESCENT_FILE_NAME_INFO(name)->size);
+
+    INCALESCENT_File_JoinValues(values, fieldCount, L',', joined);
+    result = INCALESCENT_LOG_DETAIL_FORMATTED_W(L"Read fields for %s, values discovered to be %s ...", name, joined);
+    if (FAILED(result)) {
+        return result;
+    }
+    LONG64 done = InterlockedIncrement64(&context->readDone);
+    return INCALESCENT_LOG_PROGRESS_W(L"Read %lld of %llu archive members...", done, context->readTotal);
+}
+
+// Lists a member of a zip archive if it is a data file. Members that are encrypted or compressed
+// with anything but deflate are skipped with a line in the log.
+static HRESULT INCALESCENT_Archived_ListZipMember(PVOID parameter, const INCALESCENT_Archive_Member *member) {
+    INCALESCENT_Archived_Context *context = parameter;
+    const BYTE *data = NULL;
+
+    if (!INCALESCENT_Archived_MemberMatches(member, context->session->suffix)) {
+        return S_FALSE;
+    }
+    if (member->encrypted || (member->method != INCALESCENT_ARCHIVE_METHOD_STORED && member->method != INCALESCENT_ARCHIVE_METHOD_DEFLATED)) {
+        HRESULT result = INCALESCENT_LOG_DETAIL_FORMATTED_W(L"Skipped a member of %s that is encrypted or compressed with method %lu ...",
+                                                            context->archivePath, member->method);
+        return FAILED(result) ? result : S_FALSE;
+    }
+
+    HRESULT result = INCALESCENT_Archive_ZipData(context->view, context->size, member, &data);
+    if (FAILED(result)) {
+        return result;
+    }
+    return INCALESCENT_Archived_AppendMemberName(context, member, data);
+}
+
+// Feeds decompressed data to an extraction, stopping the decoder once every field has been found.
+static HRESULT INCALESCENT_Archived_FeedInflated(PVOID parameter, const BYTE *data, SIZE_T size) {
+    INCALESCENT_Archived_InflateFeed *feed = parameter;
+    BOOL done = FALSE;
+    feed->crc = INCALESCENT_Crc_Update(feed->crc, data, size);
+    HRESULT result = INCALESCENT_File_FeedExtraction(feed->match, feed->extraction, data, size, &done);
+    if (SUCCEEDED(result) && done) {
+        result = S_FALSE;
+    }
+    return result;
+}
+
+// Reads the fields of the zip members listed in [begin, end) of the sorted names. A stored member
+// is scanned right in the mapped archive, and a deflated one is only decompressed as far as its
+// fields go. A member whose data was read in full because a field is missing is checked against
+// its CRC-32.
+static HRESULT INCALESCENT_Archived_ReadZipChunk(PVOID parameter, DWORD worker, SIZE_T begin, SIZE_T end) {
+    INCALESCENT_Archived_Context *context = parameter;
+    const INCALESCENT_Match *match = context->session->match;
+    INCALESCENT_Stats *statistics = context->table->statistics;
+    HRESULT result = S_OK;
+
+    // Every worker adds to a set of statistics of its own.
+    if (statistics != NULL) {
+        statistics += (SIZE_T) worker * context->session->fieldCount;
+    }
+
+    for (SIZE_T index = begin; index < end; index++) {
+        PWSTR name = context->names->entries[index];
+        const INCALESCENT_Archived_Member *member = INCALESCENT_ARCHIVED_MEMBER(name);
+        INCALESCENT_File_Extraction extraction;
+        INCALESCENT_Archived_InflateFeed feed = {.match = match, .extraction = &extraction, .crc = 0};
+        BOOL done = FALSE;
+
+        ULONGLONG parsing = INCALESCENT_Perf_Now();
+        INCALESCENT_File_BeginExtraction(match, &extraction, 0);
+        __try {
+            if (member->method == INCALESCENT_ARCHIVE_METHOD_STORED) {
+                result = INCALESCENT_File_FeedExtraction(match, &extraction, member->data, (SIZE_T) member->compressedSize, &done);
+                if (result == S_OK && !done) {
+                    feed.crc = INCALESCENT_Crc_Update(0, member->data, (SIZE_T) member->compressedSize);
+                }
+            } else {
+                result = INCALESCENT_Inflate_Run(&context->inflates[worker], member->data, (SIZE_T) member->compressedSize,
+                                                 INCALESCENT_Archived_FeedInflated, &feed, NULL);
+                done = result == S_FALSE;
+            }
+            if (result == S_OK && !done && feed.crc != member->crc) {
+                result = HRESULT_FROM_WIN32(ERROR_CRC);
+            }
+        } __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+            result = HRESULT_FROM_WIN32(ERROR_READ_FAULT);
+        }
+        if (SUCCEEDED(result)) {
+            result = INCALESCENT_Archived_FinishMember(context, name, &extraction, statistics);
+        }
+        if (FAILED(result)) {
+            return result;
+        }
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_PARSE, parsing);
+    }
+    return S_OK;
+}
+
+// Starts reading a member of a tar archive if it is a data file.
+static HRESULT INCALESCENT_Archived_BeginTarMember(PVOID parameter, const INCALESCENT_Archive_Member *member) {
+    INCALESCENT_Archived_Context *context = parameter;
+
+    if (!INCALESCENT_Archived_MemberMatches(member, context->session->suffix)) {
+        return S_FALSE;
+    }
+    HRESULT result = INCALESCENT_Archived_AppendMemberName(context, member, NULL);
+    if (FAILED(result)) {
+        return result;
+    }
+    context->current = context->names->entries[context->names->count - 1];
+    context->done = FALSE;
+    INCALESCENT_File_BeginExtraction(context->session->match, &context->extraction, 0);
+    return S_OK;
+}
+
+// Feeds the next piece of a tar member to its extraction, skipping the rest once every field has
+// been found.
+static HRESULT INCALESCENT_Archived_FeedTarMember(PVOID parameter, const BYTE *data, SIZE_T size) {
+    INCALESCENT_Archived_Context *context = parameter;
+    HRESULT result = INCALESCENT_File_FeedExtraction(context->session->match, &context->extraction, data, size, &context->done);
+    if (SUCCEEDED(result) && context->done) {
+        result = S_FALSE;
+    }
+    return result;
+}
+
+static HRESULT INCALESCENT_Archived_EndTarMember(PVOID parameter) {
+    INCALESCENT_Archived_Context *context = parameter;
+
+    // A tar archive is read by a single thread, whose statistics go into the set after the workers'.
+    context->readTotal++;
+    return INCALESCENT_Archived_FinishMember(context, context->current, &context->extraction, INCALESCENT_Table_SharedStatistics(context->table));
+}
+
+// Hands decompressed data on to a tar archive, stopping the decoder at the end of the archive.
+static HRESULT INCALESCENT_Archived_FeedTar(PVOID parameter, const BYTE *data, SIZE_T size) {
+    INCALESCENT_Archived_GzipFeed *feed = parameter;
+    feed->crc = INCALESCENT_Crc_Update(feed->crc, data, size);
+    feed->size += size;
+    return INCALESCENT_Archive_FeedTar(feed->tar, data, size);
+}
+
+// Reads a tar archive in a single pass, which is either the mapped archive itself or decompressed
+// from it. A gzip stream may consist of several members one after another, each with a header and
+// a trailer of its own, which is checked whenever a member is inflated in full. Zeros after the
+// last member are padding.
+static HRESULT INCALESCENT_Archived_ReadTar(INCALESCENT_Archived_Context *context, BOOL compressed) {
+    HRESULT result = S_OK;
+    INCALESCENT_Archive_Tar tar;
+
+    INCALESCENT_Archive_BeginTar(&tar, INCALESCENT_Archived_BeginTarMember, INCALESCENT_Archived_FeedTarMember, INCALESCENT_Archived_EndTarMember, context);
+    __try {
+        if (!compressed) {
+            result = INCALESCENT_Archive_FeedTar(&tar, context->view, context->size);
+        }
+        for (SIZE_T offset = 0; compressed && offset < context->size && result == S_OK;) {
+            SIZE_T headerSize = 0;
+            SIZE_T consumed = 0;
+            INCALESCENT_Archived_GzipFeed feed = {.tar = &tar, .crc = 0, .size = 0};
+            if (offset != 0 && INCALESCENT_Archive_IsPadding(context->view + offset, context->size - offset)) {
+                break;
+            }
+            result = INCALESCENT_Archive_GzipData(context->view + offset, context->size - offset, &headerSize);
+            if (SUCCEEDED(result)) {
+                offset += headerSize;
+                result = INCALESCENT_Inflate_Run(context->inflates, context->view + offset, context->size - offset, INCALESCENT_Archived_FeedTar, &feed,
+                                                 &consumed);
+                offset += consumed;
+            }
+            if (result == S_OK) {
+                result = INCALESCENT_Archive_GzipTrailer(context->view + offset, context->size - offset, feed.crc, feed.size);
+                offset += INCALESCENT_ARCHIVE_GZIP_TRAILER_SIZE;
+            }
+        }
+    } __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+        result = HRESULT_FROM_WIN32(ERROR_READ_FAULT);
+    }
+
+    // The blocks of zeros at the end are optional, but a member can't be cut off.
+    if (SUCCEEDED(result) && (tar.remaining != 0 || tar.headerUsed != 0)) {
+        result = HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+    }
+    return SUCCEEDED(result) ? S_OK : result;
+}
+
+// Implementation for INCALESCENT_Archived_Consolidate
+HRESULT INCALESCENT_Archived_Consolidate(INCALESCENT_File_Session *session, INCALESCENT_Archive_Kind kind, PWSTR archivePath,
+                                         PWSTR consolidatedFile, HANDLE file) {
+    HRESULT result = S_OK;
+    INCALESCENT_File_Names *names = &session->names;
+    INCALESCENT_Table table = {0};
+    INCALESCENT_Arena slots[2] = {0};
+    DWORD fieldCount = session->fieldCount;
+    DWORD workerCount = INCALESCENT_Pool_WorkerCount(session->pool);
+    INCALESCENT_Archived_Context context = {
+            .session = session,
+            .names = names,
+            .archivePath = archivePath,
+            .valueArena = &slots[0],
+            .numberArena = &slots[1],
+            .columnar = session->options.format == INCALESCENT_FILE_FORMAT_COLUMNAR,
+            .table = &table,
+    };
+
+    result = INCALESCENT_Arena_Create(context.valueArena, INCALESCENT_FILE_NAME_INDEX_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Create(context.numberArena, INCALESCENT_FILE_NAME_INDEX_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Table_CreateStatistics(&table, session);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&session->arena, sizeof(INCALESCENT_Inflate) * workerCount, INCALESCENT_ARENA_DEFAULT_ALIGNMENT,
+                                        (PVOID *) &context.inflates);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    ULONGLONG opening = INCALESCENT_Perf_Now();
+    result = INCALESCENT_File_MapFile(archivePath, &context.view, &context.size);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_OPEN, opening);
+
+    // The members of a zip archive are listed up front and read in parallel, while a tar archive is
+    // read as its members come.
+    if (kind == INCALESCENT_ARCHIVE_KIND_ZIP) {
+        ULONGLONG listing = INCALESCENT_Perf_Now();
+        __try {
+            result = INCALESCENT_Archive_ListZip(context.view, context.size, INCALESCENT_Archived_ListZipMember, &context);
+        } __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+            result = HRESULT_FROM_WIN32(ERROR_READ_FAULT);
+        }
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_ENUMERATE, listing);
+    } else {
+        result = INCALESCENT_Archived_ReadTar(&context, kind == INCALESCENT_ARCHIVE_KIND_TAR_GZIP);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    SIZE_T fileCount = names->count;
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Found %llu valid data files in the archive...", (ULONGLONG) fileCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    if (fileCount == 0) {
+        result = INCALESCENT_ERROR_NO_DATA_FILES_FOUND;
+        goto cleanup;
+    }
+
+    ULONGLONG sorting = INCALESCENT_Perf_Now();
+    result = INCALESCENT_String_NaturalSort(names->entries, fileCount, names->arena, session->pool);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_SORT, sorting);
+
+    if (kind == INCALESCENT_ARCHIVE_KIND_ZIP) {
+        context.readTotal = fileCount;
+        result = INCALESCENT_Pool_Run(session->pool, fileCount, INCALESCENT_POOL_DEFAULT_CHUNK_SIZE, INCALESCENT_Archived_ReadZipChunk, &context);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    result = INCALESCENT_Table_Begin(&table, session, consolidatedFile, file, fileCount, FALSE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    INCALESCENT_File_Value *values = (PVOID) context.valueArena->base;
+    DOUBLE *numbers = (PVOID) context.numberArena->base;
+    for (SIZE_T index = 0; index < fileCount; index++) {
+        PWSTR fileName = names->entries[index];
+        SIZE_T slot = INCALESCENT_ARCHIVED_MEMBER(fileName)->slot;
+        result = INCALESCENT_Table_AppendRow(&table, index, NULL, 0, fileName, INCALESCENT_FILE_NAME_INFO(fileName)->length,
+                                             values + (slot * fieldCount), context.columnar ? numbers + (slot * fieldCount) : NULL);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    result = INCALESCENT_Table_End(&table, session, consolidatedFile, file, NULL, slots, 2);
+
+    cleanup:
+    INCALESCENT_Table_Destroy(&table);
+    if (context.view != NULL) {
+        UnmapViewOfFile(context.view);
+    }
+    INCALESCENT_Arena_Destroy(context.numberArena);
+    INCALESCENT_Arena_Destroy(context.valueArena);
+    return result;
+}
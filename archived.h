@@ -0,0 +1,55 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_ARCHIVED_H
+#define INCALESCENT_ARCHIVED_H
+#include "file.h"
+#include "archive.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* HANDLE;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+
+/**
+ * @brief Consolidates the data files in a zip or tar archive without extracting it, wherever they
+ * are in the archive.
+ *
+ * Only the members that are data files are read: a zip archive's central directory tells where
+ * they are, and a tar archive's headers tell how much to skip to the next one, so the images in
+ * between are never read. A compressed tar archive has to be decompressed throughout, though. The
+ * members' paths in the archive make up the file column.
+ *
+ * @param[in] session           The session.
+ * @param[in] kind              The kind of archive.
+ * @param[in] archivePath       The path of the archive.
+ * @param[in] consolidatedFile  The path of the table.
+ * @param[in] file              The table's file, already created.
+ *
+ * @return The result of the consolidation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Archived_Consolidate(INCALESCENT_File_Session *session, INCALESCENT_Archive_Kind kind, PWSTR archivePath,
+                                         PWSTR consolidatedFile, HANDLE file);
+
+#endif //INCALESCENT_ARCHIVED_H
@@ -0,0 +1,152 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "arena.h"
+#include "perf.h"
+
+// Implementation for INCALESCENT_Arena_Create
+HRESULT INCALESCENT_Arena_Create(INCALESCENT_Arena *arena, SIZE_T reserveSize) {
+    HRESULT result = S_OK;
+
+    ZeroMemory(arena, sizeof(INCALESCENT_Arena));
+
+    reserveSize = INCALESCENT_ARENA_ROUND_UP(reserveSize, INCALESCENT_ARENA_COMMIT_GRANULARITY);
+    arena->base = VirtualAlloc(NULL, reserveSize, MEM_RESERVE, PAGE_READWRITE);
+    if (arena->base == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    arena->reserved = reserveSize;
+    arena->systemCallCount = 1;
+
+    cleanup:
+    return result;
+}
+
+// Commits enough of the reservation to hold the first required bytes, at least doubling the
+// committed size so that steady growth costs few calls.
+static HRESULT INCALESCENT_Arena_Commit(INCALESCENT_Arena *arena, SIZE_T required) {
+    SIZE_T target = arena->committed * 2;
+    if (target < required) {
+        target = required;
+    }
+    target = INCALESCENT_ARENA_ROUND_UP(target, INCALESCENT_ARENA_COMMIT_GRANULARITY);
+    if (target > arena->reserved) {
+        target = arena->reserved;
+    }
+
+    PVOID committed = VirtualAlloc(arena->base + arena->committed, target - arena->committed, MEM_COMMIT, PAGE_READWRITE);
+    if (committed == NULL) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    arena->committed = target;
+    arena->systemCallCount++;
+
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Arena_Allocate
+HRESULT INCALESCENT_Arena_Allocate(INCALESCENT_Arena *arena, SIZE_T size, SIZE_T alignment, PVOID *allocation) {
+    HRESULT result = S_OK;
+
+    SIZE_T offset = INCALESCENT_ARENA_ROUND_UP(arena->used, alignment);
+    if (offset > arena->reserved || size > arena->reserved - offset) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+
+    SIZE_T end = offset + size;
+    if (end > arena->committed) {
+        result = INCALESCENT_Arena_Commit(arena, end);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    *allocation = arena->base + offset;
+    arena->used = end;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    arena->allocationCount++;
+    INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_ALLOCATIONS, 1);
+    INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_BYTES_ALLOCATED, size);
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Arena_Grow
+HRESULT INCALESCENT_Arena_Grow(INCALESCENT_Arena *arena, SIZE_T reserveSize) {
+    HRESULT result = S_OK;
+    PBYTE base = NULL;
+
+    reserveSize = INCALESCENT_ARENA_ROUND_UP(reserveSize, INCALESCENT_ARENA_COMMIT_GRANULARITY);
+    if (reserveSize <= arena->reserved) {
+        goto cleanup;
+    }
+
+    base = VirtualAlloc(NULL, reserveSize, MEM_RESERVE, PAGE_READWRITE);
+    if (base == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (arena->committed != 0 && VirtualAlloc(base, arena->committed, MEM_COMMIT, PAGE_READWRITE) == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    CopyMemory(base, arena->base, arena->used);
+
+    VirtualFree(arena->base, 0, MEM_RELEASE);
+    arena->base = base;
+    arena->reserved = reserveSize;
+    arena->systemCallCount += 3;
+    base = NULL;
+
+    cleanup:
+    if (base != NULL) {
+        VirtualFree(base, 0, MEM_RELEASE);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Arena_Mark
+SIZE_T INCALESCENT_Arena_Mark(const INCALESCENT_Arena *arena) {
+    return arena->used;
+}
+
+// Implementation for INCALESCENT_Arena_Reset
+void INCALESCENT_Arena_Reset(INCALESCENT_Arena *arena, SIZE_T mark) {
+    if (mark < arena->used) {
+        arena->used = mark;
+    }
+}
+
+// Implementation for INCALESCENT_Arena_Destroy
+void INCALESCENT_Arena_Destroy(INCALESCENT_Arena *arena) {
+    if (arena->base != NULL) {
+        VirtualFree(arena->base, 0, MEM_RELEASE);
+    }
+    ZeroMemory(arena, sizeof(INCALESCENT_Arena));
+}
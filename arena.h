@@ -0,0 +1,99 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_ARENA_H
+#define INCALESCENT_ARENA_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef unsigned char* PBYTE;
+typedef void* PVOID;
+typedef unsigned __int64 SIZE_T;
+
+#define INCALESCENT_ARENA_COMMIT_GRANULARITY (64 * 1024)
+#define INCALESCENT_ARENA_DEFAULT_ALIGNMENT 16
+
+// Rounds a size or offset up to a power of two, the way allocations are aligned.
+#define INCALESCENT_ARENA_ROUND_UP(value, granularity) (((value) + ((granularity) - 1)) & ~((SIZE_T) (granularity) - 1))
+
+/**
+ * @brief A region of memory that is handed out by bumping an offset.
+ *
+ * The whole region is reserved up front and committed as it fills, doubling the committed size
+ * each time, so growing an arena takes a logarithmic number of calls into the operating system
+ * and never moves existing allocations. Individual allocations are never freed. Instead the
+ * arena is reset back to a mark, which releases everything allocated after it while keeping the
+ * memory committed for reuse. An arena must only be used by one thread at a time.
+ */
+typedef struct INCALESCENT_Arena {
+    PBYTE base;
+    SIZE_T reserved;
+    SIZE_T committed;
+    SIZE_T used;
+
+    // Statistics kept over the lifetime of the arena.
+    SIZE_T peak;
+    SIZE_T allocationCount;
+    SIZE_T systemCallCount;
+} INCALESCENT_Arena;
+
+/**
+ * @brief Reserves the address space for an arena.
+ *
+ * @param[out] arena        The arena to initialize.
+ * @param[in] reserveSize   The most memory the arena may ever hold. Only address space is reserved,
+ *                          nothing is committed until it is allocated.
+ *
+ * @return The result of the reservation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Arena_Create(INCALESCENT_Arena *arena, SIZE_T reserveSize);
+
+/**
+ * @brief Allocates memory from an arena.
+ *
+ * @param[in] arena         The arena.
+ * @param[in] size          The number of bytes to allocate. The memory is zeroed the first time it
+ *                          is committed, but memory reused after a reset keeps its previous contents.
+ * @param[in] alignment     The alignment of the allocation. Must be a power of two.
+ * @param[out] allocation   Receives the allocation.
+ *
+ * @return S_OK if successful, or E_OUTOFMEMORY once the reservation is exhausted.
+ */
+HRESULT INCALESCENT_Arena_Allocate(INCALESCENT_Arena *arena, SIZE_T size, SIZE_T alignment, PVOID *allocation);
+
+/**
+ * @brief Moves an arena into a larger reservation.
+ * Every allocation moves along with the arena, so this is only for arenas whose allocations are
+ * found by their offset from the base rather than by pointers.
+ * @param[in] arena         The arena.
+ * @param[in] reserveSize   The size of the new reservation. Nothing happens unless it is larger
+ *                          than the current one.
+ * @return The result of the reservation (S_OK if successful). The arena is unchanged if it fails.
+ */
+HRESULT INCALESCENT_Arena_Grow(INCALESCENT_Arena *arena, SIZE_T reserveSize);
+
+SIZE_T INCALESCENT_Arena_Mark(const INCALESCENT_Arena *arena);
+void INCALESCENT_Arena_Reset(INCALESCENT_Arena *arena, SIZE_T mark);
+void INCALESCENT_Arena_Destroy(INCALESCENT_Arena *arena);
+
+#endif //INCALESCENT_ARENA_H
@@ -0,0 +1,333 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "batch.h"
+#include "log.h"
+#include "perf.h"
+#include "file.h"
+#include "options.h"
+#include "arena.h"
+
+typedef struct INCALESCENT_Batch_Job {
+    PWSTR input;
+    PWSTR output;
+} INCALESCENT_Batch_Job;
+
+// The directories to consolidate. Nothing else is allocated from the job arena, so the jobs stay
+// one contiguous array, while the text of a manifest goes to the string arena.
+typedef struct INCALESCENT_Batch_Jobs {
+    INCALESCENT_Batch_Job *entries;
+    SIZE_T count;
+    INCALESCENT_Arena arena;
+    INCALESCENT_Arena strings;
+} INCALESCENT_Batch_Jobs;
+
+// Signaled on Ctrl+C, SIGINT or SIGTERM to end watch mode.
+static HANDLE INCALESCENT_Batch_StopEvent = NULL;
+
+// Turns the request to end the process into a request to stop watching, so the table is flushed
+// and closed properly instead of the process being ended on the spot. Outside Windows, this runs
+// in a signal handler, where setting the event is still safe.
+static BOOL WINAPI INCALESCENT_Batch_ConsoleHandler(DWORD controlType) {
+    if (controlType != CTRL_C_EVENT && controlType != CTRL_BREAK_EVENT && controlType != CTRL_CLOSE_EVENT) {
+        return FALSE;
+    }
+    SetEvent(INCALESCENT_Batch_StopEvent);
+    return TRUE;
+}
+
+static HRESULT INCALESCENT_Batch_AddJob(INCALESCENT_Batch_Jobs *jobs, PWSTR input, PWSTR output) {
+    INCALESCENT_Batch_Job *job = NULL;
+
+    HRESULT result = INCALESCENT_Arena_Allocate(&jobs->arena, sizeof(INCALESCENT_Batch_Job), sizeof(PWSTR), (PVOID *) &job);
+    if (SUCCEEDED(result)) {
+        job->input = input;
+        job->output = output;
+        jobs->entries = (INCALESCENT_Batch_Job *) jobs->arena.base;
+        jobs->count++;
+    }
+    return result;
+}
+
+// Adds a job for every line of a manifest file.
+static HRESULT INCALESCENT_Batch_ReadManifest(INCALESCENT_Batch_Jobs *jobs, PWSTR path) {
+    HRESULT result = S_OK;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    PBYTE bytes = NULL;
+    PWSTR text = NULL;
+
+    file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (size.QuadPart > INCALESCENT_BATCH_MANIFEST_MAX_SIZE) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    // UTF-8 never takes fewer bytes than UTF-16 takes characters, so the text fits in as many
+    // characters as the file has bytes, plus a terminator.
+    SIZE_T mark = INCALESCENT_Arena_Mark(&jobs->strings);
+    result = INCALESCENT_Arena_Allocate(&jobs->strings, sizeof(WCHAR) * ((SIZE_T) size.QuadPart + 1), sizeof(WCHAR), (PVOID *) &text);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&jobs->strings, (SIZE_T) size.QuadPart, 1, (PVOID *) &bytes);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    DWORD readCount = 0;
+    if (!ReadFile(file, bytes, (DWORD) size.QuadPart, &readCount, NULL)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    // Skip a byte order mark.
+    PBYTE start = bytes;
+    if (readCount >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+        start += 3;
+        readCount -= 3;
+    }
+
+    INT textLength = 0;
+    if (readCount != 0) {
+        textLength = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, (LPCCH) start, (INT) readCount, text, (INT) size.QuadPart);
+        if (textLength == 0) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+    }
+    text[textLength] = L'\0';
+
+    // The raw bytes aren't needed anymore. They come after the text, so dropping them keeps the text.
+    INCALESCENT_Arena_Reset(&jobs->strings, mark + sizeof(WCHAR) * (textLength + 1));
+
+    // Split the text into lines and each line into its two paths in place.
+    SIZE_T lineNumber = 0;
+    PWSTR line = text;
+    while (*line != L'\0') {
+        lineNumber++;
+        PWSTR lineEnd = line;
+        while (*lineEnd != L'\0' && *lineEnd != L'\n') {
+            lineEnd++;
+        }
+        PWSTR next = *lineEnd == L'\0' ? lineEnd : lineEnd + 1;
+        if (lineEnd != line && lineEnd[-1] == L'\r') {
+            lineEnd--;
+        }
+        *lineEnd = L'\0';
+
+        if (line != lineEnd && *line != INCALESCENT_BATCH_MANIFEST_COMMENT) {
+            PWSTR separator = line;
+            while (*separator != L'\0' && *separator != INCALESCENT_BATCH_MANIFEST_SEPARATOR) {
+                separator++;
+            }
+            if (*separator == L'\0' || separator == line || separator[1] == L'\0') {
+                INCALESCENT_LOG_INFO_FORMATTED_W(L"Line %llu of manifest %s needs an input directory and output file separated by a tab.",
+                                                 lineNumber, path);
+                result = E_INVALIDARG;
+                goto cleanup;
+            }
+            *separator = L'\0';
+
+            result = INCALESCENT_Batch_AddJob(jobs, line, separator + 1);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+        line = next;
+    }
+
+    cleanup:
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    return result;
+}
+
+// Reads the command line into the consolidation options and the list of jobs.
+static HRESULT INCALESCENT_Batch_ParseArguments(INT argumentCount, PWSTR *arguments, INCALESCENT_File_Options *options, INCALESCENT_Batch_Jobs *jobs) {
+    HRESULT result = S_OK;
+
+    // The first argument is the executable's path.
+    for (INT index = 1; index < argumentCount; index++) {
+        BOOL matched = FALSE;
+        result = INCALESCENT_Options_Parse(arguments, argumentCount, &index, options, &matched);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        if (matched) {
+            continue;
+        }
+
+        PWSTR argument = arguments[index];
+        if (index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        index++;
+
+        if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_INPUT, -1, TRUE) == CSTR_EQUAL) {
+            result = INCALESCENT_Batch_AddJob(jobs, arguments[index], NULL);
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_OUTPUT, -1, TRUE) == CSTR_EQUAL) {
+            // An output belongs to the input right before it.
+            if (jobs->count == 0 || jobs->entries[jobs->count - 1].output != NULL) {
+                result = E_INVALIDARG;
+                goto cleanup;
+            }
+            jobs->entries[jobs->count - 1].output = arguments[index];
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_MANIFEST, -1, TRUE) == CSTR_EQUAL) {
+            result = INCALESCENT_Batch_ReadManifest(jobs, arguments[index]);
+        } else {
+            result = E_INVALIDARG;
+        }
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    // A watch only ends when the process is asked to stop, so it can't be followed by another job.
+    if (jobs->count == 0 || (options->watch && jobs->count != 1)) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+    for (SIZE_T index = 0; index < jobs->count; index++) {
+        if (jobs->entries[index].output == NULL) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+    }
+
+    cleanup:
+    return result;
+}
+
+// Consolidates every directory given on the command line in one session, without any dialogs. A
+// directory that fails is reported and skipped, and the exit code tells whether any did.
+INT wmain(INT argumentCount, PWSTR *arguments) {
+    HRESULT result = S_OK;
+    INT exitCode = INCALESCENT_BATCH_EXIT_SUCCESS;
+    INCALESCENT_File_Options options = {0};
+    INCALESCENT_Batch_Jobs jobs = {0};
+    INCALESCENT_File_Session session = {0};
+    BOOL sessionCreated = FALSE;
+    SIZE_T failureCount = 0;
+
+    result = INCALESCENT_Arena_Create(&jobs.arena, INCALESCENT_BATCH_JOB_ARENA_RESERVE);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_Arena_Create(&jobs.strings, INCALESCENT_BATCH_JOB_ARENA_RESERVE);
+    }
+    if (FAILED(result)) {
+        exitCode = INCALESCENT_BATCH_EXIT_ERROR;
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Batch_ParseArguments(argumentCount, arguments, &options, &jobs);
+    if (FAILED(result)) {
+        INCALESCENT_LOG_RAW_W(INCALESCENT_BATCH_USAGE);
+        exitCode = result == E_INVALIDARG ? INCALESCENT_BATCH_EXIT_INVALID_ARGUMENTS : INCALESCENT_BATCH_EXIT_ERROR;
+        goto cleanup;
+    }
+
+    // From here on, the workers hand their lines to the logging thread instead of writing them.
+    result = INCALESCENT_LogStart();
+    if (FAILED(result)) {
+        exitCode = INCALESCENT_BATCH_EXIT_ERROR;
+        goto cleanup;
+    }
+
+    if (options.watch) {
+        INCALESCENT_Batch_StopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (INCALESCENT_Batch_StopEvent == NULL) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            exitCode = INCALESCENT_BATCH_EXIT_ERROR;
+            goto cleanup;
+        }
+        if (!SetConsoleCtrlHandler(INCALESCENT_Batch_ConsoleHandler, TRUE)) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            exitCode = INCALESCENT_BATCH_EXIT_ERROR;
+            goto cleanup;
+        }
+        options.stopEvent = INCALESCENT_Batch_StopEvent;
+    }
+
+    result = INCALESCENT_File_CreateSession(&options, &session);
+    if (FAILED(result)) {
+        exitCode = INCALESCENT_BATCH_EXIT_ERROR;
+        goto cleanup;
+    }
+    sessionCreated = TRUE;
+
+    for (SIZE_T index = 0; index < jobs.count; index++) {
+        INCALESCENT_Batch_Job *job = &jobs.entries[index];
+        INCALESCENT_LOG_INFO_FORMATTED_W(L"[%llu/%llu] Consolidating %s into %s...", index + 1, jobs.count, job->input, job->output);
+
+        HRESULT jobResult = INCALESCENT_File_Consolidate(&session, job->input, job->output);
+        if (FAILED(jobResult)) {
+            INCALESCENT_LOG_FAILED_RESULT_W(jobResult);
+            failureCount++;
+        }
+    }
+
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Consolidated %llu of %llu directories.", jobs.count - failureCount, jobs.count);
+    if (failureCount != 0) {
+        exitCode = INCALESCENT_BATCH_EXIT_DIRECTORY_FAILED;
+    }
+
+    cleanup:
+    if (FAILED(result) && exitCode == INCALESCENT_BATCH_EXIT_ERROR) {
+        INCALESCENT_LOG_FAILED_RESULT_W(result);
+    }
+    if (sessionCreated) {
+        INCALESCENT_File_DestroySession(&session);
+    }
+    INCALESCENT_Arena_Destroy(&jobs.strings);
+    INCALESCENT_Arena_Destroy(&jobs.arena);
+    if (options.stopEvent != NULL) {
+        SetConsoleCtrlHandler(INCALESCENT_Batch_ConsoleHandler, FALSE);
+    }
+    if (INCALESCENT_Batch_StopEvent != NULL) {
+        CloseHandle(INCALESCENT_Batch_StopEvent);
+    }
+
+    // The performance report is logged as well, so it goes out before the log is stopped.
+    if (FAILED(INCALESCENT_Perf_Report()) && exitCode == INCALESCENT_BATCH_EXIT_SUCCESS) {
+        exitCode = INCALESCENT_BATCH_EXIT_ERROR;
+    }
+
+    // Write whatever is still queued before exiting. A log that couldn't be written is an error
+    // of its own.
+    if (FAILED(INCALESCENT_LogStop()) && exitCode == INCALESCENT_BATCH_EXIT_SUCCESS) {
+        exitCode = INCALESCENT_BATCH_EXIT_ERROR;
+    }
+    return exitCode;
+}
@@ -0,0 +1,96 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_BATCH_H
+#define INCALESCENT_BATCH_H
+
+#define INCALESCENT_ARGUMENT_INPUT L"--input"
+#define INCALESCENT_ARGUMENT_OUTPUT L"--output"
+#define INCALESCENT_ARGUMENT_MANIFEST L"--manifest"
+
+#define INCALESCENT_BATCH_JOB_ARENA_RESERVE (1ULL * 1024 * 1024 * 1024)
+#define INCALESCENT_BATCH_MANIFEST_MAX_SIZE (64 * 1024 * 1024)
+#define INCALESCENT_BATCH_MANIFEST_COMMENT L'#'
+#define INCALESCENT_BATCH_MANIFEST_SEPARATOR L'\t'
+
+// The process exit codes.
+#define INCALESCENT_BATCH_EXIT_SUCCESS 0
+#define INCALESCENT_BATCH_EXIT_DIRECTORY_FAILED 1
+#define INCALESCENT_BATCH_EXIT_INVALID_ARGUMENTS 2
+#define INCALESCENT_BATCH_EXIT_ERROR 3
+
+#define INCALESCENT_BATCH_USAGE L"Usage: incalescent_batch [options] (--input <directory> --output <file> | --manifest <file>)...\n" \
+                                "\n" \
+                                "Consolidates every input directory into its output file. A manifest is a UTF-8 text\n" \
+                                "file with one input directory and output file per line, separated by a tab. Empty\n" \
+                                "lines and lines starting with '#' are skipped.\n" \
+                                "\n" \
+                                "An input may also be a .zip, .tar, .tar.gz or .tgz archive, whose data files are read\n" \
+                                "without extracting it, wherever they are in the archive. Archives can't be read with\n" \
+                                "--source tiff.\n" \
+                                "\n" \
+                                "An output ending in .gz is written as a gzip-compressed CSV table, compressed in the\n" \
+                                "background while the rows are written. The format has to be csv.\n" \
+                                "\n" \
+                                "Options:\n" \
+                                "  --workers <count>         Number of reading workers (default: one per processor).\n" \
+                                "  --encoding utf-8|utf-16   Encoding of the output files (default: utf-8).\n" \
+                                "  --format csv|columnar     Format of the output files (default: csv). A columnar\n" \
+                                "                            file holds every field as a number, see columnar.h.\n" \
+                                "  --source metadata|tiff    Where the fields are read from (default: metadata, the\n" \
+                                "                            .tif.metadata file of every image). With tiff, they are\n" \
+                                "                            read from the text tags of every .tif image instead.\n" \
+                                "  --read auto|overlapped|mapped\n" \
+                                "                            How data files are read (default: auto, which times\n" \
+                                "                            both on the first files and keeps the faster one).\n" \
+                                "                            Images are always read mapped.\n" \
+                                "  --cache                   Reuse the values of unchanged data files.\n" \
+                                "  --recursive               Include the data files of all subdirectories.\n" \
+                                "  --statistics              Write the count, extremes, mean, standard deviation and\n" \
+                                "                            percentiles of every column to <output>.stats.csv.\n" \
+                                "  --pyramid                 Write the minimum, maximum and mean of every column over\n" \
+                                "                            every 10, 100 and 1000 rows to <output>.10.csv and so on,\n" \
+                                "                            for plotting long series.\n" \
+                                "  --watch                   Keep watching the input directory after the table has\n" \
+                                "                            been written, appending a row for every new data file\n" \
+                                "                            until Ctrl+C, SIGINT or SIGTERM. Takes a single input\n" \
+                                "                            and can't be combined with --recursive, archives, a .gz\n" \
+                                "                            output or --format columnar.\n" \
+                                "  --memory-budget <MB>      Keep the memory of every input directory within this many\n" \
+                                "                            megabytes (at least 16), buffers included, sorting the\n" \
+                                "                            names in runs spilled to a temporary file and merged\n" \
+                                "                            while the table is written.\n" \
+                                "                            Can't be combined with --cache, --recursive, --watch,\n" \
+                                "                            archives or --format columnar.\n" \
+                                "  --field <name>            Extract a field into a column of its own. May be given\n" \
+                                "                            up to 16 times (default: the temperature only).\n" \
+                                "  --log-level detail|info|error\n" \
+                                "                            Least important lines to log (default: detail, a line\n" \
+                                "                            for every data file). Progress is logged at info.\n" \
+                                "  --log-file <file>         Log to a file instead of the standard output.\n" \
+                                "  --perf <file>             Time every phase and write a JSON report of the timings\n" \
+                                "                            and counters to the file, also logged as a table.\n" \
+                                "\n" \
+                                "Exit codes: 0 success, 1 a directory failed, 2 invalid arguments, 3 other error.\n"
+
+#endif //INCALESCENT_BATCH_H
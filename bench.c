@@ -0,0 +1,795 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <stdio.h>
+#include <strsafe.h>
+#include "bench.h"
+#include "scan.h"
+#include "file.h"
+#include "match.h"
+#include "corpus.h"
+#include "deflate.h"
+#include "options.h"
+#include "log.h"
+#include "generated_error.h"
+
+typedef struct INCALESCENT_Bench_Corpus {
+    PBYTE data;
+    SIZE_T fileSize;
+    SIZE_T fileCount;
+} INCALESCENT_Bench_Corpus;
+
+// Builds fileCount synthetic metadata files of fileSize bytes each in one allocation, with the
+// temperature key after fieldsBefore other fields.
+static HRESULT INCALESCENT_Bench_CreateCorpus(SIZE_T fileCount, SIZE_T fileSize, SIZE_T fieldsBefore, INCALESCENT_Bench_Corpus *corpus) {
+    INCALESCENT_Corpus_Options options = {
+            .fileCount = fileCount,
+            .fileSize = fileSize,
+            .fieldsBefore = fieldsBefore,
+            .names = INCALESCENT_CORPUS_NAMES_SEQUENTIAL,
+            .values = INCALESCENT_CORPUS_VALUES_DECIMAL,
+    };
+
+    // The last file is formatted in place as well, so there has to be room for its longest form.
+    corpus->data = HeapAlloc(GetProcessHeap(), 0, (fileCount * fileSize) + INCALESCENT_Corpus_FileCapacity(&options));
+    if (corpus->data == NULL) {
+        return E_OUTOFMEMORY;
+    }
+    corpus->fileSize = fileSize;
+    corpus->fileCount = fileCount;
+
+    for (SIZE_T file = 0; file < fileCount; file++) {
+        SIZE_T length;
+        INCALESCENT_Corpus_FormatFile(&options, file, corpus->data + (file * fileSize), &length);
+        if (length != fileSize) {
+            return E_INVALIDARG;
+        }
+    }
+
+    return S_OK;
+}
+
+// The extraction path prior to the byte scanner: transcode the whole buffer to UTF-16 in a fresh
+// page, then match the key one wide character at a time.
+static HRESULT INCALESCENT_Bench_LegacyExtract(const BYTE *data, SIZE_T size, WCHAR value[INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH]) {
+    static const WCHAR key[] = L"" INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING;
+    HRESULT result = INCALESCENT_ERROR_FIELD_VALUE_NOT_FOUND;
+
+    INT wideCount = MultiByteToWideChar(CP_UTF8, 0, (LPCCH) data, (INT) size, NULL, 0);
+    if (wideCount == 0) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    PWSTR string = VirtualAlloc(NULL, sizeof(WCHAR) * wideCount, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (string == NULL) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    wideCount = MultiByteToWideChar(CP_UTF8, 0, (LPCCH) data, (INT) size, string, wideCount);
+
+    SIZE_T matchCount = 0;
+    SIZE_T valueIndex = 0;
+    for (INT index = 0; index < wideCount; index++) {
+        WCHAR character = string[index];
+        if (matchCount == INCALESCENT_STRING_LENGTH(key)) {
+            if (character == L'\r') {
+                value[valueIndex] = L'\0';
+                result = S_OK;
+                break;
+            }
+            if (valueIndex == (INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH - 1)) {
+                result = INCALESCENT_ERROR_FIELD_VALUE_TOO_LARGE;
+                break;
+            }
+            value[valueIndex++] = character;
+            continue;
+        }
+        matchCount = character == key[matchCount] ? matchCount + 1 : 0;
+    }
+
+    VirtualFree(string, 0, MEM_RELEASE);
+    return result;
+}
+
+static DOUBLE INCALESCENT_Bench_Seconds(LARGE_INTEGER start, LARGE_INTEGER end) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return (DOUBLE) (end.QuadPart - start.QuadPart) / (DOUBLE) frequency.QuadPart;
+}
+
+// Sorts a handful of timings in ascending order.
+static void INCALESCENT_Bench_SortSeconds(DOUBLE *seconds, SIZE_T count) {
+    for (SIZE_T index = 1; index < count; index++) {
+        DOUBLE value = seconds[index];
+        SIZE_T position = index;
+        for (; position > 0 && seconds[position - 1] > value; position--) {
+            seconds[position] = seconds[position - 1];
+        }
+        seconds[position] = value;
+    }
+}
+
+// A piece of work to time. Whatever it computes is folded into the checksum, so that the work
+// can't be optimized away.
+typedef HRESULT (*INCALESCENT_Bench_Body)(PVOID context, SIZE_T *checksum);
+
+// Times a body INCALESCENT_BENCH_TRIALS times after an untimed warm-up, and prints the median and
+// fastest trial per item. Work that isn't measured in bytes passes zero bytes.
+static HRESULT INCALESCENT_Bench_Measure(PCSTR name, INCALESCENT_Bench_Body body, PVOID context, DOUBLE items, DOUBLE bytes, PCSTR unit,
+                                         SIZE_T *checksum) {
+    DOUBLE seconds[INCALESCENT_BENCH_TRIALS];
+
+    HRESULT result = body(context, checksum);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    for (DWORD trial = 0; trial < INCALESCENT_BENCH_TRIALS; trial++) {
+        LARGE_INTEGER start;
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&start);
+        result = body(context, checksum);
+        QueryPerformanceCounter(&end);
+        if (FAILED(result)) {
+            return result;
+        }
+        seconds[trial] = INCALESCENT_Bench_Seconds(start, end);
+    }
+    INCALESCENT_Bench_SortSeconds(seconds, INCALESCENT_BENCH_TRIALS);
+
+    DOUBLE median = seconds[INCALESCENT_BENCH_TRIALS / 2];
+    printf("%-28s %10.1f ns/%-4s (fastest %10.1f)", name, (median * 1e9) / items, unit, (seconds[0] * 1e9) / items);
+    if (bytes != 0) {
+        printf(" %10.1f MB/s", bytes / median / 1e6);
+    }
+    printf("\n");
+    return S_OK;
+}
+
+typedef struct INCALESCENT_Bench_ScanContext {
+    INCALESCENT_Scan_Level level;
+    const INCALESCENT_Match *match;
+    const INCALESCENT_Bench_Corpus *corpus;
+} INCALESCENT_Bench_ScanContext;
+
+// A pass of a scan implementation over the corpus.
+static HRESULT INCALESCENT_Bench_Scan(PVOID parameter, SIZE_T *checksum) {
+    const INCALESCENT_Bench_ScanContext *context = parameter;
+    const INCALESCENT_Bench_Corpus *corpus = context->corpus;
+
+    for (SIZE_T repetition = 0; repetition < INCALESCENT_BENCH_REPETITIONS; repetition++) {
+        for (SIZE_T file = 0; file < corpus->fileCount; file++) {
+            const BYTE *data = corpus->data + (file * corpus->fileSize);
+            const BYTE *key = INCALESCENT_Scan_FindWithLevel(
+                    context->level,
+                    data,
+                    corpus->fileSize,
+                    (const BYTE *) INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING,
+                    INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING_LENGTH
+            );
+            if (key == NULL) {
+                return INCALESCENT_ERROR_FIELD_VALUE_NOT_FOUND;
+            }
+            *checksum += (SIZE_T) (key - data);
+        }
+    }
+    return S_OK;
+}
+
+// A pass of the automaton over the corpus with several keys. Only the temperature key is present,
+// so every file is scanned to its end, which is the most a scan can take.
+static HRESULT INCALESCENT_Bench_Match(PVOID parameter, SIZE_T *checksum) {
+    const INCALESCENT_Bench_ScanContext *context = parameter;
+    const INCALESCENT_Bench_Corpus *corpus = context->corpus;
+    const BYTE *ends[INCALESCENT_MATCH_MAX_KEYS];
+
+    for (SIZE_T repetition = 0; repetition < INCALESCENT_BENCH_REPETITIONS; repetition++) {
+        for (SIZE_T file = 0; file < corpus->fileCount; file++) {
+            const BYTE *data = corpus->data + (file * corpus->fileSize);
+            if (INCALESCENT_Match_Find(context->match, data, corpus->fileSize, ends) == 0) {
+                return INCALESCENT_ERROR_FIELD_VALUE_NOT_FOUND;
+            }
+            *checksum += (SIZE_T) (ends[0] - data);
+        }
+    }
+    return S_OK;
+}
+
+// A pass of the extraction over the corpus, or of the legacy extraction without a match.
+static HRESULT INCALESCENT_Bench_Extract(PVOID parameter, SIZE_T *checksum) {
+    const INCALESCENT_Bench_ScanContext *context = parameter;
+    const INCALESCENT_Bench_Corpus *corpus = context->corpus;
+    INCALESCENT_File_Value value;
+
+    for (SIZE_T repetition = 0; repetition < INCALESCENT_BENCH_REPETITIONS; repetition++) {
+        for (SIZE_T file = 0; file < corpus->fileCount; file++) {
+            const BYTE *data = corpus->data + (file * corpus->fileSize);
+            HRESULT result = context->match == NULL
+                             ? INCALESCENT_Bench_LegacyExtract(data, corpus->fileSize, value)
+                             : INCALESCENT_File_ExtractFields(context->match, data, corpus->fileSize, &value, NULL);
+            if (FAILED(result)) {
+                return result;
+            }
+            *checksum += value[0];
+        }
+    }
+    return S_OK;
+}
+
+typedef struct INCALESCENT_Bench_TableContext {
+    // The names in the order a directory listing might return them, and a copy to sort.
+    PWSTR *names;
+    PWSTR *sorted;
+    SIZE_T *nameLengths;
+    INCALESCENT_File_Value *values;
+    SIZE_T count;
+    INCALESCENT_Arena *arena;
+    INCALESCENT_NamePool *namePool;
+    INCALESCENT_Writer *writer;
+    // The encoder of a compressed table and the number of bytes it has produced.
+    INCALESCENT_Deflate *deflate;
+    SIZE_T compressedSize;
+} INCALESCENT_Bench_TableContext;
+
+// A natural sort of the names on the calling thread.
+static HRESULT INCALESCENT_Bench_Sort(PVOID parameter, SIZE_T *checksum) {
+    const INCALESCENT_Bench_TableContext *context = parameter;
+
+    CopyMemory(context->sorted, context->names, sizeof(PWSTR) * context->count);
+    HRESULT result = INCALESCENT_String_NaturalSort(context->sorted, context->count, context->arena, NULL);
+    if (FAILED(result)) {
+        return result;
+    }
+    *checksum += (SIZE_T) context->sorted[0][0];
+    return S_OK;
+}
+
+// Appends the names to a name pool as an enumeration would and sorts it on the calling thread.
+static HRESULT INCALESCENT_Bench_SortPool(PVOID parameter, SIZE_T *checksum) {
+    const INCALESCENT_Bench_TableContext *context = parameter;
+
+    INCALESCENT_NamePool_Clear(context->namePool);
+    for (SIZE_T index = 0; index < context->count; index++) {
+        HRESULT result = INCALESCENT_NamePool_Append(context->namePool, context->names[index], context->nameLengths[index], index, index);
+        if (FAILED(result)) {
+            return result;
+        }
+    }
+    HRESULT result = INCALESCENT_NamePool_Sort(context->namePool, context->arena, NULL);
+    if (FAILED(result)) {
+        return result;
+    }
+    *checksum += context->namePool->order[0];
+    return S_OK;
+}
+
+// Formats a CSV row for every name into the writer, which writes to the null device.
+static HRESULT INCALESCENT_Bench_FormatRows(PVOID parameter, SIZE_T *checksum) {
+    const INCALESCENT_Bench_TableContext *context = parameter;
+
+    for (SIZE_T index = 0; index < context->count; index++) {
+        HRESULT result = INCALESCENT_File_WriteRow(context->writer, index, NULL, 0, context->names[index], context->nameLengths[index],
+                                                   &context->values[index], 1);
+        if (FAILED(result)) {
+            return result;
+        }
+    }
+    *checksum += context->writer->used;
+    return INCALESCENT_Writer_Flush(context->writer);
+}
+
+// Counts the compressed bytes instead of writing them.
+static HRESULT INCALESCENT_Bench_CountCompressed(PVOID parameter, const BYTE *data, SIZE_T size) {
+    UNREFERENCED_PARAMETER(data);
+    INCALESCENT_Bench_TableContext *context = parameter;
+
+    context->compressedSize += size;
+    return S_OK;
+}
+
+// Compresses the formatted rows left in the writer's buffer as the final block of a stream, the
+// work the thread of a compressed table does for every buffer.
+static HRESULT INCALESCENT_Bench_Deflate(PVOID parameter, SIZE_T *checksum) {
+    INCALESCENT_Bench_TableContext *context = parameter;
+
+    HRESULT result = INCALESCENT_Deflate_Compress(context->deflate, context->writer->buffer, context->writer->used, TRUE);
+    *checksum += context->compressedSize;
+    return result;
+}
+
+// Times the sorts, the row formatter and the deflate encoder on INCALESCENT_BENCH_SORT_NAME_COUNT names of the runs
+// pattern, shuffled the same way every time.
+static HRESULT INCALESCENT_Bench_Table(INCALESCENT_Arena *arena, SIZE_T *checksum) {
+    HRESULT result = S_OK;
+    HANDLE heap = GetProcessHeap();
+    HANDLE nullDevice = INVALID_HANDLE_VALUE;
+    INCALESCENT_Writer writer;
+    INCALESCENT_Deflate deflate;
+    INCALESCENT_NamePool namePool = {0};
+    SIZE_T count = INCALESCENT_BENCH_SORT_NAME_COUNT;
+    INCALESCENT_Corpus_Options options = {.fileCount = count, .names = INCALESCENT_CORPUS_NAMES_RUNS};
+    INCALESCENT_Bench_TableContext context = {.count = count, .arena = arena, .namePool = &namePool, .writer = &writer,
+                                             .deflate = &deflate};
+
+    PWSTR strings = HeapAlloc(heap, 0, sizeof(WCHAR) * INCALESCENT_CORPUS_MAX_NAME_LENGTH * count);
+    context.names = HeapAlloc(heap, 0, sizeof(PWSTR) * count);
+    context.sorted = HeapAlloc(heap, 0, sizeof(PWSTR) * count);
+    context.nameLengths = HeapAlloc(heap, 0, sizeof(SIZE_T) * count);
+    context.values = HeapAlloc(heap, 0, sizeof(INCALESCENT_File_Value) * count);
+    if (strings == NULL || context.names == NULL || context.sorted == NULL || context.nameLengths == NULL || context.values == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+
+    for (SIZE_T index = 0; index < count; index++) {
+        context.names[index] = strings + (INCALESCENT_CORPUS_MAX_NAME_LENGTH * index);
+        result = INCALESCENT_Corpus_FormatName(&options, index, context.names[index]);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        context.nameLengths[index] = lstrlenW(context.names[index]);
+        result = StringCchPrintfW(context.values[index], INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH, L"%zu.%02zu", 20 + (index % 180), index % 100);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    // A fixed xorshift sequence, so that every run sorts the same order.
+    ULONGLONG state = 0x9E3779B97F4A7C15ULL;
+    for (SIZE_T index = count - 1; index > 0; index--) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        SIZE_T other = (SIZE_T) (state % (index + 1));
+        PWSTR name = context.names[index];
+        context.names[index] = context.names[other];
+        context.names[other] = name;
+    }
+
+    printf("\n%llu names:\n", (ULONGLONG) count);
+    result = INCALESCENT_Bench_Measure("sort (natural)", INCALESCENT_Bench_Sort, &context, (DOUBLE) count, 0, "name", checksum);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_NamePool_Create(&namePool);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Bench_Measure("append and sort (name pool)", INCALESCENT_Bench_SortPool, &context, (DOUBLE) count, 0, "name", checksum);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    nullDevice = CreateFileW(L"NUL", GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (nullDevice == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    result = INCALESCENT_Writer_Create(&writer, nullDevice, INCALESCENT_WRITER_ENCODING_UTF8, arena);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Bench_Measure("format rows (utf-8)", INCALESCENT_Bench_FormatRows, &context, (DOUBLE) count, 0, "row", checksum);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // The rows are formatted once more and kept in the buffer for the encoder.
+    for (SIZE_T index = 0; index < count; index++) {
+        result = INCALESCENT_File_WriteRow(&writer, index, NULL, 0, context.names[index], context.nameLengths[index], &context.values[index], 1);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    result = INCALESCENT_Deflate_Create(&deflate, INCALESCENT_WRITER_BUFFER_SIZE, arena, INCALESCENT_Bench_CountCompressed, &context);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Bench_Measure("deflate rows (utf-8)", INCALESCENT_Bench_Deflate, &context, (DOUBLE) count, (DOUBLE) writer.used, "row",
+                                       checksum);
+
+    cleanup:
+    INCALESCENT_NamePool_Destroy(&namePool);
+    if (nullDevice != INVALID_HANDLE_VALUE) {
+        CloseHandle(nullDevice);
+    }
+    if (strings != NULL) {
+        HeapFree(heap, 0, strings);
+    }
+    if (context.names != NULL) {
+        HeapFree(heap, 0, context.names);
+    }
+    if (context.sorted != NULL) {
+        HeapFree(heap, 0, context.sorted);
+    }
+    if (context.nameLengths != NULL) {
+        HeapFree(heap, 0, context.nameLengths);
+    }
+    if (context.values != NULL) {
+        HeapFree(heap, 0, context.values);
+    }
+    return result;
+}
+
+// Runs every microbenchmark. The thread is pinned to one processor at a high priority, so that it
+// neither migrates nor gets preempted in the middle of a trial.
+static HRESULT INCALESCENT_Bench_Micro(void) {
+    static const SIZE_T fieldPositions[] = {0, 8, 24};
+    static const PCSTR levelNames[] = {"scan (scalar)", "scan (sse2)", "scan (avx2)"};
+    static const PCSTR keys[] = {INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING, "exposureTime=", "stagePosition=", "timestamp="};
+    HRESULT result = S_OK;
+    SIZE_T checksum = 0;
+    INCALESCENT_Scan_Level supportedLevel = INCALESCENT_Scan_SupportedLevel();
+    INCALESCENT_Arena arena = {0};
+    INCALESCENT_Match *temperature = NULL;
+    INCALESCENT_Match *several = NULL;
+    SIZE_T keyLengths[ARRAYSIZE(keys)];
+    INCALESCENT_Bench_Corpus corpus = {0};
+
+    SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+    SetThreadAffinityMask(GetCurrentThread(), 1);
+
+    for (SIZE_T key = 0; key < ARRAYSIZE(keys); key++) {
+        keyLengths[key] = lstrlenA(keys[key]);
+    }
+    result = INCALESCENT_Arena_Create(&arena, INCALESCENT_BENCH_ARENA_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Match_Create((const BYTE *const *) keys, keyLengths, 1, &arena, &temperature);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Match_Create((const BYTE *const *) keys, keyLengths, ARRAYSIZE(keys), &arena, &several);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (SIZE_T position = 0; position < ARRAYSIZE(fieldPositions); position++) {
+        result = INCALESCENT_Bench_CreateCorpus(INCALESCENT_BENCH_FILE_COUNT, INCALESCENT_FILE_READ_CHUNK_SIZE, fieldPositions[position], &corpus);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        printf("\n%llu files of %llu bytes, key after %llu fields:\n", (ULONGLONG) corpus.fileCount, (ULONGLONG) corpus.fileSize,
+               (ULONGLONG) fieldPositions[position]);
+
+        DOUBLE files = (DOUBLE) (corpus.fileCount * INCALESCENT_BENCH_REPETITIONS);
+        DOUBLE bytes = files * (DOUBLE) corpus.fileSize;
+        INCALESCENT_Bench_ScanContext context = {.corpus = &corpus};
+        for (INT level = INCALESCENT_SCAN_LEVEL_SCALAR; level <= (INT) supportedLevel; level++) {
+            context.level = level;
+            result = INCALESCENT_Bench_Measure(levelNames[level], INCALESCENT_Bench_Scan, &context, files, bytes, "file", &checksum);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+
+        context.match = several;
+        result = INCALESCENT_Bench_Measure("match (4 keys, full scan)", INCALESCENT_Bench_Match, &context, files, bytes, "file", &checksum);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        context.match = temperature;
+        result = INCALESCENT_Bench_Measure("extract (byte scanner)", INCALESCENT_Bench_Extract, &context, files, bytes, "file", &checksum);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        context.match = NULL;
+        result = INCALESCENT_Bench_Measure("extract (legacy UTF-16)", INCALESCENT_Bench_Extract, &context, files, bytes, "file", &checksum);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        HeapFree(GetProcessHeap(), 0, corpus.data);
+        corpus.data = NULL;
+    }
+
+    result = INCALESCENT_Bench_Table(&arena, &checksum);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    printf("\nchecksum %llu\n", (ULONGLONG) checksum);
+
+    cleanup:
+    if (corpus.data != NULL) {
+        HeapFree(GetProcessHeap(), 0, corpus.data);
+    }
+    INCALESCENT_Arena_Destroy(&arena);
+    return result;
+}
+
+// Evicts the data files of a directory from the file cache. Opening a file without buffering makes
+// the file system flush and purge whatever it has cached of it, so the next read goes to the drive.
+// Only the data files directly in the directory are evicted, and the directory itself stays cached.
+static HRESULT INCALESCENT_Bench_Evict(PCWSTR directory, SIZE_T *fileCount) {
+    HRESULT result = S_OK;
+    WCHAR path[INCALESCENT_FILE_FILTER_AGGREGATE_SIZE];
+    WIN32_FIND_DATAW data;
+    HANDLE find = INVALID_HANDLE_VALUE;
+
+    *fileCount = 0;
+    result = StringCchPrintfW(path, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, L"%s\\*" INCALESCENT_FILE_FILTER_SUFFIX, directory);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    find = FindFirstFileExW(path, FindExInfoBasic, &data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH | INCALESCENT_FIND_NAMES_ONLY);
+    if (find == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    do {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            continue;
+        }
+        result = StringCchPrintfW(path, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, L"%s\\%s", directory, data.cFileName);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        CloseHandle(file);
+        (*fileCount)++;
+    } while (FindNextFileW(find, &data));
+
+    if (GetLastError() != ERROR_NO_MORE_FILES) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    cleanup:
+    if (find != INVALID_HANDLE_VALUE) {
+        FindClose(find);
+    }
+    return result;
+}
+
+// Converts a path to UTF-8 for printing with the narrow C library functions.
+static PCSTR INCALESCENT_Bench_Narrow(PCWSTR path, CHAR narrow[INCALESCENT_BENCH_MAX_PATH_BYTES]) {
+    if (WideCharToMultiByte(CP_UTF8, 0, path, -1, narrow, INCALESCENT_BENCH_MAX_PATH_BYTES, NULL, NULL) == 0) {
+        return "?";
+    }
+    return narrow;
+}
+
+static void INCALESCENT_Bench_ReportRun(PCSTR name, DOUBLE seconds, SIZE_T fileCount) {
+    printf("%-28s %10.3f s %12.0f files/s\n", name, seconds, (DOUBLE) fileCount / seconds);
+}
+
+// Times a consolidation of a directory end to end: once right after evicting its data files from
+// the file cache, then warmRuns more times with them cached. All runs share one session, the way
+// the batch front end consolidates one directory after another.
+static HRESULT INCALESCENT_Bench_Consolidate(PWSTR directory, PWSTR output, const INCALESCENT_File_Options *options, DWORD warmRuns) {
+    HRESULT result = S_OK;
+    INCALESCENT_File_Session session;
+    BOOL sessionCreated = FALSE;
+    DOUBLE seconds[INCALESCENT_BENCH_MAX_WARM_RUNS + 1];
+    SIZE_T fileCount = 0;
+    CHAR narrow[INCALESCENT_BENCH_MAX_PATH_BYTES];
+
+    result = INCALESCENT_File_CreateSession(options, &session);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    sessionCreated = TRUE;
+
+    result = INCALESCENT_Bench_Evict(directory, &fileCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (DWORD run = 0; run <= warmRuns; run++) {
+        LARGE_INTEGER start;
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&start);
+        result = INCALESCENT_File_Consolidate(&session, directory, output);
+        QueryPerformanceCounter(&end);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        seconds[run] = INCALESCENT_Bench_Seconds(start, end);
+    }
+
+    printf("%llu data files in %s:\n", (ULONGLONG) fileCount, INCALESCENT_Bench_Narrow(directory, narrow));
+    INCALESCENT_Bench_ReportRun("consolidate (cold)", seconds[0], fileCount);
+    if (warmRuns != 0) {
+        INCALESCENT_Bench_SortSeconds(seconds + 1, warmRuns);
+        INCALESCENT_Bench_ReportRun("consolidate (warm, median)", seconds[1 + (warmRuns / 2)], fileCount);
+        INCALESCENT_Bench_ReportRun("consolidate (warm, fastest)", seconds[1], fileCount);
+    }
+
+    cleanup:
+    if (sessionCreated) {
+        INCALESCENT_File_DestroySession(&session);
+    }
+    return result;
+}
+
+// Parses a decimal count of at most maximum.
+static HRESULT INCALESCENT_Bench_ParseCount(PCWSTR text, SIZE_T maximum, SIZE_T *value) {
+    *value = 0;
+    if (*text == L'\0') {
+        return E_INVALIDARG;
+    }
+    for (PCWSTR character = text; *character != L'\0'; character++) {
+        if (*character < L'0' || *character > L'9') {
+            return E_INVALIDARG;
+        }
+        *value = (*value * 10) + (*character - L'0');
+        if (*value > maximum) {
+            return E_INVALIDARG;
+        }
+    }
+    return S_OK;
+}
+
+// Picks the index of a value out of a list of choices.
+static HRESULT INCALESCENT_Bench_ParseChoice(PCWSTR text, const PCWSTR *choices, DWORD choiceCount, DWORD *choice) {
+    for (DWORD index = 0; index < choiceCount; index++) {
+        if (CompareStringOrdinal(text, -1, choices[index], -1, TRUE) == CSTR_EQUAL) {
+            *choice = index;
+            return S_OK;
+        }
+    }
+    return E_INVALIDARG;
+}
+
+typedef struct INCALESCENT_Bench_Arguments {
+    // The directory to generate a corpus in, or to consolidate. Neither runs the microbenchmarks.
+    PWSTR generate;
+    PWSTR consolidate;
+    PWSTR output;
+    DWORD warmRuns;
+    INCALESCENT_Corpus_Options corpus;
+    INCALESCENT_File_Options options;
+} INCALESCENT_Bench_Arguments;
+
+static HRESULT INCALESCENT_Bench_ParseArguments(INT argumentCount, PWSTR *arguments, INCALESCENT_Bench_Arguments *parsed) {
+    static const PCWSTR names[] = {
+            INCALESCENT_BENCH_ARGUMENT_NAMES_SEQUENTIAL,
+            INCALESCENT_BENCH_ARGUMENT_NAMES_PADDED,
+            INCALESCENT_BENCH_ARGUMENT_NAMES_RUNS,
+    };
+    static const PCWSTR values[] = {
+            INCALESCENT_BENCH_ARGUMENT_VALUES_DECIMAL,
+            INCALESCENT_BENCH_ARGUMENT_VALUES_INTEGER,
+            INCALESCENT_BENCH_ARGUMENT_VALUES_EXPONENT,
+            INCALESCENT_BENCH_ARGUMENT_VALUES_MIXED,
+    };
+    HRESULT result = S_OK;
+
+    // The first argument is the executable's path.
+    for (INT index = 1; index < argumentCount; index++) {
+        BOOL matched = FALSE;
+        result = INCALESCENT_Options_Parse(arguments, argumentCount, &index, &parsed->options, &matched);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        if (matched) {
+            continue;
+        }
+
+        PWSTR argument = arguments[index];
+        if (index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        index++;
+
+        SIZE_T count = 0;
+        DWORD choice = 0;
+        if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_GENERATE, -1, TRUE) == CSTR_EQUAL) {
+            parsed->generate = arguments[index];
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_CONSOLIDATE, -1, TRUE) == CSTR_EQUAL) {
+            parsed->consolidate = arguments[index];
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_OUTPUT, -1, TRUE) == CSTR_EQUAL) {
+            parsed->output = arguments[index];
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_RUNS, -1, TRUE) == CSTR_EQUAL) {
+            result = INCALESCENT_Bench_ParseCount(arguments[index], INCALESCENT_BENCH_MAX_WARM_RUNS, &count);
+            parsed->warmRuns = (DWORD) count;
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_FILES, -1, TRUE) == CSTR_EQUAL) {
+            result = INCALESCENT_Bench_ParseCount(arguments[index], INCALESCENT_CORPUS_MAX_FILE_COUNT, &parsed->corpus.fileCount);
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_SIZE, -1, TRUE) == CSTR_EQUAL) {
+            result = INCALESCENT_Bench_ParseCount(arguments[index], INCALESCENT_CORPUS_MAX_FILE_SIZE, &parsed->corpus.fileSize);
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_POSITION, -1, TRUE) == CSTR_EQUAL) {
+            result = INCALESCENT_Bench_ParseCount(arguments[index], INCALESCENT_CORPUS_MAX_FILE_SIZE / INCALESCENT_CORPUS_MAX_LINE_LENGTH,
+                                                  &parsed->corpus.fieldsBefore);
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_NAMES, -1, TRUE) == CSTR_EQUAL) {
+            result = INCALESCENT_Bench_ParseChoice(arguments[index], names, ARRAYSIZE(names), &choice);
+            parsed->corpus.names = (INCALESCENT_Corpus_Names) choice;
+        } else if (CompareStringOrdinal(argument, -1, INCALESCENT_BENCH_ARGUMENT_VALUES, -1, TRUE) == CSTR_EQUAL) {
+            result = INCALESCENT_Bench_ParseChoice(arguments[index], values, ARRAYSIZE(values), &choice);
+            parsed->corpus.values = (INCALESCENT_Corpus_Values) choice;
+        } else {
+            result = E_INVALIDARG;
+        }
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    // A consolidation needs somewhere to write to, and only one thing can be done at a time.
+    if ((parsed->generate != NULL && parsed->consolidate != NULL) || (parsed->consolidate != NULL) != (parsed->output != NULL)) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    cleanup:
+    return result;
+}
+
+INT wmain(INT argumentCount, PWSTR *arguments) {
+    HRESULT result = S_OK;
+    INCALESCENT_Bench_Arguments parsed = {
+            .warmRuns = INCALESCENT_BENCH_WARM_RUNS,
+            .corpus = {
+                    .fileCount = INCALESCENT_BENCH_CORPUS_FILE_COUNT,
+                    .fileSize = INCALESCENT_BENCH_CORPUS_FILE_SIZE,
+                    .fieldsBefore = INCALESCENT_BENCH_CORPUS_FIELDS_BEFORE,
+                    .names = INCALESCENT_CORPUS_NAMES_SEQUENTIAL,
+                    .values = INCALESCENT_CORPUS_VALUES_DECIMAL,
+            },
+    };
+
+    // A consolidation logs a line for every data file by default, which would be timed along with
+    // it. --log-level still overrides this.
+    INCALESCENT_LogSetLevel(INCALESCENT_LOG_LEVEL_ERROR);
+
+    result = INCALESCENT_Bench_ParseArguments(argumentCount, arguments, &parsed);
+    if (FAILED(result)) {
+        INCALESCENT_LOG_RAW_W(INCALESCENT_BENCH_USAGE);
+        return 2;
+    }
+
+    if (parsed.generate != NULL) {
+        result = INCALESCENT_Corpus_Write(parsed.generate, &parsed.corpus);
+        if (SUCCEEDED(result)) {
+            CHAR narrow[INCALESCENT_BENCH_MAX_PATH_BYTES];
+            printf("Wrote %llu data files of %llu bytes to %s.\n", (ULONGLONG) parsed.corpus.fileCount, (ULONGLONG) parsed.corpus.fileSize,
+                   INCALESCENT_Bench_Narrow(parsed.generate, narrow));
+        }
+    } else if (parsed.consolidate != NULL) {
+        result = INCALESCENT_LogStart();
+        if (SUCCEEDED(result)) {
+            result = INCALESCENT_Bench_Consolidate(parsed.consolidate, parsed.output, &parsed.options, parsed.warmRuns);
+            HRESULT logResult = INCALESCENT_LogStop();
+            if (SUCCEEDED(result)) {
+                result = logResult;
+            }
+        }
+    } else {
+        result = INCALESCENT_Bench_Micro();
+    }
+
+    if (FAILED(result)) {
+        printf("benchmark failed (0x%08x)\n", (unsigned int) result);
+        return 1;
+    }
+    return 0;
+}
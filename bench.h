@@ -0,0 +1,90 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_BENCH_H
+#define INCALESCENT_BENCH_H
+
+#define INCALESCENT_BENCH_FILE_COUNT 4096
+#define INCALESCENT_BENCH_REPETITIONS 64
+#define INCALESCENT_BENCH_ARENA_RESERVE (256 * 1024 * 1024)
+
+// Every measurement is taken this many times after an untimed warm-up, and the median and fastest
+// of them are reported, so a single interruption doesn't skew the result.
+#define INCALESCENT_BENCH_TRIALS 7
+
+// The number of names the sort is timed on, a directory of a size that is common in practice.
+#define INCALESCENT_BENCH_SORT_NAME_COUNT 65536
+
+// The defaults of a generated corpus.
+#define INCALESCENT_BENCH_CORPUS_FILE_COUNT 1000
+#define INCALESCENT_BENCH_CORPUS_FILE_SIZE 4096
+#define INCALESCENT_BENCH_CORPUS_FIELDS_BEFORE 24
+
+// The number of warm runs of an end-to-end benchmark after its cold run.
+#define INCALESCENT_BENCH_WARM_RUNS 5
+#define INCALESCENT_BENCH_MAX_WARM_RUNS 64
+
+// Room for a data file path in UTF-8, at up to three bytes for each of its UTF-16 code units.
+#define INCALESCENT_BENCH_MAX_PATH_BYTES (INCALESCENT_FILE_FILTER_AGGREGATE_SIZE * 3)
+
+#define INCALESCENT_BENCH_ARGUMENT_GENERATE L"--generate"
+#define INCALESCENT_BENCH_ARGUMENT_FILES L"--files"
+#define INCALESCENT_BENCH_ARGUMENT_SIZE L"--size"
+#define INCALESCENT_BENCH_ARGUMENT_POSITION L"--position"
+#define INCALESCENT_BENCH_ARGUMENT_NAMES L"--names"
+#define INCALESCENT_BENCH_ARGUMENT_NAMES_SEQUENTIAL L"sequential"
+#define INCALESCENT_BENCH_ARGUMENT_NAMES_PADDED L"padded"
+#define INCALESCENT_BENCH_ARGUMENT_NAMES_RUNS L"runs"
+#define INCALESCENT_BENCH_ARGUMENT_VALUES L"--values"
+#define INCALESCENT_BENCH_ARGUMENT_VALUES_DECIMAL L"decimal"
+#define INCALESCENT_BENCH_ARGUMENT_VALUES_INTEGER L"integer"
+#define INCALESCENT_BENCH_ARGUMENT_VALUES_EXPONENT L"exponent"
+#define INCALESCENT_BENCH_ARGUMENT_VALUES_MIXED L"mixed"
+#define INCALESCENT_BENCH_ARGUMENT_CONSOLIDATE L"--consolidate"
+#define INCALESCENT_BENCH_ARGUMENT_OUTPUT L"--output"
+#define INCALESCENT_BENCH_ARGUMENT_RUNS L"--runs"
+
+#define INCALESCENT_BENCH_USAGE L"Usage: incalescent_bench\n" \
+                                "       incalescent_bench --generate <directory> [corpus options]\n" \
+                                "       incalescent_bench --consolidate <directory> --output <file> [options]\n" \
+                                "\n" \
+                                "Without arguments, runs the microbenchmarks of the scanners, the extraction, the sort\n" \
+                                "and the row formatter on corpora in memory. --generate writes a corpus of data files,\n" \
+                                "and --consolidate times a cold run with the data files evicted from the file cache\n" \
+                                "followed by warm runs.\n" \
+                                "\n" \
+                                "Corpus options:\n" \
+                                "  --files <count>           Number of data files, up to 1048576 (default: 1000).\n" \
+                                "  --size <bytes>            Size of every data file (default: 4096).\n" \
+                                "  --position <fields>       Fields in front of the temperature (default: 24).\n" \
+                                "  --names sequential|padded|runs\n" \
+                                "                            Names like image_1, image_000001 or run1_image1\n" \
+                                "                            (default: sequential).\n" \
+                                "  --values decimal|integer|exponent|mixed\n" \
+                                "                            Format of the temperatures (default: decimal).\n" \
+                                "\n" \
+                                "Consolidation options:\n" \
+                                "  --runs <count>            Number of warm runs (default: 5).\n" \
+                                "  Any option of incalescent_batch, such as --workers or --read.\n"
+
+#endif //INCALESCENT_BENCH_H
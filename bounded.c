@@ -0,0 +1,310 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "bounded.h"
+#include "table.h"
+#include "runs.h"
+#include "log.h"
+#include "pool.h"
+#include "perf.h"
+#include "generated_error.h"
+
+// What a consolidation within a memory budget keeps while the names come out of the runs.
+typedef struct INCALESCENT_Bounded_Context {
+    INCALESCENT_File_Session *session;
+    PWSTR dataDirectory;
+    INCALESCENT_Runs *runs;
+    INCALESCENT_Table *table;
+
+    // The names of the batch being gathered, and the values and indices of a whole batch.
+    INCALESCENT_File_Names *batch;
+    INCALESCENT_File_Value *values;
+    SIZE_T *indices;
+    SIZE_T batchCapacity;
+
+    // The share of the budget the names are gathered and sorted in, which the run table comes out of.
+    SIZE_T namesBudget;
+
+    // The rows written so far, and the data files read so far out of all of them.
+    SIZE_T rowCount;
+    volatile LONG64 readDone;
+    SIZE_T fileCount;
+} INCALESCENT_Bounded_Context;
+
+// Sorts the names gathered so far and spills them as a run, making room for the next ones.
+static HRESULT INCALESCENT_Bounded_SpillNames(PVOID parameter, INCALESCENT_File_Names *names) {
+    INCALESCENT_Bounded_Context *context = parameter;
+
+    ULONGLONG start = INCALESCENT_Perf_Now();
+    HRESULT result = INCALESCENT_String_NaturalSort(names->entries, names->count, names->arena, context->session->pool);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_Runs_Spill(context->runs, names->entries, names->count);
+    }
+    INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_SORT, start);
+
+    INCALESCENT_File_ClearNames(names);
+    INCALESCENT_Arena_Reset(names->arena, 0);
+
+    // Every run takes an entry in the run table, and merging them in groups adds at most as many
+    // again, so the names make room for twice the table.
+    SIZE_T tableSize = 2 * context->runs->table.used;
+    names->budget = context->namesBudget > tableSize ? context->namesBudget - tableSize : 0;
+    return result;
+}
+
+// Copies a name coming out of the runs into a list, behind its information.
+static HRESULT INCALESCENT_Bounded_CopyName(INCALESCENT_File_Names *names, PWSTR name) {
+    HRESULT result = S_OK;
+    const INCALESCENT_File_NameInfo *nameInfo = INCALESCENT_FILE_NAME_INFO(name);
+    SIZE_T size = sizeof(INCALESCENT_File_NameInfo) + (sizeof(WCHAR) * (nameInfo->length + 1));
+    INCALESCENT_File_NameInfo *info = NULL;
+    PWSTR *entry = NULL;
+
+    result = INCALESCENT_Arena_Allocate(names->arena, size, sizeof(ULONGLONG), (PVOID *) &info);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    CopyMemory(info, nameInfo, size);
+
+    result = INCALESCENT_Arena_Allocate(&names->index, sizeof(PWSTR), sizeof(PWSTR), (PVOID *) &entry);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    *entry = (PWSTR) (info + 1);
+
+    names->entries = (PWSTR *) names->index.base;
+    names->count++;
+
+    cleanup:
+    return result;
+}
+
+// Reads the data files of a batch of sorted names and appends their rows to the table.
+static HRESULT INCALESCENT_Bounded_ConsolidateBatch(INCALESCENT_Bounded_Context *context, PWSTR *names, SIZE_T count) {
+    INCALESCENT_File_Session *session = context->session;
+    DWORD fieldCount = session->fieldCount;
+
+    for (SIZE_T index = 0; index < count; index++) {
+        context->indices[index] = index;
+    }
+    INCALESCENT_File_ReadContext read = {
+            .dataDirectory = context->dataDirectory,
+            .names = names,
+            .values = context->values,
+            .match = session->match,
+            .fieldCount = fieldCount,
+            .io = session->io,
+            .statistics = context->table->statistics,
+            .hint = &session->readHint,
+            .readDone = &context->readDone,
+            .readTotal = context->fileCount,
+            .indices = context->indices,
+            .tiff = session->options.source == INCALESCENT_FILE_SOURCE_TIFF,
+    };
+    HRESULT result = INCALESCENT_File_ReadFiles(session, &read, count);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    for (SIZE_T index = 0; index < count; index++) {
+        result = INCALESCENT_Table_AppendRow(context->table, context->rowCount, NULL, 0, names[index], INCALESCENT_FILE_NAME_INFO(names[index])->length,
+                                             context->values + (index * fieldCount), NULL);
+        if (FAILED(result)) {
+            return result;
+        }
+        context->rowCount++;
+    }
+    return S_OK;
+}
+
+// Consolidates the batch gathered from the runs and clears it for the next one.
+static HRESULT INCALESCENT_Bounded_FlushBatch(INCALESCENT_Bounded_Context *context) {
+    HRESULT result = INCALESCENT_Bounded_ConsolidateBatch(context, context->batch->entries, context->batch->count);
+    INCALESCENT_File_ClearNames(context->batch);
+    INCALESCENT_Arena_Reset(context->batch->arena, 0);
+    return result;
+}
+
+// Gathers the names coming out of the merge into batches, consolidating every full one.
+static HRESULT INCALESCENT_Bounded_MergeName(PVOID parameter, PWSTR name) {
+    INCALESCENT_Bounded_Context *context = parameter;
+
+    HRESULT result = INCALESCENT_Bounded_CopyName(context->batch, name);
+    if (FAILED(result) || context->batch->count < context->batchCapacity) {
+        return result;
+    }
+    return INCALESCENT_Bounded_FlushBatch(context);
+}
+
+// Implementation for INCALESCENT_Bounded_Consolidate
+HRESULT INCALESCENT_Bounded_Consolidate(INCALESCENT_File_Session *session, PWSTR dataDirectory, PWSTR consolidatedFile, HANDLE file) {
+    HRESULT result = S_OK;
+    const INCALESCENT_File_Options *options = &session->options;
+    SIZE_T budget = options->memoryBudget;
+    DWORD fieldCount = session->fieldCount;
+    INCALESCENT_Arena nameArena = {0};
+    INCALESCENT_Arena batchArena = {0};
+    INCALESCENT_File_Names names = {0};
+    INCALESCENT_File_Names batch = {0};
+    INCALESCENT_Runs runs = {0};
+    INCALESCENT_Table table = {0};
+    INCALESCENT_Bounded_Context context = {
+            .session = session,
+            .dataDirectory = dataDirectory,
+            .runs = &runs,
+            .table = &table,
+            .batch = &batch,
+    };
+
+    result = INCALESCENT_Arena_Create(&nameArena, INCALESCENT_FILE_NAME_INDEX_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Create(&batchArena, INCALESCENT_FILE_NAME_INDEX_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_File_CreateNames(&names, &nameArena);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_File_CreateNames(&batch, &batchArena);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // The table is begun before any name is gathered, so everything the session and the table take
+    // is known before the budget is split. Only a columnar table needs to know its rows up front.
+    result = INCALESCENT_Table_CreateStatistics(&table, session);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Table_Begin(&table, session, consolidatedFile, file, 0, FALSE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // What is left of the budget goes half to gathering and sorting the names, and a quarter each
+    // to the merge and the batches.
+    SIZE_T fixedMemory = INCALESCENT_Table_FixedMemory(&table, session);
+    SIZE_T share = budget > fixedMemory ? (budget - fixedMemory) / 4 : 0;
+    if (share < INCALESCENT_Runs_Size(2)) {
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"The memory budget of %llu bytes doesn't leave enough beyond the %llu bytes the table takes...",
+                                                  (ULONGLONG) budget, (ULONGLONG) fixedMemory);
+        if (SUCCEEDED(result)) {
+            result = HRESULT_FROM_WIN32(ERROR_NOT_ENOUGH_QUOTA);
+        }
+        goto cleanup;
+    }
+    result = INCALESCENT_Runs_Create(&runs, share);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    context.namesBudget = 2 * share;
+    names.spill = INCALESCENT_Bounded_SpillNames;
+    names.spillContext = &context;
+    names.budget = context.namesBudget;
+    ULONGLONG start = INCALESCENT_Perf_Now();
+    result = INCALESCENT_File_Enumerate(dataDirectory, session->suffix, FALSE, &names, NULL);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_ENUMERATE, start);
+
+    SIZE_T fileCount = runs.nameCount + names.count;
+    context.fileCount = fileCount;
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Found %llu valid data files...", (ULONGLONG) fileCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    if (fileCount == 0) {
+        result = INCALESCENT_ERROR_NO_DATA_FILES_FOUND;
+        goto cleanup;
+    }
+
+    // The last names only become a run of their own when there are other runs to merge them with.
+    if (runs.runCount != 0) {
+        if (names.count != 0) {
+            result = INCALESCENT_Bounded_SpillNames(&context, &names);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Spilled the names in %llu sorted runs, merging them %llu at a time...", (ULONGLONG) runs.runCount,
+                                                  (ULONGLONG) runs.fanIn);
+    } else {
+        start = INCALESCENT_Perf_Now();
+        result = INCALESCENT_String_NaturalSort(names.entries, names.count, names.arena, session->pool);
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_SORT, start);
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // A batch takes the values and index of every data file in it, and its name at the longest. The
+    // values and indices may each be padded up to their alignment.
+    SIZE_T fileSize = (sizeof(INCALESCENT_File_Value) * fieldCount) + sizeof(SIZE_T) + sizeof(PWSTR) +
+                      INCALESCENT_ARENA_ROUND_UP(INCALESCENT_RUNS_MAX_RECORD_SIZE, sizeof(ULONGLONG));
+    context.batchCapacity = (share - (2 * INCALESCENT_ARENA_DEFAULT_ALIGNMENT)) / fileSize;
+    if (context.batchCapacity > fileCount) {
+        context.batchCapacity = fileCount;
+    }
+    result = INCALESCENT_Arena_Allocate(&session->arena, sizeof(INCALESCENT_File_Value) * fieldCount * context.batchCapacity, sizeof(WCHAR),
+                                        (PVOID *) &context.values);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&session->arena, sizeof(SIZE_T) * context.batchCapacity, sizeof(SIZE_T), (PVOID *) &context.indices);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    if (runs.runCount != 0) {
+        result = INCALESCENT_Runs_Merge(&runs, INCALESCENT_Bounded_MergeName, &context);
+        if (SUCCEEDED(result) && batch.count != 0) {
+            result = INCALESCENT_Bounded_FlushBatch(&context);
+        }
+    } else {
+        for (SIZE_T begin = 0; begin < names.count && SUCCEEDED(result); begin += context.batchCapacity) {
+            SIZE_T count = names.count - begin < context.batchCapacity ? names.count - begin : context.batchCapacity;
+            result = INCALESCENT_Bounded_ConsolidateBatch(&context, names.entries + begin, count);
+        }
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    INCALESCENT_Arena arenas[] = {nameArena, names.index, batchArena, batch.index, runs.table, runs.arena};
+    result = INCALESCENT_Table_End(&table, session, consolidatedFile, file, NULL, arenas, ARRAYSIZE(arenas));
+
+    cleanup:
+    INCALESCENT_Table_Destroy(&table);
+    INCALESCENT_Runs_Destroy(&runs);
+    INCALESCENT_File_FreeNames(&names);
+    INCALESCENT_File_FreeNames(&batch);
+    INCALESCENT_Arena_Destroy(&nameArena);
+    INCALESCENT_Arena_Destroy(&batchArena);
+    return result;
+}
@@ -0,0 +1,55 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_BOUNDED_H
+#define INCALESCENT_BOUNDED_H
+#include "file.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* HANDLE;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+
+/**
+ * @brief Consolidates a directory within the memory budget of the session's options.
+ *
+ * The buffers of the session and the table come out of the budget first. The names are gathered
+ * until the next one wouldn't leave room for sorting them within half of the rest, then sorted and
+ * spilled as a run. The runs are merged back into batches of data files that are read and written
+ * as they come out, the merge and the batches taking a quarter of the rest each. A directory whose
+ * names all fit is sorted in memory instead, without any runs. Every arena of the consolidation
+ * stays within the budget together, so the peak it logs is never above it.
+ *
+ * @param[in] session           The session.
+ * @param[in] dataDirectory     The directory holding the data files.
+ * @param[in] consolidatedFile  The path of the table.
+ * @param[in] file              The table's file, already created.
+ *
+ * @return The result of the consolidation (S_OK if successful), or
+ *         HRESULT_FROM_WIN32(ERROR_NOT_ENOUGH_QUOTA) if the session and the table leave too little
+ *         of the budget for the merge.
+ */
+HRESULT INCALESCENT_Bounded_Consolidate(INCALESCENT_File_Session *session, PWSTR dataDirectory, PWSTR consolidatedFile, HANDLE file);
+
+#endif //INCALESCENT_BOUNDED_H
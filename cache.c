@@ -0,0 +1,314 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include "cache.h"
+#include "log.h"
+
+#define INCALESCENT_CACHE_FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define INCALESCENT_CACHE_FNV_PRIME 0x00000100000001B3ULL
+
+// Hashes bytes with 64-bit FNV-1a, continuing from a previous hash.
+static ULONGLONG INCALESCENT_Cache_Hash(ULONGLONG hash, const BYTE *data, SIZE_T size) {
+    for (SIZE_T index = 0; index < size; index++) {
+        hash ^= data[index];
+        hash *= INCALESCENT_CACHE_FNV_PRIME;
+    }
+    return hash;
+}
+
+// The size of a record including its strings and padding.
+static SIZE_T INCALESCENT_Cache_RecordSize(SIZE_T nameLength, SIZE_T valueLength) {
+    SIZE_T size = sizeof(INCALESCENT_Cache_Entry) + sizeof(WCHAR) * (nameLength + valueLength);
+    return (size + (INCALESCENT_CACHE_RECORD_ALIGNMENT - 1)) & ~((SIZE_T) INCALESCENT_CACHE_RECORD_ALIGNMENT - 1);
+}
+
+// Builds the path of the cache file, or of the temporary file it is written to first.
+static HRESULT INCALESCENT_Cache_Path(PCWSTR outputPath, PCWSTR extension, WCHAR path[INCALESCENT_CACHE_PATH_SIZE]) {
+    HRESULT result = StringCchCopyW(path, INCALESCENT_CACHE_PATH_SIZE, outputPath);
+    if (SUCCEEDED(result)) {
+        result = StringCchCatW(path, INCALESCENT_CACHE_PATH_SIZE, extension);
+    }
+    if (FAILED(result)) {
+        path[0] = L'\0';
+    }
+    return result;
+}
+
+// Checks a loaded payload record by record and fills the lookup table. Returns FALSE if any
+// record runs past the end of the payload or the record count doesn't add up.
+static BOOL INCALESCENT_Cache_Index(INCALESCENT_Cache *cache) {
+    ULONGLONG offset = 0;
+    ULONGLONG count = 0;
+
+    while (offset < cache->payloadSize) {
+        if (cache->payloadSize - offset < sizeof(INCALESCENT_Cache_Entry)) {
+            return FALSE;
+        }
+        const INCALESCENT_Cache_Entry *record = (const INCALESCENT_Cache_Entry *) (cache->payload + offset);
+        SIZE_T recordSize = INCALESCENT_Cache_RecordSize(record->nameLength, record->valueLength);
+        if (cache->payloadSize - offset < recordSize || count == cache->recordCount) {
+            return FALSE;
+        }
+
+        ULONGLONG hash = INCALESCENT_Cache_Hash(INCALESCENT_CACHE_FNV_OFFSET_BASIS, (const BYTE *) (record + 1),
+                                                sizeof(WCHAR) * record->nameLength);
+        SIZE_T slot = (SIZE_T) hash & cache->tableMask;
+        while (cache->table[slot] != 0) {
+            slot = (slot + 1) & cache->tableMask;
+        }
+        cache->table[slot] = offset + 1;
+
+        offset += recordSize;
+        count++;
+    }
+
+    return count == cache->recordCount;
+}
+
+// Implementation for INCALESCENT_Cache_Load
+HRESULT INCALESCENT_Cache_Load(INCALESCENT_Cache *cache, PCWSTR outputPath, const BYTE *schema, SIZE_T schemaSize, INCALESCENT_Arena *arena) {
+    HRESULT result = S_OK;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    WCHAR path[INCALESCENT_CACHE_PATH_SIZE];
+    INCALESCENT_Cache_Header header;
+    DWORD readCount = 0;
+
+    ZeroMemory(cache, sizeof(INCALESCENT_Cache));
+    cache->schemaHash = INCALESCENT_Cache_Hash(INCALESCENT_CACHE_FNV_OFFSET_BASIS, schema, schemaSize);
+    result = INCALESCENT_Arena_Create(&cache->pending, INCALESCENT_CACHE_MAX_FILE_SIZE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Cache_Path(outputPath, INCALESCENT_CACHE_EXTENSION, path);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        // There is no cache yet on the first run.
+        DWORD lastError = GetLastError();
+        if (lastError != ERROR_FILE_NOT_FOUND && lastError != ERROR_PATH_NOT_FOUND) {
+            result = HRESULT_FROM_WIN32(lastError);
+        }
+        goto cleanup;
+    }
+
+    if (!ReadFile(file, &header, sizeof(header), &readCount, NULL)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (readCount != sizeof(header) || header.magic != INCALESCENT_CACHE_MAGIC || header.version != INCALESCENT_CACHE_VERSION ||
+        header.payloadSize > INCALESCENT_CACHE_MAX_FILE_SIZE || header.recordCount > header.payloadSize / sizeof(INCALESCENT_Cache_Entry)) {
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Ignoring the cache at %s, its header is invalid...", path);
+        goto cleanup;
+    }
+    if (header.schemaHash != cache->schemaHash) {
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Ignoring the cache at %s, it was saved with a different schema...", path);
+        goto cleanup;
+    }
+
+    SIZE_T mark = INCALESCENT_Arena_Mark(arena);
+    result = INCALESCENT_Arena_Allocate(arena, (SIZE_T) header.payloadSize, INCALESCENT_CACHE_RECORD_ALIGNMENT, (PVOID *) &cache->payload);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    if (!ReadFile(file, cache->payload, (DWORD) header.payloadSize, &readCount, NULL)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (readCount != header.payloadSize ||
+        INCALESCENT_Cache_Hash(INCALESCENT_CACHE_FNV_OFFSET_BASIS, cache->payload, readCount) != header.payloadHash) {
+        INCALESCENT_Arena_Reset(arena, mark);
+        cache->payload = NULL;
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Ignoring the cache at %s, its contents are damaged...", path);
+        goto cleanup;
+    }
+
+    // Keep the table at most half full so that probe sequences stay short.
+    SIZE_T tableSize = 2;
+    while (tableSize < header.recordCount * 2) {
+        tableSize *= 2;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(ULONGLONG) * tableSize, sizeof(ULONGLONG), (PVOID *) &cache->table);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(cache->table, sizeof(ULONGLONG) * tableSize);
+    cache->tableMask = tableSize - 1;
+    cache->payloadSize = header.payloadSize;
+    cache->recordCount = header.recordCount;
+
+    if (!INCALESCENT_Cache_Index(cache)) {
+        INCALESCENT_Arena_Reset(arena, mark);
+        cache->payload = NULL;
+        cache->table = NULL;
+        cache->payloadSize = 0;
+        cache->recordCount = 0;
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Ignoring the cache at %s, its records are invalid...", path);
+        goto cleanup;
+    }
+
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Loaded %llu cached values from %s...", cache->recordCount, path);
+
+    cleanup:
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Cache_Lookup
+BOOL INCALESCENT_Cache_Lookup(const INCALESCENT_Cache *cache, PCWSTR name, SIZE_T nameLength, ULONGLONG size,
+                              ULONGLONG lastWriteTime, PWSTR value, SIZE_T valueMaxLength) {
+    if (cache->recordCount == 0) {
+        return FALSE;
+    }
+
+    ULONGLONG hash = INCALESCENT_Cache_Hash(INCALESCENT_CACHE_FNV_OFFSET_BASIS, (const BYTE *) name, sizeof(WCHAR) * nameLength);
+    for (SIZE_T slot = (SIZE_T) hash & cache->tableMask; cache->table[slot] != 0; slot = (slot + 1) & cache->tableMask) {
+        const INCALESCENT_Cache_Entry *record = (const INCALESCENT_Cache_Entry *) (cache->payload + cache->table[slot] - 1);
+        const WCHAR *recordName = (const WCHAR *) (record + 1);
+        if (record->nameLength != nameLength ||
+            CompareStringOrdinal(recordName, (INT) nameLength, name, (INT) nameLength, FALSE) != CSTR_EQUAL) {
+            continue;
+        }
+
+        // The name matches, but the file only counts as unchanged if its size and time do too.
+        if (record->size != size || record->lastWriteTime != lastWriteTime || record->valueLength >= valueMaxLength) {
+            return FALSE;
+        }
+        CopyMemory(value, recordName + record->nameLength, sizeof(WCHAR) * record->valueLength);
+        value[record->valueLength] = L'\0';
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+// Implementation for INCALESCENT_Cache_Record
+HRESULT INCALESCENT_Cache_Record(INCALESCENT_Cache *cache, PCWSTR name, SIZE_T nameLength, ULONGLONG size,
+                                 ULONGLONG lastWriteTime, PCWSTR value, SIZE_T valueLength) {
+    HRESULT result = S_OK;
+    INCALESCENT_Cache_Entry *record = NULL;
+
+    // The pending arena holds nothing else, so the records land back to back as the payload.
+    result = INCALESCENT_Arena_Allocate(&cache->pending, INCALESCENT_Cache_RecordSize(nameLength, valueLength),
+                                        INCALESCENT_CACHE_RECORD_ALIGNMENT, (PVOID *) &record);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    record->size = size;
+    record->lastWriteTime = lastWriteTime;
+    record->nameLength = (unsigned short) nameLength;
+    record->valueLength = (unsigned short) valueLength;
+    CopyMemory(record + 1, name, sizeof(WCHAR) * nameLength);
+    CopyMemory((PWSTR) (record + 1) + nameLength, value, sizeof(WCHAR) * valueLength);
+    cache->pendingCount++;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Cache_Save
+HRESULT INCALESCENT_Cache_Save(INCALESCENT_Cache *cache, PCWSTR outputPath) {
+    HRESULT result = S_OK;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    WCHAR path[INCALESCENT_CACHE_PATH_SIZE];
+    WCHAR temporaryPath[INCALESCENT_CACHE_PATH_SIZE] = {0};
+    DWORD writeCount = 0;
+
+    result = INCALESCENT_Cache_Path(outputPath, INCALESCENT_CACHE_EXTENSION, path);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Cache_Path(outputPath, INCALESCENT_CACHE_TEMPORARY_EXTENSION, temporaryPath);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    INCALESCENT_Cache_Header header = {
+            .magic = INCALESCENT_CACHE_MAGIC,
+            .version = INCALESCENT_CACHE_VERSION,
+            .schemaHash = cache->schemaHash,
+            .recordCount = cache->pendingCount,
+            .payloadSize = cache->pending.used,
+            .payloadHash = INCALESCENT_Cache_Hash(INCALESCENT_CACHE_FNV_OFFSET_BASIS, cache->pending.base, cache->pending.used),
+    };
+
+    file = CreateFileW(temporaryPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (!WriteFile(file, &header, sizeof(header), &writeCount, NULL)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (writeCount != sizeof(header)) {
+        result = HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+        goto cleanup;
+    }
+    if (!WriteFile(file, cache->pending.base, (DWORD) cache->pending.used, &writeCount, NULL)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (writeCount != cache->pending.used) {
+        result = HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+        goto cleanup;
+    }
+
+    // The contents have to reach the disk before the rename does, otherwise a crash could leave a
+    // renamed but empty file behind.
+    if (!FlushFileBuffers(file)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+
+    if (!MoveFileExW(temporaryPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Saved %llu values to the cache at %s...", cache->pendingCount, path);
+
+    cleanup:
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    if (FAILED(result) && temporaryPath[0] != L'\0') {
+        DeleteFileW(temporaryPath);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Cache_Destroy
+void INCALESCENT_Cache_Destroy(INCALESCENT_Cache *cache) {
+    INCALESCENT_Arena_Destroy(&cache->pending);
+    ZeroMemory(cache, sizeof(INCALESCENT_Cache));
+}
@@ -0,0 +1,134 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_CACHE_H
+#define INCALESCENT_CACHE_H
+#include "arena.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef int BOOL;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+typedef const WCHAR* PCWSTR;
+typedef unsigned char BYTE;
+typedef unsigned char* PBYTE;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+#define INCALESCENT_CACHE_EXTENSION L".cache"
+#define INCALESCENT_CACHE_TEMPORARY_EXTENSION L".cache.tmp"
+#define INCALESCENT_CACHE_PATH_SIZE ((260 * 2) + 16)
+#define INCALESCENT_CACHE_MAGIC 0x48434E49 // "INCH" in little-endian byte order
+#define INCALESCENT_CACHE_VERSION 2
+#define INCALESCENT_CACHE_MAX_FILE_SIZE (1ULL * 1024 * 1024 * 1024)
+#define INCALESCENT_CACHE_RECORD_ALIGNMENT 8
+
+/*
+ * The cache file layout (all integers are little-endian):
+ *
+ *   header:  UINT32 magic, UINT32 version, UINT64 FNV-1a hash of the schema, UINT64 record
+ *            count, UINT64 payload size, UINT64 FNV-1a hash of the payload
+ *   payload: one record per data file, back to back, each padded to a multiple of 8 bytes:
+ *            UINT64 file size, UINT64 last write time (FILETIME), UINT16 name length,
+ *            UINT16 value length, WCHAR name[name length], WCHAR value[value length]
+ *
+ * A file that is truncated, has a different version or schema or doesn't match its hash is
+ * ignored as a whole, so a crash while the cache is being replaced costs at most one full re-read.
+ * The schema describes what the values are, so values of other fields are never mixed in.
+ */
+typedef struct INCALESCENT_Cache_Header {
+    DWORD magic;
+    DWORD version;
+    ULONGLONG schemaHash;
+    ULONGLONG recordCount;
+    ULONGLONG payloadSize;
+    ULONGLONG payloadHash;
+} INCALESCENT_Cache_Header;
+
+typedef struct INCALESCENT_Cache_Entry {
+    ULONGLONG size;
+    ULONGLONG lastWriteTime;
+    unsigned short nameLength;
+    unsigned short valueLength;
+} INCALESCENT_Cache_Entry;
+
+typedef struct INCALESCENT_Cache {
+    // The records of the previous run and an open-addressing table of their payload offsets, each
+    // stored plus one so that zero marks an empty slot.
+    PBYTE payload;
+    ULONGLONG payloadSize;
+    ULONGLONG recordCount;
+    ULONGLONG *table;
+    SIZE_T tableMask;
+    ULONGLONG schemaHash;
+
+    // The records of the current run, which replace the file when it is saved.
+    INCALESCENT_Arena pending;
+    ULONGLONG pendingCount;
+} INCALESCENT_Cache;
+
+/**
+ * @brief Loads the cache file kept next to an output file.
+ *
+ * A missing or damaged cache file isn't an error, the cache simply starts out empty.
+ *
+ * @param[out] cache        The cache to initialize.
+ * @param[in] outputPath    The path of the consolidated output. The cache lives at the same path
+ *                          with INCALESCENT_CACHE_EXTENSION appended.
+ * @param[in] schema        Describes the values. A cache file saved with another schema is ignored.
+ * @param[in] schemaSize    The size of the schema in bytes.
+ * @param[in] arena         The arena the previous run's records are loaded into.
+ *
+ * @return The result of the load (S_OK if successful).
+ */
+HRESULT INCALESCENT_Cache_Load(INCALESCENT_Cache *cache, PCWSTR outputPath, const BYTE *schema, SIZE_T schemaSize, INCALESCENT_Arena *arena);
+
+/**
+ * @brief Looks up the value recorded for a data file by the previous run.
+ *
+ * @return TRUE if the file has a record with the same size and last write time, in which case the
+ *         value is copied to value (at most valueMaxLength characters including the terminator).
+ */
+BOOL INCALESCENT_Cache_Lookup(const INCALESCENT_Cache *cache, PCWSTR name, SIZE_T nameLength, ULONGLONG size,
+                              ULONGLONG lastWriteTime, PWSTR value, SIZE_T valueMaxLength);
+
+/**
+ * @brief Records a data file's value for the next run.
+ *
+ * @return S_OK if successful, or E_OUTOFMEMORY once the cache would exceed INCALESCENT_CACHE_MAX_FILE_SIZE.
+ */
+HRESULT INCALESCENT_Cache_Record(INCALESCENT_Cache *cache, PCWSTR name, SIZE_T nameLength, ULONGLONG size,
+                                 ULONGLONG lastWriteTime, PCWSTR value, SIZE_T valueLength);
+
+/**
+ * @brief Replaces the cache file with the records of the current run.
+ *
+ * The records are written to a temporary file that is flushed to disk and then renamed over the
+ * cache file, so the cache file is always either the old one or the complete new one.
+ */
+HRESULT INCALESCENT_Cache_Save(INCALESCENT_Cache *cache, PCWSTR outputPath);
+
+void INCALESCENT_Cache_Destroy(INCALESCENT_Cache *cache);
+
+#endif //INCALESCENT_CACHE_H
@@ -0,0 +1,444 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <math.h>
+#include "columnar.h"
+
+#define INCALESCENT_COLUMNAR_FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define INCALESCENT_COLUMNAR_FNV_PRIME 0x00000100000001B3ULL
+
+#define INCALESCENT_COLUMNAR_ROUND_UP(value) (((value) + (INCALESCENT_COLUMNAR_ALIGNMENT - 1)) & ~((ULONGLONG) INCALESCENT_COLUMNAR_ALIGNMENT - 1))
+
+// The largest single write, which keeps the byte count within a DWORD.
+#define INCALESCENT_COLUMNAR_MAX_WRITE (1024 * 1024 * 1024)
+
+// The number of index values generated at a time while the index column is written.
+#define INCALESCENT_COLUMNAR_INDEX_BATCH 4096
+
+#define INCALESCENT_COLUMNAR_INDEX_NAME "Index"
+#define INCALESCENT_COLUMNAR_DIRECTORY_NAME "Directory"
+#define INCALESCENT_COLUMNAR_FILE_NAME "File"
+
+// A UTF-16 unit never takes more than 3 bytes in UTF-8.
+#define INCALESCENT_COLUMNAR_MAX_BYTES_PER_UNIT 3
+
+static ULONGLONG INCALESCENT_Columnar_Hash(const BYTE *data, SIZE_T size) {
+    ULONGLONG hash = INCALESCENT_COLUMNAR_FNV_OFFSET_BASIS;
+    for (SIZE_T index = 0; index < size; index++) {
+        hash ^= data[index];
+        hash *= INCALESCENT_COLUMNAR_FNV_PRIME;
+    }
+    return hash;
+}
+
+// Converts a string to UTF-8 at the end of the arena. The arena is trimmed to the converted bytes,
+// so they can be given back by resetting the arena to its mark from before the call.
+static HRESULT INCALESCENT_Columnar_ToUtf8(INCALESCENT_Arena *arena, PCWSTR string, SIZE_T length, PBYTE *bytes, DWORD *byteCount) {
+    HRESULT result = S_OK;
+    SIZE_T mark = INCALESCENT_Arena_Mark(arena);
+
+    result = INCALESCENT_Arena_Allocate(arena, (INCALESCENT_COLUMNAR_MAX_BYTES_PER_UNIT * length) + 1, 1, (PVOID *) bytes);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    INT converted = 0;
+    if (length != 0) {
+        converted = WideCharToMultiByte(CP_UTF8, 0, string, (INT) length, (LPSTR) *bytes, (INT) (INCALESCENT_COLUMNAR_MAX_BYTES_PER_UNIT * length),
+                                        NULL, NULL);
+        if (converted == 0) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+    }
+    *byteCount = converted;
+    INCALESCENT_Arena_Reset(arena, mark + converted);
+
+    cleanup:
+    return result;
+}
+
+static HRESULT INCALESCENT_Columnar_CreateDictionary(INCALESCENT_Columnar_Dictionary *dictionary, INCALESCENT_Arena *arena, SIZE_T rowCount) {
+    HRESULT result = S_OK;
+
+    ZeroMemory(dictionary, sizeof(INCALESCENT_Columnar_Dictionary));
+
+    // Keep the table at most half full so that probe sequences stay short.
+    SIZE_T tableSize = 2;
+    while (tableSize < rowCount * 2) {
+        tableSize *= 2;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * tableSize, sizeof(DWORD), (PVOID *) &dictionary->table);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(dictionary->table, sizeof(DWORD) * tableSize);
+    dictionary->tableMask = tableSize - 1;
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(PBYTE) * rowCount, sizeof(PBYTE), (PVOID *) &dictionary->entries);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * rowCount, sizeof(DWORD), (PVOID *) &dictionary->entryLengths);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * rowCount, sizeof(DWORD), (PVOID *) &dictionary->indices);
+
+    cleanup:
+    return result;
+}
+
+// Stores a row's string in a dictionary, adding it as a new entry if it isn't there yet.
+static HRESULT INCALESCENT_Columnar_Intern(INCALESCENT_Columnar_Dictionary *dictionary, INCALESCENT_Arena *arena, SIZE_T row,
+                                           PCWSTR string, SIZE_T length) {
+    HRESULT result = S_OK;
+    SIZE_T mark = INCALESCENT_Arena_Mark(arena);
+    PBYTE bytes = NULL;
+    DWORD byteCount = 0;
+
+    result = INCALESCENT_Columnar_ToUtf8(arena, string, length, &bytes, &byteCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    SIZE_T slot = (SIZE_T) INCALESCENT_Columnar_Hash(bytes, byteCount) & dictionary->tableMask;
+    for (; dictionary->table[slot] != 0; slot = (slot + 1) & dictionary->tableMask) {
+        DWORD entry = dictionary->table[slot] - 1;
+        if (dictionary->entryLengths[entry] == byteCount && RtlEqualMemory(dictionary->entries[entry], bytes, byteCount)) {
+            // The string is already stored, so the converted copy isn't needed.
+            INCALESCENT_Arena_Reset(arena, mark);
+            dictionary->indices[row] = entry;
+            goto cleanup;
+        }
+    }
+
+    dictionary->entries[dictionary->entryCount] = bytes;
+    dictionary->entryLengths[dictionary->entryCount] = byteCount;
+    dictionary->indices[row] = (DWORD) dictionary->entryCount;
+    dictionary->entryCount++;
+    dictionary->table[slot] = (DWORD) dictionary->entryCount;
+    dictionary->dataSize += byteCount;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Columnar_Create
+HRESULT INCALESCENT_Columnar_Create(INCALESCENT_Columnar *columnar, INCALESCENT_Arena *arena, SIZE_T rowCount, BOOL hasDirectories,
+                                    const PCWSTR *fieldNames, DWORD fieldCount) {
+    HRESULT result = S_OK;
+
+    ZeroMemory(columnar, sizeof(INCALESCENT_Columnar));
+    if (fieldCount > INCALESCENT_COLUMNAR_MAX_FIELDS || rowCount > MAXDWORD) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+    columnar->arena = arena;
+    columnar->rowCapacity = rowCount;
+    columnar->hasDirectories = hasDirectories;
+    columnar->fieldCount = fieldCount;
+
+    if (hasDirectories) {
+        result = INCALESCENT_Columnar_CreateDictionary(&columnar->directories, arena, rowCount);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    result = INCALESCENT_Columnar_CreateDictionary(&columnar->files, arena, rowCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    SIZE_T validitySize = (rowCount + 7) / 8;
+    for (DWORD field = 0; field < fieldCount; field++) {
+        columnar->fieldNames[field] = fieldNames[field];
+        result = INCALESCENT_Arena_Allocate(arena, sizeof(DOUBLE) * rowCount, sizeof(DOUBLE), (PVOID *) &columnar->values[field]);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_Arena_Allocate(arena, validitySize, 1, (PVOID *) &columnar->validity[field]);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        ZeroMemory(columnar->validity[field], validitySize);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Columnar_AppendRow
+HRESULT INCALESCENT_Columnar_AppendRow(INCALESCENT_Columnar *columnar, PCWSTR directory, SIZE_T directoryLength,
+                                       PCWSTR file, SIZE_T fileLength, const DOUBLE *values) {
+    HRESULT result = S_OK;
+    SIZE_T row = columnar->rowCount;
+
+    if (row == columnar->rowCapacity) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    if (columnar->hasDirectories) {
+        result = INCALESCENT_Columnar_Intern(&columnar->directories, columnar->arena, row, directory, directoryLength);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    result = INCALESCENT_Columnar_Intern(&columnar->files, columnar->arena, row, file, fileLength);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (DWORD field = 0; field < columnar->fieldCount; field++) {
+        if (isnan(values[field])) {
+            columnar->values[field][row] = 0.0;
+        } else {
+            columnar->values[field][row] = values[field];
+            columnar->validity[field][row / 8] |= (BYTE) (1 << (row % 8));
+        }
+    }
+    columnar->rowCount++;
+
+    cleanup:
+    return result;
+}
+
+// Writes bytes at an offset past the current position, filling the gap with zeros.
+static HRESULT INCALESCENT_Columnar_WriteAt(HANDLE file, ULONGLONG *position, ULONGLONG offset, const void *data, SIZE_T size) {
+    static const BYTE zeros[INCALESCENT_COLUMNAR_ALIGNMENT] = {0};
+    DWORD writeCount = 0;
+
+    if (offset > *position) {
+        if (!WriteFile(file, zeros, (DWORD) (offset - *position), &writeCount, NULL)) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        if (writeCount != offset - *position) {
+            return HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+        }
+        *position = offset;
+    }
+
+    const BYTE *bytes = data;
+    while (size != 0) {
+        DWORD chunk = size > INCALESCENT_COLUMNAR_MAX_WRITE ? INCALESCENT_COLUMNAR_MAX_WRITE : (DWORD) size;
+        if (!WriteFile(file, bytes, chunk, &writeCount, NULL)) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        if (writeCount != chunk) {
+            return HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+        }
+        bytes += chunk;
+        size -= chunk;
+        *position += chunk;
+    }
+    return S_OK;
+}
+
+// Reserves the next aligned section of the file and returns its offset.
+static ULONGLONG INCALESCENT_Columnar_Place(ULONGLONG *end, ULONGLONG size) {
+    ULONGLONG offset = INCALESCENT_COLUMNAR_ROUND_UP(*end);
+    *end = offset + size;
+    return offset;
+}
+
+// Lays out a dictionary column's sections and flattens its entries into one offsets array and one
+// block of bytes, so each can be written at once.
+static HRESULT INCALESCENT_Columnar_PlaceDictionary(INCALESCENT_Columnar *columnar, const INCALESCENT_Columnar_Dictionary *dictionary,
+                                                    INCALESCENT_Columnar_Column *column, ULONGLONG *end,
+                                                    ULONGLONG **offsets, PBYTE *data) {
+    HRESULT result = S_OK;
+
+    result = INCALESCENT_Arena_Allocate(columnar->arena, sizeof(ULONGLONG) * (dictionary->entryCount + 1), sizeof(ULONGLONG), (PVOID *) offsets);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(columnar->arena, dictionary->dataSize + 1, 1, (PVOID *) data);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    ULONGLONG used = 0;
+    for (SIZE_T entry = 0; entry < dictionary->entryCount; entry++) {
+        (*offsets)[entry] = used;
+        CopyMemory(*data + used, dictionary->entries[entry], dictionary->entryLengths[entry]);
+        used += dictionary->entryLengths[entry];
+    }
+    (*offsets)[dictionary->entryCount] = used;
+
+    column->type = INCALESCENT_COLUMNAR_TYPE_DICTIONARY;
+    column->dataOffset = INCALESCENT_Columnar_Place(end, sizeof(DWORD) * columnar->rowCount);
+    column->dictionaryCount = dictionary->entryCount;
+    column->dictionaryOffsetsOffset = INCALESCENT_Columnar_Place(end, sizeof(ULONGLONG) * (dictionary->entryCount + 1));
+    column->dictionaryDataOffset = INCALESCENT_Columnar_Place(end, dictionary->dataSize);
+
+    cleanup:
+    return result;
+}
+
+static HRESULT INCALESCENT_Columnar_WriteDictionary(HANDLE file, ULONGLONG *position, const INCALESCENT_Columnar *columnar,
+                                                    const INCALESCENT_Columnar_Dictionary *dictionary, const INCALESCENT_Columnar_Column *column,
+                                                    const ULONGLONG *offsets, const BYTE *data) {
+    HRESULT result = INCALESCENT_Columnar_WriteAt(file, position, column->dataOffset, dictionary->indices, sizeof(DWORD) * columnar->rowCount);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_Columnar_WriteAt(file, position, column->dictionaryOffsetsOffset, offsets,
+                                              sizeof(ULONGLONG) * (dictionary->entryCount + 1));
+    }
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_Columnar_WriteAt(file, position, column->dictionaryDataOffset, data, dictionary->dataSize);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Columnar_Write
+HRESULT INCALESCENT_Columnar_Write(INCALESCENT_Columnar *columnar, HANDLE file) {
+    HRESULT result = S_OK;
+    INCALESCENT_Arena *arena = columnar->arena;
+    SIZE_T mark = INCALESCENT_Arena_Mark(arena);
+    INCALESCENT_Columnar_Column columns[3 + INCALESCENT_COLUMNAR_MAX_FIELDS] = {0};
+    const BYTE *names[3 + INCALESCENT_COLUMNAR_MAX_FIELDS];
+    ULONGLONG *directoryOffsets = NULL;
+    PBYTE directoryData = NULL;
+    ULONGLONG *fileOffsets = NULL;
+    PBYTE fileData = NULL;
+    ULONGLONG indices[INCALESCENT_COLUMNAR_INDEX_BATCH];
+
+    // The index column comes first, then the directory column if there is one, the file column and
+    // the field columns.
+    DWORD columnCount = 0;
+    DWORD indexColumn = columnCount++;
+    names[indexColumn] = (const BYTE *) INCALESCENT_COLUMNAR_INDEX_NAME;
+    columns[indexColumn].nameLength = sizeof(INCALESCENT_COLUMNAR_INDEX_NAME) - 1;
+    DWORD directoryColumn = 0;
+    if (columnar->hasDirectories) {
+        directoryColumn = columnCount++;
+        names[directoryColumn] = (const BYTE *) INCALESCENT_COLUMNAR_DIRECTORY_NAME;
+        columns[directoryColumn].nameLength = sizeof(INCALESCENT_COLUMNAR_DIRECTORY_NAME) - 1;
+    }
+    DWORD fileColumn = columnCount++;
+    names[fileColumn] = (const BYTE *) INCALESCENT_COLUMNAR_FILE_NAME;
+    columns[fileColumn].nameLength = sizeof(INCALESCENT_COLUMNAR_FILE_NAME) - 1;
+    DWORD firstFieldColumn = columnCount;
+    for (DWORD field = 0; field < columnar->fieldCount; field++) {
+        PBYTE name = NULL;
+        result = INCALESCENT_Columnar_ToUtf8(arena, columnar->fieldNames[field], lstrlenW(columnar->fieldNames[field]), &name,
+                                             &columns[columnCount].nameLength);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        names[columnCount] = name;
+        columnCount++;
+    }
+
+    // Lay out the whole file before writing any of it.
+    INCALESCENT_Columnar_Header header = {
+            .magic = INCALESCENT_COLUMNAR_MAGIC,
+            .version = INCALESCENT_COLUMNAR_VERSION,
+            .rowCount = columnar->rowCount,
+            .columnCount = columnCount,
+    };
+    ULONGLONG end = sizeof(header);
+    header.columnsOffset = INCALESCENT_Columnar_Place(&end, sizeof(INCALESCENT_Columnar_Column) * columnCount);
+    for (DWORD column = 0; column < columnCount; column++) {
+        columns[column].nameOffset = INCALESCENT_Columnar_Place(&end, columns[column].nameLength);
+    }
+
+    columns[indexColumn].type = INCALESCENT_COLUMNAR_TYPE_UINT64;
+    columns[indexColumn].dataOffset = INCALESCENT_Columnar_Place(&end, sizeof(ULONGLONG) * columnar->rowCount);
+    if (columnar->hasDirectories) {
+        result = INCALESCENT_Columnar_PlaceDictionary(columnar, &columnar->directories, &columns[directoryColumn], &end,
+                                                      &directoryOffsets, &directoryData);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    result = INCALESCENT_Columnar_PlaceDictionary(columnar, &columnar->files, &columns[fileColumn], &end, &fileOffsets, &fileData);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    for (DWORD field = 0; field < columnar->fieldCount; field++) {
+        INCALESCENT_Columnar_Column *column = &columns[firstFieldColumn + field];
+        column->type = INCALESCENT_COLUMNAR_TYPE_FLOAT64;
+        column->dataOffset = INCALESCENT_Columnar_Place(&end, sizeof(DOUBLE) * columnar->rowCount);
+        column->validityOffset = INCALESCENT_Columnar_Place(&end, (columnar->rowCount + 7) / 8);
+    }
+
+    // Write the sections in the order they were placed.
+    ULONGLONG position = 0;
+    result = INCALESCENT_Columnar_WriteAt(file, &position, 0, &header, sizeof(header));
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Columnar_WriteAt(file, &position, header.columnsOffset, columns, sizeof(INCALESCENT_Columnar_Column) * columnCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    for (DWORD column = 0; column < columnCount; column++) {
+        result = INCALESCENT_Columnar_WriteAt(file, &position, columns[column].nameOffset, names[column], columns[column].nameLength);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    // The index column is generated a batch at a time.
+    for (SIZE_T row = 0; row < columnar->rowCount; row += INCALESCENT_COLUMNAR_INDEX_BATCH) {
+        SIZE_T count = columnar->rowCount - row < INCALESCENT_COLUMNAR_INDEX_BATCH ? columnar->rowCount - row : INCALESCENT_COLUMNAR_INDEX_BATCH;
+        for (SIZE_T index = 0; index < count; index++) {
+            indices[index] = row + index;
+        }
+        result = INCALESCENT_Columnar_WriteAt(file, &position, columns[indexColumn].dataOffset + (sizeof(ULONGLONG) * row), indices,
+                                              sizeof(ULONGLONG) * count);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    if (columnar->hasDirectories) {
+        result = INCALESCENT_Columnar_WriteDictionary(file, &position, columnar, &columnar->directories, &columns[directoryColumn],
+                                                      directoryOffsets, directoryData);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    result = INCALESCENT_Columnar_WriteDictionary(file, &position, columnar, &columnar->files, &columns[fileColumn], fileOffsets, fileData);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (DWORD field = 0; field < columnar->fieldCount; field++) {
+        const INCALESCENT_Columnar_Column *column = &columns[firstFieldColumn + field];
+        result = INCALESCENT_Columnar_WriteAt(file, &position, column->dataOffset, columnar->values[field], sizeof(DOUBLE) * columnar->rowCount);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_Columnar_WriteAt(file, &position, column->validityOffset, columnar->validity[field], (columnar->rowCount + 7) / 8);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    cleanup:
+    INCALESCENT_Arena_Reset(arena, mark);
+    return result;
+}
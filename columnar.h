@@ -0,0 +1,153 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_COLUMNAR_H
+#define INCALESCENT_COLUMNAR_H
+#include "arena.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef double DOUBLE;
+typedef unsigned short WCHAR;
+typedef const WCHAR* PCWSTR;
+typedef void* HANDLE;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+#define INCALESCENT_COLUMNAR_MAGIC 0x43434E49 // "INCC" in little-endian byte order
+#define INCALESCENT_COLUMNAR_VERSION 1
+#define INCALESCENT_COLUMNAR_ALIGNMENT 64
+#define INCALESCENT_COLUMNAR_MAX_FIELDS 16
+
+/*
+ * The columnar file layout (all integers and floats are little-endian, all offsets are from the
+ * start of the file and every section starts at a multiple of 64 bytes, so a reader can map the
+ * file and use the columns in place):
+ *
+ *   header:   UINT32 magic, UINT32 version, UINT64 row count, UINT32 column count,
+ *             UINT32 reserved, UINT64 offset of the column descriptors
+ *   columns:  one descriptor per column: UINT32 type, UINT32 name length, UINT64 name offset,
+ *             UINT64 data offset, UINT64 validity offset, UINT64 dictionary count,
+ *             UINT64 dictionary offsets offset, UINT64 dictionary data offset
+ *   sections: the UTF-8 column names, then the data of every column in order
+ *
+ * The data of a column depends on its type:
+ *
+ *   UINT64:      UINT64 value[row count]
+ *   DICTIONARY:  UINT32 index[row count] into the dictionary, whose entries are UTF-8 strings.
+ *                Entry i spans the bytes [offsets[i], offsets[i + 1]) of the dictionary data,
+ *                with UINT64 offsets[dictionary count + 1].
+ *   FLOAT64:     DOUBLE value[row count], plus a validity bitmap of (row count + 7) / 8 bytes.
+ *                Bit (i % 8) of byte (i / 8) is set if row i has a value, the same as in Apache
+ *                Arrow. The value of a row without one is 0.
+ *
+ * Offsets a column doesn't use are 0.
+ */
+typedef enum INCALESCENT_Columnar_Type {
+    INCALESCENT_COLUMNAR_TYPE_UINT64 = 1,
+    INCALESCENT_COLUMNAR_TYPE_DICTIONARY = 2,
+    INCALESCENT_COLUMNAR_TYPE_FLOAT64 = 3,
+} INCALESCENT_Columnar_Type;
+
+typedef struct INCALESCENT_Columnar_Header {
+    DWORD magic;
+    DWORD version;
+    ULONGLONG rowCount;
+    DWORD columnCount;
+    DWORD reserved;
+    ULONGLONG columnsOffset;
+} INCALESCENT_Columnar_Header;
+
+typedef struct INCALESCENT_Columnar_Column {
+    DWORD type;
+    DWORD nameLength;
+    ULONGLONG nameOffset;
+    ULONGLONG dataOffset;
+    ULONGLONG validityOffset;
+    ULONGLONG dictionaryCount;
+    ULONGLONG dictionaryOffsetsOffset;
+    ULONGLONG dictionaryDataOffset;
+} INCALESCENT_Columnar_Column;
+
+// A column of strings, each stored once, and the index of every row's string.
+typedef struct INCALESCENT_Columnar_Dictionary {
+    const BYTE **entries;
+    DWORD *entryLengths;
+    SIZE_T entryCount;
+    SIZE_T dataSize;
+
+    // An open-addressing table of entry numbers, each stored plus one so that zero marks an empty slot.
+    DWORD *table;
+    SIZE_T tableMask;
+
+    DWORD *indices;
+} INCALESCENT_Columnar_Dictionary;
+
+typedef struct INCALESCENT_Columnar {
+    INCALESCENT_Arena *arena;
+    SIZE_T rowCapacity;
+    SIZE_T rowCount;
+
+    BOOL hasDirectories;
+    INCALESCENT_Columnar_Dictionary directories;
+    INCALESCENT_Columnar_Dictionary files;
+
+    // One column of values and one validity bitmap per field.
+    PCWSTR fieldNames[INCALESCENT_COLUMNAR_MAX_FIELDS];
+    DWORD fieldCount;
+    DOUBLE *values[INCALESCENT_COLUMNAR_MAX_FIELDS];
+    BYTE *validity[INCALESCENT_COLUMNAR_MAX_FIELDS];
+} INCALESCENT_Columnar;
+
+/**
+ * @brief Prepares a table with an index column, an optional directory column, a file column and a
+ *        number column per field.
+ *
+ * @param[out] columnar         The table to initialize.
+ * @param[in] arena             The arena the table is built in.
+ * @param[in] rowCount          The number of rows that will be appended.
+ * @param[in] hasDirectories    Whether the table has a directory column.
+ * @param[in] fieldNames        The names of the field columns. They must outlive the table.
+ * @param[in] fieldCount        The number of fields, at most INCALESCENT_COLUMNAR_MAX_FIELDS.
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Columnar_Create(INCALESCENT_Columnar *columnar, INCALESCENT_Arena *arena, SIZE_T rowCount, BOOL hasDirectories,
+                                    const PCWSTR *fieldNames, DWORD fieldCount);
+
+/**
+ * @brief Appends a row. Its index is the number of rows appended before it.
+ *
+ * @param[in] values    The value of every field. A NaN leaves the row without a value.
+ */
+HRESULT INCALESCENT_Columnar_AppendRow(INCALESCENT_Columnar *columnar, PCWSTR directory, SIZE_T directoryLength,
+                                       PCWSTR file, SIZE_T fileLength, const DOUBLE *values);
+
+/**
+ * @brief Writes the table to a file at its current position.
+ */
+HRESULT INCALESCENT_Columnar_Write(INCALESCENT_Columnar *columnar, HANDLE file);
+
+#endif //INCALESCENT_COLUMNAR_H
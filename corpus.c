@@ -0,0 +1,157 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include <stdio.h>
+#include "corpus.h"
+#include "file.h"
+
+// Formats the temperature field of a file. A mixed corpus takes each format in turn, with a
+// negative decimal in place of the mixed one.
+static INT INCALESCENT_Corpus_FormatTemperature(const INCALESCENT_Corpus_Options *options, SIZE_T file, PSTR line) {
+    ULONGLONG whole = 20 + (file % 180);
+    ULONGLONG hundredths = file % 100;
+    INCALESCENT_Corpus_Values format = options->values;
+    if (format == INCALESCENT_CORPUS_VALUES_MIXED) {
+        format = (INCALESCENT_Corpus_Values) (file % 4);
+    }
+
+    switch (format) {
+        case INCALESCENT_CORPUS_VALUES_DECIMAL:
+            return snprintf(line, INCALESCENT_CORPUS_MAX_LINE_LENGTH, INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING "%llu.%02llu\r\n", whole, hundredths);
+        case INCALESCENT_CORPUS_VALUES_INTEGER:
+            return snprintf(line, INCALESCENT_CORPUS_MAX_LINE_LENGTH, INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING "%llu\r\n", whole);
+        case INCALESCENT_CORPUS_VALUES_EXPONENT:
+            return snprintf(line, INCALESCENT_CORPUS_MAX_LINE_LENGTH, INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING "%.4e\r\n",
+                            (DOUBLE) whole + ((DOUBLE) hundredths / 100.0));
+        default:
+            return snprintf(line, INCALESCENT_CORPUS_MAX_LINE_LENGTH, INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING "-%llu.%02llu\r\n", whole, hundredths);
+    }
+}
+
+// Implementation for INCALESCENT_Corpus_FormatFile
+void INCALESCENT_Corpus_FormatFile(const INCALESCENT_Corpus_Options *options, SIZE_T file, PBYTE text, SIZE_T *length) {
+    SIZE_T used = 0;
+    CHAR line[INCALESCENT_CORPUS_MAX_LINE_LENGTH];
+
+    for (SIZE_T field = 0; field <= options->fieldsBefore || used < options->fileSize; field++) {
+        INT lineLength;
+        if (field < options->fieldsBefore) {
+            lineLength = snprintf(line, sizeof(line), "userField%llu=%llu\r\n", (ULONGLONG) field, (ULONGLONG) ((file * 31) + field));
+        } else if (field == options->fieldsBefore) {
+            lineLength = INCALESCENT_Corpus_FormatTemperature(options, file, line);
+        } else {
+            lineLength = snprintf(line, sizeof(line), "padding%llu=%llu\r\n", (ULONGLONG) field, (ULONGLONG) used);
+        }
+
+        // Only the padding is cut off at the file size.
+        SIZE_T copyLength = (SIZE_T) lineLength;
+        if (field > options->fieldsBefore && copyLength > options->fileSize - used) {
+            copyLength = options->fileSize - used;
+        }
+        CopyMemory(text + used, line, copyLength);
+        used += copyLength;
+    }
+
+    *length = used;
+}
+
+// Implementation for INCALESCENT_Corpus_FileCapacity
+SIZE_T INCALESCENT_Corpus_FileCapacity(const INCALESCENT_Corpus_Options *options) {
+    return options->fileSize + ((options->fieldsBefore + 1) * INCALESCENT_CORPUS_MAX_LINE_LENGTH);
+}
+
+// Implementation for INCALESCENT_Corpus_FormatName
+HRESULT INCALESCENT_Corpus_FormatName(const INCALESCENT_Corpus_Options *options, SIZE_T file, PWSTR name) {
+    switch (options->names) {
+        case INCALESCENT_CORPUS_NAMES_PADDED:
+            return StringCchPrintfW(name, INCALESCENT_CORPUS_MAX_NAME_LENGTH, L"image_%06zu" INCALESCENT_FILE_FILTER_SUFFIX, file + 1);
+        case INCALESCENT_CORPUS_NAMES_RUNS:
+            return StringCchPrintfW(name, INCALESCENT_CORPUS_MAX_NAME_LENGTH, L"run%zu_image%zu" INCALESCENT_FILE_FILTER_SUFFIX,
+                                    (file / INCALESCENT_CORPUS_RUN_LENGTH) + 1, (file % INCALESCENT_CORPUS_RUN_LENGTH) + 1);
+        default:
+            return StringCchPrintfW(name, INCALESCENT_CORPUS_MAX_NAME_LENGTH, L"image_%zu" INCALESCENT_FILE_FILTER_SUFFIX, file + 1);
+    }
+}
+
+// Implementation for INCALESCENT_Corpus_Write
+HRESULT INCALESCENT_Corpus_Write(PCWSTR directory, const INCALESCENT_Corpus_Options *options) {
+    HRESULT result = S_OK;
+    HANDLE heap = GetProcessHeap();
+    PBYTE text = NULL;
+    WCHAR name[INCALESCENT_CORPUS_MAX_NAME_LENGTH];
+    WCHAR path[INCALESCENT_FILE_FILTER_AGGREGATE_SIZE];
+
+    if (options->fileCount == 0 || options->fileCount > INCALESCENT_CORPUS_MAX_FILE_COUNT || options->fileSize > INCALESCENT_CORPUS_MAX_FILE_SIZE ||
+        options->fieldsBefore * INCALESCENT_CORPUS_MAX_LINE_LENGTH > INCALESCENT_CORPUS_MAX_FILE_SIZE ||
+        options->names > INCALESCENT_CORPUS_NAMES_RUNS || options->values > INCALESCENT_CORPUS_VALUES_MIXED) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    if (!CreateDirectoryW(directory, NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    text = HeapAlloc(heap, 0, INCALESCENT_Corpus_FileCapacity(options));
+    if (text == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+
+    for (SIZE_T file = 0; file < options->fileCount; file++) {
+        result = INCALESCENT_Corpus_FormatName(options, file, name);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = StringCchPrintfW(path, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, L"%s\\%s", directory, name);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        SIZE_T length;
+        INCALESCENT_Corpus_FormatFile(options, file, text, &length);
+
+        HANDLE handle = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (handle == INVALID_HANDLE_VALUE) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        DWORD written;
+        if (!WriteFile(handle, text, (DWORD) length, &written, NULL)) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+        }
+        CloseHandle(handle);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    cleanup:
+    if (text != NULL) {
+        HeapFree(heap, 0, text);
+    }
+    return result;
+}
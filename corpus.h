@@ -0,0 +1,115 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_CORPUS_H
+#define INCALESCENT_CORPUS_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef unsigned char BYTE;
+typedef BYTE* PBYTE;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+typedef const WCHAR* PCWSTR;
+typedef unsigned __int64 SIZE_T;
+
+#define INCALESCENT_CORPUS_MAX_FILE_COUNT (1024 * 1024)
+#define INCALESCENT_CORPUS_MAX_FILE_SIZE (1024 * 1024)
+#define INCALESCENT_CORPUS_MAX_LINE_LENGTH 64
+#define INCALESCENT_CORPUS_MAX_NAME_LENGTH 64
+
+// The files of a run in the runs name pattern.
+#define INCALESCENT_CORPUS_RUN_LENGTH 1000
+
+typedef enum INCALESCENT_Corpus_Names {
+    // image_1, image_2, ... image_10, which only come out in order with a natural sort.
+    INCALESCENT_CORPUS_NAMES_SEQUENTIAL = 0,
+
+    // image_000001, image_000002, ..., which come out in order either way.
+    INCALESCENT_CORPUS_NAMES_PADDED = 1,
+
+    // run1_image1 to run1_image1000, then run2_image1, with a number to compare in two places.
+    INCALESCENT_CORPUS_NAMES_RUNS = 2,
+} INCALESCENT_Corpus_Names;
+
+typedef enum INCALESCENT_Corpus_Values {
+    // 23.45
+    INCALESCENT_CORPUS_VALUES_DECIMAL = 0,
+
+    // 23
+    INCALESCENT_CORPUS_VALUES_INTEGER = 1,
+
+    // 2.3450e+01
+    INCALESCENT_CORPUS_VALUES_EXPONENT = 2,
+
+    // Each of the above and a negative decimal in turn.
+    INCALESCENT_CORPUS_VALUES_MIXED = 3,
+} INCALESCENT_Corpus_Values;
+
+// What a synthetic corpus of data files looks like. The same options always give the same corpus.
+typedef struct INCALESCENT_Corpus_Options {
+    SIZE_T fileCount;
+
+    // The size of every file in bytes. Files are padded with further fields up to this size, but
+    // never cut off before the temperature field.
+    SIZE_T fileSize;
+
+    // The number of fields in front of the temperature field.
+    SIZE_T fieldsBefore;
+
+    INCALESCENT_Corpus_Names names;
+    INCALESCENT_Corpus_Values values;
+} INCALESCENT_Corpus_Options;
+
+/**
+ * @brief Formats the contents of one data file of a corpus.
+ *
+ * The field lines mimic what the acquisition software writes: fieldsBefore other fields, the
+ * temperature field, then padding fields up to the file size.
+ *
+ * @param[in] options   The corpus.
+ * @param[in] file      The index of the file in the corpus.
+ * @param[out] text     Receives the file's contents. Must hold at least
+ *                      INCALESCENT_Corpus_FileCapacity bytes.
+ * @param[out] length   Receives the length of the contents in bytes.
+ */
+void INCALESCENT_Corpus_FormatFile(const INCALESCENT_Corpus_Options *options, SIZE_T file, PBYTE text, SIZE_T *length);
+
+// The most bytes a file of the corpus takes.
+SIZE_T INCALESCENT_Corpus_FileCapacity(const INCALESCENT_Corpus_Options *options);
+
+// Formats the name of one data file of a corpus, including its suffix, into a buffer of
+// INCALESCENT_CORPUS_MAX_NAME_LENGTH characters.
+HRESULT INCALESCENT_Corpus_FormatName(const INCALESCENT_Corpus_Options *options, SIZE_T file, PWSTR name);
+
+/**
+ * @brief Writes a corpus of data files into a directory, which is created if it doesn't exist.
+ *
+ * Files already in the directory are replaced.
+ *
+ * @return The result of writing the files (S_OK if successful), or E_INVALIDARG if the options
+ *         are out of range.
+ */
+HRESULT INCALESCENT_Corpus_Write(PCWSTR directory, const INCALESCENT_Corpus_Options *options);
+
+#endif //INCALESCENT_CORPUS_H
@@ -0,0 +1,46 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_CRC_H
+#define INCALESCENT_CRC_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef unsigned char BYTE;
+typedef unsigned __int64 SIZE_T;
+
+// The reversed polynomial of the CRC-32 that gzip and zip use (ISO 3309).
+#define INCALESCENT_CRC_POLYNOMIAL 0xEDB88320
+
+/**
+ * @brief Continues the CRC-32 of a stream of data over its next piece.
+ *
+ * @param[in] crc       The CRC-32 of the data so far, or 0 at the start.
+ * @param[in] data      The next piece of the data.
+ * @param[in] size      The size of the piece in bytes.
+ *
+ * @return The CRC-32 of the data including the piece.
+ */
+DWORD INCALESCENT_Crc_Update(DWORD crc, const BYTE *data, SIZE_T size);
+
+#endif //INCALESCENT_CRC_H
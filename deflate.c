@@ -0,0 +1,573 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <intrin.h>
+#include "deflate.h"
+
+static const WORD INCALESCENT_Deflate_LengthBase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const BYTE INCALESCENT_Deflate_LengthExtra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const WORD INCALESCENT_Deflate_DistanceBase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+        16385, 24577
+};
+static const BYTE INCALESCENT_Deflate_DistanceExtra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// The order the lengths of the code length code are stored in.
+static const BYTE INCALESCENT_Deflate_CodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// A Huffman code fitted to the symbols of a block. The codes are stored reversed, as they are
+// written least significant bit first.
+typedef struct INCALESCENT_Deflate_Code {
+    WORD codes[INCALESCENT_DEFLATE_LITERALS];
+    BYTE lengths[INCALESCENT_DEFLATE_LITERALS];
+} INCALESCENT_Deflate_Code;
+
+// Implementation for INCALESCENT_Deflate_Create
+HRESULT INCALESCENT_Deflate_Create(INCALESCENT_Deflate *deflate, SIZE_T maxInput, INCALESCENT_Arena *arena, INCALESCENT_Deflate_Sink sink,
+                                   PVOID context) {
+    HRESULT result = S_OK;
+
+    ZeroMemory(deflate, sizeof(INCALESCENT_Deflate));
+    deflate->maxInput = maxInput;
+    deflate->sink = sink;
+    deflate->context = context;
+
+    result = INCALESCENT_Arena_Allocate(arena, (2 * INCALESCENT_DEFLATE_WINDOW_SIZE) + maxInput, INCALESCENT_ARENA_DEFAULT_ALIGNMENT,
+                                        (PVOID *) &deflate->window);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(LONG) * INCALESCENT_DEFLATE_HASH_SIZE, sizeof(LONG), (PVOID *) &deflate->head);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(LONG) * INCALESCENT_DEFLATE_WINDOW_SIZE, sizeof(LONG), (PVOID *) &deflate->previous);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(WORD) * INCALESCENT_DEFLATE_MAX_SYMBOLS, sizeof(WORD), (PVOID *) &deflate->lengths);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(WORD) * INCALESCENT_DEFLATE_MAX_SYMBOLS, sizeof(WORD), (PVOID *) &deflate->distances);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, INCALESCENT_DEFLATE_OUTPUT_SIZE, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &deflate->output);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (DWORD index = 0; index < INCALESCENT_DEFLATE_HASH_SIZE; index++) {
+        deflate->head[index] = -1;
+    }
+
+    for (DWORD code = 0; code < ARRAYSIZE(INCALESCENT_Deflate_LengthBase); code++) {
+        DWORD last = code + 1 < ARRAYSIZE(INCALESCENT_Deflate_LengthBase) ? INCALESCENT_Deflate_LengthBase[code + 1] : INCALESCENT_DEFLATE_MAX_MATCH + 1;
+        for (DWORD length = INCALESCENT_Deflate_LengthBase[code]; length < last; length++) {
+            deflate->lengthCodes[length] = (BYTE) code;
+        }
+    }
+    // A match of the longest length has a code of its own, even though the code before it could
+    // also express it.
+    deflate->lengthCodes[INCALESCENT_DEFLATE_MAX_MATCH] = ARRAYSIZE(INCALESCENT_Deflate_LengthBase) - 1;
+
+    for (DWORD code = 0; code < ARRAYSIZE(INCALESCENT_Deflate_DistanceBase); code++) {
+        DWORD first = INCALESCENT_Deflate_DistanceBase[code] - 1;
+        DWORD last = first + (1 << INCALESCENT_Deflate_DistanceExtra[code]);
+        for (DWORD distance = first; distance < last; distance++) {
+            if (distance < 256) {
+                deflate->distanceCodes[distance] = (BYTE) code;
+            } else {
+                deflate->distanceCodes[256 + (distance >> 7)] = (BYTE) code;
+            }
+        }
+    }
+
+    cleanup:
+    return result;
+}
+
+static DWORD INCALESCENT_Deflate_DistanceCode(const INCALESCENT_Deflate *deflate, DWORD distance) {
+    distance--;
+    return distance < 256 ? deflate->distanceCodes[distance] : deflate->distanceCodes[256 + (distance >> 7)];
+}
+
+// Appends count bits, at most 16, least significant first. Whole words go to the output as soon
+// as they are complete.
+static void INCALESCENT_Deflate_Put(INCALESCENT_Deflate *deflate, DWORD value, DWORD count) {
+    deflate->bits |= (ULONGLONG) value << deflate->bitCount;
+    deflate->bitCount += count;
+    if (deflate->bitCount >= 32) {
+        DWORD word = (DWORD) deflate->bits;
+        CopyMemory(deflate->output + deflate->outputUsed, &word, sizeof(DWORD));
+        deflate->outputUsed += sizeof(DWORD);
+        deflate->bits >>= 32;
+        deflate->bitCount -= 32;
+    }
+}
+
+// Hands the output that is complete on to the sink.
+static HRESULT INCALESCENT_Deflate_Drain(INCALESCENT_Deflate *deflate) {
+    HRESULT result = S_OK;
+    if (deflate->outputUsed != 0) {
+        result = deflate->sink(deflate->context, deflate->output, deflate->outputUsed);
+        deflate->outputUsed = 0;
+    }
+    return result;
+}
+
+// Fits the lengths of a code to the frequencies of its symbols, none longer than maxBits. A Huffman
+// code is built from the symbols sorted by frequency, then codes that are too long are shortened
+// by lengthening the longest codes that aren't, which keeps the code complete. Any code has at
+// least 2 symbols, so that it is complete even if only one of them is used.
+static void INCALESCENT_Deflate_FitLengths(const DWORD *frequencies, DWORD symbolCount, DWORD maxBits, BYTE *lengths) {
+    DWORD weights[2 * INCALESCENT_DEFLATE_LITERALS];
+    WORD parents[2 * INCALESCENT_DEFLATE_LITERALS];
+    BYTE depths[2 * INCALESCENT_DEFLATE_LITERALS];
+    WORD sorted[INCALESCENT_DEFLATE_LITERALS];
+    DWORD lengthCounts[2 * INCALESCENT_DEFLATE_LITERALS] = {0};
+    DWORD usedCount = 0;
+    DWORD missing = 2;
+
+    ZeroMemory(lengths, symbolCount);
+    for (DWORD symbol = 0; symbol < symbolCount && missing != 0; symbol++) {
+        missing -= frequencies[symbol] != 0 ? 1 : 0;
+    }
+    for (DWORD symbol = 0; symbol < symbolCount; symbol++) {
+        if (frequencies[symbol] == 0) {
+            if (missing == 0) {
+                continue;
+            }
+            missing--;
+        }
+
+        // Insertion sort by frequency, which is plenty for a few hundred symbols.
+        DWORD position = usedCount++;
+        while (position > 0 && frequencies[sorted[position - 1]] > frequencies[symbol]) {
+            sorted[position] = sorted[position - 1];
+            position--;
+        }
+        sorted[position] = (WORD) symbol;
+    }
+
+    // The leaves are in order of weight and the internal nodes are created in order of weight, so
+    // the two lightest nodes are always at the front of one or the other.
+    for (DWORD leaf = 0; leaf < usedCount; leaf++) {
+        weights[leaf] = frequencies[sorted[leaf]];
+    }
+    DWORD nextLeaf = 0;
+    DWORD nextNode = usedCount;
+    for (DWORD node = usedCount; node < (2 * usedCount) - 1; node++) {
+        weights[node] = 0;
+        for (DWORD child = 0; child < 2; child++) {
+            DWORD lightest;
+            if (nextLeaf < usedCount && (nextNode >= node || weights[nextLeaf] <= weights[nextNode])) {
+                lightest = nextLeaf++;
+            } else {
+                lightest = nextNode++;
+            }
+            weights[node] += weights[lightest];
+            parents[lightest] = (WORD) node;
+        }
+    }
+    DWORD root = (2 * usedCount) - 2;
+    depths[root] = 0;
+    for (DWORD node = root; node > 0; node--) {
+        depths[node - 1] = depths[parents[node - 1]] + 1;
+    }
+    for (DWORD leaf = 0; leaf < usedCount; leaf++) {
+        lengthCounts[depths[leaf]]++;
+    }
+
+    // Fold the codes that are too long into the longest allowed length, then take codes of that
+    // length away and split shorter codes until the code is complete again.
+    DWORD longest = 0;
+    for (DWORD leaf = 0; leaf < usedCount; leaf++) {
+        longest = depths[leaf] > longest ? depths[leaf] : longest;
+    }
+    if (longest > maxBits) {
+        for (DWORD length = maxBits + 1; length <= longest; length++) {
+            lengthCounts[maxBits] += lengthCounts[length];
+            lengthCounts[length] = 0;
+        }
+        ULONGLONG total = 0;
+        for (DWORD length = 1; length <= maxBits; length++) {
+            total += (ULONGLONG) lengthCounts[length] << (maxBits - length);
+        }
+        while (total != 1ULL << maxBits) {
+            lengthCounts[maxBits]--;
+            for (DWORD length = maxBits - 1; length > 0; length--) {
+                if (lengthCounts[length] != 0) {
+                    lengthCounts[length]--;
+                    lengthCounts[length + 1] += 2;
+                    break;
+                }
+            }
+            total--;
+        }
+    }
+
+    // The least frequent symbols get the longest codes.
+    DWORD leaf = 0;
+    for (DWORD length = longest > maxBits ? maxBits : longest; length > 0; length--) {
+        for (DWORD counted = 0; counted < lengthCounts[length]; counted++) {
+            lengths[sorted[leaf++]] = (BYTE) length;
+        }
+    }
+}
+
+// Assigns the canonical codes of the given lengths, reversed.
+static void INCALESCENT_Deflate_AssignCodes(INCALESCENT_Deflate_Code *code, DWORD symbolCount) {
+    WORD counts[INCALESCENT_DEFLATE_MAX_BITS + 1] = {0};
+    WORD next[INCALESCENT_DEFLATE_MAX_BITS + 1];
+
+    for (DWORD symbol = 0; symbol < symbolCount; symbol++) {
+        counts[code->lengths[symbol]]++;
+    }
+    counts[0] = 0;
+    DWORD value = 0;
+    for (DWORD length = 1; length <= INCALESCENT_DEFLATE_MAX_BITS; length++) {
+        value = (value + counts[length - 1]) << 1;
+        next[length] = (WORD) value;
+    }
+    for (DWORD symbol = 0; symbol < symbolCount; symbol++) {
+        DWORD length = code->lengths[symbol];
+        if (length == 0) {
+            continue;
+        }
+        DWORD assigned = next[length]++;
+        DWORD reversed = 0;
+        for (DWORD bit = 0; bit < length; bit++) {
+            reversed |= ((assigned >> bit) & 1) << (length - 1 - bit);
+        }
+        code->codes[symbol] = (WORD) reversed;
+    }
+}
+
+// Writes the symbols collected so far as a block with codes of its own, preceded by the lengths of
+// those codes, which are run-length encoded with a code of their own in turn.
+static HRESULT INCALESCENT_Deflate_WriteBlock(INCALESCENT_Deflate *deflate, BOOL final) {
+    HRESULT result = S_OK;
+    DWORD literalFrequencies[INCALESCENT_DEFLATE_LITERALS] = {0};
+    DWORD distanceFrequencies[INCALESCENT_DEFLATE_DISTANCES] = {0};
+    DWORD codeLengthFrequencies[INCALESCENT_DEFLATE_CODE_LENGTHS] = {0};
+    INCALESCENT_Deflate_Code literals;
+    INCALESCENT_Deflate_Code distances;
+    INCALESCENT_Deflate_Code codeLengths;
+    BYTE allLengths[INCALESCENT_DEFLATE_LITERALS + INCALESCENT_DEFLATE_DISTANCES];
+    BYTE runs[INCALESCENT_DEFLATE_LITERALS + INCALESCENT_DEFLATE_DISTANCES];
+    BYTE runExtras[INCALESCENT_DEFLATE_LITERALS + INCALESCENT_DEFLATE_DISTANCES];
+    DWORD runCount = 0;
+
+    if (deflate->outputUsed + INCALESCENT_DEFLATE_MAX_BLOCK_BYTES > INCALESCENT_DEFLATE_OUTPUT_SIZE) {
+        result = INCALESCENT_Deflate_Drain(deflate);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    // An empty block takes the fixed codes, where the end of the block is 7 zero bits.
+    if (deflate->symbolCount == 0) {
+        INCALESCENT_Deflate_Put(deflate, final ? 1 : 0, 1);
+        INCALESCENT_Deflate_Put(deflate, 1, 2);
+        INCALESCENT_Deflate_Put(deflate, 0, 7);
+        goto cleanup;
+    }
+
+    for (DWORD symbol = 0; symbol < deflate->symbolCount; symbol++) {
+        if (deflate->distances[symbol] == 0) {
+            literalFrequencies[deflate->lengths[symbol]]++;
+        } else {
+            literalFrequencies[257 + deflate->lengthCodes[deflate->lengths[symbol]]]++;
+            distanceFrequencies[INCALESCENT_Deflate_DistanceCode(deflate, deflate->distances[symbol])]++;
+        }
+    }
+    literalFrequencies[INCALESCENT_DEFLATE_END_OF_BLOCK] = 1;
+    INCALESCENT_Deflate_FitLengths(literalFrequencies, INCALESCENT_DEFLATE_LITERALS, INCALESCENT_DEFLATE_MAX_BITS, literals.lengths);
+    INCALESCENT_Deflate_FitLengths(distanceFrequencies, INCALESCENT_DEFLATE_DISTANCES, INCALESCENT_DEFLATE_MAX_BITS, distances.lengths);
+    INCALESCENT_Deflate_AssignCodes(&literals, INCALESCENT_DEFLATE_LITERALS);
+    INCALESCENT_Deflate_AssignCodes(&distances, INCALESCENT_DEFLATE_DISTANCES);
+
+    DWORD literalCount = INCALESCENT_DEFLATE_LITERALS;
+    while (literalCount > 257 && literals.lengths[literalCount - 1] == 0) {
+        literalCount--;
+    }
+    DWORD distanceCount = INCALESCENT_DEFLATE_DISTANCES;
+    while (distanceCount > 1 && distances.lengths[distanceCount - 1] == 0) {
+        distanceCount--;
+    }
+    CopyMemory(allLengths, literals.lengths, literalCount);
+    CopyMemory(allLengths + literalCount, distances.lengths, distanceCount);
+
+    // Runs of zeros take code 17 or 18, runs of another length code 16 after the length itself.
+    DWORD lengthCount = literalCount + distanceCount;
+    for (DWORD index = 0; index < lengthCount;) {
+        BYTE length = allLengths[index];
+        DWORD run = 1;
+        while (index + run < lengthCount && allLengths[index + run] == length) {
+            run++;
+        }
+        if (length == 0 && run >= 11) {
+            run = run > 138 ? 138 : run;
+            runs[runCount] = 18;
+            runExtras[runCount++] = (BYTE) (run - 11);
+        } else if (length == 0 && run >= 3) {
+            runs[runCount] = 17;
+            runExtras[runCount++] = (BYTE) (run - 3);
+        } else if (length != 0 && run >= 4) {
+            run = run > 7 ? 7 : run;
+            runs[runCount] = length;
+            runExtras[runCount++] = 0;
+            runs[runCount] = 16;
+            runExtras[runCount++] = (BYTE) (run - 4);
+        } else {
+            run = 1;
+            runs[runCount] = length;
+            runExtras[runCount++] = 0;
+        }
+        index += run;
+    }
+    for (DWORD run = 0; run < runCount; run++) {
+        codeLengthFrequencies[runs[run]]++;
+    }
+    INCALESCENT_Deflate_FitLengths(codeLengthFrequencies, INCALESCENT_DEFLATE_CODE_LENGTHS, INCALESCENT_DEFLATE_MAX_CODE_LENGTH_BITS,
+                                   codeLengths.lengths);
+    INCALESCENT_Deflate_AssignCodes(&codeLengths, INCALESCENT_DEFLATE_CODE_LENGTHS);
+    DWORD codeLengthCount = INCALESCENT_DEFLATE_CODE_LENGTHS;
+    while (codeLengthCount > 4 && codeLengths.lengths[INCALESCENT_Deflate_CodeLengthOrder[codeLengthCount - 1]] == 0) {
+        codeLengthCount--;
+    }
+
+    INCALESCENT_Deflate_Put(deflate, final ? 1 : 0, 1);
+    INCALESCENT_Deflate_Put(deflate, 2, 2);
+    INCALESCENT_Deflate_Put(deflate, literalCount - 257, 5);
+    INCALESCENT_Deflate_Put(deflate, distanceCount - 1, 5);
+    INCALESCENT_Deflate_Put(deflate, codeLengthCount - 4, 4);
+    for (DWORD index = 0; index < codeLengthCount; index++) {
+        INCALESCENT_Deflate_Put(deflate, codeLengths.lengths[INCALESCENT_Deflate_CodeLengthOrder[index]], 3);
+    }
+    for (DWORD run = 0; run < runCount; run++) {
+        INCALESCENT_Deflate_Put(deflate, codeLengths.codes[runs[run]], codeLengths.lengths[runs[run]]);
+        if (runs[run] == 16) {
+            INCALESCENT_Deflate_Put(deflate, runExtras[run], 2);
+        } else if (runs[run] == 17) {
+            INCALESCENT_Deflate_Put(deflate, runExtras[run], 3);
+        } else if (runs[run] == 18) {
+            INCALESCENT_Deflate_Put(deflate, runExtras[run], 7);
+        }
+    }
+
+    for (DWORD symbol = 0; symbol < deflate->symbolCount; symbol++) {
+        DWORD length = deflate->lengths[symbol];
+        DWORD distance = deflate->distances[symbol];
+        if (distance == 0) {
+            INCALESCENT_Deflate_Put(deflate, literals.codes[length], literals.lengths[length]);
+            continue;
+        }
+
+        DWORD lengthCode = deflate->lengthCodes[length];
+        INCALESCENT_Deflate_Put(deflate, literals.codes[257 + lengthCode], literals.lengths[257 + lengthCode]);
+        INCALESCENT_Deflate_Put(deflate, length - INCALESCENT_Deflate_LengthBase[lengthCode], INCALESCENT_Deflate_LengthExtra[lengthCode]);
+        DWORD distanceCode = INCALESCENT_Deflate_DistanceCode(deflate, distance);
+        INCALESCENT_Deflate_Put(deflate, distances.codes[distanceCode], distances.lengths[distanceCode]);
+        INCALESCENT_Deflate_Put(deflate, distance - INCALESCENT_Deflate_DistanceBase[distanceCode], INCALESCENT_Deflate_DistanceExtra[distanceCode]);
+    }
+    INCALESCENT_Deflate_Put(deflate, literals.codes[INCALESCENT_DEFLATE_END_OF_BLOCK], literals.lengths[INCALESCENT_DEFLATE_END_OF_BLOCK]);
+
+    cleanup:
+    deflate->symbolCount = 0;
+    return result;
+}
+
+// Links a position into the chain of its hash and returns the previous position with that hash.
+static LONG INCALESCENT_Deflate_Insert(INCALESCENT_Deflate *deflate, LONG position) {
+    const BYTE *bytes = deflate->window + position;
+    DWORD hash = ((bytes[0] | ((DWORD) bytes[1] << 8) | ((DWORD) bytes[2] << 16)) * 2654435761U) >> (32 - INCALESCENT_DEFLATE_HASH_BITS);
+    LONG candidate = deflate->head[hash];
+    deflate->previous[position & (INCALESCENT_DEFLATE_WINDOW_SIZE - 1)] = candidate;
+    deflate->head[hash] = position;
+    return candidate;
+}
+
+// Finds the longest match for a position among the earlier positions in its chain, comparing 8
+// bytes at a time.
+static DWORD INCALESCENT_Deflate_Match(const INCALESCENT_Deflate *deflate, LONG position, LONG candidate, DWORD limit, DWORD *distance) {
+    const BYTE *scan = deflate->window + position;
+    DWORD best = INCALESCENT_DEFLATE_MIN_MATCH - 1;
+
+    for (DWORD chain = 0; chain < INCALESCENT_DEFLATE_MAX_CHAIN && candidate >= 0 && position - candidate < INCALESCENT_DEFLATE_WINDOW_SIZE;
+         chain++) {
+        const BYTE *match = deflate->window + candidate;
+        if (match[best] == scan[best] && match[0] == scan[0] && match[1] == scan[1]) {
+            DWORD length = 0;
+            while (length + sizeof(ULONGLONG) <= limit) {
+                ULONGLONG first;
+                ULONGLONG second;
+                CopyMemory(&first, match + length, sizeof(ULONGLONG));
+                CopyMemory(&second, scan + length, sizeof(ULONGLONG));
+                if (first != second) {
+                    DWORD bit;
+                    _BitScanForward64(&bit, first ^ second);
+                    length += bit / 8;
+                    break;
+                }
+                length += sizeof(ULONGLONG);
+            }
+            if (length + sizeof(ULONGLONG) > limit) {
+                while (length < limit && match[length] == scan[length]) {
+                    length++;
+                }
+            }
+
+            if (length > best) {
+                best = length;
+                *distance = position - candidate;
+                if (length >= limit || length >= INCALESCENT_DEFLATE_NICE_MATCH) {
+                    break;
+                }
+            }
+        }
+        candidate = deflate->previous[candidate & (INCALESCENT_DEFLATE_WINDOW_SIZE - 1)];
+    }
+    return best >= INCALESCENT_DEFLATE_MIN_MATCH ? best : 0;
+}
+
+// Adds a symbol to the block, writing the block once it is full.
+static HRESULT INCALESCENT_Deflate_Emit(INCALESCENT_Deflate *deflate, DWORD length, DWORD distance) {
+    deflate->lengths[deflate->symbolCount] = (WORD) length;
+    deflate->distances[deflate->symbolCount] = (WORD) distance;
+    deflate->symbolCount++;
+    if (deflate->symbolCount == INCALESCENT_DEFLATE_MAX_SYMBOLS) {
+        return INCALESCENT_Deflate_WriteBlock(deflate, FALSE);
+    }
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Deflate_Compress
+HRESULT INCALESCENT_Deflate_Compress(INCALESCENT_Deflate *deflate, const BYTE *data, SIZE_T size, BOOL final) {
+    HRESULT result = S_OK;
+
+    CopyMemory(deflate->window + deflate->windowUsed, data, size);
+    LONG position = (LONG) deflate->windowUsed;
+    LONG end = (LONG) (deflate->windowUsed + size);
+    deflate->windowUsed += size;
+
+    // A match is only taken once the match at the next position turns out to be no longer. The
+    // pending symbol is the one at the position before.
+    BOOL pending = FALSE;
+    DWORD pendingLength = 0;
+    DWORD pendingDistance = 0;
+    while (position < end) {
+        DWORD length = 0;
+        DWORD distance = 0;
+        DWORD limit = (DWORD) (end - position) < INCALESCENT_DEFLATE_MAX_MATCH ? (DWORD) (end - position) : INCALESCENT_DEFLATE_MAX_MATCH;
+        if (limit >= INCALESCENT_DEFLATE_MIN_MATCH) {
+            LONG candidate = INCALESCENT_Deflate_Insert(deflate, position);
+            if (pendingLength < INCALESCENT_DEFLATE_NICE_MATCH) {
+                length = INCALESCENT_Deflate_Match(deflate, position, candidate, limit, &distance);
+            }
+        }
+
+        if (pending && pendingLength != 0 && length <= pendingLength) {
+            result = INCALESCENT_Deflate_Emit(deflate, pendingLength, pendingDistance);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+            LONG matchEnd = position - 1 + (LONG) pendingLength;
+            for (position++; position < matchEnd; position++) {
+                if (end - position >= INCALESCENT_DEFLATE_MIN_MATCH) {
+                    INCALESCENT_Deflate_Insert(deflate, position);
+                }
+            }
+            pending = FALSE;
+            pendingLength = 0;
+            continue;
+        }
+
+        if (pending) {
+            result = INCALESCENT_Deflate_Emit(deflate, deflate->window[position - 1], 0);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+        pending = TRUE;
+        pendingLength = length;
+        pendingDistance = distance;
+        position++;
+    }
+    if (pending) {
+        if (pendingLength != 0) {
+            result = INCALESCENT_Deflate_Emit(deflate, pendingLength, pendingDistance);
+        } else {
+            result = INCALESCENT_Deflate_Emit(deflate, deflate->window[position - 1], 0);
+        }
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    // Every piece ends a block, so no symbol has to wait for the next piece. The last one also
+    // pads its last byte.
+    if (deflate->symbolCount != 0 || final) {
+        result = INCALESCENT_Deflate_WriteBlock(deflate, final);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    if (final) {
+        while (deflate->bitCount != 0) {
+            deflate->output[deflate->outputUsed++] = (BYTE) deflate->bits;
+            deflate->bits >>= 8;
+            deflate->bitCount = deflate->bitCount > 8 ? deflate->bitCount - 8 : 0;
+        }
+    }
+    result = INCALESCENT_Deflate_Drain(deflate);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // Keep at least the last window for the matches of the next piece, moving the positions along
+    // with it. Moving by whole windows keeps every position in the same slot of the chains.
+    if (deflate->windowUsed > 2 * INCALESCENT_DEFLATE_WINDOW_SIZE) {
+        LONG shift = (LONG) ((deflate->windowUsed - INCALESCENT_DEFLATE_WINDOW_SIZE) & ~((SIZE_T) INCALESCENT_DEFLATE_WINDOW_SIZE - 1));
+        deflate->windowUsed -= shift;
+        MoveMemory(deflate->window, deflate->window + shift, deflate->windowUsed);
+        for (DWORD index = 0; index < INCALESCENT_DEFLATE_HASH_SIZE; index++) {
+            deflate->head[index] = deflate->head[index] >= shift ? deflate->head[index] - shift : -1;
+        }
+        for (DWORD index = 0; index < INCALESCENT_DEFLATE_WINDOW_SIZE; index++) {
+            deflate->previous[index] = deflate->previous[index] >= shift ? deflate->previous[index] - shift : -1;
+        }
+    }
+
+    cleanup:
+    return result;
+}
@@ -0,0 +1,131 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_DEFLATE_H
+#define INCALESCENT_DEFLATE_H
+#include "arena.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef int BOOL;
+typedef void* PVOID;
+typedef unsigned short WORD;
+typedef unsigned char BYTE;
+typedef unsigned char* PBYTE;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+// The farthest back a match can reach, and the shortest and longest match.
+#define INCALESCENT_DEFLATE_WINDOW_SIZE (32 * 1024)
+#define INCALESCENT_DEFLATE_MIN_MATCH 3
+#define INCALESCENT_DEFLATE_MAX_MATCH 258
+
+// The positions of the last occurrences of every hash of 3 bytes.
+#define INCALESCENT_DEFLATE_HASH_BITS 15
+#define INCALESCENT_DEFLATE_HASH_SIZE (1 << INCALESCENT_DEFLATE_HASH_BITS)
+
+// How many earlier occurrences are tried for every match, and a match long enough to stop looking
+// for a longer one right away, and to not look for a longer one at the next position either.
+#define INCALESCENT_DEFLATE_MAX_CHAIN 32
+#define INCALESCENT_DEFLATE_NICE_MATCH 128
+
+// The symbols of a block are collected before the block is written, so its codes can be fitted to
+// them. A symbol takes at most 48 bits, so the output buffer always has room for a whole block.
+#define INCALESCENT_DEFLATE_MAX_SYMBOLS (32 * 1024)
+#define INCALESCENT_DEFLATE_MAX_BLOCK_BYTES ((INCALESCENT_DEFLATE_MAX_SYMBOLS * 6) + 1024)
+#define INCALESCENT_DEFLATE_OUTPUT_SIZE (4 * INCALESCENT_DEFLATE_MAX_BLOCK_BYTES)
+
+#define INCALESCENT_DEFLATE_MAX_BITS 15
+#define INCALESCENT_DEFLATE_MAX_CODE_LENGTH_BITS 7
+#define INCALESCENT_DEFLATE_LITERALS 286
+#define INCALESCENT_DEFLATE_DISTANCES 30
+#define INCALESCENT_DEFLATE_CODE_LENGTHS 19
+#define INCALESCENT_DEFLATE_END_OF_BLOCK 256
+
+/**
+ * @brief Receives a piece of the compressed data.
+ *
+ * @return S_OK if successful, or a failure to abort.
+ */
+typedef HRESULT (*INCALESCENT_Deflate_Sink)(PVOID context, const BYTE *data, SIZE_T size);
+
+/**
+ * @brief An encoder of raw deflate data (RFC 1951).
+ *
+ * Matches are found through chains of earlier positions with the same hash, taking a match at the
+ * next position instead when it is longer, and every block gets Huffman codes of its own. Input is
+ * taken a piece at a time, and matches reach back into the previous pieces.
+ */
+typedef struct INCALESCENT_Deflate {
+    // At least the last window of the previous pieces, followed by the current piece.
+    PBYTE window;
+    SIZE_T windowUsed;
+    SIZE_T maxInput;
+    LONG *head;
+    LONG *previous;
+
+    // The symbols of the current block. A literal has a distance of zero.
+    WORD *lengths;
+    WORD *distances;
+    DWORD symbolCount;
+
+    // The codes of every match length and of the smaller distances, and of the larger distances
+    // divided by 128.
+    BYTE lengthCodes[INCALESCENT_DEFLATE_MAX_MATCH + 1];
+    BYTE distanceCodes[512];
+
+    PBYTE output;
+    SIZE_T outputUsed;
+    ULONGLONG bits;
+    DWORD bitCount;
+    INCALESCENT_Deflate_Sink sink;
+    PVOID context;
+} INCALESCENT_Deflate;
+
+/**
+ * @brief Initializes an encoder.
+ *
+ * @param[out] deflate  The encoder to initialize.
+ * @param[in] maxInput  The most bytes a single piece of input can have.
+ * @param[in] arena     The arena the window and buffers are allocated from.
+ * @param[in] sink      Receives the compressed data.
+ * @param[in] context   Passed on to the sink.
+ *
+ * @return The result of the initialization (S_OK if successful).
+ */
+HRESULT INCALESCENT_Deflate_Create(INCALESCENT_Deflate *deflate, SIZE_T maxInput, INCALESCENT_Arena *arena, INCALESCENT_Deflate_Sink sink,
+                                   PVOID context);
+
+/**
+ * @brief Compresses the next piece of input, handing on all the compressed data that is complete.
+ *
+ * @param[in,out] deflate   The encoder.
+ * @param[in] data          The input, which may be empty.
+ * @param[in] size          The number of bytes, at most maxInput.
+ * @param[in] final         Whether this is the last piece, after which the data is complete.
+ *
+ * @return S_OK if successful, or the failure of the sink.
+ */
+HRESULT INCALESCENT_Deflate_Compress(INCALESCENT_Deflate *deflate, const BYTE *data, SIZE_T size, BOOL final);
+
+#endif //INCALESCENT_DEFLATE_H
@@ -23,9 +23,9 @@
  */
 #ifndef INCALESCENT_DIALOG_H
 #define INCALESCENT_DIALOG_H
+#include "platform.h"
 
 // Forward declarations from <windows.h>
-typedef long HRESULT;
 typedef unsigned short WCHAR;
 
 #define INCALESCENT_DIALOG_FILE_MAX_PATH 260
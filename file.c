@@ -23,20 +23,173 @@
  */
 #include <windows.h>
 #include <strsafe.h>
+#include <math.h>
 #include "file.h"
 #include "log.h"
+#include "pool.h"
+#include "writer.h"
+#include "io.h"
+#include "match.h"
+#include "number.h"
+#include "tiff.h"
+#include "archive.h"
+#include "table.h"
+#include "sorted.h"
+#include "tree.h"
+#include "bounded.h"
+#include "archived.h"
+#include "perf.h"
 #include "generated_error.h"
 
-#define CLAMP_POSITIVE(value, maximumValue) ((value) > (maximumValue) ? (maximumValue) : (value))
+// Implementation for INCALESCENT_File_ExtractFields
+HRESULT INCALESCENT_File_ExtractFields(const INCALESCENT_Match *match, const BYTE *data, SIZE_T size, INCALESCENT_File_Value *values,
+                                      DOUBLE *numbers) {
+    HRESULT result = S_OK;
+    INCALESCENT_File_Extraction extraction;
+    BOOL done = FALSE;
+
+    // The buffer is all there is to search, but it may not be the whole file, so a value that runs
+    // into its end may have been cut off.
+    INCALESCENT_File_BeginExtraction(match, &extraction, 0);
+    result = INCALESCENT_File_FeedExtraction(match, &extraction, data, size, &done);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_File_FinishExtraction(match, &extraction, FALSE, values, numbers);
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_File_BeginExtraction
+void INCALESCENT_File_BeginExtraction(const INCALESCENT_Match *match, INCALESCENT_File_Extraction *extraction, ULONGLONG origin) {
+    INCALESCENT_Match_Begin(match, &extraction->stream);
+    extraction->offset = origin;
+    extraction->origin = origin;
+    extraction->open = 0;
+    extraction->complete = 0;
+    extraction->fieldsStart = MAXULONG64;
+    extraction->fieldsEnd = 0;
+    ZeroMemory(extraction->rawLengths, sizeof(extraction->rawLengths));
+}
+
+// Implementation for INCALESCENT_File_FeedExtraction
+HRESULT INCALESCENT_File_FeedExtraction(const INCALESCENT_Match *match, INCALESCENT_File_Extraction *extraction, const BYTE *data, SIZE_T size,
+                                        BOOL *done) {
+    HRESULT result = S_OK;
+    const BYTE *ends[INCALESCENT_MATCH_MAX_KEYS];
+    const BYTE *end = data + size;
+    DWORD keyCount = INCALESCENT_Match_KeyCount(match);
+
+    // Search the raw UTF-8 bytes for all the keys at once. The keys are UTF-8 as well, and no UTF-8
+    // character starts in the middle of another, so a byte match is always a character match.
+    DWORD found = INCALESCENT_Match_Feed(match, &extraction->stream, data, size, ends);
+
+    // The values cut off by the previous chunk continue at the start of this one.
+    DWORD collecting = extraction->open | found;
+    while (collecting != 0) {
+        unsigned long key;
+        _BitScanForward(&key, collecting);
+        collecting &= collecting - 1;
+
+        const BYTE *valueStart = data;
+        if (found & (1UL << key)) {
+            valueStart = ends[key];
+            ULONGLONG keyStart = extraction->offset + (valueStart - data) - INCALESCENT_Match_KeyLength(match, key);
+            if (keyStart < extraction->fieldsStart) {
+                extraction->fieldsStart = keyStart;
+            }
+        }
+
+        // The '\r' character denotes the end of the field's value.
+        const BYTE *valueEnd = valueStart;
+        while (valueEnd < end && *valueEnd != '\r' && *valueEnd != '\n') {
+            valueEnd++;
+        }
+
+        // If length exceeds maximum this value is invalid. The "- 1" is for the null-terminating character.
+        SIZE_T length = valueEnd - valueStart;
+        if (extraction->rawLengths[key] + length > (INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH - 1)) {
+            result = INCALESCENT_ERROR_FIELD_VALUE_TOO_LARGE;
+            goto cleanup;
+        }
+        CopyMemory(extraction->raw[key] + extraction->rawLengths[key], valueStart, length);
+        extraction->rawLengths[key] += (BYTE) length;
+
+        if (valueEnd == end) {
+            extraction->open |= 1UL << key;
+            continue;
+        }
+        extraction->open &= ~(1UL << key);
+        extraction->complete |= 1UL << key;
+        ULONGLONG valueEndOffset = extraction->offset + (valueEnd - data) + 1;
+        if (valueEndOffset > extraction->fieldsEnd) {
+            extraction->fieldsEnd = valueEndOffset;
+        }
+    }
+
+    cleanup:
+    extraction->offset += size;
+    *done = extraction->complete == (1UL << keyCount) - 1;
+    return result;
+}
+
+// Implementation for INCALESCENT_File_FinishExtraction
+HRESULT INCALESCENT_File_FinishExtraction(const INCALESCENT_Match *match, const INCALESCENT_File_Extraction *extraction, BOOL endOfFile,
+                                          INCALESCENT_File_Value *values, DOUBLE *numbers) {
+    HRESULT result = S_OK;
+    DWORD keyCount = INCALESCENT_Match_KeyCount(match);
+
+    // A value that runs into the end of a chunk may have been cut off, so it doesn't count as found
+    // unless the chunk was the end of the file.
+    DWORD complete = extraction->complete;
+    if (endOfFile) {
+        complete |= extraction->open;
+    }
+    if (complete != (1UL << keyCount) - 1) {
+        result = INCALESCENT_ERROR_FIELD_VALUE_NOT_FOUND;
+        goto cleanup;
+    }
+
+    for (DWORD key = 0; key < keyCount; key++) {
+        const BYTE *raw = extraction->raw[key];
+        SIZE_T length = extraction->rawLengths[key];
+
+        // Numbers are parsed straight from the raw bytes.
+        if (numbers != NULL && !INCALESCENT_Number_Parse(raw, length, &numbers[key])) {
+            numbers[key] = NAN;
+        }
+
+        // Only the value itself is transcoded. UTF-8 never takes fewer bytes than UTF-16 takes
+        // characters, so the value always fits once its byte length has been checked.
+        INT wideCount = 0;
+        if (length != 0) {
+            wideCount = MultiByteToWideChar(CP_UTF8, 0, (LPCCH) raw, (INT) length, values[key], INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH - 1);
+            if (wideCount == 0) {
+                result = HRESULT_FROM_WIN32(GetLastError());
+                goto cleanup;
+            }
+        }
+        values[key][wideCount] = L'\0';
+    }
+
+    cleanup:
+    return result;
+}
 
-// Implementation for INCALESCENT_File_ReadTemperature
-HRESULT INCALESCENT_File_ReadTemperature(PWSTR path, WCHAR value[INCALESCENT_FILE_TEMPERATURE_FIELD_VALUE_MAX_LENGTH]) {
-    BYTE buffer[INCALESCENT_FILE_TEMPERATURE_RAW_BUFFER_SIZE];
+// Implementation for INCALESCENT_File_ReadFields
+HRESULT INCALESCENT_File_ReadFields(PWSTR path, const INCALESCENT_Match *match, INCALESCENT_Arena *scratch, INCALESCENT_File_Value *values) {
     HRESULT result = S_OK;
-    PWSTR string = NULL;
-    BOOL foundValue = FALSE;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    PBYTE buffer = NULL;
+    INCALESCENT_File_Extraction extraction;
 
-    HANDLE file = CreateFileW(
+    result = INCALESCENT_Arena_Allocate(scratch, INCALESCENT_FILE_READ_CHUNK_SIZE, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &buffer);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    file = CreateFileW(
             path,
             GENERIC_READ,
             0,
@@ -50,101 +203,143 @@ HRESULT INCALESCENT_File_ReadTemperature(PWSTR path, WCHAR value[INCALESCENT_FIL
         goto cleanup;
     }
 
-    DWORD readCount = 0;
-    BOOL readResult = ReadFile(file, buffer, INCALESCENT_FILE_TEMPERATURE_RAW_BUFFER_SIZE, &readCount, NULL);
-    if (!readResult) {
-        result = HRESULT_FROM_WIN32(GetLastError());
-        goto cleanup;
-    }
+    // Keep reading until every value is complete or the file ends.
+    INCALESCENT_File_BeginExtraction(match, &extraction, 0);
+    BOOL done = FALSE;
+    BOOL endOfFile = FALSE;
+    while (!done && !endOfFile) {
+        DWORD readCount = 0;
+        BOOL readResult = ReadFile(file, buffer, INCALESCENT_FILE_READ_CHUNK_SIZE, &readCount, NULL);
+        if (!readResult) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        endOfFile = readCount < INCALESCENT_FILE_READ_CHUNK_SIZE;
 
-    INT wideCount = MultiByteToWideChar(CP_UTF8, 0, (LPCCH) buffer, INCALESCENT_FILE_TEMPERATURE_RAW_BUFFER_SIZE, NULL,
-                                        0);
-    if (wideCount == 0) {
-        result = HRESULT_FROM_WIN32(GetLastError());
-        goto cleanup;
+        result = INCALESCENT_File_FeedExtraction(match, &extraction, buffer, readCount, &done);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
     }
-    wideCount = CLAMP_POSITIVE(wideCount, INCALESCENT_FILE_TEMPERATURE_CHARACTER_BUFFER_MAX_LENGTH);
 
-    string = VirtualAlloc(NULL, wideCount, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
-    if (string == NULL) {
-        result = HRESULT_FROM_WIN32(GetLastError());
-        goto cleanup;
-    }
+    result = INCALESCENT_File_FinishExtraction(match, &extraction, endOfFile, values, NULL);
 
-    wideCount = MultiByteToWideChar(CP_UTF8, 0, (LPCCH) buffer, INCALESCENT_FILE_TEMPERATURE_RAW_BUFFER_SIZE, string,
-                                    wideCount);
-    if (wideCount == 0) {
-        result = HRESULT_FROM_WIN32(GetLastError());
-        goto cleanup;
+    cleanup:
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
     }
 
-    SIZE_T matchCount = 0;
-    SIZE_T valueIndex = 0;
+    return result;
+}
 
-    for (SIZE_T index = 0; index < wideCount; index++) {
-        WCHAR character = string[index];
+// Implementation for INCALESCENT_File_CreateNames
+HRESULT INCALESCENT_File_CreateNames(INCALESCENT_File_Names *names, INCALESCENT_Arena *arena) {
+    ZeroMemory(names, sizeof(INCALESCENT_File_Names));
+    names->arena = arena;
+    return INCALESCENT_Arena_Create(&names->index, INCALESCENT_FILE_NAME_INDEX_RESERVE);
+}
 
-        // If there was a perfect match of characters we can start adding them
-        // to the value buffer.
-        if (matchCount == INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING_LENGTH) {
-            // The '\r' character denotes the end of the field's value.
-            if (character == '\r') {
-                value[valueIndex] = '\0';
-                foundValue = TRUE;
-                break;
-            }
+// Copies a name into the arena behind its information and appends a pointer to it to the entry
+// array. Nothing else is allocated from the index arena, so every new entry lands directly after
+// the previous one.
+static HRESULT INCALESCENT_File_AppendName(INCALESCENT_File_Names *names, const WIN32_FIND_DATAW *data, SIZE_T nameLength) {
+    HRESULT result = S_OK;
+    INCALESCENT_File_NameInfo *info = NULL;
+    PWSTR *entry = NULL;
+    SIZE_T size = sizeof(INCALESCENT_File_NameInfo) + sizeof(WCHAR) * (nameLength + 1);
 
-            // If length exceeds maximum this value is invalid. The "- 1" is for the null-terminating character.
-            if (valueIndex == (INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING_LENGTH - 1)) {
-                result = INCALESCENT_ERROR_FIELD_VALUE_TOO_LARGE;
+    // A list kept within a budget is spilled before the name would take it past the budget, which
+    // covers sorting the names as well as holding them.
+    if (names->spill != NULL) {
+        SIZE_T sortSize = 0;
+        result = INCALESCENT_String_SortSize(data->cFileName, &sortSize);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        SIZE_T needed = INCALESCENT_ARENA_ROUND_UP(names->arena->used, sizeof(ULONGLONG)) + size + names->index.used + sizeof(PWSTR) +
+                        names->sortSize + sortSize + INCALESCENT_STRING_SORT_SLACK;
+        if (names->count != 0 && needed > names->budget) {
+            result = names->spill(names->spillContext, names);
+            if (FAILED(result)) {
                 goto cleanup;
             }
-
-            value[valueIndex] = character;
-            valueIndex++;
-            continue;
-        }
-
-        // Determine if the character is a match, if not reset and try again
-        if (character == INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING[matchCount]) {
-            matchCount++;
-        } else {
-            matchCount = 0;
         }
+        names->sortSize += sortSize;
     }
 
-    if (!foundValue) {
-        result = INCALESCENT_ERROR_FIELD_VALUE_NOT_FOUND;
+    result = INCALESCENT_Arena_Allocate(names->arena, size, sizeof(ULONGLONG), (PVOID *) &info);
+    if (FAILED(result)) {
+        goto cleanup;
     }
+    info->size = ((ULONGLONG) data->nFileSizeHigh << 32) | data->nFileSizeLow;
+    info->lastWriteTime = ((ULONGLONG) data->ftLastWriteTime.dwHighDateTime << 32) | data->ftLastWriteTime.dwLowDateTime;
+    info->length = nameLength;
+    CopyMemory(info + 1, data->cFileName, sizeof(WCHAR) * (nameLength + 1));
 
-    cleanup:
-    if (string != NULL) {
-        VirtualFree(string, 0, MEM_FREE);
-    }
-    if (file != INVALID_HANDLE_VALUE) {
-        CloseHandle(file);
+    result = INCALESCENT_Arena_Allocate(&names->index, sizeof(PWSTR), sizeof(PWSTR), (PVOID *) &entry);
+    if (FAILED(result)) {
+        goto cleanup;
     }
+    *entry = (PWSTR) (info + 1);
+
+    names->entries = (PWSTR *) names->index.base;
+    names->count++;
 
+    cleanup:
     return result;
 }
 
-HRESULT INCALESCENT_File_FilteredNamesSorted(PWSTR directory, PBYTE nameAllocation, PSIZE_T nameAllocationSize, PSIZE_T fileCount) {
+// Implementation for INCALESCENT_File_ClearNames
+void INCALESCENT_File_ClearNames(INCALESCENT_File_Names *names) {
+    INCALESCENT_Arena_Reset(&names->index, 0);
+    names->entries = NULL;
+    names->count = 0;
+    names->sortSize = 0;
+}
+
+// Implementation for INCALESCENT_File_FreeNames
+void INCALESCENT_File_FreeNames(INCALESCENT_File_Names *names) {
+    INCALESCENT_Arena_Destroy(&names->index);
+    names->entries = NULL;
+    names->count = 0;
+}
+
+// Called for every data file or subdirectory a search finds.
+typedef HRESULT (*INCALESCENT_File_FoundCallback)(PVOID context, const WIN32_FIND_DATAW *data, SIZE_T nameLength);
+
+// Searches a directory in a single pass, handing every data file to one callback and every
+// subdirectory to the other, which may be NULL to skip them. Reparse points are skipped either way.
+static HRESULT INCALESCENT_File_Find(PWSTR directory, PCWSTR suffix, BOOL details, INCALESCENT_File_FoundCallback foundFile,
+                                     INCALESCENT_File_FoundCallback foundDirectory, PVOID context) {
     HRESULT result;
     WCHAR buffer[INCALESCENT_FILE_FILTER_AGGREGATE_SIZE];
-    SIZE_T filesFound = 0;
+    HANDLE find = INVALID_HANDLE_VALUE;
+    SIZE_T suffixLength = lstrlenW(suffix);
 
     result = StringCchCopyW(buffer, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, directory);
     if (FAILED(result)) {
         goto cleanup;
     }
 
-    result = StringCchCatW(buffer, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, INCALESCENT_FILE_FILTER);
+    result = StringCchCatW(buffer, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, INCALESCENT_FILE_FILTER_PATTERN);
     if (FAILED(result)) {
         goto cleanup;
     }
 
+    // Without subdirectories to collect, only the data files have to come back from the search.
+    if (foundDirectory == NULL) {
+        result = StringCchCatW(buffer, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, suffix);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    // Enumerate every entry in a single pass. The basic information level skips the short
+    // name lookup and the large fetch flag asks for bigger batches per directory query, which
+    // saves round trips on network shares.
     WIN32_FIND_DATAW data;
-    HANDLE find = FindFirstFileW(buffer, &data);
+    find = FindFirstFileExW(buffer, FindExInfoBasic, &data, FindExSearchNameMatch, NULL,
+                            FIND_FIRST_EX_LARGE_FETCH | (details ? 0 : INCALESCENT_FIND_NAMES_ONLY));
     if (find == INVALID_HANDLE_VALUE) {
         DWORD lastError = GetLastError();
         // If a file couldn't be found, that's okay. Just inform the user.
@@ -156,9 +351,6 @@ HRESULT INCALESCENT_File_FilteredNamesSorted(PWSTR directory, PBYTE nameAllocati
         goto cleanup;
     }
 
-    PWSTR *allocationStringPointer = (PWSTR *) nameAllocation;
-    PBYTE allocationStringStart = nameAllocation + (sizeof(PWSTR) * *fileCount);
-
     do {
         // Obtain the length of the file name string.
         SIZE_T nameLength = 0;
@@ -167,161 +359,898 @@ HRESULT INCALESCENT_File_FilteredNamesSorted(PWSTR directory, PBYTE nameAllocati
             goto cleanup;
         }
 
-        // Increment the number of files that have been found
-        filesFound += 1;
-
-        // Increase the size of the allocation required to store the file names.
-        // Each string needs an associated pointer that resides in the beginning of
-        // the memory allocation along with the actual string stored somewhere within
-        // the allocation.
-        *nameAllocationSize += sizeof(PWSTR) + (sizeof(WCHAR) * (nameLength + 1));
+        // Subdirectories are only collected when asked for. Reparse points are left out so that
+        // links can't lead a walk in circles.
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            BOOL dots = data.cFileName[0] == L'.' && (nameLength == 1 || (nameLength == 2 && data.cFileName[1] == L'.'));
+            if (foundDirectory != NULL && !dots && !(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+                result = foundDirectory(context, &data, nameLength);
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+            }
+            continue;
+        }
 
-        // If there is no names buffer to write to, then there is no need to write to it.
-        if (nameAllocation == NULL) {
+        // Only keep entries ending with the data file suffix. Matching the suffix here rather than
+        // in the search pattern also avoids false positives from short (8.3) name matching.
+        if (nameLength <= suffixLength) {
+            continue;
+        }
+        INT comparison = CompareStringOrdinal(
+                data.cFileName + (nameLength - suffixLength),
+                (INT) suffixLength,
+                suffix,
+                (INT) suffixLength,
+                TRUE
+        );
+        if (comparison != CSTR_EQUAL) {
             continue;
         }
 
-        // Copy the file's name into the allocation at its appropriate location.
-        PWSTR stringStart = (PWSTR) allocationStringStart;
-        result = StringCchCopyW(stringStart, nameLength + 1, data.cFileName);
+        result = foundFile(context, &data, nameLength);
         if (FAILED(result)) {
             goto cleanup;
         }
-        *allocationStringPointer = (PWSTR) allocationStringStart;
-
-        allocationStringPointer++;
-        allocationStringStart += sizeof(WCHAR) * (nameLength + 1);
     } while (FindNextFileW(find, &data) != FALSE);
 
     // Catch any errors that FindNextFileW may have
     DWORD lastError = GetLastError();
-    if (lastError != 0) {
-        if (lastError != ERROR_NO_MORE_FILES) {
-            result = HRESULT_FROM_WIN32(GetLastError());
-            goto cleanup;
-        }
+    if (lastError != ERROR_NO_MORE_FILES) {
+        result = HRESULT_FROM_WIN32(lastError);
+        goto cleanup;
     }
 
-    // This function run is simply to determine the allocation size and file count.
-    // There is no writing of file names to a buffer occurring yet.
-    if (nameAllocation == NULL) {
-        goto cleanup;
+    cleanup:
+    if (find != INVALID_HANDLE_VALUE) {
+        FindClose(find);
     }
+    return result;
+}
 
-    if (filesFound != *fileCount) {
-        result = INCALESCENT_ERROR_DATA_FILE_COUNT_MISMATCH;
-        goto cleanup;
+// The lists an enumeration appends to.
+typedef struct INCALESCENT_File_EnumerateContext {
+    INCALESCENT_File_Names *names;
+    INCALESCENT_File_Names *directories;
+} INCALESCENT_File_EnumerateContext;
+
+static HRESULT INCALESCENT_File_FoundName(PVOID parameter, const WIN32_FIND_DATAW *data, SIZE_T nameLength) {
+    INCALESCENT_File_EnumerateContext *context = parameter;
+    return INCALESCENT_File_AppendName(context->names, data, nameLength);
+}
+
+static HRESULT INCALESCENT_File_FoundDirectory(PVOID parameter, const WIN32_FIND_DATAW *data, SIZE_T nameLength) {
+    INCALESCENT_File_EnumerateContext *context = parameter;
+    return INCALESCENT_File_AppendName(context->directories, data, nameLength);
+}
+
+// Implementation for INCALESCENT_File_Enumerate
+HRESULT INCALESCENT_File_Enumerate(PWSTR directory, PCWSTR suffix, BOOL details, INCALESCENT_File_Names *names, INCALESCENT_File_Names *directories) {
+    INCALESCENT_File_EnumerateContext context = {
+            .names = names,
+            .directories = directories,
+    };
+    return INCALESCENT_File_Find(directory, suffix, details, INCALESCENT_File_FoundName, directories == NULL ? NULL : INCALESCENT_File_FoundDirectory,
+                                 &context);
+}
+
+static HRESULT INCALESCENT_File_FoundPooledName(PVOID parameter, const WIN32_FIND_DATAW *data, SIZE_T nameLength) {
+    return INCALESCENT_NamePool_Append(parameter, data->cFileName, nameLength,
+                                       ((ULONGLONG) data->nFileSizeHigh << 32) | data->nFileSizeLow,
+                                       ((ULONGLONG) data->ftLastWriteTime.dwHighDateTime << 32) | data->ftLastWriteTime.dwLowDateTime);
+}
+
+// Implementation for INCALESCENT_File_FilteredNamesSorted
+HRESULT INCALESCENT_File_FilteredNamesSorted(PWSTR directory, PCWSTR suffix, BOOL details, INCALESCENT_NamePool *names, INCALESCENT_Arena *arena, INCALESCENT_Pool *pool) {
+    ULONGLONG start = INCALESCENT_Perf_Now();
+    HRESULT result = INCALESCENT_File_Find(directory, suffix, details, INCALESCENT_File_FoundPooledName, NULL, names);
+    if (FAILED(result)) {
+        return result;
     }
+    INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_ENUMERATE, start);
 
     // Sort all the file names alphanumerically.
-    result = INCALESCENT_String_BubbleSort(nameAllocation, *fileCount);
+    start = INCALESCENT_Perf_Now();
+    result = INCALESCENT_NamePool_Sort(names, arena, pool);
+    INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_SORT, start);
+    return result;
+}
 
-    cleanup:
+// Implementation for INCALESCENT_File_JoinValues
+SIZE_T INCALESCENT_File_JoinValues(const INCALESCENT_File_Value *values, DWORD fieldCount, WCHAR separator,
+                                   WCHAR joined[INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH]) {
+    SIZE_T length = 0;
+    for (DWORD field = 0; field < fieldCount; field++) {
+        if (field != 0) {
+            joined[length++] = separator;
+        }
+        for (const WCHAR *character = values[field]; *character != L'\0'; character++) {
+            joined[length++] = *character;
+        }
+    }
+    joined[length] = L'\0';
+    return length;
+}
+
+// Implementation for INCALESCENT_File_LookupValues
+BOOL INCALESCENT_File_LookupValues(const INCALESCENT_Cache *cache, PWSTR name, DWORD fieldCount, INCALESCENT_File_Value *values) {
+    WCHAR joined[INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH];
+    const INCALESCENT_File_NameInfo *info = INCALESCENT_FILE_NAME_INFO(name);
+
+    if (!INCALESCENT_Cache_Lookup(cache, name, info->length, info->size, info->lastWriteTime, joined, INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH)) {
+        return FALSE;
+    }
+
+    // Split the values back up. A record with a different number of values or a value that is too
+    // long doesn't count.
+    DWORD field = 0;
+    SIZE_T length = 0;
+    for (const WCHAR *character = joined;; character++) {
+        if (*character == INCALESCENT_FILE_CACHE_VALUE_SEPARATOR || *character == L'\0') {
+            if (field == fieldCount) {
+                return FALSE;
+            }
+            values[field][length] = L'\0';
+            field++;
+            length = 0;
+            if (*character == L'\0') {
+                break;
+            }
+            continue;
+        }
+        if (field == fieldCount || length == (INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH - 1)) {
+            return FALSE;
+        }
+        values[field][length++] = *character;
+    }
+    return field == fieldCount;
+}
+
+// Implementation for INCALESCENT_File_RecordValues
+HRESULT INCALESCENT_File_RecordValues(INCALESCENT_Cache *cache, PWSTR name, DWORD fieldCount, const INCALESCENT_File_Value *values) {
+    WCHAR joined[INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH];
+    const INCALESCENT_File_NameInfo *info = INCALESCENT_FILE_NAME_INFO(name);
+
+    SIZE_T length = INCALESCENT_File_JoinValues(values, fieldCount, INCALESCENT_FILE_CACHE_VALUE_SEPARATOR, joined);
+    return INCALESCENT_Cache_Record(cache, name, info->length, info->size, info->lastWriteTime, joined, length);
+}
+
+// Implementation for INCALESCENT_File_ParseValues
+void INCALESCENT_File_ParseValues(const INCALESCENT_File_Value *values, DWORD fieldCount, DOUBLE *numbers) {
+    BYTE text[INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH];
+    for (DWORD field = 0; field < fieldCount; field++) {
+        SIZE_T length = 0;
+        BOOL ascii = TRUE;
+        for (; values[field][length] != L'\0'; length++) {
+            ascii = ascii && values[field][length] < 0x80;
+            text[length] = (BYTE) values[field][length];
+        }
+        if (!ascii || !INCALESCENT_Number_Parse(text, length, &numbers[field])) {
+            numbers[field] = NAN;
+        }
+    }
+}
+
+// Implementation for INCALESCENT_File_AddStatistics
+void INCALESCENT_File_AddStatistics(INCALESCENT_Stats *statistics, const INCALESCENT_File_Value *values, const DOUBLE *numbers, DWORD fieldCount) {
+    DOUBLE parsed[INCALESCENT_FILE_MAX_FIELDS];
+    if (numbers == NULL) {
+        INCALESCENT_File_ParseValues(values, fieldCount, parsed);
+        numbers = parsed;
+    }
+    for (DWORD field = 0; field < fieldCount; field++) {
+        INCALESCENT_Stats_Add(&statistics[field], numbers[field]);
+    }
+}
+
+// Returns the name of the data file with an index, decoding it into the buffer if it is in a pool.
+static PCWSTR INCALESCENT_File_ReadName(const INCALESCENT_File_ReadContext *context, SIZE_T index, PWSTR buffer) {
+    if (context->namePool == NULL) {
+        return context->names[index];
+    }
+    INCALESCENT_NamePool_Get(context->namePool, context->namePool->order[index], buffer, NULL, NULL);
+    return buffer;
+}
+
+// Counts a data file as read, logging the progress every so often.
+static HRESULT INCALESCENT_File_ReportRead(const INCALESCENT_File_ReadContext *context) {
+    INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_FILES_READ, 1);
+    LONG64 done = InterlockedIncrement64(context->readDone);
+    return INCALESCENT_LOG_PROGRESS_W(L"Read %lld of %llu data files...", done, context->readTotal);
+}
+
+// Implementation for INCALESCENT_File_IsIncomplete
+BOOL INCALESCENT_File_IsIncomplete(HRESULT result) {
+    // A file that is still open for writing can't be opened, and a file that is only partly written
+    // may not contain the whole value yet, or in the case of an image may not even have its
+    // directories yet.
+    return result == HRESULT_FROM_WIN32(ERROR_SHARING_VIOLATION) || result == INCALESCENT_ERROR_FIELD_VALUE_NOT_FOUND ||
+           result == HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+}
+
+// Records the failure of a data file that is still being written instead of failing the read, if
+// the context asks for that.
+static BOOL INCALESCENT_File_DeferIncomplete(const INCALESCENT_File_ReadContext *context, SIZE_T tag, HRESULT *result) {
+    if (context->failures == NULL || !INCALESCENT_File_IsIncomplete(*result)) {
+        return FALSE;
+    }
+    context->failures[tag] = *result;
+    *result = S_OK;
+    return TRUE;
+}
+
+// Remembers where the fields of a data file were, so the next data file is read from there. When
+// they don't fit into a single chunk, the next data file is read from the start.
+static void INCALESCENT_File_LearnHint(volatile LONG64 *hint, const INCALESCENT_File_Extraction *extraction) {
+    ULONGLONG start = extraction->fieldsStart & ~((ULONGLONG) INCALESCENT_FILE_READ_HINT_ALIGNMENT - 1);
+    LONG64 learned = 0;
+    if (extraction->fieldsEnd - start <= INCALESCENT_FILE_READ_CHUNK_SIZE) {
+        learned = (LONG64) start;
+    }
+
+    // The hint is shared by every worker, so it is only written when it changes.
+    if (*hint != learned) {
+        InterlockedExchange64(hint, learned);
+    }
+}
+
+// Reads the fields of every data file listed in [begin, end) of the index array into its slots
+// of the value array. Each file owns its own slot, so the table can be written in index order once
+// all workers are done. The worker keeps its I/O engine full, parsing each chunk as soon as its
+// read completes and reading the next chunk of a file only if its fields aren't complete yet.
+static HRESULT INCALESCENT_File_ReadChunk(PVOID parameter, DWORD worker, SIZE_T begin, SIZE_T end) {
+    INCALESCENT_File_ReadContext *context = parameter;
+    HRESULT result = S_OK;
+    WCHAR filePathBuffer[INCALESCENT_FILE_FILTER_AGGREGATE_SIZE];
+    WCHAR name[INCALESCENT_NAMEPOOL_MAX_NAME_LENGTH];
+    WCHAR joined[INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH];
+    INCALESCENT_Io_Completion completions[INCALESCENT_IO_MAX_BATCH];
+    INCALESCENT_Io *io = context->io[worker];
+    SIZE_T next = begin;
+
+    // The extraction of every file in flight, by the slot its reads go through.
+    INCALESCENT_File_Extraction extractions[INCALESCENT_FILE_IO_DEPTH];
+    BOOL extracting[INCALESCENT_FILE_IO_DEPTH] = {0};
+
+    while (next < end || INCALESCENT_Io_Pending(io) != 0) {
+        while (next < end && INCALESCENT_Io_CanSubmit(io)) {
+            // Create a new string which contains the file's full path
+            result = StringCchPrintfW(filePathBuffer, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, L"%s\\%s", context->dataDirectory,
+                                      INCALESCENT_File_ReadName(context, context->indices[next], name));
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+
+            result = INCALESCENT_Io_Submit(io, filePathBuffer, context->indices[next], (ULONGLONG) *context->hint);
+            if (FAILED(result) && !INCALESCENT_File_DeferIncomplete(context, context->indices[next], &result)) {
+                goto cleanup;
+            }
+            next++;
+        }
+        if (INCALESCENT_Io_Pending(io) == 0) {
+            continue;
+        }
+
+        DWORD completionCount = 0;
+        result = INCALESCENT_Io_Complete(io, completions, INCALESCENT_IO_MAX_BATCH, &completionCount);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        // Every completion is released, even after a failure, so that its slot can be reused.
+        for (DWORD index = 0; index < completionCount; index++) {
+            INCALESCENT_Io_Completion *completion = &completions[index];
+            INCALESCENT_File_Extraction *extraction = &extractions[completion->slot];
+            ULONGLONG parsing = INCALESCENT_Perf_Now();
+            if (!extracting[completion->slot]) {
+                INCALESCENT_File_BeginExtraction(context->match, extraction, completion->offset);
+                extracting[completion->slot] = TRUE;
+            }
+
+            BOOL done = FALSE;
+            if (SUCCEEDED(result)) {
+                result = completion->result;
+            }
+            if (SUCCEEDED(result)) {
+                result = INCALESCENT_File_FeedExtraction(context->match, extraction, completion->data, completion->size, &done);
+            }
+            if (SUCCEEDED(result) && !done) {
+                // A file read from the hint that didn't have every field within that chunk is
+                // started over from its beginning. Any other file carries on with its next chunk.
+                ULONGLONG offset = completion->offset + completion->size;
+                BOOL restart = extraction->origin != 0;
+                if (restart) {
+                    INCALESCENT_File_BeginExtraction(context->match, extraction, 0);
+                    offset = 0;
+                }
+                if (restart || !completion->endOfFile) {
+                    INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_PARSE, parsing);
+                    result = INCALESCENT_Io_Continue(io, completion, offset);
+                    if (SUCCEEDED(result)) {
+                        continue;
+                    }
+                }
+            }
 
-    *fileCount = filesFound;
+            INCALESCENT_File_Value *values = context->values + (completion->tag * context->fieldCount);
+            if (SUCCEEDED(result)) {
+                DOUBLE *numbers = context->numbers == NULL ? NULL : context->numbers + (completion->tag * context->fieldCount);
+                result = INCALESCENT_File_FinishExtraction(context->match, extraction, completion->endOfFile, values, numbers);
+                if (SUCCEEDED(result) && context->statistics != NULL) {
+                    INCALESCENT_File_AddStatistics(context->statistics + (worker * context->fieldCount), values, numbers, context->fieldCount);
+                }
+                INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_PARSE, parsing);
+            }
+            if (SUCCEEDED(result)) {
+                INCALESCENT_File_LearnHint(context->hint, extraction);
+                INCALESCENT_File_JoinValues(values, context->fieldCount, L',', joined);
+                result = INCALESCENT_LOG_DETAIL_FORMATTED_W(L"Read fields for %s, values discovered to be %s ...",
+                                                            INCALESCENT_File_ReadName(context, completion->tag, name), joined);
+            }
+            if (SUCCEEDED(result)) {
+                result = INCALESCENT_File_ReportRead(context);
+            } else {
+                INCALESCENT_File_DeferIncomplete(context, completion->tag, &result);
+            }
+            extracting[completion->slot] = FALSE;
+            INCALESCENT_Io_Release(io, completion);
+        }
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    cleanup:
+    if (FAILED(result)) {
+        INCALESCENT_Io_Drain(io);
+    }
     return result;
 }
 
-HRESULT INCALESCENT_File_ReadAndWrite(PWSTR dataDirectory, PWSTR consolidatedFile) {
+// Implementation for INCALESCENT_File_MapFile
+HRESULT INCALESCENT_File_MapFile(PCWSTR path, const BYTE **view, SIZE_T *size) {
     HRESULT result = S_OK;
-    HANDLE file = NULL;
-    PBYTE names = NULL;
-    HANDLE heap = GetProcessHeap();
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
 
-    file = CreateFileW(consolidatedFile, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    *view = NULL;
+    *size = 0;
+
+    file = CreateFileW(
+            path,
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            NULL,
+            OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN,
+            NULL
+    );
     if (file == INVALID_HANDLE_VALUE) {
         result = HRESULT_FROM_WIN32(GetLastError());
         goto cleanup;
     }
 
-    SIZE_T allocationSize = 0;
-    SIZE_T fileCount = 0;
-    result = INCALESCENT_File_FilteredNamesSorted(dataDirectory, NULL, &allocationSize, &fileCount);\
-    if (FAILED(result)) {
-        goto cleanup;
-    }
-    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Found %d valid data files...", fileCount);
-    if (FAILED(result)) {
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
         goto cleanup;
     }
-    if (fileCount == 0) {
-        result = INCALESCENT_ERROR_NO_DATA_FILES_FOUND;
+    if (fileSize.QuadPart == 0) {
         goto cleanup;
     }
 
-    names = HeapAlloc(heap, HEAP_ZERO_MEMORY, allocationSize);
-    if (names == NULL) {
+    mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
         result = HRESULT_FROM_WIN32(GetLastError());
         goto cleanup;
     }
-    result = INCALESCENT_File_FilteredNamesSorted(dataDirectory, names, &allocationSize, &fileCount);
-    if (FAILED(result)) {
+    *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (*view == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
         goto cleanup;
     }
+    *size = (SIZE_T) fileSize.QuadPart;
 
-    WCHAR buffer[INCALESCENT_TABLE_ROW_LENGTH];
-    result = StringCchCopyW(buffer, INCALESCENT_TABLE_ROW_LENGTH, INCALESCENT_TABLE_HEADER_STRING);
+    // The view keeps the file open by itself.
+    cleanup:
+    if (mapping != NULL) {
+        CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    return result;
+}
+
+typedef struct INCALESCENT_File_TiffFeed {
+    const INCALESCENT_Match *match;
+    INCALESCENT_File_Extraction *extraction;
+} INCALESCENT_File_TiffFeed;
+
+// Feeds the text of a tag to an extraction, followed by a line break so that a value at the end of
+// the tag ends there. Stops the walk once every field has been found.
+static HRESULT INCALESCENT_File_FeedTiffText(PVOID parameter, const BYTE *text, SIZE_T length) {
+    INCALESCENT_File_TiffFeed *feed = parameter;
+    BOOL done = FALSE;
+    HRESULT result = INCALESCENT_File_FeedExtraction(feed->match, feed->extraction, text, length, &done);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_File_FeedExtraction(feed->match, feed->extraction, (const BYTE *) "\n", 1, &done);
+    }
+    if (SUCCEEDED(result) && done) {
+        result = S_FALSE;
+    }
+    return result;
+}
+
+// Feeds the text tags of a TIFF image in memory to an extraction.
+static HRESULT INCALESCENT_File_FeedTiff(const INCALESCENT_Match *match, INCALESCENT_File_Extraction *extraction, const BYTE *data, SIZE_T size) {
+    INCALESCENT_File_TiffFeed feed = {.match = match, .extraction = extraction};
+    return INCALESCENT_Tiff_ForEachText(data, size, INCALESCENT_File_FeedTiffText, &feed);
+}
+
+// Implementation for INCALESCENT_File_ReadTiffFields
+HRESULT INCALESCENT_File_ReadTiffFields(PCWSTR path, const INCALESCENT_Match *match, INCALESCENT_File_Value *values) {
+    HRESULT result = S_OK;
+    const BYTE *view = NULL;
+    SIZE_T size = 0;
+    INCALESCENT_File_Extraction extraction;
+
+    result = INCALESCENT_File_MapFile(path, &view, &size);
     if (FAILED(result)) {
         goto cleanup;
     }
 
-    DWORD writeCount = 0;
-    BOOL writeResult = WriteFile(file, buffer, sizeof(WCHAR) * (INCALESCENT_TABLE_HEADER_STRING_LENGTH), &writeCount, NULL);
-    if (!writeResult) {
-        result = HRESULT_FROM_WIN32(GetLastError());
-        goto cleanup;
+    INCALESCENT_File_BeginExtraction(match, &extraction, 0);
+    __try {
+        if (size != 0) {
+            result = INCALESCENT_File_FeedTiff(match, &extraction, view, size);
+        }
+    } __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+        result = HRESULT_FROM_WIN32(ERROR_READ_FAULT);
+    }
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_File_FinishExtraction(match, &extraction, TRUE, values, NULL);
     }
 
+    cleanup:
+    if (view != NULL) {
+        UnmapViewOfFile(view);
+    }
+    return result;
+}
+
+// Reads the fields of every data file listed in [begin, end) of the index array by mapping it into
+// memory and scanning it in place. The files are mapped a batch at a time, and the pages the fields
+// were last found in are prefetched for the whole batch with a single call, so the batch is read
+// from the drive concurrently before any of it is scanned.
+static HRESULT INCALESCENT_File_ReadChunkMapped(PVOID parameter, DWORD worker, SIZE_T begin, SIZE_T end) {
+    INCALESCENT_File_ReadContext *context = parameter;
+    HRESULT result = S_OK;
     WCHAR filePathBuffer[INCALESCENT_FILE_FILTER_AGGREGATE_SIZE];
+    WCHAR name[INCALESCENT_NAMEPOOL_MAX_NAME_LENGTH];
+    WCHAR joined[INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH];
+    const BYTE *views[INCALESCENT_FILE_MAP_BATCH];
+    SIZE_T sizes[INCALESCENT_FILE_MAP_BATCH];
+    WIN32_MEMORY_RANGE_ENTRY ranges[INCALESCENT_FILE_MAP_BATCH];
+    DWORD mappedCount = 0;
 
-    PWSTR *mappedString = (PWSTR *) names;
-    for (SIZE_T index = 0; index < fileCount; index++) {
-        // Create a new string which contains the file's full path
-        PWSTR fileName = *(mappedString + index);
-        result = StringCchPrintfW(filePathBuffer, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, L"%s\\%s", dataDirectory, fileName);
-        if (FAILED(result)) {
-            goto cleanup;
+    for (SIZE_T batch = begin; batch < end; batch += INCALESCENT_FILE_MAP_BATCH) {
+        SIZE_T batchEnd = batch + INCALESCENT_FILE_MAP_BATCH < end ? batch + INCALESCENT_FILE_MAP_BATCH : end;
+        ULONGLONG prefetchEnd = (ULONGLONG) *context->hint + INCALESCENT_FILE_READ_CHUNK_SIZE;
+        ULONG rangeCount = 0;
+
+        for (SIZE_T next = batch; next < batchEnd; next++) {
+            result = StringCchPrintfW(filePathBuffer, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, L"%s\\%s", context->dataDirectory,
+                                      INCALESCENT_File_ReadName(context, context->indices[next], name));
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+
+            // A file that couldn't be mapped keeps its place in the batch without a view.
+            ULONGLONG opening = INCALESCENT_Perf_Now();
+            result = INCALESCENT_File_MapFile(filePathBuffer, &views[mappedCount], &sizes[mappedCount]);
+            if (FAILED(result) && !INCALESCENT_File_DeferIncomplete(context, context->indices[next], &result)) {
+                goto cleanup;
+            }
+            INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_OPEN, opening);
+            if (sizes[mappedCount] != 0) {
+                ranges[rangeCount].VirtualAddress = (PVOID) views[mappedCount];
+                ranges[rangeCount].NumberOfBytes = sizes[mappedCount] < prefetchEnd ? sizes[mappedCount] : (SIZE_T) prefetchEnd;
+                rangeCount++;
+            }
+            mappedCount++;
         }
-        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Reading temperature for %s ...", fileName);
-        if (FAILED(result)) {
-            goto cleanup;
+
+        // Prefetching is only a hint, so it failing doesn't matter.
+        if (rangeCount != 0) {
+            ULONGLONG prefetching = INCALESCENT_Perf_Now();
+            PrefetchVirtualMemory(GetCurrentProcess(), rangeCount, ranges, 0);
+            INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_READ, prefetching);
         }
 
-        // Attempt to retrieve the data value from the file
-        WCHAR value[INCALESCENT_FILE_TEMPERATURE_FIELD_VALUE_MAX_LENGTH];
-        result = INCALESCENT_File_ReadTemperature(filePathBuffer, value);
-        if (FAILED(result)) {
-            goto cleanup;
+        for (DWORD mapped = 0; mapped < mappedCount; mapped++) {
+            SIZE_T tag = context->indices[batch + mapped];
+            INCALESCENT_File_Value *values = context->values + (tag * context->fieldCount);
+            DOUBLE *numbers = context->numbers == NULL ? NULL : context->numbers + (tag * context->fieldCount);
+            INCALESCENT_File_Extraction extraction;
+            BOOL done = FALSE;
+            if (context->failures != NULL && FAILED(context->failures[tag])) {
+                continue;
+            }
+
+            // A mapped file that can't be read, say because the network share it is on went away,
+            // raises an exception when its pages are touched instead of failing a read.
+            ULONGLONG parsing = INCALESCENT_Perf_Now();
+            INCALESCENT_File_BeginExtraction(context->match, &extraction, 0);
+            __try {
+                if (sizes[mapped] != 0 && context->tiff) {
+                    result = INCALESCENT_File_FeedTiff(context->match, &extraction, views[mapped], sizes[mapped]);
+                } else if (sizes[mapped] != 0) {
+                    result = INCALESCENT_File_FeedExtraction(context->match, &extraction, views[mapped], sizes[mapped], &done);
+                }
+            } __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+                result = HRESULT_FROM_WIN32(ERROR_READ_FAULT);
+            }
+            if (SUCCEEDED(result)) {
+                result = INCALESCENT_File_FinishExtraction(context->match, &extraction, TRUE, values, numbers);
+                if (SUCCEEDED(result) && context->statistics != NULL) {
+                    INCALESCENT_File_AddStatistics(context->statistics + (worker * context->fieldCount), values, numbers, context->fieldCount);
+                }
+                INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_PARSE, parsing);
+                INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_BYTES_READ, sizes[mapped]);
+            }
+            if (SUCCEEDED(result)) {
+                // Where the fields were found in the text of the tags says nothing about the file.
+                if (!context->tiff) {
+                    INCALESCENT_File_LearnHint(context->hint, &extraction);
+                }
+                INCALESCENT_File_JoinValues(values, context->fieldCount, L',', joined);
+                result = INCALESCENT_LOG_DETAIL_FORMATTED_W(L"Read fields for %s, values discovered to be %s ...", INCALESCENT_File_ReadName(context, tag, name), joined);
+            }
+            if (SUCCEEDED(result)) {
+                result = INCALESCENT_File_ReportRead(context);
+            } else {
+                INCALESCENT_File_DeferIncomplete(context, tag, &result);
+            }
+            if (FAILED(result)) {
+                goto cleanup;
+            }
         }
-        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"... found, value discovered to be %s ...", value);
+
+        for (; mappedCount != 0; mappedCount--) {
+            if (views[mappedCount - 1] != NULL) {
+                UnmapViewOfFile(views[mappedCount - 1]);
+            }
+        }
+    }
+
+    cleanup:
+    for (; mappedCount != 0; mappedCount--) {
+        if (views[mappedCount - 1] != NULL) {
+            UnmapViewOfFile(views[mappedCount - 1]);
+        }
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_File_ReadFiles
+HRESULT INCALESCENT_File_ReadFiles(INCALESCENT_File_Session *session, const INCALESCENT_File_ReadContext *context, SIZE_T readCount) {
+    static const INCALESCENT_Pool_Callback readers[] = {INCALESCENT_File_ReadChunk, INCALESCENT_File_ReadChunkMapped};
+    HRESULT result = S_OK;
+    INCALESCENT_File_ReadContext remaining = *context;
+    SIZE_T sampleCount = INCALESCENT_FILE_CALIBRATION_FILES;
+    volatile LONG64 readDone = 0;
+
+    // A consolidation that reads its data files in several batches counts all of them together.
+    if (remaining.readDone == NULL) {
+        remaining.readDone = &readDone;
+        remaining.readTotal = readCount;
+    }
+
+    if (session->readMode == INCALESCENT_FILE_READ_MODE_AUTO && readCount >= ARRAYSIZE(readers) * sampleCount) {
+        LARGE_INTEGER frequency;
+        DOUBLE milliseconds[ARRAYSIZE(readers)];
+        QueryPerformanceFrequency(&frequency);
+
+        // The samples are split into small chunks, so they are read by as many workers as the rest.
+        for (DWORD reader = 0; reader < ARRAYSIZE(readers); reader++) {
+            LARGE_INTEGER start;
+            LARGE_INTEGER end;
+            QueryPerformanceCounter(&start);
+            result = INCALESCENT_Pool_Run(session->pool, sampleCount, INCALESCENT_FILE_MAP_BATCH, readers[reader], &remaining);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+            QueryPerformanceCounter(&end);
+            milliseconds[reader] = (DOUBLE) (end.QuadPart - start.QuadPart) * 1000.0 / (DOUBLE) frequency.QuadPart;
+            remaining.indices += sampleCount;
+            readCount -= sampleCount;
+        }
+
+        session->readMode = milliseconds[1] < milliseconds[0] ? INCALESCENT_FILE_READ_MODE_MAPPED : INCALESCENT_FILE_READ_MODE_OVERLAPPED;
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Read %d data files in %.1f ms overlapped and in %.1f ms mapped, reading the rest %s...",
+                                                  (INT) sampleCount, milliseconds[0], milliseconds[1],
+                                                  session->readMode == INCALESCENT_FILE_READ_MODE_MAPPED ? L"mapped" : L"overlapped");
         if (FAILED(result)) {
             goto cleanup;
         }
+    }
+
+    // Too few data files to tell the two apart are read overlapped, which is never far off.
+    INCALESCENT_Pool_Callback reader = session->readMode == INCALESCENT_FILE_READ_MODE_MAPPED ? INCALESCENT_File_ReadChunkMapped : INCALESCENT_File_ReadChunk;
+    result = INCALESCENT_Pool_Run(session->pool, readCount, INCALESCENT_POOL_DEFAULT_CHUNK_SIZE, reader, &remaining);
 
-        result = StringCchPrintfW(buffer, INCALESCENT_TABLE_ROW_LENGTH, L"%d,%s,%s\r\n", index, fileName, value);
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_File_WriteRow
+HRESULT INCALESCENT_File_WriteRow(INCALESCENT_Writer *writer, SIZE_T index, PWSTR directory, SIZE_T directoryLength,
+                                  PWSTR fileName, SIZE_T fileNameLength, const INCALESCENT_File_Value *values, DWORD fieldCount) {
+    SIZE_T valueLengths[INCALESCENT_FILE_MAX_FIELDS];
+
+    // A comma after the index and the directory, one in front of every value and 2 new-line characters.
+    SIZE_T length = INCALESCENT_WRITER_UNSIGNED_MAX_DIGITS + 1 + directoryLength + 1 + fileNameLength + 2;
+    for (DWORD field = 0; field < fieldCount; field++) {
+        valueLengths[field] = lstrlenW(values[field]);
+        length += 1 + valueLengths[field];
+    }
+
+    HRESULT result = INCALESCENT_Writer_Reserve(writer, INCALESCENT_WRITER_MAX_BYTES_PER_UNIT * length);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    INCALESCENT_Writer_AppendUnsigned(writer, index);
+    INCALESCENT_Writer_AppendAscii(writer, ",", 1);
+    if (directory != NULL) {
+        INCALESCENT_Writer_AppendString(writer, directory, directoryLength);
+        INCALESCENT_Writer_AppendAscii(writer, ",", 1);
+    }
+    INCALESCENT_Writer_AppendString(writer, fileName, fileNameLength);
+    for (DWORD field = 0; field < fieldCount; field++) {
+        INCALESCENT_Writer_AppendAscii(writer, ",", 1);
+        INCALESCENT_Writer_AppendString(writer, values[field], valueLengths[field]);
+    }
+    INCALESCENT_Writer_AppendAscii(writer, "\r\n", 2);
+    return S_OK;
+}
+
+// Compiles the keys of the fields to extract into the automaton every data file is scanned with.
+// A field's key is its name in UTF-8 followed by the separator. Without any fields given, only the
+// temperature is extracted.
+static HRESULT INCALESCENT_File_CompileFields(INCALESCENT_File_Session *session) {
+    HRESULT result = S_OK;
+    const INCALESCENT_File_Options *options = &session->options;
+    const BYTE *keys[INCALESCENT_FILE_MAX_FIELDS];
+    SIZE_T keyLengths[INCALESCENT_FILE_MAX_FIELDS];
+    PBYTE buffer = NULL;
+
+    if (options->fieldCount == 0) {
+        session->fieldCount = 1;
+        session->columns[0] = INCALESCENT_FILE_TEMPERATURE_COLUMN_NAME;
+        session->keys = (const BYTE *) INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING;
+        session->keysSize = INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING_LENGTH;
+        keys[0] = session->keys;
+        keyLengths[0] = session->keysSize;
+    } else {
+        // A UTF-16 unit never takes more than 3 bytes in UTF-8.
+        SIZE_T bufferSize = options->fieldCount * ((INCALESCENT_FILE_FIELD_NAME_MAX_LENGTH * 3) + 1);
+        result = INCALESCENT_Arena_Allocate(&session->arena, bufferSize, 1, (PVOID *) &buffer);
         if (FAILED(result)) {
             goto cleanup;
         }
 
-        SIZE_T charactersWritten;
-        result = StringCchLengthW(buffer, INCALESCENT_TABLE_ROW_LENGTH, &charactersWritten);
+        SIZE_T used = 0;
+        session->fieldCount = options->fieldCount;
+        for (DWORD field = 0; field < options->fieldCount; field++) {
+            session->columns[field] = options->fields[field];
+            INT byteCount = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, options->fields[field], lstrlenW(options->fields[field]),
+                                                (LPSTR) buffer + used, (INT) (bufferSize - used - 1), NULL, NULL);
+            if (byteCount == 0) {
+                result = HRESULT_FROM_WIN32(GetLastError());
+                goto cleanup;
+            }
+            keys[field] = buffer + used;
+            keyLengths[field] = byteCount + 1;
+            buffer[used + byteCount] = INCALESCENT_FILE_FIELD_SEPARATOR;
+            used += keyLengths[field];
+        }
+        session->keys = buffer;
+        session->keysSize = used;
+    }
+
+    result = INCALESCENT_Match_Create(keys, keyLengths, session->fieldCount, &session->arena, &session->match);
+
+    cleanup:
+    return result;
+}
+
+// The size of the reservation of a run's arena. Everything in it is needed at once, so a run that
+// takes more than the machine's memory wouldn't get anywhere anyway, and reserving less leaves the
+// address space to the other arenas where it is limited.
+static SIZE_T INCALESCENT_File_RunArenaReserve(void) {
+    SIZE_T reserve = INCALESCENT_FILE_RUN_ARENA_RESERVE;
+    MEMORYSTATUSEX status = {.dwLength = sizeof(MEMORYSTATUSEX)};
+    if (GlobalMemoryStatusEx(&status)) {
+        if (status.ullTotalPhys < reserve) {
+            reserve = status.ullTotalPhys;
+        }
+        if (status.ullAvailVirtual / 2 < reserve) {
+            reserve = status.ullAvailVirtual / 2;
+        }
+    }
+    return reserve;
+}
+
+// Implementation for INCALESCENT_File_CreateSession
+HRESULT INCALESCENT_File_CreateSession(const INCALESCENT_File_Options *options, INCALESCENT_File_Session *session) {
+    HRESULT result = S_OK;
+
+    ZeroMemory(session, sizeof(INCALESCENT_File_Session));
+    session->options = *options;
+    session->readMode = options->readMode;
+    session->suffix = INCALESCENT_FILE_FILTER_SUFFIX;
+    if (options->source == INCALESCENT_FILE_SOURCE_TIFF) {
+        session->readMode = INCALESCENT_FILE_READ_MODE_MAPPED;
+        session->suffix = INCALESCENT_FILE_TIFF_SUFFIX;
+    }
+
+    result = INCALESCENT_Pool_Create(options->workerCount, &session->pool);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Using %d workers...", INCALESCENT_Pool_WorkerCount(session->pool));
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // Everything that lives for the whole run comes out of one arena, and every worker gets a
+    // scratch arena of its own for the memory it needs while reading a single file.
+    result = INCALESCENT_Arena_Create(&session->arena, INCALESCENT_File_RunArenaReserve());
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&session->arena, sizeof(INCALESCENT_Arena) * INCALESCENT_Pool_WorkerCount(session->pool),
+                                        INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &session->scratch);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&session->arena, sizeof(INCALESCENT_Io *) * INCALESCENT_Pool_WorkerCount(session->pool),
+                                        INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &session->io);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    for (; session->scratchCount < INCALESCENT_Pool_WorkerCount(session->pool); session->scratchCount++) {
+        DWORD index = session->scratchCount;
+        session->io[index] = NULL;
+        result = INCALESCENT_Arena_Create(&session->scratch[index], INCALESCENT_FILE_SCRATCH_ARENA_RESERVE);
         if (FAILED(result)) {
             goto cleanup;
         }
 
-        writeResult = WriteFile(file, buffer, sizeof(WCHAR) * charactersWritten, &writeCount, NULL);
-        if (!writeResult) {
-            result = HRESULT_FROM_WIN32(GetLastError());
+        // Each worker drives an I/O engine of its own, which lives at the bottom of its scratch arena.
+        result = INCALESCENT_Io_Create(&session->scratch[index], INCALESCENT_FILE_IO_DEPTH, INCALESCENT_FILE_READ_CHUNK_SIZE,
+                                       &session->io[index]);
+        if (FAILED(result)) {
+            session->scratchCount++;
             goto cleanup;
         }
     }
 
+    result = INCALESCENT_File_CreateNames(&session->names, &session->arena);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_NamePool_Create(&session->namePool);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_File_CompileFields(session);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // Everything allocated from here on belongs to a single directory.
+    session->arenaMark = INCALESCENT_Arena_Mark(&session->arena);
+
     cleanup:
-    if (names != NULL) {
-        HeapFree(heap, 0, names);
+    if (FAILED(result)) {
+        INCALESCENT_File_DestroySession(session);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_File_DestroySession
+void INCALESCENT_File_DestroySession(INCALESCENT_File_Session *session) {
+    if (session->pool != NULL) {
+        INCALESCENT_Pool_Destroy(session->pool);
+    }
+    INCALESCENT_File_FreeNames(&session->names);
+    INCALESCENT_NamePool_Destroy(&session->namePool);
+    for (DWORD index = 0; index < session->scratchCount; index++) {
+        INCALESCENT_Io_Destroy(session->io[index]);
+        INCALESCENT_Arena_Destroy(&session->scratch[index]);
+    }
+    INCALESCENT_Arena_Destroy(&session->arena);
+    ZeroMemory(session, sizeof(INCALESCENT_File_Session));
+}
+
+// Implementation for INCALESCENT_File_Consolidate
+HRESULT INCALESCENT_File_Consolidate(INCALESCENT_File_Session *session, PWSTR dataDirectory, PWSTR consolidatedFile) {
+    HRESULT result = S_OK;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    const INCALESCENT_File_Options *options = &session->options;
+
+    // Only a single directory can be watched, and only a CSV table can grow. A table compressed
+    // into a gzip stream is only complete once it ends, and a columnar table is meant to be mapped
+    // as it is, so only a CSV table can be compressed and then it can't grow.
+    if (options->watch && (options->recursive || options->format != INCALESCENT_FILE_FORMAT_CSV)) {
+        result = E_INVALIDARG;
+        goto cleanup;
     }
-    if (file != NULL) {
+    if (INCALESCENT_Table_IsCompressed(consolidatedFile) && (options->watch || options->format != INCALESCENT_FILE_FORMAT_CSV)) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    // A memory budget only holds when the table can be written as the names come out of the runs,
+    // so nothing may need all of them at once.
+    if (options->memoryBudget != 0 && (options->memoryBudget < INCALESCENT_FILE_MIN_MEMORY_BUDGET || options->cache || options->recursive ||
+                                       options->watch || options->format != INCALESCENT_FILE_FORMAT_CSV)) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    // A data directory may also be an archive, which can't be watched, and whose members are all
+    // listed up front, so it can't be kept within a memory budget. Its images are only ever in
+    // memory a piece at a time, so their tags can't be read either.
+    INCALESCENT_Archive_Kind archive = INCALESCENT_ARCHIVE_KIND_NONE;
+    DWORD attributes = GetFileAttributesW(dataDirectory);
+    if (attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        archive = INCALESCENT_Archive_KindOf(dataDirectory);
+    }
+    if (archive != INCALESCENT_ARCHIVE_KIND_NONE && (options->watch || options->source == INCALESCENT_FILE_SOURCE_TIFF || options->memoryBudget != 0)) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    file = CreateFileW(consolidatedFile, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    if (archive != INCALESCENT_ARCHIVE_KIND_NONE) {
+        result = INCALESCENT_Archived_Consolidate(session, archive, dataDirectory, consolidatedFile, file);
+    } else if (options->recursive) {
+        result = INCALESCENT_Tree_Consolidate(session, dataDirectory, consolidatedFile, file);
+    } else if (options->memoryBudget != 0) {
+        result = INCALESCENT_Bounded_Consolidate(session, dataDirectory, consolidatedFile, file);
+    } else {
+        result = INCALESCENT_Sorted_Consolidate(session, dataDirectory, consolidatedFile, file);
+    }
+
+    cleanup:
+    // Hand everything this directory used back to the session for the next one.
+    INCALESCENT_File_ClearNames(&session->names);
+    INCALESCENT_NamePool_Clear(&session->namePool);
+    INCALESCENT_Arena_Reset(&session->arena, session->arenaMark);
+    if (file != INVALID_HANDLE_VALUE) {
         CloseHandle(file);
     }
     return result;
 }
+
+// Implementation for INCALESCENT_File_ReadAndWrite
+HRESULT INCALESCENT_File_ReadAndWrite(PWSTR dataDirectory, PWSTR consolidatedFile, const INCALESCENT_File_Options *options) {
+    INCALESCENT_File_Session session;
+
+    HRESULT result = INCALESCENT_File_CreateSession(options, &session);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_File_Consolidate(&session, dataDirectory, consolidatedFile);
+        INCALESCENT_File_DestroySession(&session);
+    }
+    return result;
+}
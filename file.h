@@ -24,33 +24,474 @@
 #ifndef INCALESCENT_FILE_H
 #define INCALESCENT_FILE_H
 #include "string.h"
+#include "namepool.h"
+#include "arena.h"
+#include "writer.h"
+#include "io.h"
+#include "match.h"
+#include "stats.h"
+#include "cache.h"
+#include "platform.h"
 
 // Forward declarations from <windows.h>
-typedef long HRESULT;
 typedef unsigned short WCHAR;
 typedef WCHAR* PWSTR;
+typedef unsigned char BYTE;
 typedef unsigned char* PBYTE;
+typedef unsigned __int64 SIZE_T;
 typedef unsigned __int64* PSIZE_T;
+typedef int BOOL;
+typedef unsigned __int64 ULONGLONG;
+typedef void* HANDLE;
+typedef double DOUBLE;
+typedef const WCHAR* PCWSTR;
+typedef __int64 LONG64;
+typedef void* PVOID;
 
 #define INCALESCENT_FILE_MAX_PATH 260
-#define INCALESCENT_FILE_FILTER L"\\*.tif.metadata"
+#define INCALESCENT_FILE_FILTER_PATTERN L"\\*"
+#define INCALESCENT_FILE_FILTER_SUFFIX L".tif.metadata"
+#define INCALESCENT_FILE_FILTER_SUFFIX_LENGTH INCALESCENT_STRING_LENGTH(INCALESCENT_FILE_FILTER_SUFFIX)
+#define INCALESCENT_FILE_TIFF_SUFFIX L".tif"
 #define INCALESCENT_FILE_FILTER_AGGREGATE_SIZE ((INCALESCENT_FILE_MAX_PATH * 2) + 2)
 
-#define INCALESCENT_FILE_TEMPERATURE_FIELD_VALUE_MAX_LENGTH 16
-#define INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING L"userComment4="
+#define INCALESCENT_FILE_NAME_INDEX_RESERVE (4ULL * 1024 * 1024 * 1024)
+// The most address space the arena of a run reserves. It holds the values of every data file at
+// once, so it never reserves more than the machine's memory, nor more than half of the address
+// space the process has left.
+#define INCALESCENT_FILE_RUN_ARENA_RESERVE (32ULL * 1024 * 1024 * 1024)
+#define INCALESCENT_FILE_SCRATCH_ARENA_RESERVE (64ULL * 1024 * 1024)
+
+// The smallest memory budget. Below it, the runs would be too short to be worth merging.
+#define INCALESCENT_FILE_MIN_MEMORY_BUDGET (16ULL * 1024 * 1024)
+
+// The number of reads each worker keeps in flight.
+#define INCALESCENT_FILE_IO_DEPTH 32
+
+// The number of directories listed at once when consolidating a tree. Listing waits on the file
+// system rather than the processor, so this doesn't depend on the processor count.
+#define INCALESCENT_FILE_WALK_WORKERS 8
+
+// The most fields that can be extracted at once, and the longest field name and value including
+// their null-terminating characters.
+#define INCALESCENT_FILE_MAX_FIELDS 16
+#define INCALESCENT_FILE_FIELD_NAME_MAX_LENGTH 64
+#define INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH 32
+#define INCALESCENT_FILE_FIELD_SEPARATOR '='
+
+// The field extracted when no fields are given, and the column it goes into.
+#define INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING "userComment4="
 #define INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING_LENGTH INCALESCENT_STRING_LENGTH(INCALESCENT_FILE_TEMPERATURE_FIELD_KEY_STRING)
+#define INCALESCENT_FILE_TEMPERATURE_COLUMN_NAME L"Temperature"
+
+// Data files are read this many bytes at a time, until every field has been found. Most data files
+// have all their fields within the first read.
+#define INCALESCENT_FILE_READ_CHUNK_SIZE 1024
+
+// Where the fields were found in the last data file is remembered at this granularity, so the next
+// one can start reading right there.
+#define INCALESCENT_FILE_READ_HINT_ALIGNMENT 512
+
+// The number of data files a worker maps at once when reading them mapped, so their pages can be
+// prefetched with a single call.
+#define INCALESCENT_FILE_MAP_BATCH 16
+
+// The number of data files read each way to pick the faster way to read the rest.
+#define INCALESCENT_FILE_CALIBRATION_FILES 64
+
+// The values of a data file's fields joined into one string, as the cache keeps them. No value
+// can contain a new-line character, so it separates them.
+#define INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH (INCALESCENT_FILE_MAX_FIELDS * INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH)
+#define INCALESCENT_FILE_CACHE_VALUE_SEPARATOR L'\n'
+
+// The value of a single field. A data file's values are stored one after another, in the order of
+// the fields.
+typedef WCHAR INCALESCENT_File_Value[INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH];
+
+// The fields found so far in a data file that is read a chunk at a time. The values are collected
+// as raw bytes, since a value may be split across chunks, and are only transcoded once all of them
+// are complete.
+typedef struct INCALESCENT_File_Extraction {
+    INCALESCENT_Match_Stream stream;
+
+    // The offset in the file of the next chunk, and of the first one.
+    ULONGLONG offset;
+    ULONGLONG origin;
+
+    // The keys whose values are still being collected, and the ones whose values are complete.
+    DWORD open;
+    DWORD complete;
+
+    // Where the first key starts and the last value ends, counting its line break.
+    ULONGLONG fieldsStart;
+    ULONGLONG fieldsEnd;
+
+    BYTE raw[INCALESCENT_FILE_MAX_FIELDS][INCALESCENT_FILE_FIELD_VALUE_MAX_LENGTH];
+    BYTE rawLengths[INCALESCENT_FILE_MAX_FIELDS];
+} INCALESCENT_File_Extraction;
+
+// What the enumeration learned about a data file, stored directly in front of its name.
+typedef struct INCALESCENT_File_NameInfo {
+    ULONGLONG size;
+    ULONGLONG lastWriteTime;
+    SIZE_T length;
+} INCALESCENT_File_NameInfo;
+
+#define INCALESCENT_FILE_NAME_INFO(name) (((INCALESCENT_File_NameInfo *) (name)) - 1)
+
+typedef struct INCALESCENT_File_Names INCALESCENT_File_Names;
+
+// Makes room in a list of names that has grown past its budget, by moving its names elsewhere and
+// clearing it.
+typedef HRESULT (*INCALESCENT_File_SpillCallback)(PVOID context, INCALESCENT_File_Names *names);
+
+// The names of the data files found in a directory. The strings are copied into the run arena,
+// each behind its INCALESCENT_File_NameInfo, while the entry array gets an arena of its own so it
+// stays contiguous as it grows during the single enumeration pass.
+struct INCALESCENT_File_Names {
+    PWSTR *entries;
+    SIZE_T count;
+    INCALESCENT_Arena *arena;
+    INCALESCENT_Arena index;
+
+    // Called before a name would take the list past budget bytes, counting both arenas and sortSize,
+    // the memory sorting the names takes, or NULL to keep every name.
+    INCALESCENT_File_SpillCallback spill;
+    PVOID spillContext;
+    SIZE_T budget;
+    SIZE_T sortSize;
+};
+
+typedef enum INCALESCENT_File_Format {
+    // A CSV table of the values as they are written in the data files.
+    INCALESCENT_FILE_FORMAT_CSV = 0,
+
+    // A binary table of columns that can be memory-mapped and used without any parsing, with every
+    // field parsed into a number (see columnar.h).
+    INCALESCENT_FILE_FORMAT_COLUMNAR = 1,
+} INCALESCENT_File_Format;
+
+typedef enum INCALESCENT_File_Source {
+    // A metadata file next to every image, which holds the fields as lines of text.
+    INCALESCENT_FILE_SOURCE_METADATA = 0,
+
+    // The text tags of every image itself, for instruments that don't write metadata files (see
+    // tiff.h). Images are always read mapped, since their tags can be anywhere in the file.
+    INCALESCENT_FILE_SOURCE_TIFF = 1,
+} INCALESCENT_File_Source;
+
+typedef enum INCALESCENT_File_ReadMode {
+    // Times both ways on the first data files of a session and keeps the faster one.
+    INCALESCENT_FILE_READ_MODE_AUTO = 0,
+
+    // Overlapped reads of a chunk at a time into buffers of the I/O engine. Usually the faster way
+    // on network shares, where every page fault of a mapped file is a round trip of its own.
+    INCALESCENT_FILE_READ_MODE_OVERLAPPED = 1,
+
+    // Every data file is mapped into memory and scanned in place, without any copies. Usually the
+    // faster way on local drives.
+    INCALESCENT_FILE_READ_MODE_MAPPED = 2,
+} INCALESCENT_File_ReadMode;
+
+typedef struct INCALESCENT_File_Options {
+    // The number of workers reading data files concurrently. Zero uses one worker per
+    // active logical processor.
+    DWORD workerCount;
+
+    // The format of the consolidated table, and the encoding of a CSV table.
+    INCALESCENT_File_Format format;
+    INCALESCENT_Writer_Encoding encoding;
+
+    // Where the fields are read from, and how data files are read.
+    INCALESCENT_File_Source source;
+    INCALESCENT_File_ReadMode readMode;
+
+    // The names of the fields to extract from every data file, each of which becomes a column of
+    // the table. Without any, only the temperature is extracted.
+    WCHAR fields[INCALESCENT_FILE_MAX_FIELDS][INCALESCENT_FILE_FIELD_NAME_MAX_LENGTH];
+    DWORD fieldCount;
+
+    // Whether to keep the values of unchanged data files in a cache next to the consolidated
+    // table, so that a re-run only reads the data files that are new or were modified.
+    BOOL cache;
+
+    // Whether to consolidate the data files of every directory below the data directory as well,
+    // adding a column with each file's directory relative to the data directory.
+    BOOL recursive;
+
+    // Whether to compute the count, extremes, mean, standard deviation and quantiles of every
+    // column while the data files are read, and write them next to the consolidated table.
+    BOOL statistics;
+
+    // Whether to write downsampled copies of the table next to it, with the minimum, maximum and
+    // mean of every field over every 10, 100 and 1000 rows (see pyramid.h).
+    BOOL pyramid;
+
+    // The most memory the names of a directory may take, in bytes, or zero to keep all of them in
+    // memory. With a budget, the names are sorted in runs that are spilled to a temporary file
+    // and merged back while the data files are read and the table is written, so a directory of any
+    // size takes the same memory. It can't be combined with the cache, recursion, watching,
+    // archives or a columnar table, which all need every name or row at once.
+    SIZE_T memoryBudget;
+
+    // Whether to keep watching the data directory after the table has been written, appending a
+    // row for every new data file until stopEvent is signaled. The pyramid, the statistics and the
+    // cache are only written once the watch has stopped.
+    BOOL watch;
+    HANDLE stopEvent;
+} INCALESCENT_File_Options;
+
+// The workers, I/O engines and memory of a consolidation. A session consolidates any number of
+// directories one after another, reusing all of them.
+typedef struct INCALESCENT_File_Session {
+    INCALESCENT_File_Options options;
+    INCALESCENT_Pool *pool;
+    INCALESCENT_Arena arena;
+    SIZE_T arenaMark;
+    INCALESCENT_Arena *scratch;
+    DWORD scratchCount;
+    INCALESCENT_Io **io;
+    INCALESCENT_File_Names names;
+
+    // The names of a single directory, kept compact for sorting and reading them in order.
+    INCALESCENT_NamePool namePool;
+
+    // The suffix of the data files of the session's source.
+    PCWSTR suffix;
+
+    // The keys of all the fields compiled into one automaton, so every data file is only scanned
+    // once no matter how many fields are extracted, and the table's column names.
+    INCALESCENT_Match *match;
+    DWORD fieldCount;
+    PCWSTR columns[INCALESCENT_FILE_MAX_FIELDS];
+
+    // The keys one after another, which tells the cache whether its values are of the same fields.
+    const BYTE *keys;
+    SIZE_T keysSize;
+
+    // The offset the fields were last found at, rounded down to INCALESCENT_FILE_READ_HINT_ALIGNMENT.
+    // Data files written by the same software keep their fields in the same place, so reading
+    // from there usually finds all of them with a single read.
+    volatile LONG64 readHint;
+
+    // The memory the consolidations of the session have taken at their peak, as last logged.
+    ULONGLONG memoryPeak;
+
+    // How data files are read, which stays INCALESCENT_FILE_READ_MODE_AUTO until a consolidation
+    // has read enough data files to time both ways.
+    INCALESCENT_File_ReadMode readMode;
+} INCALESCENT_File_Session;
+
+// The data files a consolidation reads in parallel, and where their values go.
+typedef struct INCALESCENT_File_ReadContext {
+    PWSTR dataDirectory;
+    PWSTR *names;
+
+    // The sorted pool the names come from instead, or NULL if they are in the list.
+    const INCALESCENT_NamePool *namePool;
+    INCALESCENT_File_Value *values;
+    const INCALESCENT_Match *match;
+    DWORD fieldCount;
+    INCALESCENT_Io **io;
+
+    // The values parsed into numbers, or NULL if the table doesn't need them.
+    DOUBLE *numbers;
+
+    // The statistics of every column, a set of them for each worker, or NULL if they aren't kept.
+    INCALESCENT_Stats *statistics;
+
+    // The offset the fields were found at in the files read so far, where every read starts.
+    volatile LONG64 *hint;
 
-#define INCALESCENT_FILE_TEMPERATURE_RAW_BUFFER_SIZE 1024
-#define INCALESCENT_FILE_TEMPERATURE_CHARACTER_BUFFER_MAX_LENGTH 2048
+    // The number of data files read so far, out of how many, for the progress lines. A NULL
+    // counter counts the data files of a single call only.
+    volatile LONG64 *readDone;
+    SIZE_T readTotal;
 
-// 2 commas, 2 new-line characters, 1 for null-terminating character
-#define INCALESCENT_TABLE_CONTROL_CHARACTER_COUNT 5
-#define INCALESCENT_TABLE_HEADER_STRING L"Index,File,Temperature\r\n"
-#define INCALESCENT_TABLE_HEADER_STRING_LENGTH INCALESCENT_STRING_LENGTH(INCALESCENT_TABLE_HEADER_STRING)
-#define INCALESCENT_TABLE_ROW_LENGTH (INCALESCENT_TABLE_CONTROL_CHARACTER_COUNT + INCALESCENT_FILE_TEMPERATURE_FIELD_VALUE_MAX_LENGTH + INCALESCENT_FILE_FILTER_AGGREGATE_SIZE)
+    // The indices of the data files that have to be read. Files whose value came from the cache
+    // are left out.
+    SIZE_T *indices;
+
+    // Whether the data files are TIFF images whose tags hold the fields.
+    BOOL tiff;
+
+    // The failure of every data file that was still being written, by index, or NULL if those end
+    // the read like any other failure. The failures have to start out as S_OK.
+    HRESULT *failures;
+} INCALESCENT_File_ReadContext;
+
+/**
+ * @brief Extracts the values of several fields from the raw bytes of a data file in one pass.
+ *
+ * A field's value runs from right after its key to the end of its line.
+ *
+ * @param[in] match     The keys of the fields, compiled.
+ * @param[in] data      The bytes of the data file.
+ * @param[in] size      The number of bytes.
+ * @param[out] values   Receives the value of every field, in the order of the keys.
+ * @param[out] numbers  Receives every value parsed into a number, or NaN for a value that isn't a
+ *                      number. May be NULL if the numbers aren't needed.
+ *
+ * @return S_OK if successful, INCALESCENT_ERROR_FIELD_VALUE_NOT_FOUND if any of the fields is
+ *         missing or cut off, or INCALESCENT_ERROR_FIELD_VALUE_TOO_LARGE if a value doesn't fit.
+ */
+HRESULT INCALESCENT_File_ExtractFields(const INCALESCENT_Match *match, const BYTE *data, SIZE_T size, INCALESCENT_File_Value *values,
+                                      DOUBLE *numbers);
+
+// Starts extracting the fields of a data file whose first chunk is read from origin. The match must
+// have at most INCALESCENT_FILE_MAX_FIELDS keys.
+void INCALESCENT_File_BeginExtraction(const INCALESCENT_Match *match, INCALESCENT_File_Extraction *extraction, ULONGLONG origin);
+
+/**
+ * @brief Extracts the fields from the next chunk of a data file.
+ *
+ * A key or value that is split between two chunks is picked up where the previous chunk left off.
+ *
+ * @param[in] match             The keys of the fields, compiled.
+ * @param[in,out] extraction    The extraction, started with INCALESCENT_File_BeginExtraction.
+ * @param[in] data              The bytes of the chunk.
+ * @param[in] size              The number of bytes.
+ * @param[out] done             Receives whether every field's value is complete, so no further
+ *                              chunk is needed.
+ *
+ * @return S_OK if successful, or INCALESCENT_ERROR_FIELD_VALUE_TOO_LARGE if a value doesn't fit.
+ */
+HRESULT INCALESCENT_File_FeedExtraction(const INCALESCENT_Match *match, INCALESCENT_File_Extraction *extraction, const BYTE *data, SIZE_T size,
+                                        BOOL *done);
+
+/**
+ * @brief Finishes an extraction, transcoding the values that were collected.
+ *
+ * @param[in] match         The keys of the fields, compiled.
+ * @param[in] extraction    The extraction.
+ * @param[in] endOfFile     Whether the last chunk reached the end of the file, which ends a value
+ *                          that has no line break after it.
+ * @param[out] values       Receives the value of every field, in the order of the keys.
+ * @param[out] numbers      Receives every value parsed into a number, or NaN for a value that
+ *                          isn't a number. May be NULL if the numbers aren't needed.
+ *
+ * @return S_OK if successful, or INCALESCENT_ERROR_FIELD_VALUE_NOT_FOUND if any of the fields is
+ *         missing or cut off.
+ */
+HRESULT INCALESCENT_File_FinishExtraction(const INCALESCENT_Match *match, const INCALESCENT_File_Extraction *extraction, BOOL endOfFile,
+                                          INCALESCENT_File_Value *values, DOUBLE *numbers);
+
+/**
+ * @brief Formats one row of a CSV table, with a directory column first when directory isn't NULL.
+ *
+ * The row reserves the most space it can take up front, so it is formatted straight into the
+ * writer's buffer without any further checks.
+ *
+ * @return The result of making room for the row (S_OK if successful).
+ */
+HRESULT INCALESCENT_File_WriteRow(INCALESCENT_Writer *writer, SIZE_T index, PWSTR directory, SIZE_T directoryLength, PWSTR fileName,
+                                  SIZE_T fileNameLength, const INCALESCENT_File_Value *values, DWORD fieldCount);
+
+// Whether a data file failed to read because it is still being written, so that it may well be read
+// once it has settled.
+BOOL INCALESCENT_File_IsIncomplete(HRESULT result);
+
+// Reads a data file a chunk at a time until every field has been found.
+HRESULT INCALESCENT_File_ReadFields(PWSTR path, const INCALESCENT_Match *match, INCALESCENT_Arena *scratch, INCALESCENT_File_Value *values);
+
+// Reads the fields of a single TIFF image from its tags, mapping it so that only the pages of its
+// directories and text are read.
+HRESULT INCALESCENT_File_ReadTiffFields(PCWSTR path, const INCALESCENT_Match *match, INCALESCENT_File_Value *values);
+
+// Maps a whole file into memory for reading. An empty file can't be mapped, so it gets no view.
+HRESULT INCALESCENT_File_MapFile(PCWSTR path, const BYTE **view, SIZE_T *size);
+
+/**
+ * @brief Reads the fields of the data files listed in the context's index array in parallel.
+ *
+ * Until the session has decided how to read data files, the first ones are read each way and
+ * timed, and the faster way is kept for the rest of the session.
+ *
+ * @param[in,out] session   The session, whose workers read the data files.
+ * @param[in] context       The data files and where their values go.
+ * @param[in] readCount     The number of indices in the context.
+ *
+ * @return The result of the first read that failed (S_OK if successful).
+ */
+HRESULT INCALESCENT_File_ReadFiles(INCALESCENT_File_Session *session, const INCALESCENT_File_ReadContext *context, SIZE_T readCount);
+
+// Joins the values of a data file's fields into one string, with the separator between every two
+// of them. Returns the length of the string.
+SIZE_T INCALESCENT_File_JoinValues(const INCALESCENT_File_Value *values, DWORD fieldCount, WCHAR separator,
+                                   WCHAR joined[INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH]);
+
+// Takes the values of a data file from the cache if the file hasn't changed since they were recorded.
+BOOL INCALESCENT_File_LookupValues(const INCALESCENT_Cache *cache, PWSTR name, DWORD fieldCount, INCALESCENT_File_Value *values);
+
+// Records the values of a data file for the next run.
+HRESULT INCALESCENT_File_RecordValues(INCALESCENT_Cache *cache, PWSTR name, DWORD fieldCount, const INCALESCENT_File_Value *values);
+
+// Parses values that came from the cache into numbers. Numbers are plain ASCII, so a value with any
+// other character isn't one.
+void INCALESCENT_File_ParseValues(const INCALESCENT_File_Value *values, DWORD fieldCount, DOUBLE *numbers);
+
+// Adds the values of a data file to the statistics of their columns, parsing them first unless the
+// numbers are given.
+void INCALESCENT_File_AddStatistics(INCALESCENT_Stats *statistics, const INCALESCENT_File_Value *values, const DOUBLE *numbers, DWORD fieldCount);
+
+HRESULT INCALESCENT_File_CreateNames(INCALESCENT_File_Names *names, INCALESCENT_Arena *arena);
+/**
+ * @brief Appends the data files of a directory to a list of names, in the order they are found.
+ *
+ * @param[in] directory     The directory.
+ * @param[in] suffix        The suffix of the data files. Files without it are skipped.
+ * @param[in] details       Whether the size and last write time of every data file are needed.
+ *                          Without them, both are zero.
+ * @param[in,out] names     The list the data files are appended to.
+ * @param[in,out] directories   The list the subdirectories are appended to, or NULL to skip them.
+ *                              Reparse points are skipped either way.
+ *
+ * @return The result of the enumeration (S_OK if successful).
+ */
+HRESULT INCALESCENT_File_Enumerate(PWSTR directory, PCWSTR suffix, BOOL details, INCALESCENT_File_Names *names, INCALESCENT_File_Names *directories);
+/**
+ * @brief Appends the data files of a directory to a name pool and sorts it.
+ *
+ * @param[in] directory     The directory.
+ * @param[in] suffix        The suffix of the data files. Files without it are skipped.
+ * @param[in] details       Whether the size and last write time of every data file are needed.
+ *                          Without them, both are zero.
+ * @param[in,out] names     The pool the data files are appended to. Its order array holds them sorted.
+ * @param[in] arena         The arena the sort takes its temporary memory from.
+ * @param[in] pool          The pool the sort keys are computed on, or NULL to do it on this thread.
+ *
+ * @return The result of the enumeration or the sort (S_OK if successful).
+ */
+HRESULT INCALESCENT_File_FilteredNamesSorted(PWSTR directory, PCWSTR suffix, BOOL details, INCALESCENT_NamePool *names, INCALESCENT_Arena *arena, INCALESCENT_Pool *pool);
+void INCALESCENT_File_ClearNames(INCALESCENT_File_Names *names);
+void INCALESCENT_File_FreeNames(INCALESCENT_File_Names *names);
+
+/**
+ * @brief Starts the workers and reserves the memory for consolidating directories.
+ *
+ * @param[in] options       The options every consolidation of the session uses.
+ * @param[out] session      The session to initialize. It must be released with INCALESCENT_File_DestroySession.
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_File_CreateSession(const INCALESCENT_File_Options *options, INCALESCENT_File_Session *session);
+
+/**
+ * @brief Consolidates the fields of a directory's data files into a table.
+ *
+ * All the memory the consolidation takes is handed back to the session afterward, so consolidating
+ * many directories in a row only ever needs as much as the largest of them.
+ *
+ * @param[in] session           The session.
+ * @param[in] dataDirectory     The directory holding the data files, or a zip, tar or gzip-compressed
+ *                              tar archive of them, which is read without extracting it.
+ * @param[in] consolidatedFile  The table to write. An existing file is replaced.
+ *
+ * @return The result of the consolidation (S_OK if successful).
+ */
+HRESULT INCALESCENT_File_Consolidate(INCALESCENT_File_Session *session, PWSTR dataDirectory, PWSTR consolidatedFile);
 
-HRESULT INCALESCENT_File_ReadTemperature(PWSTR path, WCHAR value[INCALESCENT_FILE_TEMPERATURE_FIELD_VALUE_MAX_LENGTH]);
-HRESULT INCALESCENT_File_FilteredNamesSorted(PWSTR directory, PBYTE nameAllocation, PSIZE_T nameAllocationSize, PSIZE_T fileCount);
-HRESULT INCALESCENT_File_ReadAndWrite(PWSTR dataDirectory, PWSTR consolidatedFile);
+void INCALESCENT_File_DestroySession(INCALESCENT_File_Session *session);
+HRESULT INCALESCENT_File_ReadAndWrite(PWSTR dataDirectory, PWSTR consolidatedFile, const INCALESCENT_File_Options *options);
 
 #endif //INCALESCENT_FILE_H
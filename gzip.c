@@ -0,0 +1,202 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "gzip.h"
+#include "deflate.h"
+#include "crc.h"
+
+struct INCALESCENT_Gzip {
+    HANDLE file;
+    HANDLE thread;
+    INCALESCENT_Arena arena;
+    INCALESCENT_Deflate deflate;
+
+    // The CRC-32 of the data so far and its size, both kept by the thread.
+    DWORD crc;
+    DWORD inputSize;
+
+    SRWLOCK lock;
+    CONDITION_VARIABLE posted;
+    CONDITION_VARIABLE done;
+
+    // The block handed to the thread, which is busy until it has been written.
+    const BYTE *block;
+    SIZE_T blockSize;
+    BOOL final;
+    BOOL busy;
+    BOOL shutdown;
+    HRESULT result;
+};
+
+static HRESULT INCALESCENT_Gzip_WriteFile(PVOID context, const BYTE *data, SIZE_T size) {
+    INCALESCENT_Gzip *gzip = context;
+    DWORD writeCount = 0;
+    if (!WriteFile(gzip->file, data, (DWORD) size, &writeCount, NULL)) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    if (writeCount != size) {
+        return HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+    }
+    return S_OK;
+}
+
+static DWORD WINAPI INCALESCENT_Gzip_ThreadStart(LPVOID parameter) {
+    INCALESCENT_Gzip *gzip = parameter;
+
+    AcquireSRWLockExclusive(&gzip->lock);
+    for (;;) {
+        while (!gzip->busy && !gzip->shutdown) {
+            SleepConditionVariableSRW(&gzip->posted, &gzip->lock, INFINITE, 0);
+        }
+        if (!gzip->busy) {
+            break;
+        }
+
+        // Once the stream has failed, blocks are only taken so that nobody waits on them forever.
+        const BYTE *block = gzip->block;
+        SIZE_T blockSize = gzip->blockSize;
+        BOOL final = gzip->final;
+        HRESULT result = gzip->result;
+        ReleaseSRWLockExclusive(&gzip->lock);
+
+        if (SUCCEEDED(result)) {
+            gzip->crc = INCALESCENT_Crc_Update(gzip->crc, block, blockSize);
+            gzip->inputSize += (DWORD) blockSize;
+            result = INCALESCENT_Deflate_Compress(&gzip->deflate, block, blockSize, final);
+        }
+
+        AcquireSRWLockExclusive(&gzip->lock);
+        gzip->result = result;
+        gzip->busy = FALSE;
+        WakeAllConditionVariable(&gzip->done);
+    }
+    ReleaseSRWLockExclusive(&gzip->lock);
+
+    return 0;
+}
+
+// Implementation for INCALESCENT_Gzip_Create
+HRESULT INCALESCENT_Gzip_Create(HANDLE file, SIZE_T maxBlock, INCALESCENT_Gzip **gzip) {
+    static const BYTE header[] = INCALESCENT_GZIP_HEADER;
+    HRESULT result = S_OK;
+
+    INCALESCENT_Gzip *intermediate = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(INCALESCENT_Gzip));
+    if (intermediate == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+    intermediate->file = file;
+    InitializeSRWLock(&intermediate->lock);
+    InitializeConditionVariable(&intermediate->posted);
+    InitializeConditionVariable(&intermediate->done);
+
+    result = INCALESCENT_Arena_Create(&intermediate->arena, INCALESCENT_GZIP_ARENA_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Deflate_Create(&intermediate->deflate, maxBlock, &intermediate->arena, INCALESCENT_Gzip_WriteFile, intermediate);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Gzip_WriteFile(intermediate, header, sizeof(header));
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    intermediate->thread = CreateThread(NULL, 0, INCALESCENT_Gzip_ThreadStart, intermediate, 0, NULL);
+    if (intermediate->thread == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    *gzip = intermediate;
+    intermediate = NULL;
+
+    cleanup:
+    INCALESCENT_Gzip_Destroy(intermediate);
+    return result;
+}
+
+// Waits for the thread to be done with the previous block and hands it the next one.
+static HRESULT INCALESCENT_Gzip_Post(INCALESCENT_Gzip *gzip, const BYTE *block, SIZE_T size, BOOL final) {
+    AcquireSRWLockExclusive(&gzip->lock);
+    while (gzip->busy) {
+        SleepConditionVariableSRW(&gzip->done, &gzip->lock, INFINITE, 0);
+    }
+    HRESULT result = gzip->result;
+    if (SUCCEEDED(result)) {
+        gzip->block = block;
+        gzip->blockSize = size;
+        gzip->final = final;
+        gzip->busy = TRUE;
+        WakeAllConditionVariable(&gzip->posted);
+    }
+    ReleaseSRWLockExclusive(&gzip->lock);
+
+    return result;
+}
+
+// Implementation for INCALESCENT_Gzip_Write
+HRESULT INCALESCENT_Gzip_Write(INCALESCENT_Gzip *gzip, const BYTE *block, SIZE_T size) {
+    return INCALESCENT_Gzip_Post(gzip, block, size, FALSE);
+}
+
+// Implementation for INCALESCENT_Gzip_Finish
+HRESULT INCALESCENT_Gzip_Finish(INCALESCENT_Gzip *gzip) {
+    HRESULT result = INCALESCENT_Gzip_Post(gzip, NULL, 0, TRUE);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    AcquireSRWLockExclusive(&gzip->lock);
+    while (gzip->busy) {
+        SleepConditionVariableSRW(&gzip->done, &gzip->lock, INFINITE, 0);
+    }
+    result = gzip->result;
+    ReleaseSRWLockExclusive(&gzip->lock);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    DWORD trailer[2] = {gzip->crc, gzip->inputSize};
+    return INCALESCENT_Gzip_WriteFile(gzip, (const BYTE *) trailer, sizeof(trailer));
+}
+
+// Implementation for INCALESCENT_Gzip_Destroy
+void INCALESCENT_Gzip_Destroy(INCALESCENT_Gzip *gzip) {
+    if (gzip == NULL) {
+        return;
+    }
+
+    if (gzip->thread != NULL) {
+        AcquireSRWLockExclusive(&gzip->lock);
+        gzip->shutdown = TRUE;
+        WakeAllConditionVariable(&gzip->posted);
+        ReleaseSRWLockExclusive(&gzip->lock);
+        WaitForSingleObject(gzip->thread, INFINITE);
+        CloseHandle(gzip->thread);
+    }
+    INCALESCENT_Arena_Destroy(&gzip->arena);
+    HeapFree(GetProcessHeap(), 0, gzip);
+}
@@ -0,0 +1,75 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_GZIP_H
+#define INCALESCENT_GZIP_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* HANDLE;
+typedef unsigned char BYTE;
+typedef unsigned short WCHAR;
+typedef const WCHAR* PCWSTR;
+typedef unsigned __int64 SIZE_T;
+
+// Files with this extension are written as gzip streams.
+#define INCALESCENT_GZIP_EXTENSION L".gz"
+
+#define INCALESCENT_GZIP_ARENA_RESERVE (64ULL * 1024 * 1024)
+
+// The fixed part of the gzip header (RFC 1952): the magic, the deflate method, no flags, no
+// modification time, no extra flags, and NTFS as the operating system. The trailer is the CRC-32
+// of the data and its size modulo 2^32.
+#define INCALESCENT_GZIP_HEADER {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 11}
+
+typedef struct INCALESCENT_Gzip INCALESCENT_Gzip;
+
+/**
+ * @brief Starts a gzip stream that is compressed and written by a thread of its own.
+ *
+ * @param[in] file      The file to write to, right after the header. The stream doesn't take
+ *                      ownership of it.
+ * @param[in] maxBlock  The most bytes a single block can have.
+ * @param[out] gzip     Receives the stream. It must be released with INCALESCENT_Gzip_Destroy.
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Gzip_Create(HANDLE file, SIZE_T maxBlock, INCALESCENT_Gzip **gzip);
+
+/**
+ * @brief Hands the next block of data to the stream's thread.
+ *
+ * Waits for the thread to finish the previous block first, so the previous block can be reused
+ * once this returns, while this block has to stay unchanged until the next call.
+ *
+ * @return S_OK if successful, or the failure that stopped the stream.
+ */
+HRESULT INCALESCENT_Gzip_Write(INCALESCENT_Gzip *gzip, const BYTE *block, SIZE_T size);
+
+// Ends the stream, waiting for the thread to compress and write everything handed to it, and
+// writes the trailer.
+HRESULT INCALESCENT_Gzip_Finish(INCALESCENT_Gzip *gzip);
+
+void INCALESCENT_Gzip_Destroy(INCALESCENT_Gzip *gzip);
+
+#endif //INCALESCENT_GZIP_H
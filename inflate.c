@@ -0,0 +1,420 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "inflate.h"
+
+#define INCALESCENT_INFLATE_INVALID HRESULT_FROM_WIN32(ERROR_INVALID_DATA)
+
+static const WORD INCALESCENT_Inflate_LengthBase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const BYTE INCALESCENT_Inflate_LengthExtra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const WORD INCALESCENT_Inflate_DistanceBase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+        16385, 24577
+};
+static const BYTE INCALESCENT_Inflate_DistanceExtra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// The order the lengths of the code length code are stored in.
+static const BYTE INCALESCENT_Inflate_CodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+static void INCALESCENT_Inflate_Refill(INCALESCENT_Inflate *inflate) {
+    while (inflate->bitCount <= 56 && inflate->position < inflate->inputSize) {
+        inflate->bits |= (ULONGLONG) inflate->input[inflate->position++] << inflate->bitCount;
+        inflate->bitCount += 8;
+    }
+}
+
+// Takes the next count bits, at most 32, least significant first. Fails if the data ends first.
+static BOOL INCALESCENT_Inflate_Bits(INCALESCENT_Inflate *inflate, DWORD count, DWORD *value) {
+    if (inflate->bitCount < count) {
+        INCALESCENT_Inflate_Refill(inflate);
+        if (inflate->bitCount < count) {
+            return FALSE;
+        }
+    }
+    *value = (DWORD) (inflate->bits & ((1ULL << count) - 1));
+    inflate->bits >>= count;
+    inflate->bitCount -= count;
+    return TRUE;
+}
+
+// Builds a code from the length of the code of every symbol. A code may be incomplete, but not
+// over-subscribed.
+static BOOL INCALESCENT_Inflate_Build(INCALESCENT_Inflate_Code *code, const BYTE *lengths, DWORD symbolCount) {
+    WORD offsets[INCALESCENT_INFLATE_MAX_BITS + 1];
+
+    ZeroMemory(code->counts, sizeof(code->counts));
+    for (DWORD symbol = 0; symbol < symbolCount; symbol++) {
+        code->counts[lengths[symbol]]++;
+    }
+    code->counts[0] = 0;
+
+    LONG left = 1;
+    for (DWORD length = 1; length <= INCALESCENT_INFLATE_MAX_BITS; length++) {
+        left = (left << 1) - code->counts[length];
+        if (left < 0) {
+            return FALSE;
+        }
+    }
+
+    offsets[1] = 0;
+    for (DWORD length = 1; length < INCALESCENT_INFLATE_MAX_BITS; length++) {
+        offsets[length + 1] = offsets[length] + code->counts[length];
+    }
+    for (DWORD symbol = 0; symbol < symbolCount; symbol++) {
+        if (lengths[symbol] != 0) {
+            code->symbols[offsets[lengths[symbol]]++] = (WORD) symbol;
+        }
+    }
+
+    // Codes are stored most significant bit first, but read least significant first, so every
+    // short code fills the table entries that end with its reversed bits.
+    ZeroMemory(code->fast, sizeof(code->fast));
+    DWORD value = 0;
+    DWORD index = 0;
+    for (DWORD length = 1; length <= INCALESCENT_INFLATE_FAST_BITS; length++) {
+        for (DWORD counted = 0; counted < code->counts[length]; counted++, value++) {
+            DWORD reversed = 0;
+            for (DWORD bit = 0; bit < length; bit++) {
+                reversed |= ((value >> bit) & 1) << (length - 1 - bit);
+            }
+            WORD entry = (WORD) ((code->symbols[index++] << 4) | length);
+            for (DWORD fill = reversed; fill < (1 << INCALESCENT_INFLATE_FAST_BITS); fill += 1 << length) {
+                code->fast[fill] = entry;
+            }
+        }
+        value <<= 1;
+    }
+    return TRUE;
+}
+
+// Decodes a symbol. Short codes take a single lookup, longer ones are decoded a bit at a time.
+static BOOL INCALESCENT_Inflate_Decode(INCALESCENT_Inflate *inflate, const INCALESCENT_Inflate_Code *code, DWORD *symbol) {
+    if (inflate->bitCount < INCALESCENT_INFLATE_MAX_BITS) {
+        INCALESCENT_Inflate_Refill(inflate);
+    }
+
+    WORD entry = code->fast[inflate->bits & ((1 << INCALESCENT_INFLATE_FAST_BITS) - 1)];
+    if (entry != 0) {
+        DWORD length = entry & 0xF;
+        if (length > inflate->bitCount) {
+            return FALSE;
+        }
+        inflate->bits >>= length;
+        inflate->bitCount -= length;
+        *symbol = entry >> 4;
+        return TRUE;
+    }
+
+    LONG value = 0;
+    LONG first = 0;
+    LONG index = 0;
+    for (DWORD length = 1; length <= INCALESCENT_INFLATE_MAX_BITS && length <= inflate->bitCount; length++) {
+        value |= (LONG) ((inflate->bits >> (length - 1)) & 1);
+        LONG count = code->counts[length];
+        if (value - count < first) {
+            inflate->bits >>= length;
+            inflate->bitCount -= length;
+            *symbol = code->symbols[index + (value - first)];
+            return TRUE;
+        }
+        index += count;
+        first = (first + count) << 1;
+        value <<= 1;
+    }
+    return FALSE;
+}
+
+// Hands on everything decompressed since the last time.
+static HRESULT INCALESCENT_Inflate_HandOn(INCALESCENT_Inflate *inflate) {
+    HRESULT result = S_OK;
+    if (inflate->used != inflate->handedOn) {
+        result = inflate->sink(inflate->context, inflate->buffer + inflate->handedOn, inflate->used - inflate->handedOn);
+        inflate->handedOn = inflate->used;
+    }
+    return result;
+}
+
+// Makes sure the buffer has room for the longest match, handing on the buffer and keeping only the
+// last window of it if not.
+static HRESULT INCALESCENT_Inflate_MakeRoom(INCALESCENT_Inflate *inflate) {
+    if (inflate->used + INCALESCENT_INFLATE_MAX_MATCH <= INCALESCENT_INFLATE_BUFFER_SIZE) {
+        return S_OK;
+    }
+
+    HRESULT result = INCALESCENT_Inflate_HandOn(inflate);
+    if (result != S_OK) {
+        return result;
+    }
+    MoveMemory(inflate->buffer, inflate->buffer + inflate->used - INCALESCENT_INFLATE_WINDOW_SIZE, INCALESCENT_INFLATE_WINDOW_SIZE);
+    inflate->used = INCALESCENT_INFLATE_WINDOW_SIZE;
+    inflate->handedOn = INCALESCENT_INFLATE_WINDOW_SIZE;
+    return S_OK;
+}
+
+// Copies a stored block, which starts at the next byte boundary.
+static HRESULT INCALESCENT_Inflate_Stored(INCALESCENT_Inflate *inflate) {
+    HRESULT result = S_OK;
+    DWORD length = 0;
+    DWORD complement = 0;
+
+    DWORD padding = 0;
+    INCALESCENT_Inflate_Bits(inflate, inflate->bitCount % 8, &padding);
+    if (!INCALESCENT_Inflate_Bits(inflate, 16, &length) || !INCALESCENT_Inflate_Bits(inflate, 16, &complement) || length != (~complement & 0xFFFF)) {
+        return INCALESCENT_INFLATE_INVALID;
+    }
+
+    // Bytes already taken into the bit buffer come out of it first, the rest straight from the input.
+    while (length != 0 && inflate->bitCount != 0) {
+        DWORD byte = 0;
+        result = INCALESCENT_Inflate_MakeRoom(inflate);
+        if (result != S_OK) {
+            return result;
+        }
+        INCALESCENT_Inflate_Bits(inflate, 8, &byte);
+        inflate->buffer[inflate->used++] = (BYTE) byte;
+        length--;
+    }
+    if (length > inflate->inputSize - inflate->position) {
+        return INCALESCENT_INFLATE_INVALID;
+    }
+    while (length != 0) {
+        result = INCALESCENT_Inflate_MakeRoom(inflate);
+        if (result != S_OK) {
+            return result;
+        }
+        SIZE_T size = INCALESCENT_INFLATE_BUFFER_SIZE - inflate->used;
+        size = size < length ? size : length;
+        CopyMemory(inflate->buffer + inflate->used, inflate->input + inflate->position, size);
+        inflate->used += size;
+        inflate->position += size;
+        length -= (DWORD) size;
+    }
+    return S_OK;
+}
+
+// Decodes a block compressed with the current codes, up to its end-of-block symbol.
+static HRESULT INCALESCENT_Inflate_Codes(INCALESCENT_Inflate *inflate) {
+    for (;;) {
+        DWORD symbol = 0;
+        HRESULT result = INCALESCENT_Inflate_MakeRoom(inflate);
+        if (result != S_OK) {
+            return result;
+        }
+        if (!INCALESCENT_Inflate_Decode(inflate, &inflate->literals, &symbol)) {
+            return INCALESCENT_INFLATE_INVALID;
+        }
+
+        if (symbol < 256) {
+            inflate->buffer[inflate->used++] = (BYTE) symbol;
+            continue;
+        }
+        if (symbol == 256) {
+            return S_OK;
+        }
+
+        symbol -= 257;
+        DWORD extra = 0;
+        if (symbol >= ARRAYSIZE(INCALESCENT_Inflate_LengthBase) ||
+            !INCALESCENT_Inflate_Bits(inflate, INCALESCENT_Inflate_LengthExtra[symbol], &extra)) {
+            return INCALESCENT_INFLATE_INVALID;
+        }
+        DWORD length = INCALESCENT_Inflate_LengthBase[symbol] + extra;
+
+        if (!INCALESCENT_Inflate_Decode(inflate, &inflate->distances, &symbol) || symbol >= ARRAYSIZE(INCALESCENT_Inflate_DistanceBase) ||
+            !INCALESCENT_Inflate_Bits(inflate, INCALESCENT_Inflate_DistanceExtra[symbol], &extra)) {
+            return INCALESCENT_INFLATE_INVALID;
+        }
+        SIZE_T distance = INCALESCENT_Inflate_DistanceBase[symbol] + extra;
+        if (distance > inflate->used) {
+            return INCALESCENT_INFLATE_INVALID;
+        }
+
+        // A match may overlap the bytes it produces, so it is copied a byte at a time.
+        BYTE *to = inflate->buffer + inflate->used;
+        const BYTE *from = to - distance;
+        for (DWORD index = 0; index < length; index++) {
+            to[index] = from[index];
+        }
+        inflate->used += length;
+    }
+}
+
+// Builds the fixed codes of a block of type 1.
+static void INCALESCENT_Inflate_Fixed(INCALESCENT_Inflate *inflate) {
+    BYTE lengths[INCALESCENT_INFLATE_MAX_LITERALS];
+    DWORD symbol = 0;
+    for (; symbol < 144; symbol++) {
+        lengths[symbol] = 8;
+    }
+    for (; symbol < 256; symbol++) {
+        lengths[symbol] = 9;
+    }
+    for (; symbol < 280; symbol++) {
+        lengths[symbol] = 7;
+    }
+    for (; symbol < INCALESCENT_INFLATE_MAX_LITERALS; symbol++) {
+        lengths[symbol] = 8;
+    }
+    INCALESCENT_Inflate_Build(&inflate->literals, lengths, INCALESCENT_INFLATE_MAX_LITERALS);
+
+    for (symbol = 0; symbol < INCALESCENT_INFLATE_MAX_DISTANCES; symbol++) {
+        lengths[symbol] = 5;
+    }
+    INCALESCENT_Inflate_Build(&inflate->distances, lengths, INCALESCENT_INFLATE_MAX_DISTANCES);
+}
+
+// Reads the codes of a block of type 2, which are themselves compressed with a code length code.
+static HRESULT INCALESCENT_Inflate_Dynamic(INCALESCENT_Inflate *inflate) {
+    BYTE lengths[INCALESCENT_INFLATE_MAX_LITERALS + INCALESCENT_INFLATE_MAX_DISTANCES];
+    INCALESCENT_Inflate_Code lengthCode;
+    DWORD literalCount = 0;
+    DWORD distanceCount = 0;
+    DWORD codeLengthCount = 0;
+
+    if (!INCALESCENT_Inflate_Bits(inflate, 5, &literalCount) || !INCALESCENT_Inflate_Bits(inflate, 5, &distanceCount) ||
+        !INCALESCENT_Inflate_Bits(inflate, 4, &codeLengthCount)) {
+        return INCALESCENT_INFLATE_INVALID;
+    }
+    literalCount += 257;
+    distanceCount += 1;
+    codeLengthCount += 4;
+    if (literalCount > INCALESCENT_INFLATE_MAX_LITERALS || distanceCount > INCALESCENT_INFLATE_MAX_DISTANCES) {
+        return INCALESCENT_INFLATE_INVALID;
+    }
+
+    ZeroMemory(lengths, sizeof(lengths));
+    for (DWORD index = 0; index < codeLengthCount; index++) {
+        DWORD length = 0;
+        if (!INCALESCENT_Inflate_Bits(inflate, 3, &length)) {
+            return INCALESCENT_INFLATE_INVALID;
+        }
+        lengths[INCALESCENT_Inflate_CodeLengthOrder[index]] = (BYTE) length;
+    }
+    if (!INCALESCENT_Inflate_Build(&lengthCode, lengths, ARRAYSIZE(INCALESCENT_Inflate_CodeLengthOrder))) {
+        return INCALESCENT_INFLATE_INVALID;
+    }
+
+    // The lengths of both codes are one sequence, so a repeat may run from one into the other.
+    DWORD total = literalCount + distanceCount;
+    for (DWORD index = 0; index < total;) {
+        DWORD symbol = 0;
+        if (!INCALESCENT_Inflate_Decode(inflate, &lengthCode, &symbol)) {
+            return INCALESCENT_INFLATE_INVALID;
+        }
+        if (symbol < 16) {
+            lengths[index++] = (BYTE) symbol;
+            continue;
+        }
+
+        BYTE repeated = 0;
+        DWORD repeat = 0;
+        if (symbol == 16) {
+            if (index == 0 || !INCALESCENT_Inflate_Bits(inflate, 2, &repeat)) {
+                return INCALESCENT_INFLATE_INVALID;
+            }
+            repeated = lengths[index - 1];
+            repeat += 3;
+        } else if (symbol == 17) {
+            if (!INCALESCENT_Inflate_Bits(inflate, 3, &repeat)) {
+                return INCALESCENT_INFLATE_INVALID;
+            }
+            repeat += 3;
+        } else {
+            if (!INCALESCENT_Inflate_Bits(inflate, 7, &repeat)) {
+                return INCALESCENT_INFLATE_INVALID;
+            }
+            repeat += 11;
+        }
+        if (index + repeat > total) {
+            return INCALESCENT_INFLATE_INVALID;
+        }
+        for (; repeat != 0; repeat--) {
+            lengths[index++] = repeated;
+        }
+    }
+
+    // Without a code for the end of the block, the block could never end.
+    if (lengths[256] == 0 || !INCALESCENT_Inflate_Build(&inflate->literals, lengths, literalCount) ||
+        !INCALESCENT_Inflate_Build(&inflate->distances, lengths + literalCount, distanceCount)) {
+        return INCALESCENT_INFLATE_INVALID;
+    }
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Inflate_Run
+HRESULT INCALESCENT_Inflate_Run(INCALESCENT_Inflate *inflate, const BYTE *data, SIZE_T size, INCALESCENT_Inflate_Sink sink, PVOID context,
+                                SIZE_T *consumed) {
+    HRESULT result = S_OK;
+    DWORD last = 0;
+
+    inflate->input = data;
+    inflate->inputSize = size;
+    inflate->position = 0;
+    inflate->bits = 0;
+    inflate->bitCount = 0;
+    inflate->used = 0;
+    inflate->handedOn = 0;
+    inflate->sink = sink;
+    inflate->context = context;
+
+    while (!last) {
+        DWORD type = 0;
+        if (!INCALESCENT_Inflate_Bits(inflate, 1, &last) || !INCALESCENT_Inflate_Bits(inflate, 2, &type)) {
+            result = INCALESCENT_INFLATE_INVALID;
+            goto cleanup;
+        }
+
+        if (type == 0) {
+            result = INCALESCENT_Inflate_Stored(inflate);
+        } else if (type == 1) {
+            INCALESCENT_Inflate_Fixed(inflate);
+            result = INCALESCENT_Inflate_Codes(inflate);
+        } else if (type == 2) {
+            result = INCALESCENT_Inflate_Dynamic(inflate);
+            if (result == S_OK) {
+                result = INCALESCENT_Inflate_Codes(inflate);
+            }
+        } else {
+            result = INCALESCENT_INFLATE_INVALID;
+        }
+        if (result != S_OK) {
+            goto cleanup;
+        }
+    }
+    result = INCALESCENT_Inflate_HandOn(inflate);
+
+    // Whole bytes still in the bit buffer were never part of the data.
+    if (consumed != NULL) {
+        *consumed = inflate->position - (inflate->bitCount / 8);
+    }
+
+    cleanup:
+    return result;
+}
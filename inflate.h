@@ -0,0 +1,108 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_INFLATE_H
+#define INCALESCENT_INFLATE_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* PVOID;
+typedef unsigned short WORD;
+typedef unsigned char BYTE;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+// The farthest back a match can reach, and the longest match.
+#define INCALESCENT_INFLATE_WINDOW_SIZE (32 * 1024)
+#define INCALESCENT_INFLATE_MAX_MATCH 258
+
+// Output is collected in a buffer of several windows and handed on whenever it fills, after which
+// only the last window is kept for the matches to reach back into.
+#define INCALESCENT_INFLATE_BUFFER_SIZE (4 * INCALESCENT_INFLATE_WINDOW_SIZE)
+
+#define INCALESCENT_INFLATE_MAX_BITS 15
+#define INCALESCENT_INFLATE_MAX_LITERALS 288
+#define INCALESCENT_INFLATE_MAX_DISTANCES 30
+
+// Codes up to this long are decoded with a single table lookup, which covers nearly all of them.
+#define INCALESCENT_INFLATE_FAST_BITS 10
+
+/**
+ * @brief Receives a piece of the decompressed data.
+ *
+ * @return S_OK to go on, S_FALSE to stop decompressing or a failure to abort.
+ */
+typedef HRESULT (*INCALESCENT_Inflate_Sink)(PVOID context, const BYTE *data, SIZE_T size);
+
+// A canonical Huffman code, with a table that decodes the short codes at once.
+typedef struct INCALESCENT_Inflate_Code {
+    WORD counts[INCALESCENT_INFLATE_MAX_BITS + 1];
+    WORD symbols[INCALESCENT_INFLATE_MAX_LITERALS];
+
+    // The symbol in the upper bits and the length in the lowest 4, or 0 for a longer code.
+    WORD fast[1 << INCALESCENT_INFLATE_FAST_BITS];
+} INCALESCENT_Inflate_Code;
+
+/**
+ * @brief A decoder of raw deflate data (RFC 1951).
+ *
+ * The compressed data has to be in memory as a whole, like a mapped file, while the decompressed
+ * data is handed on a buffer at a time, so data of any size is decompressed in constant memory. The
+ * decoder is large, so it is meant to be allocated once and reused.
+ */
+typedef struct INCALESCENT_Inflate {
+    const BYTE *input;
+    SIZE_T inputSize;
+    SIZE_T position;
+    ULONGLONG bits;
+    DWORD bitCount;
+
+    BYTE buffer[INCALESCENT_INFLATE_BUFFER_SIZE];
+    SIZE_T used;
+    SIZE_T handedOn;
+    INCALESCENT_Inflate_Sink sink;
+    PVOID context;
+
+    INCALESCENT_Inflate_Code literals;
+    INCALESCENT_Inflate_Code distances;
+} INCALESCENT_Inflate;
+
+/**
+ * @brief Decompresses raw deflate data, handing the output on as it is produced.
+ *
+ * @param[in,out] inflate   The decoder.
+ * @param[in] data          The compressed data.
+ * @param[in] size          The size of the compressed data in bytes.
+ * @param[in] sink          Receives the decompressed data.
+ * @param[in] context       Passed on to the sink.
+ * @param[out] consumed     Receives the number of bytes the compressed data took, up to the end of
+ *                          its last block. May be NULL.
+ *
+ * @return S_OK once the last block has been decompressed, S_FALSE if the sink stopped it,
+ *         HRESULT_FROM_WIN32(ERROR_INVALID_DATA) if the data is corrupt or cut off, or the failure of
+ *         the sink.
+ */
+HRESULT INCALESCENT_Inflate_Run(INCALESCENT_Inflate *inflate, const BYTE *data, SIZE_T size, INCALESCENT_Inflate_Sink sink, PVOID context,
+                                SIZE_T *consumed);
+
+#endif //INCALESCENT_INFLATE_H
@@ -0,0 +1,312 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "io.h"
+#include "perf.h"
+
+typedef struct INCALESCENT_IoSlot {
+    // Must come first so that a completed OVERLAPPED can be turned back into its slot.
+    OVERLAPPED overlapped;
+    HANDLE file;
+    PBYTE buffer;
+    SIZE_T tag;
+
+    // Set when the read failed before it could be queued. The completion is then posted by hand.
+    DWORD error;
+    BOOL pending;
+    ULONGLONG offset;
+
+    // When the read was queued, for the performance counters.
+    ULONGLONG queued;
+} INCALESCENT_IoSlot;
+
+struct INCALESCENT_Io {
+    HANDLE port;
+    INCALESCENT_IoSlot *slots;
+    DWORD *freeSlots;
+    DWORD freeCount;
+    DWORD depth;
+    DWORD pending;
+    SIZE_T readSize;
+};
+
+// Closes the file of a slot and puts the slot back on the free list.
+static void INCALESCENT_Io_FreeSlot(INCALESCENT_Io *io, DWORD slotIndex) {
+    INCALESCENT_IoSlot *slot = &io->slots[slotIndex];
+
+    if (slot->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(slot->file);
+        slot->file = INVALID_HANDLE_VALUE;
+    }
+    io->freeSlots[io->freeCount] = slotIndex;
+    io->freeCount++;
+}
+
+// Queues a read of a slot's open file at an offset.
+static HRESULT INCALESCENT_Io_Queue(INCALESCENT_Io *io, INCALESCENT_IoSlot *slot, ULONGLONG offset) {
+    HRESULT result = S_OK;
+
+    ZeroMemory(&slot->overlapped, sizeof(OVERLAPPED));
+    slot->overlapped.Offset = (DWORD) offset;
+    slot->overlapped.OffsetHigh = (DWORD) (offset >> 32);
+    slot->offset = offset;
+    slot->error = ERROR_SUCCESS;
+    slot->pending = TRUE;
+    slot->queued = INCALESCENT_Perf_Now();
+    io->pending++;
+
+    BOOL readResult = ReadFile(slot->file, slot->buffer, (DWORD) io->readSize, NULL, &slot->overlapped);
+    if (!readResult) {
+        DWORD lastError = GetLastError();
+        if (lastError != ERROR_IO_PENDING) {
+            // Nothing was queued for a read that failed right away, so queue its completion
+            // here to keep every read reporting back the same way.
+            slot->error = lastError;
+            if (!PostQueuedCompletionStatus(io->port, 0, 0, &slot->overlapped)) {
+                result = HRESULT_FROM_WIN32(GetLastError());
+                slot->pending = FALSE;
+                io->pending--;
+            }
+        }
+    }
+
+    return result;
+}
+
+// Implementation for INCALESCENT_Io_Create
+HRESULT INCALESCENT_Io_Create(INCALESCENT_Arena *arena, DWORD depth, SIZE_T readSize, INCALESCENT_Io **io) {
+    HRESULT result = S_OK;
+    INCALESCENT_Io *intermediate = NULL;
+    PBYTE buffers = NULL;
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_Io), INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &intermediate);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(intermediate, sizeof(INCALESCENT_Io));
+    intermediate->depth = depth;
+    intermediate->readSize = readSize;
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_IoSlot) * depth, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &intermediate->slots);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * depth, sizeof(DWORD), (PVOID *) &intermediate->freeSlots);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, readSize * depth, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &buffers);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (DWORD index = 0; index < depth; index++) {
+        INCALESCENT_IoSlot *slot = &intermediate->slots[index];
+        ZeroMemory(slot, sizeof(INCALESCENT_IoSlot));
+        slot->file = INVALID_HANDLE_VALUE;
+        slot->buffer = buffers + (readSize * index);
+
+        // Hand out the lowest slots first.
+        intermediate->freeSlots[index] = depth - index - 1;
+    }
+    intermediate->freeCount = depth;
+
+    intermediate->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (intermediate->port == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    *io = intermediate;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Io_Submit
+HRESULT INCALESCENT_Io_Submit(INCALESCENT_Io *io, PCWSTR path, SIZE_T tag, ULONGLONG offset) {
+    HRESULT result = S_OK;
+
+    if (io->freeCount == 0) {
+        result = E_UNEXPECTED;
+        goto cleanup;
+    }
+    DWORD slotIndex = io->freeSlots[io->freeCount - 1];
+    INCALESCENT_IoSlot *slot = &io->slots[slotIndex];
+
+    // Opening a file can't be overlapped, but once it is open the read is queued and the
+    // caller is free to open the next one while this one is still on its way.
+    ULONGLONG opening = INCALESCENT_Perf_Now();
+    slot->file = CreateFileW(
+            path,
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            NULL,
+            OPEN_EXISTING,
+            FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN,
+            NULL
+    );
+    if (slot->file == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    if (CreateIoCompletionPort(slot->file, io->port, 0, 0) == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        CloseHandle(slot->file);
+        slot->file = INVALID_HANDLE_VALUE;
+        goto cleanup;
+    }
+    INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_OPEN, opening);
+
+    slot->tag = tag;
+    io->freeCount--;
+    result = INCALESCENT_Io_Queue(io, slot, offset);
+    if (FAILED(result)) {
+        INCALESCENT_Io_FreeSlot(io, slotIndex);
+        goto cleanup;
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Io_Continue
+HRESULT INCALESCENT_Io_Continue(INCALESCENT_Io *io, const INCALESCENT_Io_Completion *completion, ULONGLONG offset) {
+    return INCALESCENT_Io_Queue(io, &io->slots[completion->slot], offset);
+}
+
+// Implementation for INCALESCENT_Io_Complete
+HRESULT INCALESCENT_Io_Complete(INCALESCENT_Io *io, INCALESCENT_Io_Completion *completions, DWORD maximum, DWORD *count) {
+    HRESULT result = S_OK;
+    OVERLAPPED_ENTRY entries[INCALESCENT_IO_MAX_BATCH];
+    ULONG removed = 0;
+
+    *count = 0;
+    if (io->pending == 0) {
+        result = E_UNEXPECTED;
+        goto cleanup;
+    }
+    if (maximum > INCALESCENT_IO_MAX_BATCH) {
+        maximum = INCALESCENT_IO_MAX_BATCH;
+    }
+
+    if (!GetQueuedCompletionStatusEx(io->port, entries, maximum, &removed, INFINITE, FALSE)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    for (ULONG index = 0; index < removed; index++) {
+        INCALESCENT_IoSlot *slot = (INCALESCENT_IoSlot *) entries[index].lpOverlapped;
+        INCALESCENT_Io_Completion *completion = &completions[index];
+        slot->pending = FALSE;
+        io->pending--;
+
+        completion->tag = slot->tag;
+        completion->slot = (DWORD) (slot - io->slots);
+        completion->data = slot->buffer;
+        completion->size = entries[index].dwNumberOfBytesTransferred;
+        completion->offset = slot->offset;
+        completion->result = S_OK;
+
+        // The status of a finished read is kept in the OVERLAPPED, and asking for the result of a
+        // read that is known to be done turns it into a Win32 error without waiting.
+        DWORD error = slot->error;
+        if (error == ERROR_SUCCESS && slot->overlapped.Internal != 0) {
+            DWORD transferred = 0;
+            if (!GetOverlappedResult(slot->file, &slot->overlapped, &transferred, FALSE)) {
+                error = GetLastError();
+            }
+        }
+
+        // Reading past the end of a file isn't an error, there just isn't anything to parse.
+        if (error == ERROR_HANDLE_EOF) {
+            completion->size = 0;
+        } else if (error != ERROR_SUCCESS) {
+            completion->result = HRESULT_FROM_WIN32(error);
+        }
+        completion->endOfFile = completion->size < io->readSize;
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_READ, slot->queued);
+        INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_BYTES_READ, completion->size);
+    }
+    *count = removed;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Io_Release
+void INCALESCENT_Io_Release(INCALESCENT_Io *io, const INCALESCENT_Io_Completion *completion) {
+    INCALESCENT_Io_FreeSlot(io, completion->slot);
+}
+
+// Implementation for INCALESCENT_Io_Drain
+void INCALESCENT_Io_Drain(INCALESCENT_Io *io) {
+    INCALESCENT_Io_Completion completions[INCALESCENT_IO_MAX_BATCH];
+
+    for (DWORD index = 0; index < io->depth; index++) {
+        if (io->slots[index].pending) {
+            CancelIoEx(io->slots[index].file, &io->slots[index].overlapped);
+        }
+    }
+
+    while (io->pending != 0) {
+        DWORD count = 0;
+        if (FAILED(INCALESCENT_Io_Complete(io, completions, INCALESCENT_IO_MAX_BATCH, &count))) {
+            break;
+        }
+        for (DWORD index = 0; index < count; index++) {
+            INCALESCENT_Io_Release(io, &completions[index]);
+        }
+    }
+}
+
+// Implementation for INCALESCENT_Io_CanSubmit
+BOOL INCALESCENT_Io_CanSubmit(const INCALESCENT_Io *io) {
+    return io->freeCount != 0;
+}
+
+// Implementation for INCALESCENT_Io_Pending
+DWORD INCALESCENT_Io_Pending(const INCALESCENT_Io *io) {
+    return io->pending;
+}
+
+// Implementation for INCALESCENT_Io_Destroy
+void INCALESCENT_Io_Destroy(INCALESCENT_Io *io) {
+    if (io == NULL) {
+        return;
+    }
+
+    INCALESCENT_Io_Drain(io);
+    for (DWORD index = 0; index < io->depth; index++) {
+        if (io->slots[index].file != INVALID_HANDLE_VALUE) {
+            CloseHandle(io->slots[index].file);
+            io->slots[index].file = INVALID_HANDLE_VALUE;
+        }
+    }
+    if (io->port != NULL) {
+        CloseHandle(io->port);
+        io->port = NULL;
+    }
+}
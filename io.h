@@ -0,0 +1,109 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_IO_H
+#define INCALESCENT_IO_H
+#include "arena.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WCHAR;
+typedef const WCHAR* PCWSTR;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+#define INCALESCENT_IO_MAX_BATCH 64
+
+typedef struct INCALESCENT_Io INCALESCENT_Io;
+
+typedef struct INCALESCENT_Io_Completion {
+    // The tag the read was submitted with.
+    SIZE_T tag;
+
+    // The outcome of the read. On success, data points at the size bytes that were read from offset,
+    // which stay valid until the completion is released or continued. A read that came up short
+    // reached the end of the file.
+    HRESULT result;
+    const BYTE *data;
+    SIZE_T size;
+    ULONGLONG offset;
+    BOOL endOfFile;
+
+    DWORD slot;
+} INCALESCENT_Io_Completion;
+
+/**
+ * @brief Creates an engine that keeps many small file reads in flight at once.
+ *
+ * Every submission opens a file for overlapped I/O and starts reading it, and the engine's
+ * completion port collects the reads in whatever order they finish. On Linux the opens and reads
+ * go through io_uring instead, or through a few threads of the engine's own where io_uring isn't
+ * available. A file stays open until its completion is released, so it can be read further with
+ * INCALESCENT_Io_Continue. An engine must only be used by one thread at a time.
+ *
+ * @param[in] arena     The arena the engine and its read buffers are allocated from.
+ * @param[in] depth     The most reads that can be in flight at once.
+ * @param[in] readSize  The number of bytes each read asks for.
+ * @param[out] io       Receives the engine. It must be released with INCALESCENT_Io_Destroy.
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Io_Create(INCALESCENT_Arena *arena, DWORD depth, SIZE_T readSize, INCALESCENT_Io **io);
+
+/**
+ * @brief Opens a file and starts reading it at an offset.
+ *
+ * Must only be called while INCALESCENT_Io_CanSubmit returns TRUE. A failure to open the file is
+ * returned right away, while a failure to read it is reported through its completion. On Linux the
+ * file is opened in the background, so a failure to open it is reported through its completion too.
+ */
+HRESULT INCALESCENT_Io_Submit(INCALESCENT_Io *io, PCWSTR path, SIZE_T tag, ULONGLONG offset);
+
+/**
+ * @brief Starts another read of a completed file, into the same buffer.
+ *
+ * The completion's data is overwritten, and the read completes like any other with the same tag.
+ * A failure to read is reported through its completion. If queuing it fails, the error is
+ * returned and the completion still has to be released.
+ */
+HRESULT INCALESCENT_Io_Continue(INCALESCENT_Io *io, const INCALESCENT_Io_Completion *completion, ULONGLONG offset);
+
+/**
+ * @brief Waits for at least one submitted read to finish and collects up to maximum of them.
+ *
+ * Every collected completion holds on to its buffer until it is passed to INCALESCENT_Io_Release.
+ */
+HRESULT INCALESCENT_Io_Complete(INCALESCENT_Io *io, INCALESCENT_Io_Completion *completions, DWORD maximum, DWORD *count);
+
+void INCALESCENT_Io_Release(INCALESCENT_Io *io, const INCALESCENT_Io_Completion *completion);
+
+// Cancels every read still in flight and waits for them to finish.
+void INCALESCENT_Io_Drain(INCALESCENT_Io *io);
+
+BOOL INCALESCENT_Io_CanSubmit(const INCALESCENT_Io *io);
+DWORD INCALESCENT_Io_Pending(const INCALESCENT_Io *io);
+void INCALESCENT_Io_Destroy(INCALESCENT_Io *io);
+
+#endif //INCALESCENT_IO_H
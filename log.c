@@ -2,83 +2,424 @@
 #include <strsafe.h>
 #include "log.h"
 
-// Implementation for INCALESCENT_LogRawW
-HRESULT INCALESCENT_LogRawW(PWSTR message, const SIZE_T messageSize) {
+#define INCALESCENT_LOG_MAX_LINE_LENGTH (INCALESCENT_LOG_MAX_HEADER_LENGTH + INCALESCENT_LOG_MAX_MESSAGE_LENGTH)
+
+static const PCWSTR INCALESCENT_LogLevelNames[] = {L"DETAIL", L"INFO", L"ERROR"};
+
+// A line in the queue. The sequence number tells whose turn the slot is: it equals the position a
+// producer may claim it at, is one past that once the line is in, and moves a whole lap ahead once
+// the logging thread has taken the line out.
+typedef struct INCALESCENT_LogSlot {
+    volatile LONG64 sequence;
+    SIZE_T length;
+    WCHAR text[INCALESCENT_LOG_MAX_LINE_LENGTH];
+} INCALESCENT_LogSlot;
+
+// A bounded queue that any number of threads put lines into and only the logging thread takes
+// them out of. Producers only ever contend on claiming a position, which is a single
+// compare-and-swap, and format their line into the claimed slot without holding anything.
+typedef struct INCALESCENT_LogQueue {
+    INCALESCENT_LogSlot *slots;
+    DECLSPEC_ALIGN(64) volatile LONG64 enqueuePosition;
+    DECLSPEC_ALIGN(64) LONG64 dequeuePosition;
+
+    // Set by the logging thread right before it waits for more lines, so that only then does a
+    // producer have to wake it up.
+    volatile LONG sleeping;
+    volatile LONG stopping;
+    HANDLE wake;
+    HANDLE thread;
+
+    // Where lines go, and the first error writing them.
+    HANDLE output;
+    HANDLE file;
+    HRESULT failure;
+
+    volatile LONG minimumLevel;
+    volatile LONG64 lastProgress;
+} INCALESCENT_LogQueue;
+
+static INCALESCENT_LogQueue INCALESCENT_Log = {0};
+
+// Writes text to the output. A console takes the text as it is, while output that was redirected
+// to a file or pipe gets it as UTF-8, converted in pieces that fit on the stack.
+static HRESULT INCALESCENT_LogWriteW(HANDLE output, PCWSTR message, SIZE_T messageSize) {
     HRESULT result = S_OK;
 
-    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
-    if (console == INVALID_HANDLE_VALUE) {
-        result = HRESULT_FROM_WIN32(GetLastError());
+    // Without any output at all there is nowhere to log to, which isn't an error.
+    if (output == NULL || output == INVALID_HANDLE_VALUE) {
         goto cleanup;
     }
 
     DWORD written;
-    BOOL writeResult = WriteConsoleW(console, message, messageSize, &written, NULL);
-    if (!writeResult) {
-        result = HRESULT_FROM_WIN32(GetLastError());
+    if (GetFileType(output) == FILE_TYPE_CHAR) {
+        if (!WriteConsoleW(output, message, (DWORD) messageSize, &written, NULL)) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+        }
+        goto cleanup;
+    }
+
+    CHAR converted[INCALESCENT_LOG_MAX_MESSAGE_LENGTH * 3];
+    while (messageSize != 0) {
+        SIZE_T pieceSize = messageSize < INCALESCENT_LOG_MAX_MESSAGE_LENGTH ? messageSize : INCALESCENT_LOG_MAX_MESSAGE_LENGTH;
+
+        // Never split a surrogate pair between two pieces.
+        if (pieceSize < messageSize && IS_HIGH_SURROGATE(message[pieceSize - 1])) {
+            pieceSize--;
+        }
+
+        INT convertedSize = WideCharToMultiByte(CP_UTF8, 0, message, (INT) pieceSize, converted, sizeof(converted), NULL, NULL);
+        if (convertedSize == 0 || !WriteFile(output, converted, convertedSize, &written, NULL)) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        message += pieceSize;
+        messageSize -= pieceSize;
     }
 
     cleanup:
     return result;
 }
 
-// Implementation for INCALESCENT_LogFormattedW
-HRESULT INCALESCENT_LogFormattedW(PWSTR levelString, PWSTR format, ...) {
-    va_list parameters;
-    va_start(parameters, format);
+// The output lines are written to when they aren't queued.
+static HANDLE INCALESCENT_LogOutput(void) {
+    if (INCALESCENT_Log.file != NULL) {
+        return INCALESCENT_Log.file;
+    }
+    return GetStdHandle(STD_OUTPUT_HANDLE);
+}
+
+// Writes the digits of a number, padded with zeros to count digits.
+static PWSTR INCALESCENT_LogPutDigits(PWSTR text, UINT value, DWORD count) {
+    for (DWORD index = count; index != 0; index--) {
+        text[index - 1] = (WCHAR) (L'0' + (value % 10));
+        value /= 10;
+    }
+    return text + count;
+}
+
+// Formats a line, "[month-day-year hour:minute:second] [level] message", into text in a single
+// pass. A message that doesn't fit is cut off rather than dropped.
+static HRESULT INCALESCENT_LogFormatLine(PWSTR text, INCALESCENT_Log_Level level, PCWSTR format, va_list parameters, SIZE_T *length) {
     HRESULT result = S_OK;
+    SYSTEMTIME time;
+    GetLocalTime(&time);
 
-    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
-    if (console == INVALID_HANDLE_VALUE) {
-        result = HRESULT_FROM_WIN32(GetLastError());
-        goto cleanup;
+    PWSTR end = text;
+    *end++ = L'[';
+    end = INCALESCENT_LogPutDigits(end, time.wMonth, 2);
+    *end++ = L'-';
+    end = INCALESCENT_LogPutDigits(end, time.wDay, 2);
+    *end++ = L'-';
+    end = INCALESCENT_LogPutDigits(end, time.wYear, 4);
+    *end++ = L' ';
+    end = INCALESCENT_LogPutDigits(end, time.wHour, 2);
+    *end++ = L':';
+    end = INCALESCENT_LogPutDigits(end, time.wMinute, 2);
+    *end++ = L':';
+    end = INCALESCENT_LogPutDigits(end, time.wSecond, 2);
+    *end++ = L']';
+    *end++ = L' ';
+    *end++ = L'[';
+    for (PCWSTR name = INCALESCENT_LogLevelNames[level]; *name != L'\0'; name++) {
+        *end++ = *name;
     }
+    *end++ = L']';
+    *end++ = L' ';
 
-    WCHAR suppliedMessage[INCALESCENT_LOG_MAX_MESSAGE_LENGTH];
-    result = StringCchVPrintfW(suppliedMessage, INCALESCENT_LOG_MAX_MESSAGE_LENGTH, format, parameters);
-    va_end(parameters);
-    if (FAILED(result)) {
+    // One character is kept back for the line break.
+    SIZE_T remaining = 0;
+    result = StringCchVPrintfExW(end, (text + INCALESCENT_LOG_MAX_LINE_LENGTH - 1) - end, &end, &remaining, 0, format, parameters);
+    if (FAILED(result) && result != STRSAFE_E_INSUFFICIENT_BUFFER) {
         goto cleanup;
     }
+    result = S_OK;
+    *end++ = L'\n';
+    *length = end - text;
 
-    SYSTEMTIME time;
-    GetLocalTime(&time);
+    cleanup:
+    return result;
+}
 
-    WCHAR logMessage[INCALESCENT_LOG_MAX_MESSAGE_LENGTH + INCALESCENT_LOG_MAX_HEADER_LENGTH];
-    result = StringCchPrintfW(
-            logMessage,
-            INCALESCENT_LOG_MAX_MESSAGE_LENGTH,
-            INCALESCENT_LOG_FORMAT_W,
-            time.wMonth,
-            time.wDay,
-            time.wYear,
-            time.wHour,
-            time.wMinute,
-            time.wSecond,
-            levelString,
-            suppliedMessage
-    );
-    if (FAILED(result)) {
+// Claims the next slot of the queue, waiting for the logging thread if the queue is full.
+static INCALESCENT_LogSlot *INCALESCENT_LogClaim(void) {
+    LONG64 position = INCALESCENT_Log.enqueuePosition;
+    for (;;) {
+        INCALESCENT_LogSlot *slot = &INCALESCENT_Log.slots[position % INCALESCENT_LOG_QUEUE_CAPACITY];
+        LONG64 sequence = slot->sequence;
+        if (sequence == position) {
+            LONG64 claimed = InterlockedCompareExchange64(&INCALESCENT_Log.enqueuePosition, position + 1, position);
+            if (claimed == position) {
+                return slot;
+            }
+            position = claimed;
+        } else if (sequence < position) {
+            // The slot still holds the line from a lap ago.
+            SetEvent(INCALESCENT_Log.wake);
+            SwitchToThread();
+            position = INCALESCENT_Log.enqueuePosition;
+        } else {
+            position = INCALESCENT_Log.enqueuePosition;
+        }
+    }
+}
+
+// Hands a claimed slot over to the logging thread, waking it up if it was waiting for lines.
+static void INCALESCENT_LogPublish(INCALESCENT_LogSlot *slot, LONG64 position) {
+    InterlockedExchange64(&slot->sequence, position + 1);
+    if (INCALESCENT_Log.sleeping && InterlockedExchange(&INCALESCENT_Log.sleeping, FALSE)) {
+        SetEvent(INCALESCENT_Log.wake);
+    }
+}
+
+// Takes every line out of the queue that is ready, in order, and writes them with as few calls
+// as possible. Returns whether there were any.
+static BOOL INCALESCENT_LogDrain(PWSTR batch) {
+    BOOL drained = FALSE;
+    SIZE_T batchLength = 0;
+
+    for (;;) {
+        LONG64 position = INCALESCENT_Log.dequeuePosition;
+        INCALESCENT_LogSlot *slot = &INCALESCENT_Log.slots[position % INCALESCENT_LOG_QUEUE_CAPACITY];
+        BOOL ready = slot->sequence == position + 1;
+        if (!ready || batchLength + slot->length > INCALESCENT_LOG_BATCH_LENGTH) {
+            if (batchLength != 0) {
+                HRESULT result = INCALESCENT_LogWriteW(INCALESCENT_Log.output, batch, batchLength);
+                if (FAILED(result) && SUCCEEDED(INCALESCENT_Log.failure)) {
+                    INCALESCENT_Log.failure = result;
+                }
+                batchLength = 0;
+            }
+            if (!ready) {
+                break;
+            }
+        }
+
+        CopyMemory(batch + batchLength, slot->text, sizeof(WCHAR) * slot->length);
+        batchLength += slot->length;
+        INCALESCENT_Log.dequeuePosition = position + 1;
+        InterlockedExchange64(&slot->sequence, position + INCALESCENT_LOG_QUEUE_CAPACITY);
+        drained = TRUE;
+    }
+
+    return drained;
+}
+
+static DWORD WINAPI INCALESCENT_LogThreadStart(PVOID parameter) {
+    PWSTR batch = parameter;
+
+    for (;;) {
+        if (INCALESCENT_LogDrain(batch)) {
+            continue;
+        }
+        if (INCALESCENT_Log.stopping) {
+            break;
+        }
+
+        // Say that a wake-up is needed before looking one last time, so that a line published in
+        // between is either seen here or wakes the thread up.
+        InterlockedExchange(&INCALESCENT_Log.sleeping, TRUE);
+        if (INCALESCENT_LogDrain(batch)) {
+            InterlockedExchange(&INCALESCENT_Log.sleeping, FALSE);
+            continue;
+        }
+        WaitForSingleObject(INCALESCENT_Log.wake, INFINITE);
+    }
+
+    // Lines logged right before stopping are still written.
+    INCALESCENT_LogDrain(batch);
+    return 0;
+}
+
+// Implementation for INCALESCENT_LogStart
+HRESULT INCALESCENT_LogStart(void) {
+    HRESULT result = S_OK;
+    PWSTR batch = NULL;
+
+    // The slots and the batch buffer are allocated together.
+    SIZE_T slotsSize = sizeof(INCALESCENT_LogSlot) * INCALESCENT_LOG_QUEUE_CAPACITY;
+    PBYTE memory = VirtualAlloc(NULL, slotsSize + (sizeof(WCHAR) * INCALESCENT_LOG_BATCH_LENGTH), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (memory == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
         goto cleanup;
     }
+    INCALESCENT_Log.slots = (INCALESCENT_LogSlot *) memory;
+    batch = (PWSTR) (memory + slotsSize);
+    for (LONG64 index = 0; index < INCALESCENT_LOG_QUEUE_CAPACITY; index++) {
+        INCALESCENT_Log.slots[index].sequence = index;
+    }
+    INCALESCENT_Log.enqueuePosition = 0;
+    INCALESCENT_Log.dequeuePosition = 0;
+    INCALESCENT_Log.sleeping = FALSE;
+    INCALESCENT_Log.stopping = FALSE;
+    INCALESCENT_Log.failure = S_OK;
+    INCALESCENT_Log.output = INCALESCENT_LogOutput();
 
-    SIZE_T logMessageSize;
-    result = StringCchLengthW(logMessage, INCALESCENT_LOG_MAX_MESSAGE_LENGTH, &logMessageSize);
+    INCALESCENT_Log.wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (INCALESCENT_Log.wake == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    INCALESCENT_Log.thread = CreateThread(NULL, 0, INCALESCENT_LogThreadStart, batch, 0, NULL);
+    if (INCALESCENT_Log.thread == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    cleanup:
     if (FAILED(result)) {
+        if (INCALESCENT_Log.wake != NULL) {
+            CloseHandle(INCALESCENT_Log.wake);
+            INCALESCENT_Log.wake = NULL;
+        }
+        if (memory != NULL) {
+            VirtualFree(memory, 0, MEM_RELEASE);
+        }
+        INCALESCENT_Log.slots = NULL;
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_LogStop
+HRESULT INCALESCENT_LogStop(void) {
+    HRESULT result = S_OK;
+
+    if (INCALESCENT_Log.thread != NULL) {
+        InterlockedExchange(&INCALESCENT_Log.stopping, TRUE);
+        SetEvent(INCALESCENT_Log.wake);
+        WaitForSingleObject(INCALESCENT_Log.thread, INFINITE);
+        CloseHandle(INCALESCENT_Log.thread);
+        CloseHandle(INCALESCENT_Log.wake);
+        VirtualFree(INCALESCENT_Log.slots, 0, MEM_RELEASE);
+        INCALESCENT_Log.thread = NULL;
+        INCALESCENT_Log.wake = NULL;
+        INCALESCENT_Log.slots = NULL;
+        result = INCALESCENT_Log.failure;
+    }
+
+    if (INCALESCENT_Log.file != NULL) {
+        CloseHandle(INCALESCENT_Log.file);
+        INCALESCENT_Log.file = NULL;
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_LogSetLevel
+void INCALESCENT_LogSetLevel(INCALESCENT_Log_Level level) {
+    InterlockedExchange(&INCALESCENT_Log.minimumLevel, level);
+}
+
+// Implementation for INCALESCENT_LogSetFile
+HRESULT INCALESCENT_LogSetFile(PCWSTR path) {
+    HRESULT result = S_OK;
+
+    if (INCALESCENT_Log.thread != NULL) {
+        result = E_UNEXPECTED;
         goto cleanup;
     }
 
-    DWORD charactersWritten;
-    BOOL writeResult = WriteConsoleW(console, logMessage, logMessageSize, &charactersWritten, NULL);
-    if (!writeResult) {
+    HANDLE file = CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
         result = HRESULT_FROM_WIN32(GetLastError());
         goto cleanup;
     }
+    if (INCALESCENT_Log.file != NULL) {
+        CloseHandle(INCALESCENT_Log.file);
+    }
+    INCALESCENT_Log.file = file;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_LogRawW
+HRESULT INCALESCENT_LogRawW(PWSTR message, const SIZE_T messageSize) {
+    if (INCALESCENT_Log.thread == NULL) {
+        return INCALESCENT_LogWriteW(INCALESCENT_LogOutput(), message, messageSize);
+    }
+
+    // Queue the text a slot at a time, so it stays in order with the lines around it.
+    SIZE_T remaining = messageSize;
+    while (remaining != 0) {
+        SIZE_T pieceSize = remaining < INCALESCENT_LOG_MAX_LINE_LENGTH ? remaining : INCALESCENT_LOG_MAX_LINE_LENGTH;
+        if (pieceSize < remaining && IS_HIGH_SURROGATE(message[pieceSize - 1])) {
+            pieceSize--;
+        }
+
+        INCALESCENT_LogSlot *slot = INCALESCENT_LogClaim();
+        LONG64 position = slot->sequence;
+        CopyMemory(slot->text, message, sizeof(WCHAR) * pieceSize);
+        slot->length = pieceSize;
+        INCALESCENT_LogPublish(slot, position);
+
+        message += pieceSize;
+        remaining -= pieceSize;
+    }
+    return S_OK;
+}
+
+// Logs a line at a level, queuing it if the logging thread is running.
+static HRESULT INCALESCENT_LogVFormattedW(INCALESCENT_Log_Level level, PCWSTR format, va_list parameters) {
+    HRESULT result = S_OK;
+
+    if ((LONG) level < INCALESCENT_Log.minimumLevel) {
+        goto cleanup;
+    }
+
+    if (INCALESCENT_Log.thread == NULL) {
+        WCHAR line[INCALESCENT_LOG_MAX_LINE_LENGTH];
+        SIZE_T length = 0;
+        result = INCALESCENT_LogFormatLine(line, level, format, parameters, &length);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_LogWriteW(INCALESCENT_LogOutput(), line, length);
+        goto cleanup;
+    }
+
+    // The line is formatted straight into its slot. A line that can't be formatted still has to be
+    // handed over, since the logging thread takes the slots in order, so it is left empty.
+    INCALESCENT_LogSlot *slot = INCALESCENT_LogClaim();
+    LONG64 position = slot->sequence;
+    result = INCALESCENT_LogFormatLine(slot->text, level, format, parameters, &slot->length);
+    if (FAILED(result)) {
+        slot->length = 0;
+    }
+    INCALESCENT_LogPublish(slot, position);
 
     cleanup:
     return result;
 }
 
+// Implementation for INCALESCENT_LogFormattedW
+HRESULT INCALESCENT_LogFormattedW(INCALESCENT_Log_Level level, PWSTR format, ...) {
+    va_list parameters;
+    va_start(parameters, format);
+    HRESULT result = INCALESCENT_LogVFormattedW(level, format, parameters);
+    va_end(parameters);
+    return result;
+}
+
+// Implementation for INCALESCENT_LogProgressW
+HRESULT INCALESCENT_LogProgressW(PWSTR format, ...) {
+    // Whichever thread moves the time of the last progress line forward gets to log it, and every
+    // other thread skips it without waiting.
+    LONG64 now = (LONG64) GetTickCount64();
+    LONG64 last = INCALESCENT_Log.lastProgress;
+    if (now - last < INCALESCENT_LOG_PROGRESS_INTERVAL_MS) {
+        return S_OK;
+    }
+    if (InterlockedCompareExchange64(&INCALESCENT_Log.lastProgress, now, last) != last) {
+        return S_OK;
+    }
+
+    va_list parameters;
+    va_start(parameters, format);
+    HRESULT result = INCALESCENT_LogVFormattedW(INCALESCENT_LOG_LEVEL_INFO, format, parameters);
+    va_end(parameters);
+    return result;
+}
+
 // Implementation for INCALESCENT_LogFormattedErrorResultW
 HRESULT INCALESCENT_LogFormattedErrorResultW(HRESULT failedResult) {
     HRESULT result = S_OK;
@@ -98,8 +439,16 @@ HRESULT INCALESCENT_LogFormattedErrorResultW(HRESULT failedResult) {
         goto cleanup;
     }
 
-    result = INCALESCENT_LogFormattedW(L"Error", L"Encountered error (0x%x): %s\n", failedResult, errorMessage);
+    // System messages end in a line break of their own, but the line gets one anyway.
+    while (formatResult > 0 && (errorMessage[formatResult - 1] == L'\r' || errorMessage[formatResult - 1] == L'\n')) {
+        errorMessage[--formatResult] = L'\0';
+    }
+
+    result = INCALESCENT_LogFormattedW(INCALESCENT_LOG_LEVEL_ERROR, L"Encountered error (0x%x): %s", failedResult, errorMessage);
 
     cleanup:
+    if (errorMessage != NULL) {
+        LocalFree(errorMessage);
+    }
     return result;
 }
@@ -24,21 +24,77 @@
 #ifndef INCALESCENT_LOG_H
 #define INCALESCENT_LOG_H
 #include "string.h"
+#include "platform.h"
 
 // Forward declarations from <windows.h>
-typedef long HRESULT;
 typedef unsigned short* PWSTR;
+typedef const unsigned short* PCWSTR;
 
-#define INCALESCENT_LOG_FORMAT_W L"[%02d-%02d-%d %02d:%02d:%02d] [%s] %s\n"
 #define INCALESCENT_LOG_MAX_HEADER_LENGTH 64
 #define INCALESCENT_LOG_MAX_MESSAGE_LENGTH 512
 
+// The number of lines the queue holds. A thread that logs while it is full waits for the logging
+// thread to catch up, so nothing is ever dropped.
+#define INCALESCENT_LOG_QUEUE_CAPACITY 256
+
+// The logging thread writes everything it takes off the queue at once, up to this many characters.
+#define INCALESCENT_LOG_BATCH_LENGTH (32 * 1024)
+
+// The least time between two progress lines.
+#define INCALESCENT_LOG_PROGRESS_INTERVAL_MS 1000
+
+typedef enum INCALESCENT_Log_Level {
+    // A line for every single data file.
+    INCALESCENT_LOG_LEVEL_DETAIL = 0,
+
+    // What a consolidation is doing and how far along it is.
+    INCALESCENT_LOG_LEVEL_INFO = 1,
+
+    INCALESCENT_LOG_LEVEL_ERROR = 2,
+} INCALESCENT_Log_Level;
+
+/**
+ * @brief Starts the logging thread.
+ *
+ * From then on, lines are queued and written by the logging thread in batches, so any number of
+ * threads can log at once without waiting on the console or on each other. Until it is started,
+ * and after it is stopped, every line is written right away.
+ *
+ * @return The result of starting the thread (S_OK if successful).
+ */
+HRESULT INCALESCENT_LogStart(void);
+
+/**
+ * @brief Writes every queued line and stops the logging thread.
+ *
+ * @return S_OK if every line was written, or the first error the logging thread ran into.
+ */
+HRESULT INCALESCENT_LogStop(void);
+
+// Leaves out every line below the given level.
+void INCALESCENT_LogSetLevel(INCALESCENT_Log_Level level);
+
+/**
+ * @brief Logs to a file instead of the standard output. The file is replaced, and is closed when
+ *        logging is stopped.
+ *
+ * Must be called before the logging thread is started.
+ */
+HRESULT INCALESCENT_LogSetFile(PCWSTR path);
+
 HRESULT INCALESCENT_LogRawW(PWSTR message, SIZE_T messageSize);
-HRESULT INCALESCENT_LogFormattedW(PWSTR levelString, PWSTR format, ...);
+HRESULT INCALESCENT_LogFormattedW(INCALESCENT_Log_Level level, PWSTR format, ...);
+
+// Logs an INFO line, unless another progress line was logged less than
+// INCALESCENT_LOG_PROGRESS_INTERVAL_MS ago. Meant to be called as often as anything changes.
+HRESULT INCALESCENT_LogProgressW(PWSTR format, ...);
+
 HRESULT INCALESCENT_LogFormattedErrorResultW(HRESULT failedResult);
 
 #define INCALESCENT_LOG_RAW_W(message) INCALESCENT_LogRawW(message, INCALESCENT_STRING_LENGTH(message))
-#define INCALESCENT_LOG_INFO_FORMATTED_W(format, ...) INCALESCENT_LogFormattedW(L"INFO", format, ##__VA_ARGS__)
+#define INCALESCENT_LOG_DETAIL_FORMATTED_W(format, ...) INCALESCENT_LogFormattedW(INCALESCENT_LOG_LEVEL_DETAIL, format, ##__VA_ARGS__)
+#define INCALESCENT_LOG_INFO_FORMATTED_W(format, ...) INCALESCENT_LogFormattedW(INCALESCENT_LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#define INCALESCENT_LOG_PROGRESS_W(format, ...) INCALESCENT_LogProgressW(format, ##__VA_ARGS__)
 #define INCALESCENT_LOG_FAILED_RESULT_W(result) INCALESCENT_LogFormattedErrorResultW(result)
 
 #endif //INCALESCENT_LOG_H
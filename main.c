@@ -22,12 +22,62 @@
  * SOFTWARE.
  */
 #include <windows.h>
+#include <shellapi.h>
 #include "main.h"
 #include "log.h"
+#include "perf.h"
 #include "file.h"
+#include "options.h"
 #include "dialog.h"
 #include "generated_error.h"
 
+// Signaled when the user presses Ctrl+C to end watch mode.
+static HANDLE INCALESCENT_Main_StopEvent = NULL;
+
+// Turns Ctrl+C and Ctrl+Break into a request to stop watching, so the table is flushed and closed
+// properly instead of the process being ended on the spot.
+static BOOL WINAPI INCALESCENT_Main_ConsoleHandler(DWORD controlType) {
+    if (controlType != CTRL_C_EVENT && controlType != CTRL_BREAK_EVENT) {
+        return FALSE;
+    }
+    SetEvent(INCALESCENT_Main_StopEvent);
+    return TRUE;
+}
+
+// Reads the optional command line arguments into the consolidation options. Unknown arguments
+// are rejected so that a typo doesn't silently fall back to the defaults.
+static HRESULT INCALESCENT_Main_ParseOptions(INCALESCENT_File_Options *options) {
+    HRESULT result = S_OK;
+    INT argumentCount = 0;
+
+    PWSTR *arguments = CommandLineToArgvW(GetCommandLineW(), &argumentCount);
+    if (arguments == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    // The first argument is the executable's path.
+    for (INT index = 1; index < argumentCount; index++) {
+        BOOL matched = FALSE;
+        result = INCALESCENT_Options_Parse(arguments, argumentCount, &index, options, &matched);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        if (matched) {
+            continue;
+        }
+
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    cleanup:
+    if (arguments != NULL) {
+        LocalFree(arguments);
+    }
+    return result;
+}
+
 INT WINAPI WinMain(HINSTANCE instance, HINSTANCE previousInstance, PSTR commandLineArguments, INT showCommand) {
     UNREFERENCED_PARAMETER(instance);
     UNREFERENCED_PARAMETER(previousInstance);
@@ -35,6 +85,7 @@ INT WINAPI WinMain(HINSTANCE instance, HINSTANCE previousInstance, PSTR commandL
     UNREFERENCED_PARAMETER(instance);
 
     HRESULT result = S_OK;
+    INCALESCENT_File_Options options = {0};
 
     // Print the license to the console
     result = INCALESCENT_LOG_RAW_W(INCALESCENT_LICENSE);
@@ -42,6 +93,30 @@ INT WINAPI WinMain(HINSTANCE instance, HINSTANCE previousInstance, PSTR commandL
         goto cleanup;
     }
 
+    result = INCALESCENT_Main_ParseOptions(&options);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // From here on, the workers hand their lines to the logging thread instead of writing them.
+    result = INCALESCENT_LogStart();
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    if (options.watch) {
+        INCALESCENT_Main_StopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (INCALESCENT_Main_StopEvent == NULL) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        if (!SetConsoleCtrlHandler(INCALESCENT_Main_ConsoleHandler, TRUE)) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        options.stopEvent = INCALESCENT_Main_StopEvent;
+    }
+
     presentFileChoices:
     result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Presenting file prompt for input directory...");
     if (FAILED(result)) {
@@ -88,7 +163,7 @@ INT WINAPI WinMain(HINSTANCE instance, HINSTANCE previousInstance, PSTR commandL
 
     // Read the files and write the data to the file.
     DWORD startTime = GetTickCount();
-    result = INCALESCENT_File_ReadAndWrite(sourcePath, destinationPath);
+    result = INCALESCENT_File_ReadAndWrite(sourcePath, destinationPath, &options);
     if (FAILED(result)) {
         if (result != INCALESCENT_ERROR_NO_DATA_FILES_FOUND) {
             goto cleanup;
@@ -128,5 +203,17 @@ INT WINAPI WinMain(HINSTANCE instance, HINSTANCE previousInstance, PSTR commandL
         result = INCALESCENT_LOG_FAILED_RESULT_W(result);
     }
 
+    // The performance report is logged as well, so it goes out before the log is stopped.
+    HRESULT perfResult = INCALESCENT_Perf_Report();
+    if (SUCCEEDED(result)) {
+        result = perfResult;
+    }
+
+    // Write whatever is still queued before exiting.
+    HRESULT logResult = INCALESCENT_LogStop();
+    if (SUCCEEDED(result)) {
+        result = logResult;
+    }
+
     return result;
 }
@@ -23,6 +23,7 @@
  */
 #ifndef INCALESCENT_MAIN_H
 #define INCALESCENT_MAIN_H
+
 #define INCALESCENT_LICENSE L"The MIT License\n" \
                             "\n" \
                             "Copyright (c) 2023 Daniel Landeros\n" \
@@ -0,0 +1,283 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <intrin.h>
+#include "match.h"
+#include "scan.h"
+
+struct INCALESCENT_Match {
+    DWORD keyCount;
+    DWORD classCount;
+
+    // The class of every byte value. Class 0 stands for all the bytes that don't appear in any key.
+    USHORT classes[256];
+
+    // The next state for every state and class, one row of classCount entries per state, and the
+    // keys that end in every state, including the ones that end in a suffix of it.
+    USHORT *transitions;
+    DWORD *outputs;
+
+    // A single key is searched for with the vectorized scan instead of the automaton.
+    const BYTE *keys[INCALESCENT_MATCH_MAX_KEYS];
+    SIZE_T keyLengths[INCALESCENT_MATCH_MAX_KEYS];
+};
+
+// Implementation for INCALESCENT_Match_Create
+HRESULT INCALESCENT_Match_Create(const BYTE *const *keys, const SIZE_T *keyLengths, DWORD keyCount, INCALESCENT_Arena *arena,
+                                 INCALESCENT_Match **match) {
+    HRESULT result = S_OK;
+    INCALESCENT_Match *intermediate = NULL;
+    PBYTE keyCopies = NULL;
+    USHORT *failures = NULL;
+    USHORT *queue = NULL;
+
+    // The trie has at most one state per key byte plus the root.
+    SIZE_T stateLimit = 1;
+    SIZE_T keyBytes = 0;
+    if (keyCount == 0 || keyCount > INCALESCENT_MATCH_MAX_KEYS) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+    for (DWORD key = 0; key < keyCount; key++) {
+        if (keyLengths[key] == 0) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        keyBytes += keyLengths[key];
+    }
+    stateLimit += keyBytes;
+    if (stateLimit > INCALESCENT_MATCH_MAX_STATES) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_Match), INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &intermediate);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(intermediate, sizeof(INCALESCENT_Match));
+    intermediate->keyCount = keyCount;
+
+    result = INCALESCENT_Arena_Allocate(arena, keyBytes, 1, (PVOID *) &keyCopies);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    intermediate->classCount = 1;
+    for (DWORD key = 0; key < keyCount; key++) {
+        CopyMemory(keyCopies, keys[key], keyLengths[key]);
+        intermediate->keys[key] = keyCopies;
+        intermediate->keyLengths[key] = keyLengths[key];
+        keyCopies += keyLengths[key];
+
+        for (SIZE_T index = 0; index < keyLengths[key]; index++) {
+            if (intermediate->classes[keys[key][index]] == 0) {
+                intermediate->classes[keys[key][index]] = (USHORT) intermediate->classCount++;
+            }
+        }
+    }
+
+    DWORD classCount = intermediate->classCount;
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(USHORT) * stateLimit * classCount, INCALESCENT_ARENA_DEFAULT_ALIGNMENT,
+                                        (PVOID *) &intermediate->transitions);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * stateLimit, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &intermediate->outputs);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    USHORT *transitions = intermediate->transitions;
+    DWORD *outputs = intermediate->outputs;
+    ZeroMemory(transitions, sizeof(USHORT) * stateLimit * classCount);
+    ZeroMemory(outputs, sizeof(DWORD) * stateLimit);
+
+    // Build the trie of the keys. No edge of the trie leads back to the root, so a zero entry
+    // means there is no edge yet.
+    DWORD stateCount = 1;
+    for (DWORD key = 0; key < keyCount; key++) {
+        DWORD state = 0;
+        for (SIZE_T index = 0; index < keyLengths[key]; index++) {
+            USHORT *next = &transitions[(state * classCount) + intermediate->classes[keys[key][index]]];
+            if (*next == 0) {
+                *next = (USHORT) stateCount++;
+            }
+            state = *next;
+        }
+        outputs[state] |= 1UL << key;
+    }
+
+    // The failure links and the queue are only needed while the automaton is built.
+    SIZE_T mark = INCALESCENT_Arena_Mark(arena);
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(USHORT) * stateCount, sizeof(USHORT), (PVOID *) &failures);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(USHORT) * stateCount, sizeof(USHORT), (PVOID *) &queue);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // Visit the states breadth-first, so the failure state of every state is complete by the time
+    // it is needed. The missing edges of a state are taken from its failure state, which turns the
+    // trie into a machine that never has to backtrack. The root's missing edges already lead back
+    // to the root, and class 0 leads back to the root from everywhere.
+    DWORD head = 0;
+    DWORD tail = 0;
+    for (DWORD column = 1; column < classCount; column++) {
+        USHORT child = transitions[column];
+        if (child != 0) {
+            failures[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+    while (head < tail) {
+        DWORD state = queue[head++];
+        USHORT *row = &transitions[state * classCount];
+        const USHORT *failureRow = &transitions[failures[state] * classCount];
+        for (DWORD column = 1; column < classCount; column++) {
+            USHORT child = row[column];
+            if (child == 0) {
+                row[column] = failureRow[column];
+                continue;
+            }
+            failures[child] = failureRow[column];
+            outputs[child] |= outputs[failures[child]];
+            queue[tail++] = child;
+        }
+    }
+    INCALESCENT_Arena_Reset(arena, mark);
+
+    *match = intermediate;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Match_Find
+DWORD INCALESCENT_Match_Find(const INCALESCENT_Match *match, const BYTE *data, SIZE_T size, const BYTE **ends) {
+    INCALESCENT_Match_Stream stream;
+
+    for (DWORD key = 0; key < match->keyCount; key++) {
+        ends[key] = NULL;
+    }
+
+    INCALESCENT_Match_Begin(match, &stream);
+    DWORD found = INCALESCENT_Match_Feed(match, &stream, data, size, ends);
+    DWORD foundCount = 0;
+    for (; found != 0; found &= found - 1) {
+        foundCount++;
+    }
+    return foundCount;
+}
+
+// Implementation for INCALESCENT_Match_Begin
+void INCALESCENT_Match_Begin(const INCALESCENT_Match *match, INCALESCENT_Match_Stream *stream) {
+    stream->state = 0;
+    stream->remaining = match->keyCount == 32 ? 0xFFFFFFFFUL : (1UL << match->keyCount) - 1;
+}
+
+// Runs the automaton over a buffer, recording the keys that end in it.
+static DWORD INCALESCENT_Match_Run(const INCALESCENT_Match *match, INCALESCENT_Match_Stream *stream, const BYTE *data, SIZE_T size,
+                                   const BYTE **ends) {
+    const USHORT *transitions = match->transitions;
+    const DWORD *outputs = match->outputs;
+    const USHORT *classes = match->classes;
+    DWORD classCount = match->classCount;
+    DWORD remaining = stream->remaining;
+    DWORD found = 0;
+    DWORD state = stream->state;
+
+    for (SIZE_T index = 0; index < size; index++) {
+        state = transitions[(state * classCount) + classes[data[index]]];
+        DWORD hits = outputs[state] & remaining;
+        if (hits == 0) {
+            continue;
+        }
+
+        // Only the first occurrence of a key counts, so it drops out of the mask once found.
+        remaining &= ~hits;
+        found |= hits;
+        do {
+            unsigned long key;
+            _BitScanForward(&key, hits);
+            ends[key] = data + index + 1;
+            hits &= hits - 1;
+        } while (hits != 0);
+
+        if (remaining == 0) {
+            break;
+        }
+    }
+
+    stream->state = state;
+    stream->remaining = remaining;
+    return found;
+}
+
+// Implementation for INCALESCENT_Match_Feed
+DWORD INCALESCENT_Match_Feed(const INCALESCENT_Match *match, INCALESCENT_Match_Stream *stream, const BYTE *data, SIZE_T size,
+                             const BYTE **ends) {
+    if (stream->remaining == 0) {
+        return 0;
+    }
+    if (match->keyCount != 1) {
+        return INCALESCENT_Match_Run(match, stream, data, size, ends);
+    }
+
+    // A single key is searched for with the vectorized scan. Only an occurrence that began in the
+    // previous buffer needs the automaton, and it has to end within the first keyLength - 1 bytes.
+    SIZE_T keyLength = match->keyLengths[0];
+    SIZE_T carried = keyLength - 1;
+    if (stream->state != 0) {
+        SIZE_T head = size < carried ? size : carried;
+        DWORD found = INCALESCENT_Match_Run(match, stream, data, head, ends);
+        if (found != 0 || head == size) {
+            return found;
+        }
+    }
+
+    const BYTE *occurrence = INCALESCENT_Scan_Find(data, size, match->keys[0], keyLength);
+    if (occurrence != NULL) {
+        ends[0] = occurrence + keyLength;
+        stream->remaining = 0;
+        return 1;
+    }
+
+    // No occurrence ends in this buffer, so the state only depends on its last keyLength - 1 bytes,
+    // which the automaton picks up from the root.
+    SIZE_T tail = size < carried ? size : carried;
+    stream->state = 0;
+    INCALESCENT_Match_Run(match, stream, data + size - tail, tail, ends);
+    return 0;
+}
+
+// Implementation for INCALESCENT_Match_KeyCount
+DWORD INCALESCENT_Match_KeyCount(const INCALESCENT_Match *match) {
+    return match->keyCount;
+}
+
+// Implementation for INCALESCENT_Match_KeyLength
+SIZE_T INCALESCENT_Match_KeyLength(const INCALESCENT_Match *match, DWORD key) {
+    return match->keyLengths[key];
+}
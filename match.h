@@ -0,0 +1,107 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_MATCH_H
+#define INCALESCENT_MATCH_H
+#include "arena.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef unsigned char BYTE;
+typedef unsigned __int64 SIZE_T;
+
+// Every key owns one bit of the mask of keys a state matches.
+#define INCALESCENT_MATCH_MAX_KEYS 32
+
+// States are stored as 16-bit numbers to keep the transition table small enough for the L1 cache.
+#define INCALESCENT_MATCH_MAX_STATES 65535
+
+typedef struct INCALESCENT_Match INCALESCENT_Match;
+
+// Where a scan over several buffers is, so a key that straddles two of them is still found.
+typedef struct INCALESCENT_Match_Stream {
+    DWORD state;
+
+    // The keys that haven't been found yet.
+    DWORD remaining;
+} INCALESCENT_Match_Stream;
+
+/**
+ * @brief Compiles a set of keys into an Aho-Corasick automaton.
+ *
+ * The automaton is a complete state machine, so a scan takes exactly one table lookup per byte no
+ * matter how many keys there are. Bytes that don't appear in any key share a single column of the
+ * table, which keeps it to a few kilobytes for typical keys. The keys are copied, so they don't
+ * have to outlive the call.
+ *
+ * @param[in] keys          The keys. A key may occur within another one.
+ * @param[in] keyLengths    The length of every key in bytes. Each must be at least 1.
+ * @param[in] keyCount      The number of keys, at most INCALESCENT_MATCH_MAX_KEYS.
+ * @param[in] arena         The arena the automaton is allocated from. It lives as long as the arena.
+ * @param[out] match        Receives the automaton.
+ *
+ * @return S_OK if successful, or E_INVALIDARG if there are too many keys or they are too long.
+ */
+HRESULT INCALESCENT_Match_Create(const BYTE *const *keys, const SIZE_T *keyLengths, DWORD keyCount, INCALESCENT_Arena *arena,
+                                 INCALESCENT_Match **match);
+
+/**
+ * @brief Finds the first occurrence of every key within a byte buffer in a single pass.
+ *
+ * The scan stops as soon as every key has been found.
+ *
+ * @param[in] match     The automaton.
+ * @param[in] data      The buffer to search.
+ * @param[in] size      The size of the buffer in bytes.
+ * @param[out] ends     Receives, for every key in the order it was given, a pointer to the byte
+ *                      right after its first occurrence, or NULL if it doesn't occur.
+ *
+ * @return The number of keys found.
+ */
+DWORD INCALESCENT_Match_Find(const INCALESCENT_Match *match, const BYTE *data, SIZE_T size, const BYTE **ends);
+
+// Starts a scan over several buffers, as if they were one.
+void INCALESCENT_Match_Begin(const INCALESCENT_Match *match, INCALESCENT_Match_Stream *stream);
+
+/**
+ * @brief Continues a scan with the next buffer.
+ *
+ * A key that begins in an earlier buffer and ends in this one is found here. Only the first
+ * occurrence of every key counts, and the scan stops as soon as every key has been found.
+ *
+ * @param[in] match         The automaton.
+ * @param[in,out] stream    The scan, started with INCALESCENT_Match_Begin.
+ * @param[in] data          The next buffer.
+ * @param[in] size          The size of the buffer in bytes.
+ * @param[out] ends         Receives, for every key found in this buffer, a pointer to the byte
+ *                          right after it. The other entries are left alone.
+ *
+ * @return The mask of the keys found in this buffer, one bit per key in the order they were given.
+ */
+DWORD INCALESCENT_Match_Feed(const INCALESCENT_Match *match, INCALESCENT_Match_Stream *stream, const BYTE *data, SIZE_T size,
+                             const BYTE **ends);
+
+DWORD INCALESCENT_Match_KeyCount(const INCALESCENT_Match *match);
+SIZE_T INCALESCENT_Match_KeyLength(const INCALESCENT_Match *match, DWORD key);
+
+#endif //INCALESCENT_MATCH_H
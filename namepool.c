@@ -0,0 +1,379 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "namepool.h"
+#include "string.h"
+
+// The most bytes a record takes: the shared and stored lengths, the stored bytes, the size and the
+// last write time.
+#define INCALESCENT_NAMEPOOL_MAX_RECORD_SIZE (2 * 5 + INCALESCENT_NAMEPOOL_MAX_NAME_SIZE + 10 + sizeof(ULONGLONG))
+
+// The most the entries and the order of the most names take, the order with room for one more.
+#define INCALESCENT_NAMEPOOL_MAX_ENTRIES_SIZE (INCALESCENT_NAMEPOOL_MAX_NAMES * sizeof(INCALESCENT_NamePool_Entry))
+#define INCALESCENT_NAMEPOOL_MAX_ORDER_SIZE ((INCALESCENT_NAMEPOOL_MAX_NAMES + 1) * sizeof(DWORD))
+
+// Implementation for INCALESCENT_NamePool_Create
+HRESULT INCALESCENT_NamePool_Create(INCALESCENT_NamePool *names) {
+    ZeroMemory(names, sizeof(INCALESCENT_NamePool));
+
+    HRESULT result = INCALESCENT_Arena_Create(&names->bytes, INCALESCENT_NAMEPOOL_INITIAL_RESERVE);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_Arena_Create(&names->entryArena, INCALESCENT_NAMEPOOL_INITIAL_RESERVE);
+    }
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_Arena_Create(&names->orderArena, INCALESCENT_NAMEPOOL_INITIAL_RESERVE);
+    }
+    return result;
+}
+
+// Allocates from an arena of the pool, moving it into a reservation twice as large whenever it is
+// full, but never into one larger than the limit. Everything in the pool is found by an index or an
+// offset, so nothing points into the arenas.
+static HRESULT INCALESCENT_NamePool_Allocate(INCALESCENT_Arena *arena, SIZE_T limit, SIZE_T size, SIZE_T alignment, PVOID *allocation) {
+    HRESULT result = INCALESCENT_Arena_Allocate(arena, size, alignment, allocation);
+    while (result == E_OUTOFMEMORY && arena->reserved < limit) {
+        SIZE_T reserveSize = arena->reserved > limit / 2 ? limit : arena->reserved * 2;
+        result = INCALESCENT_Arena_Grow(arena, reserveSize);
+        if (SUCCEEDED(result)) {
+            result = INCALESCENT_Arena_Allocate(arena, size, alignment, allocation);
+        }
+    }
+    return result;
+}
+
+// Encodes UTF-16 code units as UTF-8. A surrogate pair becomes the 4 bytes of its code point, and an
+// unpaired surrogate the 3 bytes of its own value. Returns the number of bytes.
+static SIZE_T INCALESCENT_NamePool_Encode(PCWSTR name, SIZE_T length, BYTE *encoded) {
+    SIZE_T size = 0;
+
+    for (SIZE_T index = 0; index < length; index++) {
+        DWORD unit = name[index];
+        if (unit < 0x80) {
+            encoded[size++] = (BYTE) unit;
+        } else if (unit < 0x800) {
+            encoded[size++] = (BYTE) (0xC0 | (unit >> 6));
+            encoded[size++] = (BYTE) (0x80 | (unit & 0x3F));
+        } else if (unit >= 0xD800 && unit < 0xDC00 && index + 1 < length && name[index + 1] >= 0xDC00 && name[index + 1] < 0xE000) {
+            DWORD codePoint = 0x10000 + ((unit - 0xD800) << 10) + (name[index + 1] - 0xDC00);
+            encoded[size++] = (BYTE) (0xF0 | (codePoint >> 18));
+            encoded[size++] = (BYTE) (0x80 | ((codePoint >> 12) & 0x3F));
+            encoded[size++] = (BYTE) (0x80 | ((codePoint >> 6) & 0x3F));
+            encoded[size++] = (BYTE) (0x80 | (codePoint & 0x3F));
+            index++;
+        } else {
+            encoded[size++] = (BYTE) (0xE0 | (unit >> 12));
+            encoded[size++] = (BYTE) (0x80 | ((unit >> 6) & 0x3F));
+            encoded[size++] = (BYTE) (0x80 | (unit & 0x3F));
+        }
+    }
+    return size;
+}
+
+// Decodes what INCALESCENT_NamePool_Encode encoded and terminates it. Returns the number of code units.
+static SIZE_T INCALESCENT_NamePool_Decode(const BYTE *encoded, SIZE_T size, PWSTR name) {
+    SIZE_T length = 0;
+
+    for (SIZE_T index = 0; index < size;) {
+        BYTE lead = encoded[index];
+        if (lead < 0x80) {
+            name[length++] = lead;
+            index++;
+        } else if (lead < 0xE0) {
+            name[length++] = (WCHAR) (((lead & 0x1F) << 6) | (encoded[index + 1] & 0x3F));
+            index += 2;
+        } else if (lead < 0xF0) {
+            name[length++] = (WCHAR) (((lead & 0x0F) << 12) | ((encoded[index + 1] & 0x3F) << 6) | (encoded[index + 2] & 0x3F));
+            index += 3;
+        } else {
+            DWORD codePoint = ((lead & 0x07) << 18) | ((encoded[index + 1] & 0x3F) << 12) | ((encoded[index + 2] & 0x3F) << 6) |
+                              (encoded[index + 3] & 0x3F);
+            codePoint -= 0x10000;
+            name[length++] = (WCHAR) (0xD800 + (codePoint >> 10));
+            name[length++] = (WCHAR) (0xDC00 + (codePoint & 0x3FF));
+            index += 4;
+        }
+    }
+    name[length] = L'\0';
+    return length;
+}
+
+// Writes a number 7 bits at a time, lowest first, with the high bit set on every byte but the last.
+static BYTE *INCALESCENT_NamePool_PutVarint(BYTE *output, ULONGLONG value) {
+    while (value >= 0x80) {
+        *output++ = (BYTE) (value | 0x80);
+        value >>= 7;
+    }
+    *output++ = (BYTE) value;
+    return output;
+}
+
+static const BYTE *INCALESCENT_NamePool_GetVarint(const BYTE *input, ULONGLONG *value) {
+    ULONGLONG result = 0;
+    DWORD shift = 0;
+    for (;;) {
+        BYTE byte = *input++;
+        result |= (ULONGLONG) (byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            break;
+        }
+        shift += 7;
+    }
+    *value = result;
+    return input;
+}
+
+static BOOL INCALESCENT_NamePool_IsDigit(BYTE character) {
+    return character >= '0' && character <= '9';
+}
+
+// Implementation for INCALESCENT_NamePool_Append
+HRESULT INCALESCENT_NamePool_Append(INCALESCENT_NamePool *names, PCWSTR name, SIZE_T length, ULONGLONG size, ULONGLONG lastWriteTime) {
+    HRESULT result = S_OK;
+    BYTE encoded[INCALESCENT_NAMEPOOL_MAX_NAME_SIZE];
+    BYTE buffer[INCALESCENT_NAMEPOOL_MAX_RECORD_SIZE];
+    BYTE *record = NULL;
+    INCALESCENT_NamePool_Entry *entry = NULL;
+
+    if (length >= INCALESCENT_NAMEPOOL_MAX_NAME_LENGTH) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+    if (names->count == INCALESCENT_NAMEPOOL_MAX_NAMES) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+    SIZE_T encodedSize = INCALESCENT_NamePool_Encode(name, length, encoded);
+
+    // The numeric suffix is the last run of digits, wherever it is in the name.
+    SIZE_T digitsEnd = encodedSize;
+    while (digitsEnd > 0 && !INCALESCENT_NamePool_IsDigit(encoded[digitsEnd - 1])) {
+        digitsEnd--;
+    }
+    SIZE_T digitsBegin = digitsEnd;
+    while (digitsBegin > 0 && INCALESCENT_NamePool_IsDigit(encoded[digitsBegin - 1])) {
+        digitsBegin--;
+    }
+    ULONGLONG number = INCALESCENT_NAMEPOOL_NO_NUMBER;
+    if (digitsEnd != digitsBegin && digitsEnd - digitsBegin <= INCALESCENT_NAMEPOOL_MAX_NUMBER_DIGITS) {
+        number = 0;
+        for (SIZE_T index = digitsBegin; index < digitsEnd; index++) {
+            number = (number * 10) + (encoded[index] - '0');
+        }
+    }
+
+    // Names that only differ in their numbers sort by them, as long as what surrounds the numbers
+    // is plain ASCII, which can't be taken for part of a number.
+    if (names->count == 0) {
+        CopyMemory(names->first, encoded, encodedSize);
+        names->firstSize = encodedSize;
+        names->stemSize = digitsBegin;
+        names->tailSize = encodedSize - digitsEnd;
+        names->uniform = number != INCALESCENT_NAMEPOOL_NO_NUMBER && (digitsBegin == 0 || encoded[digitsBegin - 1] < 0x80) &&
+                         (digitsEnd == encodedSize || encoded[digitsEnd] < 0x80);
+    } else if (names->uniform) {
+        names->uniform = number != INCALESCENT_NAMEPOOL_NO_NUMBER && digitsBegin == names->stemSize && encodedSize - digitsEnd == names->tailSize &&
+                         RtlEqualMemory(encoded, names->first, digitsBegin) &&
+                         RtlEqualMemory(encoded + digitsEnd, names->first + (names->firstSize - names->tailSize), names->tailSize);
+    }
+
+    SIZE_T shared = 0;
+    if (names->count % INCALESCENT_NAMEPOOL_RESTART_INTERVAL == 0) {
+        CopyMemory(names->head, encoded, encodedSize);
+        names->headSize = encodedSize;
+    } else {
+        while (shared < encodedSize && shared < names->headSize && encoded[shared] == names->head[shared]) {
+            shared++;
+        }
+    }
+
+    BYTE *output = INCALESCENT_NamePool_PutVarint(buffer, shared);
+    output = INCALESCENT_NamePool_PutVarint(output, encodedSize - shared);
+    CopyMemory(output, encoded + shared, encodedSize - shared);
+    output += encodedSize - shared;
+    output = INCALESCENT_NamePool_PutVarint(output, size);
+    CopyMemory(output, &lastWriteTime, sizeof(ULONGLONG));
+    output += sizeof(ULONGLONG);
+
+    // The records never grow beyond what 32-bit offsets can reach.
+    result = INCALESCENT_NamePool_Allocate(&names->bytes, INCALESCENT_NAMEPOOL_MAX_BYTES, output - buffer, 1, (PVOID *) &record);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    CopyMemory(record, buffer, output - buffer);
+
+    result = INCALESCENT_NamePool_Allocate(&names->entryArena, INCALESCENT_NAMEPOOL_MAX_ENTRIES_SIZE, sizeof(INCALESCENT_NamePool_Entry),
+                                           sizeof(ULONGLONG), (PVOID *) &entry);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    entry->number = number;
+    entry->offset = (DWORD) (record - names->bytes.base);
+    entry->length = (DWORD) length;
+    names->entries = (INCALESCENT_NamePool_Entry *) names->entryArena.base;
+    names->count++;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_NamePool_Get
+SIZE_T INCALESCENT_NamePool_Get(const INCALESCENT_NamePool *names, SIZE_T index, PWSTR name, ULONGLONG *size, ULONGLONG *lastWriteTime) {
+    BYTE encoded[INCALESCENT_NAMEPOOL_MAX_NAME_SIZE];
+    ULONGLONG shared = 0;
+    ULONGLONG stored = 0;
+    ULONGLONG fileSize = 0;
+
+    // The first name of the block is stored in full, so its shared length is zero.
+    const BYTE *head = names->bytes.base + names->entries[index - (index % INCALESCENT_NAMEPOOL_RESTART_INTERVAL)].offset;
+    head = INCALESCENT_NamePool_GetVarint(head, &shared);
+    head = INCALESCENT_NamePool_GetVarint(head, &stored);
+
+    const BYTE *record = names->bytes.base + names->entries[index].offset;
+    record = INCALESCENT_NamePool_GetVarint(record, &shared);
+    record = INCALESCENT_NamePool_GetVarint(record, &stored);
+    CopyMemory(encoded, head, shared);
+    CopyMemory(encoded + shared, record, stored);
+    record += stored;
+
+    record = INCALESCENT_NamePool_GetVarint(record, &fileSize);
+    if (size != NULL) {
+        *size = fileSize;
+    }
+    if (lastWriteTime != NULL) {
+        CopyMemory(lastWriteTime, record, sizeof(ULONGLONG));
+    }
+    return INCALESCENT_NamePool_Decode(encoded, shared + stored, name);
+}
+
+// Decodes the names for the sort keys of the general sort.
+static PCWSTR INCALESCENT_NamePool_Source(PVOID context, SIZE_T index, PWSTR buffer) {
+    INCALESCENT_NamePool_Get(context, index, buffer, NULL, NULL);
+    return buffer;
+}
+
+// Sorts the names of a uniform pool by their numbers, with a radix sort a byte at a time that skips
+// the bytes every number has in common. Returns S_FALSE if two names have the same number, which
+// only happens when they differ in leading zeros, so they need the general sort after all.
+static HRESULT INCALESCENT_NamePool_SortByNumber(INCALESCENT_NamePool *names, INCALESCENT_Arena *arena) {
+    HRESULT result = S_OK;
+    SIZE_T arenaMark = INCALESCENT_Arena_Mark(arena);
+    SIZE_T (*counts)[256] = NULL;
+    DWORD *scratch = NULL;
+    SIZE_T count = names->count;
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(SIZE_T) * 256 * sizeof(ULONGLONG), INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &counts);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * count, sizeof(DWORD), (PVOID *) &scratch);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(counts, sizeof(SIZE_T) * 256 * sizeof(ULONGLONG));
+    for (SIZE_T index = 0; index < count; index++) {
+        ULONGLONG number = names->entries[index].number;
+        for (DWORD digit = 0; digit < sizeof(ULONGLONG); digit++) {
+            counts[digit][(number >> (8 * digit)) & 0xFF]++;
+        }
+        names->order[index] = (DWORD) index;
+    }
+
+    DWORD *source = names->order;
+    DWORD *destination = scratch;
+    for (DWORD digit = 0; digit < sizeof(ULONGLONG); digit++) {
+        if (counts[digit][(names->entries[0].number >> (8 * digit)) & 0xFF] == count) {
+            continue;
+        }
+
+        SIZE_T offset = 0;
+        for (DWORD bucket = 0; bucket < 256; bucket++) {
+            SIZE_T bucketCount = counts[digit][bucket];
+            counts[digit][bucket] = offset;
+            offset += bucketCount;
+        }
+        for (SIZE_T index = 0; index < count; index++) {
+            DWORD name = source[index];
+            destination[counts[digit][(names->entries[name].number >> (8 * digit)) & 0xFF]++] = name;
+        }
+
+        DWORD *swap = source;
+        source = destination;
+        destination = swap;
+    }
+    if (source != names->order) {
+        CopyMemory(names->order, source, sizeof(DWORD) * count);
+    }
+
+    for (SIZE_T index = 1; index < count; index++) {
+        if (names->entries[names->order[index]].number == names->entries[names->order[index - 1]].number) {
+            result = S_FALSE;
+            break;
+        }
+    }
+
+    cleanup:
+    INCALESCENT_Arena_Reset(arena, arenaMark);
+    return result;
+}
+
+// Implementation for INCALESCENT_NamePool_Sort
+HRESULT INCALESCENT_NamePool_Sort(INCALESCENT_NamePool *names, INCALESCENT_Arena *arena, INCALESCENT_Pool *pool) {
+    INCALESCENT_Arena_Reset(&names->orderArena, 0);
+    names->order = NULL;
+    HRESULT result = INCALESCENT_NamePool_Allocate(&names->orderArena, INCALESCENT_NAMEPOOL_MAX_ORDER_SIZE, sizeof(DWORD) * (names->count + 1),
+                                                   sizeof(DWORD), (PVOID *) &names->order);
+    if (FAILED(result) || names->count == 0) {
+        return result;
+    }
+
+    if (names->uniform) {
+        result = INCALESCENT_NamePool_SortByNumber(names, arena);
+        if (result != S_FALSE) {
+            return result;
+        }
+    }
+    return INCALESCENT_String_NaturalOrder(names->count, INCALESCENT_NamePool_Source, names, names->order, arena, pool);
+}
+
+// Implementation for INCALESCENT_NamePool_Clear
+void INCALESCENT_NamePool_Clear(INCALESCENT_NamePool *names) {
+    INCALESCENT_Arena_Reset(&names->bytes, 0);
+    INCALESCENT_Arena_Reset(&names->entryArena, 0);
+    INCALESCENT_Arena_Reset(&names->orderArena, 0);
+    names->entries = NULL;
+    names->order = NULL;
+    names->count = 0;
+    names->headSize = 0;
+    names->uniform = FALSE;
+}
+
+// Implementation for INCALESCENT_NamePool_Destroy
+void INCALESCENT_NamePool_Destroy(INCALESCENT_NamePool *names) {
+    INCALESCENT_Arena_Destroy(&names->bytes);
+    INCALESCENT_Arena_Destroy(&names->entryArena);
+    INCALESCENT_Arena_Destroy(&names->orderArena);
+    names->entries = NULL;
+    names->order = NULL;
+    names->count = 0;
+}
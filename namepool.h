@@ -0,0 +1,156 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_NAMEPOOL_H
+#define INCALESCENT_NAMEPOOL_H
+#include "arena.h"
+#include "pool.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef unsigned char BYTE;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+typedef const WCHAR* PCWSTR;
+typedef int BOOL;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+// The longest name in characters including its null-terminating character, and in bytes once
+// encoded, where every UTF-16 code unit takes at most 3.
+#define INCALESCENT_NAMEPOOL_MAX_NAME_LENGTH 260
+#define INCALESCENT_NAMEPOOL_MAX_NAME_SIZE (3 * INCALESCENT_NAMEPOOL_MAX_NAME_LENGTH)
+
+// Every this many names, a name is stored in full, and the ones after it only store what follows
+// the prefix they share with it.
+#define INCALESCENT_NAMEPOOL_RESTART_INTERVAL 16
+
+// The records are found by 32-bit offsets, so they can't take more than 4 GiB.
+#define INCALESCENT_NAMEPOOL_MAX_BYTES (4ULL * 1024 * 1024 * 1024)
+#define INCALESCENT_NAMEPOOL_MAX_NAMES 0xFFFFFFFFULL
+
+// Every arena of a pool starts out reserving this much, and moves into a reservation twice as large
+// whenever it fills up, up to what the most names take.
+#define INCALESCENT_NAMEPOOL_INITIAL_RESERVE (16ULL * 1024 * 1024)
+
+// The numeric suffix of a name without one, or with more digits than fit into 64 bits.
+#define INCALESCENT_NAMEPOOL_NO_NUMBER ((ULONGLONG) -1)
+#define INCALESCENT_NAMEPOOL_MAX_NUMBER_DIGITS 19
+
+// A name of the pool. The record at offset holds the name's bytes after the prefix it shares with
+// the first name of its block, and its size and last write time.
+typedef struct INCALESCENT_NamePool_Entry {
+    // The value of the last run of digits in the name, or INCALESCENT_NAMEPOOL_NO_NUMBER.
+    ULONGLONG number;
+    DWORD offset;
+
+    // The length of the name in UTF-16 code units.
+    DWORD length;
+} INCALESCENT_NamePool_Entry;
+
+/**
+ * @brief A compact store of the names of a directory's data files.
+ *
+ * Names are stored as UTF-8, with the unpaired surrogates Windows allows in names encoded the same
+ * way as any other code unit, so every name comes back exactly as it went in. Names of time-lapse
+ * frames share long prefixes, so only every INCALESCENT_NAMEPOOL_RESTART_INTERVAL-th name is stored
+ * in full and the rest only store the bytes after the prefix they share with it. Any name decodes
+ * from just two records, no matter where it is.
+ *
+ * Every name also gets the value of its numeric suffix. When all names are the same apart from that
+ * number, which is what the frames of a single acquisition look like, they are sorted by the numbers
+ * alone, without any sort keys.
+ */
+typedef struct INCALESCENT_NamePool {
+    INCALESCENT_Arena bytes;
+    INCALESCENT_Arena entryArena;
+    INCALESCENT_NamePool_Entry *entries;
+    SIZE_T count;
+
+    // The index of every name in sorted order, once the pool has been sorted.
+    INCALESCENT_Arena orderArena;
+    DWORD *order;
+
+    // The first name of the current block, which the names after it share their prefixes with.
+    BYTE head[INCALESCENT_NAMEPOOL_MAX_NAME_SIZE];
+    SIZE_T headSize;
+
+    // The first name of the pool split around its numeric suffix, and whether every name since has
+    // been the same apart from that number.
+    BYTE first[INCALESCENT_NAMEPOOL_MAX_NAME_SIZE];
+    SIZE_T firstSize;
+    SIZE_T stemSize;
+    SIZE_T tailSize;
+    BOOL uniform;
+} INCALESCENT_NamePool;
+
+// Reserves the memory of a pool. It must be released with INCALESCENT_NamePool_Destroy.
+HRESULT INCALESCENT_NamePool_Create(INCALESCENT_NamePool *names);
+
+/**
+ * @brief Adds a name to the pool.
+ *
+ * @param[in] names         The pool.
+ * @param[in] name          The name.
+ * @param[in] length        The length of the name, which must be shorter than
+ *                          INCALESCENT_NAMEPOOL_MAX_NAME_LENGTH.
+ * @param[in] size          The size of the file.
+ * @param[in] lastWriteTime The last write time of the file.
+ *
+ * @return S_OK if successful, or E_OUTOFMEMORY once the pool is full.
+ */
+HRESULT INCALESCENT_NamePool_Append(INCALESCENT_NamePool *names, PCWSTR name, SIZE_T length, ULONGLONG size, ULONGLONG lastWriteTime);
+
+/**
+ * @brief Sorts the pool the way INCALESCENT_String_NaturalSort sorts strings, into its order array.
+ *
+ * @param[in] names     The pool.
+ * @param[in] arena     The arena the sort keys are allocated from, if it needs any. Everything
+ *                      allocated is released again before the function returns.
+ * @param[in] pool      The pool used to sort large pools in parallel. May be NULL.
+ *
+ * @return The result of the sort operation (S_OK if successful).
+ */
+HRESULT INCALESCENT_NamePool_Sort(INCALESCENT_NamePool *names, INCALESCENT_Arena *arena, INCALESCENT_Pool *pool);
+
+/**
+ * @brief Decodes a name of the pool.
+ *
+ * May be called from any number of threads at once, as long as the pool doesn't change.
+ *
+ * @param[in] names          The pool.
+ * @param[in] index          The index of the name, in the order the names were added.
+ * @param[out] name          Receives the null-terminated name. Must hold
+ *                           INCALESCENT_NAMEPOOL_MAX_NAME_LENGTH characters.
+ * @param[out] size          Receives the size of the file. May be NULL.
+ * @param[out] lastWriteTime Receives the last write time of the file. May be NULL.
+ *
+ * @return The length of the name.
+ */
+SIZE_T INCALESCENT_NamePool_Get(const INCALESCENT_NamePool *names, SIZE_T index, PWSTR name, ULONGLONG *size, ULONGLONG *lastWriteTime);
+
+// Removes every name, keeping the memory committed for the next directory.
+void INCALESCENT_NamePool_Clear(INCALESCENT_NamePool *names);
+void INCALESCENT_NamePool_Destroy(INCALESCENT_NamePool *names);
+
+#endif //INCALESCENT_NAMEPOOL_H
@@ -0,0 +1,145 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <stdlib.h>
+#include <math.h>
+#include "number.h"
+
+// The largest integer up to which every integer is an exact double.
+#define INCALESCENT_NUMBER_EXACT_INTEGER_LIMIT (1ULL << 53)
+
+// The largest power of ten that is an exact double.
+#define INCALESCENT_NUMBER_EXACT_POWER_LIMIT 22
+
+#define INCALESCENT_NUMBER_MAX_DIGITS 19
+
+static const DOUBLE INCALESCENT_Number_Powers[INCALESCENT_NUMBER_EXACT_POWER_LIMIT + 1] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Converts text the fast path can't handle exactly. The text has already been validated.
+static BOOL INCALESCENT_Number_ParseSlow(const BYTE *text, SIZE_T length, DOUBLE *value) {
+    CHAR buffer[INCALESCENT_NUMBER_MAX_LENGTH + 1];
+    if (length > INCALESCENT_NUMBER_MAX_LENGTH) {
+        return FALSE;
+    }
+    CopyMemory(buffer, text, length);
+    buffer[length] = '\0';
+
+    *value = strtod(buffer, NULL);
+    return isfinite(*value);
+}
+
+// Implementation for INCALESCENT_Number_Parse
+BOOL INCALESCENT_Number_Parse(const BYTE *text, SIZE_T length, DOUBLE *value) {
+    const BYTE *character = text;
+    const BYTE *end = text + length;
+    BOOL negative = FALSE;
+    ULONGLONG mantissa = 0;
+    SIZE_T digitCount = 0;
+    SIZE_T significantCount = 0;
+    LONGLONG exponent = 0;
+
+    if (character < end && (*character == '-' || *character == '+')) {
+        negative = *character == '-';
+        character++;
+    }
+
+    // Leading zeros don't count toward the significant digits, and every digit after the decimal
+    // point lowers the power of ten by one.
+    for (; character < end && *character >= '0' && *character <= '9'; character++, digitCount++) {
+        if (mantissa != 0 || *character != '0') {
+            if (significantCount < INCALESCENT_NUMBER_MAX_DIGITS) {
+                mantissa = (mantissa * 10) + (*character - '0');
+            } else {
+                exponent++;
+            }
+            significantCount++;
+        }
+    }
+    if (character < end && *character == '.') {
+        character++;
+        for (; character < end && *character >= '0' && *character <= '9'; character++, digitCount++) {
+            if (mantissa != 0 || *character != '0') {
+                if (significantCount < INCALESCENT_NUMBER_MAX_DIGITS) {
+                    mantissa = (mantissa * 10) + (*character - '0');
+                    exponent--;
+                }
+                significantCount++;
+            } else {
+                exponent--;
+            }
+        }
+    }
+    if (digitCount == 0) {
+        return FALSE;
+    }
+
+    if (character < end && (*character == 'e' || *character == 'E')) {
+        character++;
+        BOOL negativeExponent = FALSE;
+        if (character < end && (*character == '-' || *character == '+')) {
+            negativeExponent = *character == '-';
+            character++;
+        }
+        if (character == end) {
+            return FALSE;
+        }
+        LONGLONG written = 0;
+        for (; character < end && *character >= '0' && *character <= '9'; character++) {
+            // Anything this large over- or underflows regardless of the digits.
+            if (written < 100000) {
+                written = (written * 10) + (*character - '0');
+            }
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+    if (character != end) {
+        return FALSE;
+    }
+
+    if (mantissa == 0) {
+        *value = negative ? -0.0 : 0.0;
+        return TRUE;
+    }
+
+    // Digits beyond the first 19 were dropped, so only the slow path can round correctly. Otherwise
+    // a power of ten too large to be exact may still be split, as long as the digits times the
+    // excess stay an exact integer.
+    if (significantCount <= INCALESCENT_NUMBER_MAX_DIGITS && mantissa <= INCALESCENT_NUMBER_EXACT_INTEGER_LIMIT) {
+        while (exponent > INCALESCENT_NUMBER_EXACT_POWER_LIMIT && mantissa * 10 <= INCALESCENT_NUMBER_EXACT_INTEGER_LIMIT) {
+            mantissa *= 10;
+            exponent--;
+        }
+        if (exponent >= -INCALESCENT_NUMBER_EXACT_POWER_LIMIT && exponent <= INCALESCENT_NUMBER_EXACT_POWER_LIMIT) {
+            DOUBLE result = (DOUBLE) mantissa;
+            result = exponent < 0 ? result / INCALESCENT_Number_Powers[-exponent] : result * INCALESCENT_Number_Powers[exponent];
+            *value = negative ? -result : result;
+            return TRUE;
+        }
+    }
+
+    return INCALESCENT_Number_ParseSlow(text, length, value);
+}
@@ -0,0 +1,53 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_NUMBER_H
+#define INCALESCENT_NUMBER_H
+
+// Forward declarations from <windows.h>
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef double DOUBLE;
+typedef unsigned __int64 SIZE_T;
+
+// The longest text parsed by the slow path. Longer text is never a valid field value anyway.
+#define INCALESCENT_NUMBER_MAX_LENGTH 64
+
+/**
+ * @brief Parses decimal text into the nearest double.
+ *
+ * The text is an optional sign, digits with an optional decimal point and an optional exponent,
+ * with nothing before or after it. Text with at most 19 significant digits whose value and power
+ * of ten are both exact doubles, which covers every value the acquisition software writes, is
+ * converted with a single multiplication or division and so is correctly rounded. Anything else
+ * falls back to the C runtime's strtod, which is correctly rounded as well.
+ *
+ * @param[in] text      The text, which doesn't have to be null-terminated.
+ * @param[in] length    The length of the text in bytes.
+ * @param[out] value    Receives the value.
+ *
+ * @return TRUE if the text is a finite number, FALSE otherwise.
+ */
+BOOL INCALESCENT_Number_Parse(const BYTE *text, SIZE_T length, DOUBLE *value);
+
+#endif //INCALESCENT_NUMBER_H
@@ -0,0 +1,245 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include "options.h"
+
+// Implementation for INCALESCENT_Options_Parse
+HRESULT INCALESCENT_Options_Parse(PWSTR *arguments, INT argumentCount, INT *index, INCALESCENT_File_Options *options, BOOL *matched) {
+    HRESULT result = S_OK;
+    PWSTR argument = arguments[*index];
+    *matched = TRUE;
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_WORKERS, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        DWORD workerCount = 0;
+        for (PWSTR character = arguments[*index]; *character != L'\0'; character++) {
+            if (*character < L'0' || *character > L'9' || workerCount > INCALESCENT_ARGUMENT_WORKERS_MAX) {
+                result = E_INVALIDARG;
+                goto cleanup;
+            }
+            workerCount = (workerCount * 10) + (*character - L'0');
+        }
+        options->workerCount = workerCount;
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_ENCODING, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_ENCODING_UTF8, -1, TRUE) == CSTR_EQUAL) {
+            options->encoding = INCALESCENT_WRITER_ENCODING_UTF8;
+        } else if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_ENCODING_UTF16, -1, TRUE) == CSTR_EQUAL) {
+            options->encoding = INCALESCENT_WRITER_ENCODING_UTF16LE;
+        } else {
+            result = E_INVALIDARG;
+        }
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_FORMAT, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_FORMAT_CSV, -1, TRUE) == CSTR_EQUAL) {
+            options->format = INCALESCENT_FILE_FORMAT_CSV;
+        } else if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_FORMAT_COLUMNAR, -1, TRUE) == CSTR_EQUAL) {
+            options->format = INCALESCENT_FILE_FORMAT_COLUMNAR;
+        } else {
+            result = E_INVALIDARG;
+        }
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_SOURCE, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_SOURCE_METADATA, -1, TRUE) == CSTR_EQUAL) {
+            options->source = INCALESCENT_FILE_SOURCE_METADATA;
+        } else if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_SOURCE_TIFF, -1, TRUE) == CSTR_EQUAL) {
+            options->source = INCALESCENT_FILE_SOURCE_TIFF;
+        } else {
+            result = E_INVALIDARG;
+        }
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_READ, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_READ_AUTO, -1, TRUE) == CSTR_EQUAL) {
+            options->readMode = INCALESCENT_FILE_READ_MODE_AUTO;
+        } else if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_READ_OVERLAPPED, -1, TRUE) == CSTR_EQUAL) {
+            options->readMode = INCALESCENT_FILE_READ_MODE_OVERLAPPED;
+        } else if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_READ_MAPPED, -1, TRUE) == CSTR_EQUAL) {
+            options->readMode = INCALESCENT_FILE_READ_MODE_MAPPED;
+        } else {
+            result = E_INVALIDARG;
+        }
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_CACHE, -1, TRUE) == CSTR_EQUAL) {
+        options->cache = TRUE;
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_RECURSIVE, -1, TRUE) == CSTR_EQUAL) {
+        options->recursive = TRUE;
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_STATISTICS, -1, TRUE) == CSTR_EQUAL) {
+        options->statistics = TRUE;
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_PYRAMID, -1, TRUE) == CSTR_EQUAL) {
+        options->pyramid = TRUE;
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_WATCH, -1, TRUE) == CSTR_EQUAL) {
+        options->watch = TRUE;
+        goto cleanup;
+    }
+
+    // The budget is given in megabytes.
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_MEMORY_BUDGET, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount || arguments[*index + 1][0] == L'\0') {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        SIZE_T megabytes = 0;
+        for (PWSTR character = arguments[*index]; *character != L'\0'; character++) {
+            if (*character < L'0' || *character > L'9' || megabytes > INCALESCENT_ARGUMENT_MEMORY_BUDGET_MAX_MEGABYTES) {
+                result = E_INVALIDARG;
+                goto cleanup;
+            }
+            megabytes = (megabytes * 10) + (*character - L'0');
+        }
+        options->memoryBudget = megabytes * 1024 * 1024;
+        if (options->memoryBudget < INCALESCENT_FILE_MIN_MEMORY_BUDGET) {
+            result = E_INVALIDARG;
+        }
+        goto cleanup;
+    }
+
+    // Every field becomes a column, so its name can't contain the table's separator, and the key
+    // separator would make it a different key.
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_FIELD, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount || options->fieldCount == INCALESCENT_FILE_MAX_FIELDS) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        PWSTR field = arguments[*index];
+        if (field[0] == L'\0') {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        for (PWSTR character = field; *character != L'\0'; character++) {
+            if (*character == L',' || *character == L'=' || *character == L'\r' || *character == L'\n') {
+                result = E_INVALIDARG;
+                goto cleanup;
+            }
+        }
+        result = StringCchCopyW(options->fields[options->fieldCount], INCALESCENT_FILE_FIELD_NAME_MAX_LENGTH, field);
+        if (FAILED(result)) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        options->fieldCount++;
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_LOG_LEVEL, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_LOG_LEVEL_DETAIL, -1, TRUE) == CSTR_EQUAL) {
+            INCALESCENT_LogSetLevel(INCALESCENT_LOG_LEVEL_DETAIL);
+        } else if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_LOG_LEVEL_INFO, -1, TRUE) == CSTR_EQUAL) {
+            INCALESCENT_LogSetLevel(INCALESCENT_LOG_LEVEL_INFO);
+        } else if (CompareStringOrdinal(arguments[*index], -1, INCALESCENT_ARGUMENT_LOG_LEVEL_ERROR, -1, TRUE) == CSTR_EQUAL) {
+            INCALESCENT_LogSetLevel(INCALESCENT_LOG_LEVEL_ERROR);
+        } else {
+            result = E_INVALIDARG;
+        }
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_LOG_FILE, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        result = INCALESCENT_LogSetFile(arguments[*index]);
+        goto cleanup;
+    }
+
+    if (CompareStringOrdinal(argument, -1, INCALESCENT_ARGUMENT_PERF, -1, TRUE) == CSTR_EQUAL) {
+        if (*index + 1 == argumentCount) {
+            result = E_INVALIDARG;
+            goto cleanup;
+        }
+        (*index)++;
+
+        result = INCALESCENT_Perf_Start(arguments[*index]);
+        goto cleanup;
+    }
+
+    *matched = FALSE;
+
+    cleanup:
+    return result;
+}
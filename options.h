@@ -0,0 +1,85 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_OPTIONS_H
+#define INCALESCENT_OPTIONS_H
+#include "file.h"
+#include "log.h"
+#include "perf.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef int BOOL;
+typedef int INT;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+
+#define INCALESCENT_ARGUMENT_WORKERS L"--workers"
+#define INCALESCENT_ARGUMENT_WORKERS_MAX 1024
+#define INCALESCENT_ARGUMENT_ENCODING L"--encoding"
+#define INCALESCENT_ARGUMENT_ENCODING_UTF8 L"utf-8"
+#define INCALESCENT_ARGUMENT_ENCODING_UTF16 L"utf-16"
+#define INCALESCENT_ARGUMENT_FORMAT L"--format"
+#define INCALESCENT_ARGUMENT_FORMAT_CSV L"csv"
+#define INCALESCENT_ARGUMENT_FORMAT_COLUMNAR L"columnar"
+#define INCALESCENT_ARGUMENT_SOURCE L"--source"
+#define INCALESCENT_ARGUMENT_SOURCE_METADATA L"metadata"
+#define INCALESCENT_ARGUMENT_SOURCE_TIFF L"tiff"
+#define INCALESCENT_ARGUMENT_READ L"--read"
+#define INCALESCENT_ARGUMENT_READ_AUTO L"auto"
+#define INCALESCENT_ARGUMENT_READ_OVERLAPPED L"overlapped"
+#define INCALESCENT_ARGUMENT_READ_MAPPED L"mapped"
+#define INCALESCENT_ARGUMENT_CACHE L"--cache"
+#define INCALESCENT_ARGUMENT_RECURSIVE L"--recursive"
+#define INCALESCENT_ARGUMENT_STATISTICS L"--statistics"
+#define INCALESCENT_ARGUMENT_PYRAMID L"--pyramid"
+#define INCALESCENT_ARGUMENT_WATCH L"--watch"
+#define INCALESCENT_ARGUMENT_MEMORY_BUDGET L"--memory-budget"
+#define INCALESCENT_ARGUMENT_MEMORY_BUDGET_MAX_MEGABYTES (1024 * 1024)
+#define INCALESCENT_ARGUMENT_FIELD L"--field"
+#define INCALESCENT_ARGUMENT_LOG_LEVEL L"--log-level"
+#define INCALESCENT_ARGUMENT_LOG_LEVEL_DETAIL L"detail"
+#define INCALESCENT_ARGUMENT_LOG_LEVEL_INFO L"info"
+#define INCALESCENT_ARGUMENT_LOG_LEVEL_ERROR L"error"
+#define INCALESCENT_ARGUMENT_LOG_FILE L"--log-file"
+#define INCALESCENT_ARGUMENT_PERF L"--perf"
+
+/**
+ * @brief Parses one of the command line arguments every front end accepts.
+ *
+ * The logging and performance counter arguments apply to the process-wide log and counters right
+ * away, since there is only one of each.
+ *
+ * @param[in] arguments         The command line arguments.
+ * @param[in] argumentCount     The number of arguments.
+ * @param[in,out] index         The index of the argument to parse. Advanced past the argument's
+ *                              value if it takes one.
+ * @param[in,out] options       The options the argument is stored in.
+ * @param[out] matched          Receives FALSE if the argument isn't one of the common ones, in
+ *                              which case the caller has to handle it.
+ *
+ * @return S_OK if successful, or E_INVALIDARG if the argument's value is missing or malformed.
+ */
+HRESULT INCALESCENT_Options_Parse(PWSTR *arguments, INT argumentCount, INT *index, INCALESCENT_File_Options *options, BOOL *matched);
+
+#endif //INCALESCENT_OPTIONS_H
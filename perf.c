@@ -0,0 +1,308 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include "perf.h"
+#include "log.h"
+
+static const PCSTR INCALESCENT_Perf_PhaseNames[] = {"enumerate", "sort", "open", "read", "parse", "write", "cache"};
+static const PCSTR INCALESCENT_Perf_CounterNames[] = {"files_read", "bytes_read", "files_cached", "rows_written", "bytes_written", "allocations",
+                                                      "bytes_allocated"};
+
+// The samples recorded by the threads that share a slot, in performance counter ticks. Each slot
+// starts on a page of its own, so threads in different slots never touch the same cache line.
+typedef struct INCALESCENT_Perf_Slot {
+    volatile LONG64 buckets[INCALESCENT_PERF_PHASE_COUNT][INCALESCENT_PERF_BUCKETS];
+    volatile LONG64 totals[INCALESCENT_PERF_PHASE_COUNT];
+    volatile LONG64 maxima[INCALESCENT_PERF_PHASE_COUNT];
+    volatile LONG64 counters[INCALESCENT_PERF_COUNTER_COUNT];
+} INCALESCENT_Perf_Slot;
+
+typedef struct INCALESCENT_Perf_State {
+    // NULL unless the counters are collected.
+    INCALESCENT_Perf_Slot *slots;
+    HANDLE report;
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+} INCALESCENT_Perf_State;
+
+static INCALESCENT_Perf_State INCALESCENT_Perf = {0};
+
+#define INCALESCENT_PERF_PAGE_SIZE 4096
+#define INCALESCENT_PERF_SLOT_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+#define INCALESCENT_PERF_SLOT_SIZE (((sizeof(INCALESCENT_Perf_Slot) + INCALESCENT_PERF_PAGE_SIZE - 1) / INCALESCENT_PERF_PAGE_SIZE) * INCALESCENT_PERF_PAGE_SIZE)
+
+static INCALESCENT_Perf_Slot *INCALESCENT_Perf_SlotAt(DWORD index) {
+    return (PVOID) ((PBYTE) INCALESCENT_Perf.slots + (INCALESCENT_PERF_SLOT_SIZE * index));
+}
+
+// The slot of the calling thread. Nothing is promised about the bits of a thread ID, so the ID is
+// multiplied by a constant that spreads every bit of it into the high half of the product, which
+// picks the slot.
+static INCALESCENT_Perf_Slot *INCALESCENT_Perf_ThreadSlot(void) {
+    ULONGLONG hash = (ULONGLONG) GetCurrentThreadId() * INCALESCENT_PERF_SLOT_HASH_MULTIPLIER;
+    return INCALESCENT_Perf_SlotAt((DWORD) (hash >> 32) % INCALESCENT_PERF_SLOTS);
+}
+
+// The bucket a duration falls into. Durations below 2^(INCALESCENT_PERF_SUB_BUCKET_BITS + 1) get a
+// bucket each.
+static DWORD INCALESCENT_Perf_Bucket(ULONGLONG duration) {
+    if (duration < 2 * INCALESCENT_PERF_SUB_BUCKETS) {
+        return (DWORD) duration;
+    }
+
+    unsigned long highest;
+    _BitScanReverse64(&highest, duration);
+    DWORD shift = highest - INCALESCENT_PERF_SUB_BUCKET_BITS;
+    return 2 * INCALESCENT_PERF_SUB_BUCKETS + ((shift - 1) * INCALESCENT_PERF_SUB_BUCKETS) +
+           (DWORD) ((duration >> shift) & (INCALESCENT_PERF_SUB_BUCKETS - 1));
+}
+
+// The middle of the durations that fall into a bucket.
+static DOUBLE INCALESCENT_Perf_BucketMiddle(DWORD bucket) {
+    if (bucket < 2 * INCALESCENT_PERF_SUB_BUCKETS) {
+        return (DOUBLE) bucket;
+    }
+
+    DWORD offset = bucket - (2 * INCALESCENT_PERF_SUB_BUCKETS);
+    DWORD shift = (offset / INCALESCENT_PERF_SUB_BUCKETS) + 1;
+    ULONGLONG lowest = (ULONGLONG) (INCALESCENT_PERF_SUB_BUCKETS + (offset % INCALESCENT_PERF_SUB_BUCKETS)) << shift;
+    return (DOUBLE) lowest + ((DOUBLE) (1ULL << shift) / 2.0);
+}
+
+// Implementation for INCALESCENT_Perf_Start
+HRESULT INCALESCENT_Perf_Start(PCWSTR reportPath) {
+    HRESULT result = S_OK;
+
+    if (INCALESCENT_Perf.slots != NULL) {
+        result = E_UNEXPECTED;
+        goto cleanup;
+    }
+
+    INCALESCENT_Perf.report = CreateFileW(reportPath, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INCALESCENT_Perf.report == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        INCALESCENT_Perf.report = NULL;
+        goto cleanup;
+    }
+
+    // The pages come zeroed, which is where every counter starts.
+    INCALESCENT_Perf.slots = VirtualAlloc(NULL, INCALESCENT_PERF_SLOT_SIZE * INCALESCENT_PERF_SLOTS, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (INCALESCENT_Perf.slots == NULL) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        CloseHandle(INCALESCENT_Perf.report);
+        INCALESCENT_Perf.report = NULL;
+        goto cleanup;
+    }
+
+    QueryPerformanceFrequency(&INCALESCENT_Perf.frequency);
+    QueryPerformanceCounter(&INCALESCENT_Perf.start);
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Perf_Now
+ULONGLONG INCALESCENT_Perf_Now(void) {
+    if (INCALESCENT_Perf.slots == NULL) {
+        return 0;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (ULONGLONG) now.QuadPart;
+}
+
+// Implementation for INCALESCENT_Perf_Record
+void INCALESCENT_Perf_Record(INCALESCENT_Perf_Phase phase, ULONGLONG start) {
+    if (start == 0) {
+        return;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    LONG64 duration = (LONG64) ((ULONGLONG) now.QuadPart - start);
+
+    INCALESCENT_Perf_Slot *slot = INCALESCENT_Perf_ThreadSlot();
+    InterlockedIncrement64(&slot->buckets[phase][INCALESCENT_Perf_Bucket((ULONGLONG) duration)]);
+    InterlockedExchangeAdd64(&slot->totals[phase], duration);
+
+    LONG64 maximum = slot->maxima[phase];
+    while (duration > maximum) {
+        LONG64 previous = InterlockedCompareExchange64(&slot->maxima[phase], duration, maximum);
+        if (previous == maximum) {
+            break;
+        }
+        maximum = previous;
+    }
+}
+
+// Implementation for INCALESCENT_Perf_Count
+void INCALESCENT_Perf_Count(INCALESCENT_Perf_Counter counter, ULONGLONG amount) {
+    if (INCALESCENT_Perf.slots == NULL) {
+        return;
+    }
+    InterlockedExchangeAdd64(&INCALESCENT_Perf_ThreadSlot()->counters[counter], (LONG64) amount);
+}
+
+typedef struct INCALESCENT_Perf_Summary {
+    LONG64 count;
+    DOUBLE totalMilliseconds;
+    DOUBLE p50Microseconds;
+    DOUBLE p99Microseconds;
+    DOUBLE maxMicroseconds;
+} INCALESCENT_Perf_Summary;
+
+// Adds up the histograms of a phase over every slot and reads the percentiles off the sum.
+static void INCALESCENT_Perf_Summarize(INCALESCENT_Perf_Phase phase, INCALESCENT_Perf_Summary *summary) {
+    LONG64 buckets[INCALESCENT_PERF_BUCKETS] = {0};
+    LONG64 total = 0;
+    LONG64 maximum = 0;
+    DOUBLE microsecondsPerTick = 1000000.0 / (DOUBLE) INCALESCENT_Perf.frequency.QuadPart;
+
+    summary->count = 0;
+    for (DWORD index = 0; index < INCALESCENT_PERF_SLOTS; index++) {
+        INCALESCENT_Perf_Slot *slot = INCALESCENT_Perf_SlotAt(index);
+        for (DWORD bucket = 0; bucket < INCALESCENT_PERF_BUCKETS; bucket++) {
+            buckets[bucket] += slot->buckets[phase][bucket];
+            summary->count += slot->buckets[phase][bucket];
+        }
+        total += slot->totals[phase];
+        if (slot->maxima[phase] > maximum) {
+            maximum = slot->maxima[phase];
+        }
+    }
+
+    // A percentile is the middle of the bucket its sample falls into, which never exceeds the
+    // longest sample.
+    LONG64 p50Rank = (summary->count + 1) / 2;
+    LONG64 p99Rank = summary->count - (summary->count / 100);
+    LONG64 seen = 0;
+    summary->p50Microseconds = 0;
+    summary->p99Microseconds = 0;
+    for (DWORD bucket = 0; bucket < INCALESCENT_PERF_BUCKETS && seen < p99Rank; bucket++) {
+        if (buckets[bucket] == 0) {
+            continue;
+        }
+        DOUBLE middle = INCALESCENT_Perf_BucketMiddle(bucket);
+        if (middle > (DOUBLE) maximum) {
+            middle = (DOUBLE) maximum;
+        }
+        if (seen < p50Rank && seen + buckets[bucket] >= p50Rank) {
+            summary->p50Microseconds = middle * microsecondsPerTick;
+        }
+        seen += buckets[bucket];
+        if (seen >= p99Rank) {
+            summary->p99Microseconds = middle * microsecondsPerTick;
+        }
+    }
+
+    summary->totalMilliseconds = (DOUBLE) total * microsecondsPerTick / 1000.0;
+    summary->maxMicroseconds = (DOUBLE) maximum * microsecondsPerTick;
+}
+
+// Implementation for INCALESCENT_Perf_Report
+HRESULT INCALESCENT_Perf_Report(void) {
+    HRESULT result = S_OK;
+    CHAR report[INCALESCENT_PERF_REPORT_SIZE];
+    PSTR end = report;
+    SIZE_T remaining = INCALESCENT_PERF_REPORT_SIZE;
+
+    if (INCALESCENT_Perf.slots == NULL) {
+        goto cleanup;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    DOUBLE seconds = (DOUBLE) (now.QuadPart - INCALESCENT_Perf.start.QuadPart) / (DOUBLE) INCALESCENT_Perf.frequency.QuadPart;
+
+    result = StringCchPrintfExA(end, remaining, &end, &remaining, 0, "{\n  \"seconds\": %.6f,\n  \"phases\": {\n", seconds);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"%-10s %10s %12s %12s %12s %12s", L"Phase", L"Count", L"Total ms", L"p50 us", L"p99 us", L"Max us");
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (DWORD phase = 0; phase < INCALESCENT_PERF_PHASE_COUNT; phase++) {
+        INCALESCENT_Perf_Summary summary;
+        INCALESCENT_Perf_Summarize(phase, &summary);
+
+        result = StringCchPrintfExA(end, remaining, &end, &remaining, 0,
+                                    "    \"%s\": {\"count\": %lld, \"total_ms\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f}%s\n",
+                                    INCALESCENT_Perf_PhaseNames[phase], summary.count, summary.totalMilliseconds, summary.p50Microseconds,
+                                    summary.p99Microseconds, summary.maxMicroseconds, phase + 1 < INCALESCENT_PERF_PHASE_COUNT ? "," : "");
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"%-10hs %10lld %12.3f %12.3f %12.3f %12.3f", INCALESCENT_Perf_PhaseNames[phase], summary.count,
+                                                  summary.totalMilliseconds, summary.p50Microseconds, summary.p99Microseconds,
+                                                  summary.maxMicroseconds);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    result = StringCchPrintfExA(end, remaining, &end, &remaining, 0, "  },\n  \"counters\": {\n");
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    for (DWORD counter = 0; counter < INCALESCENT_PERF_COUNTER_COUNT; counter++) {
+        LONG64 value = 0;
+        for (DWORD index = 0; index < INCALESCENT_PERF_SLOTS; index++) {
+            INCALESCENT_Perf_Slot *slot = INCALESCENT_Perf_SlotAt(index);
+            value += slot->counters[counter];
+        }
+
+        result = StringCchPrintfExA(end, remaining, &end, &remaining, 0, "    \"%s\": %lld%s\n", INCALESCENT_Perf_CounterNames[counter], value,
+                                    counter + 1 < INCALESCENT_PERF_COUNTER_COUNT ? "," : "");
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"%-16hs %lld", INCALESCENT_Perf_CounterNames[counter], value);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    result = StringCchPrintfExA(end, remaining, &end, &remaining, 0, "  }\n}\n");
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    DWORD written;
+    if (!WriteFile(INCALESCENT_Perf.report, report, (DWORD) (end - report), &written, NULL)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    cleanup:
+    if (INCALESCENT_Perf.slots != NULL) {
+        VirtualFree(INCALESCENT_Perf.slots, 0, MEM_RELEASE);
+        CloseHandle(INCALESCENT_Perf.report);
+        ZeroMemory(&INCALESCENT_Perf, sizeof(INCALESCENT_Perf_State));
+    }
+    return result;
+}
@@ -0,0 +1,111 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_PERF_H
+#define INCALESCENT_PERF_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef unsigned __int64 ULONGLONG;
+typedef const unsigned short* PCWSTR;
+
+// Every thread records into one of this many slots, picked by its thread ID. A slot is only
+// contended when more threads than that are recording at once.
+#define INCALESCENT_PERF_SLOTS 64
+
+// A duration's bucket is its highest set bit together with the next INCALESCENT_PERF_SUB_BUCKET_BITS
+// bits, so a percentile read off the histogram is within 1 / 2^INCALESCENT_PERF_SUB_BUCKET_BITS of
+// the true one.
+#define INCALESCENT_PERF_SUB_BUCKET_BITS 3
+#define INCALESCENT_PERF_SUB_BUCKETS (1 << INCALESCENT_PERF_SUB_BUCKET_BITS)
+#define INCALESCENT_PERF_BUCKETS (2 * INCALESCENT_PERF_SUB_BUCKETS + (63 - INCALESCENT_PERF_SUB_BUCKET_BITS) * INCALESCENT_PERF_SUB_BUCKETS)
+
+// The most bytes the JSON report takes.
+#define INCALESCENT_PERF_REPORT_SIZE (8 * 1024)
+
+typedef enum INCALESCENT_Perf_Phase {
+    // Listing a directory, or waiting for the walk to list the next ones.
+    INCALESCENT_PERF_PHASE_ENUMERATE = 0,
+    INCALESCENT_PERF_PHASE_SORT,
+
+    // Opening a data file, or mapping it.
+    INCALESCENT_PERF_PHASE_OPEN,
+
+    // A read from the moment it was queued until it completed, or prefetching a batch of mapped files.
+    INCALESCENT_PERF_PHASE_READ,
+
+    // Scanning what was read of a data file for its fields, and parsing them.
+    INCALESCENT_PERF_PHASE_PARSE,
+
+    // Building and writing a whole table.
+    INCALESCENT_PERF_PHASE_WRITE,
+
+    // Loading or saving a cache sidecar.
+    INCALESCENT_PERF_PHASE_CACHE,
+
+    INCALESCENT_PERF_PHASE_COUNT,
+} INCALESCENT_Perf_Phase;
+
+typedef enum INCALESCENT_Perf_Counter {
+    INCALESCENT_PERF_COUNTER_FILES_READ = 0,
+    INCALESCENT_PERF_COUNTER_BYTES_READ,
+    INCALESCENT_PERF_COUNTER_FILES_CACHED,
+    INCALESCENT_PERF_COUNTER_ROWS_WRITTEN,
+    INCALESCENT_PERF_COUNTER_BYTES_WRITTEN,
+    INCALESCENT_PERF_COUNTER_ALLOCATIONS,
+    INCALESCENT_PERF_COUNTER_BYTES_ALLOCATED,
+    INCALESCENT_PERF_COUNTER_COUNT,
+} INCALESCENT_Perf_Counter;
+
+/**
+ * @brief Starts collecting performance counters for the whole process.
+ *
+ * Until it is started, every other function does nothing at all, so the counters cost a single
+ * branch where they are recorded. The report is written to the given file at the end, which is
+ * replaced right away so that a path that can't be written is caught before any work is done.
+ *
+ * @param[in] reportPath    The file the JSON report is written to.
+ *
+ * @return The result of creating the file and the counters (S_OK if successful).
+ */
+HRESULT INCALESCENT_Perf_Start(PCWSTR reportPath);
+
+// Returns a timestamp to pass to INCALESCENT_Perf_Record, or 0 if the counters aren't collected.
+ULONGLONG INCALESCENT_Perf_Now(void);
+
+// Records the time since start, taken with INCALESCENT_Perf_Now, as one sample of the phase.
+void INCALESCENT_Perf_Record(INCALESCENT_Perf_Phase phase, ULONGLONG start);
+
+void INCALESCENT_Perf_Count(INCALESCENT_Perf_Counter counter, ULONGLONG amount);
+
+/**
+ * @brief Writes the report and logs it as a table, then stops collecting.
+ *
+ * The report holds the number of samples, total time and the 50th and 99th percentile and maximum
+ * duration of every phase, and every counter. Does nothing if the counters aren't collected.
+ *
+ * @return The result of writing the report (S_OK if successful).
+ */
+HRESULT INCALESCENT_Perf_Report(void);
+
+#endif //INCALESCENT_PERF_H
@@ -0,0 +1,49 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_PLATFORM_H
+#define INCALESCENT_PLATFORM_H
+
+// Forward declarations from <windows.h> of the types whose width depends on the platform. Windows
+// keeps long at 32 bits even on 64-bit processors, while the other platforms widen it to 64 bits,
+// so there the compatibility layer in posix/ declares them with int instead.
+#ifdef _WIN32
+typedef long HRESULT;
+typedef long LONG;
+typedef unsigned long DWORD;
+#else
+typedef int HRESULT;
+typedef int LONG;
+typedef unsigned int DWORD;
+#endif
+
+// The flag of a directory search that only needs the names and whether they are directories.
+// Windows reports everything else along with them anyway, while elsewhere the rest takes a call
+// for every entry.
+#ifdef _WIN32
+#define INCALESCENT_FIND_NAMES_ONLY 0
+#else
+#define INCALESCENT_FIND_NAMES_ONLY FIND_FIRST_EX_NAMES_ONLY
+#endif
+
+#endif //INCALESCENT_PLATFORM_H
@@ -0,0 +1,277 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "pool.h"
+
+typedef struct DECLSPEC_CACHEALIGN INCALESCENT_PoolWorker {
+    struct INCALESCENT_Pool *pool;
+    HANDLE thread;
+    DWORD index;
+
+    // The share of the current run that this worker still has to process. Thieves
+    // take from the end while the owner takes from the beginning, both under the lock.
+    SRWLOCK lock;
+    SIZE_T begin;
+    SIZE_T end;
+} INCALESCENT_PoolWorker;
+
+struct INCALESCENT_Pool {
+    INCALESCENT_PoolWorker *workers;
+    DWORD workerCount;
+
+    SRWLOCK lock;
+    CONDITION_VARIABLE wake;
+    CONDITION_VARIABLE finished;
+    ULONG generation;
+    DWORD busyCount;
+    BOOL shutdown;
+
+    INCALESCENT_Pool_Callback callback;
+    PVOID context;
+    SIZE_T chunkSize;
+    volatile LONG result;
+};
+
+static BOOL INCALESCENT_Pool_TakeOwn(INCALESCENT_PoolWorker *worker, SIZE_T chunkSize, SIZE_T *begin, SIZE_T *end) {
+    BOOL taken = FALSE;
+
+    AcquireSRWLockExclusive(&worker->lock);
+    if (worker->begin < worker->end) {
+        SIZE_T remaining = worker->end - worker->begin;
+        *begin = worker->begin;
+        *end = worker->begin + (remaining < chunkSize ? remaining : chunkSize);
+        worker->begin = *end;
+        taken = TRUE;
+    }
+    ReleaseSRWLockExclusive(&worker->lock);
+
+    return taken;
+}
+
+static BOOL INCALESCENT_Pool_Steal(INCALESCENT_PoolWorker *thief) {
+    INCALESCENT_Pool *pool = thief->pool;
+
+    for (DWORD offset = 1; offset < pool->workerCount; offset++) {
+        INCALESCENT_PoolWorker *victim = &pool->workers[(thief->index + offset) % pool->workerCount];
+        SIZE_T stolenBegin = 0;
+        SIZE_T stolenEnd = 0;
+
+        AcquireSRWLockExclusive(&victim->lock);
+        if (victim->begin < victim->end) {
+            // Take the back half, rounding up so a single remaining index can be stolen too.
+            SIZE_T remaining = victim->end - victim->begin;
+            stolenBegin = victim->begin + (remaining / 2);
+            stolenEnd = victim->end;
+            victim->end = stolenBegin;
+        }
+        ReleaseSRWLockExclusive(&victim->lock);
+
+        if (stolenBegin == stolenEnd) {
+            continue;
+        }
+
+        AcquireSRWLockExclusive(&thief->lock);
+        thief->begin = stolenBegin;
+        thief->end = stolenEnd;
+        ReleaseSRWLockExclusive(&thief->lock);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void INCALESCENT_Pool_Work(INCALESCENT_PoolWorker *worker) {
+    INCALESCENT_Pool *pool = worker->pool;
+
+    // Stop taking new chunks as soon as any worker has failed.
+    while (pool->result == S_OK) {
+        SIZE_T begin;
+        SIZE_T end;
+        if (!INCALESCENT_Pool_TakeOwn(worker, pool->chunkSize, &begin, &end)) {
+            if (!INCALESCENT_Pool_Steal(worker)) {
+                break;
+            }
+            continue;
+        }
+
+        HRESULT result = pool->callback(pool->context, worker->index, begin, end);
+        if (FAILED(result)) {
+            InterlockedCompareExchange(&pool->result, result, S_OK);
+            break;
+        }
+    }
+}
+
+static DWORD WINAPI INCALESCENT_Pool_ThreadStart(LPVOID parameter) {
+    INCALESCENT_PoolWorker *worker = parameter;
+    INCALESCENT_Pool *pool = worker->pool;
+    ULONG generation = 0;
+
+    AcquireSRWLockExclusive(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == generation) {
+            SleepConditionVariableSRW(&pool->wake, &pool->lock, INFINITE, 0);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        generation = pool->generation;
+        ReleaseSRWLockExclusive(&pool->lock);
+
+        INCALESCENT_Pool_Work(worker);
+
+        AcquireSRWLockExclusive(&pool->lock);
+        pool->busyCount--;
+        if (pool->busyCount == 0) {
+            WakeAllConditionVariable(&pool->finished);
+        }
+    }
+    ReleaseSRWLockExclusive(&pool->lock);
+
+    return 0;
+}
+
+// Implementation for INCALESCENT_Pool_Create
+HRESULT INCALESCENT_Pool_Create(DWORD workerCount, INCALESCENT_Pool **pool) {
+    HRESULT result = S_OK;
+    HANDLE heap = GetProcessHeap();
+
+    if (workerCount == 0) {
+        workerCount = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    }
+    if (workerCount == 0) {
+        workerCount = 1;
+    }
+    if (workerCount > INCALESCENT_POOL_MAX_WORKERS) {
+        workerCount = INCALESCENT_POOL_MAX_WORKERS;
+    }
+
+    INCALESCENT_Pool *intermediate = HeapAlloc(heap, HEAP_ZERO_MEMORY, sizeof(INCALESCENT_Pool));
+    if (intermediate == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+    InitializeSRWLock(&intermediate->lock);
+    InitializeConditionVariable(&intermediate->wake);
+    InitializeConditionVariable(&intermediate->finished);
+
+    intermediate->workers = HeapAlloc(heap, HEAP_ZERO_MEMORY, sizeof(INCALESCENT_PoolWorker) * workerCount);
+    if (intermediate->workers == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+
+    for (DWORD index = 0; index < workerCount; index++) {
+        INCALESCENT_PoolWorker *worker = &intermediate->workers[index];
+        worker->pool = intermediate;
+        worker->index = index;
+        InitializeSRWLock(&worker->lock);
+
+        worker->thread = CreateThread(NULL, 0, INCALESCENT_Pool_ThreadStart, worker, 0, NULL);
+        if (worker->thread == NULL) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        // Only count workers whose thread exists so that destruction joins exactly those.
+        intermediate->workerCount = index + 1;
+    }
+
+    *pool = intermediate;
+    intermediate = NULL;
+
+    cleanup:
+    if (intermediate != NULL) {
+        INCALESCENT_Pool_Destroy(intermediate);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Pool_Run
+HRESULT INCALESCENT_Pool_Run(INCALESCENT_Pool *pool, SIZE_T count, SIZE_T chunkSize, INCALESCENT_Pool_Callback callback, PVOID context) {
+    if (count == 0) {
+        return S_OK;
+    }
+    if (chunkSize == 0) {
+        chunkSize = INCALESCENT_POOL_DEFAULT_CHUNK_SIZE;
+    }
+
+    AcquireSRWLockExclusive(&pool->lock);
+
+    // Hand every worker an even share of the range. The pool lock orders these writes
+    // before the workers observe the new generation.
+    SIZE_T share = count / pool->workerCount;
+    SIZE_T extra = count % pool->workerCount;
+    SIZE_T next = 0;
+    for (DWORD index = 0; index < pool->workerCount; index++) {
+        INCALESCENT_PoolWorker *worker = &pool->workers[index];
+        worker->begin = next;
+        next += share + (index < extra ? 1 : 0);
+        worker->end = next;
+    }
+
+    pool->callback = callback;
+    pool->context = context;
+    pool->chunkSize = chunkSize;
+    pool->result = S_OK;
+    pool->busyCount = pool->workerCount;
+    pool->generation++;
+    WakeAllConditionVariable(&pool->wake);
+
+    while (pool->busyCount != 0) {
+        SleepConditionVariableSRW(&pool->finished, &pool->lock, INFINITE, 0);
+    }
+    HRESULT result = pool->result;
+
+    ReleaseSRWLockExclusive(&pool->lock);
+
+    return result;
+}
+
+// Implementation for INCALESCENT_Pool_WorkerCount
+DWORD INCALESCENT_Pool_WorkerCount(INCALESCENT_Pool *pool) {
+    return pool->workerCount;
+}
+
+// Implementation for INCALESCENT_Pool_Destroy
+void INCALESCENT_Pool_Destroy(INCALESCENT_Pool *pool) {
+    HANDLE heap = GetProcessHeap();
+
+    if (pool == NULL) {
+        return;
+    }
+
+    AcquireSRWLockExclusive(&pool->lock);
+    pool->shutdown = TRUE;
+    WakeAllConditionVariable(&pool->wake);
+    ReleaseSRWLockExclusive(&pool->lock);
+
+    if (pool->workers != NULL) {
+        for (DWORD index = 0; index < pool->workerCount; index++) {
+            WaitForSingleObject(pool->workers[index].thread, INFINITE);
+            CloseHandle(pool->workers[index].thread);
+        }
+        HeapFree(heap, 0, pool->workers);
+    }
+    HeapFree(heap, 0, pool);
+}
@@ -0,0 +1,82 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_POOL_H
+#define INCALESCENT_POOL_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* PVOID;
+typedef unsigned __int64 SIZE_T;
+
+#define INCALESCENT_POOL_MAX_WORKERS 64
+#define INCALESCENT_POOL_DEFAULT_CHUNK_SIZE 64
+
+typedef struct INCALESCENT_Pool INCALESCENT_Pool;
+
+/**
+ * @brief Processes a contiguous chunk of the range handed to INCALESCENT_Pool_Run.
+ *
+ * @param[in] context   The context pointer supplied to INCALESCENT_Pool_Run.
+ * @param[in] worker    The index of the worker running the chunk, in the range [0, workerCount).
+ *                      Callbacks may use it to address per-worker state without locking.
+ * @param[in] begin     The first index of the chunk.
+ * @param[in] end       One past the last index of the chunk.
+ *
+ * @return S_OK if the chunk was processed. Any failure stops the run as soon as every worker
+ *         finishes the chunk it is currently processing.
+ */
+typedef HRESULT (*INCALESCENT_Pool_Callback)(PVOID context, DWORD worker, SIZE_T begin, SIZE_T end);
+
+/**
+ * @brief Creates a pool of worker threads.
+ *
+ * @param[in] workerCount   The number of workers to create. Zero creates one worker per active
+ *                          logical processor. The count is clamped to INCALESCENT_POOL_MAX_WORKERS.
+ * @param[out] pool         Receives the pool. It must be released with INCALESCENT_Pool_Destroy.
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Pool_Create(DWORD workerCount, INCALESCENT_Pool **pool);
+
+/**
+ * @brief Runs a callback over the range [0, count) on every worker and waits for it to finish.
+ *
+ * The range is split evenly between the workers up front. Each worker takes chunks of at most
+ * chunkSize indices from the front of its own share, and once that is exhausted it steals the
+ * back half of whatever remains of another worker's share. No index is handed out twice.
+ *
+ * @param[in] pool          The pool.
+ * @param[in] count         The number of indices to process.
+ * @param[in] chunkSize     The maximum number of indices passed to a single callback.
+ * @param[in] callback      The callback to run.
+ * @param[in] context       The context pointer passed through to the callback.
+ *
+ * @return The first failure returned by a callback, otherwise S_OK.
+ */
+HRESULT INCALESCENT_Pool_Run(INCALESCENT_Pool *pool, SIZE_T count, SIZE_T chunkSize, INCALESCENT_Pool_Callback callback, PVOID context);
+
+DWORD INCALESCENT_Pool_WorkerCount(INCALESCENT_Pool *pool);
+void INCALESCENT_Pool_Destroy(INCALESCENT_Pool *pool);
+
+#endif //INCALESCENT_POOL_H
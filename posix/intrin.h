@@ -0,0 +1,51 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_POSIX_INTRIN_H
+#define INCALESCENT_POSIX_INTRIN_H
+#include <windows.h>
+
+// The compiler intrinsics of <intrin.h> that aren't already declared by <windows.h>, in terms of the
+// GCC ones.
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// Not taken from <cpuid.h>, whose __cpuid takes the registers one by one.
+static inline void INCALESCENT_Posix_Cpuid(int information[4], int leaf, int subleaf) {
+    __asm__ volatile("cpuid" : "=a"(information[0]), "=b"(information[1]), "=c"(information[2]), "=d"(information[3]) : "a"(leaf), "c"(subleaf));
+}
+
+#define __cpuidex(information, leaf, subleaf) INCALESCENT_Posix_Cpuid((information), (leaf), (subleaf))
+#define __cpuid(information, leaf) INCALESCENT_Posix_Cpuid((information), (leaf), 0)
+
+static inline unsigned long long INCALESCENT_Posix_Xgetbv(unsigned int index) {
+    unsigned int low;
+    unsigned int high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(index));
+    return ((unsigned long long) high << 32) | low;
+}
+
+#define _xgetbv(index) INCALESCENT_Posix_Xgetbv(index)
+#endif
+
+#endif //INCALESCENT_POSIX_INTRIN_H
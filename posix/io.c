@@ -0,0 +1,644 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include <windows.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "../io.h"
+#include "../perf.h"
+
+// Every submission is opened and read through io_uring, which keeps all of them in flight with a
+// single system call for each batch. The open and the first read go in one after the other, since
+// the read needs the descriptor the open gives. Where io_uring can't be set up, because the kernel
+// is too old or doesn't allow it, a few of the engine's own threads open and read the files
+// instead. Either way, completions are handed out in the order the reads finish, from the same
+// slots as the overlapped engine.
+
+// Paths of data files are at most MAX_PATH UTF-16 units, none of which takes more than three bytes
+// in UTF-8.
+#define INCALESCENT_IO_PATH_SIZE 1024
+
+// The threads of an engine without io_uring, which each block on one file at a time.
+#define INCALESCENT_IO_THREAD_COUNT 4
+
+// The operations a probe of io_uring reports on.
+#define INCALESCENT_IO_PROBE_OPS 256
+
+typedef struct INCALESCENT_IoSlot {
+    INT descriptor;
+    PSTR path;
+    PBYTE buffer;
+    SIZE_T tag;
+    DWORD error;
+    BOOL pending;
+    ULONGLONG offset;
+    SIZE_T size;
+
+    // Whether the file is still being opened, which is done before its first read.
+    BOOL opening;
+
+    // When the open or read was queued, for the performance counters.
+    ULONGLONG queued;
+} INCALESCENT_IoSlot;
+
+// The rings an io_uring instance shares with the kernel. The submission ring holds indices into
+// the array of submission entries, and the completion ring holds the completions themselves.
+typedef struct INCALESCENT_IoRing {
+    INT descriptor;
+    PBYTE submissionRing;
+    SIZE_T submissionRingSize;
+    PBYTE completionRing;
+    SIZE_T completionRingSize;
+    struct io_uring_sqe *entries;
+    SIZE_T entriesSize;
+
+    unsigned *submissionHead;
+    unsigned *submissionTail;
+    unsigned *submissionArray;
+    unsigned submissionMask;
+    unsigned *completionHead;
+    unsigned *completionTail;
+    unsigned completionMask;
+    struct io_uring_cqe *completions;
+
+    // The entries queued since the kernel was last told about them.
+    DWORD unsubmitted;
+} INCALESCENT_IoRing;
+
+struct INCALESCENT_Io {
+    INCALESCENT_IoSlot *slots;
+    DWORD *freeSlots;
+    DWORD freeCount;
+    DWORD depth;
+    DWORD pending;
+    SIZE_T readSize;
+
+    // io_uring, unless the engine fell back to threads.
+    BOOL threaded;
+    INCALESCENT_IoRing ring;
+
+    // The threads, the slots queued for them and the slots they finished, the latter two as rings
+    // of depth slot indices. The lock guards both rings and stopping.
+    HANDLE *threads;
+    DWORD threadCount;
+    SRWLOCK lock;
+    CONDITION_VARIABLE queuedCondition;
+    CONDITION_VARIABLE finishedCondition;
+    DWORD *queued;
+    DWORD queuedStart;
+    DWORD queuedCount;
+    DWORD *finished;
+    DWORD finishedStart;
+    DWORD finishedCount;
+    BOOL stopping;
+};
+
+// Unmaps the rings of an io_uring instance and closes it.
+static void INCALESCENT_Io_CloseRing(INCALESCENT_IoRing *ring) {
+    if (ring->entries != NULL) {
+        munmap(ring->entries, ring->entriesSize);
+    }
+    if (ring->completionRing != NULL && ring->completionRing != ring->submissionRing) {
+        munmap(ring->completionRing, ring->completionRingSize);
+    }
+    if (ring->submissionRing != NULL) {
+        munmap(ring->submissionRing, ring->submissionRingSize);
+    }
+    if (ring->descriptor >= 0) {
+        close(ring->descriptor);
+    }
+    ZeroMemory(ring, sizeof(INCALESCENT_IoRing));
+    ring->descriptor = -1;
+}
+
+// Maps one of the regions of an io_uring instance, or returns NULL.
+static PVOID INCALESCENT_Io_MapRing(INT descriptor, SIZE_T size, off_t offset) {
+    PVOID region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, offset);
+    return region == MAP_FAILED ? NULL : region;
+}
+
+// Whether the kernel can open and read files through io_uring. Both came in the same release as the
+// probe, so a kernel that can't be probed can't do either.
+static BOOL INCALESCENT_Io_CanOpenAndRead(INT descriptor) {
+    BYTE buffer[sizeof(struct io_uring_probe) + (INCALESCENT_IO_PROBE_OPS * sizeof(struct io_uring_probe_op))];
+    struct io_uring_probe *probe = (struct io_uring_probe *) buffer;
+
+    ZeroMemory(buffer, sizeof(buffer));
+    if (syscall(__NR_io_uring_register, descriptor, IORING_REGISTER_PROBE, probe, INCALESCENT_IO_PROBE_OPS) < 0) {
+        return FALSE;
+    }
+    return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) &&
+           (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+}
+
+// Sets up an io_uring instance with room for depth operations and maps its rings. Fails without
+// setting an error, as the engine falls back to threads then.
+static BOOL INCALESCENT_Io_OpenRing(INCALESCENT_IoRing *ring, DWORD depth) {
+    struct io_uring_params parameters;
+
+    ZeroMemory(ring, sizeof(INCALESCENT_IoRing));
+    ZeroMemory(&parameters, sizeof(parameters));
+    ring->descriptor = (INT) syscall(__NR_io_uring_setup, depth, &parameters);
+    if (ring->descriptor < 0 || !INCALESCENT_Io_CanOpenAndRead(ring->descriptor)) {
+        goto failed;
+    }
+
+    // Newer kernels map both rings as one region.
+    ring->submissionRingSize = parameters.sq_off.array + (parameters.sq_entries * sizeof(unsigned));
+    ring->completionRingSize = parameters.cq_off.cqes + (parameters.cq_entries * sizeof(struct io_uring_cqe));
+    if (parameters.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->completionRingSize > ring->submissionRingSize) {
+            ring->submissionRingSize = ring->completionRingSize;
+        }
+        ring->completionRingSize = ring->submissionRingSize;
+    }
+    ring->submissionRing = INCALESCENT_Io_MapRing(ring->descriptor, ring->submissionRingSize, IORING_OFF_SQ_RING);
+    if (ring->submissionRing == NULL) {
+        goto failed;
+    }
+    if (parameters.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->completionRing = ring->submissionRing;
+    } else {
+        ring->completionRing = INCALESCENT_Io_MapRing(ring->descriptor, ring->completionRingSize, IORING_OFF_CQ_RING);
+        if (ring->completionRing == NULL) {
+            goto failed;
+        }
+    }
+    ring->entriesSize = parameters.sq_entries * sizeof(struct io_uring_sqe);
+    ring->entries = INCALESCENT_Io_MapRing(ring->descriptor, ring->entriesSize, IORING_OFF_SQES);
+    if (ring->entries == NULL) {
+        goto failed;
+    }
+
+    ring->submissionHead = (unsigned *) (ring->submissionRing + parameters.sq_off.head);
+    ring->submissionTail = (unsigned *) (ring->submissionRing + parameters.sq_off.tail);
+    ring->submissionArray = (unsigned *) (ring->submissionRing + parameters.sq_off.array);
+    ring->submissionMask = *(unsigned *) (ring->submissionRing + parameters.sq_off.ring_mask);
+    ring->completionHead = (unsigned *) (ring->completionRing + parameters.cq_off.head);
+    ring->completionTail = (unsigned *) (ring->completionRing + parameters.cq_off.tail);
+    ring->completionMask = *(unsigned *) (ring->completionRing + parameters.cq_off.ring_mask);
+    ring->completions = (struct io_uring_cqe *) (ring->completionRing + parameters.cq_off.cqes);
+    return TRUE;
+
+    failed:
+    INCALESCENT_Io_CloseRing(ring);
+    return FALSE;
+}
+
+// Takes the next submission entry of the ring, cleared and tagged with a slot. There is always one
+// free, as no slot has more than one operation in flight.
+static struct io_uring_sqe *INCALESCENT_Io_NextEntry(INCALESCENT_Io *io, INCALESCENT_IoSlot *slot) {
+    INCALESCENT_IoRing *ring = &io->ring;
+    unsigned index = *ring->submissionTail & ring->submissionMask;
+    struct io_uring_sqe *entry = &ring->entries[index];
+
+    ZeroMemory(entry, sizeof(struct io_uring_sqe));
+    entry->user_data = (ULONGLONG) (slot - io->slots);
+    ring->submissionArray[index] = index;
+    return entry;
+}
+
+// Hands the entry taken last over to the kernel, which sees it on the next call into it.
+static void INCALESCENT_Io_PushEntry(INCALESCENT_IoRing *ring) {
+    __atomic_store_n(ring->submissionTail, *ring->submissionTail + 1, __ATOMIC_RELEASE);
+    ring->unsubmitted++;
+}
+
+// Submits the queued entries and, if asked to, waits until at least one operation has completed.
+static HRESULT INCALESCENT_Io_Enter(INCALESCENT_IoRing *ring, BOOL wait) {
+    for (;;) {
+        LONG submitted = (LONG) syscall(__NR_io_uring_enter, ring->descriptor, ring->unsubmitted, wait ? 1 : 0,
+                                        wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (submitted >= 0) {
+            ring->unsubmitted -= (DWORD) submitted;
+            return S_OK;
+        }
+        if (errno != EINTR) {
+            return HRESULT_FROM_WIN32(INCALESCENT_Posix_Error(errno));
+        }
+    }
+}
+
+// Reads the file a slot has open until the buffer is full or the file ends, so a short read means
+// the end like with the overlapped engine.
+static void INCALESCENT_Io_ReadSlot(INCALESCENT_Io *io, INCALESCENT_IoSlot *slot) {
+    SIZE_T total = 0;
+
+    while (total < io->readSize) {
+        ssize_t count = pread(slot->descriptor, slot->buffer + total, io->readSize - total, (off_t) (slot->offset + total));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            slot->error = INCALESCENT_Posix_Error(errno);
+            break;
+        }
+        if (count == 0) {
+            break;
+        }
+        total += (SIZE_T) count;
+    }
+    slot->size = total;
+}
+
+// Opens and reads the files queued for the threads of an engine, until the engine stops.
+static DWORD WINAPI INCALESCENT_Io_Thread(LPVOID parameter) {
+    INCALESCENT_Io *io = parameter;
+
+    AcquireSRWLockExclusive(&io->lock);
+    for (;;) {
+        while (io->queuedCount == 0 && !io->stopping) {
+            SleepConditionVariableSRW(&io->queuedCondition, &io->lock, INFINITE, 0);
+        }
+        if (io->queuedCount == 0) {
+            break;
+        }
+        DWORD slotIndex = io->queued[io->queuedStart];
+        io->queuedStart = (io->queuedStart + 1) % io->depth;
+        io->queuedCount--;
+        ReleaseSRWLockExclusive(&io->lock);
+
+        INCALESCENT_IoSlot *slot = &io->slots[slotIndex];
+        if (slot->opening) {
+            slot->descriptor = open(slot->path, O_RDONLY | O_CLOEXEC);
+            if (slot->descriptor < 0) {
+                slot->error = INCALESCENT_Posix_Error(errno);
+            } else {
+                INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_OPEN, slot->queued);
+                slot->queued = INCALESCENT_Perf_Now();
+            }
+            slot->opening = FALSE;
+        }
+        if (slot->error == ERROR_SUCCESS) {
+            INCALESCENT_Io_ReadSlot(io, slot);
+        }
+
+        AcquireSRWLockExclusive(&io->lock);
+        io->finished[(io->finishedStart + io->finishedCount) % io->depth] = slotIndex;
+        io->finishedCount++;
+        WakeConditionVariable(&io->finishedCondition);
+    }
+    ReleaseSRWLockExclusive(&io->lock);
+
+    return 0;
+}
+
+// Stops the threads of an engine once they have finished what was queued, and waits for them.
+static void INCALESCENT_Io_StopThreads(INCALESCENT_Io *io) {
+    AcquireSRWLockExclusive(&io->lock);
+    io->stopping = TRUE;
+    WakeAllConditionVariable(&io->queuedCondition);
+    ReleaseSRWLockExclusive(&io->lock);
+
+    for (DWORD index = 0; index < io->threadCount; index++) {
+        WaitForSingleObject(io->threads[index], INFINITE);
+        CloseHandle(io->threads[index]);
+    }
+    io->threadCount = 0;
+}
+
+// Closes the file of a slot and puts the slot back on the free list.
+static void INCALESCENT_Io_FreeSlot(INCALESCENT_Io *io, DWORD slotIndex) {
+    INCALESCENT_IoSlot *slot = &io->slots[slotIndex];
+
+    if (slot->descriptor >= 0) {
+        close(slot->descriptor);
+        slot->descriptor = -1;
+    }
+    io->freeSlots[io->freeCount] = slotIndex;
+    io->freeCount++;
+}
+
+// Queues the open of a slot's path, or a read of its open file at an offset.
+static void INCALESCENT_Io_Queue(INCALESCENT_Io *io, INCALESCENT_IoSlot *slot, ULONGLONG offset) {
+    slot->offset = offset;
+    slot->error = ERROR_SUCCESS;
+    slot->size = 0;
+    slot->queued = INCALESCENT_Perf_Now();
+    slot->pending = TRUE;
+    io->pending++;
+
+    if (io->threaded) {
+        AcquireSRWLockExclusive(&io->lock);
+        io->queued[(io->queuedStart + io->queuedCount) % io->depth] = (DWORD) (slot - io->slots);
+        io->queuedCount++;
+        WakeConditionVariable(&io->queuedCondition);
+        ReleaseSRWLockExclusive(&io->lock);
+        return;
+    }
+
+    struct io_uring_sqe *entry = INCALESCENT_Io_NextEntry(io, slot);
+    if (slot->opening) {
+        entry->opcode = IORING_OP_OPENAT;
+        entry->fd = AT_FDCWD;
+        entry->addr = (ULONGLONG) (ULONG_PTR) slot->path;
+        entry->open_flags = O_RDONLY | O_CLOEXEC;
+    } else {
+        entry->opcode = IORING_OP_READ;
+        entry->fd = slot->descriptor;
+        entry->addr = (ULONGLONG) (ULONG_PTR) slot->buffer;
+        entry->len = (DWORD) io->readSize;
+        entry->off = offset;
+    }
+    INCALESCENT_Io_PushEntry(&io->ring);
+}
+
+// Takes the outcome of a slot's open or read from the completion ring. Returns FALSE for an open
+// that succeeded, whose first read is queued right away instead of completing the slot.
+static BOOL INCALESCENT_Io_Reap(INCALESCENT_Io *io, const struct io_uring_cqe *entry, INCALESCENT_IoSlot **finished) {
+    INCALESCENT_IoSlot *slot = &io->slots[entry->user_data];
+
+    if (slot->opening) {
+        slot->opening = FALSE;
+        if (entry->res >= 0) {
+            INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_OPEN, slot->queued);
+            slot->descriptor = entry->res;
+            io->pending--;
+            INCALESCENT_Io_Queue(io, slot, slot->offset);
+            return FALSE;
+        }
+    }
+    if (entry->res < 0) {
+        slot->error = INCALESCENT_Posix_Error(-entry->res);
+    } else {
+        slot->size = (SIZE_T) entry->res;
+    }
+    *finished = slot;
+    return TRUE;
+}
+
+// Implementation for INCALESCENT_Io_Create
+HRESULT INCALESCENT_Io_Create(INCALESCENT_Arena *arena, DWORD depth, SIZE_T readSize, INCALESCENT_Io **io) {
+    HRESULT result = S_OK;
+    INCALESCENT_Io *intermediate = NULL;
+    PBYTE buffers = NULL;
+    PSTR paths = NULL;
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_Io), INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &intermediate);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(intermediate, sizeof(INCALESCENT_Io));
+    intermediate->depth = depth;
+    intermediate->readSize = readSize;
+    intermediate->ring.descriptor = -1;
+    InitializeSRWLock(&intermediate->lock);
+    InitializeConditionVariable(&intermediate->queuedCondition);
+    InitializeConditionVariable(&intermediate->finishedCondition);
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_IoSlot) * depth, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &intermediate->slots);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * depth, sizeof(DWORD), (PVOID *) &intermediate->freeSlots);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, readSize * depth, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &buffers);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, INCALESCENT_IO_PATH_SIZE * depth, 1, (PVOID *) &paths);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (DWORD index = 0; index < depth; index++) {
+        INCALESCENT_IoSlot *slot = &intermediate->slots[index];
+        ZeroMemory(slot, sizeof(INCALESCENT_IoSlot));
+        slot->descriptor = -1;
+        slot->buffer = buffers + (readSize * index);
+        slot->path = paths + (INCALESCENT_IO_PATH_SIZE * index);
+
+        // Hand out the lowest slots first.
+        intermediate->freeSlots[index] = depth - index - 1;
+    }
+    intermediate->freeCount = depth;
+
+    if (!INCALESCENT_Io_OpenRing(&intermediate->ring, depth)) {
+        intermediate->threaded = TRUE;
+        result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * depth, sizeof(DWORD), (PVOID *) &intermediate->queued);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_Arena_Allocate(arena, sizeof(DWORD) * depth, sizeof(DWORD), (PVOID *) &intermediate->finished);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_Arena_Allocate(arena, sizeof(HANDLE) * INCALESCENT_IO_THREAD_COUNT, sizeof(HANDLE), (PVOID *) &intermediate->threads);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        for (; intermediate->threadCount < INCALESCENT_IO_THREAD_COUNT; intermediate->threadCount++) {
+            intermediate->threads[intermediate->threadCount] = CreateThread(NULL, 0, INCALESCENT_Io_Thread, intermediate, 0, NULL);
+            if (intermediate->threads[intermediate->threadCount] == NULL) {
+                result = HRESULT_FROM_WIN32(GetLastError());
+                INCALESCENT_Io_StopThreads(intermediate);
+                goto cleanup;
+            }
+        }
+    }
+
+    *io = intermediate;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Io_Submit
+HRESULT INCALESCENT_Io_Submit(INCALESCENT_Io *io, PCWSTR path, SIZE_T tag, ULONGLONG offset) {
+    HRESULT result = S_OK;
+    CHAR converted[INCALESCENT_POSIX_PATH_SIZE];
+
+    if (io->freeCount == 0) {
+        result = E_UNEXPECTED;
+        goto cleanup;
+    }
+    DWORD slotIndex = io->freeSlots[io->freeCount - 1];
+    INCALESCENT_IoSlot *slot = &io->slots[slotIndex];
+
+    // The path has to stay where it is until the file has been opened.
+    if (!INCALESCENT_Posix_Path(path, converted)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    SIZE_T length = strlen(converted);
+    if (length >= INCALESCENT_IO_PATH_SIZE) {
+        result = HRESULT_FROM_WIN32(ERROR_FILENAME_EXCED_RANGE);
+        goto cleanup;
+    }
+    CopyMemory(slot->path, converted, length + 1);
+
+    slot->tag = tag;
+    slot->opening = TRUE;
+    io->freeCount--;
+    INCALESCENT_Io_Queue(io, slot, offset);
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Io_Continue
+HRESULT INCALESCENT_Io_Continue(INCALESCENT_Io *io, const INCALESCENT_Io_Completion *completion, ULONGLONG offset) {
+    INCALESCENT_Io_Queue(io, &io->slots[completion->slot], offset);
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Io_Complete
+HRESULT INCALESCENT_Io_Complete(INCALESCENT_Io *io, INCALESCENT_Io_Completion *completions, DWORD maximum, DWORD *count) {
+    HRESULT result = S_OK;
+    INCALESCENT_IoSlot *finished[INCALESCENT_IO_MAX_BATCH];
+    DWORD removed = 0;
+
+    *count = 0;
+    if (io->pending == 0) {
+        result = E_UNEXPECTED;
+        goto cleanup;
+    }
+    if (maximum > INCALESCENT_IO_MAX_BATCH) {
+        maximum = INCALESCENT_IO_MAX_BATCH;
+    }
+
+    if (io->threaded) {
+        AcquireSRWLockExclusive(&io->lock);
+        while (io->finishedCount == 0) {
+            SleepConditionVariableSRW(&io->finishedCondition, &io->lock, INFINITE, 0);
+        }
+        while (removed < maximum && io->finishedCount != 0) {
+            finished[removed++] = &io->slots[io->finished[io->finishedStart]];
+            io->finishedStart = (io->finishedStart + 1) % io->depth;
+            io->finishedCount--;
+        }
+        ReleaseSRWLockExclusive(&io->lock);
+    } else {
+        // Whatever was queued since the last call goes in first, so it is under way while the
+        // completions already there are handed out.
+        INCALESCENT_IoRing *ring = &io->ring;
+        if (ring->unsubmitted != 0) {
+            result = INCALESCENT_Io_Enter(ring, FALSE);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+        while (removed < maximum) {
+            unsigned head = *ring->completionHead;
+            if (head == __atomic_load_n(ring->completionTail, __ATOMIC_ACQUIRE)) {
+                // The first reads of files that were just opened are queued rather than waited for.
+                if (removed != 0 && ring->unsubmitted == 0) {
+                    break;
+                }
+                result = INCALESCENT_Io_Enter(ring, removed == 0);
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+                if (removed != 0) {
+                    break;
+                }
+                continue;
+            }
+            struct io_uring_cqe entry = ring->completions[head & ring->completionMask];
+            __atomic_store_n(ring->completionHead, head + 1, __ATOMIC_RELEASE);
+            if (INCALESCENT_Io_Reap(io, &entry, &finished[removed])) {
+                removed++;
+            }
+        }
+    }
+
+    for (DWORD index = 0; index < removed; index++) {
+        INCALESCENT_IoSlot *slot = finished[index];
+        INCALESCENT_Io_Completion *completion = &completions[index];
+        slot->pending = FALSE;
+        io->pending--;
+
+        completion->tag = slot->tag;
+        completion->slot = (DWORD) (slot - io->slots);
+        completion->data = slot->buffer;
+        completion->size = slot->size;
+        completion->offset = slot->offset;
+        completion->result = slot->error == ERROR_SUCCESS ? S_OK : HRESULT_FROM_WIN32(slot->error);
+        completion->endOfFile = completion->size < io->readSize;
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_READ, slot->queued);
+        INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_BYTES_READ, completion->size);
+    }
+    *count = removed;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Io_Release
+void INCALESCENT_Io_Release(INCALESCENT_Io *io, const INCALESCENT_Io_Completion *completion) {
+    INCALESCENT_Io_FreeSlot(io, completion->slot);
+}
+
+// Implementation for INCALESCENT_Io_Drain
+void INCALESCENT_Io_Drain(INCALESCENT_Io *io) {
+    INCALESCENT_Io_Completion completions[INCALESCENT_IO_MAX_BATCH];
+
+    // The reads are only of the first bytes of small files, so they are waited for rather than
+    // cancelled.
+    while (io->pending != 0) {
+        DWORD count = 0;
+        if (FAILED(INCALESCENT_Io_Complete(io, completions, INCALESCENT_IO_MAX_BATCH, &count))) {
+            break;
+        }
+        for (DWORD index = 0; index < count; index++) {
+            INCALESCENT_Io_Release(io, &completions[index]);
+        }
+    }
+}
+
+// Implementation for INCALESCENT_Io_CanSubmit
+BOOL INCALESCENT_Io_CanSubmit(const INCALESCENT_Io *io) {
+    return io->freeCount != 0;
+}
+
+// Implementation for INCALESCENT_Io_Pending
+DWORD INCALESCENT_Io_Pending(const INCALESCENT_Io *io) {
+    return io->pending;
+}
+
+// Implementation for INCALESCENT_Io_Destroy
+void INCALESCENT_Io_Destroy(INCALESCENT_Io *io) {
+    if (io == NULL) {
+        return;
+    }
+
+    INCALESCENT_Io_Drain(io);
+    if (io->threaded) {
+        INCALESCENT_Io_StopThreads(io);
+    } else {
+        INCALESCENT_Io_CloseRing(&io->ring);
+    }
+    for (DWORD index = 0; index < io->depth; index++) {
+        if (io->slots[index].descriptor >= 0) {
+            close(io->slots[index].descriptor);
+            io->slots[index].descriptor = -1;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <stdlib.h>
+
+INT wmain(INT argumentCount, PWSTR *arguments);
+
+// The console programs start at wmain, which takes its arguments as UTF-16 like on Windows.
+int main(int argumentCount, char **arguments) {
+    PWSTR *converted = calloc((SIZE_T) argumentCount + 1, sizeof(PWSTR));
+    if (converted == NULL) {
+        return EXIT_FAILURE;
+    }
+    for (int index = 0; index < argumentCount; index++) {
+        INT length = MultiByteToWideChar(CP_UTF8, 0, arguments[index], -1, NULL, 0);
+        converted[index] = calloc((SIZE_T) length, sizeof(WCHAR));
+        if (converted[index] == NULL) {
+            return EXIT_FAILURE;
+        }
+        MultiByteToWideChar(CP_UTF8, 0, arguments[index], -1, converted[index], length);
+    }
+    return wmain(argumentCount, converted);
+}
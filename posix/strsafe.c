@@ -0,0 +1,439 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <strsafe.h>
+#include <stdio.h>
+
+// Where formatted text goes: a buffer of either width that is never overrun. Once it is full, the
+// rest of the text is dropped and the result marked as truncated.
+typedef struct INCALESCENT_Posix_Output {
+    PWSTR wide;
+    PSTR narrow;
+    SIZE_T size;
+    SIZE_T length;
+    BOOL truncated;
+} INCALESCENT_Posix_Output;
+
+static void INCALESCENT_Posix_Put(INCALESCENT_Posix_Output *output, WCHAR character) {
+    if (output->length + 1 >= output->size) {
+        output->truncated = TRUE;
+        return;
+    }
+    if (output->wide != NULL) {
+        output->wide[output->length] = character;
+    } else {
+        output->narrow[output->length] = (CHAR) character;
+    }
+    output->length++;
+}
+
+// Writes a code point, as UTF-16 into a wide buffer or as UTF-8 into a narrow one. A sequence that
+// doesn't fit whole is dropped whole.
+static void INCALESCENT_Posix_PutCodePoint(INCALESCENT_Posix_Output *output, DWORD codePoint) {
+    if (output->wide != NULL) {
+        if (codePoint > 0xFFFF) {
+            if (output->length + 2 >= output->size) {
+                output->truncated = TRUE;
+                return;
+            }
+            INCALESCENT_Posix_Put(output, (WCHAR) (0xD800 + ((codePoint - 0x10000) >> 10)));
+            codePoint = 0xDC00 + ((codePoint - 0x10000) & 0x3FF);
+        }
+        INCALESCENT_Posix_Put(output, (WCHAR) codePoint);
+        return;
+    }
+
+    WCHAR source[2] = {(WCHAR) codePoint, 0};
+    INT sourceLength = 1;
+    if (codePoint > 0xFFFF) {
+        source[0] = (WCHAR) (0xD800 + ((codePoint - 0x10000) >> 10));
+        source[1] = (WCHAR) (0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+        sourceLength = 2;
+    }
+    CHAR encoded[4];
+    INT encodedLength = WideCharToMultiByte(CP_UTF8, 0, source, sourceLength, encoded, sizeof(encoded), NULL, NULL);
+    if (output->length + encodedLength >= output->size) {
+        output->truncated = TRUE;
+        return;
+    }
+    for (INT index = 0; index < encodedLength; index++) {
+        INCALESCENT_Posix_Put(output, (BYTE) encoded[index]);
+    }
+}
+
+// Writes a string of either width, padded to a width and cut at a precision counted in code units
+// of the string itself. A negative precision means the whole string.
+static void INCALESCENT_Posix_PutString(INCALESCENT_Posix_Output *output, LPCVOID string, BOOL wide, INT width, INT precision, BOOL left) {
+    if (string == NULL) {
+        string = wide ? (LPCVOID) L"(null)" : (LPCVOID) "(null)";
+    }
+    INT length = wide ? lstrlenW(string) : lstrlenA(string);
+    if (precision >= 0 && precision < length) {
+        length = precision;
+    }
+
+    // The padding counts the characters of the string, which for the text used here are code units.
+    INT padding = width > length ? width - length : 0;
+    for (INT index = 0; index < padding && !left; index++) {
+        INCALESCENT_Posix_Put(output, L' ');
+    }
+    if (wide) {
+        LPCWSTR characters = string;
+        for (INT index = 0; index < length; index++) {
+            DWORD codePoint = characters[index];
+            if (IS_HIGH_SURROGATE(codePoint) && index + 1 < length && IS_LOW_SURROGATE(characters[index + 1])) {
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (characters[index + 1] - 0xDC00);
+                index++;
+            }
+            INCALESCENT_Posix_PutCodePoint(output, codePoint);
+        }
+    } else if (output->wide == NULL) {
+        for (INT index = 0; index < length; index++) {
+            INCALESCENT_Posix_Put(output, (BYTE) ((PCSTR) string)[index]);
+        }
+    } else {
+        WCHAR converted[1024];
+        INT convertedLength = length == 0 ? 0 : MultiByteToWideChar(CP_UTF8, 0, string, length, converted, ARRAYSIZE(converted));
+        for (INT index = 0; index < convertedLength; index++) {
+            INCALESCENT_Posix_Put(output, converted[index]);
+        }
+    }
+    for (INT index = 0; index < padding && left; index++) {
+        INCALESCENT_Posix_Put(output, L' ');
+    }
+}
+
+// Formats into an output with the conventions of <strsafe.h>. A format is wide or narrow like the
+// output, and numbers are formatted by snprintf from a specification rebuilt with C's lengths.
+static void INCALESCENT_Posix_Format(INCALESCENT_Posix_Output *output, LPCVOID format, va_list parameters) {
+    BOOL wide = output->wide != NULL;
+    SIZE_T position = 0;
+    for (;;) {
+        WCHAR character = wide ? ((PCWSTR) format)[position] : (BYTE) ((PCSTR) format)[position];
+        position++;
+        if (character == L'\0') {
+            return;
+        }
+        if (character != L'%') {
+            INCALESCENT_Posix_Put(output, character);
+            continue;
+        }
+
+        // Gather the flags, width and precision as they were written.
+        CHAR specification[32] = "%";
+        SIZE_T specificationLength = 1;
+        INT width = 0;
+        INT precision = -1;
+        BOOL left = FALSE;
+#define INCALESCENT_POSIX_FORMAT_NEXT() (wide ? ((PCWSTR) format)[position] : (BYTE) ((PCSTR) format)[position])
+        while (INCALESCENT_POSIX_FORMAT_NEXT() != L'\0' && INCALESCENT_POSIX_FORMAT_NEXT() < 0x80 &&
+               strchr("-+ #0", (CHAR) INCALESCENT_POSIX_FORMAT_NEXT()) != NULL) {
+            left = left || INCALESCENT_POSIX_FORMAT_NEXT() == L'-';
+            specification[specificationLength++] = (CHAR) INCALESCENT_POSIX_FORMAT_NEXT();
+            position++;
+        }
+        if (INCALESCENT_POSIX_FORMAT_NEXT() == L'*') {
+            width = va_arg(parameters, INT);
+            left = left || width < 0;
+            width = width < 0 ? -width : width;
+            position++;
+        } else {
+            while (INCALESCENT_POSIX_FORMAT_NEXT() >= L'0' && INCALESCENT_POSIX_FORMAT_NEXT() <= L'9') {
+                width = (width * 10) + (INCALESCENT_POSIX_FORMAT_NEXT() - L'0');
+                position++;
+            }
+        }
+        if (INCALESCENT_POSIX_FORMAT_NEXT() == L'.') {
+            precision = 0;
+            position++;
+            if (INCALESCENT_POSIX_FORMAT_NEXT() == L'*') {
+                precision = va_arg(parameters, INT);
+                position++;
+            } else {
+                while (INCALESCENT_POSIX_FORMAT_NEXT() >= L'0' && INCALESCENT_POSIX_FORMAT_NEXT() <= L'9') {
+                    precision = (precision * 10) + (INCALESCENT_POSIX_FORMAT_NEXT() - L'0');
+                    position++;
+                }
+            }
+        }
+        if (left && strchr(specification, '-') == NULL) {
+            specification[specificationLength++] = '-';
+        }
+        specificationLength += (SIZE_T) snprintf(specification + specificationLength, sizeof(specification) - specificationLength, "%d", width);
+        if (precision >= 0) {
+            specificationLength += (SIZE_T) snprintf(specification + specificationLength, sizeof(specification) - specificationLength, ".%d",
+                                                     precision);
+        }
+
+        // The size of the argument, where l alone stays 32 bits as on Windows, and the width of a
+        // string or character argument when it is given explicitly, 1 for wide and -1 for narrow.
+        INT size = 0;
+        INT stringWidth = 0;
+        for (BOOL parsing = TRUE; parsing;) {
+            switch (INCALESCENT_POSIX_FORMAT_NEXT()) {
+                case L'h':
+                    size = size == -1 ? -2 : -1;
+                    stringWidth = -1;
+                    position++;
+                    break;
+                case L'l':
+                    size = size == 1 ? 2 : 1;
+                    stringWidth = 1;
+                    position++;
+                    break;
+                case L'w':
+                    stringWidth = 1;
+                    position++;
+                    break;
+                case L'z':
+                case L'j':
+                case L't':
+                    size = 2;
+                    position++;
+                    break;
+                case L'L':
+                    position++;
+                    break;
+                case L'I':
+                    if (wide ? (((PCWSTR) format)[position + 1] == L'6' && ((PCWSTR) format)[position + 2] == L'4')
+                             : (((PCSTR) format)[position + 1] == '6' && ((PCSTR) format)[position + 2] == '4')) {
+                        size = 2;
+                        position += 3;
+                    } else {
+                        size = 2;
+                        position++;
+                    }
+                    break;
+                default:
+                    parsing = FALSE;
+                    break;
+            }
+        }
+
+        WCHAR conversion = INCALESCENT_POSIX_FORMAT_NEXT();
+#undef INCALESCENT_POSIX_FORMAT_NEXT
+        if (conversion == L'\0') {
+            return;
+        }
+        position++;
+
+        // Without an explicit width, %s and %c take the width of the format and %S and %C the other.
+        BOOL wideString = stringWidth != 0 ? stringWidth > 0 : (conversion == L's' || conversion == L'c') == wide;
+
+        CHAR number[512];
+        INT numberLength = -1;
+        switch (conversion) {
+            case L'%':
+                INCALESCENT_Posix_Put(output, L'%');
+                break;
+            case L'd':
+            case L'i':
+                specification[specificationLength++] = 'l';
+                specification[specificationLength++] = 'l';
+                specification[specificationLength++] = 'd';
+                specification[specificationLength] = '\0';
+                numberLength = snprintf(number, sizeof(number), specification,
+                                        size == 2 ? va_arg(parameters, LONGLONG) : size == -2 ? (LONGLONG) (signed char) va_arg(parameters, INT)
+                                                                                   : size == -1 ? (LONGLONG) (SHORT) va_arg(parameters, INT)
+                                                                                                : (LONGLONG) va_arg(parameters, INT));
+                break;
+            case L'u':
+            case L'x':
+            case L'X':
+            case L'o':
+                specification[specificationLength++] = 'l';
+                specification[specificationLength++] = 'l';
+                specification[specificationLength++] = (CHAR) conversion;
+                specification[specificationLength] = '\0';
+                numberLength = snprintf(number, sizeof(number), specification,
+                                        size == 2 ? va_arg(parameters, ULONGLONG) : size == -2 ? (ULONGLONG) (BYTE) va_arg(parameters, UINT)
+                                                                                    : size == -1 ? (ULONGLONG) (USHORT) va_arg(parameters, UINT)
+                                                                                                 : (ULONGLONG) va_arg(parameters, UINT));
+                break;
+            case L'f':
+            case L'F':
+            case L'e':
+            case L'E':
+            case L'g':
+            case L'G':
+            case L'a':
+            case L'A':
+                specification[specificationLength++] = (CHAR) conversion;
+                specification[specificationLength] = '\0';
+                numberLength = snprintf(number, sizeof(number), specification, va_arg(parameters, DOUBLE));
+                break;
+            case L'p':
+                numberLength = snprintf(number, sizeof(number), "%016llX", (ULONGLONG) (ULONG_PTR) va_arg(parameters, PVOID));
+                break;
+            case L'c':
+            case L'C': {
+                WCHAR value[2] = {(WCHAR) va_arg(parameters, INT), L'\0'};
+                CHAR narrowValue[2] = {(CHAR) value[0], '\0'};
+                INCALESCENT_Posix_PutString(output, wideString ? (LPCVOID) value : (LPCVOID) narrowValue, wideString, width, -1, left);
+                break;
+            }
+            case L's':
+            case L'S':
+                INCALESCENT_Posix_PutString(output, va_arg(parameters, LPCVOID), wideString, width, precision, left);
+                break;
+            default:
+                break;
+        }
+        for (INT index = 0; index < numberLength && index < (INT) sizeof(number) - 1; index++) {
+            INCALESCENT_Posix_Put(output, (BYTE) number[index]);
+        }
+    }
+}
+
+// Finishes a formatted string and reports where it ends and how much room is left behind it.
+static HRESULT INCALESCENT_Posix_Finish(INCALESCENT_Posix_Output *output, PVOID *end, SIZE_T *remaining) {
+    if (output->wide != NULL) {
+        output->wide[output->length] = L'\0';
+        if (end != NULL) {
+            *end = output->wide + output->length;
+        }
+    } else {
+        output->narrow[output->length] = '\0';
+        if (end != NULL) {
+            *end = output->narrow + output->length;
+        }
+    }
+    if (remaining != NULL) {
+        *remaining = output->size - output->length;
+    }
+    return output->truncated ? STRSAFE_E_INSUFFICIENT_BUFFER : S_OK;
+}
+
+// Implementation for StringCchLengthW
+HRESULT StringCchLengthW(PCWSTR string, SIZE_T maximum, SIZE_T *length) {
+    if (string == NULL || maximum > STRSAFE_MAX_CCH) {
+        return STRSAFE_E_INVALID_PARAMETER;
+    }
+    SIZE_T count = 0;
+    while (count < maximum && string[count] != L'\0') {
+        count++;
+    }
+    if (count == maximum) {
+        return STRSAFE_E_INVALID_PARAMETER;
+    }
+    if (length != NULL) {
+        *length = count;
+    }
+    return S_OK;
+}
+
+// Implementation for StringCchCopyNW
+HRESULT StringCchCopyNW(PWSTR destination, SIZE_T size, PCWSTR source, SIZE_T count) {
+    if (size == 0 || size > STRSAFE_MAX_CCH) {
+        return STRSAFE_E_INVALID_PARAMETER;
+    }
+    SIZE_T length = 0;
+    while (length < count && source[length] != L'\0') {
+        if (length + 1 == size) {
+            destination[length] = L'\0';
+            return STRSAFE_E_INSUFFICIENT_BUFFER;
+        }
+        destination[length] = source[length];
+        length++;
+    }
+    destination[length] = L'\0';
+    return S_OK;
+}
+
+// Implementation for StringCchCopyW
+HRESULT StringCchCopyW(PWSTR destination, SIZE_T size, PCWSTR source) {
+    return StringCchCopyNW(destination, size, source, STRSAFE_MAX_CCH);
+}
+
+// Implementation for StringCchCatW
+HRESULT StringCchCatW(PWSTR destination, SIZE_T size, PCWSTR source) {
+    SIZE_T length;
+    HRESULT result = StringCchLengthW(destination, size, &length);
+    if (FAILED(result)) {
+        return result;
+    }
+    return StringCchCopyW(destination + length, size - length, source);
+}
+
+// Implementation for StringCchVPrintfExW
+HRESULT StringCchVPrintfExW(PWSTR destination, SIZE_T size, PWSTR *end, SIZE_T *remaining, DWORD flags, PCWSTR format, va_list parameters) {
+    UNREFERENCED_PARAMETER(flags);
+    if (size == 0 || size > STRSAFE_MAX_CCH) {
+        return STRSAFE_E_INVALID_PARAMETER;
+    }
+    INCALESCENT_Posix_Output output = {.wide = destination, .size = size};
+    INCALESCENT_Posix_Format(&output, format, parameters);
+    return INCALESCENT_Posix_Finish(&output, (PVOID *) end, remaining);
+}
+
+// Implementation for StringCchVPrintfW
+HRESULT StringCchVPrintfW(PWSTR destination, SIZE_T size, PCWSTR format, va_list parameters) {
+    return StringCchVPrintfExW(destination, size, NULL, NULL, 0, format, parameters);
+}
+
+// Implementation for StringCchPrintfExW
+HRESULT StringCchPrintfExW(PWSTR destination, SIZE_T size, PWSTR *end, SIZE_T *remaining, DWORD flags, PCWSTR format, ...) {
+    va_list parameters;
+    va_start(parameters, format);
+    HRESULT result = StringCchVPrintfExW(destination, size, end, remaining, flags, format, parameters);
+    va_end(parameters);
+    return result;
+}
+
+// Implementation for StringCchPrintfW
+HRESULT StringCchPrintfW(PWSTR destination, SIZE_T size, PCWSTR format, ...) {
+    va_list parameters;
+    va_start(parameters, format);
+    HRESULT result = StringCchVPrintfExW(destination, size, NULL, NULL, 0, format, parameters);
+    va_end(parameters);
+    return result;
+}
+
+// Implementation for StringCchVPrintfExA
+HRESULT StringCchVPrintfExA(PSTR destination, SIZE_T size, PSTR *end, SIZE_T *remaining, DWORD flags, PCSTR format, va_list parameters) {
+    UNREFERENCED_PARAMETER(flags);
+    if (size == 0 || size > STRSAFE_MAX_CCH) {
+        return STRSAFE_E_INVALID_PARAMETER;
+    }
+    INCALESCENT_Posix_Output output = {.narrow = destination, .size = size};
+    INCALESCENT_Posix_Format(&output, format, parameters);
+    return INCALESCENT_Posix_Finish(&output, (PVOID *) end, remaining);
+}
+
+// Implementation for StringCchPrintfExA
+HRESULT StringCchPrintfExA(PSTR destination, SIZE_T size, PSTR *end, SIZE_T *remaining, DWORD flags, PCSTR format, ...) {
+    va_list parameters;
+    va_start(parameters, format);
+    HRESULT result = StringCchVPrintfExA(destination, size, end, remaining, flags, format, parameters);
+    va_end(parameters);
+    return result;
+}
+
+// Implementation for StringCchPrintfA
+HRESULT StringCchPrintfA(PSTR destination, SIZE_T size, PCSTR format, ...) {
+    va_list parameters;
+    va_start(parameters, format);
+    HRESULT result = StringCchVPrintfExA(destination, size, NULL, NULL, 0, format, parameters);
+    va_end(parameters);
+    return result;
+}
@@ -0,0 +1,48 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_POSIX_STRSAFE_H
+#define INCALESCENT_POSIX_STRSAFE_H
+#include <windows.h>
+
+// The counted string functions of <strsafe.h>. The formatting ones follow the Windows conventions
+// rather than the C library's: %s takes a string of the same width as the format and %hs a narrow
+// one, an l on an integer conversion still means 32 bits, and %I64 means 64 bits.
+
+#define STRSAFE_MAX_CCH 2147483647
+#define STRSAFE_E_INSUFFICIENT_BUFFER ((HRESULT) 0x8007007A)
+#define STRSAFE_E_INVALID_PARAMETER ((HRESULT) 0x80070057)
+
+HRESULT StringCchLengthW(PCWSTR string, SIZE_T maximum, SIZE_T *length);
+HRESULT StringCchCopyW(PWSTR destination, SIZE_T size, PCWSTR source);
+HRESULT StringCchCopyNW(PWSTR destination, SIZE_T size, PCWSTR source, SIZE_T count);
+HRESULT StringCchCatW(PWSTR destination, SIZE_T size, PCWSTR source);
+HRESULT StringCchPrintfW(PWSTR destination, SIZE_T size, PCWSTR format, ...);
+HRESULT StringCchVPrintfW(PWSTR destination, SIZE_T size, PCWSTR format, va_list parameters);
+HRESULT StringCchPrintfExW(PWSTR destination, SIZE_T size, PWSTR *end, SIZE_T *remaining, DWORD flags, PCWSTR format, ...);
+HRESULT StringCchVPrintfExW(PWSTR destination, SIZE_T size, PWSTR *end, SIZE_T *remaining, DWORD flags, PCWSTR format, va_list parameters);
+HRESULT StringCchPrintfA(PSTR destination, SIZE_T size, PCSTR format, ...);
+HRESULT StringCchPrintfExA(PSTR destination, SIZE_T size, PSTR *end, SIZE_T *remaining, DWORD flags, PCSTR format, ...);
+HRESULT StringCchVPrintfExA(PSTR destination, SIZE_T size, PSTR *end, SIZE_T *remaining, DWORD flags, PCSTR format, va_list parameters);
+
+#endif //INCALESCENT_POSIX_STRSAFE_H
@@ -0,0 +1,484 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+
+// The code page of the names in zip archives that don't mark them as UTF-8.
+#define INCALESCENT_POSIX_CODE_PAGE_OEM_US 437
+
+#define INCALESCENT_POSIX_REPLACEMENT_CHARACTER 0xFFFD
+
+// The upper half of code page 437, the lower half being ASCII.
+static const WCHAR INCALESCENT_Posix_CodePage437[128] = {
+        0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7, 0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+        0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9, 0x00FF, 0x00D6, 0x00DC, 0x00A2, 0x00A3, 0x00A5, 0x20A7, 0x0192,
+        0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA, 0x00BF, 0x2310, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+        0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556, 0x2555, 0x2563, 0x2551, 0x2557, 0x255D, 0x255C, 0x255B, 0x2510,
+        0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x255E, 0x255F, 0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x2567,
+        0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256B, 0x256A, 0x2518, 0x250C, 0x2588, 0x2584, 0x258C, 0x2590, 0x2580,
+        0x03B1, 0x00DF, 0x0393, 0x03C0, 0x03A3, 0x03C3, 0x00B5, 0x03C4, 0x03A6, 0x0398, 0x03A9, 0x03B4, 0x221E, 0x03C6, 0x03B5, 0x2229,
+        0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0,
+};
+
+// One element of a string in sort order, either a single character or, when digits sort as
+// numbers, a whole run of digits.
+typedef struct INCALESCENT_Posix_Element {
+    DWORD weight;
+    BOOL number;
+
+    // The digits of a number without its leading zeros, and how many zeros there were.
+    LPCWSTR digits;
+    INT digitCount;
+    INT zeroCount;
+
+    // The characters of the string the element covers, to tell case apart.
+    LPCWSTR characters;
+    INT characterCount;
+} INCALESCENT_Posix_Element;
+
+// Whether a character is in a range where upper and lower case alternate, starting with upper case
+// at the even or odd code point given by parity.
+static BOOL INCALESCENT_Posix_Alternating(WCHAR character, WCHAR *parity) {
+    if ((character >= 0x0100 && character <= 0x012F) || (character >= 0x0132 && character <= 0x0137) ||
+        (character >= 0x014A && character <= 0x0177)) {
+        *parity = 0;
+        return TRUE;
+    }
+    if ((character >= 0x0139 && character <= 0x0148) || (character >= 0x0179 && character <= 0x017E)) {
+        *parity = 1;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// The lower case of the characters that the sort order folds: ASCII, Latin-1, Latin Extended-A,
+// Greek and Cyrillic. Other characters are their own lower case.
+static WCHAR INCALESCENT_Posix_Lower(WCHAR character) {
+    WCHAR parity;
+    if ((character >= L'A' && character <= L'Z') || (character >= 0x00C0 && character <= 0x00DE && character != 0x00D7) ||
+        (character >= 0x0391 && character <= 0x03A9 && character != 0x03A2) || (character >= 0x0410 && character <= 0x042F)) {
+        return character + 0x20;
+    }
+    if (character >= 0x0400 && character <= 0x040F) {
+        return character + 0x50;
+    }
+    if (INCALESCENT_Posix_Alternating(character, &parity) && (character & 1) == parity) {
+        return character + 1;
+    }
+    return character;
+}
+
+// The upper case of a character, the inverse of INCALESCENT_Posix_Lower.
+static WCHAR INCALESCENT_Posix_Upper(WCHAR character) {
+    WCHAR parity;
+    if ((character >= L'a' && character <= L'z') || (character >= 0x00E0 && character <= 0x00FE && character != 0x00F7) ||
+        (character >= 0x03B1 && character <= 0x03C9 && character != 0x03C2) || (character >= 0x0430 && character <= 0x044F)) {
+        return character - 0x20;
+    }
+    if (character >= 0x0450 && character <= 0x045F) {
+        return character - 0x50;
+    }
+    if (INCALESCENT_Posix_Alternating(character, &parity) && (character & 1) != parity) {
+        return character - 1;
+    }
+    return character;
+}
+
+static BOOL INCALESCENT_Posix_Digit(WCHAR character) {
+    return character >= L'0' && character <= L'9';
+}
+
+// Reads the element at *position of a string of the given length and advances past it. A
+// character weighs one more than its lower case, which keeps zero free to end the string, and
+// a number weighs what the digit zero does so that numbers sort among the digits.
+static void INCALESCENT_Posix_NextElement(LPCWSTR string, INT length, INT *position, BOOL numbers, INCALESCENT_Posix_Element *element) {
+    INT start = *position;
+    element->characters = string + start;
+    if (!numbers || !INCALESCENT_Posix_Digit(string[start])) {
+        element->weight = (DWORD) INCALESCENT_Posix_Lower(string[start]) + 1;
+        element->number = FALSE;
+        element->characterCount = 1;
+        *position = start + 1;
+        return;
+    }
+
+    INT end = start;
+    while (end < length && INCALESCENT_Posix_Digit(string[end])) {
+        end++;
+    }
+    INT significant = start;
+    while (significant < end - 1 && string[significant] == L'0') {
+        significant++;
+    }
+    element->weight = L'0' + 1;
+    element->number = TRUE;
+    element->digits = string + significant;
+    element->digitCount = end - significant;
+    element->zeroCount = significant - start;
+    element->characterCount = end - start;
+    *position = end;
+}
+
+// Compares the primary weight of two elements: first their weights, then for two numbers how many
+// significant digits they have, then the digits themselves.
+static INT INCALESCENT_Posix_CompareElements(const INCALESCENT_Posix_Element *first, const INCALESCENT_Posix_Element *second) {
+    if (first->weight != second->weight) {
+        return first->weight < second->weight ? -1 : 1;
+    }
+    if (!first->number) {
+        return 0;
+    }
+    if (first->digitCount != second->digitCount) {
+        return first->digitCount < second->digitCount ? -1 : 1;
+    }
+    for (INT index = 0; index < first->digitCount; index++) {
+        if (first->digits[index] != second->digits[index]) {
+            return first->digits[index] < second->digits[index] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// Compares the case of two elements of equal primary weight, with lower case first.
+static INT INCALESCENT_Posix_CompareCase(const INCALESCENT_Posix_Element *first, const INCALESCENT_Posix_Element *second) {
+    if (first->number) {
+        return 0;
+    }
+    BOOL firstUpper = first->characters[0] != INCALESCENT_Posix_Lower(first->characters[0]);
+    BOOL secondUpper = second->characters[0] != INCALESCENT_Posix_Lower(second->characters[0]);
+    return firstUpper == secondUpper ? 0 : (firstUpper ? 1 : -1);
+}
+
+static INT INCALESCENT_Posix_Length(LPCWSTR string, INT length) {
+    return length < 0 ? lstrlenW(string) : length;
+}
+
+// Implementation for lstrlenW
+INT lstrlenW(LPCWSTR string) {
+    if (string == NULL) {
+        return 0;
+    }
+    LPCWSTR end = string;
+    while (*end != L'\0') {
+        end++;
+    }
+    return (INT) (end - string);
+}
+
+// Implementation for lstrlenA
+INT lstrlenA(LPCSTR string) {
+    return string == NULL ? 0 : (INT) strlen(string);
+}
+
+// Decodes the UTF-8 sequence at bytes[*position] and advances past it. Returns FALSE for a
+// sequence that is malformed, overlong, a surrogate or out of range, having advanced one byte.
+static BOOL INCALESCENT_Posix_DecodeUtf8(const BYTE *bytes, INT byteCount, INT *position, DWORD *codePoint) {
+    BYTE lead = bytes[*position];
+    INT length = lead < 0x80 ? 1 : (lead & 0xE0) == 0xC0 ? 2 : (lead & 0xF0) == 0xE0 ? 3 : (lead & 0xF8) == 0xF0 ? 4 : 0;
+    static const DWORD minimums[] = {0, 0, 0x80, 0x800, 0x10000};
+
+    (*position)++;
+    if (length == 0 || *position - 1 + length > byteCount) {
+        return FALSE;
+    }
+    DWORD value = length == 1 ? lead : lead & (0x7F >> length);
+    for (INT index = 1; index < length; index++) {
+        BYTE continuation = bytes[*position - 1 + index];
+        if ((continuation & 0xC0) != 0x80) {
+            return FALSE;
+        }
+        value = (value << 6) | (continuation & 0x3F);
+    }
+    if (value < minimums[length] || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+        return FALSE;
+    }
+    *position += length - 1;
+    *codePoint = value;
+    return TRUE;
+}
+
+// Implementation for MultiByteToWideChar
+INT MultiByteToWideChar(UINT codePage, DWORD flags, LPCCH bytes, INT byteCount, LPWSTR wide, INT wideCount) {
+    if (bytes == NULL || (codePage != CP_UTF8 && codePage != INCALESCENT_POSIX_CODE_PAGE_OEM_US) || wideCount < 0) {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return 0;
+    }
+    if (byteCount < 0) {
+        byteCount = lstrlenA(bytes) + 1;
+    }
+
+    // Without a buffer, only count how many code units the string takes.
+    const BYTE *source = (const BYTE *) bytes;
+    INT count = 0;
+    for (INT position = 0; position < byteCount;) {
+        DWORD codePoint;
+        if (codePage == INCALESCENT_POSIX_CODE_PAGE_OEM_US) {
+            codePoint = source[position] < 0x80 ? source[position] : INCALESCENT_Posix_CodePage437[source[position] - 0x80];
+            position++;
+        } else if (!INCALESCENT_Posix_DecodeUtf8(source, byteCount, &position, &codePoint)) {
+            if (flags & MB_ERR_INVALID_CHARS) {
+                SetLastError(ERROR_NO_UNICODE_TRANSLATION);
+                return 0;
+            }
+            codePoint = INCALESCENT_POSIX_REPLACEMENT_CHARACTER;
+        }
+
+        INT units = codePoint > 0xFFFF ? 2 : 1;
+        if (wideCount != 0) {
+            if (count + units > wideCount) {
+                SetLastError(ERROR_INSUFFICIENT_BUFFER);
+                return 0;
+            }
+            if (units == 2) {
+                wide[count] = (WCHAR) (0xD800 + ((codePoint - 0x10000) >> 10));
+                wide[count + 1] = (WCHAR) (0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+            } else {
+                wide[count] = (WCHAR) codePoint;
+            }
+        }
+        count += units;
+    }
+    return count;
+}
+
+// Implementation for WideCharToMultiByte
+INT WideCharToMultiByte(UINT codePage, DWORD flags, LPCWSTR wide, INT wideCount, LPSTR bytes, INT byteCount, LPCCH defaultChar, PBOOL usedDefault) {
+    UNREFERENCED_PARAMETER(defaultChar);
+    if (wide == NULL || codePage != CP_UTF8 || byteCount < 0) {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return 0;
+    }
+    if (usedDefault != NULL) {
+        *usedDefault = FALSE;
+    }
+    if (wideCount < 0) {
+        wideCount = lstrlenW(wide) + 1;
+    }
+
+    // Without a buffer, only count how many bytes the string takes.
+    INT count = 0;
+    for (INT position = 0; position < wideCount; position++) {
+        DWORD codePoint = wide[position];
+        if (IS_HIGH_SURROGATE(codePoint) && position + 1 < wideCount && IS_LOW_SURROGATE(wide[position + 1])) {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (wide[position + 1] - 0xDC00);
+            position++;
+        } else if (IS_HIGH_SURROGATE(codePoint) || IS_LOW_SURROGATE(codePoint)) {
+            if (flags & WC_ERR_INVALID_CHARS) {
+                SetLastError(ERROR_NO_UNICODE_TRANSLATION);
+                return 0;
+            }
+            codePoint = INCALESCENT_POSIX_REPLACEMENT_CHARACTER;
+        }
+
+        BYTE encoded[4];
+        INT length;
+        if (codePoint < 0x80) {
+            encoded[0] = (BYTE) codePoint;
+            length = 1;
+        } else if (codePoint < 0x800) {
+            encoded[0] = (BYTE) (0xC0 | (codePoint >> 6));
+            encoded[1] = (BYTE) (0x80 | (codePoint & 0x3F));
+            length = 2;
+        } else if (codePoint < 0x10000) {
+            encoded[0] = (BYTE) (0xE0 | (codePoint >> 12));
+            encoded[1] = (BYTE) (0x80 | ((codePoint >> 6) & 0x3F));
+            encoded[2] = (BYTE) (0x80 | (codePoint & 0x3F));
+            length = 3;
+        } else {
+            encoded[0] = (BYTE) (0xF0 | (codePoint >> 18));
+            encoded[1] = (BYTE) (0x80 | ((codePoint >> 12) & 0x3F));
+            encoded[2] = (BYTE) (0x80 | ((codePoint >> 6) & 0x3F));
+            encoded[3] = (BYTE) (0x80 | (codePoint & 0x3F));
+            length = 4;
+        }
+
+        if (byteCount != 0) {
+            if (count + length > byteCount) {
+                SetLastError(ERROR_INSUFFICIENT_BUFFER);
+                return 0;
+            }
+            CopyMemory(bytes + count, encoded, length);
+        }
+        count += length;
+    }
+    return count;
+}
+
+// Implementation for CompareStringOrdinal
+INT CompareStringOrdinal(LPCWSTR first, INT firstLength, LPCWSTR second, INT secondLength, BOOL ignoreCase) {
+    firstLength = INCALESCENT_Posix_Length(first, firstLength);
+    secondLength = INCALESCENT_Posix_Length(second, secondLength);
+
+    // Ignoring case compares the upper case of both, as Windows does.
+    INT length = firstLength < secondLength ? firstLength : secondLength;
+    for (INT index = 0; index < length; index++) {
+        WCHAR firstCharacter = ignoreCase ? INCALESCENT_Posix_Upper(first[index]) : first[index];
+        WCHAR secondCharacter = ignoreCase ? INCALESCENT_Posix_Upper(second[index]) : second[index];
+        if (firstCharacter != secondCharacter) {
+            return firstCharacter < secondCharacter ? CSTR_LESS_THAN : CSTR_GREATER_THAN;
+        }
+    }
+    return firstLength == secondLength ? CSTR_EQUAL : (firstLength < secondLength ? CSTR_LESS_THAN : CSTR_GREATER_THAN);
+}
+
+// Implementation for CompareStringEx
+INT CompareStringEx(LPCWSTR locale, DWORD flags, LPCWSTR first, INT firstLength, LPCWSTR second, INT secondLength, LPVOID version, LPVOID reserved,
+                    LPARAM parameter) {
+    UNREFERENCED_PARAMETER(locale);
+    UNREFERENCED_PARAMETER(version);
+    UNREFERENCED_PARAMETER(reserved);
+    UNREFERENCED_PARAMETER(parameter);
+    if (first == NULL || second == NULL) {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return 0;
+    }
+
+    // Trailing terminators of an explicit length are not part of the string.
+    firstLength = INCALESCENT_Posix_Length(first, firstLength);
+    secondLength = INCALESCENT_Posix_Length(second, secondLength);
+    while (firstLength > 0 && first[firstLength - 1] == L'\0') {
+        firstLength--;
+    }
+    while (secondLength > 0 && second[secondLength - 1] == L'\0') {
+        secondLength--;
+    }
+
+    // The primary weights decide, then the leading zeros of the numbers, and then the case of the
+    // characters unless it is ignored.
+    BOOL numbers = (flags & SORT_DIGITSASNUMBERS) != 0;
+    BOOL ignoreCase = (flags & (NORM_IGNORECASE | LINGUISTIC_IGNORECASE)) != 0;
+    INT zeros = 0;
+    INT letterCase = 0;
+    INT firstPosition = 0;
+    INT secondPosition = 0;
+    while (firstPosition < firstLength && secondPosition < secondLength) {
+        INCALESCENT_Posix_Element firstElement;
+        INCALESCENT_Posix_Element secondElement;
+        INCALESCENT_Posix_NextElement(first, firstLength, &firstPosition, numbers, &firstElement);
+        INCALESCENT_Posix_NextElement(second, secondLength, &secondPosition, numbers, &secondElement);
+
+        INT comparison = INCALESCENT_Posix_CompareElements(&firstElement, &secondElement);
+        if (comparison != 0) {
+            return comparison < 0 ? CSTR_LESS_THAN : CSTR_GREATER_THAN;
+        }
+        if (zeros == 0 && firstElement.number && firstElement.zeroCount != secondElement.zeroCount) {
+            zeros = firstElement.zeroCount < secondElement.zeroCount ? -1 : 1;
+        }
+        if (letterCase == 0 && !ignoreCase) {
+            letterCase = INCALESCENT_Posix_CompareCase(&firstElement, &secondElement);
+        }
+    }
+    if (firstPosition < firstLength || secondPosition < secondLength) {
+        return firstPosition < firstLength ? CSTR_GREATER_THAN : CSTR_LESS_THAN;
+    }
+
+    INT comparison = zeros != 0 ? zeros : letterCase;
+    return comparison == 0 ? CSTR_EQUAL : (comparison < 0 ? CSTR_LESS_THAN : CSTR_GREATER_THAN);
+}
+
+// Implementation for CompareStringW
+INT CompareStringW(DWORD locale, DWORD flags, LPCWSTR first, INT firstLength, LPCWSTR second, INT secondLength) {
+    UNREFERENCED_PARAMETER(locale);
+    return CompareStringEx(LOCALE_NAME_USER_DEFAULT, flags, first, firstLength, second, secondLength, NULL, NULL, 0);
+}
+
+// Appends a big-endian value of the given number of bytes to a sort key, or only counts it when
+// the key has no buffer.
+static BOOL INCALESCENT_Posix_AppendKey(PBYTE key, INT keySize, INT *keyLength, DWORD value, INT byteCount) {
+    if (key != NULL) {
+        if (*keyLength + byteCount > keySize) {
+            return FALSE;
+        }
+        for (INT index = 0; index < byteCount; index++) {
+            key[*keyLength + index] = (BYTE) (value >> (8 * (byteCount - 1 - index)));
+        }
+    }
+    *keyLength += byteCount;
+    return TRUE;
+}
+
+// Implementation for LCMapStringEx
+INT LCMapStringEx(LPCWSTR locale, DWORD flags, LPCWSTR source, INT sourceLength, LPWSTR destination, INT destinationLength, LPVOID version,
+                  LPVOID reserved, LPARAM parameter) {
+    UNREFERENCED_PARAMETER(locale);
+    UNREFERENCED_PARAMETER(version);
+    UNREFERENCED_PARAMETER(reserved);
+    UNREFERENCED_PARAMETER(parameter);
+
+    // Only sort keys are supported, which are byte strings ordered like CompareStringEx with the
+    // same flags orders their strings.
+    if (!(flags & LCMAP_SORTKEY) || source == NULL || destinationLength < 0) {
+        SetLastError(ERROR_INVALID_FLAGS);
+        return 0;
+    }
+    sourceLength = INCALESCENT_Posix_Length(source, sourceLength);
+    while (sourceLength > 0 && source[sourceLength - 1] == L'\0') {
+        sourceLength--;
+    }
+
+    PBYTE key = destinationLength == 0 ? NULL : (PBYTE) destination;
+    BOOL numbers = (flags & SORT_DIGITSASNUMBERS) != 0;
+    BOOL ignoreCase = (flags & (NORM_IGNORECASE | LINGUISTIC_IGNORECASE)) != 0;
+    INT keyLength = 0;
+    BOOL fits = TRUE;
+
+    // The primary level holds three bytes of weight per element, a number followed by its count
+    // of significant digits and the digits, and ends in a zero weight below every element.
+    for (INT position = 0; position < sourceLength && fits;) {
+        INCALESCENT_Posix_Element element;
+        INCALESCENT_Posix_NextElement(source, sourceLength, &position, numbers, &element);
+        fits = INCALESCENT_Posix_AppendKey(key, destinationLength, &keyLength, element.weight, 3);
+        if (element.number) {
+            fits = fits && INCALESCENT_Posix_AppendKey(key, destinationLength, &keyLength, (DWORD) element.digitCount, 2);
+            for (INT index = 0; index < element.digitCount && fits; index++) {
+                fits = INCALESCENT_Posix_AppendKey(key, destinationLength, &keyLength, element.digits[index], 1);
+            }
+        }
+    }
+    fits = fits && INCALESCENT_Posix_AppendKey(key, destinationLength, &keyLength, 0, 3);
+
+    // The secondary level holds the leading zeros of every number, one above their count so that
+    // a zero ends the level, and the tertiary level whether each character is upper case.
+    for (INT position = 0; position < sourceLength && fits;) {
+        INCALESCENT_Posix_Element element;
+        INCALESCENT_Posix_NextElement(source, sourceLength, &position, numbers, &element);
+        if (element.number) {
+            fits = INCALESCENT_Posix_AppendKey(key, destinationLength, &keyLength, (DWORD) element.zeroCount + 1, 2);
+        }
+    }
+    fits = fits && INCALESCENT_Posix_AppendKey(key, destinationLength, &keyLength, 0, 2);
+    for (INT position = 0; position < sourceLength && fits && !ignoreCase;) {
+        INCALESCENT_Posix_Element element;
+        INCALESCENT_Posix_NextElement(source, sourceLength, &position, numbers, &element);
+        if (!element.number) {
+            fits = INCALESCENT_Posix_AppendKey(key, destinationLength, &keyLength, element.characters[0] != INCALESCENT_Posix_Lower(element.characters[0]) ? 2 : 1, 1);
+        }
+    }
+    fits = fits && INCALESCENT_Posix_AppendKey(key, destinationLength, &keyLength, 0, 1);
+
+    if (!fits) {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+        return 0;
+    }
+    return keyLength;
+}
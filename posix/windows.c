@@ -0,0 +1,1567 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include <windows.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+// The directory entries a search reads with each call.
+#define INCALESCENT_POSIX_FIND_BUFFER_SIZE (32 * 1024)
+
+// The seconds between 1601, where a FILETIME starts counting, and 1970.
+#define INCALESCENT_POSIX_EPOCH_DIFFERENCE 11644473600ULL
+
+typedef enum INCALESCENT_Posix_Kind {
+    INCALESCENT_POSIX_KIND_FILE = 0,
+    INCALESCENT_POSIX_KIND_EVENT = 1,
+    INCALESCENT_POSIX_KIND_THREAD = 2,
+    INCALESCENT_POSIX_KIND_FIND = 3,
+    INCALESCENT_POSIX_KIND_MAPPING = 4,
+} INCALESCENT_Posix_Kind;
+
+// What a HANDLE points at. Files and events are both file descriptors, the latter an eventfd, so
+// that either can be waited on with poll.
+typedef struct INCALESCENT_Posix_Object {
+    INCALESCENT_Posix_Kind kind;
+    INT descriptor;
+    BOOL manualReset;
+    BOOL standard;
+
+    // A thread, which is joined by the first wait for it.
+    pthread_t thread;
+    LPTHREAD_START_ROUTINE start;
+    LPVOID parameter;
+    BOOL joined;
+
+    // A directory search, which only matches names ending in a suffix, and an empty suffix
+    // matches every name. The directory is the descriptor, and its entries are read a buffer at a
+    // time. An ASCII suffix is also kept in uppercase bytes, so that names can be matched before
+    // they are converted.
+    PBYTE entries;
+    SIZE_T entriesSize;
+    SIZE_T entriesOffset;
+    CHAR path[INCALESCENT_POSIX_PATH_SIZE];
+    SIZE_T pathLength;
+    WCHAR suffix[MAX_PATH];
+    INT suffixLength;
+    CHAR asciiSuffix[MAX_PATH];
+    BOOL ascii;
+    BOOL namesOnly;
+
+    // A mapping of a whole file.
+    SIZE_T size;
+} INCALESCENT_Posix_Object;
+
+// Every reservation and mapped view starts a page before the address it hands out. The first page
+// records how large the whole region is, which VirtualFree and UnmapViewOfFile aren't told.
+typedef struct INCALESCENT_Posix_Region {
+    SIZE_T size;
+} INCALESCENT_Posix_Region;
+
+static _Thread_local DWORD INCALESCENT_Posix_LastError = ERROR_SUCCESS;
+
+// The innermost guarded block the thread is in, and the handler that jumps out of it.
+static _Thread_local INCALESCENT_Posix_Guard *INCALESCENT_Posix_Guards = NULL;
+static pthread_once_t INCALESCENT_Posix_GuardOnce = PTHREAD_ONCE_INIT;
+
+static INCALESCENT_Posix_Object INCALESCENT_Posix_StandardInput = {.kind = INCALESCENT_POSIX_KIND_FILE, .descriptor = 0, .standard = TRUE};
+static INCALESCENT_Posix_Object INCALESCENT_Posix_StandardOutput = {.kind = INCALESCENT_POSIX_KIND_FILE, .descriptor = 1, .standard = TRUE};
+static INCALESCENT_Posix_Object INCALESCENT_Posix_StandardError = {.kind = INCALESCENT_POSIX_KIND_FILE, .descriptor = 2, .standard = TRUE};
+
+// The console control handler. Only one can be installed at a time.
+static volatile PHANDLER_ROUTINE INCALESCENT_Posix_ControlHandler = NULL;
+
+// Implementation for INCALESCENT_Posix_Error
+DWORD INCALESCENT_Posix_Error(INT error) {
+    switch (error) {
+        case 0:
+            return ERROR_SUCCESS;
+        case ENOENT:
+            return ERROR_FILE_NOT_FOUND;
+        case ENOTDIR:
+            return ERROR_PATH_NOT_FOUND;
+        case EACCES:
+        case EPERM:
+        case EISDIR:
+        case EROFS:
+            return ERROR_ACCESS_DENIED;
+        case EEXIST:
+            return ERROR_FILE_EXISTS;
+        case EBADF:
+            return ERROR_INVALID_HANDLE;
+        case ENOMEM:
+            return ERROR_NOT_ENOUGH_MEMORY;
+        case EINVAL:
+            return ERROR_INVALID_PARAMETER;
+        case EMFILE:
+        case ENFILE:
+            return ERROR_TOO_MANY_OPEN_FILES;
+        case ENOSPC:
+        case EDQUOT:
+            return ERROR_DISK_FULL;
+        case ENAMETOOLONG:
+            return ERROR_FILENAME_EXCED_RANGE;
+        case EBUSY:
+        case ETXTBSY:
+            return ERROR_SHARING_VIOLATION;
+        case EXDEV:
+            return ERROR_NOT_SAME_DEVICE;
+        case ENOTEMPTY:
+            return ERROR_DIR_NOT_EMPTY;
+        case EPIPE:
+            return ERROR_BROKEN_PIPE;
+        case EIO:
+            return ERROR_IO_DEVICE;
+        case EFAULT:
+            return ERROR_NOACCESS;
+        case EOVERFLOW:
+        case EFBIG:
+            return ERROR_BUFFER_OVERFLOW;
+        case ETIMEDOUT:
+            return ERROR_TIMEOUT;
+        default:
+            return ERROR_GEN_FAILURE;
+    }
+}
+
+// Records the error of the last failed system call and returns a value to fail with.
+static BOOL INCALESCENT_Posix_Fail(void) {
+    INCALESCENT_Posix_LastError = INCALESCENT_Posix_Error(errno);
+    return FALSE;
+}
+
+static PVOID INCALESCENT_Posix_FailWith(DWORD error) {
+    INCALESCENT_Posix_LastError = error;
+    return NULL;
+}
+
+static INCALESCENT_Posix_Object *INCALESCENT_Posix_CreateObject(INCALESCENT_Posix_Kind kind) {
+    INCALESCENT_Posix_Object *object = calloc(1, sizeof(INCALESCENT_Posix_Object));
+    if (object == NULL) {
+        return INCALESCENT_Posix_FailWith(ERROR_NOT_ENOUGH_MEMORY);
+    }
+    object->kind = kind;
+    object->descriptor = -1;
+    return object;
+}
+
+// Implementation for INCALESCENT_Posix_Path
+BOOL INCALESCENT_Posix_Path(LPCWSTR path, PSTR converted) {
+    if (path == NULL) {
+        INCALESCENT_Posix_LastError = ERROR_INVALID_PARAMETER;
+        return FALSE;
+    }
+    if (path[0] == L'N' && path[1] == L'U' && path[2] == L'L' && path[3] == L'\0') {
+        strcpy(converted, "/dev/null");
+        return TRUE;
+    }
+
+    INT length = WideCharToMultiByte(CP_UTF8, 0, path, -1, converted, INCALESCENT_POSIX_PATH_SIZE, NULL, NULL);
+    if (length == 0) {
+        INCALESCENT_Posix_LastError = ERROR_FILENAME_EXCED_RANGE;
+        return FALSE;
+    }
+    for (PSTR character = converted; *character != '\0'; character++) {
+        if (*character == '\\') {
+            *character = '/';
+        }
+    }
+
+    // A path ending in a separator still names the directory.
+    if (length > 2 && converted[length - 2] == '/') {
+        converted[length - 2] = '\0';
+    }
+    return TRUE;
+}
+
+// Converts seconds and nanoseconds since 1970 into a FILETIME.
+static void INCALESCENT_Posix_FileTime(const struct timespec *time, FILETIME *fileTime) {
+    ULONGLONG ticks = (((ULONGLONG) time->tv_sec + INCALESCENT_POSIX_EPOCH_DIFFERENCE) * 10000000ULL) + ((ULONGLONG) time->tv_nsec / 100);
+    fileTime->dwLowDateTime = (DWORD) ticks;
+    fileTime->dwHighDateTime = (DWORD) (ticks >> 32);
+}
+
+static ULONGLONG INCALESCENT_Posix_Clock(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return ((ULONGLONG) now.tv_sec * 1000000000ULL) + (ULONGLONG) now.tv_nsec;
+}
+
+// Turns a timeout in milliseconds into one for poll.
+static INT INCALESCENT_Posix_Timeout(DWORD milliseconds) {
+    return milliseconds == INFINITE ? -1 : (INT) (milliseconds > 0x7FFFFFFF ? 0x7FFFFFFF : milliseconds);
+}
+
+// Implementation for GetLastError
+DWORD GetLastError(void) {
+    return INCALESCENT_Posix_LastError;
+}
+
+// Implementation for SetLastError
+void SetLastError(DWORD error) {
+    INCALESCENT_Posix_LastError = error;
+}
+
+// Implementation for FormatMessageW
+DWORD FormatMessageW(DWORD flags, LPCVOID source, DWORD messageId, DWORD languageId, LPWSTR buffer, DWORD size, va_list *arguments) {
+    static const struct {
+        DWORD error;
+        PCSTR message;
+    } messages[] = {
+            {ERROR_SUCCESS, "The operation completed successfully."},
+            {ERROR_FILE_NOT_FOUND, "The system cannot find the file specified."},
+            {ERROR_PATH_NOT_FOUND, "The system cannot find the path specified."},
+            {ERROR_TOO_MANY_OPEN_FILES, "The system cannot open the file."},
+            {ERROR_ACCESS_DENIED, "Access is denied."},
+            {ERROR_INVALID_HANDLE, "The handle is invalid."},
+            {ERROR_NOT_ENOUGH_MEMORY, "Not enough memory resources are available to process this command."},
+            {ERROR_BAD_FORMAT, "An attempt was made to load a program with an incorrect format."},
+            {ERROR_INVALID_DATA, "The data is invalid."},
+            {ERROR_OUTOFMEMORY, "Not enough memory resources are available to complete this operation."},
+            {ERROR_NOT_SAME_DEVICE, "The system cannot move the file to a different disk drive."},
+            {ERROR_NO_MORE_FILES, "There are no more files."},
+            {ERROR_CRC, "Data error (cyclic redundancy check)."},
+            {ERROR_WRITE_FAULT, "The system cannot write to the specified device."},
+            {ERROR_READ_FAULT, "The system cannot read from the specified device."},
+            {ERROR_GEN_FAILURE, "A device attached to the system is not functioning."},
+            {ERROR_SHARING_VIOLATION, "The process cannot access the file because it is being used by another process."},
+            {ERROR_HANDLE_EOF, "Reached the end of the file."},
+            {ERROR_NOT_SUPPORTED, "The request is not supported."},
+            {ERROR_FILE_EXISTS, "The file exists."},
+            {ERROR_INVALID_PARAMETER, "The parameter is incorrect."},
+            {ERROR_BROKEN_PIPE, "The pipe has been ended."},
+            {ERROR_BUFFER_OVERFLOW, "The file name is too long."},
+            {ERROR_DISK_FULL, "There is not enough space on the disk."},
+            {ERROR_INSUFFICIENT_BUFFER, "The data area passed to a system call is too small."},
+            {ERROR_DIR_NOT_EMPTY, "The directory is not empty."},
+            {ERROR_ALREADY_EXISTS, "Cannot create a file when that file already exists."},
+            {ERROR_FILENAME_EXCED_RANGE, "The filename or extension is too long."},
+            {ERROR_DIRECTORY, "The directory name is invalid."},
+            {ERROR_OPERATION_ABORTED, "The I/O operation has been aborted because of either a thread exit or an application request."},
+            {ERROR_NOACCESS, "Invalid access to memory location."},
+            {ERROR_INVALID_FLAGS, "Invalid flags."},
+            {ERROR_FILE_INVALID, "The volume for a file has been externally altered so that the opened file is no longer valid."},
+            {ERROR_NO_UNICODE_TRANSLATION, "No mapping for the Unicode character exists in the target multi-byte code page."},
+            {ERROR_IO_DEVICE, "The request could not be performed because of an I/O device error."},
+            {ERROR_FILE_CORRUPT, "The file or directory is corrupted and unreadable."},
+            {ERROR_TIMEOUT, "This operation returned because the timeout period expired."},
+            {ERROR_NOT_ENOUGH_QUOTA, "Not enough quota is available to process this command."},
+    };
+    UNREFERENCED_PARAMETER(source);
+    UNREFERENCED_PARAMETER(languageId);
+    UNREFERENCED_PARAMETER(arguments);
+
+    // Only the messages of Win32 errors are known, whether given as they are or as an HRESULT.
+    DWORD error = messageId;
+    if ((messageId & 0xFFFF0000) == 0x80070000) {
+        error = messageId & 0xFFFF;
+    } else if (messageId == (DWORD) E_OUTOFMEMORY) {
+        error = ERROR_OUTOFMEMORY;
+    } else if (messageId == (DWORD) E_UNEXPECTED || messageId == (DWORD) E_FAIL) {
+        error = ERROR_GEN_FAILURE;
+    }
+
+    PCSTR message = NULL;
+    for (SIZE_T index = 0; index < ARRAYSIZE(messages); index++) {
+        if (messages[index].error == error) {
+            message = messages[index].message;
+            break;
+        }
+    }
+    if (message == NULL || !(flags & FORMAT_MESSAGE_FROM_SYSTEM)) {
+        INCALESCENT_Posix_LastError = ERROR_MR_MID_NOT_FOUND;
+        return 0;
+    }
+
+    // Like the system messages, every one ends in a line break.
+    SIZE_T length = strlen(message) + 2;
+    LPWSTR text = buffer;
+    if (flags & FORMAT_MESSAGE_ALLOCATE_BUFFER) {
+        text = malloc(sizeof(WCHAR) * (length + 1));
+        if (text == NULL) {
+            INCALESCENT_Posix_LastError = ERROR_NOT_ENOUGH_MEMORY;
+            return 0;
+        }
+        *(LPWSTR *) buffer = text;
+    } else if (size < length + 1) {
+        INCALESCENT_Posix_LastError = ERROR_INSUFFICIENT_BUFFER;
+        return 0;
+    }
+    for (SIZE_T index = 0; index < length - 2; index++) {
+        text[index] = (WCHAR) message[index];
+    }
+    text[length - 2] = L'\r';
+    text[length - 1] = L'\n';
+    text[length] = L'\0';
+    return (DWORD) length;
+}
+
+// Implementation for LocalFree
+PVOID LocalFree(PVOID memory) {
+    free(memory);
+    return NULL;
+}
+
+// Implementation for GetProcessHeap
+HANDLE GetProcessHeap(void) {
+    static BYTE heap;
+    return &heap;
+}
+
+// Implementation for HeapAlloc
+LPVOID HeapAlloc(HANDLE heap, DWORD flags, SIZE_T size) {
+    UNREFERENCED_PARAMETER(heap);
+    LPVOID memory = (flags & HEAP_ZERO_MEMORY) ? calloc(1, size) : malloc(size);
+    if (memory == NULL) {
+        INCALESCENT_Posix_LastError = ERROR_NOT_ENOUGH_MEMORY;
+    }
+    return memory;
+}
+
+// Implementation for HeapFree
+BOOL HeapFree(HANDLE heap, DWORD flags, LPVOID memory) {
+    UNREFERENCED_PARAMETER(heap);
+    UNREFERENCED_PARAMETER(flags);
+    free(memory);
+    return TRUE;
+}
+
+// Maps a region with a page in front of it that records its size, and returns the address after
+// that page. The rest of the region is left inaccessible unless it is committed right away.
+static PBYTE INCALESCENT_Posix_MapRegion(SIZE_T size, INT protection) {
+    SIZE_T page = (SIZE_T) sysconf(_SC_PAGESIZE);
+    SIZE_T total = page + ((size + page - 1) & ~(page - 1));
+    PBYTE region = mmap(NULL, total, protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) {
+        INCALESCENT_Posix_Fail();
+        return NULL;
+    }
+    if (protection == PROT_NONE && mprotect(region, page, PROT_READ | PROT_WRITE) != 0) {
+        INCALESCENT_Posix_Fail();
+        munmap(region, total);
+        return NULL;
+    }
+    ((INCALESCENT_Posix_Region *) region)->size = total;
+    return region + page;
+}
+
+// Unmaps a region mapped by INCALESCENT_Posix_MapRegion.
+static BOOL INCALESCENT_Posix_UnmapRegion(LPCVOID address) {
+    SIZE_T page = (SIZE_T) sysconf(_SC_PAGESIZE);
+    PBYTE region = (PBYTE) address - page;
+    if (munmap(region, ((INCALESCENT_Posix_Region *) region)->size) != 0) {
+        return INCALESCENT_Posix_Fail();
+    }
+    return TRUE;
+}
+
+// Implementation for VirtualAlloc
+LPVOID VirtualAlloc(LPVOID address, SIZE_T size, DWORD allocationType, DWORD protection) {
+    INT access = protection == PAGE_READONLY ? PROT_READ : PROT_READ | PROT_WRITE;
+
+    if (allocationType & MEM_RESERVE) {
+        if (address != NULL) {
+            return INCALESCENT_Posix_FailWith(ERROR_INVALID_PARAMETER);
+        }
+        return INCALESCENT_Posix_MapRegion(size, (allocationType & MEM_COMMIT) ? access : PROT_NONE);
+    }
+
+    // Committing part of a reservation only makes it accessible. The pages themselves are only
+    // backed once they are touched, as on Windows.
+    SIZE_T page = (SIZE_T) sysconf(_SC_PAGESIZE);
+    PBYTE start = (PBYTE) ((ULONG_PTR) address & ~(page - 1));
+    PBYTE end = (PBYTE) (((ULONG_PTR) address + size + page - 1) & ~(page - 1));
+    if (mprotect(start, end - start, access) != 0) {
+        INCALESCENT_Posix_Fail();
+        return NULL;
+    }
+    return address;
+}
+
+// Implementation for VirtualFree
+BOOL VirtualFree(LPVOID address, SIZE_T size, DWORD freeType) {
+    if (freeType & MEM_RELEASE) {
+        return INCALESCENT_Posix_UnmapRegion(address);
+    }
+
+    SIZE_T page = (SIZE_T) sysconf(_SC_PAGESIZE);
+    PBYTE start = (PBYTE) ((ULONG_PTR) address & ~(page - 1));
+    PBYTE end = (PBYTE) (((ULONG_PTR) address + size + page - 1) & ~(page - 1));
+    if (madvise(start, end - start, MADV_DONTNEED) != 0 || mprotect(start, end - start, PROT_NONE) != 0) {
+        return INCALESCENT_Posix_Fail();
+    }
+    return TRUE;
+}
+
+// Implementation for PrefetchVirtualMemory
+BOOL PrefetchVirtualMemory(HANDLE process, ULONG_PTR count, WIN32_MEMORY_RANGE_ENTRY *ranges, ULONG flags) {
+    UNREFERENCED_PARAMETER(process);
+    UNREFERENCED_PARAMETER(flags);
+
+    SIZE_T page = (SIZE_T) sysconf(_SC_PAGESIZE);
+    for (ULONG_PTR index = 0; index < count; index++) {
+        PBYTE start = (PBYTE) ((ULONG_PTR) ranges[index].VirtualAddress & ~(page - 1));
+        PBYTE end = (PBYTE) ranges[index].VirtualAddress + ranges[index].NumberOfBytes;
+        madvise(start, end - start, MADV_WILLNEED);
+    }
+    return TRUE;
+}
+
+// Implementation for GlobalMemoryStatusEx
+BOOL GlobalMemoryStatusEx(LPMEMORYSTATUSEX status) {
+    ULONGLONG page = (ULONGLONG) sysconf(_SC_PAGESIZE);
+    LONG physical = (LONG) sysconf(_SC_PHYS_PAGES);
+    LONG available = (LONG) sysconf(_SC_AVPHYS_PAGES);
+    if (physical <= 0 || available < 0) {
+        return INCALESCENT_Posix_Fail();
+    }
+    status->ullTotalPhys = (ULONGLONG) physical * page;
+    status->ullAvailPhys = (ULONGLONG) available * page;
+    status->dwMemoryLoad = (DWORD) (100 - ((status->ullAvailPhys * 100) / status->ullTotalPhys));
+    status->ullTotalPageFile = status->ullTotalPhys;
+    status->ullAvailPageFile = status->ullAvailPhys;
+    status->ullAvailExtendedVirtual = 0;
+
+    // The address space is what a ulimit -v allows, or the 128 TiB of user space without one. The
+    // first number in statm is how much of it the process already takes, in pages.
+    struct rlimit limit;
+    status->ullTotalVirtual = 128ULL * 1024 * 1024 * 1024 * 1024;
+    if (getrlimit(RLIMIT_AS, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < status->ullTotalVirtual) {
+        status->ullTotalVirtual = limit.rlim_cur;
+    }
+    ULONGLONG used = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm != NULL) {
+        if (fscanf(statm, "%llu", &used) != 1) {
+            used = 0;
+        }
+        fclose(statm);
+    }
+    used *= page;
+    status->ullAvailVirtual = used < status->ullTotalVirtual ? status->ullTotalVirtual - used : 0;
+    return TRUE;
+}
+
+// Implementation for CreateFileW
+HANDLE CreateFileW(LPCWSTR path, DWORD access, DWORD shareMode, LPVOID security, DWORD disposition, DWORD flags, HANDLE templateFile) {
+    UNREFERENCED_PARAMETER(shareMode);
+    UNREFERENCED_PARAMETER(security);
+    UNREFERENCED_PARAMETER(templateFile);
+
+    CHAR converted[INCALESCENT_POSIX_PATH_SIZE];
+    if (!INCALESCENT_Posix_Path(path, converted)) {
+        return INVALID_HANDLE_VALUE;
+    }
+
+    INT openFlags = O_CLOEXEC;
+    if ((access & GENERIC_READ) && (access & GENERIC_WRITE)) {
+        openFlags |= O_RDWR;
+    } else if (access & GENERIC_WRITE) {
+        openFlags |= O_WRONLY;
+    } else {
+        openFlags |= O_RDONLY;
+    }
+    switch (disposition) {
+        case CREATE_NEW:
+            openFlags |= O_CREAT | O_EXCL;
+            break;
+        case CREATE_ALWAYS:
+            openFlags |= O_CREAT | O_TRUNC;
+            break;
+        case OPEN_ALWAYS:
+            openFlags |= O_CREAT;
+            break;
+        case TRUNCATE_EXISTING:
+            openFlags |= O_TRUNC;
+            break;
+        default:
+            break;
+    }
+
+    INCALESCENT_Posix_Object *object = INCALESCENT_Posix_CreateObject(INCALESCENT_POSIX_KIND_FILE);
+    if (object == NULL) {
+        return INVALID_HANDLE_VALUE;
+    }
+    object->descriptor = open(converted, openFlags, 0666);
+    if (object->descriptor < 0) {
+        INCALESCENT_Posix_Fail();
+        if (errno == EEXIST) {
+            INCALESCENT_Posix_LastError = ERROR_FILE_EXISTS;
+        }
+        free(object);
+        return INVALID_HANDLE_VALUE;
+    }
+
+    // A file is deleted on close by deleting it right away, since the open descriptor keeps it.
+    if (flags & FILE_FLAG_DELETE_ON_CLOSE) {
+        unlink(converted);
+    }
+    if (flags & FILE_FLAG_SEQUENTIAL_SCAN) {
+        posix_fadvise(object->descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    // Opening a file without buffering purges it from the file cache on Windows, which the
+    // benchmarks rely on to read it cold.
+    if (flags & FILE_FLAG_NO_BUFFERING) {
+        fdatasync(object->descriptor);
+        posix_fadvise(object->descriptor, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    return object;
+}
+
+// Implementation for ReadFile
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD size, LPDWORD readCount, LPOVERLAPPED overlapped) {
+    INCALESCENT_Posix_Object *object = file;
+    ULONGLONG offset = overlapped == NULL ? 0 : ((ULONGLONG) overlapped->OffsetHigh << 32) | overlapped->Offset;
+    DWORD total = 0;
+
+    // Keep reading until the buffer is full or the file ends, so a short read means the end.
+    while (total < size) {
+        ssize_t count = overlapped == NULL ? read(object->descriptor, (PBYTE) buffer + total, size - total)
+                                           : pread(object->descriptor, (PBYTE) buffer + total, size - total, (off_t) (offset + total));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return INCALESCENT_Posix_Fail();
+        }
+        if (count == 0) {
+            break;
+        }
+        total += (DWORD) count;
+        if (!object->standard && overlapped == NULL) {
+            continue;
+        }
+
+        // A pipe or terminal hands over what it has, like on Windows.
+        break;
+    }
+
+    if (readCount != NULL) {
+        *readCount = total;
+    }
+    if (overlapped != NULL) {
+        overlapped->Internal = 0;
+        overlapped->InternalHigh = total;
+
+        // A positioned read that starts at or past the end of the file fails.
+        if (total == 0 && size != 0) {
+            INCALESCENT_Posix_LastError = ERROR_HANDLE_EOF;
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Implementation for WriteFile
+BOOL WriteFile(HANDLE file, LPCVOID buffer, DWORD size, LPDWORD writeCount, LPOVERLAPPED overlapped) {
+    INCALESCENT_Posix_Object *object = file;
+    ULONGLONG offset = overlapped == NULL ? 0 : ((ULONGLONG) overlapped->OffsetHigh << 32) | overlapped->Offset;
+    DWORD total = 0;
+    BOOL succeeded = TRUE;
+
+    while (total < size) {
+        ssize_t count = overlapped == NULL ? write(object->descriptor, (const BYTE *) buffer + total, size - total)
+                                           : pwrite(object->descriptor, (const BYTE *) buffer + total, size - total, (off_t) (offset + total));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            succeeded = INCALESCENT_Posix_Fail();
+            break;
+        }
+        total += (DWORD) count;
+    }
+
+    if (writeCount != NULL) {
+        *writeCount = total;
+    }
+    if (overlapped != NULL) {
+        overlapped->Internal = 0;
+        overlapped->InternalHigh = total;
+    }
+    return succeeded;
+}
+
+// Implementation for FlushFileBuffers
+BOOL FlushFileBuffers(HANDLE file) {
+    if (fsync(((INCALESCENT_Posix_Object *) file)->descriptor) != 0) {
+        return INCALESCENT_Posix_Fail();
+    }
+    return TRUE;
+}
+
+// Implementation for GetFileSizeEx
+BOOL GetFileSizeEx(HANDLE file, PLARGE_INTEGER size) {
+    struct stat information;
+    if (fstat(((INCALESCENT_Posix_Object *) file)->descriptor, &information) != 0) {
+        return INCALESCENT_Posix_Fail();
+    }
+    size->QuadPart = information.st_size;
+    return TRUE;
+}
+
+// Implementation for GetFileType
+DWORD GetFileType(HANDLE file) {
+    struct stat information;
+    INT descriptor = ((INCALESCENT_Posix_Object *) file)->descriptor;
+    if (isatty(descriptor)) {
+        return FILE_TYPE_CHAR;
+    }
+    if (fstat(descriptor, &information) != 0) {
+        INCALESCENT_Posix_Fail();
+        return FILE_TYPE_UNKNOWN;
+    }
+    if (S_ISFIFO(information.st_mode) || S_ISSOCK(information.st_mode)) {
+        return FILE_TYPE_PIPE;
+    }
+    return S_ISCHR(information.st_mode) ? FILE_TYPE_CHAR : FILE_TYPE_DISK;
+}
+
+// Implementation for CloseHandle
+BOOL CloseHandle(HANDLE handle) {
+    INCALESCENT_Posix_Object *object = handle;
+    if (object == NULL || object == INVALID_HANDLE_VALUE || object->standard) {
+        return object != NULL && object != INVALID_HANDLE_VALUE;
+    }
+
+    BOOL succeeded = TRUE;
+    if (object->kind == INCALESCENT_POSIX_KIND_THREAD) {
+        if (!object->joined) {
+            pthread_detach(object->thread);
+        }
+    } else if (object->descriptor >= 0 && close(object->descriptor) != 0) {
+        succeeded = INCALESCENT_Posix_Fail();
+    }
+    free(object);
+    return succeeded;
+}
+
+// Implementation for DeleteFileW
+BOOL DeleteFileW(LPCWSTR path) {
+    CHAR converted[INCALESCENT_POSIX_PATH_SIZE];
+    if (!INCALESCENT_Posix_Path(path, converted)) {
+        return FALSE;
+    }
+    if (unlink(converted) != 0) {
+        return INCALESCENT_Posix_Fail();
+    }
+    return TRUE;
+}
+
+// Implementation for MoveFileExW
+BOOL MoveFileExW(LPCWSTR existing, LPCWSTR path, DWORD flags) {
+    CHAR convertedExisting[INCALESCENT_POSIX_PATH_SIZE];
+    CHAR converted[INCALESCENT_POSIX_PATH_SIZE];
+    if (!INCALESCENT_Posix_Path(existing, convertedExisting) || !INCALESCENT_Posix_Path(path, converted)) {
+        return FALSE;
+    }
+
+    // Without MOVEFILE_REPLACE_EXISTING an existing file is kept. rename can't be told so, and
+    // linking first leaves both names behind if the process dies in between, which is tolerable.
+    if (!(flags & MOVEFILE_REPLACE_EXISTING)) {
+        if (link(convertedExisting, converted) != 0) {
+            return INCALESCENT_Posix_Fail();
+        }
+        unlink(convertedExisting);
+        return TRUE;
+    }
+    if (rename(convertedExisting, converted) != 0) {
+        return INCALESCENT_Posix_Fail();
+    }
+
+    // Writing through means the new name is on disk once the call returns.
+    if (flags & MOVEFILE_WRITE_THROUGH) {
+        PSTR separator = strrchr(converted, '/');
+        INT directory = separator == NULL ? open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+                                          : (*separator = '\0', open(separator == converted ? "/" : converted, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        if (directory >= 0) {
+            fsync(directory);
+            close(directory);
+        }
+    }
+    return TRUE;
+}
+
+// Implementation for CreateDirectoryW
+BOOL CreateDirectoryW(LPCWSTR path, LPVOID security) {
+    UNREFERENCED_PARAMETER(security);
+
+    CHAR converted[INCALESCENT_POSIX_PATH_SIZE];
+    if (!INCALESCENT_Posix_Path(path, converted)) {
+        return FALSE;
+    }
+    if (mkdir(converted, 0777) != 0) {
+        INCALESCENT_Posix_Fail();
+        if (errno == EEXIST) {
+            INCALESCENT_Posix_LastError = ERROR_ALREADY_EXISTS;
+        } else if (errno == ENOENT) {
+            INCALESCENT_Posix_LastError = ERROR_PATH_NOT_FOUND;
+        }
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// The attributes of a file given its status, where link tells whether the name itself is a
+// symbolic link and the status is that of its target.
+static DWORD INCALESCENT_Posix_Attributes(const struct stat *information, BOOL link) {
+    DWORD attributes = S_ISDIR(information->st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+    if (link) {
+        attributes |= FILE_ATTRIBUTE_REPARSE_POINT;
+        attributes &= ~FILE_ATTRIBUTE_NORMAL;
+    }
+    if (!(information->st_mode & (S_IWUSR | S_IWGRP | S_IWOTH))) {
+        attributes |= FILE_ATTRIBUTE_READONLY;
+        attributes &= ~FILE_ATTRIBUTE_NORMAL;
+    }
+    return attributes;
+}
+
+// Implementation for GetFileAttributesW
+DWORD GetFileAttributesW(LPCWSTR path) {
+    CHAR converted[INCALESCENT_POSIX_PATH_SIZE];
+    struct stat information;
+    if (!INCALESCENT_Posix_Path(path, converted)) {
+        return INVALID_FILE_ATTRIBUTES;
+    }
+    if (stat(converted, &information) != 0) {
+        INCALESCENT_Posix_Fail();
+        return INVALID_FILE_ATTRIBUTES;
+    }
+    return INCALESCENT_Posix_Attributes(&information, FALSE);
+}
+
+// Implementation for GetTempPathW
+DWORD GetTempPathW(DWORD size, LPWSTR buffer) {
+    PCSTR directory = getenv("TMPDIR");
+    if (directory == NULL || directory[0] == '\0') {
+        directory = "/tmp";
+    }
+
+    // The path always ends in a separator.
+    INT length = MultiByteToWideChar(CP_UTF8, 0, directory, -1, NULL, 0);
+    if (length == 0) {
+        return 0;
+    }
+    if ((DWORD) length + 1 > size) {
+        return (DWORD) length + 1;
+    }
+    MultiByteToWideChar(CP_UTF8, 0, directory, -1, buffer, (INT) size);
+    if (length >= 2 && buffer[length - 2] == L'/') {
+        return (DWORD) length - 1;
+    }
+    buffer[length - 1] = L'/';
+    buffer[length] = L'\0';
+    return (DWORD) length;
+}
+
+// Implementation for GetTempFileNameW
+UINT GetTempFileNameW(LPCWSTR directory, LPCWSTR prefix, UINT unique, LPWSTR path) {
+    static volatile LONG counter = 0;
+    INT directoryLength = lstrlenW(directory);
+    INT prefixLength = lstrlenW(prefix) < 3 ? lstrlenW(prefix) : 3;
+    if (directoryLength + prefixLength + 10 > MAX_PATH) {
+        INCALESCENT_Posix_LastError = ERROR_BUFFER_OVERFLOW;
+        return 0;
+    }
+
+    // Without a number of its own, try numbers until one names a file that can be created.
+    UINT start = unique != 0 ? unique : (UINT) ((getpid() << 8) ^ InterlockedIncrement(&counter));
+    for (UINT attempt = 0; attempt < 0x10000; attempt++) {
+        UINT number = (start + attempt) & 0xFFFF;
+        if (number == 0) {
+            continue;
+        }
+
+        LPWSTR end = path;
+        CopyMemory(end, directory, sizeof(WCHAR) * directoryLength);
+        end += directoryLength;
+        if (directoryLength != 0 && end[-1] != L'/' && end[-1] != L'\\') {
+            *end++ = L'/';
+        }
+        CopyMemory(end, prefix, sizeof(WCHAR) * prefixLength);
+        end += prefixLength;
+        for (INT digit = 3; digit >= 0; digit--) {
+            *end++ = L"0123456789ABCDEF"[(number >> (digit * 4)) & 0xF];
+        }
+        CopyMemory(end, L".tmp", sizeof(WCHAR) * 5);
+        if (unique != 0) {
+            return unique;
+        }
+
+        HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+            return number;
+        }
+        if (INCALESCENT_Posix_LastError != ERROR_FILE_EXISTS) {
+            return 0;
+        }
+    }
+    INCALESCENT_Posix_LastError = ERROR_FILE_EXISTS;
+    return 0;
+}
+
+// An entry as getdents64 returns it, which the C library doesn't declare.
+typedef struct INCALESCENT_Posix_DirectoryEntry {
+    ULONGLONG inode;
+    LONGLONG offset;
+    WORD length;
+    BYTE type;
+    CHAR name[];
+} INCALESCENT_Posix_DirectoryEntry;
+
+// Whether a name ends in the ASCII suffix of a search, ignoring case. The bytes of an ASCII
+// character never show up inside another character in UTF-8, so this matches exactly the names that
+// end in the suffix once they are converted.
+static BOOL INCALESCENT_Posix_EndsInSuffix(const INCALESCENT_Posix_Object *find, PCSTR name, SIZE_T nameLength) {
+    if (nameLength < (SIZE_T) find->suffixLength) {
+        return FALSE;
+    }
+    PCSTR end = name + (nameLength - find->suffixLength);
+    for (INT index = 0; index < find->suffixLength; index++) {
+        CHAR character = end[index] >= 'a' && end[index] <= 'z' ? (CHAR) (end[index] - 'a' + 'A') : end[index];
+        if (character != find->asciiSuffix[index]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Fills in the data of the next entry of a search that matches its suffix, skipping . and ..
+// The entries are read straight from the directory a buffer at a time, and a name that doesn't end
+// in an ASCII suffix is skipped before it is even converted. A search for names only takes the
+// type of an entry from the directory as well, and only looks up its status when the type is
+// unknown or a symbolic link, whose target may be a directory.
+static BOOL INCALESCENT_Posix_FindNext(INCALESCENT_Posix_Object *find, WIN32_FIND_DATAW *data) {
+    for (;;) {
+        if (find->entriesOffset == find->entriesSize) {
+            LONG64 size = syscall(SYS_getdents64, find->descriptor, find->entries, INCALESCENT_POSIX_FIND_BUFFER_SIZE);
+            if (size <= 0) {
+                INCALESCENT_Posix_LastError = size == 0 ? ERROR_NO_MORE_FILES : INCALESCENT_Posix_Error(errno);
+                return FALSE;
+            }
+            find->entriesSize = (SIZE_T) size;
+            find->entriesOffset = 0;
+        }
+        const INCALESCENT_Posix_DirectoryEntry *entry = (const INCALESCENT_Posix_DirectoryEntry *) (find->entries + find->entriesOffset);
+        find->entriesOffset += entry->length;
+        if (entry->name[0] == '.' && (entry->name[1] == '\0' || (entry->name[1] == '.' && entry->name[2] == '\0'))) {
+            continue;
+        }
+
+        SIZE_T entryLength = strlen(entry->name);
+        if (find->ascii && !INCALESCENT_Posix_EndsInSuffix(find, entry->name, entryLength)) {
+            continue;
+        }
+        INT nameLength = MultiByteToWideChar(CP_UTF8, 0, entry->name, (INT) entryLength + 1, data->cFileName, MAX_PATH);
+        if (nameLength == 0) {
+            continue;
+        }
+        nameLength--;
+        if (!find->ascii && (nameLength < find->suffixLength ||
+                             CompareStringOrdinal(data->cFileName + (nameLength - find->suffixLength), find->suffixLength, find->suffix,
+                                                  find->suffixLength, TRUE) != CSTR_EQUAL)) {
+            continue;
+        }
+
+        ZeroMemory(data, offsetof(WIN32_FIND_DATAW, cFileName));
+        data->cAlternateFileName[0] = L'\0';
+        if (find->namesOnly && (entry->type == DT_REG || entry->type == DT_DIR)) {
+            data->dwFileAttributes = entry->type == DT_DIR ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+            return TRUE;
+        }
+
+        // The status of a symbolic link is that of its target, but it is marked as a reparse point.
+        if (find->pathLength + 1 + entryLength >= INCALESCENT_POSIX_PATH_SIZE) {
+            continue;
+        }
+        CopyMemory(find->path + find->pathLength + 1, entry->name, entryLength + 1);
+        struct stat information;
+        if (lstat(find->path, &information) != 0) {
+            continue;
+        }
+        BOOL link = S_ISLNK(information.st_mode);
+        if (link && stat(find->path, &information) != 0) {
+            continue;
+        }
+
+        data->dwFileAttributes = INCALESCENT_Posix_Attributes(&information, link);
+        INCALESCENT_Posix_FileTime(&information.st_mtim, &data->ftLastWriteTime);
+        INCALESCENT_Posix_FileTime(&information.st_atim, &data->ftLastAccessTime);
+        INCALESCENT_Posix_FileTime(&information.st_ctim, &data->ftCreationTime);
+        data->nFileSizeHigh = (DWORD) ((ULONGLONG) information.st_size >> 32);
+        data->nFileSizeLow = (DWORD) information.st_size;
+        return TRUE;
+    }
+}
+
+// Implementation for FindFirstFileExW
+HANDLE FindFirstFileExW(LPCWSTR pattern, FINDEX_INFO_LEVELS level, LPVOID data, FINDEX_SEARCH_OPS search, LPVOID filter, DWORD flags) {
+    UNREFERENCED_PARAMETER(level);
+    UNREFERENCED_PARAMETER(search);
+    UNREFERENCED_PARAMETER(filter);
+
+    // Only patterns of the form directory\* and directory\*suffix are supported.
+    INT patternLength = lstrlenW(pattern);
+    INT separator = patternLength - 1;
+    while (separator >= 0 && pattern[separator] != L'\\' && pattern[separator] != L'/') {
+        separator--;
+    }
+    if (separator < 0 || pattern[separator + 1] != L'*' || patternLength - separator - 2 >= MAX_PATH) {
+        return INCALESCENT_Posix_FailWith(ERROR_INVALID_PARAMETER), INVALID_HANDLE_VALUE;
+    }
+
+    INCALESCENT_Posix_Object *find = INCALESCENT_Posix_CreateObject(INCALESCENT_POSIX_KIND_FIND);
+    if (find == NULL) {
+        return INVALID_HANDLE_VALUE;
+    }
+    find->suffixLength = patternLength - separator - 2;
+    CopyMemory(find->suffix, pattern + separator + 2, sizeof(WCHAR) * find->suffixLength);
+    find->ascii = TRUE;
+    for (INT index = 0; index < find->suffixLength; index++) {
+        WCHAR character = find->suffix[index];
+        find->ascii = find->ascii && character < 0x80;
+        find->asciiSuffix[index] = (CHAR) (character >= L'a' && character <= L'z' ? character - L'a' + L'A' : character);
+    }
+    find->namesOnly = (flags & FIND_FIRST_EX_NAMES_ONLY) != 0;
+
+    WCHAR directory[INCALESCENT_POSIX_PATH_SIZE];
+    if (separator + 2 > INCALESCENT_POSIX_PATH_SIZE) {
+        free(find);
+        return INCALESCENT_Posix_FailWith(ERROR_FILENAME_EXCED_RANGE), INVALID_HANDLE_VALUE;
+    }
+    CopyMemory(directory, pattern, sizeof(WCHAR) * (separator + 1));
+    directory[separator == 0 ? 1 : separator] = L'\0';
+    if (!INCALESCENT_Posix_Path(directory, find->path)) {
+        free(find);
+        return INVALID_HANDLE_VALUE;
+    }
+    find->pathLength = strlen(find->path);
+    find->path[find->pathLength] = '/';
+
+    find->entries = malloc(INCALESCENT_POSIX_FIND_BUFFER_SIZE);
+    if (find->entries == NULL) {
+        free(find);
+        return INCALESCENT_Posix_FailWith(ERROR_NOT_ENOUGH_MEMORY), INVALID_HANDLE_VALUE;
+    }
+    find->descriptor = open(find->path[0] == '\0' ? "/" : (find->path[find->pathLength] = '\0', find->path), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    find->path[find->pathLength] = '/';
+    if (find->descriptor == -1) {
+        INCALESCENT_Posix_Fail();
+        if (errno == ENOENT) {
+            INCALESCENT_Posix_LastError = ERROR_PATH_NOT_FOUND;
+        }
+        free(find->entries);
+        free(find);
+        return INVALID_HANDLE_VALUE;
+    }
+
+    // Windows reports a search without any match as a missing file.
+    if (!INCALESCENT_Posix_FindNext(find, data)) {
+        DWORD error = INCALESCENT_Posix_LastError;
+        close(find->descriptor);
+        free(find->entries);
+        free(find);
+        INCALESCENT_Posix_LastError = error == ERROR_NO_MORE_FILES ? ERROR_FILE_NOT_FOUND : error;
+        return INVALID_HANDLE_VALUE;
+    }
+    return find;
+}
+
+// Implementation for FindNextFileW
+BOOL FindNextFileW(HANDLE find, WIN32_FIND_DATAW *data) {
+    return INCALESCENT_Posix_FindNext(find, data);
+}
+
+// Implementation for FindClose
+BOOL FindClose(HANDLE find) {
+    INCALESCENT_Posix_Object *object = find;
+    close(object->descriptor);
+    free(object->entries);
+    free(object);
+    return TRUE;
+}
+
+// Implementation for CreateFileMappingW
+HANDLE CreateFileMappingW(HANDLE file, LPVOID security, DWORD protection, DWORD sizeHigh, DWORD sizeLow, LPCWSTR name) {
+    UNREFERENCED_PARAMETER(security);
+    UNREFERENCED_PARAMETER(protection);
+    UNREFERENCED_PARAMETER(name);
+
+    // Only read-only mappings of a whole file are supported, and an empty file can't be mapped.
+    LARGE_INTEGER size;
+    if (sizeHigh != 0 || sizeLow != 0 || !GetFileSizeEx(file, &size)) {
+        return sizeHigh != 0 || sizeLow != 0 ? INCALESCENT_Posix_FailWith(ERROR_NOT_SUPPORTED) : NULL;
+    }
+    if (size.QuadPart == 0) {
+        return INCALESCENT_Posix_FailWith(ERROR_FILE_INVALID);
+    }
+
+    INCALESCENT_Posix_Object *mapping = INCALESCENT_Posix_CreateObject(INCALESCENT_POSIX_KIND_MAPPING);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    mapping->descriptor = dup(((INCALESCENT_Posix_Object *) file)->descriptor);
+    if (mapping->descriptor < 0) {
+        INCALESCENT_Posix_Fail();
+        free(mapping);
+        return NULL;
+    }
+    mapping->size = (SIZE_T) size.QuadPart;
+    return mapping;
+}
+
+// Implementation for MapViewOfFile
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size) {
+    UNREFERENCED_PARAMETER(access);
+    INCALESCENT_Posix_Object *object = mapping;
+    if (offsetHigh != 0 || offsetLow != 0 || (size != 0 && size != object->size)) {
+        return INCALESCENT_Posix_FailWith(ERROR_NOT_SUPPORTED);
+    }
+
+    // The file is mapped over the reserved region, behind the page that records its size.
+    PBYTE view = INCALESCENT_Posix_MapRegion(object->size, PROT_NONE);
+    if (view == NULL) {
+        return NULL;
+    }
+    if (mmap(view, object->size, PROT_READ, MAP_SHARED | MAP_FIXED, object->descriptor, 0) == MAP_FAILED) {
+        INCALESCENT_Posix_Fail();
+        INCALESCENT_Posix_UnmapRegion(view);
+        return NULL;
+    }
+    return view;
+}
+
+// Implementation for UnmapViewOfFile
+BOOL UnmapViewOfFile(LPCVOID view) {
+    return INCALESCENT_Posix_UnmapRegion(view);
+}
+
+// Implementation for DosDateTimeToFileTime
+BOOL DosDateTimeToFileTime(WORD date, WORD time, LPFILETIME fileTime) {
+    LONGLONG year = 1980 + (date >> 9);
+    LONGLONG month = (date >> 5) & 0xF;
+    LONGLONG day = date & 0x1F;
+    if (month < 1 || month > 12 || day < 1 || (time >> 11) > 23 || ((time >> 5) & 0x3F) > 59 || (time & 0x1F) > 29) {
+        INCALESCENT_Posix_LastError = ERROR_INVALID_PARAMETER;
+        return FALSE;
+    }
+
+    // Count the days since 1970 in the proleptic Gregorian calendar, with years starting in March.
+    year -= month <= 2;
+    LONGLONG era = year / 400;
+    LONGLONG yearOfEra = year - (era * 400);
+    LONGLONG dayOfYear = ((153 * (month + (month > 2 ? -3 : 9))) + 2) / 5 + day - 1;
+    LONGLONG dayOfEra = (yearOfEra * 365) + (yearOfEra / 4) - (yearOfEra / 100) + dayOfYear;
+    LONGLONG days = (era * 146097) + dayOfEra - 719468;
+
+    struct timespec moment = {
+            .tv_sec = (time_t) ((days * 86400) + ((time >> 11) * 3600) + (((time >> 5) & 0x3F) * 60) + ((time & 0x1F) * 2)),
+            .tv_nsec = 0,
+    };
+    INCALESCENT_Posix_FileTime(&moment, fileTime);
+    return TRUE;
+}
+
+// Implementation for INCALESCENT_Posix_Descriptor
+INT INCALESCENT_Posix_Descriptor(HANDLE handle) {
+    return ((INCALESCENT_Posix_Object *) handle)->descriptor;
+}
+
+// Implementation for GetStdHandle
+HANDLE GetStdHandle(DWORD handle) {
+    switch (handle) {
+        case STD_INPUT_HANDLE:
+            return &INCALESCENT_Posix_StandardInput;
+        case STD_OUTPUT_HANDLE:
+            return &INCALESCENT_Posix_StandardOutput;
+        case STD_ERROR_HANDLE:
+            return &INCALESCENT_Posix_StandardError;
+        default:
+            INCALESCENT_Posix_LastError = ERROR_INVALID_PARAMETER;
+            return INVALID_HANDLE_VALUE;
+    }
+}
+
+// Implementation for WriteConsoleW
+BOOL WriteConsoleW(HANDLE console, const void *buffer, DWORD length, LPDWORD written, LPVOID reserved) {
+    UNREFERENCED_PARAMETER(reserved);
+    CHAR converted[4096];
+    LPCWSTR text = buffer;
+    DWORD remaining = length;
+
+    // A terminal takes UTF-8, converted in pieces that never split a surrogate pair.
+    while (remaining != 0) {
+        DWORD pieceLength = remaining < 1024 ? remaining : 1024;
+        if (pieceLength < remaining && IS_HIGH_SURROGATE(text[pieceLength - 1])) {
+            pieceLength--;
+        }
+        INT convertedLength = WideCharToMultiByte(CP_UTF8, 0, text, (INT) pieceLength, converted, sizeof(converted), NULL, NULL);
+        if (convertedLength == 0 || !WriteFile(console, converted, (DWORD) convertedLength, NULL, NULL)) {
+            return FALSE;
+        }
+        text += pieceLength;
+        remaining -= pieceLength;
+    }
+    if (written != NULL) {
+        *written = length;
+    }
+    return TRUE;
+}
+
+// Jumps out of the innermost guarded block of the thread a SIGBUS was raised on. Outside of any, the
+// signal ends the process like it would have without a handler.
+static void INCALESCENT_Posix_GuardSignal(INT signalNumber) {
+    INCALESCENT_Posix_Guard *guard = INCALESCENT_Posix_Guards;
+    if (guard == NULL) {
+        signal(signalNumber, SIG_DFL);
+        raise(signalNumber);
+        return;
+    }
+    INCALESCENT_Posix_Guards = guard->outer;
+    guard->code = EXCEPTION_IN_PAGE_ERROR;
+    siglongjmp(guard->jump, 1);
+}
+
+// The handler doesn't block SIGBUS while it runs, so jumping out of it leaves the signal mask as it
+// was, and the guarded blocks don't have to save it.
+static void INCALESCENT_Posix_InstallGuard(void) {
+    struct sigaction action = {0};
+    action.sa_handler = INCALESCENT_Posix_GuardSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_NODEFER;
+    sigaction(SIGBUS, &action, NULL);
+}
+
+// Implementation for INCALESCENT_Posix_GuardNext
+BOOL INCALESCENT_Posix_GuardNext(INCALESCENT_Posix_Guard *guard) {
+    if (!guard->done) {
+        guard->done = TRUE;
+        return TRUE;
+    }
+
+    // A block that ran to its end is still the innermost one.
+    if (INCALESCENT_Posix_Guards == guard) {
+        INCALESCENT_Posix_Guards = guard->outer;
+    }
+    return FALSE;
+}
+
+// Implementation for INCALESCENT_Posix_GuardEnter
+BOOL INCALESCENT_Posix_GuardEnter(INCALESCENT_Posix_Guard *guard) {
+    pthread_once(&INCALESCENT_Posix_GuardOnce, INCALESCENT_Posix_InstallGuard);
+    guard->outer = INCALESCENT_Posix_Guards;
+    INCALESCENT_Posix_Guards = guard;
+    return TRUE;
+}
+
+// Implementation for INCALESCENT_Posix_GuardCatch
+BOOL INCALESCENT_Posix_GuardCatch(INCALESCENT_Posix_Guard *guard, INT filter) {
+    if (filter == EXCEPTION_EXECUTE_HANDLER) {
+        return TRUE;
+    }
+
+    // The search goes on to the block around this one, or ends the process without one.
+    INCALESCENT_Posix_Guard *outer = INCALESCENT_Posix_Guards;
+    if (outer == NULL) {
+        signal(SIGBUS, SIG_DFL);
+        raise(SIGBUS);
+        return FALSE;
+    }
+    INCALESCENT_Posix_Guards = outer->outer;
+    outer->code = guard->code;
+    siglongjmp(outer->jump, 1);
+}
+
+// Runs the console control handler on the thread the signal interrupted, so the handler may only do
+// what is safe in a signal handler. Setting an event is, since it writes to an eventfd. A signal the
+// handler doesn't take ends the process like it would have without a handler.
+static void INCALESCENT_Posix_ControlSignal(INT signalNumber) {
+    PHANDLER_ROUTINE handler = INCALESCENT_Posix_ControlHandler;
+    INT savedError = errno;
+    if (handler == NULL || !handler(signalNumber == SIGINT ? CTRL_C_EVENT : CTRL_CLOSE_EVENT)) {
+        signal(signalNumber, SIG_DFL);
+        raise(signalNumber);
+    }
+    errno = savedError;
+}
+
+// Implementation for SetConsoleCtrlHandler
+BOOL SetConsoleCtrlHandler(PHANDLER_ROUTINE handler, BOOL add) {
+    if (handler == NULL || (add ? INCALESCENT_Posix_ControlHandler != NULL : INCALESCENT_Posix_ControlHandler != handler)) {
+        INCALESCENT_Posix_LastError = ERROR_INVALID_PARAMETER;
+        return FALSE;
+    }
+
+    struct sigaction action = {0};
+    action.sa_handler = add ? INCALESCENT_Posix_ControlSignal : SIG_DFL;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    INCALESCENT_Posix_ControlHandler = add ? handler : NULL;
+    if (sigaction(SIGINT, &action, NULL) != 0 || sigaction(SIGTERM, &action, NULL) != 0) {
+        return INCALESCENT_Posix_Fail();
+    }
+    return TRUE;
+}
+
+static PVOID INCALESCENT_Posix_ThreadStart(PVOID parameter) {
+    INCALESCENT_Posix_Object *thread = parameter;
+    return (PVOID) (ULONG_PTR) thread->start(thread->parameter);
+}
+
+// Implementation for CreateThread
+HANDLE CreateThread(LPVOID security, SIZE_T stackSize, LPTHREAD_START_ROUTINE start, LPVOID parameter, DWORD flags, LPDWORD threadId) {
+    UNREFERENCED_PARAMETER(security);
+    UNREFERENCED_PARAMETER(flags);
+
+    INCALESCENT_Posix_Object *thread = INCALESCENT_Posix_CreateObject(INCALESCENT_POSIX_KIND_THREAD);
+    if (thread == NULL) {
+        return NULL;
+    }
+    thread->start = start;
+    thread->parameter = parameter;
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    if (stackSize != 0) {
+        pthread_attr_setstacksize(&attributes, stackSize);
+    }
+    INT error = pthread_create(&thread->thread, &attributes, INCALESCENT_Posix_ThreadStart, thread);
+    pthread_attr_destroy(&attributes);
+    if (error != 0) {
+        INCALESCENT_Posix_LastError = INCALESCENT_Posix_Error(error);
+        free(thread);
+        return NULL;
+    }
+    if (threadId != NULL) {
+        *threadId = 0;
+    }
+    return thread;
+}
+
+// Implementation for GetCurrentProcess
+HANDLE GetCurrentProcess(void) {
+    return (HANDLE) (LONG_PTR) -1;
+}
+
+// Implementation for GetCurrentThread
+HANDLE GetCurrentThread(void) {
+    return (HANDLE) (LONG_PTR) -2;
+}
+
+// Implementation for GetCurrentThreadId
+DWORD GetCurrentThreadId(void) {
+    return (DWORD) syscall(SYS_gettid);
+}
+
+// Implementation for SwitchToThread
+BOOL SwitchToThread(void) {
+    sched_yield();
+    return TRUE;
+}
+
+// Implementation for Sleep
+void Sleep(DWORD milliseconds) {
+    struct timespec duration = {.tv_sec = milliseconds / 1000, .tv_nsec = (long) (milliseconds % 1000) * 1000000};
+    while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+    }
+}
+
+// Implementation for SetPriorityClass
+BOOL SetPriorityClass(HANDLE process, DWORD priorityClass) {
+    UNREFERENCED_PARAMETER(process);
+
+    // Raising the priority takes privileges most users don't have, so not getting it is fine.
+    if (priorityClass == HIGH_PRIORITY_CLASS) {
+        setpriority(PRIO_PROCESS, 0, -10);
+    }
+    return TRUE;
+}
+
+// Implementation for SetThreadPriority
+BOOL SetThreadPriority(HANDLE thread, INT priority) {
+    UNREFERENCED_PARAMETER(thread);
+    UNREFERENCED_PARAMETER(priority);
+    return TRUE;
+}
+
+// Implementation for SetThreadAffinityMask
+DWORD_PTR SetThreadAffinityMask(HANDLE thread, DWORD_PTR mask) {
+    UNREFERENCED_PARAMETER(thread);
+    cpu_set_t previous;
+    cpu_set_t set;
+
+    if (sched_getaffinity(0, sizeof(previous), &previous) != 0) {
+        INCALESCENT_Posix_Fail();
+        return 0;
+    }
+    CPU_ZERO(&set);
+    for (INT processor = 0; processor < 64; processor++) {
+        if (mask & ((DWORD_PTR) 1 << processor)) {
+            CPU_SET(processor, &set);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        INCALESCENT_Posix_Fail();
+        return 0;
+    }
+
+    DWORD_PTR previousMask = 0;
+    for (INT processor = 0; processor < 64; processor++) {
+        if (CPU_ISSET(processor, &previous)) {
+            previousMask |= (DWORD_PTR) 1 << processor;
+        }
+    }
+    return previousMask;
+}
+
+// Implementation for GetActiveProcessorCount
+DWORD GetActiveProcessorCount(WORD group) {
+    UNREFERENCED_PARAMETER(group);
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        return (DWORD) CPU_COUNT(&set);
+    }
+    LONG count = (LONG) sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (DWORD) count : 1;
+}
+
+// Implementation for CreateEventW
+HANDLE CreateEventW(LPVOID security, BOOL manualReset, BOOL initialState, LPCWSTR name) {
+    UNREFERENCED_PARAMETER(security);
+    UNREFERENCED_PARAMETER(name);
+
+    INCALESCENT_Posix_Object *event = INCALESCENT_Posix_CreateObject(INCALESCENT_POSIX_KIND_EVENT);
+    if (event == NULL) {
+        return NULL;
+    }
+    event->manualReset = manualReset;
+    event->descriptor = eventfd(initialState ? 1 : 0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event->descriptor < 0) {
+        INCALESCENT_Posix_Fail();
+        free(event);
+        return NULL;
+    }
+    return event;
+}
+
+// Implementation for SetEvent
+BOOL SetEvent(HANDLE event) {
+    // An event is signaled while its counter isn't zero, however often it was set.
+    ULONGLONG one = 1;
+    if (write(((INCALESCENT_Posix_Object *) event)->descriptor, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        return INCALESCENT_Posix_Fail();
+    }
+    return TRUE;
+}
+
+// Implementation for ResetEvent
+BOOL ResetEvent(HANDLE event) {
+    ULONGLONG count;
+    if (read(((INCALESCENT_Posix_Object *) event)->descriptor, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        return INCALESCENT_Posix_Fail();
+    }
+    return TRUE;
+}
+
+// Takes the signal of a handle that poll reported as signaled. A thread has ended, and a
+// manual-reset event stays signaled, while an auto-reset event is reset by the one waiter that
+// manages to read it. Returns FALSE if another waiter got there first.
+static BOOL INCALESCENT_Posix_Acquire(INCALESCENT_Posix_Object *object) {
+    if (object->kind != INCALESCENT_POSIX_KIND_EVENT || object->manualReset) {
+        return TRUE;
+    }
+    ULONGLONG count;
+    return read(object->descriptor, &count, sizeof(count)) == sizeof(count);
+}
+
+// Implementation for WaitForSingleObject
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds) {
+    INCALESCENT_Posix_Object *object = handle;
+
+    // A thread is only ever waited for until it ends.
+    if (object->kind == INCALESCENT_POSIX_KIND_THREAD) {
+        if (!object->joined) {
+            INT error = pthread_join(object->thread, NULL);
+            if (error != 0) {
+                INCALESCENT_Posix_LastError = INCALESCENT_Posix_Error(error);
+                return WAIT_FAILED;
+            }
+            object->joined = TRUE;
+        }
+        return WAIT_OBJECT_0;
+    }
+    return WaitForMultipleObjects(1, &handle, FALSE, milliseconds);
+}
+
+// Implementation for WaitForMultipleObjects
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE *handles, BOOL waitAll, DWORD milliseconds) {
+    struct pollfd descriptors[64];
+    if (count == 0 || count > ARRAYSIZE(descriptors) || waitAll) {
+        INCALESCENT_Posix_LastError = ERROR_INVALID_PARAMETER;
+        return WAIT_FAILED;
+    }
+    for (DWORD index = 0; index < count; index++) {
+        INCALESCENT_Posix_Object *object = handles[index];
+        if (object == NULL || object == INVALID_HANDLE_VALUE || object->kind != INCALESCENT_POSIX_KIND_EVENT) {
+            INCALESCENT_Posix_LastError = ERROR_INVALID_HANDLE;
+            return WAIT_FAILED;
+        }
+        descriptors[index].fd = object->descriptor;
+        descriptors[index].events = POLLIN;
+    }
+
+    ULONGLONG deadline = INCALESCENT_Posix_Clock(CLOCK_MONOTONIC) + ((ULONGLONG) milliseconds * 1000000ULL);
+    for (;;) {
+        INT timeout = INCALESCENT_Posix_Timeout(milliseconds);
+        if (milliseconds != INFINITE) {
+            ULONGLONG now = INCALESCENT_Posix_Clock(CLOCK_MONOTONIC);
+            timeout = now >= deadline ? 0 : (INT) ((deadline - now + 999999) / 1000000);
+        }
+
+        INT ready = poll(descriptors, count, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            INCALESCENT_Posix_Fail();
+            return WAIT_FAILED;
+        }
+        if (ready == 0) {
+            return WAIT_TIMEOUT;
+        }
+
+        // The lowest signaled handle wins, as on Windows.
+        for (DWORD index = 0; index < count; index++) {
+            if ((descriptors[index].revents & POLLIN) && INCALESCENT_Posix_Acquire(handles[index])) {
+                return WAIT_OBJECT_0 + index;
+            }
+        }
+    }
+}
+
+// Implementation for InitializeSRWLock
+void InitializeSRWLock(SRWLOCK *lock) {
+    _Static_assert(sizeof(SRWLOCK) >= sizeof(pthread_mutex_t), "A lock must hold a mutex.");
+    pthread_mutex_init((pthread_mutex_t *) lock, NULL);
+}
+
+// Implementation for AcquireSRWLockExclusive
+void AcquireSRWLockExclusive(SRWLOCK *lock) {
+    pthread_mutex_lock((pthread_mutex_t *) lock);
+}
+
+// Implementation for ReleaseSRWLockExclusive
+void ReleaseSRWLockExclusive(SRWLOCK *lock) {
+    pthread_mutex_unlock((pthread_mutex_t *) lock);
+}
+
+// Implementation for InitializeConditionVariable
+void InitializeConditionVariable(CONDITION_VARIABLE *condition) {
+    _Static_assert(sizeof(CONDITION_VARIABLE) >= sizeof(pthread_cond_t), "A condition variable must hold a condition.");
+    pthread_cond_init((pthread_cond_t *) condition, NULL);
+}
+
+// Implementation for SleepConditionVariableSRW
+BOOL SleepConditionVariableSRW(CONDITION_VARIABLE *condition, SRWLOCK *lock, DWORD milliseconds, ULONG flags) {
+    UNREFERENCED_PARAMETER(flags);
+    if (milliseconds == INFINITE) {
+        pthread_cond_wait((pthread_cond_t *) condition, (pthread_mutex_t *) lock);
+        return TRUE;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += milliseconds / 1000;
+    deadline.tv_nsec += (long) (milliseconds % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    if (pthread_cond_timedwait((pthread_cond_t *) condition, (pthread_mutex_t *) lock, &deadline) == ETIMEDOUT) {
+        INCALESCENT_Posix_LastError = ERROR_TIMEOUT;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Implementation for WakeConditionVariable
+void WakeConditionVariable(CONDITION_VARIABLE *condition) {
+    pthread_cond_signal((pthread_cond_t *) condition);
+}
+
+// Implementation for WakeAllConditionVariable
+void WakeAllConditionVariable(CONDITION_VARIABLE *condition) {
+    pthread_cond_broadcast((pthread_cond_t *) condition);
+}
+
+// Implementation for QueryPerformanceCounter
+BOOL QueryPerformanceCounter(LARGE_INTEGER *count) {
+    count->QuadPart = (LONGLONG) INCALESCENT_Posix_Clock(CLOCK_MONOTONIC);
+    return TRUE;
+}
+
+// Implementation for QueryPerformanceFrequency
+BOOL QueryPerformanceFrequency(LARGE_INTEGER *frequency) {
+    frequency->QuadPart = 1000000000LL;
+    return TRUE;
+}
+
+// Implementation for GetTickCount64
+ULONGLONG GetTickCount64(void) {
+    return INCALESCENT_Posix_Clock(CLOCK_MONOTONIC) / 1000000ULL;
+}
+
+// Implementation for GetLocalTime
+void GetLocalTime(SYSTEMTIME *time) {
+    struct timespec now;
+    struct tm local;
+    clock_gettime(CLOCK_REALTIME, &now);
+    localtime_r(&now.tv_sec, &local);
+
+    time->wYear = (WORD) (local.tm_year + 1900);
+    time->wMonth = (WORD) (local.tm_mon + 1);
+    time->wDayOfWeek = (WORD) local.tm_wday;
+    time->wDay = (WORD) local.tm_mday;
+    time->wHour = (WORD) local.tm_hour;
+    time->wMinute = (WORD) local.tm_min;
+    time->wSecond = (WORD) local.tm_sec;
+    time->wMilliseconds = (WORD) (now.tv_nsec / 1000000);
+}
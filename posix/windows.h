@@ -0,0 +1,539 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_POSIX_WINDOWS_H
+#define INCALESCENT_POSIX_WINDOWS_H
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <string.h>
+#include "../platform.h"
+
+// The part of the Windows API the consolidation engine and its console front ends use, on top of
+// Linux. Wide strings are UTF-16 like on Windows, which takes -fshort-wchar, so none of the wide
+// functions of the C library can be used. Paths are converted to UTF-8, with backslashes taken as
+// separators. See windows.c for how each function maps onto the system.
+
+#define WINAPI
+#define CALLBACK
+#define FALSE 0
+#define TRUE 1
+#define VOID void
+
+typedef int INT;
+typedef int BOOL;
+typedef unsigned int UINT;
+typedef unsigned int ULONG;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef unsigned short WORD;
+typedef unsigned char BYTE;
+typedef unsigned char UCHAR;
+typedef unsigned char BOOLEAN;
+typedef char CHAR;
+typedef double DOUBLE;
+typedef float FLOAT;
+typedef long long LONGLONG;
+typedef unsigned long long ULONGLONG;
+typedef long long LONG64;
+typedef unsigned long long ULONG64;
+typedef unsigned long long DWORD64;
+typedef unsigned long long SIZE_T;
+typedef long long SSIZE_T;
+typedef unsigned long long ULONG_PTR;
+typedef long long LONG_PTR;
+typedef unsigned long long DWORD_PTR;
+typedef LONG_PTR LPARAM;
+typedef unsigned short WCHAR;
+
+typedef BYTE *PBYTE;
+typedef BYTE *LPBYTE;
+typedef SIZE_T *PSIZE_T;
+typedef WCHAR *PWSTR;
+typedef WCHAR *LPWSTR;
+typedef const WCHAR *PCWSTR;
+typedef const WCHAR *LPCWSTR;
+typedef CHAR *PSTR;
+typedef CHAR *LPSTR;
+typedef CHAR *LPCH;
+typedef const CHAR *PCSTR;
+typedef const CHAR *LPCSTR;
+typedef const CHAR *LPCCH;
+typedef void *PVOID;
+typedef void *LPVOID;
+typedef const void *LPCVOID;
+typedef void *HANDLE;
+typedef HANDLE *PHANDLE;
+typedef DWORD *PDWORD;
+typedef DWORD *LPDWORD;
+typedef LONG *PLONG;
+typedef ULONG *PULONG;
+typedef BOOL *PBOOL;
+
+typedef union LARGE_INTEGER {
+    struct {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+    LONGLONG QuadPart;
+} LARGE_INTEGER, *PLARGE_INTEGER;
+
+typedef union ULARGE_INTEGER {
+    struct {
+        DWORD LowPart;
+        DWORD HighPart;
+    };
+    ULONGLONG QuadPart;
+} ULARGE_INTEGER;
+
+typedef struct FILETIME {
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+} FILETIME, *LPFILETIME;
+
+typedef struct SYSTEMTIME {
+    WORD wYear;
+    WORD wMonth;
+    WORD wDayOfWeek;
+    WORD wDay;
+    WORD wHour;
+    WORD wMinute;
+    WORD wSecond;
+    WORD wMilliseconds;
+} SYSTEMTIME;
+
+#define MAX_PATH 260
+
+typedef struct WIN32_FIND_DATAW {
+    DWORD dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD nFileSizeHigh;
+    DWORD nFileSizeLow;
+    DWORD dwReserved0;
+    DWORD dwReserved1;
+    WCHAR cFileName[MAX_PATH];
+    WCHAR cAlternateFileName[14];
+} WIN32_FIND_DATAW;
+
+typedef enum FINDEX_INFO_LEVELS {
+    FindExInfoStandard,
+    FindExInfoBasic,
+} FINDEX_INFO_LEVELS;
+
+typedef enum FINDEX_SEARCH_OPS {
+    FindExSearchNameMatch,
+} FINDEX_SEARCH_OPS;
+
+// Not a Windows flag. The search only reports the names and whether they are directories, without
+// looking up the size, times and other attributes of every entry, which takes a call of its own.
+#define FIND_FIRST_EX_NAMES_ONLY 0x80000000
+
+// Reads and writes given an OVERLAPPED are positioned, but always finish before they return.
+typedef struct OVERLAPPED {
+    ULONG_PTR Internal;
+    ULONG_PTR InternalHigh;
+    union {
+        struct {
+            DWORD Offset;
+            DWORD OffsetHigh;
+        };
+        PVOID Pointer;
+    };
+    HANDLE hEvent;
+} OVERLAPPED, *LPOVERLAPPED;
+
+typedef struct WIN32_MEMORY_RANGE_ENTRY {
+    PVOID VirtualAddress;
+    SIZE_T NumberOfBytes;
+} WIN32_MEMORY_RANGE_ENTRY;
+
+typedef struct MEMORYSTATUSEX {
+    DWORD dwLength;
+    DWORD dwMemoryLoad;
+    ULONGLONG ullTotalPhys;
+    ULONGLONG ullAvailPhys;
+    ULONGLONG ullTotalPageFile;
+    ULONGLONG ullAvailPageFile;
+    ULONGLONG ullTotalVirtual;
+    ULONGLONG ullAvailVirtual;
+    ULONGLONG ullAvailExtendedVirtual;
+} MEMORYSTATUSEX, *LPMEMORYSTATUSEX;
+
+// A lock is a mutex, so only exclusive acquisition is provided. Both start out zeroed like on
+// Windows, which is how the C library initializes them statically as well.
+typedef struct SRWLOCK {
+    _Alignas(8) BYTE opaque[40];
+} SRWLOCK;
+
+typedef struct CONDITION_VARIABLE {
+    _Alignas(8) BYTE opaque[48];
+} CONDITION_VARIABLE;
+
+#define SRWLOCK_INIT {{0}}
+#define CONDITION_VARIABLE_INIT {{0}}
+
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE)(LPVOID parameter);
+typedef BOOL (WINAPI *PHANDLER_ROUTINE)(DWORD controlType);
+
+#define S_OK ((HRESULT) 0)
+#define S_FALSE ((HRESULT) 1)
+#define E_NOTIMPL ((HRESULT) 0x80004001)
+#define E_ABORT ((HRESULT) 0x80004004)
+#define E_FAIL ((HRESULT) 0x80004005)
+#define E_UNEXPECTED ((HRESULT) 0x8000FFFF)
+#define E_OUTOFMEMORY ((HRESULT) 0x8007000E)
+#define E_INVALIDARG ((HRESULT) 0x80070057)
+#define SUCCEEDED(hr) (((HRESULT) (hr)) >= 0)
+#define FAILED(hr) (((HRESULT) (hr)) < 0)
+#define HRESULT_FROM_WIN32(x) ((HRESULT) (x) <= 0 ? ((HRESULT) (x)) : ((HRESULT) (((x) & 0x0000FFFF) | (7 << 16) | 0x80000000)))
+
+#define ERROR_SUCCESS 0L
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_PATH_NOT_FOUND 3L
+#define ERROR_TOO_MANY_OPEN_FILES 4L
+#define ERROR_ACCESS_DENIED 5L
+#define ERROR_INVALID_HANDLE 6L
+#define ERROR_NOT_ENOUGH_MEMORY 8L
+#define ERROR_BAD_FORMAT 11L
+#define ERROR_INVALID_DATA 13L
+#define ERROR_OUTOFMEMORY 14L
+#define ERROR_NOT_SAME_DEVICE 17L
+#define ERROR_NO_MORE_FILES 18L
+#define ERROR_CRC 23L
+#define ERROR_WRITE_FAULT 29L
+#define ERROR_READ_FAULT 30L
+#define ERROR_GEN_FAILURE 31L
+#define ERROR_SHARING_VIOLATION 32L
+#define ERROR_HANDLE_EOF 38L
+#define ERROR_NOT_SUPPORTED 50L
+#define ERROR_FILE_EXISTS 80L
+#define ERROR_INVALID_PARAMETER 87L
+#define ERROR_BROKEN_PIPE 109L
+#define ERROR_BUFFER_OVERFLOW 111L
+#define ERROR_DISK_FULL 112L
+#define ERROR_INSUFFICIENT_BUFFER 122L
+#define ERROR_DIR_NOT_EMPTY 145L
+#define ERROR_ALREADY_EXISTS 183L
+#define ERROR_FILENAME_EXCED_RANGE 206L
+#define ERROR_DIRECTORY 267L
+#define ERROR_MR_MID_NOT_FOUND 317L
+#define ERROR_OPERATION_ABORTED 995L
+#define ERROR_IO_PENDING 997L
+#define ERROR_NOACCESS 998L
+#define ERROR_NOTIFY_ENUM_DIR 1022L
+#define ERROR_FILE_INVALID 1006L
+#define ERROR_INVALID_FLAGS 1004L
+#define ERROR_IO_DEVICE 1117L
+#define ERROR_NOT_FOUND 1168L
+#define ERROR_NO_UNICODE_TRANSLATION 1113L
+#define ERROR_FILE_CORRUPT 1392L
+#define ERROR_TIMEOUT 1460L
+#define ERROR_NOT_ENOUGH_QUOTA 1816L
+
+#define INFINITE 0xFFFFFFFF
+#define MAXDWORD 0xFFFFFFFF
+#define MAXULONG64 ((ULONG64) ~((ULONG64) 0))
+#define WAIT_OBJECT_0 0x00000000L
+#define WAIT_TIMEOUT 0x00000102L
+#define WAIT_FAILED ((DWORD) 0xFFFFFFFF)
+
+#define INVALID_HANDLE_VALUE ((HANDLE) (LONG_PTR) -1)
+#define INVALID_FILE_ATTRIBUTES ((DWORD) -1)
+
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+#define FILE_LIST_DIRECTORY 0x0001
+#define FILE_SHARE_READ 0x00000001
+#define FILE_SHARE_WRITE 0x00000002
+#define FILE_SHARE_DELETE 0x00000004
+#define CREATE_NEW 1
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+#define OPEN_ALWAYS 4
+#define TRUNCATE_EXISTING 5
+#define FILE_ATTRIBUTE_READONLY 0x00000001
+#define FILE_ATTRIBUTE_DIRECTORY 0x00000010
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define FILE_ATTRIBUTE_TEMPORARY 0x00000100
+#define FILE_ATTRIBUTE_REPARSE_POINT 0x00000400
+#define FILE_FLAG_WRITE_THROUGH 0x80000000
+#define FILE_FLAG_OVERLAPPED 0x40000000
+#define FILE_FLAG_NO_BUFFERING 0x20000000
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000
+#define FILE_FLAG_DELETE_ON_CLOSE 0x04000000
+#define FILE_FLAG_BACKUP_SEMANTICS 0x02000000
+#define FILE_TYPE_UNKNOWN 0x0000
+#define FILE_TYPE_DISK 0x0001
+#define FILE_TYPE_CHAR 0x0002
+#define FILE_TYPE_PIPE 0x0003
+#define FIND_FIRST_EX_LARGE_FETCH 0x00000002
+#define MOVEFILE_REPLACE_EXISTING 0x00000001
+#define MOVEFILE_WRITE_THROUGH 0x00000008
+
+#define MEM_COMMIT 0x00001000
+#define MEM_RESERVE 0x00002000
+#define MEM_DECOMMIT 0x00004000
+#define MEM_RELEASE 0x00008000
+#define PAGE_READONLY 0x02
+#define PAGE_READWRITE 0x04
+#define FILE_MAP_READ 0x0004
+#define HEAP_ZERO_MEMORY 0x00000008
+
+#define STD_INPUT_HANDLE ((DWORD) -10)
+#define STD_OUTPUT_HANDLE ((DWORD) -11)
+#define STD_ERROR_HANDLE ((DWORD) -12)
+
+// SIGINT arrives as CTRL_C_EVENT and SIGTERM as CTRL_CLOSE_EVENT.
+#define CTRL_C_EVENT 0
+#define CTRL_BREAK_EVENT 1
+#define CTRL_CLOSE_EVENT 2
+
+#define CP_UTF8 65001
+#define MB_ERR_INVALID_CHARS 0x00000008
+#define WC_ERR_INVALID_CHARS 0x00000080
+#define IS_HIGH_SURROGATE(wch) (((wch) >= 0xD800) && ((wch) <= 0xDBFF))
+#define IS_LOW_SURROGATE(wch) (((wch) >= 0xDC00) && ((wch) <= 0xDFFF))
+
+#define LOCALE_NAME_USER_DEFAULT NULL
+#define LOCALE_USER_DEFAULT 0x0400
+#define NORM_IGNORECASE 0x00000001
+#define LINGUISTIC_IGNORECASE 0x00000010
+#define SORT_DIGITSASNUMBERS 0x00000008
+#define LCMAP_SORTKEY 0x00000400
+#define CSTR_LESS_THAN 1
+#define CSTR_EQUAL 2
+#define CSTR_GREATER_THAN 3
+
+#define FORMAT_MESSAGE_ALLOCATE_BUFFER 0x00000100
+#define FORMAT_MESSAGE_IGNORE_INSERTS 0x00000200
+#define FORMAT_MESSAGE_FROM_SYSTEM 0x00001000
+
+#define ALL_PROCESSOR_GROUPS 0xFFFF
+#define HIGH_PRIORITY_CLASS 0x00000080
+#define THREAD_PRIORITY_HIGHEST 2
+
+#define ARRAYSIZE(array) (sizeof(array) / sizeof((array)[0]))
+#define UNREFERENCED_PARAMETER(parameter) ((void) (parameter))
+#define DECLSPEC_ALIGN(x) __attribute__((aligned(x)))
+#define SYSTEM_CACHE_ALIGNMENT_SIZE 64
+#define DECLSPEC_CACHEALIGN DECLSPEC_ALIGN(SYSTEM_CACHE_ALIGNMENT_SIZE)
+
+#define ZeroMemory(destination, length) memset((destination), 0, (length))
+#define FillMemory(destination, length, fill) memset((destination), (fill), (length))
+#define CopyMemory(destination, source, length) memcpy((destination), (source), (length))
+#define MoveMemory(destination, source, length) memmove((destination), (source), (length))
+#define RtlEqualMemory(first, second, length) (!memcmp((first), (second), (length)))
+
+// Structured exception handling only covers what reading a mapped file raises. A guarded block runs
+// with a SIGBUS handler that jumps back out of it, which is what touching a page of a mapped file
+// that shrank underneath raises, and the filter sees EXCEPTION_IN_PAGE_ERROR like on Windows. A
+// block may only be left through its end, never with break, goto or return.
+typedef struct INCALESCENT_Posix_Guard {
+    sigjmp_buf jump;
+    struct INCALESCENT_Posix_Guard *outer;
+    volatile DWORD code;
+    BOOL done;
+} INCALESCENT_Posix_Guard;
+
+BOOL INCALESCENT_Posix_GuardNext(INCALESCENT_Posix_Guard *guard);
+BOOL INCALESCENT_Posix_GuardEnter(INCALESCENT_Posix_Guard *guard);
+BOOL INCALESCENT_Posix_GuardCatch(INCALESCENT_Posix_Guard *guard, INT filter);
+
+#define __try for (INCALESCENT_Posix_Guard INCALESCENT_Posix_guard = {.done = FALSE}; INCALESCENT_Posix_GuardNext(&INCALESCENT_Posix_guard);) \
+                  if (sigsetjmp(INCALESCENT_Posix_guard.jump, 0) == 0) \
+                      if (INCALESCENT_Posix_GuardEnter(&INCALESCENT_Posix_guard))
+#define __except(filter) else {} else if (INCALESCENT_Posix_GuardCatch(&INCALESCENT_Posix_guard, (filter)))
+#define GetExceptionCode() (INCALESCENT_Posix_guard.code)
+#define EXCEPTION_IN_PAGE_ERROR 0xC0000006L
+#define EXCEPTION_EXECUTE_HANDLER 1
+#define EXCEPTION_CONTINUE_SEARCH 0
+
+#define MemoryBarrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+// The bit scans, which <winnt.h> declares as well. They take any integer type for the index, so
+// they work with both DWORD and unsigned long.
+#define _BitScanForward(index, mask) \
+    ((mask) != 0 ? (*(index) = (DWORD) __builtin_ctz((unsigned int) (mask)), (BYTE) 1) : (BYTE) 0)
+#define _BitScanForward64(index, mask) \
+    ((mask) != 0 ? (*(index) = (DWORD) __builtin_ctzll((ULONGLONG) (mask)), (BYTE) 1) : (BYTE) 0)
+#define _BitScanReverse(index, mask) \
+    ((mask) != 0 ? (*(index) = (DWORD) (31 - __builtin_clz((unsigned int) (mask))), (BYTE) 1) : (BYTE) 0)
+#define _BitScanReverse64(index, mask) \
+    ((mask) != 0 ? (*(index) = (DWORD) (63 - __builtin_clzll((ULONGLONG) (mask))), (BYTE) 1) : (BYTE) 0)
+
+// Errors
+DWORD GetLastError(void);
+void SetLastError(DWORD error);
+DWORD FormatMessageW(DWORD flags, LPCVOID source, DWORD messageId, DWORD languageId, LPWSTR buffer, DWORD size, va_list *arguments);
+PVOID LocalFree(PVOID memory);
+
+// Memory
+HANDLE GetProcessHeap(void);
+LPVOID HeapAlloc(HANDLE heap, DWORD flags, SIZE_T size);
+BOOL HeapFree(HANDLE heap, DWORD flags, LPVOID memory);
+LPVOID VirtualAlloc(LPVOID address, SIZE_T size, DWORD allocationType, DWORD protection);
+BOOL VirtualFree(LPVOID address, SIZE_T size, DWORD freeType);
+BOOL PrefetchVirtualMemory(HANDLE process, ULONG_PTR count, WIN32_MEMORY_RANGE_ENTRY *ranges, ULONG flags);
+BOOL GlobalMemoryStatusEx(LPMEMORYSTATUSEX status);
+
+// Files
+HANDLE CreateFileW(LPCWSTR path, DWORD access, DWORD shareMode, LPVOID security, DWORD disposition, DWORD flags, HANDLE templateFile);
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD size, LPDWORD readCount, LPOVERLAPPED overlapped);
+BOOL WriteFile(HANDLE file, LPCVOID buffer, DWORD size, LPDWORD writeCount, LPOVERLAPPED overlapped);
+BOOL FlushFileBuffers(HANDLE file);
+BOOL GetFileSizeEx(HANDLE file, PLARGE_INTEGER size);
+DWORD GetFileType(HANDLE file);
+BOOL CloseHandle(HANDLE handle);
+BOOL DeleteFileW(LPCWSTR path);
+BOOL MoveFileExW(LPCWSTR existing, LPCWSTR path, DWORD flags);
+BOOL CreateDirectoryW(LPCWSTR path, LPVOID security);
+DWORD GetFileAttributesW(LPCWSTR path);
+DWORD GetTempPathW(DWORD size, LPWSTR buffer);
+UINT GetTempFileNameW(LPCWSTR directory, LPCWSTR prefix, UINT unique, LPWSTR path);
+HANDLE FindFirstFileExW(LPCWSTR pattern, FINDEX_INFO_LEVELS level, LPVOID data, FINDEX_SEARCH_OPS search, LPVOID filter, DWORD flags);
+BOOL FindNextFileW(HANDLE find, WIN32_FIND_DATAW *data);
+BOOL FindClose(HANDLE find);
+HANDLE CreateFileMappingW(HANDLE file, LPVOID security, DWORD protection, DWORD sizeHigh, DWORD sizeLow, LPCWSTR name);
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size);
+BOOL UnmapViewOfFile(LPCVOID view);
+BOOL DosDateTimeToFileTime(WORD date, WORD time, LPFILETIME fileTime);
+
+// The file descriptor behind a file or event, for waiting on it together with others.
+INT INCALESCENT_Posix_Descriptor(HANDLE handle);
+
+// The bytes a path takes in UTF-8, including its NUL.
+#define INCALESCENT_POSIX_PATH_SIZE 4096
+
+// Converts a UTF-16 path into UTF-8 and takes backslashes as separators. The NUL device is /dev/null.
+// The converted path must hold INCALESCENT_POSIX_PATH_SIZE bytes.
+BOOL INCALESCENT_Posix_Path(LPCWSTR path, PSTR converted);
+
+// Translates an errno value into the closest Win32 error.
+DWORD INCALESCENT_Posix_Error(INT error);
+
+// Console
+HANDLE GetStdHandle(DWORD handle);
+BOOL WriteConsoleW(HANDLE console, const void *buffer, DWORD length, LPDWORD written, LPVOID reserved);
+BOOL SetConsoleCtrlHandler(PHANDLER_ROUTINE handler, BOOL add);
+
+// Threads and synchronization
+HANDLE CreateThread(LPVOID security, SIZE_T stackSize, LPTHREAD_START_ROUTINE start, LPVOID parameter, DWORD flags, LPDWORD threadId);
+HANDLE GetCurrentProcess(void);
+HANDLE GetCurrentThread(void);
+DWORD GetCurrentThreadId(void);
+BOOL SwitchToThread(void);
+void Sleep(DWORD milliseconds);
+BOOL SetPriorityClass(HANDLE process, DWORD priorityClass);
+BOOL SetThreadPriority(HANDLE thread, INT priority);
+DWORD_PTR SetThreadAffinityMask(HANDLE thread, DWORD_PTR mask);
+DWORD GetActiveProcessorCount(WORD group);
+HANDLE CreateEventW(LPVOID security, BOOL manualReset, BOOL initialState, LPCWSTR name);
+BOOL SetEvent(HANDLE event);
+BOOL ResetEvent(HANDLE event);
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE *handles, BOOL waitAll, DWORD milliseconds);
+void InitializeSRWLock(SRWLOCK *lock);
+void AcquireSRWLockExclusive(SRWLOCK *lock);
+void ReleaseSRWLockExclusive(SRWLOCK *lock);
+void InitializeConditionVariable(CONDITION_VARIABLE *condition);
+BOOL SleepConditionVariableSRW(CONDITION_VARIABLE *condition, SRWLOCK *lock, DWORD milliseconds, ULONG flags);
+void WakeConditionVariable(CONDITION_VARIABLE *condition);
+void WakeAllConditionVariable(CONDITION_VARIABLE *condition);
+
+// Time
+BOOL QueryPerformanceCounter(LARGE_INTEGER *count);
+BOOL QueryPerformanceFrequency(LARGE_INTEGER *frequency);
+ULONGLONG GetTickCount64(void);
+void GetLocalTime(SYSTEMTIME *time);
+
+// Strings
+INT lstrlenW(LPCWSTR string);
+INT lstrlenA(LPCSTR string);
+INT MultiByteToWideChar(UINT codePage, DWORD flags, LPCCH bytes, INT byteCount, LPWSTR wide, INT wideCount);
+INT WideCharToMultiByte(UINT codePage, DWORD flags, LPCWSTR wide, INT wideCount, LPSTR bytes, INT byteCount, LPCCH defaultChar, PBOOL usedDefault);
+INT CompareStringOrdinal(LPCWSTR first, INT firstLength, LPCWSTR second, INT secondLength, BOOL ignoreCase);
+INT CompareStringEx(LPCWSTR locale, DWORD flags, LPCWSTR first, INT firstLength, LPCWSTR second, INT secondLength, LPVOID version, LPVOID reserved,
+                    LPARAM parameter);
+INT CompareStringW(DWORD locale, DWORD flags, LPCWSTR first, INT firstLength, LPCWSTR second, INT secondLength);
+INT LCMapStringEx(LPCWSTR locale, DWORD flags, LPCWSTR source, INT sourceLength, LPWSTR destination, INT destinationLength, LPVOID version,
+                  LPVOID reserved, LPARAM parameter);
+
+// Interlocked operations, all of them full barriers like on Windows.
+static inline LONG InterlockedIncrement(LONG volatile *target) {
+    return __atomic_add_fetch(target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG InterlockedDecrement(LONG volatile *target) {
+    return __atomic_sub_fetch(target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG InterlockedExchange(LONG volatile *target, LONG value) {
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG InterlockedExchangeAdd(LONG volatile *target, LONG value) {
+    return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG InterlockedCompareExchange(LONG volatile *target, LONG exchange, LONG comparand) {
+    __atomic_compare_exchange_n(target, &comparand, exchange, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+static inline LONG64 InterlockedIncrement64(LONG64 volatile *target) {
+    return __atomic_add_fetch(target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64 InterlockedDecrement64(LONG64 volatile *target) {
+    return __atomic_sub_fetch(target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64 InterlockedExchange64(LONG64 volatile *target, LONG64 value) {
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64 InterlockedExchangeAdd64(LONG64 volatile *target, LONG64 value) {
+    return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64 InterlockedAdd64(LONG64 volatile *target, LONG64 value) {
+    return __atomic_add_fetch(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64 InterlockedCompareExchange64(LONG64 volatile *target, LONG64 exchange, LONG64 comparand) {
+    __atomic_compare_exchange_n(target, &comparand, exchange, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+static inline PVOID InterlockedExchangePointer(PVOID volatile *target, PVOID value) {
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline PVOID InterlockedCompareExchangePointer(PVOID volatile *target, PVOID exchange, PVOID comparand) {
+    __atomic_compare_exchange_n(target, &comparand, exchange, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+#endif //INCALESCENT_POSIX_WINDOWS_H
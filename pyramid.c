@@ -0,0 +1,234 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include <math.h>
+#include "pyramid.h"
+
+static void INCALESCENT_Pyramid_ResetLevel(INCALESCENT_Pyramid_Level *level, SIZE_T first, DWORD fieldCount) {
+    level->first = first;
+    level->rowCount = 0;
+    for (DWORD field = 0; field < fieldCount; field++) {
+        level->buckets[field].minimum = INFINITY;
+        level->buckets[field].maximum = -INFINITY;
+        level->buckets[field].sum = 0;
+        level->buckets[field].count = 0;
+    }
+}
+
+// Writes the header of a level, the first and last row followed by the minimum, maximum and mean of
+// every field.
+static HRESULT INCALESCENT_Pyramid_WriteHeader(const INCALESCENT_Pyramid *pyramid, INCALESCENT_Writer *writer) {
+    static const PCSTR suffixes[] = {" Minimum", " Maximum", " Mean"};
+    SIZE_T nameLengths[INCALESCENT_PYRAMID_MAX_FIELDS];
+    SIZE_T length = INCALESCENT_PYRAMID_HEADER_STRING_LENGTH + 2;
+    for (DWORD field = 0; field < pyramid->fieldCount; field++) {
+        nameLengths[field] = lstrlenW(pyramid->fieldNames[field]);
+        for (DWORD suffix = 0; suffix < ARRAYSIZE(suffixes); suffix++) {
+            length += 1 + nameLengths[field] + lstrlenA(suffixes[suffix]);
+        }
+    }
+
+    HRESULT result = INCALESCENT_Writer_Reserve(writer, INCALESCENT_WRITER_MAX_BYTES_PER_UNIT * length);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    INCALESCENT_Writer_AppendAscii(writer, INCALESCENT_PYRAMID_HEADER_STRING, INCALESCENT_PYRAMID_HEADER_STRING_LENGTH);
+    for (DWORD field = 0; field < pyramid->fieldCount; field++) {
+        for (DWORD suffix = 0; suffix < ARRAYSIZE(suffixes); suffix++) {
+            INCALESCENT_Writer_AppendAscii(writer, ",", 1);
+            INCALESCENT_Writer_AppendString(writer, pyramid->fieldNames[field], nameLengths[field]);
+            INCALESCENT_Writer_AppendAscii(writer, suffixes[suffix], lstrlenA(suffixes[suffix]));
+        }
+    }
+    INCALESCENT_Writer_AppendAscii(writer, "\r\n", 2);
+    return S_OK;
+}
+
+// Writes the bucket a level is building as a row of its file. A field without any numbers in the
+// bucket is left empty.
+static HRESULT INCALESCENT_Pyramid_WriteBucket(const INCALESCENT_Pyramid *pyramid, INCALESCENT_Pyramid_Level *level) {
+    WCHAR number[INCALESCENT_PYRAMID_NUMBER_LENGTH];
+
+    // The first and last row with a comma after each, 3 numbers with a comma in front of each per
+    // field and 2 new-line characters.
+    SIZE_T length = (2 * (INCALESCENT_WRITER_UNSIGNED_MAX_DIGITS + 1)) + (pyramid->fieldCount * 3 * (1 + INCALESCENT_PYRAMID_NUMBER_LENGTH)) + 2;
+    HRESULT result = INCALESCENT_Writer_Reserve(&level->writer, INCALESCENT_WRITER_MAX_BYTES_PER_UNIT * length);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    INCALESCENT_Writer_AppendUnsigned(&level->writer, level->first);
+    INCALESCENT_Writer_AppendAscii(&level->writer, ",", 1);
+    INCALESCENT_Writer_AppendUnsigned(&level->writer, level->first + level->rowCount - 1);
+    for (DWORD field = 0; field < pyramid->fieldCount; field++) {
+        const INCALESCENT_Pyramid_Bucket *bucket = &level->buckets[field];
+        DOUBLE numbers[3] = {bucket->minimum, bucket->maximum, bucket->count == 0 ? 0 : bucket->sum / (DOUBLE) bucket->count};
+        for (DWORD index = 0; index < ARRAYSIZE(numbers); index++) {
+            INCALESCENT_Writer_AppendAscii(&level->writer, ",", 1);
+            if (bucket->count == 0) {
+                continue;
+            }
+            result = StringCchPrintfW(number, INCALESCENT_PYRAMID_NUMBER_LENGTH, L"%.15g", numbers[index]);
+            if (FAILED(result)) {
+                return result;
+            }
+            INCALESCENT_Writer_AppendString(&level->writer, number, lstrlenW(number));
+        }
+    }
+    INCALESCENT_Writer_AppendAscii(&level->writer, "\r\n", 2);
+    return S_OK;
+}
+
+// Writes the bucket a level is building, folds it into the bucket of the level above and starts the
+// level's next bucket.
+static HRESULT INCALESCENT_Pyramid_EndBucket(INCALESCENT_Pyramid *pyramid, DWORD index) {
+    INCALESCENT_Pyramid_Level *level = &pyramid->levels[index];
+    HRESULT result = INCALESCENT_Pyramid_WriteBucket(pyramid, level);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    if (index + 1 < pyramid->levelCount) {
+        INCALESCENT_Pyramid_Level *parent = &pyramid->levels[index + 1];
+        for (DWORD field = 0; field < pyramid->fieldCount; field++) {
+            INCALESCENT_Pyramid_Bucket *into = &parent->buckets[field];
+            const INCALESCENT_Pyramid_Bucket *from = &level->buckets[field];
+            into->minimum = from->minimum < into->minimum ? from->minimum : into->minimum;
+            into->maximum = from->maximum > into->maximum ? from->maximum : into->maximum;
+            into->sum += from->sum;
+            into->count += from->count;
+        }
+        parent->rowCount += level->rowCount;
+    }
+
+    INCALESCENT_Pyramid_ResetLevel(level, level->first + level->rowCount, pyramid->fieldCount);
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Pyramid_Create
+HRESULT INCALESCENT_Pyramid_Create(INCALESCENT_Pyramid *pyramid, PCWSTR tablePath, const PCWSTR *fieldNames, DWORD fieldCount,
+                                   INCALESCENT_Writer_Encoding encoding, INCALESCENT_Arena *arena) {
+    HRESULT result = S_OK;
+    WCHAR path[INCALESCENT_PYRAMID_PATH_SIZE];
+    SIZE_T span = 1;
+
+    if (fieldCount > INCALESCENT_PYRAMID_MAX_FIELDS) {
+        result = E_INVALIDARG;
+        goto cleanup;
+    }
+    for (DWORD field = 0; field < fieldCount; field++) {
+        pyramid->fieldNames[field] = fieldNames[field];
+    }
+    pyramid->fieldCount = fieldCount;
+    pyramid->rowCount = 0;
+
+    for (DWORD index = 0; index < INCALESCENT_PYRAMID_LEVELS; index++) {
+        INCALESCENT_Pyramid_Level *level = &pyramid->levels[index];
+        span *= INCALESCENT_PYRAMID_FACTOR;
+        level->span = span;
+        INCALESCENT_Pyramid_ResetLevel(level, 0, fieldCount);
+
+        result = StringCchPrintfW(path, INCALESCENT_PYRAMID_PATH_SIZE, INCALESCENT_PYRAMID_PATH_FORMAT, tablePath, (ULONGLONG) span);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        level->file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (level->file == INVALID_HANDLE_VALUE) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        pyramid->levelCount++;
+
+        result = INCALESCENT_Writer_Create(&level->writer, level->file, encoding, arena);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_Pyramid_WriteHeader(pyramid, &level->writer);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Pyramid_AppendRow
+HRESULT INCALESCENT_Pyramid_AppendRow(INCALESCENT_Pyramid *pyramid, const DOUBLE *values) {
+    INCALESCENT_Pyramid_Level *level = &pyramid->levels[0];
+    for (DWORD field = 0; field < pyramid->fieldCount; field++) {
+        DOUBLE value = values[field];
+        if (isnan(value)) {
+            continue;
+        }
+        INCALESCENT_Pyramid_Bucket *bucket = &level->buckets[field];
+        bucket->minimum = value < bucket->minimum ? value : bucket->minimum;
+        bucket->maximum = value > bucket->maximum ? value : bucket->maximum;
+        bucket->sum += value;
+        bucket->count++;
+    }
+    level->rowCount++;
+    pyramid->rowCount++;
+
+    // A full bucket can fill the one above it, and so on up the levels.
+    for (DWORD index = 0; index < pyramid->levelCount && pyramid->levels[index].rowCount == pyramid->levels[index].span; index++) {
+        HRESULT result = INCALESCENT_Pyramid_EndBucket(pyramid, index);
+        if (FAILED(result)) {
+            return result;
+        }
+    }
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Pyramid_Finish
+HRESULT INCALESCENT_Pyramid_Finish(INCALESCENT_Pyramid *pyramid) {
+    HRESULT result = S_OK;
+
+    // Going up the levels, every partial bucket is folded into the one above before that is written.
+    for (DWORD index = 0; index < pyramid->levelCount; index++) {
+        if (pyramid->levels[index].rowCount != 0) {
+            result = INCALESCENT_Pyramid_EndBucket(pyramid, index);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+        result = INCALESCENT_Writer_Flush(&pyramid->levels[index].writer);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Pyramid_Destroy
+void INCALESCENT_Pyramid_Destroy(INCALESCENT_Pyramid *pyramid) {
+    for (DWORD index = 0; index < pyramid->levelCount; index++) {
+        CloseHandle(pyramid->levels[index].file);
+    }
+    pyramid->levelCount = 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_PYRAMID_H
+#define INCALESCENT_PYRAMID_H
+#include "string.h"
+#include "arena.h"
+#include "writer.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef double DOUBLE;
+typedef unsigned short WCHAR;
+typedef const WCHAR* PCWSTR;
+typedef void* HANDLE;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+// The levels of the pyramid. The first level summarizes every INCALESCENT_PYRAMID_FACTOR rows of
+// the table, and every further level that many buckets of the level before it.
+#define INCALESCENT_PYRAMID_LEVELS 3
+#define INCALESCENT_PYRAMID_FACTOR 10
+#define INCALESCENT_PYRAMID_MAX_FIELDS 16
+
+// Every level is written next to the table, named after the number of rows in its buckets.
+#define INCALESCENT_PYRAMID_PATH_FORMAT L"%s.%llu.csv"
+#define INCALESCENT_PYRAMID_PATH_SIZE ((260 * 2) + 32)
+#define INCALESCENT_PYRAMID_HEADER_STRING "First,Last"
+#define INCALESCENT_PYRAMID_HEADER_STRING_LENGTH INCALESCENT_STRING_LENGTH(INCALESCENT_PYRAMID_HEADER_STRING)
+#define INCALESCENT_PYRAMID_NUMBER_LENGTH 32
+
+// The numbers of a field in a run of rows. Rows without a number are left out.
+typedef struct INCALESCENT_Pyramid_Bucket {
+    DOUBLE minimum;
+    DOUBLE maximum;
+    DOUBLE sum;
+    ULONGLONG count;
+} INCALESCENT_Pyramid_Bucket;
+
+typedef struct INCALESCENT_Pyramid_Level {
+    HANDLE file;
+    INCALESCENT_Writer writer;
+
+    // The number of rows a full bucket spans, the first row of the bucket being built and how many
+    // rows it spans so far.
+    SIZE_T span;
+    SIZE_T first;
+    SIZE_T rowCount;
+    INCALESCENT_Pyramid_Bucket buckets[INCALESCENT_PYRAMID_MAX_FIELDS];
+} INCALESCENT_Pyramid_Level;
+
+/**
+ * @brief Downsampled copies of a table, for plotting series that are too long to plot in full.
+ *
+ * Every level is a CSV table with the first and last row of every bucket followed by the minimum,
+ * maximum and mean of every field in it, so a viewer can load the coarsest level at once and read
+ * the rows of a range it zooms in on from a finer one. The pyramid is built as the rows of the table
+ * are appended, and a finished bucket is folded into the level above it, so every row is only
+ * looked at once.
+ */
+typedef struct INCALESCENT_Pyramid {
+    PCWSTR fieldNames[INCALESCENT_PYRAMID_MAX_FIELDS];
+    DWORD fieldCount;
+    SIZE_T rowCount;
+
+    // The levels whose files have been created, which are the ones closed by the destruction.
+    INCALESCENT_Pyramid_Level levels[INCALESCENT_PYRAMID_LEVELS];
+    DWORD levelCount;
+} INCALESCENT_Pyramid;
+
+/**
+ * @brief Creates the file of every level next to a table and writes their headers.
+ *
+ * @param[out] pyramid      The pyramid to initialize. It must be zeroed, so that it can be
+ *                          destroyed even if the creation fails.
+ * @param[in] tablePath     The path of the table the pyramid summarizes.
+ * @param[in] fieldNames    The names of the fields. They must outlive the pyramid.
+ * @param[in] fieldCount    The number of fields, at most INCALESCENT_PYRAMID_MAX_FIELDS.
+ * @param[in] encoding      The encoding of the level files.
+ * @param[in] arena         The arena the output buffers are allocated from.
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Pyramid_Create(INCALESCENT_Pyramid *pyramid, PCWSTR tablePath, const PCWSTR *fieldNames, DWORD fieldCount,
+                                   INCALESCENT_Writer_Encoding encoding, INCALESCENT_Arena *arena);
+
+/**
+ * @brief Adds the next row of the table. Its index is the number of rows added before it.
+ *
+ * @param[in] values    The value of every field. A NaN leaves the row without a value.
+ */
+HRESULT INCALESCENT_Pyramid_AppendRow(INCALESCENT_Pyramid *pyramid, const DOUBLE *values);
+
+/**
+ * @brief Writes the buckets the last rows are in, even though they aren't full, and flushes every level.
+ */
+HRESULT INCALESCENT_Pyramid_Finish(INCALESCENT_Pyramid *pyramid);
+
+// Closes the files of the levels. A zeroed pyramid has none.
+void INCALESCENT_Pyramid_Destroy(INCALESCENT_Pyramid *pyramid);
+
+#endif //INCALESCENT_PYRAMID_H
@@ -0,0 +1,369 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "runs.h"
+
+// The next name of a run being merged, and the part of the run read so far.
+typedef struct INCALESCENT_Runs_Cursor {
+    // The next byte of the run to read, and the end of the run.
+    ULONGLONG offset;
+    ULONGLONG end;
+
+    PBYTE buffer;
+    SIZE_T position;
+    SIZE_T used;
+
+    // The name the cursor is at and its sort key. The name is NULL once the run is exhausted.
+    PWSTR name;
+    PBYTE key;
+    SIZE_T keyLength;
+} INCALESCENT_Runs_Cursor;
+
+// The size a name takes in a run, behind its information and padded to the record alignment.
+static SIZE_T INCALESCENT_Runs_RecordSize(SIZE_T length) {
+    SIZE_T size = sizeof(INCALESCENT_File_NameInfo) + (sizeof(WCHAR) * (length + 1));
+    return (size + INCALESCENT_RUNS_RECORD_ALIGNMENT - 1) & ~((SIZE_T) INCALESCENT_RUNS_RECORD_ALIGNMENT - 1);
+}
+
+// Implementation for INCALESCENT_Runs_Size
+SIZE_T INCALESCENT_Runs_Size(SIZE_T fanIn) {
+    // The cursors, the heap and every buffer may each be padded up to their alignment.
+    SIZE_T runSize = sizeof(INCALESCENT_Runs_Cursor) + sizeof(SIZE_T) + INCALESCENT_RUNS_BUFFER_SIZE + INCALESCENT_STRING_SORT_KEY_MAX_SIZE +
+                     INCALESCENT_ARENA_DEFAULT_ALIGNMENT;
+    return INCALESCENT_RUNS_BUFFER_SIZE + (2 * INCALESCENT_ARENA_DEFAULT_ALIGNMENT) + (fanIn * runSize);
+}
+
+// Implementation for INCALESCENT_Runs_Create
+HRESULT INCALESCENT_Runs_Create(INCALESCENT_Runs *runs, SIZE_T budget) {
+    HRESULT result = S_OK;
+    WCHAR directory[MAX_PATH + 1];
+    WCHAR path[MAX_PATH];
+
+    ZeroMemory(runs, sizeof(INCALESCENT_Runs));
+    runs->file = INVALID_HANDLE_VALUE;
+
+    // Every run being merged takes a buffer and a sort key besides the output buffer, and a merge
+    // needs at least two of them to get anywhere.
+    SIZE_T fixedSize = INCALESCENT_Runs_Size(0);
+    runs->fanIn = budget > fixedSize ? (budget - fixedSize) / (INCALESCENT_Runs_Size(1) - fixedSize) : 0;
+    if (runs->fanIn < 2) {
+        runs->fanIn = 2;
+    }
+    if (runs->fanIn > INCALESCENT_RUNS_MAX_FAN_IN) {
+        runs->fanIn = INCALESCENT_RUNS_MAX_FAN_IN;
+    }
+
+    result = INCALESCENT_Arena_Create(&runs->table, INCALESCENT_RUNS_TABLE_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Create(&runs->arena, INCALESCENT_RUNS_ARENA_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&runs->arena, INCALESCENT_RUNS_BUFFER_SIZE, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &runs->output);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    DWORD length = GetTempPathW(ARRAYSIZE(directory), directory);
+    if (length == 0) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (length > ARRAYSIZE(directory)) {
+        result = HRESULT_FROM_WIN32(ERROR_BUFFER_OVERFLOW);
+        goto cleanup;
+    }
+    if (GetTempFileNameW(directory, INCALESCENT_RUNS_TEMPORARY_PREFIX, 0, path) == 0) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    // The file is deleted once it is closed, even if the process ends without closing it. Marking
+    // it temporary keeps it in the cache rather than on the disk for as long as memory allows.
+    runs->file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                             NULL);
+    if (runs->file == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        DeleteFileW(path);
+        goto cleanup;
+    }
+
+    cleanup:
+    return result;
+}
+
+// Writes the buffered records out at the end of the file.
+static HRESULT INCALESCENT_Runs_Flush(INCALESCENT_Runs *runs) {
+    OVERLAPPED overlapped = {0};
+    DWORD written = 0;
+
+    if (runs->outputUsed == 0) {
+        return S_OK;
+    }
+    overlapped.Offset = (DWORD) runs->written;
+    overlapped.OffsetHigh = (DWORD) (runs->written >> 32);
+    if (!WriteFile(runs->file, runs->output, (DWORD) runs->outputUsed, &written, &overlapped)) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    if (written != runs->outputUsed) {
+        return HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+    }
+    runs->written += written;
+    runs->outputUsed = 0;
+    return S_OK;
+}
+
+// Appends a name to the run being written.
+static HRESULT INCALESCENT_Runs_Append(INCALESCENT_Runs *runs, PWSTR name) {
+    const INCALESCENT_File_NameInfo *info = INCALESCENT_FILE_NAME_INFO(name);
+    SIZE_T recordSize = INCALESCENT_Runs_RecordSize(info->length);
+
+    if (INCALESCENT_RUNS_BUFFER_SIZE - runs->outputUsed < recordSize) {
+        HRESULT result = INCALESCENT_Runs_Flush(runs);
+        if (FAILED(result)) {
+            return result;
+        }
+    }
+    CopyMemory(runs->output + runs->outputUsed, info, sizeof(INCALESCENT_File_NameInfo) + (sizeof(WCHAR) * (info->length + 1)));
+    runs->outputUsed += recordSize;
+    runs->size += recordSize;
+    return S_OK;
+}
+
+// Ends the run that started at offset, writing out the rest of it so it can be read back.
+static HRESULT INCALESCENT_Runs_EndRun(INCALESCENT_Runs *runs, ULONGLONG offset) {
+    INCALESCENT_Runs_Run *run = NULL;
+
+    HRESULT result = INCALESCENT_Runs_Flush(runs);
+    if (FAILED(result)) {
+        return result;
+    }
+    result = INCALESCENT_Arena_Allocate(&runs->table, sizeof(INCALESCENT_Runs_Run), sizeof(ULONGLONG), (PVOID *) &run);
+    if (FAILED(result)) {
+        return result;
+    }
+    run->offset = offset;
+    run->size = runs->size - offset;
+    runs->runs = (INCALESCENT_Runs_Run *) runs->table.base;
+    runs->runCount++;
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Runs_Spill
+HRESULT INCALESCENT_Runs_Spill(INCALESCENT_Runs *runs, PWSTR *names, SIZE_T count) {
+    HRESULT result = S_OK;
+    ULONGLONG offset = runs->size;
+
+    for (SIZE_T index = 0; index < count; index++) {
+        result = INCALESCENT_Runs_Append(runs, names[index]);
+        if (FAILED(result)) {
+            return result;
+        }
+    }
+    result = INCALESCENT_Runs_EndRun(runs, offset);
+    if (FAILED(result)) {
+        return result;
+    }
+    runs->nameCount += count;
+    return S_OK;
+}
+
+// Moves a cursor to the next name of its run. More of the run is read once fewer bytes than the
+// largest record are left in the buffer, so a record is never split.
+static HRESULT INCALESCENT_Runs_Advance(INCALESCENT_Runs *runs, INCALESCENT_Runs_Cursor *cursor) {
+    SIZE_T left = cursor->used - cursor->position;
+
+    if (left < INCALESCENT_RUNS_MAX_RECORD_SIZE && cursor->offset < cursor->end) {
+        MoveMemory(cursor->buffer, cursor->buffer + cursor->position, left);
+        ULONGLONG remaining = cursor->end - cursor->offset;
+        DWORD size = (DWORD) (remaining < INCALESCENT_RUNS_BUFFER_SIZE - left ? remaining : INCALESCENT_RUNS_BUFFER_SIZE - left);
+        OVERLAPPED overlapped = {0};
+        overlapped.Offset = (DWORD) cursor->offset;
+        overlapped.OffsetHigh = (DWORD) (cursor->offset >> 32);
+        DWORD read = 0;
+        if (!ReadFile(runs->file, cursor->buffer + left, size, &read, &overlapped)) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        if (read != size) {
+            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+        }
+        cursor->offset += size;
+        cursor->position = 0;
+        cursor->used = left + size;
+        left = cursor->used;
+    }
+    if (left == 0) {
+        cursor->name = NULL;
+        return S_OK;
+    }
+
+    // Only this process ever wrote the file, but a record that doesn't fit would still be read
+    // past the buffer.
+    const INCALESCENT_File_NameInfo *info = (const INCALESCENT_File_NameInfo *) (cursor->buffer + cursor->position);
+    if (left < sizeof(INCALESCENT_File_NameInfo) || info->length >= INCALESCENT_FILE_MAX_PATH || INCALESCENT_Runs_RecordSize(info->length) > left) {
+        return HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+    }
+    cursor->name = (PWSTR) (info + 1);
+    cursor->position += INCALESCENT_Runs_RecordSize(info->length);
+    return INCALESCENT_String_SortKey(cursor->name, cursor->key, &cursor->keyLength);
+}
+
+// Whether the name of the first cursor comes before the name of the second. Equal names come from
+// the earlier run first.
+static BOOL INCALESCENT_Runs_Precedes(const INCALESCENT_Runs_Cursor *cursors, SIZE_T first, SIZE_T second) {
+    INT comparison = INCALESCENT_String_CompareKeys(cursors[first].key, cursors[first].keyLength, cursors[second].key, cursors[second].keyLength);
+    return comparison < 0 || (comparison == 0 && first < second);
+}
+
+// Moves the cursor at position of the heap down until neither of its children precedes it.
+static void INCALESCENT_Runs_SiftDown(const INCALESCENT_Runs_Cursor *cursors, SIZE_T *heap, SIZE_T count, SIZE_T position) {
+    for (;;) {
+        SIZE_T first = position;
+        SIZE_T left = (2 * position) + 1;
+        SIZE_T right = left + 1;
+        if (left < count && INCALESCENT_Runs_Precedes(cursors, heap[left], heap[first])) {
+            first = left;
+        }
+        if (right < count && INCALESCENT_Runs_Precedes(cursors, heap[right], heap[first])) {
+            first = right;
+        }
+        if (first == position) {
+            return;
+        }
+        SIZE_T swap = heap[position];
+        heap[position] = heap[first];
+        heap[first] = swap;
+        position = first;
+    }
+}
+
+// Merges the runs [first, first + count) into the callback, keeping the cursors in a heap ordered
+// by their next names.
+static HRESULT INCALESCENT_Runs_MergeGroup(INCALESCENT_Runs *runs, SIZE_T first, SIZE_T count, INCALESCENT_Runs_Callback callback,
+                                           PVOID context) {
+    HRESULT result = S_OK;
+    SIZE_T arenaMark = INCALESCENT_Arena_Mark(&runs->arena);
+    INCALESCENT_Runs_Cursor *cursors = NULL;
+    SIZE_T *heap = NULL;
+    SIZE_T heapCount = 0;
+
+    result = INCALESCENT_Arena_Allocate(&runs->arena, sizeof(INCALESCENT_Runs_Cursor) * count, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &cursors);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&runs->arena, sizeof(SIZE_T) * count, sizeof(SIZE_T), (PVOID *) &heap);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (SIZE_T index = 0; index < count; index++) {
+        INCALESCENT_Runs_Cursor *cursor = &cursors[index];
+        ZeroMemory(cursor, sizeof(INCALESCENT_Runs_Cursor));
+        result = INCALESCENT_Arena_Allocate(&runs->arena, INCALESCENT_RUNS_BUFFER_SIZE, INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &cursor->buffer);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_Arena_Allocate(&runs->arena, INCALESCENT_STRING_SORT_KEY_MAX_SIZE, 1, (PVOID *) &cursor->key);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        cursor->offset = runs->runs[first + index].offset;
+        cursor->end = cursor->offset + runs->runs[first + index].size;
+
+        result = INCALESCENT_Runs_Advance(runs, cursor);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        if (cursor->name != NULL) {
+            heap[heapCount++] = index;
+        }
+    }
+    for (SIZE_T position = heapCount / 2; position-- > 0;) {
+        INCALESCENT_Runs_SiftDown(cursors, heap, heapCount, position);
+    }
+
+    while (heapCount != 0) {
+        INCALESCENT_Runs_Cursor *cursor = &cursors[heap[0]];
+        result = callback(context, cursor->name);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_Runs_Advance(runs, cursor);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        if (cursor->name == NULL) {
+            heap[0] = heap[--heapCount];
+        }
+        INCALESCENT_Runs_SiftDown(cursors, heap, heapCount, 0);
+    }
+
+    cleanup:
+    INCALESCENT_Arena_Reset(&runs->arena, arenaMark);
+    return result;
+}
+
+// Appends a name of a merge to the run being written.
+static HRESULT INCALESCENT_Runs_Respill(PVOID parameter, PWSTR name) {
+    return INCALESCENT_Runs_Append(parameter, name);
+}
+
+// Implementation for INCALESCENT_Runs_Merge
+HRESULT INCALESCENT_Runs_Merge(INCALESCENT_Runs *runs, INCALESCENT_Runs_Callback callback, PVOID context) {
+    HRESULT result = S_OK;
+    SIZE_T first = 0;
+
+    // Every level of runs is merged in groups into a shorter level of longer runs, until a single
+    // merge can take all of them. A level's runs stay in the order of the names they hold, so names
+    // that sort equally never swap places.
+    while (runs->runCount - first > runs->fanIn) {
+        SIZE_T last = runs->runCount;
+        for (SIZE_T group = first; group < last; group += runs->fanIn) {
+            SIZE_T count = last - group < runs->fanIn ? last - group : runs->fanIn;
+            ULONGLONG offset = runs->size;
+            result = INCALESCENT_Runs_MergeGroup(runs, group, count, INCALESCENT_Runs_Respill, runs);
+            if (FAILED(result)) {
+                return result;
+            }
+            result = INCALESCENT_Runs_EndRun(runs, offset);
+            if (FAILED(result)) {
+                return result;
+            }
+        }
+        first = last;
+    }
+    return INCALESCENT_Runs_MergeGroup(runs, first, runs->runCount - first, callback, context);
+}
+
+// Implementation for INCALESCENT_Runs_Destroy
+void INCALESCENT_Runs_Destroy(INCALESCENT_Runs *runs) {
+    if (runs->file != NULL && runs->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(runs->file);
+    }
+    runs->file = INVALID_HANDLE_VALUE;
+    INCALESCENT_Arena_Destroy(&runs->table);
+    INCALESCENT_Arena_Destroy(&runs->arena);
+}
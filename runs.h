@@ -0,0 +1,140 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_RUNS_H
+#define INCALESCENT_RUNS_H
+#include "arena.h"
+#include "file.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* PVOID;
+typedef void* HANDLE;
+typedef unsigned char* PBYTE;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+
+// Runs are written and read this many bytes at a time. Every run being merged takes a buffer of
+// this size and room for the sort key of its next name.
+#define INCALESCENT_RUNS_BUFFER_SIZE (256 * 1024)
+#define INCALESCENT_RUNS_MAX_FAN_IN 1024
+#define INCALESCENT_RUNS_TABLE_RESERVE (64 * 1024 * 1024)
+#define INCALESCENT_RUNS_ARENA_RESERVE (1ULL * 1024 * 1024 * 1024)
+#define INCALESCENT_RUNS_TEMPORARY_PREFIX L"inc"
+
+// Every name is stored behind its INCALESCENT_File_NameInfo, padded to this alignment so that the
+// next one can be used in place.
+#define INCALESCENT_RUNS_RECORD_ALIGNMENT 8
+#define INCALESCENT_RUNS_MAX_RECORD_SIZE (sizeof(INCALESCENT_File_NameInfo) + (sizeof(WCHAR) * INCALESCENT_FILE_MAX_PATH))
+
+// Where a run is in the temporary file.
+typedef struct INCALESCENT_Runs_Run {
+    ULONGLONG offset;
+    ULONGLONG size;
+} INCALESCENT_Runs_Run;
+
+/**
+ * @brief Sorted runs of names spilled to a temporary file, and merged back into a single sorted
+ *        sequence.
+ *
+ * Each run is a sorted batch of names, written one after another to a temporary file that is
+ * deleted once it is closed. The runs are merged by comparing the sort key of each run's next name,
+ * so the merge needs no more memory than a read buffer and a sort key per run, no matter how many
+ * names there are. When there are more runs than the fan-in allows, groups of them are first merged
+ * into longer runs at the end of the file.
+ */
+typedef struct INCALESCENT_Runs {
+    HANDLE file;
+
+    // Where the runs are, and the number of names in all of them.
+    INCALESCENT_Runs_Run *runs;
+    SIZE_T runCount;
+    SIZE_T nameCount;
+
+    // The most runs merged at once.
+    SIZE_T fanIn;
+
+    // The end of the file including the buffered bytes, and the end of what was written out.
+    ULONGLONG size;
+    ULONGLONG written;
+    PBYTE output;
+    SIZE_T outputUsed;
+
+    // The run table, and the buffers of a merge.
+    INCALESCENT_Arena table;
+    INCALESCENT_Arena arena;
+} INCALESCENT_Runs;
+
+// Takes the next name of a merge, which is behind its INCALESCENT_File_NameInfo and only valid
+// until the callback returns.
+typedef HRESULT (*INCALESCENT_Runs_Callback)(PVOID context, PWSTR name);
+
+/**
+ * @brief Creates the temporary file for the runs.
+ *
+ * @param[out] runs     The runs to initialize. They must be released with INCALESCENT_Runs_Destroy,
+ *                      even if creating them fails.
+ * @param[in] budget    The memory the buffers of the runs may take, which sets how many runs are
+ *                      merged at once. Two runs are always merged at a time, even if the budget
+ *                      is below INCALESCENT_Runs_Size(2).
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Runs_Create(INCALESCENT_Runs *runs, SIZE_T budget);
+
+// The most memory the buffers of the runs take when merging fanIn runs at once: the output buffer,
+// and a cursor, a buffer and a sort key for every run. The run table isn't included, as it grows
+// with the number of runs.
+SIZE_T INCALESCENT_Runs_Size(SIZE_T fanIn);
+
+/**
+ * @brief Writes a sorted batch of names as a run.
+ *
+ * @param[in] runs      The runs.
+ * @param[in] names     The names in sorted order, each behind its INCALESCENT_File_NameInfo.
+ * @param[in] count     The number of names.
+ *
+ * @return The result of writing the run (S_OK if successful).
+ */
+HRESULT INCALESCENT_Runs_Spill(INCALESCENT_Runs *runs, PWSTR *names, SIZE_T count);
+
+/**
+ * @brief Merges every run, passing each name to the callback in sorted order.
+ *
+ * Names that sort equally come in the order they were spilled, the same as a stable sort of all of
+ * them would put them in.
+ *
+ * @param[in] runs      The runs.
+ * @param[in] callback  Takes every name. The merge stops at the first failure it returns.
+ * @param[in] context   The context of the callback.
+ *
+ * @return The result of the merge (S_OK if successful).
+ */
+HRESULT INCALESCENT_Runs_Merge(INCALESCENT_Runs *runs, INCALESCENT_Runs_Callback callback, PVOID context);
+
+// Closes and deletes the temporary file and releases the memory of the runs.
+void INCALESCENT_Runs_Destroy(INCALESCENT_Runs *runs);
+
+#endif //INCALESCENT_RUNS_H
@@ -0,0 +1,179 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <intrin.h>
+#include "scan.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define INCALESCENT_SCAN_X86
+#include <immintrin.h>
+#endif
+
+// MSVC emits any instruction set anywhere, while GCC and Clang only do so in functions marked for it.
+#if defined(__GNUC__)
+#define INCALESCENT_SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define INCALESCENT_SCAN_TARGET_AVX2
+#endif
+
+#define INCALESCENT_SCAN_LEVEL_UNKNOWN (-1)
+
+static volatile LONG INCALESCENT_Scan_DetectedLevel = INCALESCENT_SCAN_LEVEL_UNKNOWN;
+
+static const BYTE *INCALESCENT_Scan_FindScalar(const BYTE *data, SIZE_T size, const BYTE *key, SIZE_T keyLength) {
+    if (keyLength > size) {
+        return NULL;
+    }
+
+    const BYTE *last = data + (size - keyLength);
+    for (const BYTE *candidate = data; candidate <= last; candidate++) {
+        candidate = memchr(candidate, key[0], (last - candidate) + 1);
+        if (candidate == NULL) {
+            break;
+        }
+        if (candidate[keyLength - 1] == key[keyLength - 1] && memcmp(candidate, key, keyLength) == 0) {
+            return candidate;
+        }
+    }
+
+    return NULL;
+}
+
+#ifdef INCALESCENT_SCAN_X86
+static const BYTE *INCALESCENT_Scan_FindSse2(const BYTE *data, SIZE_T size, const BYTE *key, SIZE_T keyLength) {
+    if (keyLength > size) {
+        return NULL;
+    }
+
+    __m128i firstByte = _mm_set1_epi8((char) key[0]);
+    __m128i lastByte = _mm_set1_epi8((char) key[keyLength - 1]);
+
+    // Every candidate start in [0, candidateCount) leaves room for the whole key, so loading the
+    // vector that holds the last byte of the key never reads past the end of the buffer.
+    SIZE_T candidateCount = size - keyLength + 1;
+    SIZE_T index = 0;
+    for (; index + sizeof(__m128i) <= candidateCount; index += sizeof(__m128i)) {
+        __m128i firstBlock = _mm_loadu_si128((const __m128i *) (data + index));
+        __m128i lastBlock = _mm_loadu_si128((const __m128i *) (data + index + keyLength - 1));
+        __m128i matches = _mm_and_si128(_mm_cmpeq_epi8(firstByte, firstBlock), _mm_cmpeq_epi8(lastByte, lastBlock));
+
+        unsigned long mask = (unsigned int) _mm_movemask_epi8(matches);
+        while (mask != 0) {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            if (memcmp(data + index + bit, key, keyLength) == 0) {
+                return data + index + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return INCALESCENT_Scan_FindScalar(data + index, size - index, key, keyLength);
+}
+
+INCALESCENT_SCAN_TARGET_AVX2 static const BYTE *INCALESCENT_Scan_FindAvx2(const BYTE *data, SIZE_T size, const BYTE *key, SIZE_T keyLength) {
+    if (keyLength > size) {
+        return NULL;
+    }
+
+    __m256i firstByte = _mm256_set1_epi8((char) key[0]);
+    __m256i lastByte = _mm256_set1_epi8((char) key[keyLength - 1]);
+
+    SIZE_T candidateCount = size - keyLength + 1;
+    SIZE_T index = 0;
+    for (; index + sizeof(__m256i) <= candidateCount; index += sizeof(__m256i)) {
+        __m256i firstBlock = _mm256_loadu_si256((const __m256i *) (data + index));
+        __m256i lastBlock = _mm256_loadu_si256((const __m256i *) (data + index + keyLength - 1));
+        __m256i matches = _mm256_and_si256(_mm256_cmpeq_epi8(firstByte, firstBlock), _mm256_cmpeq_epi8(lastByte, lastBlock));
+
+        unsigned long mask = (unsigned int) _mm256_movemask_epi8(matches);
+        while (mask != 0) {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            if (memcmp(data + index + bit, key, keyLength) == 0) {
+                return data + index + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    // Finish the tail with the narrower vectors before falling back to single bytes.
+    return INCALESCENT_Scan_FindSse2(data + index, size - index, key, keyLength);
+}
+#endif
+
+// Implementation for INCALESCENT_Scan_SupportedLevel
+INCALESCENT_Scan_Level INCALESCENT_Scan_SupportedLevel(void) {
+    INCALESCENT_Scan_Level level = INCALESCENT_SCAN_LEVEL_SCALAR;
+
+#ifdef INCALESCENT_SCAN_X86
+    int information[4];
+    __cpuid(information, 0);
+    int maximumLeaf = information[0];
+
+    __cpuid(information, 1);
+    BOOL sse2 = (information[3] & (1 << 26)) != 0;
+    BOOL osxsave = (information[2] & (1 << 27)) != 0;
+    BOOL avx = (information[2] & (1 << 28)) != 0;
+    if (sse2) {
+        level = INCALESCENT_SCAN_LEVEL_SSE2;
+    }
+
+    // AVX2 also needs the operating system to save the upper halves of the YMM registers.
+    if (maximumLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(information, 7, 0);
+        if ((information[1] & (1 << 5)) != 0) {
+            level = INCALESCENT_SCAN_LEVEL_AVX2;
+        }
+    }
+#endif
+
+    return level;
+}
+
+// Implementation for INCALESCENT_Scan_FindWithLevel
+const BYTE *INCALESCENT_Scan_FindWithLevel(INCALESCENT_Scan_Level level, const BYTE *data, SIZE_T size, const BYTE *key, SIZE_T keyLength) {
+    switch (level) {
+#ifdef INCALESCENT_SCAN_X86
+        case INCALESCENT_SCAN_LEVEL_AVX2:
+            return INCALESCENT_Scan_FindAvx2(data, size, key, keyLength);
+        case INCALESCENT_SCAN_LEVEL_SSE2:
+            return INCALESCENT_Scan_FindSse2(data, size, key, keyLength);
+#endif
+        default:
+            return INCALESCENT_Scan_FindScalar(data, size, key, keyLength);
+    }
+}
+
+// Implementation for INCALESCENT_Scan_Find
+const BYTE *INCALESCENT_Scan_Find(const BYTE *data, SIZE_T size, const BYTE *key, SIZE_T keyLength) {
+    // Detection is idempotent, so racing threads at worst detect the level twice.
+    LONG level = INCALESCENT_Scan_DetectedLevel;
+    if (level == INCALESCENT_SCAN_LEVEL_UNKNOWN) {
+        level = INCALESCENT_Scan_SupportedLevel();
+        InterlockedExchange(&INCALESCENT_Scan_DetectedLevel, level);
+    }
+
+    return INCALESCENT_Scan_FindWithLevel((INCALESCENT_Scan_Level) level, data, size, key, keyLength);
+}
@@ -0,0 +1,64 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_SCAN_H
+#define INCALESCENT_SCAN_H
+
+// Forward declarations from <windows.h>
+typedef unsigned char BYTE;
+typedef unsigned __int64 SIZE_T;
+
+typedef enum INCALESCENT_Scan_Level {
+    INCALESCENT_SCAN_LEVEL_SCALAR = 0,
+    INCALESCENT_SCAN_LEVEL_SSE2 = 1,
+    INCALESCENT_SCAN_LEVEL_AVX2 = 2,
+} INCALESCENT_Scan_Level;
+
+/**
+ * @brief Finds the first occurrence of a key within a byte buffer.
+ *
+ * Candidate positions are found by comparing the first and the last byte of the key against
+ * a whole vector of the buffer at once, so the remaining bytes of the key are only compared
+ * where both of those match. The widest implementation supported by the processor is chosen
+ * the first time the function is called.
+ *
+ * @param[in] data          The buffer to search.
+ * @param[in] size          The size of the buffer in bytes.
+ * @param[in] key           The key to search for.
+ * @param[in] keyLength     The length of the key in bytes. Must be at least 1.
+ *
+ * @return A pointer to the first byte of the match within data, or NULL if there is none.
+ */
+const BYTE *INCALESCENT_Scan_Find(const BYTE *data, SIZE_T size, const BYTE *key, SIZE_T keyLength);
+
+/**
+ * @brief Finds the first occurrence of a key using a specific implementation.
+ *
+ * This is the same as INCALESCENT_Scan_Find, except the implementation is chosen by the caller.
+ * The level must be supported by the processor (see INCALESCENT_Scan_SupportedLevel).
+ */
+const BYTE *INCALESCENT_Scan_FindWithLevel(INCALESCENT_Scan_Level level, const BYTE *data, SIZE_T size, const BYTE *key, SIZE_T keyLength);
+
+INCALESCENT_Scan_Level INCALESCENT_Scan_SupportedLevel(void);
+
+#endif //INCALESCENT_SCAN_H
@@ -0,0 +1,324 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include "sorted.h"
+#include "table.h"
+#include "log.h"
+#include "pool.h"
+#include "cache.h"
+#include "watch.h"
+#include "perf.h"
+#include "generated_error.h"
+
+// A name decoded from a name pool, behind its information like the names of a list.
+typedef struct INCALESCENT_Sorted_Name {
+    INCALESCENT_File_NameInfo info;
+    WCHAR text[INCALESCENT_NAMEPOOL_MAX_NAME_LENGTH];
+} INCALESCENT_Sorted_Name;
+
+// Decodes the name at a position of a sorted name pool, returning it in a form
+// INCALESCENT_FILE_NAME_INFO works on.
+static PWSTR INCALESCENT_Sorted_NameAt(const INCALESCENT_NamePool *names, SIZE_T position, INCALESCENT_Sorted_Name *name) {
+    name->info.length = INCALESCENT_NamePool_Get(names, names->order[position], name->text, &name->info.size, &name->info.lastWriteTime);
+    return name->text;
+}
+
+// Appends a row for every data file that shows up in the directory until the watch is stopped.
+// Each batch of settled files is sorted before it is appended, but the table can only grow at the
+// end, so a file that sorts before rows that were already written still comes after them. The rows
+// go through the table like any other, so they are in its pyramid and statistics, which are written
+// once the watch has stopped.
+static HRESULT INCALESCENT_Sorted_WatchAndAppend(INCALESCENT_File_Session *session, PWSTR dataDirectory, INCALESCENT_Watch *watch,
+                                                 INCALESCENT_Table *table) {
+    HRESULT result = S_OK;
+    WCHAR filePathBuffer[INCALESCENT_FILE_FILTER_AGGREGATE_SIZE];
+    WCHAR joined[INCALESCENT_FILE_JOINED_VALUES_MAX_LENGTH];
+    INCALESCENT_File_Value values[INCALESCENT_FILE_MAX_FIELDS];
+    INCALESCENT_Arena *scratch = &session->scratch[0];
+
+    // The rows of the files that were already there are visible before the first new one arrives.
+    result = INCALESCENT_Writer_Flush(&table->writer);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Watching %s for new data files, press Ctrl+C to stop...", dataDirectory);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (;;) {
+        PWSTR *batch = NULL;
+        SIZE_T batchCount = 0;
+        result = INCALESCENT_Watch_Next(watch, &batch, &batchCount);
+        if (FAILED(result) || result == S_FALSE) {
+            break;
+        }
+
+        result = INCALESCENT_String_NaturalSort(batch, batchCount, scratch, session->pool);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        for (SIZE_T index = 0; index < batchCount; index++) {
+            result = StringCchPrintfW(filePathBuffer, INCALESCENT_FILE_FILTER_AGGREGATE_SIZE, L"%s\\%s", dataDirectory, batch[index]);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+
+            // A file that is still being written is given more time.
+            SIZE_T mark = INCALESCENT_Arena_Mark(scratch);
+            if (session->options.source == INCALESCENT_FILE_SOURCE_TIFF) {
+                result = INCALESCENT_File_ReadTiffFields(filePathBuffer, session->match, values);
+            } else {
+                result = INCALESCENT_File_ReadFields(filePathBuffer, session->match, scratch, values);
+            }
+            INCALESCENT_Arena_Reset(scratch, mark);
+            if (INCALESCENT_File_IsIncomplete(result) && INCALESCENT_Watch_Retry(watch, batch[index])) {
+                result = S_OK;
+                continue;
+            }
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+
+            result = INCALESCENT_Table_AppendRow(table, table->rowCount, NULL, 0, batch[index], lstrlenW(batch[index]), values, NULL);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+            if (table->statistics != NULL) {
+                INCALESCENT_File_AddStatistics(INCALESCENT_Table_SharedStatistics(table), values, NULL, session->fieldCount);
+            }
+
+            INCALESCENT_File_JoinValues(values, session->fieldCount, L',', joined);
+            result = INCALESCENT_LOG_DETAIL_FORMATTED_W(L"Appended %s, values discovered to be %s ...", batch[index], joined);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+
+        // Make the new rows visible right away.
+        result = INCALESCENT_Writer_Flush(&table->writer);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    if (result == S_FALSE) {
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Stopped watching after %llu rows...", (ULONGLONG) table->rowCount);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Sorted_Consolidate
+HRESULT INCALESCENT_Sorted_Consolidate(INCALESCENT_File_Session *session, PWSTR dataDirectory, PWSTR consolidatedFile, HANDLE file) {
+    HRESULT result = S_OK;
+    const INCALESCENT_File_Options *options = &session->options;
+    INCALESCENT_Arena *arena = &session->arena;
+    INCALESCENT_NamePool *names = &session->namePool;
+    INCALESCENT_Sorted_Name name;
+    INCALESCENT_File_Value *values = NULL;
+    DOUBLE *numbers = NULL;
+    DWORD fieldCount = session->fieldCount;
+    SIZE_T *indices = NULL;
+    INCALESCENT_Table table = {0};
+    INCALESCENT_Cache cache = {0};
+    INCALESCENT_Watch *watch = NULL;
+    HRESULT *failures = NULL;
+
+    // The watch starts collecting changes before the directory is enumerated, so no file that shows
+    // up in between can be missed.
+    if (options->watch) {
+        result = INCALESCENT_Watch_Create(dataDirectory, session->suffix, options->stopEvent, arena, &watch);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    result = INCALESCENT_File_FilteredNamesSorted(dataDirectory, session->suffix, options->cache, names, arena, session->pool);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    SIZE_T fileCount = names->count;
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Found %llu valid data files...", (ULONGLONG) fileCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    // A watched directory may well start out empty.
+    if (fileCount == 0 && !options->watch) {
+        result = INCALESCENT_ERROR_NO_DATA_FILES_FOUND;
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_File_Value) * fieldCount * fileCount, sizeof(WCHAR), (PVOID *) &values);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(SIZE_T) * fileCount, sizeof(SIZE_T), (PVOID *) &indices);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // A watched directory may have files in it that are still being written, which are left for the
+    // watch to append once they have settled, rather than failing the table.
+    if (watch != NULL) {
+        result = INCALESCENT_Arena_Allocate(arena, sizeof(HRESULT) * fileCount, sizeof(HRESULT), (PVOID *) &failures);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        ZeroMemory(failures, sizeof(HRESULT) * fileCount);
+    }
+
+    if (options->format == INCALESCENT_FILE_FORMAT_COLUMNAR) {
+        result = INCALESCENT_Arena_Allocate(arena, sizeof(DOUBLE) * fieldCount * fileCount, sizeof(DOUBLE), (PVOID *) &numbers);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    result = INCALESCENT_Table_CreateStatistics(&table, session);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // Take the value of every data file whose size and last write time haven't changed since the
+    // previous run from the cache. The enumeration already reported both, so only the files that
+    // are new or were modified have to be opened at all.
+    SIZE_T readCount = 0;
+    if (options->cache) {
+        ULONGLONG loading = INCALESCENT_Perf_Now();
+        result = INCALESCENT_Cache_Load(&cache, consolidatedFile, session->keys, session->keysSize, arena);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_CACHE, loading);
+    }
+    for (SIZE_T index = 0; index < fileCount; index++) {
+        if (!options->cache || !INCALESCENT_File_LookupValues(&cache, INCALESCENT_Sorted_NameAt(names, index, &name), fieldCount, values + (index * fieldCount))) {
+            indices[readCount] = index;
+            readCount++;
+            continue;
+        }
+
+        DOUBLE *fileNumbers = numbers == NULL ? NULL : numbers + (index * fieldCount);
+        if (fileNumbers != NULL) {
+            INCALESCENT_File_ParseValues(values + (index * fieldCount), fieldCount, fileNumbers);
+        }
+        if (table.statistics != NULL) {
+            INCALESCENT_File_AddStatistics(INCALESCENT_Table_SharedStatistics(&table), values + (index * fieldCount), fileNumbers, fieldCount);
+        }
+    }
+    INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_FILES_CACHED, fileCount - readCount);
+    if (options->cache) {
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Reusing %llu cached values, reading %llu data files...", (ULONGLONG) (fileCount - readCount),
+                                                  (ULONGLONG) readCount);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    // Read the remaining data files in parallel. The rows are only written afterward so that the
+    // table comes out in the same order as the sorted names regardless of which worker finished first.
+    INCALESCENT_File_ReadContext context = {
+            .dataDirectory = dataDirectory,
+            .namePool = names,
+            .values = values,
+            .match = session->match,
+            .fieldCount = fieldCount,
+            .io = session->io,
+            .numbers = numbers,
+            .statistics = table.statistics,
+            .hint = &session->readHint,
+            .indices = indices,
+            .tiff = options->source == INCALESCENT_FILE_SOURCE_TIFF,
+            .failures = failures,
+    };
+    result = INCALESCENT_File_ReadFiles(session, &context, readCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // Build the table in memory. The cache holds exactly the data files of this run, so files that
+    // were removed drop out of it as well.
+    result = INCALESCENT_Table_Begin(&table, session, consolidatedFile, file, fileCount, FALSE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (SIZE_T index = 0; index < fileCount; index++) {
+        PWSTR fileName = INCALESCENT_Sorted_NameAt(names, index, &name);
+        if (failures != NULL && FAILED(failures[index])) {
+            result = INCALESCENT_Watch_Hold(watch, fileName, INCALESCENT_FILE_NAME_INFO(fileName)->length);
+            if (SUCCEEDED(result)) {
+                result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Waiting for %s to be complete...", fileName);
+            }
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+            continue;
+        }
+
+        result = INCALESCENT_Table_AppendRow(&table, table.rowCount, NULL, 0, fileName, INCALESCENT_FILE_NAME_INFO(fileName)->length,
+                                             values + (index * fieldCount), numbers == NULL ? NULL : numbers + (index * fieldCount));
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+
+        if (options->cache) {
+            result = INCALESCENT_File_RecordValues(&cache, fileName, fieldCount, values + (index * fieldCount));
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+    }
+
+    // A watched table only ends once the watch has stopped, so that its pyramid and statistics
+    // cover the rows appended while watching as well.
+    if (watch != NULL) {
+        for (SIZE_T index = 0; index < fileCount; index++) {
+            if (FAILED(failures[index])) {
+                continue;
+            }
+            PWSTR fileName = INCALESCENT_Sorted_NameAt(names, index, &name);
+            result = INCALESCENT_Watch_MarkKnown(watch, fileName, INCALESCENT_FILE_NAME_INFO(fileName)->length);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+        result = INCALESCENT_Sorted_WatchAndAppend(session, dataDirectory, watch, &table);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    result = INCALESCENT_Table_End(&table, session, consolidatedFile, file, options->cache ? &cache : NULL, NULL, 0);
+
+    cleanup:
+    INCALESCENT_Table_Destroy(&table);
+    INCALESCENT_Watch_Destroy(watch);
+    INCALESCENT_Cache_Destroy(&cache);
+    return result;
+}
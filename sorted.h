@@ -0,0 +1,50 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_SORTED_H
+#define INCALESCENT_SORTED_H
+#include "file.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* HANDLE;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+
+/**
+ * @brief Consolidates the data files of a single directory, whose names are all sorted in memory.
+ *
+ * The values of unchanged data files are taken from the cache, the rest are read in parallel, and
+ * the rows are written in the order of the sorted names. If the session's options ask for it, the
+ * directory is watched afterward and a row is appended for every new data file.
+ *
+ * @param[in] session           The session.
+ * @param[in] dataDirectory     The directory holding the data files.
+ * @param[in] consolidatedFile  The path of the table.
+ * @param[in] file              The table's file, already created.
+ *
+ * @return The result of the consolidation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Sorted_Consolidate(INCALESCENT_File_Session *session, PWSTR dataDirectory, PWSTR consolidatedFile, HANDLE file);
+
+#endif //INCALESCENT_SORTED_H
@@ -0,0 +1,220 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <stdlib.h>
+#include <math.h>
+#include "stats.h"
+
+#define INCALESCENT_STATS_PI 3.14159265358979323846
+
+// The scale function of the digest, which maps a quantile to a scale where every centroid spans at
+// most 1. It is steepest at the extremes, which is where the centroids come out smallest.
+static DOUBLE INCALESCENT_Stats_Scale(DOUBLE quantile) {
+    return (INCALESCENT_STATS_COMPRESSION / (2.0 * INCALESCENT_STATS_PI)) * asin((2.0 * quantile) - 1.0);
+}
+
+static DOUBLE INCALESCENT_Stats_InverseScale(DOUBLE scale) {
+    if (scale >= INCALESCENT_STATS_COMPRESSION / 4.0) {
+        return 1.0;
+    }
+    return (sin(scale * (2.0 * INCALESCENT_STATS_PI) / INCALESCENT_STATS_COMPRESSION) + 1.0) / 2.0;
+}
+
+static int INCALESCENT_Stats_CompareCentroids(const void *left, const void *right) {
+    DOUBLE leftMean = ((const INCALESCENT_Stats_Centroid *) left)->mean;
+    DOUBLE rightMean = ((const INCALESCENT_Stats_Centroid *) right)->mean;
+    return (leftMean > rightMean) - (leftMean < rightMean);
+}
+
+// Merges the buffered values and any extra centroids into the centroids. Everything is sorted by
+// mean and then swept once, folding each centroid into the one before it for as long as that one
+// stays within a single step of the scale function.
+static void INCALESCENT_Stats_Compress(INCALESCENT_Stats *stats, const INCALESCENT_Stats_Centroid *extra, DWORD extraCount) {
+    INCALESCENT_Stats_Centroid incoming[INCALESCENT_STATS_BUFFER_SIZE + INCALESCENT_STATS_MAX_CENTROIDS];
+    INCALESCENT_Stats_Centroid sorted[INCALESCENT_STATS_BUFFER_SIZE + (2 * INCALESCENT_STATS_MAX_CENTROIDS)];
+    DWORD incomingCount = 0;
+    DOUBLE total = 0;
+
+    if (stats->bufferCount == 0 && extraCount == 0) {
+        return;
+    }
+
+    for (DWORD index = 0; index < stats->bufferCount; index++) {
+        incoming[incomingCount].mean = stats->buffer[index];
+        incoming[incomingCount].weight = 1.0;
+        incomingCount++;
+    }
+    for (DWORD index = 0; index < extraCount; index++) {
+        incoming[incomingCount++] = extra[index];
+    }
+    qsort(incoming, incomingCount, sizeof(INCALESCENT_Stats_Centroid), INCALESCENT_Stats_CompareCentroids);
+
+    // The centroids are sorted already, so the two only have to be merged.
+    DWORD sortedCount = 0;
+    DWORD existing = 0;
+    DWORD next = 0;
+    while (existing < stats->centroidCount || next < incomingCount) {
+        if (next == incomingCount || (existing < stats->centroidCount && stats->centroids[existing].mean <= incoming[next].mean)) {
+            sorted[sortedCount] = stats->centroids[existing++];
+        } else {
+            sorted[sortedCount] = incoming[next++];
+        }
+        total += sorted[sortedCount].weight;
+        sortedCount++;
+    }
+
+    DWORD last = 0;
+    DOUBLE weightSoFar = 0;
+    DOUBLE limit = total * INCALESCENT_Stats_InverseScale(INCALESCENT_Stats_Scale(0.0) + 1.0);
+    stats->centroids[0] = sorted[0];
+    for (DWORD index = 1; index < sortedCount; index++) {
+        INCALESCENT_Stats_Centroid *current = &stats->centroids[last];
+
+        // The scale function never allows more centroids than there is room for, but rounding
+        // mustn't be able to overrun them either.
+        if (weightSoFar + current->weight + sorted[index].weight <= limit || last + 1 == INCALESCENT_STATS_MAX_CENTROIDS) {
+            current->weight += sorted[index].weight;
+            current->mean += (sorted[index].mean - current->mean) * sorted[index].weight / current->weight;
+            continue;
+        }
+
+        weightSoFar += current->weight;
+        limit = total * INCALESCENT_Stats_InverseScale(INCALESCENT_Stats_Scale(weightSoFar / total) + 1.0);
+        last++;
+        stats->centroids[last] = sorted[index];
+    }
+    stats->centroidCount = last + 1;
+    stats->bufferCount = 0;
+}
+
+// Implementation for INCALESCENT_Stats_Reset
+void INCALESCENT_Stats_Reset(INCALESCENT_Stats *stats) {
+    stats->count = 0;
+    stats->mean = 0;
+    stats->m2 = 0;
+    stats->minimum = 0;
+    stats->maximum = 0;
+    stats->centroidCount = 0;
+    stats->bufferCount = 0;
+}
+
+// Implementation for INCALESCENT_Stats_Add
+void INCALESCENT_Stats_Add(INCALESCENT_Stats *stats, DOUBLE value) {
+    if (!isfinite(value)) {
+        return;
+    }
+
+    stats->count++;
+    DOUBLE delta = value - stats->mean;
+    stats->mean += delta / (DOUBLE) stats->count;
+    stats->m2 += delta * (value - stats->mean);
+    if (stats->count == 1 || value < stats->minimum) {
+        stats->minimum = value;
+    }
+    if (stats->count == 1 || value > stats->maximum) {
+        stats->maximum = value;
+    }
+
+    stats->buffer[stats->bufferCount++] = value;
+    if (stats->bufferCount == INCALESCENT_STATS_BUFFER_SIZE) {
+        INCALESCENT_Stats_Compress(stats, NULL, 0);
+    }
+}
+
+// Implementation for INCALESCENT_Stats_Merge
+void INCALESCENT_Stats_Merge(INCALESCENT_Stats *into, INCALESCENT_Stats *from) {
+    if (from->count == 0) {
+        return;
+    }
+
+    // The mean and variance of the union follow from those of both halves (Chan et al.).
+    if (into->count == 0) {
+        into->mean = from->mean;
+        into->m2 = from->m2;
+        into->minimum = from->minimum;
+        into->maximum = from->maximum;
+    } else {
+        DOUBLE count = (DOUBLE) (into->count + from->count);
+        DOUBLE delta = from->mean - into->mean;
+        into->mean += delta * (DOUBLE) from->count / count;
+        into->m2 += from->m2 + (delta * delta * (DOUBLE) into->count * (DOUBLE) from->count / count);
+        if (from->minimum < into->minimum) {
+            into->minimum = from->minimum;
+        }
+        if (from->maximum > into->maximum) {
+            into->maximum = from->maximum;
+        }
+    }
+    into->count += from->count;
+
+    INCALESCENT_Stats_Compress(from, NULL, 0);
+    INCALESCENT_Stats_Compress(into, from->centroids, from->centroidCount);
+}
+
+// Implementation for INCALESCENT_Stats_StandardDeviation
+DOUBLE INCALESCENT_Stats_StandardDeviation(const INCALESCENT_Stats *stats) {
+    if (stats->count < 2) {
+        return 0;
+    }
+    return sqrt(stats->m2 / (DOUBLE) (stats->count - 1));
+}
+
+// Implementation for INCALESCENT_Stats_Quantile
+DOUBLE INCALESCENT_Stats_Quantile(INCALESCENT_Stats *stats, DOUBLE quantile) {
+    INCALESCENT_Stats_Compress(stats, NULL, 0);
+
+    if (stats->count == 0) {
+        return NAN;
+    }
+    if (quantile <= 0) {
+        return stats->minimum;
+    }
+    if (quantile >= 1) {
+        return stats->maximum;
+    }
+
+    // Every centroid stands for its weight spread evenly around its mean, so the position of the
+    // quantile is interpolated between the middles of the centroids on either side of it.
+    const INCALESCENT_Stats_Centroid *centroids = stats->centroids;
+    DWORD last = stats->centroidCount - 1;
+    DOUBLE position = quantile * (DOUBLE) stats->count;
+    DOUBLE weightSoFar = centroids[0].weight / 2.0;
+    if (position < weightSoFar) {
+        return stats->minimum + ((centroids[0].mean - stats->minimum) * (position / weightSoFar));
+    }
+
+    for (DWORD index = 0; index < last; index++) {
+        DOUBLE step = (centroids[index].weight + centroids[index + 1].weight) / 2.0;
+        if (position < weightSoFar + step) {
+            return centroids[index].mean + ((centroids[index + 1].mean - centroids[index].mean) * ((position - weightSoFar) / step));
+        }
+        weightSoFar += step;
+    }
+
+    DOUBLE fraction = (position - weightSoFar) / (centroids[last].weight / 2.0);
+    if (fraction > 1.0) {
+        fraction = 1.0;
+    }
+    return centroids[last].mean + ((stats->maximum - centroids[last].mean) * fraction);
+}
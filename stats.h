@@ -0,0 +1,90 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_STATS_H
+#define INCALESCENT_STATS_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef double DOUBLE;
+typedef unsigned __int64 ULONGLONG;
+
+// How finely the digest resolves quantiles. It keeps about this many centroids, which are
+// smallest near the extremes, so the tails are resolved far better than the middle.
+#define INCALESCENT_STATS_COMPRESSION 100
+#define INCALESCENT_STATS_MAX_CENTROIDS (2 * INCALESCENT_STATS_COMPRESSION)
+
+// Values are collected in a buffer and only merged into the centroids once it is full.
+#define INCALESCENT_STATS_BUFFER_SIZE (5 * INCALESCENT_STATS_COMPRESSION)
+
+typedef struct INCALESCENT_Stats_Centroid {
+    DOUBLE mean;
+    DOUBLE weight;
+} INCALESCENT_Stats_Centroid;
+
+/**
+ * @brief Statistics of a stream of values, computed in a single pass in constant memory.
+ *
+ * The mean and variance are kept with Welford's method, which doesn't lose precision to
+ * cancellation the way a sum of squares does. Quantiles come from a merging t-digest. Both can be
+ * merged, so every thread can keep statistics of its own and combine them at the end.
+ */
+typedef struct INCALESCENT_Stats {
+    ULONGLONG count;
+    DOUBLE mean;
+    DOUBLE m2;
+    DOUBLE minimum;
+    DOUBLE maximum;
+
+    // The centroids, sorted by mean, and the values not merged into them yet.
+    INCALESCENT_Stats_Centroid centroids[INCALESCENT_STATS_MAX_CENTROIDS];
+    DWORD centroidCount;
+    DOUBLE buffer[INCALESCENT_STATS_BUFFER_SIZE];
+    DWORD bufferCount;
+} INCALESCENT_Stats;
+
+void INCALESCENT_Stats_Reset(INCALESCENT_Stats *stats);
+
+// Adds a value. Values that aren't finite numbers are left out.
+void INCALESCENT_Stats_Add(INCALESCENT_Stats *stats, DOUBLE value);
+
+// Adds every value of from to into. From is compressed along the way but otherwise unchanged.
+void INCALESCENT_Stats_Merge(INCALESCENT_Stats *into, INCALESCENT_Stats *from);
+
+// The sample standard deviation, or 0 for fewer than two values.
+DOUBLE INCALESCENT_Stats_StandardDeviation(const INCALESCENT_Stats *stats);
+
+/**
+ * @brief Estimates a quantile.
+ *
+ * The estimate interpolates between the centroids around the quantile, and between the outermost
+ * centroids and the exact minimum and maximum.
+ *
+ * @param[in,out] stats     The statistics. Any buffered values are merged first.
+ * @param[in] quantile      The quantile, from 0 to 1.
+ *
+ * @return The estimate, or NaN if there are no values.
+ */
+DOUBLE INCALESCENT_Stats_Quantile(INCALESCENT_Stats *stats, DOUBLE quantile);
+
+#endif //INCALESCENT_STATS_H
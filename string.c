@@ -24,57 +24,387 @@
 #include <windows.h>
 #include "string.h"
 
+typedef struct INCALESCENT_String_SortEntry {
+    PBYTE key;
+    SIZE_T keyLength;
+    SIZE_T index;
+} INCALESCENT_String_SortEntry;
 
-// Implementation of INCALESCENT_String_BubbleSort
-HRESULT INCALESCENT_String_BubbleSort(PBYTE buffer, SIZE_T count) {
-    HRESULT result = S_OK;
+typedef struct INCALESCENT_String_SortContext {
+    INCALESCENT_String_SortEntry *entries;
+    INCALESCENT_String_SortEntry *scratch;
+    SIZE_T count;
+    SIZE_T runLength;
+    INCALESCENT_String_Source source;
+    PVOID sourceContext;
+} INCALESCENT_String_SortContext;
 
-    PWSTR *mappedHeader = (PWSTR *) buffer;
-
-    for (SIZE_T indexOuter = 0; indexOuter < (count - 1); indexOuter++) {
-        BOOL swapPerformed = FALSE;
-
-        for (SIZE_T indexInner = 0; indexInner < (count - indexOuter - 1); indexInner++) {
-            PWSTR firstString = *(mappedHeader + indexInner);
-            PWSTR secondString = *(mappedHeader + indexInner + 1);
-
-            // Obtain the comparison result between the first and the second string.
-            // The length fields for both strings are set to "-1" so that the comparison function
-            // will use their terminating characters. It is expected that the strings were validated by
-            // the callee of this function.
-            INT comparison = CompareStringW(
-                    LOCALE_USER_DEFAULT,
-                    LINGUISTIC_IGNORECASE | SORT_DIGITSASNUMBERS,
-                    firstString,
-                    -1,
-                    secondString,
-                    -1
-            );
-
-            // If the comparison is less than zero, the strings should be swapped so that the one with greater
-            // alphanumeric significance comes first.
-            if (comparison == CSTR_GREATER_THAN) {
-                *(mappedHeader + indexInner) = secondString;
-                *(mappedHeader + indexInner + 1) = firstString;
-                swapPerformed = TRUE;
-                continue;
-            }
+// Implementation for INCALESCENT_String_CompareKeys
+INT INCALESCENT_String_CompareKeys(const BYTE *first, SIZE_T firstLength, const BYTE *second, SIZE_T secondLength) {
+    SIZE_T length = firstLength < secondLength ? firstLength : secondLength;
+    INT comparison = memcmp(first, second, length);
+    if (comparison != 0) {
+        return comparison;
+    }
+    return (firstLength > secondLength) - (firstLength < secondLength);
+}
+
+// Orders two entries by their sort keys.
+static INT INCALESCENT_String_CompareEntries(const INCALESCENT_String_SortEntry *first, const INCALESCENT_String_SortEntry *second) {
+    return INCALESCENT_String_CompareKeys(first->key, first->keyLength, second->key, second->keyLength);
+}
+
+// Stable merge of the sorted ranges source[begin, middle) and source[middle, end) into destination[begin, end).
+static void INCALESCENT_String_Merge(const INCALESCENT_String_SortEntry *source, INCALESCENT_String_SortEntry *destination,
+                                     SIZE_T begin, SIZE_T middle, SIZE_T end) {
+    SIZE_T left = begin;
+    SIZE_T right = middle;
+    SIZE_T output = begin;
+
+    while (left < middle && right < end) {
+        // Taking from the left side on ties keeps the merge stable.
+        if (INCALESCENT_String_CompareEntries(&source[right], &source[left]) < 0) {
+            destination[output++] = source[right++];
+        } else {
+            destination[output++] = source[left++];
+        }
+    }
+    while (left < middle) {
+        destination[output++] = source[left++];
+    }
+    while (right < end) {
+        destination[output++] = source[right++];
+    }
+}
 
-            // If the comparison result is equal to zero, that means there was an error, and it
-            // should consequently be returned.
-            if (comparison == 0) {
-                result = HRESULT_FROM_WIN32(GetLastError());
-                goto cleanup;
+// Sorts entries[begin, end) using scratch[begin, end) as the merge target. The sorted result always
+// ends up back in entries.
+static void INCALESCENT_String_MergeSortRange(INCALESCENT_String_SortEntry *entries, INCALESCENT_String_SortEntry *scratch,
+                                              SIZE_T begin, SIZE_T end) {
+    // Insertion sort short blocks first, merging is only worth it past that size.
+    for (SIZE_T blockBegin = begin; blockBegin < end; blockBegin += INCALESCENT_STRING_SORT_INSERTION_LENGTH) {
+        SIZE_T blockEnd = blockBegin + INCALESCENT_STRING_SORT_INSERTION_LENGTH;
+        if (blockEnd > end) {
+            blockEnd = end;
+        }
+
+        for (SIZE_T index = blockBegin + 1; index < blockEnd; index++) {
+            INCALESCENT_String_SortEntry entry = entries[index];
+            SIZE_T position = index;
+            while (position > blockBegin && INCALESCENT_String_CompareEntries(&entry, &entries[position - 1]) < 0) {
+                entries[position] = entries[position - 1];
+                position--;
             }
+            entries[position] = entry;
+        }
+    }
+
+    INCALESCENT_String_SortEntry *source = entries;
+    INCALESCENT_String_SortEntry *destination = scratch;
+    for (SIZE_T width = INCALESCENT_STRING_SORT_INSERTION_LENGTH; width < (end - begin); width *= 2) {
+        for (SIZE_T left = begin; left < end; left += 2 * width) {
+            SIZE_T middle = left + width < end ? left + width : end;
+            SIZE_T right = left + (2 * width) < end ? left + (2 * width) : end;
+            INCALESCENT_String_Merge(source, destination, left, middle, right);
+        }
+
+        INCALESCENT_String_SortEntry *swap = source;
+        source = destination;
+        destination = swap;
+    }
+
+    if (source != entries) {
+        CopyMemory(entries + begin, source + begin, sizeof(INCALESCENT_String_SortEntry) * (end - begin));
+    }
+}
+
+// Measures the sort key of every string in [begin, end).
+static HRESULT INCALESCENT_String_MeasureKeys(PVOID parameter, DWORD worker, SIZE_T begin, SIZE_T end) {
+    UNREFERENCED_PARAMETER(worker);
+
+    INCALESCENT_String_SortContext *context = parameter;
+    WCHAR buffer[INCALESCENT_STRING_SOURCE_BUFFER_LENGTH];
+    for (SIZE_T index = begin; index < end; index++) {
+        INCALESCENT_String_SortEntry *entry = &context->entries[index];
+        INT keyLength = LCMapStringEx(
+                LOCALE_NAME_USER_DEFAULT,
+                LCMAP_SORTKEY | INCALESCENT_STRING_SORT_FLAGS,
+                context->source(context->sourceContext, entry->index, buffer),
+                -1,
+                NULL,
+                0,
+                NULL,
+                NULL,
+                0
+        );
+        if (keyLength == 0) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        entry->keyLength = keyLength;
+    }
+
+    return S_OK;
+}
+
+// Writes the sort key of every string in [begin, end) into the space reserved for it.
+static HRESULT INCALESCENT_String_MapKeys(PVOID parameter, DWORD worker, SIZE_T begin, SIZE_T end) {
+    UNREFERENCED_PARAMETER(worker);
+
+    INCALESCENT_String_SortContext *context = parameter;
+    WCHAR buffer[INCALESCENT_STRING_SOURCE_BUFFER_LENGTH];
+    for (SIZE_T index = begin; index < end; index++) {
+        INCALESCENT_String_SortEntry *entry = &context->entries[index];
+
+        // With LCMAP_SORTKEY the destination is a byte buffer and its size is given in bytes.
+        INT keyLength = LCMapStringEx(
+                LOCALE_NAME_USER_DEFAULT,
+                LCMAP_SORTKEY | INCALESCENT_STRING_SORT_FLAGS,
+                context->source(context->sourceContext, entry->index, buffer),
+                -1,
+                (LPWSTR) entry->key,
+                (INT) entry->keyLength,
+                NULL,
+                NULL,
+                0
+        );
+        if (keyLength == 0) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+    }
+
+    return S_OK;
+}
+
+// Sorts each of the runs in [begin, end) independently.
+static HRESULT INCALESCENT_String_SortRuns(PVOID parameter, DWORD worker, SIZE_T begin, SIZE_T end) {
+    UNREFERENCED_PARAMETER(worker);
+
+    INCALESCENT_String_SortContext *context = parameter;
+    for (SIZE_T run = begin; run < end; run++) {
+        SIZE_T runBegin = run * context->runLength;
+        SIZE_T runEnd = runBegin + context->runLength < context->count ? runBegin + context->runLength : context->count;
+        INCALESCENT_String_MergeSortRange(context->entries, context->scratch, runBegin, runEnd);
+    }
+
+    return S_OK;
+}
+
+// Merges each of the run pairs in [begin, end) from the entries into the scratch space.
+static HRESULT INCALESCENT_String_MergeRuns(PVOID parameter, DWORD worker, SIZE_T begin, SIZE_T end) {
+    UNREFERENCED_PARAMETER(worker);
+
+    INCALESCENT_String_SortContext *context = parameter;
+    for (SIZE_T pair = begin; pair < end; pair++) {
+        SIZE_T left = pair * 2 * context->runLength;
+        SIZE_T middle = left + context->runLength < context->count ? left + context->runLength : context->count;
+        SIZE_T right = middle + context->runLength < context->count ? middle + context->runLength : context->count;
+        INCALESCENT_String_Merge(context->entries, context->scratch, left, middle, right);
+    }
+
+    return S_OK;
+}
+
+// Runs a callback over [0, count) on the pool, or on the calling thread when there is no pool.
+static HRESULT INCALESCENT_String_Run(INCALESCENT_Pool *pool, SIZE_T count, SIZE_T chunkSize,
+                                      INCALESCENT_Pool_Callback callback, PVOID context) {
+    if (pool == NULL) {
+        return callback(context, 0, 0, count);
+    }
+    return INCALESCENT_Pool_Run(pool, count, chunkSize, callback, context);
+}
+
+// Sorts the strings of a source by their sort keys, leaving the sorted entries in *sorted. Everything
+// is allocated from the arena, which the caller resets once it has taken the order.
+static HRESULT INCALESCENT_String_SortEntries(SIZE_T count, INCALESCENT_String_Source source, PVOID sourceContext, INCALESCENT_Arena *arena,
+                                              INCALESCENT_Pool *pool, INCALESCENT_String_SortEntry **sorted) {
+    HRESULT result = S_OK;
+    INCALESCENT_String_SortEntry *entries = NULL;
+    INCALESCENT_String_SortEntry *scratch = NULL;
+    PBYTE keys = NULL;
+
+    // Small buffers aren't worth waking the workers for.
+    if (count < INCALESCENT_STRING_SORT_PARALLEL_THRESHOLD) {
+        pool = NULL;
+    }
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_String_SortEntry) * count,
+                                        INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &entries);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_String_SortEntry) * count,
+                                        INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &scratch);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    for (SIZE_T index = 0; index < count; index++) {
+        entries[index].index = index;
+    }
+
+    INCALESCENT_String_SortContext context = {
+            .entries = entries,
+            .scratch = scratch,
+            .count = count,
+            .source = source,
+            .sourceContext = sourceContext,
+    };
+
+    // Map every string into its sort key exactly once. The keys compare with a plain byte comparison,
+    // which is far cheaper than running the linguistic comparison on every step of the sort.
+    result = INCALESCENT_String_Run(pool, count, INCALESCENT_POOL_DEFAULT_CHUNK_SIZE, INCALESCENT_String_MeasureKeys, &context);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    SIZE_T keysSize = 0;
+    for (SIZE_T index = 0; index < count; index++) {
+        keysSize += entries[index].keyLength;
+    }
+    result = INCALESCENT_Arena_Allocate(arena, keysSize, 1, (PVOID *) &keys);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    PBYTE nextKey = keys;
+    for (SIZE_T index = 0; index < count; index++) {
+        entries[index].key = nextKey;
+        nextKey += entries[index].keyLength;
+    }
+
+    result = INCALESCENT_String_Run(pool, count, INCALESCENT_POOL_DEFAULT_CHUNK_SIZE, INCALESCENT_String_MapKeys, &context);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // Sort one run per worker, then merge pairs of runs until a single run is left.
+    SIZE_T runCount = pool == NULL ? 1 : INCALESCENT_Pool_WorkerCount(pool);
+    context.runLength = (count + runCount - 1) / runCount;
+    result = INCALESCENT_String_Run(pool, runCount, 1, INCALESCENT_String_SortRuns, &context);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    while (context.runLength < count) {
+        SIZE_T pairCount = (count + (2 * context.runLength) - 1) / (2 * context.runLength);
+        result = INCALESCENT_String_Run(pool, pairCount, 1, INCALESCENT_String_MergeRuns, &context);
+        if (FAILED(result)) {
+            goto cleanup;
         }
 
-        // If a swap wasn't performed, then the strings have already been sorted.
-        if (!swapPerformed) {
-            break;
+        INCALESCENT_String_SortEntry *swap = context.entries;
+        context.entries = context.scratch;
+        context.scratch = swap;
+        context.runLength *= 2;
+    }
+    *sorted = context.entries;
+
+    cleanup:
+    return result;
+}
+
+// Gives the strings of an array as they are.
+static PCWSTR INCALESCENT_String_ArraySource(PVOID context, SIZE_T index, PWSTR buffer) {
+    UNREFERENCED_PARAMETER(buffer);
+    return ((PWSTR *) context)[index];
+}
+
+// Implementation of INCALESCENT_String_NaturalSort
+HRESULT INCALESCENT_String_NaturalSort(PWSTR *strings, SIZE_T count, INCALESCENT_Arena *arena, INCALESCENT_Pool *pool) {
+    HRESULT result = S_OK;
+    SIZE_T arenaMark = INCALESCENT_Arena_Mark(arena);
+    INCALESCENT_String_SortEntry *sorted = NULL;
+    PWSTR *original = NULL;
+
+    if (count < 2) {
+        goto cleanup;
+    }
+
+    // The strings are taken from a copy of the array, so they can be put back in sorted order.
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(PWSTR) * count, sizeof(PWSTR), (PVOID *) &original);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    CopyMemory(original, strings, sizeof(PWSTR) * count);
+
+    result = INCALESCENT_String_SortEntries(count, INCALESCENT_String_ArraySource, original, arena, pool, &sorted);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    for (SIZE_T index = 0; index < count; index++) {
+        strings[index] = original[sorted[index].index];
+    }
+
+    cleanup:
+    INCALESCENT_Arena_Reset(arena, arenaMark);
+
+    return result;
+}
+
+// Implementation for INCALESCENT_String_NaturalOrder
+HRESULT INCALESCENT_String_NaturalOrder(SIZE_T count, INCALESCENT_String_Source source, PVOID context, DWORD *order, INCALESCENT_Arena *arena,
+                                        INCALESCENT_Pool *pool) {
+    HRESULT result = S_OK;
+    SIZE_T arenaMark = INCALESCENT_Arena_Mark(arena);
+    INCALESCENT_String_SortEntry *sorted = NULL;
+
+    if (count < 2) {
+        if (count == 1) {
+            order[0] = 0;
         }
+        goto cleanup;
+    }
+
+    result = INCALESCENT_String_SortEntries(count, source, context, arena, pool, &sorted);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    for (SIZE_T index = 0; index < count; index++) {
+        order[index] = (DWORD) sorted[index].index;
     }
 
     cleanup:
+    INCALESCENT_Arena_Reset(arena, arenaMark);
 
     return result;
 }
+
+// Implementation for INCALESCENT_String_SortSize
+HRESULT INCALESCENT_String_SortSize(PCWSTR string, SIZE_T *size) {
+    INT keyLength = LCMapStringEx(
+            LOCALE_NAME_USER_DEFAULT,
+            LCMAP_SORTKEY | INCALESCENT_STRING_SORT_FLAGS,
+            string,
+            -1,
+            NULL,
+            0,
+            NULL,
+            NULL,
+            0
+    );
+    if (keyLength == 0) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    // The copy of the array takes a pointer, and the entries and their scratch space an entry each.
+    *size = sizeof(PWSTR) + (2 * sizeof(INCALESCENT_String_SortEntry)) + keyLength;
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_String_SortKey
+HRESULT INCALESCENT_String_SortKey(PCWSTR string, BYTE *key, SIZE_T *keyLength) {
+    INT length = LCMapStringEx(
+            LOCALE_NAME_USER_DEFAULT,
+            LCMAP_SORTKEY | INCALESCENT_STRING_SORT_FLAGS,
+            string,
+            -1,
+            (LPWSTR) key,
+            INCALESCENT_STRING_SORT_KEY_MAX_SIZE,
+            NULL,
+            NULL,
+            0
+    );
+    if (length == 0) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    *keyLength = length;
+    return S_OK;
+}
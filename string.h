@@ -23,30 +23,111 @@
  */
 #ifndef INCALESCENT_STRING_H
 #define INCALESCENT_STRING_H
+#include "pool.h"
+#include "arena.h"
+#include "platform.h"
 
 #define INCALESCENT_STRING_LENGTH(string) ((sizeof(string) / sizeof((string)[0])) - 1)
 
 // Forward declarations from <windows.h>
-typedef long HRESULT;
-typedef unsigned char* PBYTE;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
 typedef unsigned __int64 SIZE_T;
+typedef unsigned char BYTE;
+typedef int INT;
+typedef const WCHAR* PCWSTR;
+typedef void* PVOID;
+
+#define INCALESCENT_STRING_SORT_FLAGS (LINGUISTIC_IGNORECASE | SORT_DIGITSASNUMBERS)
+#define INCALESCENT_STRING_SORT_INSERTION_LENGTH 16
+#define INCALESCENT_STRING_SORT_PARALLEL_THRESHOLD 8192
+
+// The largest sort key of a file name. Every character maps to a few bytes at most on each level of
+// the key.
+#define INCALESCENT_STRING_SORT_KEY_MAX_SIZE 4096
+
+// The padding INCALESCENT_String_NaturalSort may add to aligning what it allocates, on top of what
+// INCALESCENT_String_SortSize gives for its strings.
+#define INCALESCENT_STRING_SORT_SLACK (3 * INCALESCENT_ARENA_DEFAULT_ALIGNMENT)
+
+// The characters of the buffer a string source may decode a string into, including its
+// null-terminating character.
+#define INCALESCENT_STRING_SOURCE_BUFFER_LENGTH 260
+
+// Gives the string at index of a collection that isn't an array of strings. A string that isn't
+// stored as it is can be decoded into the buffer, which is only reused once the string has been
+// mapped into its sort key. It is called from the workers of the pool concurrently.
+typedef PCWSTR (*INCALESCENT_String_Source)(PVOID context, SIZE_T index, PWSTR buffer);
 
 /**
- * @brief Sorts a string buffer alphanumerically.
+ * @brief Sorts an array of strings alphanumerically.
  *
- * This function will sort a specialized string buffer alphanumerically such that a smaller
+ * This function will sort an array of strings alphanumerically such that a smaller
  * number will take precedence over a larger one. This is to ensure that data file names are
  * written to the resultant table in the order that they were created.
  *
- * @param[in] buffer    The string buffer. The first count * sizeof(PWSTR) bytes contain pointers
- *                      to each string within the buffer. This allows for quick manipulation of
- *                      which string each pointer points to during the sort operation. All strings
- *                      must be NULL-terminated so the function knows when they end and the next
- *                      one begins.
- * @param[in] count     The number of strings in the buffer.
+ * Every string is mapped once into a binary sort key that orders exactly like
+ * CompareStringW(LINGUISTIC_IGNORECASE | SORT_DIGITSASNUMBERS), and the keys are then
+ * merge sorted. The sort is stable, so strings that compare equal keep their original order.
+ * Above INCALESCENT_STRING_SORT_PARALLEL_THRESHOLD strings the key mapping, the sorting of
+ * runs and the merging of runs are spread over the workers of the pool.
+ *
+ * @param[in] strings   The array of string pointers. Only the pointers are reordered, the strings
+ *                      themselves never move. All strings must be NULL-terminated so the function
+ *                      knows where they end.
+ * @param[in] count     The number of strings in the array.
+ * @param[in] arena     The arena the sort keys and merge space are allocated from. Everything
+ *                      allocated is released again before the function returns.
+ * @param[in] pool      The pool used to sort large arrays in parallel. May be NULL, in which
+ *                      case the sort runs on the calling thread.
+ *
+ * @return The result of the sort operation (S_OK if successful).
+ */
+HRESULT INCALESCENT_String_NaturalSort(PWSTR *strings, SIZE_T count, INCALESCENT_Arena *arena, INCALESCENT_Pool *pool);
+
+/**
+ * @brief Works out the order INCALESCENT_String_NaturalSort would sort a collection of strings in,
+ *        without needing them as an array.
+ *
+ * @param[in] count     The number of strings, which must fit into a DWORD.
+ * @param[in] source    Gives every string, twice over the course of the sort.
+ * @param[in] context   The context of the source.
+ * @param[out] order    Receives the index of every string in sorted order.
+ * @param[in] arena     The arena the sort keys and merge space are allocated from. Everything
+ *                      allocated is released again before the function returns.
+ * @param[in] pool      The pool used to sort large collections in parallel, or NULL.
  *
  * @return The result of the sort operation (S_OK if successful).
  */
-HRESULT INCALESCENT_String_BubbleSort(PBYTE buffer, SIZE_T count);
+HRESULT INCALESCENT_String_NaturalOrder(SIZE_T count, INCALESCENT_String_Source source, PVOID context, DWORD *order, INCALESCENT_Arena *arena,
+                                        INCALESCENT_Pool *pool);
+
+/**
+ * @brief Measures the memory INCALESCENT_String_NaturalSort takes for a string: its place in the
+ *        copy of the array and in the sort entries, and its sort key.
+ *
+ * @param[in] string    The NULL-terminated string.
+ * @param[out] size     Receives the number of bytes.
+ *
+ * @return The result of measuring the key (S_OK if successful).
+ */
+HRESULT INCALESCENT_String_SortSize(PCWSTR string, SIZE_T *size);
+
+/**
+ * @brief Maps a string into the sort key INCALESCENT_String_NaturalSort orders it by.
+ *
+ * Strings that were sorted apart, such as the runs of an external sort, can be merged by comparing
+ * their keys with INCALESCENT_String_CompareKeys.
+ *
+ * @param[in] string        The NULL-terminated string.
+ * @param[out] key          Receives the key. Must hold INCALESCENT_STRING_SORT_KEY_MAX_SIZE bytes.
+ * @param[out] keyLength    Receives the number of bytes of the key.
+ *
+ * @return The result of the mapping (S_OK if successful).
+ */
+HRESULT INCALESCENT_String_SortKey(PCWSTR string, BYTE *key, SIZE_T *keyLength);
+
+// Orders two sort keys. A key that is a prefix of the other sorts first.
+INT INCALESCENT_String_CompareKeys(const BYTE *first, SIZE_T firstLength, const BYTE *second, SIZE_T secondLength);
 
 #endif //INCALESCENT_STRING_H
@@ -0,0 +1,367 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include "table.h"
+#include "log.h"
+#include "pool.h"
+#include "perf.h"
+
+// Writes the header of the table, the given columns followed by a column for every field.
+static HRESULT INCALESCENT_Table_WriteHeader(INCALESCENT_Writer *writer, PCSTR columns, SIZE_T columnsLength, const INCALESCENT_File_Session *session) {
+    SIZE_T columnLengths[INCALESCENT_FILE_MAX_FIELDS];
+    SIZE_T length = columnsLength + 2;
+    for (DWORD field = 0; field < session->fieldCount; field++) {
+        columnLengths[field] = lstrlenW(session->columns[field]);
+        length += 1 + columnLengths[field];
+    }
+
+    HRESULT result = INCALESCENT_Writer_Reserve(writer, INCALESCENT_WRITER_MAX_BYTES_PER_UNIT * length);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    INCALESCENT_Writer_AppendAscii(writer, columns, columnsLength);
+    for (DWORD field = 0; field < session->fieldCount; field++) {
+        INCALESCENT_Writer_AppendAscii(writer, ",", 1);
+        INCALESCENT_Writer_AppendString(writer, session->columns[field], columnLengths[field]);
+    }
+    INCALESCENT_Writer_AppendAscii(writer, "\r\n", 2);
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Table_IsCompressed
+BOOL INCALESCENT_Table_IsCompressed(PCWSTR consolidatedFile) {
+    SIZE_T length = lstrlenW(consolidatedFile);
+    SIZE_T extensionLength = INCALESCENT_STRING_LENGTH(INCALESCENT_GZIP_EXTENSION);
+    return length > extensionLength &&
+           CompareStringOrdinal(consolidatedFile + (length - extensionLength), (INT) extensionLength, INCALESCENT_GZIP_EXTENSION,
+                                (INT) extensionLength, TRUE) == CSTR_EQUAL;
+}
+
+// Implementation for INCALESCENT_Table_Begin
+HRESULT INCALESCENT_Table_Begin(INCALESCENT_Table *table, INCALESCENT_File_Session *session, PCWSTR consolidatedFile, HANDLE file,
+                                SIZE_T rowCount, BOOL hasDirectories) {
+    HRESULT result = S_OK;
+
+    table->format = session->options.format;
+    table->fieldCount = session->fieldCount;
+    table->started = INCALESCENT_Perf_Now();
+    table->rowCount = 0;
+    if (session->options.pyramid) {
+        result = INCALESCENT_Pyramid_Create(&table->pyramid, consolidatedFile, session->columns, session->fieldCount, session->options.encoding,
+                                            &session->arena);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        table->hasPyramid = TRUE;
+    }
+
+    if (table->format == INCALESCENT_FILE_FORMAT_COLUMNAR) {
+        result = INCALESCENT_Columnar_Create(&table->columnar, &session->arena, rowCount, hasDirectories, session->columns, session->fieldCount);
+        goto cleanup;
+    }
+
+    if (INCALESCENT_Table_IsCompressed(consolidatedFile)) {
+        result = INCALESCENT_Writer_CreateCompressed(&table->writer, file, session->options.encoding, &session->arena);
+    } else {
+        result = INCALESCENT_Writer_Create(&table->writer, file, session->options.encoding, &session->arena);
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    if (hasDirectories) {
+        result = INCALESCENT_Table_WriteHeader(&table->writer, INCALESCENT_TABLE_TREE_HEADER_STRING, INCALESCENT_TABLE_TREE_HEADER_STRING_LENGTH, session);
+    } else {
+        result = INCALESCENT_Table_WriteHeader(&table->writer, INCALESCENT_TABLE_HEADER_STRING, INCALESCENT_TABLE_HEADER_STRING_LENGTH, session);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Table_AppendRow
+HRESULT INCALESCENT_Table_AppendRow(INCALESCENT_Table *table, SIZE_T index, PWSTR directory, SIZE_T directoryLength, PWSTR fileName,
+                                    SIZE_T fileNameLength, const INCALESCENT_File_Value *values, const DOUBLE *numbers) {
+    HRESULT result = S_OK;
+
+    table->rowCount++;
+    if (table->format == INCALESCENT_FILE_FORMAT_COLUMNAR) {
+        result = INCALESCENT_Columnar_AppendRow(&table->columnar, directory, directoryLength, fileName, fileNameLength, numbers);
+    } else {
+        result = INCALESCENT_File_WriteRow(&table->writer, index, directory, directoryLength, fileName, fileNameLength, values, table->fieldCount);
+    }
+    if (FAILED(result) || !table->hasPyramid) {
+        return result;
+    }
+
+    DOUBLE parsed[INCALESCENT_FILE_MAX_FIELDS];
+    if (numbers == NULL) {
+        INCALESCENT_File_ParseValues(values, table->fieldCount, parsed);
+        numbers = parsed;
+    }
+    return INCALESCENT_Pyramid_AppendRow(&table->pyramid, numbers);
+}
+
+// Writes a columnar table, which was built in memory, or whatever a CSV table still has buffered,
+// and finishes the pyramid.
+static HRESULT INCALESCENT_Table_Write(INCALESCENT_Table *table, HANDLE file) {
+    HRESULT result = S_OK;
+
+    if (table->format == INCALESCENT_FILE_FORMAT_COLUMNAR) {
+        result = INCALESCENT_Columnar_Write(&table->columnar, file);
+    } else {
+        result = INCALESCENT_Writer_Finish(&table->writer);
+    }
+    if (SUCCEEDED(result) && table->hasPyramid) {
+        result = INCALESCENT_Pyramid_Finish(&table->pyramid);
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // The table is all that was written to the file, so its size is what the table took.
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        fileSize.QuadPart = 0;
+    }
+    if (table->started != 0) {
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_WRITE, table->started);
+        INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_ROWS_WRITTEN, table->rowCount);
+        INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_BYTES_WRITTEN, (ULONGLONG) fileSize.QuadPart);
+    }
+    if (table->writer.gzip != NULL) {
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Compressed %llu bytes of table into %llu bytes...", table->writer.bytesWritten,
+                                                  (ULONGLONG) fileSize.QuadPart);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Table_CreateStatistics
+HRESULT INCALESCENT_Table_CreateStatistics(INCALESCENT_Table *table, INCALESCENT_File_Session *session) {
+    if (!session->options.statistics) {
+        return S_OK;
+    }
+
+    table->workerCount = INCALESCENT_Pool_WorkerCount(session->pool);
+    SIZE_T count = (SIZE_T) (table->workerCount + 1) * session->fieldCount;
+    HRESULT result = INCALESCENT_Arena_Allocate(&session->arena, sizeof(INCALESCENT_Stats) * count, INCALESCENT_ARENA_DEFAULT_ALIGNMENT,
+                                                (PVOID *) &table->statistics);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    for (SIZE_T index = 0; index < count; index++) {
+        INCALESCENT_Stats_Reset(&table->statistics[index]);
+    }
+    return S_OK;
+}
+
+// Implementation for INCALESCENT_Table_SharedStatistics
+INCALESCENT_Stats *INCALESCENT_Table_SharedStatistics(const INCALESCENT_Table *table) {
+    if (table->statistics == NULL) {
+        return NULL;
+    }
+    return table->statistics + ((SIZE_T) table->workerCount * table->fieldCount);
+}
+
+// Merges the statistics of every set into the first one, then writes them next to the consolidated
+// table, a row for every column, and logs the main ones. A column without any numbers gets a count
+// of zero and is otherwise left empty.
+static HRESULT INCALESCENT_Table_SaveStatistics(INCALESCENT_Table *table, INCALESCENT_File_Session *session, PCWSTR consolidatedFile) {
+    static const DOUBLE quantiles[] = {INCALESCENT_TABLE_STATISTICS_QUANTILES};
+    HRESULT result = S_OK;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    WCHAR path[INCALESCENT_TABLE_STATISTICS_PATH_SIZE];
+    WCHAR number[INCALESCENT_TABLE_STATISTICS_NUMBER_LENGTH];
+    DOUBLE row[4 + ARRAYSIZE(quantiles)];
+    INCALESCENT_Writer writer;
+    DWORD fieldCount = session->fieldCount;
+    DWORD setCount = table->workerCount + 1;
+    INCALESCENT_Stats *statistics = table->statistics;
+
+    for (DWORD set = 1; set < setCount; set++) {
+        for (DWORD field = 0; field < fieldCount; field++) {
+            INCALESCENT_Stats_Merge(&statistics[field], &statistics[(set * fieldCount) + field]);
+        }
+    }
+
+    result = StringCchPrintfW(path, INCALESCENT_TABLE_STATISTICS_PATH_SIZE, L"%s%s", consolidatedFile, INCALESCENT_TABLE_STATISTICS_EXTENSION);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Writer_Create(&writer, file, session->options.encoding, &session->arena);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Writer_Reserve(&writer, INCALESCENT_WRITER_MAX_BYTES_PER_UNIT * INCALESCENT_TABLE_STATISTICS_HEADER_STRING_LENGTH);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    INCALESCENT_Writer_AppendAscii(&writer, INCALESCENT_TABLE_STATISTICS_HEADER_STRING, INCALESCENT_TABLE_STATISTICS_HEADER_STRING_LENGTH);
+
+    for (DWORD field = 0; field < fieldCount; field++) {
+        INCALESCENT_Stats *stats = &statistics[field];
+        SIZE_T columnLength = lstrlenW(session->columns[field]);
+
+        row[0] = stats->minimum;
+        row[1] = stats->maximum;
+        row[2] = stats->mean;
+        row[3] = INCALESCENT_Stats_StandardDeviation(stats);
+        for (DWORD quantile = 0; quantile < ARRAYSIZE(quantiles); quantile++) {
+            row[4 + quantile] = INCALESCENT_Stats_Quantile(stats, quantiles[quantile]);
+        }
+
+        // The column, the count and every number after a comma, and 2 new-line characters.
+        SIZE_T length = columnLength + 1 + INCALESCENT_WRITER_UNSIGNED_MAX_DIGITS + (ARRAYSIZE(row) * INCALESCENT_TABLE_STATISTICS_NUMBER_LENGTH) + 2;
+        result = INCALESCENT_Writer_Reserve(&writer, INCALESCENT_WRITER_MAX_BYTES_PER_UNIT * length);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        INCALESCENT_Writer_AppendString(&writer, session->columns[field], columnLength);
+        INCALESCENT_Writer_AppendAscii(&writer, ",", 1);
+        INCALESCENT_Writer_AppendUnsigned(&writer, (SIZE_T) stats->count);
+        for (DWORD column = 0; column < ARRAYSIZE(row); column++) {
+            INCALESCENT_Writer_AppendAscii(&writer, ",", 1);
+            if (stats->count != 0) {
+                result = StringCchPrintfW(number, INCALESCENT_TABLE_STATISTICS_NUMBER_LENGTH, L"%.15g", row[column]);
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+                INCALESCENT_Writer_AppendString(&writer, number, lstrlenW(number));
+            }
+        }
+        INCALESCENT_Writer_AppendAscii(&writer, "\r\n", 2);
+
+        // The median is the fourth of the quantiles.
+        result = INCALESCENT_LOG_INFO_FORMATTED_W(L"%s: %llu values, minimum %g, maximum %g, mean %g, standard deviation %g, median %g",
+                                                  session->columns[field], stats->count, row[0], row[1], row[2], row[3],
+                                                  row[4 + 3]);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    result = INCALESCENT_Writer_Flush(&writer);
+
+    cleanup:
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    return result;
+}
+
+// Adds what an arena reserved, took at its peak and was called for to a total.
+static void INCALESCENT_Table_AddArena(INCALESCENT_Arena *total, const INCALESCENT_Arena *arena) {
+    total->reserved += arena->reserved;
+    total->peak += arena->peak;
+    total->allocationCount += arena->allocationCount;
+    total->systemCallCount += arena->systemCallCount;
+}
+
+// Totals the memory a consolidation took. All of it comes from the session's arenas, the cache's
+// and the ones given, so their counters cover every allocation made along the way.
+static void INCALESCENT_Table_TotalMemory(const INCALESCENT_File_Session *session, const INCALESCENT_Cache *cache, const INCALESCENT_Arena *arenas,
+                                          DWORD arenaCount, INCALESCENT_Arena *total) {
+    *total = session->arena;
+    if (cache != NULL) {
+        INCALESCENT_Table_AddArena(total, &cache->pending);
+    }
+    INCALESCENT_Table_AddArena(total, &session->names.index);
+    const INCALESCENT_Arena *pooled[] = {&session->namePool.bytes, &session->namePool.entryArena, &session->namePool.orderArena};
+    for (DWORD index = 0; index < ARRAYSIZE(pooled); index++) {
+        INCALESCENT_Table_AddArena(total, pooled[index]);
+    }
+    for (DWORD index = 0; index < session->scratchCount; index++) {
+        INCALESCENT_Table_AddArena(total, &session->scratch[index]);
+    }
+    for (DWORD index = 0; index < arenaCount; index++) {
+        INCALESCENT_Table_AddArena(total, &arenas[index]);
+    }
+}
+
+// Implementation for INCALESCENT_Table_FixedMemory
+SIZE_T INCALESCENT_Table_FixedMemory(const INCALESCENT_Table *table, const INCALESCENT_File_Session *session) {
+    INCALESCENT_Arena total;
+    INCALESCENT_Table_TotalMemory(session, NULL, NULL, 0, &total);
+
+    // The statistics are written through a writer of their own, whose buffer is aligned to a page.
+    if (table->statistics != NULL) {
+        total.peak += INCALESCENT_WRITER_BUFFER_SIZE + INCALESCENT_ARENA_COMMIT_GRANULARITY;
+    }
+    return total.peak;
+}
+
+// Implementation for INCALESCENT_Table_End
+HRESULT INCALESCENT_Table_End(INCALESCENT_Table *table, INCALESCENT_File_Session *session, PCWSTR consolidatedFile, HANDLE file,
+                              INCALESCENT_Cache *cache, const INCALESCENT_Arena *arenas, DWORD arenaCount) {
+    HRESULT result = INCALESCENT_Table_Write(table, file);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    if (table->statistics != NULL) {
+        result = INCALESCENT_Table_SaveStatistics(table, session, consolidatedFile);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    if (cache != NULL) {
+        ULONGLONG saving = INCALESCENT_Perf_Now();
+        result = INCALESCENT_Cache_Save(cache, consolidatedFile);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_CACHE, saving);
+    }
+
+    INCALESCENT_Arena total;
+    INCALESCENT_Table_TotalMemory(session, cache, arenas, arenaCount, &total);
+    session->memoryPeak = total.peak;
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(
+            L"Memory: %llu bytes reserved, %llu bytes at peak, %llu allocations, %llu system calls.",
+            total.reserved,
+            total.peak,
+            total.allocationCount,
+            total.systemCallCount
+    );
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Table_Destroy
+void INCALESCENT_Table_Destroy(INCALESCENT_Table *table) {
+    INCALESCENT_Writer_Destroy(&table->writer);
+    INCALESCENT_Pyramid_Destroy(&table->pyramid);
+}
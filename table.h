@@ -0,0 +1,163 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_TABLE_H
+#define INCALESCENT_TABLE_H
+#include "arena.h"
+#include "writer.h"
+#include "columnar.h"
+#include "pyramid.h"
+#include "stats.h"
+#include "cache.h"
+#include "file.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* HANDLE;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+typedef const WCHAR* PCWSTR;
+typedef int BOOL;
+typedef unsigned __int64 SIZE_T;
+typedef unsigned __int64 ULONGLONG;
+typedef double DOUBLE;
+
+// The columns in front of the field columns. Every field adds a comma and its name, and the header
+// ends with 2 new-line characters.
+#define INCALESCENT_TABLE_HEADER_STRING "Index,File"
+#define INCALESCENT_TABLE_HEADER_STRING_LENGTH INCALESCENT_STRING_LENGTH(INCALESCENT_TABLE_HEADER_STRING)
+#define INCALESCENT_TABLE_TREE_HEADER_STRING "Index,Directory,File"
+#define INCALESCENT_TABLE_TREE_HEADER_STRING_LENGTH INCALESCENT_STRING_LENGTH(INCALESCENT_TABLE_TREE_HEADER_STRING)
+
+// The statistics of every column, written next to the consolidated table with this extension, one
+// row per column. The quantiles are the ones in the header.
+#define INCALESCENT_TABLE_STATISTICS_EXTENSION L".stats.csv"
+#define INCALESCENT_TABLE_STATISTICS_PATH_SIZE ((INCALESCENT_FILE_MAX_PATH * 2) + 16)
+#define INCALESCENT_TABLE_STATISTICS_HEADER_STRING "Column,Count,Minimum,Maximum,Mean,Standard Deviation,P1,P5,P25,P50,P75,P95,P99\r\n"
+#define INCALESCENT_TABLE_STATISTICS_HEADER_STRING_LENGTH INCALESCENT_STRING_LENGTH(INCALESCENT_TABLE_STATISTICS_HEADER_STRING)
+#define INCALESCENT_TABLE_STATISTICS_QUANTILES 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99
+#define INCALESCENT_TABLE_STATISTICS_NUMBER_LENGTH 32
+
+/**
+ * @brief The consolidated table being written, in whichever format the session chose, along with
+ * its pyramid and the statistics of its columns.
+ *
+ * Every way of consolidating goes through the same steps: the statistics are created before any
+ * data file is read, the table is begun once the number of rows is known, a row is appended for
+ * every data file, and ending the table writes whatever goes next to it. The table must be zeroed
+ * to start with, so that it can be destroyed however far it got.
+ */
+typedef struct INCALESCENT_Table {
+    INCALESCENT_File_Format format;
+    DWORD fieldCount;
+    INCALESCENT_Writer writer;
+    INCALESCENT_Columnar columnar;
+
+    // When the table was started and how many rows it has, for the performance counters.
+    ULONGLONG started;
+    SIZE_T rowCount;
+
+    // The downsampled copies of the table, built as its rows are appended.
+    BOOL hasPyramid;
+    INCALESCENT_Pyramid pyramid;
+
+    // The statistics of every column for every worker, and one more set after them for the values
+    // that don't come from a worker, or NULL if they aren't kept.
+    INCALESCENT_Stats *statistics;
+    DWORD workerCount;
+} INCALESCENT_Table;
+
+// Whether the table goes into a gzip stream, which its extension tells.
+BOOL INCALESCENT_Table_IsCompressed(PCWSTR consolidatedFile);
+
+/**
+ * @brief Allocates the statistics of every column for every worker, and one more set after them.
+ *
+ * Each worker only adds to its own set, so none of them are shared. Does nothing unless the
+ * session's options ask for statistics.
+ *
+ * @return The result of the allocation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Table_CreateStatistics(INCALESCENT_Table *table, INCALESCENT_File_Session *session);
+
+// The set of statistics after the workers' ones, for the values that come from the cache or a
+// single thread, or NULL if no statistics are kept.
+INCALESCENT_Stats *INCALESCENT_Table_SharedStatistics(const INCALESCENT_Table *table);
+
+/**
+ * @brief Starts a table of rowCount rows.
+ *
+ * A CSV table gets its header right away, while a columnar table is built in memory and only
+ * written once it is complete.
+ *
+ * @param[in,out] table         The table, zeroed or with its statistics created.
+ * @param[in] session           The session, whose options tell the format.
+ * @param[in] consolidatedFile  The path of the table, which the pyramid goes next to.
+ * @param[in] file              The file the table is written to.
+ * @param[in] rowCount          The number of rows a columnar table makes room for.
+ * @param[in] hasDirectories    Whether the rows have a directory column.
+ *
+ * @return The result of starting the table (S_OK if successful).
+ */
+HRESULT INCALESCENT_Table_Begin(INCALESCENT_Table *table, INCALESCENT_File_Session *session, PCWSTR consolidatedFile, HANDLE file,
+                                SIZE_T rowCount, BOOL hasDirectories);
+
+/**
+ * @brief Appends a row to the table.
+ *
+ * A columnar table only takes the numbers, a CSV table only the values, which are parsed for the
+ * pyramid if there is one.
+ *
+ * @return The result of appending the row (S_OK if successful).
+ */
+HRESULT INCALESCENT_Table_AppendRow(INCALESCENT_Table *table, SIZE_T index, PWSTR directory, SIZE_T directoryLength, PWSTR fileName,
+                                    SIZE_T fileNameLength, const INCALESCENT_File_Value *values, const DOUBLE *numbers);
+
+/**
+ * @brief Finishes the table and writes everything that goes next to it.
+ *
+ * The statistics are merged and saved, the cache is only replaced once the whole table has been
+ * written, and how much memory the consolidation took is logged last and kept in the session's
+ * memoryPeak.
+ *
+ * @param[in,out] table         The table.
+ * @param[in] session           The session.
+ * @param[in] consolidatedFile  The path of the table, which the statistics and cache go next to.
+ * @param[in] file              The file the table is written to.
+ * @param[in,out] cache         The cache to save, or NULL if there is none.
+ * @param[in] arenas            The arenas the consolidation took besides the session's.
+ * @param[in] arenaCount        The number of arenas.
+ *
+ * @return The result of the first step that failed (S_OK if successful).
+ */
+HRESULT INCALESCENT_Table_End(INCALESCENT_Table *table, INCALESCENT_File_Session *session, PCWSTR consolidatedFile, HANDLE file,
+                              INCALESCENT_Cache *cache, const INCALESCENT_Arena *arenas, DWORD arenaCount);
+
+// The memory a consolidation takes besides arenas of its own: what the session's arenas have taken at
+// their peak so far, and what INCALESCENT_Table_End still takes to save the statistics.
+SIZE_T INCALESCENT_Table_FixedMemory(const INCALESCENT_Table *table, const INCALESCENT_File_Session *session);
+
+// Stops the compression of the table, if any, and closes whatever files it has besides its own.
+void INCALESCENT_Table_Destroy(INCALESCENT_Table *table);
+
+#endif //INCALESCENT_TABLE_H
@@ -0,0 +1,214 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../corpus.h"
+#include "../file.h"
+#include "../log.h"
+
+// Consolidates a directory within the smallest memory budget, with names long enough that they
+// only fit in several sorted runs, then checks that the memory the consolidation logged at its
+// peak stays within the budget and that every row comes out in order. Takes the directory to work
+// in, which is created if it doesn't exist.
+
+#define INCALESCENT_BOUNDED_TEST_FILE_COUNT 20000
+#define INCALESCENT_BOUNDED_TEST_FILE_SIZE 128
+#define INCALESCENT_BOUNDED_TEST_PREFIX_LENGTH 150
+#define INCALESCENT_BOUNDED_TEST_WORKERS 2
+#define INCALESCENT_BOUNDED_TEST_MAX_TABLE_SIZE (8 * 1024 * 1024)
+
+static CHAR INCALESCENT_BoundedTest_Text[INCALESCENT_BOUNDED_TEST_MAX_TABLE_SIZE + 1];
+static WCHAR INCALESCENT_BoundedTest_Prefix[INCALESCENT_BOUNDED_TEST_PREFIX_LENGTH + 1];
+
+// Writes the data files, each named after the prefix and its number, so they only come out in
+// order with a natural sort.
+static HRESULT INCALESCENT_BoundedTest_Generate(PCWSTR dataDirectory) {
+    HRESULT result = S_OK;
+    INCALESCENT_Corpus_Options options = {0};
+    options.fileCount = INCALESCENT_BOUNDED_TEST_FILE_COUNT;
+    options.fileSize = INCALESCENT_BOUNDED_TEST_FILE_SIZE;
+    options.values = INCALESCENT_CORPUS_VALUES_MIXED;
+    WCHAR path[MAX_PATH];
+    BYTE text[INCALESCENT_BOUNDED_TEST_FILE_SIZE * 2];
+    SIZE_T length = 0;
+    DWORD written = 0;
+
+    if (INCALESCENT_Corpus_FileCapacity(&options) > sizeof(text)) {
+        return E_INVALIDARG;
+    }
+    for (SIZE_T index = 0; index < INCALESCENT_BOUNDED_TEST_FILE_COUNT; index++) {
+        result = StringCchPrintfW(path, ARRAYSIZE(path), L"%s\\%s_%llu%s", dataDirectory, INCALESCENT_BoundedTest_Prefix, (ULONGLONG) index + 1,
+                                  INCALESCENT_FILE_FILTER_SUFFIX);
+        if (FAILED(result)) {
+            return result;
+        }
+        INCALESCENT_Corpus_FormatFile(&options, index, text, &length);
+
+        HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        if (!WriteFile(file, text, (DWORD) length, &written, NULL) || written != length) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+        }
+        CloseHandle(file);
+        if (FAILED(result)) {
+            return result;
+        }
+    }
+    return S_OK;
+}
+
+// Reads the whole table into INCALESCENT_BoundedTest_Text and terminates it.
+static HRESULT INCALESCENT_BoundedTest_Read(PCWSTR path) {
+    HRESULT result = S_OK;
+    DWORD read = 0;
+    SIZE_T length = 0;
+
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    do {
+        if (!ReadFile(file, INCALESCENT_BoundedTest_Text + length, (DWORD) (INCALESCENT_BOUNDED_TEST_MAX_TABLE_SIZE - length), &read, NULL)) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        length += read;
+    } while (read != 0 && length < INCALESCENT_BOUNDED_TEST_MAX_TABLE_SIZE);
+    if (length == INCALESCENT_BOUNDED_TEST_MAX_TABLE_SIZE) {
+        result = HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+        goto cleanup;
+    }
+    INCALESCENT_BoundedTest_Text[length] = '\0';
+
+    cleanup:
+    CloseHandle(file);
+    return result;
+}
+
+// Checks that row n of the table is the data file numbered n + 1, and that there is one row for
+// every data file.
+static HRESULT INCALESCENT_BoundedTest_CheckTable(PCWSTR tablePath) {
+    HRESULT result = INCALESCENT_BoundedTest_Read(tablePath);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    SIZE_T rowCount = 0;
+    CHAR *line = strchr(INCALESCENT_BoundedTest_Text, '\n');
+    while (line != NULL && line[1] != '\0') {
+        line++;
+        CHAR *end = strchr(line, '\n');
+        if (end == NULL || rowCount == INCALESCENT_BOUNDED_TEST_FILE_COUNT) {
+            printf("the table has more rows than the %d data files\n", INCALESCENT_BOUNDED_TEST_FILE_COUNT);
+            return E_FAIL;
+        }
+        *end = '\0';
+
+        CHAR *name = strchr(line, ',');
+        CHAR *number = name == NULL ? NULL : strchr(name, '_');
+        if (strtoull(line, NULL, 10) != rowCount || number == NULL || strtoull(number + 1, NULL, 10) != rowCount + 1) {
+            printf("row %llu of the table is out of order: %.40s...\n", (ULONGLONG) rowCount, line);
+            return E_FAIL;
+        }
+        rowCount++;
+        line = end;
+    }
+    if (rowCount != INCALESCENT_BOUNDED_TEST_FILE_COUNT) {
+        printf("the table has %llu rows rather than %d\n", (ULONGLONG) rowCount, INCALESCENT_BOUNDED_TEST_FILE_COUNT);
+        return E_FAIL;
+    }
+    return S_OK;
+}
+
+INT wmain(INT argumentCount, PWSTR *arguments) {
+    HRESULT result = S_OK;
+    INCALESCENT_File_Options options = {0};
+    INCALESCENT_File_Session session = {0};
+    WCHAR dataDirectory[MAX_PATH];
+    WCHAR tablePath[MAX_PATH];
+    ULONGLONG memoryPeak = 0;
+
+    if (argumentCount != 2) {
+        printf("Usage: bounded_test <work directory>\n");
+        return 2;
+    }
+    PCWSTR work = arguments[1];
+    CreateDirectoryW(work, NULL);
+    for (SIZE_T index = 0; index < INCALESCENT_BOUNDED_TEST_PREFIX_LENGTH; index++) {
+        INCALESCENT_BoundedTest_Prefix[index] = L'a' + (WCHAR) (index % 26);
+    }
+
+    result = StringCchPrintfW(dataDirectory, ARRAYSIZE(dataDirectory), L"%s\\data", work);
+    if (SUCCEEDED(result)) {
+        result = StringCchPrintfW(tablePath, ARRAYSIZE(tablePath), L"%s\\table.csv", work);
+    }
+    if (SUCCEEDED(result)) {
+        CreateDirectoryW(dataDirectory, NULL);
+        result = INCALESCENT_BoundedTest_Generate(dataDirectory);
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // The statistics take a buffer of their own at the very end, which has to fit as well.
+    options.workerCount = INCALESCENT_BOUNDED_TEST_WORKERS;
+    options.memoryBudget = INCALESCENT_FILE_MIN_MEMORY_BUDGET;
+    options.statistics = TRUE;
+    result = INCALESCENT_LogStart();
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_File_CreateSession(&options, &session);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_File_Consolidate(&session, dataDirectory, tablePath);
+        memoryPeak = session.memoryPeak;
+        INCALESCENT_File_DestroySession(&session);
+    }
+    HRESULT logResult = INCALESCENT_LogStop();
+    if (SUCCEEDED(result)) {
+        result = logResult;
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    if (memoryPeak == 0 || memoryPeak > options.memoryBudget) {
+        printf("the consolidation took %llu bytes at its peak, with a budget of %llu bytes\n", memoryPeak, (ULONGLONG) options.memoryBudget);
+        result = E_FAIL;
+        goto cleanup;
+    }
+    result = INCALESCENT_BoundedTest_CheckTable(tablePath);
+
+    cleanup:
+    if (FAILED(result)) {
+        printf("bounded test failed (0x%08x)\n", (unsigned int) result);
+        return 1;
+    }
+    return 0;
+}
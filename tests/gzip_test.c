@@ -0,0 +1,262 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+#include "../crc.h"
+#include "../gzip.h"
+#include "../inflate.h"
+
+// Compresses random and repetitive buffers through a gzip stream into a file, then reads the file
+// back and inflates it, checking the header, the data and the trailer. Takes the path of the file
+// to write, which is replaced.
+
+#define INCALESCENT_GZIP_TEST_MAX_BLOCK (64 * 1024)
+#define INCALESCENT_GZIP_TEST_MAX_SIZE (4 * 1024 * 1024)
+#define INCALESCENT_GZIP_TEST_TRAILER_SIZE 8
+#define INCALESCENT_GZIP_TEST_SEED 0x9E3779B97F4A7C15ULL
+
+// The ways a buffer is filled, from incompressible to runs of a single byte.
+typedef enum INCALESCENT_GzipTest_Kind {
+    INCALESCENT_GZIP_TEST_RANDOM = 0,
+    INCALESCENT_GZIP_TEST_ROWS = 1,
+    INCALESCENT_GZIP_TEST_RUNS = 2,
+    INCALESCENT_GZIP_TEST_MIXED = 3,
+} INCALESCENT_GzipTest_Kind;
+
+typedef struct INCALESCENT_GzipTest_Case {
+    PCSTR name;
+    INCALESCENT_GzipTest_Kind kind;
+    SIZE_T size;
+} INCALESCENT_GzipTest_Case;
+
+static const INCALESCENT_GzipTest_Case INCALESCENT_GzipTest_Cases[] = {
+        {"empty", INCALESCENT_GZIP_TEST_RANDOM, 0},
+        {"one byte", INCALESCENT_GZIP_TEST_RANDOM, 1},
+        {"short random", INCALESCENT_GZIP_TEST_RANDOM, 1000},
+        {"random", INCALESCENT_GZIP_TEST_RANDOM, 3 * 1024 * 1024 + 17},
+        {"rows", INCALESCENT_GZIP_TEST_ROWS, INCALESCENT_GZIP_TEST_MAX_SIZE},
+        {"runs", INCALESCENT_GZIP_TEST_RUNS, 2 * 1024 * 1024},
+        {"mixed", INCALESCENT_GZIP_TEST_MIXED, INCALESCENT_GZIP_TEST_MAX_SIZE - 3},
+};
+
+// Compares the inflated data with the buffer it was compressed from as it comes in.
+typedef struct INCALESCENT_GzipTest_Check {
+    const BYTE *expected;
+    SIZE_T size;
+    SIZE_T offset;
+} INCALESCENT_GzipTest_Check;
+
+static BYTE INCALESCENT_GzipTest_Data[INCALESCENT_GZIP_TEST_MAX_SIZE];
+static INCALESCENT_Inflate INCALESCENT_GzipTest_Inflate;
+
+static ULONGLONG INCALESCENT_GzipTest_Next(ULONGLONG *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static SIZE_T INCALESCENT_GzipTest_Min(SIZE_T first, SIZE_T second) {
+    return first < second ? first : second;
+}
+
+static void INCALESCENT_GzipTest_Fill(ULONGLONG *state, INCALESCENT_GzipTest_Kind kind, SIZE_T size) {
+    SIZE_T position = 0;
+    ULONGLONG row = 0;
+
+    while (position < size) {
+        INCALESCENT_GzipTest_Kind part = kind;
+        if (kind == INCALESCENT_GZIP_TEST_MIXED) {
+            part = (INCALESCENT_GzipTest_Kind) (INCALESCENT_GzipTest_Next(state) % INCALESCENT_GZIP_TEST_MIXED);
+        }
+
+        SIZE_T length = 0;
+        switch (part) {
+            case INCALESCENT_GZIP_TEST_RANDOM:
+                length = 1 + (INCALESCENT_GzipTest_Next(state) % 10000);
+                for (SIZE_T index = 0; index < length && position + index < size; index++) {
+                    INCALESCENT_GzipTest_Data[position + index] = (BYTE) INCALESCENT_GzipTest_Next(state);
+                }
+                break;
+            case INCALESCENT_GZIP_TEST_ROWS: {
+                // Rows of a consolidated table, whose matches are mostly short and near.
+                CHAR line[64];
+                length = (SIZE_T) snprintf(line, sizeof(line), "%llu,run%llu,image_%llu.tif.metadata,%llu.%02llu\r\n", row, row / 1000,
+                                           row % 1000, 15 + (INCALESCENT_GzipTest_Next(state) % 30), INCALESCENT_GzipTest_Next(state) % 100);
+                row++;
+                CopyMemory(INCALESCENT_GzipTest_Data + position, line, INCALESCENT_GzipTest_Min(length, size - position));
+                break;
+            }
+            default: {
+                // A run of one byte, or a copy of data from up to a window back, which make the
+                // longest matches and the farthest ones.
+                length = 1 + (INCALESCENT_GzipTest_Next(state) % 5000);
+                SIZE_T distance = position == 0 ? 0 : 1 + (INCALESCENT_GzipTest_Next(state) % INCALESCENT_GzipTest_Min(position, INCALESCENT_INFLATE_WINDOW_SIZE));
+                BYTE value = (BYTE) INCALESCENT_GzipTest_Next(state);
+                for (SIZE_T index = 0; index < length && position + index < size; index++) {
+                    INCALESCENT_GzipTest_Data[position + index] = distance == 0 ? value : INCALESCENT_GzipTest_Data[position + index - distance];
+                }
+                break;
+            }
+        }
+        position += length;
+    }
+}
+
+static HRESULT INCALESCENT_GzipTest_Sink(PVOID context, const BYTE *data, SIZE_T size) {
+    INCALESCENT_GzipTest_Check *check = context;
+    if (size > check->size - check->offset || memcmp(data, check->expected + check->offset, size) != 0) {
+        printf("the inflated data differs after byte %llu\n", (ULONGLONG) check->offset);
+        return E_FAIL;
+    }
+    check->offset += size;
+    return S_OK;
+}
+
+// Writes the first size bytes of the data to a gzip file in blocks of random sizes.
+static HRESULT INCALESCENT_GzipTest_Compress(ULONGLONG *state, PCWSTR path, SIZE_T size) {
+    HRESULT result = S_OK;
+    INCALESCENT_Gzip *gzip = NULL;
+
+    HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    result = INCALESCENT_Gzip_Create(file, INCALESCENT_GZIP_TEST_MAX_BLOCK, &gzip);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // The blocks are never changed, so every one stays valid until the next is handed over.
+    for (SIZE_T position = 0; position < size;) {
+        SIZE_T blockSize = INCALESCENT_GzipTest_Min(1 + (INCALESCENT_GzipTest_Next(state) % INCALESCENT_GZIP_TEST_MAX_BLOCK), size - position);
+        result = INCALESCENT_Gzip_Write(gzip, INCALESCENT_GzipTest_Data + position, blockSize);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        position += blockSize;
+    }
+    result = INCALESCENT_Gzip_Finish(gzip);
+
+    cleanup:
+    INCALESCENT_Gzip_Destroy(gzip);
+    CloseHandle(file);
+    return result;
+}
+
+// Reads the gzip file back and checks it against the first size bytes of the data.
+static HRESULT INCALESCENT_GzipTest_Verify(PCWSTR path, SIZE_T size) {
+    static const BYTE header[] = INCALESCENT_GZIP_HEADER;
+    HRESULT result = S_OK;
+    LARGE_INTEGER fileSize = {0};
+    BYTE *compressed = NULL;
+    DWORD read = 0;
+
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    if (!GetFileSizeEx(file, &fileSize)) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if ((SIZE_T) fileSize.QuadPart < sizeof(header) + INCALESCENT_GZIP_TEST_TRAILER_SIZE) {
+        printf("the file only has %llu bytes\n", (ULONGLONG) fileSize.QuadPart);
+        result = E_FAIL;
+        goto cleanup;
+    }
+    compressed = HeapAlloc(GetProcessHeap(), 0, (SIZE_T) fileSize.QuadPart);
+    if (compressed == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+    if (!ReadFile(file, compressed, (DWORD) fileSize.QuadPart, &read, NULL) || read != (DWORD) fileSize.QuadPart) {
+        result = HRESULT_FROM_WIN32(GetLastError());
+        goto cleanup;
+    }
+    if (memcmp(compressed, header, sizeof(header)) != 0) {
+        printf("the header differs\n");
+        result = E_FAIL;
+        goto cleanup;
+    }
+
+    // The deflate data has to end right before the trailer.
+    INCALESCENT_GzipTest_Check check = {INCALESCENT_GzipTest_Data, size, 0};
+    SIZE_T consumed = 0;
+    SIZE_T deflateSize = (SIZE_T) fileSize.QuadPart - sizeof(header);
+    result = INCALESCENT_Inflate_Run(&INCALESCENT_GzipTest_Inflate, compressed + sizeof(header), deflateSize, INCALESCENT_GzipTest_Sink, &check,
+                                     &consumed);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    if (check.offset != size || consumed != deflateSize - INCALESCENT_GZIP_TEST_TRAILER_SIZE) {
+        printf("%llu of %llu bytes were inflated from %llu of %llu bytes\n", (ULONGLONG) check.offset, (ULONGLONG) size, (ULONGLONG) consumed,
+               (ULONGLONG) (deflateSize - INCALESCENT_GZIP_TEST_TRAILER_SIZE));
+        result = E_FAIL;
+        goto cleanup;
+    }
+
+    DWORD trailer[2];
+    CopyMemory(trailer, compressed + sizeof(header) + consumed, sizeof(trailer));
+    if (trailer[0] != INCALESCENT_Crc_Update(0, INCALESCENT_GzipTest_Data, size) || trailer[1] != (DWORD) size) {
+        printf("the trailer differs\n");
+        result = E_FAIL;
+        goto cleanup;
+    }
+    printf("%llu bytes were compressed to %llu\n", (ULONGLONG) size, (ULONGLONG) fileSize.QuadPart);
+
+    cleanup:
+    if (compressed != NULL) {
+        HeapFree(GetProcessHeap(), 0, compressed);
+    }
+    CloseHandle(file);
+    return result;
+}
+
+INT wmain(INT argumentCount, PWSTR *arguments) {
+    HRESULT result = S_OK;
+    ULONGLONG state = INCALESCENT_GZIP_TEST_SEED;
+
+    if (argumentCount != 2) {
+        printf("Usage: gzip_test <file>\n");
+        return 2;
+    }
+
+    for (SIZE_T index = 0; index < ARRAYSIZE(INCALESCENT_GzipTest_Cases); index++) {
+        const INCALESCENT_GzipTest_Case *testCase = &INCALESCENT_GzipTest_Cases[index];
+        printf("%s: ", testCase->name);
+
+        INCALESCENT_GzipTest_Fill(&state, testCase->kind, testCase->size);
+        result = INCALESCENT_GzipTest_Compress(&state, arguments[1], testCase->size);
+        if (SUCCEEDED(result)) {
+            result = INCALESCENT_GzipTest_Verify(arguments[1], testCase->size);
+        }
+        if (FAILED(result)) {
+            printf("gzip test failed (0x%08x)\n", (unsigned int) result);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../corpus.h"
+#include "../file.h"
+#include "../log.h"
+#include "../pyramid.h"
+
+// Consolidates a tree of generated data files recursively with a pyramid, then checks every bucket
+// of every level against the minimum, maximum and mean of the rows of the table it spans. Takes
+// the directory to work in, which is created if it doesn't exist.
+
+#define INCALESCENT_PYRAMID_TEST_FIRST_COUNT 1234
+#define INCALESCENT_PYRAMID_TEST_SECOND_COUNT 567
+#define INCALESCENT_PYRAMID_TEST_THIRD_COUNT 89
+#define INCALESCENT_PYRAMID_TEST_ROW_COUNT (INCALESCENT_PYRAMID_TEST_FIRST_COUNT + INCALESCENT_PYRAMID_TEST_SECOND_COUNT + INCALESCENT_PYRAMID_TEST_THIRD_COUNT)
+#define INCALESCENT_PYRAMID_TEST_FILE_SIZE 128
+#define INCALESCENT_PYRAMID_TEST_WORKERS 2
+#define INCALESCENT_PYRAMID_TEST_MAX_TABLE_SIZE (1024 * 1024)
+#define INCALESCENT_PYRAMID_TEST_TOLERANCE 1e-9
+
+static CHAR INCALESCENT_PyramidTest_Text[INCALESCENT_PYRAMID_TEST_MAX_TABLE_SIZE + 1];
+static DOUBLE INCALESCENT_PyramidTest_Values[INCALESCENT_PYRAMID_TEST_ROW_COUNT];
+
+// Writes a corpus into a directory below the work directory.
+static HRESULT INCALESCENT_PyramidTest_Generate(PCWSTR work, PCWSTR relativePath, SIZE_T fileCount, INCALESCENT_Corpus_Names names) {
+    WCHAR directory[MAX_PATH];
+    INCALESCENT_Corpus_Options options = {0};
+    options.fileCount = fileCount;
+    options.fileSize = INCALESCENT_PYRAMID_TEST_FILE_SIZE;
+    options.names = names;
+    options.values = INCALESCENT_CORPUS_VALUES_MIXED;
+
+    HRESULT result = StringCchPrintfW(directory, ARRAYSIZE(directory), L"%s\\%s", work, relativePath);
+    if (FAILED(result)) {
+        return result;
+    }
+    return INCALESCENT_Corpus_Write(directory, &options);
+}
+
+// Reads a whole output file into INCALESCENT_PyramidTest_Text and terminates it.
+static HRESULT INCALESCENT_PyramidTest_Read(PCWSTR path) {
+    HRESULT result = S_OK;
+    DWORD read = 0;
+    SIZE_T length = 0;
+
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    do {
+        if (!ReadFile(file, INCALESCENT_PyramidTest_Text + length, (DWORD) (INCALESCENT_PYRAMID_TEST_MAX_TABLE_SIZE - length), &read, NULL)) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        length += read;
+    } while (read != 0 && length < INCALESCENT_PYRAMID_TEST_MAX_TABLE_SIZE);
+    if (length == INCALESCENT_PYRAMID_TEST_MAX_TABLE_SIZE) {
+        result = HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+        goto cleanup;
+    }
+    INCALESCENT_PyramidTest_Text[length] = '\0';
+
+    cleanup:
+    CloseHandle(file);
+    return result;
+}
+
+// Reads the temperature, the last column, of every row of the table in order.
+static HRESULT INCALESCENT_PyramidTest_ReadTable(PCWSTR tablePath) {
+    HRESULT result = INCALESCENT_PyramidTest_Read(tablePath);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    SIZE_T rowCount = 0;
+    CHAR *line = strchr(INCALESCENT_PyramidTest_Text, '\n');
+    while (line != NULL && line[1] != '\0') {
+        line++;
+        CHAR *end = strchr(line, '\n');
+        if (end == NULL || rowCount == INCALESCENT_PYRAMID_TEST_ROW_COUNT) {
+            printf("the table has more rows than the %d data files\n", INCALESCENT_PYRAMID_TEST_ROW_COUNT);
+            return E_FAIL;
+        }
+        *end = '\0';
+        if (strtoull(line, NULL, 10) != rowCount) {
+            printf("row %llu of the table is out of order: %s\n", (ULONGLONG) rowCount, line);
+            return E_FAIL;
+        }
+        INCALESCENT_PyramidTest_Values[rowCount++] = strtod(strrchr(line, ',') + 1, NULL);
+        line = end;
+    }
+    if (rowCount != INCALESCENT_PYRAMID_TEST_ROW_COUNT) {
+        printf("the table has %llu rows rather than %d\n", (ULONGLONG) rowCount, INCALESCENT_PYRAMID_TEST_ROW_COUNT);
+        return E_FAIL;
+    }
+    return S_OK;
+}
+
+static BOOL INCALESCENT_PyramidTest_Near(DOUBLE actual, DOUBLE expected) {
+    return fabs(actual - expected) <= INCALESCENT_PYRAMID_TEST_TOLERANCE * fmax(1.0, fabs(expected));
+}
+
+// Checks the level whose buckets span the given number of rows against the values of the table.
+// The last bucket spans the rows that are left over.
+static HRESULT INCALESCENT_PyramidTest_CheckLevel(PCWSTR tablePath, SIZE_T span) {
+    WCHAR path[INCALESCENT_PYRAMID_PATH_SIZE];
+    HRESULT result = StringCchPrintfW(path, ARRAYSIZE(path), INCALESCENT_PYRAMID_PATH_FORMAT, tablePath, (ULONGLONG) span);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_PyramidTest_Read(path);
+    }
+    if (FAILED(result)) {
+        return result;
+    }
+    if (strncmp(INCALESCENT_PyramidTest_Text, INCALESCENT_PYRAMID_HEADER_STRING, INCALESCENT_PYRAMID_HEADER_STRING_LENGTH) != 0) {
+        printf("the level of %llu rows has no header\n", (ULONGLONG) span);
+        return E_FAIL;
+    }
+
+    SIZE_T bucketCount = (INCALESCENT_PYRAMID_TEST_ROW_COUNT + span - 1) / span;
+    CHAR *line = strchr(INCALESCENT_PyramidTest_Text, '\n');
+    for (SIZE_T bucket = 0; bucket < bucketCount; bucket++) {
+        if (line == NULL || line[1] == '\0') {
+            printf("the level of %llu rows ends after %llu of %llu buckets\n", (ULONGLONG) span, (ULONGLONG) bucket, (ULONGLONG) bucketCount);
+            return E_FAIL;
+        }
+        line++;
+
+        SIZE_T first = bucket * span;
+        SIZE_T last = (first + span < INCALESCENT_PYRAMID_TEST_ROW_COUNT ? first + span : INCALESCENT_PYRAMID_TEST_ROW_COUNT) - 1;
+        DOUBLE minimum = INCALESCENT_PyramidTest_Values[first];
+        DOUBLE maximum = minimum;
+        DOUBLE sum = 0;
+        for (SIZE_T row = first; row <= last; row++) {
+            minimum = fmin(minimum, INCALESCENT_PyramidTest_Values[row]);
+            maximum = fmax(maximum, INCALESCENT_PyramidTest_Values[row]);
+            sum += INCALESCENT_PyramidTest_Values[row];
+        }
+
+        CHAR *cursor = line;
+        DOUBLE fields[5];
+        for (DWORD index = 0; index < ARRAYSIZE(fields); index++) {
+            fields[index] = strtod(cursor, &cursor);
+            cursor++;
+        }
+        if (fields[0] != (DOUBLE) first || fields[1] != (DOUBLE) last || !INCALESCENT_PyramidTest_Near(fields[2], minimum) ||
+            !INCALESCENT_PyramidTest_Near(fields[3], maximum) || !INCALESCENT_PyramidTest_Near(fields[4], sum / (DOUBLE) (last - first + 1))) {
+            printf("bucket %llu of the level of %llu rows should span rows %llu to %llu with %.17g, %.17g and %.17g\n",
+                   (ULONGLONG) bucket, (ULONGLONG) span, (ULONGLONG) first, (ULONGLONG) last, minimum, maximum, sum / (DOUBLE) (last - first + 1));
+            return E_FAIL;
+        }
+        line = strchr(line, '\n');
+    }
+    if (line != NULL && line[1] != '\0') {
+        printf("the level of %llu rows has more than %llu buckets\n", (ULONGLONG) span, (ULONGLONG) bucketCount);
+        return E_FAIL;
+    }
+    return S_OK;
+}
+
+INT wmain(INT argumentCount, PWSTR *arguments) {
+    HRESULT result = S_OK;
+    INCALESCENT_File_Options options = {0};
+    INCALESCENT_File_Session session = {0};
+    WCHAR dataDirectory[MAX_PATH];
+    WCHAR tablePath[MAX_PATH];
+
+    if (argumentCount != 2) {
+        printf("Usage: pyramid_test <work directory>\n");
+        return 2;
+    }
+    PCWSTR work = arguments[1];
+    CreateDirectoryW(work, NULL);
+
+    // The directories are nested, so the rows of the table come from files at several depths.
+    result = StringCchPrintfW(dataDirectory, ARRAYSIZE(dataDirectory), L"%s\\data", work);
+    if (SUCCEEDED(result)) {
+        result = StringCchPrintfW(tablePath, ARRAYSIZE(tablePath), L"%s\\table.csv", work);
+    }
+    if (SUCCEEDED(result)) {
+        CreateDirectoryW(dataDirectory, NULL);
+        result = INCALESCENT_PyramidTest_Generate(work, L"data\\first", INCALESCENT_PYRAMID_TEST_FIRST_COUNT, INCALESCENT_CORPUS_NAMES_RUNS);
+    }
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_PyramidTest_Generate(work, L"data\\second", INCALESCENT_PYRAMID_TEST_SECOND_COUNT, INCALESCENT_CORPUS_NAMES_SEQUENTIAL);
+    }
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_PyramidTest_Generate(work, L"data\\second\\third", INCALESCENT_PYRAMID_TEST_THIRD_COUNT, INCALESCENT_CORPUS_NAMES_PADDED);
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    options.workerCount = INCALESCENT_PYRAMID_TEST_WORKERS;
+    options.recursive = TRUE;
+    options.pyramid = TRUE;
+    result = INCALESCENT_LogStart();
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_File_CreateSession(&options, &session);
+    if (SUCCEEDED(result)) {
+        result = INCALESCENT_File_Consolidate(&session, dataDirectory, tablePath);
+        INCALESCENT_File_DestroySession(&session);
+    }
+    HRESULT logResult = INCALESCENT_LogStop();
+    if (SUCCEEDED(result)) {
+        result = logResult;
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_PyramidTest_ReadTable(tablePath);
+    for (SIZE_T level = 0, span = INCALESCENT_PYRAMID_FACTOR; SUCCEEDED(result) && level < INCALESCENT_PYRAMID_LEVELS; level++) {
+        result = INCALESCENT_PyramidTest_CheckLevel(tablePath, span);
+        span *= INCALESCENT_PYRAMID_FACTOR;
+    }
+
+    cleanup:
+    if (FAILED(result)) {
+        printf("pyramid test failed (0x%08x)\n", (unsigned int) result);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,287 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <stdio.h>
+#include "../arena.h"
+#include "../pool.h"
+#include "../string.h"
+
+// Checks INCALESCENT_String_NaturalSort against a list of names in a known order, then against
+// CompareStringW with the same flags on random file names: runs of digits with and without leading
+// zeros, mixed case and letters outside ASCII. Takes an optional seed, so that a failure can be
+// reproduced.
+
+#define INCALESCENT_STRING_TEST_MAX_LENGTH 64
+#define INCALESCENT_STRING_TEST_ROUNDS 4
+#define INCALESCENT_STRING_TEST_LARGE_COUNT 20000
+#define INCALESCENT_STRING_TEST_SMALL_COUNT 1000
+#define INCALESCENT_STRING_TEST_PAIR_COUNT 100000
+#define INCALESCENT_STRING_TEST_WORKERS 4
+#define INCALESCENT_STRING_TEST_ARENA_RESERVE (1024 * 1024 * 1024)
+#define INCALESCENT_STRING_TEST_DEFAULT_SEED 0x9E3779B97F4A7C15ULL
+
+static const WCHAR INCALESCENT_StringTest_Letters[] =
+        L"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+        L"\x00E9\x00C9\x00E4\x00C4\x00F6\x00D6\x00DF\x00F1\x00D1\x00E7\x0142\x0141\x03C9\x03A9\x0436\x0416";
+static const WCHAR INCALESCENT_StringTest_Separators[] = L"_-. ";
+
+// Names in the order a natural sort has to put them in, whatever compares them: numbers by their
+// value, digits before letters and letters regardless of case. The three names that only differ in
+// case are equal, so they have to keep the order they are given in.
+static const PCWSTR INCALESCENT_StringTest_Unsorted[] = {
+        L"run10_image1", L"frame9", L"Zeta", L"image_100.tif.metadata", L"a10", L"frame7", L"gamma", L"image_2.tif.metadata",
+        L"run1_image10", L"Beta", L"frame10", L"image_1000.tif.metadata", L"FRAME7", L"ab", L"run2_image1", L"image_9.tif.metadata",
+        L"alpha", L"frame08", L"image_1.tif.metadata", L"Frame7", L"run1_image2", L"a2", L"image_10.tif.metadata",
+};
+static const PCWSTR INCALESCENT_StringTest_Sorted[] = {
+        L"a2", L"a10", L"ab", L"alpha", L"Beta", L"frame7", L"FRAME7", L"Frame7", L"frame08", L"frame9", L"frame10", L"gamma",
+        L"image_1.tif.metadata", L"image_2.tif.metadata", L"image_9.tif.metadata", L"image_10.tif.metadata", L"image_100.tif.metadata",
+        L"image_1000.tif.metadata", L"run1_image2", L"run1_image10", L"run2_image1", L"run10_image1", L"Zeta",
+};
+
+// A xorshift generator, which gives the same names for the same seed everywhere.
+static ULONGLONG INCALESCENT_StringTest_Next(ULONGLONG *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static SIZE_T INCALESCENT_StringTest_Below(ULONGLONG *state, SIZE_T bound) {
+    return (SIZE_T) (INCALESCENT_StringTest_Next(state) % bound);
+}
+
+// Writes a random name of a few parts into name, which holds INCALESCENT_STRING_TEST_MAX_LENGTH
+// characters. Some of the names share their beginning, so that the numbers are compared with each
+// other rather than decided by the first letters.
+static void INCALESCENT_StringTest_Generate(ULONGLONG *state, PWSTR name) {
+    SIZE_T length = 0;
+    SIZE_T partCount = 1 + INCALESCENT_StringTest_Below(state, 6);
+
+    if (INCALESCENT_StringTest_Below(state, 2) == 0) {
+        CopyMemory(name, L"image_", sizeof(WCHAR) * 6);
+        length = 6;
+    }
+    for (SIZE_T part = 0; part < partCount; part++) {
+        switch (INCALESCENT_StringTest_Below(state, 3)) {
+            case 0: {
+                SIZE_T zeroCount = INCALESCENT_StringTest_Below(state, 3) == 0 ? 1 + INCALESCENT_StringTest_Below(state, 3) : 0;
+                SIZE_T digitCount = 1 + INCALESCENT_StringTest_Below(state, 10);
+                for (SIZE_T index = 0; index < zeroCount; index++) {
+                    name[length++] = L'0';
+                }
+                for (SIZE_T index = 0; index < digitCount; index++) {
+                    name[length++] = (WCHAR) (L'0' + INCALESCENT_StringTest_Below(state, 10));
+                }
+                break;
+            }
+            case 1: {
+                SIZE_T letterCount = 1 + INCALESCENT_StringTest_Below(state, 4);
+                for (SIZE_T index = 0; index < letterCount; index++) {
+                    name[length++] = INCALESCENT_StringTest_Letters[INCALESCENT_StringTest_Below(state, ARRAYSIZE(INCALESCENT_StringTest_Letters) - 1)];
+                }
+                break;
+            }
+            default:
+                name[length++] = INCALESCENT_StringTest_Separators[INCALESCENT_StringTest_Below(state, ARRAYSIZE(INCALESCENT_StringTest_Separators) - 1)];
+                break;
+        }
+    }
+    name[length] = L'\0';
+}
+
+static INT INCALESCENT_StringTest_Compare(PCWSTR first, PCWSTR second) {
+    return CompareStringW(LOCALE_USER_DEFAULT, INCALESCENT_STRING_SORT_FLAGS, first, -1, second, -1);
+}
+
+static void INCALESCENT_StringTest_Print(PCSTR message, PCWSTR first, PCWSTR second) {
+    CHAR firstBytes[INCALESCENT_STRING_TEST_MAX_LENGTH * 3];
+    CHAR secondBytes[INCALESCENT_STRING_TEST_MAX_LENGTH * 3];
+    WideCharToMultiByte(CP_UTF8, 0, first, -1, firstBytes, sizeof(firstBytes), NULL, NULL);
+    WideCharToMultiByte(CP_UTF8, 0, second, -1, secondBytes, sizeof(secondBytes), NULL, NULL);
+    printf("%s: \"%s\" and \"%s\"\n", message, firstBytes, secondBytes);
+}
+
+// Sorts the names of a known order, which doesn't depend on the CompareStringW the random names
+// are checked against.
+static HRESULT INCALESCENT_StringTest_Fixed(INCALESCENT_Arena *arena) {
+    PWSTR sorted[ARRAYSIZE(INCALESCENT_StringTest_Unsorted)];
+    for (SIZE_T index = 0; index < ARRAYSIZE(sorted); index++) {
+        sorted[index] = (PWSTR) INCALESCENT_StringTest_Unsorted[index];
+    }
+
+    HRESULT result = INCALESCENT_String_NaturalSort(sorted, ARRAYSIZE(sorted), arena, NULL);
+    if (FAILED(result)) {
+        return result;
+    }
+    for (SIZE_T index = 0; index < ARRAYSIZE(sorted); index++) {
+        if (CompareStringOrdinal(sorted[index], -1, INCALESCENT_StringTest_Sorted[index], -1, FALSE) != CSTR_EQUAL) {
+            INCALESCENT_StringTest_Print("sorted a name where another belongs", sorted[index], INCALESCENT_StringTest_Sorted[index]);
+            return E_FAIL;
+        }
+    }
+    return S_OK;
+}
+
+// Sorts count random names and checks that every name is still there, once, and that no name
+// compares greater than the one after it.
+static HRESULT INCALESCENT_StringTest_Sort(ULONGLONG *state, SIZE_T count, INCALESCENT_Arena *arena, INCALESCENT_Pool *pool) {
+    HRESULT result = S_OK;
+    HANDLE heap = GetProcessHeap();
+    PWSTR names = HeapAlloc(heap, 0, sizeof(WCHAR) * INCALESCENT_STRING_TEST_MAX_LENGTH * count);
+    PWSTR *sorted = HeapAlloc(heap, 0, sizeof(PWSTR) * count);
+    PBYTE seen = HeapAlloc(heap, HEAP_ZERO_MEMORY, count);
+    if (names == NULL || sorted == NULL || seen == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+
+    for (SIZE_T index = 0; index < count; index++) {
+        sorted[index] = names + (INCALESCENT_STRING_TEST_MAX_LENGTH * index);
+        INCALESCENT_StringTest_Generate(state, sorted[index]);
+    }
+    result = INCALESCENT_String_NaturalSort(sorted, count, arena, pool);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    for (SIZE_T index = 0; index < count; index++) {
+        SIZE_T original = (SIZE_T) (sorted[index] - names) / INCALESCENT_STRING_TEST_MAX_LENGTH;
+        if (seen[original]) {
+            printf("name %llu was sorted twice\n", (ULONGLONG) original);
+            result = E_FAIL;
+            goto cleanup;
+        }
+        seen[original] = TRUE;
+
+        if (index != 0 && INCALESCENT_StringTest_Compare(sorted[index - 1], sorted[index]) == CSTR_GREATER_THAN) {
+            INCALESCENT_StringTest_Print("sorted out of order", sorted[index - 1], sorted[index]);
+            result = E_FAIL;
+            goto cleanup;
+        }
+    }
+
+    cleanup:
+    HeapFree(heap, 0, seen);
+    HeapFree(heap, 0, sorted);
+    HeapFree(heap, 0, names);
+    return result;
+}
+
+// Checks that the sort keys of random pairs of names order them like CompareStringW does, which
+// the merges of an external sort rely on.
+static HRESULT INCALESCENT_StringTest_Keys(ULONGLONG *state) {
+    static BYTE firstKey[INCALESCENT_STRING_SORT_KEY_MAX_SIZE];
+    static BYTE secondKey[INCALESCENT_STRING_SORT_KEY_MAX_SIZE];
+    WCHAR first[INCALESCENT_STRING_TEST_MAX_LENGTH];
+    WCHAR second[INCALESCENT_STRING_TEST_MAX_LENGTH];
+
+    for (SIZE_T pair = 0; pair < INCALESCENT_STRING_TEST_PAIR_COUNT; pair++) {
+        INCALESCENT_StringTest_Generate(state, first);
+
+        // Half of the pairs differ only in case or in one digit, which the random pairs rarely do.
+        CopyMemory(second, first, sizeof(first));
+        SIZE_T length = lstrlenW(second);
+        if (pair % 2 == 0 || length == 0) {
+            INCALESCENT_StringTest_Generate(state, second);
+        } else {
+            SIZE_T position = INCALESCENT_StringTest_Below(state, length);
+            if (second[position] >= L'0' && second[position] <= L'9') {
+                second[position] = (WCHAR) (L'0' + INCALESCENT_StringTest_Below(state, 10));
+            } else if (second[position] >= L'a' && second[position] <= L'z') {
+                second[position] -= L'a' - L'A';
+            }
+        }
+
+        SIZE_T firstLength = 0;
+        SIZE_T secondLength = 0;
+        HRESULT result = INCALESCENT_String_SortKey(first, firstKey, &firstLength);
+        if (SUCCEEDED(result)) {
+            result = INCALESCENT_String_SortKey(second, secondKey, &secondLength);
+        }
+        if (FAILED(result)) {
+            return result;
+        }
+
+        INT keyComparison = INCALESCENT_String_CompareKeys(firstKey, firstLength, secondKey, secondLength);
+        INT comparison = INCALESCENT_StringTest_Compare(first, second);
+        INT expected = comparison == CSTR_LESS_THAN ? -1 : (comparison == CSTR_GREATER_THAN ? 1 : 0);
+        if ((keyComparison > 0) - (keyComparison < 0) != expected) {
+            INCALESCENT_StringTest_Print("keys order differently", first, second);
+            return E_FAIL;
+        }
+    }
+    return S_OK;
+}
+
+INT wmain(INT argumentCount, PWSTR *arguments) {
+    HRESULT result = S_OK;
+    INCALESCENT_Arena arena = {0};
+    INCALESCENT_Pool *pool = NULL;
+    ULONGLONG seed = INCALESCENT_STRING_TEST_DEFAULT_SEED;
+
+    if (argumentCount > 1) {
+        seed = 0;
+        for (PCWSTR digit = arguments[1]; *digit >= L'0' && *digit <= L'9'; digit++) {
+            seed = (seed * 10) + (*digit - L'0');
+        }
+        seed = seed == 0 ? INCALESCENT_STRING_TEST_DEFAULT_SEED : seed;
+    }
+
+    result = INCALESCENT_Arena_Create(&arena, INCALESCENT_STRING_TEST_ARENA_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Pool_Create(INCALESCENT_STRING_TEST_WORKERS, &pool);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_StringTest_Fixed(&arena);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    ULONGLONG state = seed;
+    for (DWORD round = 0; round < INCALESCENT_STRING_TEST_ROUNDS; round++) {
+        // The large sorts are spread over the pool, while the small ones stay on this thread.
+        result = INCALESCENT_StringTest_Sort(&state, INCALESCENT_STRING_TEST_LARGE_COUNT, &arena, pool);
+        if (SUCCEEDED(result)) {
+            result = INCALESCENT_StringTest_Sort(&state, INCALESCENT_STRING_TEST_SMALL_COUNT, &arena, NULL);
+        }
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+    result = INCALESCENT_StringTest_Keys(&state);
+
+    cleanup:
+    INCALESCENT_Pool_Destroy(pool);
+    INCALESCENT_Arena_Destroy(&arena);
+    if (FAILED(result)) {
+        printf("string test failed with seed %llu (0x%08x)\n", seed, (unsigned int) result);
+        return 1;
+    }
+    return 0;
+}
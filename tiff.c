@@ -0,0 +1,172 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "tiff.h"
+
+// The layout of a file, which depends on its byte order and on whether it is a BigTIFF file.
+typedef struct INCALESCENT_Tiff_Layout {
+    const BYTE *data;
+    SIZE_T size;
+    BOOL bigEndian;
+
+    // The width of an entry count, of an entry, and of a value or offset in bytes.
+    DWORD countWidth;
+    DWORD entryWidth;
+    DWORD offsetWidth;
+} INCALESCENT_Tiff_Layout;
+
+static BOOL INCALESCENT_Tiff_InRange(const INCALESCENT_Tiff_Layout *layout, ULONGLONG offset, ULONGLONG length) {
+    return offset <= layout->size && length <= layout->size - offset;
+}
+
+// Reads an unsigned integer of 2, 4 or 8 bytes that is known to be within the file.
+static ULONGLONG INCALESCENT_Tiff_Read(const INCALESCENT_Tiff_Layout *layout, ULONGLONG offset, DWORD width) {
+    const BYTE *bytes = layout->data + offset;
+    ULONGLONG value = 0;
+    for (DWORD index = 0; index < width; index++) {
+        DWORD shift = layout->bigEndian ? 8 * (width - 1 - index) : 8 * index;
+        value |= (ULONGLONG) bytes[index] << shift;
+    }
+    return value;
+}
+
+// Passes the text of a tag on a null-terminated piece at a time. Empty pieces are skipped.
+static HRESULT INCALESCENT_Tiff_PassText(const BYTE *text, SIZE_T length, INCALESCENT_Tiff_TextCallback callback, PVOID context) {
+    HRESULT result = S_OK;
+    const BYTE *end = text + length;
+    while (text < end && result == S_OK) {
+        const BYTE *pieceEnd = text;
+        while (pieceEnd < end && *pieceEnd != '\0') {
+            pieceEnd++;
+        }
+        if (pieceEnd != text) {
+            result = callback(context, text, pieceEnd - text);
+        }
+        text = pieceEnd + 1;
+    }
+    return result;
+}
+
+// Passes on the text of every tag of a directory, and of the Exif directory it points to unless it
+// is one itself. Receives the offset of the next directory in the chain, which is 0 for the last.
+static HRESULT INCALESCENT_Tiff_WalkDirectory(const INCALESCENT_Tiff_Layout *layout, ULONGLONG offset, BOOL exif,
+                                              INCALESCENT_Tiff_TextCallback callback, PVOID context, ULONGLONG *next) {
+    HRESULT result = S_OK;
+
+    if (!INCALESCENT_Tiff_InRange(layout, offset, layout->countWidth)) {
+        result = HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+        goto cleanup;
+    }
+    ULONGLONG entryCount = INCALESCENT_Tiff_Read(layout, offset, layout->countWidth);
+    ULONGLONG entries = offset + layout->countWidth;
+    if (entryCount > (layout->size - entries) / layout->entryWidth ||
+        !INCALESCENT_Tiff_InRange(layout, entries + (entryCount * layout->entryWidth), layout->offsetWidth)) {
+        result = HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+        goto cleanup;
+    }
+
+    for (ULONGLONG index = 0; index < entryCount && result == S_OK; index++) {
+        // A tag, a type, a value count and either the value itself, if it fits, or its offset.
+        ULONGLONG entry = entries + (index * layout->entryWidth);
+        ULONGLONG tag = INCALESCENT_Tiff_Read(layout, entry, 2);
+        ULONGLONG type = INCALESCENT_Tiff_Read(layout, entry + 2, 2);
+        ULONGLONG count = INCALESCENT_Tiff_Read(layout, entry + 4, layout->offsetWidth);
+        ULONGLONG value = entry + 4 + layout->offsetWidth;
+
+        if (type == INCALESCENT_TIFF_TYPE_BYTE || type == INCALESCENT_TIFF_TYPE_ASCII || type == INCALESCENT_TIFF_TYPE_UNDEFINED) {
+            if (count == 0 || count > INCALESCENT_TIFF_MAX_TEXT_SIZE) {
+                continue;
+            }
+            ULONGLONG textOffset = count <= layout->offsetWidth ? value : INCALESCENT_Tiff_Read(layout, value, layout->offsetWidth);
+            if (!INCALESCENT_Tiff_InRange(layout, textOffset, count)) {
+                result = HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+                goto cleanup;
+            }
+            result = INCALESCENT_Tiff_PassText(layout->data + textOffset, (SIZE_T) count, callback, context);
+            continue;
+        }
+
+        if (tag == INCALESCENT_TIFF_TAG_EXIF && !exif && count == 1) {
+            DWORD width = type == INCALESCENT_TIFF_TYPE_LONG || type == INCALESCENT_TIFF_TYPE_IFD ? 4 :
+                          type == INCALESCENT_TIFF_TYPE_LONG8 || type == INCALESCENT_TIFF_TYPE_IFD8 ? 8 : 0;
+            if (width != 0 && width <= layout->offsetWidth) {
+                result = INCALESCENT_Tiff_WalkDirectory(layout, INCALESCENT_Tiff_Read(layout, value, width), TRUE, callback, context, NULL);
+            }
+        }
+    }
+    if (result != S_OK) {
+        goto cleanup;
+    }
+
+    if (next != NULL) {
+        *next = INCALESCENT_Tiff_Read(layout, entries + (entryCount * layout->entryWidth), layout->offsetWidth);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Tiff_ForEachText
+HRESULT INCALESCENT_Tiff_ForEachText(const BYTE *data, SIZE_T size, INCALESCENT_Tiff_TextCallback callback, PVOID context) {
+    HRESULT result = S_OK;
+    INCALESCENT_Tiff_Layout layout = {.data = data, .size = size};
+    ULONGLONG offset = 0;
+
+    // The byte order, the version and the offset of the first directory. A BigTIFF header also
+    // gives the width of its offsets, which is always 8.
+    if (size < 8) {
+        result = HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+        goto cleanup;
+    }
+    DWORD order = data[0] | ((DWORD) data[1] << 8);
+    if (order != INCALESCENT_TIFF_LITTLE_ENDIAN && order != INCALESCENT_TIFF_BIG_ENDIAN) {
+        result = HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+        goto cleanup;
+    }
+    layout.bigEndian = order == INCALESCENT_TIFF_BIG_ENDIAN;
+
+    ULONGLONG version = INCALESCENT_Tiff_Read(&layout, 2, 2);
+    if (version == INCALESCENT_TIFF_VERSION) {
+        layout.countWidth = 2;
+        layout.entryWidth = 12;
+        layout.offsetWidth = 4;
+        offset = INCALESCENT_Tiff_Read(&layout, 4, 4);
+    } else if (version == INCALESCENT_TIFF_BIG_VERSION && size >= 16 && INCALESCENT_Tiff_Read(&layout, 4, 2) == 8 &&
+               INCALESCENT_Tiff_Read(&layout, 6, 2) == 0) {
+        layout.countWidth = 8;
+        layout.entryWidth = 20;
+        layout.offsetWidth = 8;
+        offset = INCALESCENT_Tiff_Read(&layout, 8, 8);
+    } else {
+        result = HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+        goto cleanup;
+    }
+
+    for (DWORD directory = 0; offset != 0 && directory < INCALESCENT_TIFF_MAX_DIRECTORIES && result == S_OK; directory++) {
+        result = INCALESCENT_Tiff_WalkDirectory(&layout, offset, FALSE, callback, context, &offset);
+    }
+
+    cleanup:
+    return result == S_FALSE ? S_OK : result;
+}
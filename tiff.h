@@ -0,0 +1,83 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_TIFF_H
+#define INCALESCENT_TIFF_H
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* PVOID;
+typedef unsigned char BYTE;
+typedef unsigned __int64 SIZE_T;
+
+// The byte orders a file can start with, and the versions of classic TIFF and BigTIFF.
+#define INCALESCENT_TIFF_LITTLE_ENDIAN 0x4949 // "II"
+#define INCALESCENT_TIFF_BIG_ENDIAN 0x4D4D // "MM"
+#define INCALESCENT_TIFF_VERSION 42
+#define INCALESCENT_TIFF_BIG_VERSION 43
+
+// The types of the tags whose values are searched as text.
+#define INCALESCENT_TIFF_TYPE_BYTE 1
+#define INCALESCENT_TIFF_TYPE_ASCII 2
+#define INCALESCENT_TIFF_TYPE_UNDEFINED 7
+
+// The tag that points to the Exif directory, and the types that pointer can have.
+#define INCALESCENT_TIFF_TAG_EXIF 34665
+#define INCALESCENT_TIFF_TYPE_LONG 4
+#define INCALESCENT_TIFF_TYPE_IFD 13
+#define INCALESCENT_TIFF_TYPE_LONG8 16
+#define INCALESCENT_TIFF_TYPE_IFD8 18
+
+// A file with more directories than this is almost certainly corrupt, and its chain may well loop.
+#define INCALESCENT_TIFF_MAX_DIRECTORIES 1024
+
+// Tag values longer than this are left out, so binary blobs such as color profiles aren't searched.
+#define INCALESCENT_TIFF_MAX_TEXT_SIZE (1024 * 1024)
+
+/**
+ * @brief Receives a piece of text from a tag.
+ *
+ * @return S_OK to go on with the next piece, S_FALSE to stop the walk or a failure to abort it.
+ */
+typedef HRESULT (*INCALESCENT_Tiff_TextCallback)(PVOID context, const BYTE *text, SIZE_T length);
+
+/**
+ * @brief Walks the directories of a TIFF file in memory and passes the text of its tags on.
+ *
+ * Both byte orders, classic TIFF and BigTIFF are understood. The chain of image directories is
+ * followed, along with the Exif directory of each. Every tag of type BYTE, ASCII or UNDEFINED is
+ * passed on in place, split at its null characters, so none of it is copied and nothing but the
+ * header, the directories and the text itself is ever touched. The image data isn't read at all,
+ * which keeps the pages of a mapped file that are faulted in to a few.
+ *
+ * @param[in] data      The file.
+ * @param[in] size      The size of the file in bytes.
+ * @param[in] callback  Called for every piece of text, in the order of the directories and tags.
+ * @param[in] context   Passed on to the callback.
+ *
+ * @return S_OK if the walk finished or was stopped, HRESULT_FROM_WIN32(ERROR_BAD_FORMAT) if the data
+ *         isn't a TIFF file or points outside of itself, or the failure of the callback.
+ */
+HRESULT INCALESCENT_Tiff_ForEachText(const BYTE *data, SIZE_T size, INCALESCENT_Tiff_TextCallback callback, PVOID context);
+
+#endif //INCALESCENT_TIFF_H
@@ -0,0 +1,275 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "tree.h"
+#include "table.h"
+#include "log.h"
+#include "pool.h"
+#include "cache.h"
+#include "walk.h"
+#include "perf.h"
+#include "generated_error.h"
+
+// Copies the name of a data file found by a walk into the list as a path relative to the root of
+// the walk, keeping the file's information.
+static HRESULT INCALESCENT_Tree_AppendRelativeName(INCALESCENT_File_Names *names, INCALESCENT_Walk_Directory *directory, PWSTR name) {
+    HRESULT result = S_OK;
+    INCALESCENT_File_NameInfo *info = NULL;
+    PWSTR *entry = NULL;
+    const INCALESCENT_File_NameInfo *nameInfo = INCALESCENT_FILE_NAME_INFO(name);
+    SIZE_T prefixLength = directory->relativeLength == 0 ? 0 : directory->relativeLength + 1;
+    SIZE_T length = prefixLength + nameInfo->length;
+
+    result = INCALESCENT_Arena_Allocate(names->arena, sizeof(INCALESCENT_File_NameInfo) + sizeof(WCHAR) * (length + 1),
+                                        sizeof(ULONGLONG), (PVOID *) &info);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    *info = *nameInfo;
+    info->length = length;
+
+    PWSTR relativeName = (PWSTR) (info + 1);
+    if (prefixLength != 0) {
+        CopyMemory(relativeName, directory->relativePath, sizeof(WCHAR) * directory->relativeLength);
+        relativeName[directory->relativeLength] = L'\\';
+    }
+    CopyMemory(relativeName + prefixLength, name, sizeof(WCHAR) * (nameInfo->length + 1));
+
+    result = INCALESCENT_Arena_Allocate(&names->index, sizeof(PWSTR), sizeof(PWSTR), (PVOID *) &entry);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    *entry = relativeName;
+
+    names->entries = (PWSTR *) names->index.base;
+    names->count++;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Tree_Consolidate
+HRESULT INCALESCENT_Tree_Consolidate(INCALESCENT_File_Session *session, PWSTR rootDirectory, PWSTR consolidatedFile, HANDLE file) {
+    HRESULT result = S_OK;
+    const INCALESCENT_File_Options *options = &session->options;
+    INCALESCENT_File_Names *names = &session->names;
+    INCALESCENT_Walk *walk = NULL;
+    INCALESCENT_Cache cache = {0};
+    INCALESCENT_Table table = {0};
+    INCALESCENT_Arena trees[3] = {0};
+    INCALESCENT_Arena *valueArena = &trees[0];
+    INCALESCENT_Arena *indexArena = &trees[1];
+    INCALESCENT_Arena *numberArena = &trees[2];
+    BOOL columnar = options->format == INCALESCENT_FILE_FORMAT_COLUMNAR;
+    DWORD fieldCount = session->fieldCount;
+
+    // The values and numbers have to stay contiguous arrays as directories are added, so they get
+    // arenas of their own. The index arena holds the files to read of one batch at a time.
+    result = INCALESCENT_Arena_Create(valueArena, INCALESCENT_FILE_NAME_INDEX_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Create(numberArena, INCALESCENT_FILE_NAME_INDEX_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Create(indexArena, INCALESCENT_FILE_NAME_INDEX_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    if (options->cache) {
+        ULONGLONG loading = INCALESCENT_Perf_Now();
+        result = INCALESCENT_Cache_Load(&cache, consolidatedFile, session->keys, session->keysSize, &session->arena);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_CACHE, loading);
+    }
+
+    result = INCALESCENT_Table_CreateStatistics(&table, session);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Walk_Create(rootDirectory, session->suffix, options->cache, INCALESCENT_FILE_WALK_WORKERS, &walk);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    SIZE_T fileCount = 0;
+    SIZE_T directoryCount = 0;
+    SIZE_T cachedCount = 0;
+    for (;;) {
+        INCALESCENT_Walk_Directory *finished = NULL;
+        ULONGLONG walking = INCALESCENT_Perf_Now();
+        result = INCALESCENT_Walk_Next(walk, &finished);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        INCALESCENT_Perf_Record(INCALESCENT_PERF_PHASE_ENUMERATE, walking);
+        if (result == S_FALSE) {
+            result = S_OK;
+            break;
+        }
+
+        // Give every file of the listed directories a slot, taking the values of unchanged files
+        // from the cache and queuing the rest to be read.
+        INCALESCENT_Arena_Reset(indexArena, 0);
+        SIZE_T readCount = 0;
+        for (INCALESCENT_Walk_Directory *directory = finished; directory != NULL; directory = directory->next) {
+            directoryCount++;
+            directory->firstFile = fileCount;
+
+            PVOID directoryValues = NULL;
+            result = INCALESCENT_Arena_Allocate(valueArena, sizeof(INCALESCENT_File_Value) * fieldCount * directory->fileCount,
+                                                sizeof(WCHAR), &directoryValues);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+            INCALESCENT_File_Value *values = (PVOID) valueArena->base;
+            if (columnar) {
+                PVOID directoryNumbers = NULL;
+                result = INCALESCENT_Arena_Allocate(numberArena, sizeof(DOUBLE) * fieldCount * directory->fileCount, sizeof(DOUBLE), &directoryNumbers);
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+            }
+            DOUBLE *numbers = (PVOID) numberArena->base;
+
+            for (SIZE_T index = 0; index < directory->fileCount; index++) {
+                result = INCALESCENT_Tree_AppendRelativeName(names, directory, directory->files[index]);
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+
+                if (options->cache && INCALESCENT_File_LookupValues(&cache, names->entries[fileCount], fieldCount, values + (fileCount * fieldCount))) {
+                    if (columnar) {
+                        INCALESCENT_File_ParseValues(values + (fileCount * fieldCount), fieldCount, numbers + (fileCount * fieldCount));
+                    }
+                    if (table.statistics != NULL) {
+                        INCALESCENT_File_AddStatistics(INCALESCENT_Table_SharedStatistics(&table), values + (fileCount * fieldCount),
+                                                       columnar ? numbers + (fileCount * fieldCount) : NULL, fieldCount);
+                    }
+                    cachedCount++;
+                } else {
+                    SIZE_T *slot = NULL;
+                    result = INCALESCENT_Arena_Allocate(indexArena, sizeof(SIZE_T), sizeof(SIZE_T), (PVOID *) &slot);
+                    if (FAILED(result)) {
+                        goto cleanup;
+                    }
+                    *slot = fileCount;
+                    readCount++;
+                }
+                fileCount++;
+            }
+        }
+
+        INCALESCENT_File_ReadContext context = {
+                .dataDirectory = rootDirectory,
+                .names = names->entries,
+                .values = (PVOID) valueArena->base,
+                .match = session->match,
+                .fieldCount = fieldCount,
+                .io = session->io,
+                .numbers = columnar ? (PVOID) numberArena->base : NULL,
+                .statistics = table.statistics,
+                .hint = &session->readHint,
+                .indices = (SIZE_T *) indexArena->base,
+                .tiff = options->source == INCALESCENT_FILE_SOURCE_TIFF,
+        };
+        result = INCALESCENT_File_ReadFiles(session, &context, readCount);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    INCALESCENT_Perf_Count(INCALESCENT_PERF_COUNTER_FILES_CACHED, cachedCount);
+    result = INCALESCENT_LOG_INFO_FORMATTED_W(L"Found %llu valid data files in %llu directories, %llu of them cached...",
+                                              (ULONGLONG) fileCount, (ULONGLONG) directoryCount, (ULONGLONG) cachedCount);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    if (fileCount == 0) {
+        result = INCALESCENT_ERROR_NO_DATA_FILES_FOUND;
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Table_Begin(&table, session, consolidatedFile, file, fileCount, TRUE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    // Visit the tree depth-first, pushing the subdirectories last to first so they come off the
+    // stack in order. The stack never holds more than every directory at once.
+    INCALESCENT_File_Value *values = (PVOID) valueArena->base;
+    DOUBLE *numbers = (PVOID) numberArena->base;
+    INCALESCENT_Walk_Directory **stack = NULL;
+    INCALESCENT_Arena_Reset(indexArena, 0);
+    result = INCALESCENT_Arena_Allocate(indexArena, sizeof(INCALESCENT_Walk_Directory *) * directoryCount, sizeof(PVOID), (PVOID *) &stack);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    SIZE_T stackCount = 0;
+    SIZE_T row = 0;
+    stack[stackCount++] = INCALESCENT_Walk_Root(walk);
+    while (stackCount != 0) {
+        INCALESCENT_Walk_Directory *directory = stack[--stackCount];
+
+        for (SIZE_T index = 0; index < directory->fileCount; index++) {
+            PWSTR fileName = directory->files[index];
+            SIZE_T slot = directory->firstFile + index;
+            result = INCALESCENT_Table_AppendRow(&table, row, directory->relativePath, directory->relativeLength, fileName,
+                                                 INCALESCENT_FILE_NAME_INFO(fileName)->length, values + (slot * fieldCount),
+                                                 columnar ? numbers + (slot * fieldCount) : NULL);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+            row++;
+
+            if (options->cache) {
+                result = INCALESCENT_File_RecordValues(&cache, names->entries[slot], fieldCount, values + (slot * fieldCount));
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+            }
+        }
+
+        for (SIZE_T index = directory->childCount; index > 0; index--) {
+            stack[stackCount++] = directory->children[index - 1];
+        }
+    }
+
+    INCALESCENT_Arena used[3] = {*valueArena, *indexArena, *numberArena};
+    result = INCALESCENT_Table_End(&table, session, consolidatedFile, file, options->cache ? &cache : NULL, used, 3);
+
+    cleanup:
+    INCALESCENT_Table_Destroy(&table);
+    INCALESCENT_Walk_Destroy(walk);
+    INCALESCENT_Cache_Destroy(&cache);
+    INCALESCENT_Arena_Destroy(numberArena);
+    INCALESCENT_Arena_Destroy(indexArena);
+    INCALESCENT_Arena_Destroy(valueArena);
+    return result;
+}
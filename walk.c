@@ -0,0 +1,328 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#include "walk.h"
+#include "string.h"
+
+typedef struct DECLSPEC_CACHEALIGN INCALESCENT_WalkWorker {
+    struct INCALESCENT_Walk *walk;
+    HANDLE thread;
+
+    // The directories a worker lists live in its own arena. The two name lists are only used
+    // while a directory is being listed and are copied into the arena afterward.
+    INCALESCENT_Arena arena;
+    INCALESCENT_File_Names files;
+    INCALESCENT_File_Names directories;
+} INCALESCENT_WalkWorker;
+
+struct INCALESCENT_Walk {
+    INCALESCENT_WalkWorker *workers;
+    DWORD workerCount;
+    INCALESCENT_Walk_Directory *root;
+    SIZE_T rootLength;
+    PCWSTR suffix;
+    BOOL details;
+
+    SRWLOCK lock;
+    CONDITION_VARIABLE queued;
+    CONDITION_VARIABLE listed;
+
+    // The directories waiting to be listed, the directories listed but not yet returned, and the
+    // number of directories queued or being listed. The walk is over once that number is zero.
+    INCALESCENT_Walk_Directory *queue;
+    INCALESCENT_Walk_Directory *finished;
+    SIZE_T outstanding;
+    BOOL shutdown;
+    HRESULT result;
+};
+
+// Creates the record of a directory below another one.
+static HRESULT INCALESCENT_Walk_CreateChild(INCALESCENT_WalkWorker *worker, INCALESCENT_Walk_Directory *parent, PWSTR name,
+                                            INCALESCENT_Walk_Directory **child) {
+    HRESULT result = S_OK;
+    INCALESCENT_Walk_Directory *intermediate = NULL;
+    SIZE_T nameLength = INCALESCENT_FILE_NAME_INFO(name)->length;
+    SIZE_T parentLength = (parent->relativePath - parent->path) + parent->relativeLength;
+    SIZE_T pathLength = parentLength + 1 + nameLength;
+
+    result = INCALESCENT_Arena_Allocate(&worker->arena, sizeof(INCALESCENT_Walk_Directory) + sizeof(WCHAR) * (pathLength + 1),
+                                        sizeof(PVOID), (PVOID *) &intermediate);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(intermediate, sizeof(INCALESCENT_Walk_Directory));
+
+    intermediate->path = (PWSTR) (intermediate + 1);
+    CopyMemory(intermediate->path, parent->path, sizeof(WCHAR) * parentLength);
+    intermediate->path[parentLength] = L'\\';
+    CopyMemory(intermediate->path + parentLength + 1, name, sizeof(WCHAR) * (nameLength + 1));
+
+    // Below the root, the relative path starts right after the root and its separator.
+    SIZE_T rootLength = worker->walk->rootLength;
+    intermediate->relativePath = intermediate->path + rootLength + 1;
+    intermediate->relativeLength = pathLength - (rootLength + 1);
+
+    *child = intermediate;
+
+    cleanup:
+    return result;
+}
+
+// Lists a directory, filling in its data files and creating the records of its subdirectories.
+static HRESULT INCALESCENT_Walk_List(INCALESCENT_WalkWorker *worker, INCALESCENT_Walk_Directory *directory) {
+    HRESULT result = S_OK;
+
+    INCALESCENT_File_ClearNames(&worker->files);
+    INCALESCENT_File_ClearNames(&worker->directories);
+    result = INCALESCENT_File_Enumerate(directory->path, worker->walk->suffix, worker->walk->details, &worker->files, &worker->directories);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_String_NaturalSort(worker->files.entries, worker->files.count, &worker->arena, NULL);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_String_NaturalSort(worker->directories.entries, worker->directories.count, &worker->arena, NULL);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    directory->fileCount = worker->files.count;
+    result = INCALESCENT_Arena_Allocate(&worker->arena, sizeof(PWSTR) * directory->fileCount, sizeof(PWSTR), (PVOID *) &directory->files);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    CopyMemory(directory->files, worker->files.entries, sizeof(PWSTR) * directory->fileCount);
+
+    directory->childCount = worker->directories.count;
+    result = INCALESCENT_Arena_Allocate(&worker->arena, sizeof(INCALESCENT_Walk_Directory *) * directory->childCount, sizeof(PVOID),
+                                        (PVOID *) &directory->children);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    for (SIZE_T index = 0; index < directory->childCount; index++) {
+        result = INCALESCENT_Walk_CreateChild(worker, directory, worker->directories.entries[index], &directory->children[index]);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    cleanup:
+    return result;
+}
+
+static DWORD WINAPI INCALESCENT_Walk_ThreadStart(LPVOID parameter) {
+    INCALESCENT_WalkWorker *worker = parameter;
+    INCALESCENT_Walk *walk = worker->walk;
+
+    AcquireSRWLockExclusive(&walk->lock);
+    for (;;) {
+        while (walk->queue == NULL && walk->outstanding != 0 && !walk->shutdown && SUCCEEDED(walk->result)) {
+            SleepConditionVariableSRW(&walk->queued, &walk->lock, INFINITE, 0);
+        }
+        if (walk->queue == NULL || walk->shutdown || FAILED(walk->result)) {
+            break;
+        }
+
+        INCALESCENT_Walk_Directory *directory = walk->queue;
+        walk->queue = directory->next;
+        ReleaseSRWLockExclusive(&walk->lock);
+
+        HRESULT result = INCALESCENT_Walk_List(worker, directory);
+
+        AcquireSRWLockExclusive(&walk->lock);
+        if (FAILED(result)) {
+            if (SUCCEEDED(walk->result)) {
+                walk->result = result;
+            }
+            WakeAllConditionVariable(&walk->queued);
+            WakeAllConditionVariable(&walk->listed);
+            break;
+        }
+
+        // Queue the subdirectories last to first, so the first one is listed next. That keeps
+        // the walk close to depth-first and the listed directories close to their final order.
+        for (SIZE_T index = directory->childCount; index > 0; index--) {
+            INCALESCENT_Walk_Directory *child = directory->children[index - 1];
+            child->next = walk->queue;
+            walk->queue = child;
+        }
+        walk->outstanding += directory->childCount;
+        walk->outstanding--;
+
+        directory->next = walk->finished;
+        walk->finished = directory;
+
+        if (directory->childCount != 0 || walk->outstanding == 0) {
+            WakeAllConditionVariable(&walk->queued);
+        }
+        WakeAllConditionVariable(&walk->listed);
+    }
+    ReleaseSRWLockExclusive(&walk->lock);
+
+    return 0;
+}
+
+// Implementation for INCALESCENT_Walk_Create
+HRESULT INCALESCENT_Walk_Create(PWSTR root, PCWSTR suffix, BOOL details, DWORD workerCount, INCALESCENT_Walk **walk) {
+    HRESULT result = S_OK;
+    HANDLE heap = GetProcessHeap();
+    DWORD createdCount = 0;
+
+    if (workerCount == 0) {
+        workerCount = 1;
+    }
+    if (workerCount > INCALESCENT_WALK_MAX_WORKERS) {
+        workerCount = INCALESCENT_WALK_MAX_WORKERS;
+    }
+
+    INCALESCENT_Walk *intermediate = HeapAlloc(heap, HEAP_ZERO_MEMORY, sizeof(INCALESCENT_Walk));
+    if (intermediate == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+    InitializeSRWLock(&intermediate->lock);
+    InitializeConditionVariable(&intermediate->queued);
+    InitializeConditionVariable(&intermediate->listed);
+
+    intermediate->workers = HeapAlloc(heap, HEAP_ZERO_MEMORY, sizeof(INCALESCENT_WalkWorker) * workerCount);
+    if (intermediate->workers == NULL) {
+        result = E_OUTOFMEMORY;
+        goto cleanup;
+    }
+
+    // Every worker gets its memory before any thread starts, so a failure never has to stop threads
+    // that are already walking.
+    for (; createdCount < workerCount; createdCount++) {
+        INCALESCENT_WalkWorker *worker = &intermediate->workers[createdCount];
+        worker->walk = intermediate;
+
+        result = INCALESCENT_Arena_Create(&worker->arena, INCALESCENT_WALK_ARENA_RESERVE);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_File_CreateNames(&worker->files, &worker->arena);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        result = INCALESCENT_File_CreateNames(&worker->directories, &worker->arena);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    }
+
+    SIZE_T rootLength = lstrlenW(root);
+    result = INCALESCENT_Arena_Allocate(&intermediate->workers[0].arena, sizeof(INCALESCENT_Walk_Directory), sizeof(PVOID),
+                                        (PVOID *) &intermediate->root);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(intermediate->root, sizeof(INCALESCENT_Walk_Directory));
+    intermediate->root->path = root;
+    intermediate->root->relativePath = root + rootLength;
+    intermediate->rootLength = rootLength;
+    intermediate->suffix = suffix;
+    intermediate->details = details;
+    intermediate->queue = intermediate->root;
+    intermediate->outstanding = 1;
+
+    for (DWORD index = 0; index < workerCount; index++) {
+        INCALESCENT_WalkWorker *worker = &intermediate->workers[index];
+        worker->thread = CreateThread(NULL, 0, INCALESCENT_Walk_ThreadStart, worker, 0, NULL);
+        if (worker->thread == NULL) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        intermediate->workerCount = index + 1;
+    }
+
+    *walk = intermediate;
+    intermediate = NULL;
+
+    cleanup:
+    if (intermediate != NULL) {
+        // Workers without a thread still own memory that has to be released.
+        for (DWORD index = intermediate->workerCount; index < createdCount; index++) {
+            INCALESCENT_File_FreeNames(&intermediate->workers[index].directories);
+            INCALESCENT_File_FreeNames(&intermediate->workers[index].files);
+            INCALESCENT_Arena_Destroy(&intermediate->workers[index].arena);
+        }
+        INCALESCENT_Walk_Destroy(intermediate);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Walk_Next
+HRESULT INCALESCENT_Walk_Next(INCALESCENT_Walk *walk, INCALESCENT_Walk_Directory **finished) {
+    HRESULT result = S_OK;
+
+    AcquireSRWLockExclusive(&walk->lock);
+    while (walk->finished == NULL && walk->outstanding != 0 && SUCCEEDED(walk->result)) {
+        SleepConditionVariableSRW(&walk->listed, &walk->lock, INFINITE, 0);
+    }
+    if (FAILED(walk->result)) {
+        result = walk->result;
+    } else if (walk->finished == NULL) {
+        result = S_FALSE;
+    }
+    *finished = walk->finished;
+    walk->finished = NULL;
+    ReleaseSRWLockExclusive(&walk->lock);
+
+    return result;
+}
+
+// Implementation for INCALESCENT_Walk_Root
+INCALESCENT_Walk_Directory *INCALESCENT_Walk_Root(INCALESCENT_Walk *walk) {
+    return walk->root;
+}
+
+// Implementation for INCALESCENT_Walk_Destroy
+void INCALESCENT_Walk_Destroy(INCALESCENT_Walk *walk) {
+    HANDLE heap = GetProcessHeap();
+
+    if (walk == NULL) {
+        return;
+    }
+
+    AcquireSRWLockExclusive(&walk->lock);
+    walk->shutdown = TRUE;
+    WakeAllConditionVariable(&walk->queued);
+    ReleaseSRWLockExclusive(&walk->lock);
+
+    if (walk->workers != NULL) {
+        for (DWORD index = 0; index < walk->workerCount; index++) {
+            INCALESCENT_WalkWorker *worker = &walk->workers[index];
+            WaitForSingleObject(worker->thread, INFINITE);
+            CloseHandle(worker->thread);
+            INCALESCENT_File_FreeNames(&worker->directories);
+            INCALESCENT_File_FreeNames(&worker->files);
+            INCALESCENT_Arena_Destroy(&worker->arena);
+        }
+        HeapFree(heap, 0, walk->workers);
+    }
+    HeapFree(heap, 0, walk);
+}
@@ -0,0 +1,96 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_WALK_H
+#define INCALESCENT_WALK_H
+#include "file.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+typedef const WCHAR* PCWSTR;
+typedef unsigned __int64 SIZE_T;
+
+#define INCALESCENT_WALK_MAX_WORKERS 64
+#define INCALESCENT_WALK_ARENA_RESERVE (16ULL * 1024 * 1024 * 1024)
+
+typedef struct INCALESCENT_Walk INCALESCENT_Walk;
+
+typedef struct INCALESCENT_Walk_Directory {
+    // The full path of the directory, and the same path relative to the root, which is empty for
+    // the root itself.
+    PWSTR path;
+    PWSTR relativePath;
+    SIZE_T relativeLength;
+
+    // The data files directly inside the directory, sorted naturally. Every name is stored behind
+    // its INCALESCENT_File_NameInfo.
+    PWSTR *files;
+    SIZE_T fileCount;
+
+    // The subdirectories, sorted naturally by name.
+    struct INCALESCENT_Walk_Directory **children;
+    SIZE_T childCount;
+
+    // Free for the consumer of the walk to use.
+    SIZE_T firstFile;
+
+    // Links the directory into the queue while it waits to be listed, and into the list returned
+    // by INCALESCENT_Walk_Next afterward.
+    struct INCALESCENT_Walk_Directory *next;
+} INCALESCENT_Walk_Directory;
+
+/**
+ * @brief Starts listing a directory tree in the background.
+ *
+ * Every directory is listed by whichever worker is free, and its subdirectories are queued as soon
+ * as it has been listed, so listing latency is spread over all the workers. Reparse points aren't
+ * followed, which keeps links from leading the walk in circles.
+ *
+ * @param[in] root          The root of the tree. It must stay valid until the walk is destroyed.
+ * @param[in] suffix        The suffix of the data files. It must stay valid until the walk is destroyed.
+ * @param[in] details       Whether the size and last write time of every data file are needed.
+ * @param[in] workerCount   The number of directories listed at once.
+ * @param[out] walk         Receives the walk. It must be released with INCALESCENT_Walk_Destroy.
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Walk_Create(PWSTR root, PCWSTR suffix, BOOL details, DWORD workerCount, INCALESCENT_Walk **walk);
+
+/**
+ * @brief Waits for directories to be listed.
+ *
+ * @param[in] walk          The walk.
+ * @param[out] finished     Receives the directories listed since the last call, linked through
+ *                          their next member. They stay valid until the walk is destroyed.
+ *
+ * @return S_OK once at least one directory has been listed, S_FALSE once the whole tree has been
+ *         listed and returned, or the failure that ended the walk.
+ */
+HRESULT INCALESCENT_Walk_Next(INCALESCENT_Walk *walk, INCALESCENT_Walk_Directory **finished);
+
+INCALESCENT_Walk_Directory *INCALESCENT_Walk_Root(INCALESCENT_Walk *walk);
+void INCALESCENT_Walk_Destroy(INCALESCENT_Walk *walk);
+
+#endif //INCALESCENT_WALK_H
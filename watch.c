@@ -0,0 +1,609 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include <strsafe.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#include "watch.h"
+
+#define INCALESCENT_WATCH_PATH_SIZE ((260 * 2) + 2)
+#define INCALESCENT_WATCH_MAX_RETRIES 20
+#ifdef _WIN32
+#define INCALESCENT_WATCH_NOTIFY_FILTER (FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE)
+#else
+#define INCALESCENT_WATCH_NOTIFY_FILTER (IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO)
+#endif
+
+#define INCALESCENT_WATCH_FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define INCALESCENT_WATCH_FNV_PRIME 0x00000100000001B3ULL
+
+typedef enum INCALESCENT_Watch_State {
+    INCALESCENT_WATCH_STATE_KNOWN = 0,
+    INCALESCENT_WATCH_STATE_PENDING = 1,
+} INCALESCENT_Watch_State;
+
+// A file the watch has seen. The name is stored directly after the entry.
+typedef struct INCALESCENT_Watch_Entry {
+    struct INCALESCENT_Watch_Entry *nextPending;
+    ULONGLONG hash;
+    ULONGLONG settleTime;
+    SIZE_T length;
+    INCALESCENT_Watch_State state;
+    DWORD retries;
+} INCALESCENT_Watch_Entry;
+
+struct INCALESCENT_Watch {
+#ifdef _WIN32
+    OVERLAPPED overlapped;
+    HANDLE directory;
+#else
+    // The inotify instance that reports the changes to the directory.
+    INT notify;
+#endif
+    HANDLE stopEvent;
+    PBYTE buffer;
+    PCWSTR directoryPath;
+    PCWSTR suffix;
+    SIZE_T suffixLength;
+
+    // Every file seen so far, in an open-addressing table that is rebuilt at twice the size once
+    // it is half full.
+    INCALESCENT_Watch_Entry **table;
+    SIZE_T tableMask;
+    SIZE_T entryCount;
+    INCALESCENT_Watch_Entry *pending;
+
+    // The entries and tables live for the whole watch, while each batch of settled names is
+    // collected in an arena that is emptied on every call.
+    INCALESCENT_Arena arena;
+    INCALESCENT_Arena batch;
+};
+
+static ULONGLONG INCALESCENT_Watch_Hash(PCWSTR name, SIZE_T nameLength) {
+    ULONGLONG hash = INCALESCENT_WATCH_FNV_OFFSET_BASIS;
+    for (SIZE_T index = 0; index < nameLength; index++) {
+        hash ^= name[index];
+        hash *= INCALESCENT_WATCH_FNV_PRIME;
+    }
+    return hash;
+}
+
+// Rebuilds the table at twice its size. The old table is left behind in the arena, which wastes
+// less memory in total than the final table takes up.
+static HRESULT INCALESCENT_Watch_Grow(INCALESCENT_Watch *watch) {
+    HRESULT result = S_OK;
+    INCALESCENT_Watch_Entry **table = NULL;
+    SIZE_T tableSize = (watch->tableMask + 1) * 2;
+
+    result = INCALESCENT_Arena_Allocate(&watch->arena, sizeof(INCALESCENT_Watch_Entry *) * tableSize,
+                                        sizeof(INCALESCENT_Watch_Entry *), (PVOID *) &table);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(table, sizeof(INCALESCENT_Watch_Entry *) * tableSize);
+
+    for (SIZE_T index = 0; index <= watch->tableMask; index++) {
+        INCALESCENT_Watch_Entry *entry = watch->table[index];
+        if (entry == NULL) {
+            continue;
+        }
+        SIZE_T slot = (SIZE_T) entry->hash & (tableSize - 1);
+        while (table[slot] != NULL) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        table[slot] = entry;
+    }
+    watch->table = table;
+    watch->tableMask = tableSize - 1;
+
+    cleanup:
+    return result;
+}
+
+// Finds the entry of a file, adding a known entry for it if it hasn't been seen before.
+static HRESULT INCALESCENT_Watch_Find(INCALESCENT_Watch *watch, PCWSTR name, SIZE_T nameLength, INCALESCENT_Watch_Entry **found, BOOL *added) {
+    HRESULT result = S_OK;
+    ULONGLONG hash = INCALESCENT_Watch_Hash(name, nameLength);
+    SIZE_T slot = (SIZE_T) hash & watch->tableMask;
+    *added = FALSE;
+
+    for (; watch->table[slot] != NULL; slot = (slot + 1) & watch->tableMask) {
+        INCALESCENT_Watch_Entry *entry = watch->table[slot];
+        if (entry->hash == hash && entry->length == nameLength &&
+            CompareStringOrdinal((PCWSTR) (entry + 1), (INT) nameLength, name, (INT) nameLength, FALSE) == CSTR_EQUAL) {
+            *found = entry;
+            goto cleanup;
+        }
+    }
+
+    INCALESCENT_Watch_Entry *entry = NULL;
+    result = INCALESCENT_Arena_Allocate(&watch->arena, sizeof(INCALESCENT_Watch_Entry) + sizeof(WCHAR) * (nameLength + 1),
+                                        sizeof(ULONGLONG), (PVOID *) &entry);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(entry, sizeof(INCALESCENT_Watch_Entry));
+    entry->hash = hash;
+    entry->length = nameLength;
+    CopyMemory(entry + 1, name, sizeof(WCHAR) * nameLength);
+    ((PWSTR) (entry + 1))[nameLength] = L'\0';
+
+    watch->table[slot] = entry;
+    watch->entryCount++;
+    *found = entry;
+    *added = TRUE;
+
+    if (watch->entryCount * 2 > watch->tableMask + 1) {
+        result = INCALESCENT_Watch_Grow(watch);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Holds a file back for another debounce period.
+static void INCALESCENT_Watch_Defer(INCALESCENT_Watch *watch, INCALESCENT_Watch_Entry *entry) {
+    if (entry->state != INCALESCENT_WATCH_STATE_PENDING) {
+        entry->state = INCALESCENT_WATCH_STATE_PENDING;
+        entry->nextPending = watch->pending;
+        watch->pending = entry;
+    }
+    entry->settleTime = GetTickCount64() + INCALESCENT_WATCH_DEBOUNCE_MILLISECONDS;
+}
+
+// Records a change to a file. A new file starts waiting to settle, and a change to a file that is
+// already waiting starts its wait over.
+static HRESULT INCALESCENT_Watch_Touch(INCALESCENT_Watch *watch, PCWSTR name, SIZE_T nameLength) {
+    HRESULT result = S_OK;
+    INCALESCENT_Watch_Entry *entry = NULL;
+    BOOL added = FALSE;
+
+    if (nameLength <= watch->suffixLength ||
+        CompareStringOrdinal(name + (nameLength - watch->suffixLength), (INT) watch->suffixLength,
+                             watch->suffix, (INT) watch->suffixLength, TRUE) != CSTR_EQUAL) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Watch_Find(watch, name, nameLength, &entry, &added);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    if (added || entry->state == INCALESCENT_WATCH_STATE_PENDING) {
+        INCALESCENT_Watch_Defer(watch, entry);
+    }
+
+    cleanup:
+    return result;
+}
+
+// Touches every data file in the directory. Used when the change buffer overflowed and the
+// individual changes were lost.
+static HRESULT INCALESCENT_Watch_Rescan(INCALESCENT_Watch *watch) {
+    HRESULT result = S_OK;
+    WCHAR pattern[INCALESCENT_WATCH_PATH_SIZE];
+    HANDLE find = INVALID_HANDLE_VALUE;
+
+    result = StringCchPrintfW(pattern, INCALESCENT_WATCH_PATH_SIZE, L"%s\\*%s", watch->directoryPath, watch->suffix);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    WIN32_FIND_DATAW data;
+    find = FindFirstFileExW(pattern, FindExInfoBasic, &data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH | INCALESCENT_FIND_NAMES_ONLY);
+    if (find == INVALID_HANDLE_VALUE) {
+        DWORD lastError = GetLastError();
+        if (lastError != ERROR_FILE_NOT_FOUND) {
+            result = HRESULT_FROM_WIN32(lastError);
+        }
+        goto cleanup;
+    }
+
+    do {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            continue;
+        }
+        result = INCALESCENT_Watch_Touch(watch, data.cFileName, lstrlenW(data.cFileName));
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+    } while (FindNextFileW(find, &data) != FALSE);
+
+    DWORD lastError = GetLastError();
+    if (lastError != ERROR_NO_MORE_FILES) {
+        result = HRESULT_FROM_WIN32(lastError);
+    }
+
+    cleanup:
+    if (find != INVALID_HANDLE_VALUE) {
+        FindClose(find);
+    }
+    return result;
+}
+
+#ifdef _WIN32
+// Starts the next asynchronous read of directory changes.
+static HRESULT INCALESCENT_Watch_Listen(INCALESCENT_Watch *watch) {
+    if (!ReadDirectoryChangesW(watch->directory, watch->buffer, INCALESCENT_WATCH_BUFFER_SIZE, FALSE,
+                               INCALESCENT_WATCH_NOTIFY_FILTER, NULL, &watch->overlapped, NULL)) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    return S_OK;
+}
+
+// Opens the directory and starts reading its changes.
+static HRESULT INCALESCENT_Watch_Open(INCALESCENT_Watch *watch) {
+    watch->overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (watch->overlapped.hEvent == NULL) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    watch->directory = CreateFileW(
+            watch->directoryPath,
+            FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL,
+            OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+            NULL
+    );
+    if (watch->directory == INVALID_HANDLE_VALUE) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    return INCALESCENT_Watch_Listen(watch);
+}
+
+// Waits for the stop event or the read of directory changes, whichever comes first.
+static HRESULT INCALESCENT_Watch_Wait(INCALESCENT_Watch *watch, DWORD timeout, DWORD *waitResult) {
+    HANDLE events[2] = {watch->stopEvent, watch->overlapped.hEvent};
+
+    *waitResult = WaitForMultipleObjects(2, events, FALSE, timeout);
+    if (*waitResult != WAIT_OBJECT_0 && *waitResult != WAIT_OBJECT_0 + 1 && *waitResult != WAIT_TIMEOUT) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    return S_OK;
+}
+
+// Collects the changes of a finished read and starts the next one.
+static HRESULT INCALESCENT_Watch_Collect(INCALESCENT_Watch *watch) {
+    HRESULT result = S_OK;
+    DWORD size = 0;
+
+    if (!GetOverlappedResult(watch->directory, &watch->overlapped, &size, FALSE)) {
+        DWORD lastError = GetLastError();
+        if (lastError != ERROR_NOTIFY_ENUM_DIR) {
+            result = HRESULT_FROM_WIN32(lastError);
+            goto cleanup;
+        }
+        size = 0;
+    }
+
+    // No data means more changes happened than fit in the buffer.
+    if (size == 0) {
+        result = INCALESCENT_Watch_Rescan(watch);
+    } else {
+        PBYTE position = watch->buffer;
+        for (;;) {
+            FILE_NOTIFY_INFORMATION *information = (FILE_NOTIFY_INFORMATION *) position;
+            if (information->Action == FILE_ACTION_ADDED || information->Action == FILE_ACTION_MODIFIED ||
+                information->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                result = INCALESCENT_Watch_Touch(watch, information->FileName, information->FileNameLength / sizeof(WCHAR));
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+            }
+            if (information->NextEntryOffset == 0) {
+                break;
+            }
+            position += information->NextEntryOffset;
+        }
+    }
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Watch_Listen(watch);
+
+    cleanup:
+    return result;
+}
+
+// Ends the read of directory changes and closes the directory.
+static void INCALESCENT_Watch_Close(INCALESCENT_Watch *watch) {
+    // The pending read writes into the buffer, so it has to be finished before the memory goes away.
+    if (watch->directory != INVALID_HANDLE_VALUE) {
+        DWORD size = 0;
+        if (CancelIoEx(watch->directory, &watch->overlapped) || GetLastError() != ERROR_NOT_FOUND) {
+            GetOverlappedResult(watch->directory, &watch->overlapped, &size, TRUE);
+        }
+        CloseHandle(watch->directory);
+    }
+    if (watch->overlapped.hEvent != NULL) {
+        CloseHandle(watch->overlapped.hEvent);
+    }
+}
+#else
+// Starts reporting the changes to the directory.
+static HRESULT INCALESCENT_Watch_Open(INCALESCENT_Watch *watch) {
+    CHAR path[INCALESCENT_WATCH_PATH_SIZE * 2];
+
+    if (WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, watch->directoryPath, -1, path, sizeof(path), NULL, NULL) == 0) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    for (PSTR character = path; *character != '\0'; character++) {
+        if (*character == '\\') {
+            *character = '/';
+        }
+    }
+
+    watch->notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->notify < 0) {
+        return errno == ENOMEM ? E_OUTOFMEMORY : HRESULT_FROM_WIN32(ERROR_TOO_MANY_OPEN_FILES);
+    }
+    if (inotify_add_watch(watch->notify, path, INCALESCENT_WATCH_NOTIFY_FILTER | IN_ONLYDIR) < 0) {
+        return errno == ENOENT || errno == ENOTDIR ? HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND) : HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED);
+    }
+    return S_OK;
+}
+
+// Waits for the stop event or for changes to the directory, whichever comes first.
+static HRESULT INCALESCENT_Watch_Wait(INCALESCENT_Watch *watch, DWORD timeout, DWORD *waitResult) {
+    struct pollfd descriptors[2] = {
+            {.fd = INCALESCENT_Posix_Descriptor(watch->stopEvent), .events = POLLIN},
+            {.fd = watch->notify, .events = POLLIN},
+    };
+
+    INT ready = poll(descriptors, 2, timeout == INFINITE ? -1 : (INT) timeout);
+    if (ready < 0) {
+        // An interrupted wait is simply over early, and the caller works out how long is left.
+        if (errno != EINTR) {
+            return errno == ENOMEM ? E_OUTOFMEMORY : E_UNEXPECTED;
+        }
+        ready = 0;
+    }
+    if (ready == 0) {
+        *waitResult = WAIT_TIMEOUT;
+    } else {
+        *waitResult = descriptors[0].revents != 0 ? WAIT_OBJECT_0 : WAIT_OBJECT_0 + 1;
+    }
+    return S_OK;
+}
+
+// Collects every change that has been reported so far.
+static HRESULT INCALESCENT_Watch_Collect(INCALESCENT_Watch *watch) {
+    HRESULT result = S_OK;
+    WCHAR name[MAX_PATH + 1];
+
+    for (;;) {
+        ssize_t size = read(watch->notify, watch->buffer, INCALESCENT_WATCH_BUFFER_SIZE);
+        if (size < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                result = E_UNEXPECTED;
+            }
+            goto cleanup;
+        }
+
+        for (PBYTE position = watch->buffer; position < watch->buffer + size;) {
+            struct inotify_event *event = (struct inotify_event *) position;
+            position += sizeof(struct inotify_event) + event->len;
+
+            // An overflow means more changes happened than the kernel kept.
+            if (event->mask & IN_Q_OVERFLOW) {
+                result = INCALESCENT_Watch_Rescan(watch);
+                if (FAILED(result)) {
+                    goto cleanup;
+                }
+                continue;
+            }
+            if ((event->mask & IN_ISDIR) || event->len == 0) {
+                continue;
+            }
+
+            INT nameLength = MultiByteToWideChar(CP_UTF8, 0, event->name, -1, name, ARRAYSIZE(name));
+            if (nameLength == 0) {
+                continue;
+            }
+            result = INCALESCENT_Watch_Touch(watch, name, (SIZE_T) nameLength - 1);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+    }
+
+    cleanup:
+    return result;
+}
+
+// Stops reporting the changes to the directory.
+static void INCALESCENT_Watch_Close(INCALESCENT_Watch *watch) {
+    if (watch->notify >= 0) {
+        close(watch->notify);
+    }
+}
+#endif
+
+// Implementation for INCALESCENT_Watch_Create
+HRESULT INCALESCENT_Watch_Create(PCWSTR directory, PCWSTR suffix, HANDLE stopEvent, INCALESCENT_Arena *arena, INCALESCENT_Watch **watch) {
+    HRESULT result = S_OK;
+    INCALESCENT_Watch *intermediate = NULL;
+
+    result = INCALESCENT_Arena_Allocate(arena, sizeof(INCALESCENT_Watch), INCALESCENT_ARENA_DEFAULT_ALIGNMENT, (PVOID *) &intermediate);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    ZeroMemory(intermediate, sizeof(INCALESCENT_Watch));
+#ifdef _WIN32
+    intermediate->directory = INVALID_HANDLE_VALUE;
+#else
+    intermediate->notify = -1;
+#endif
+    intermediate->stopEvent = stopEvent;
+    intermediate->directoryPath = directory;
+    intermediate->suffix = suffix;
+    intermediate->suffixLength = lstrlenW(suffix);
+
+    result = INCALESCENT_Arena_Create(&intermediate->arena, INCALESCENT_WATCH_ARENA_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Create(&intermediate->batch, INCALESCENT_WATCH_ARENA_RESERVE);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&intermediate->arena, INCALESCENT_WATCH_BUFFER_SIZE, sizeof(DWORD), (PVOID *) &intermediate->buffer);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Arena_Allocate(&intermediate->arena, sizeof(INCALESCENT_Watch_Entry *) * INCALESCENT_WATCH_INITIAL_TABLE_SIZE,
+                                        sizeof(INCALESCENT_Watch_Entry *), (PVOID *) &intermediate->table);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    intermediate->tableMask = INCALESCENT_WATCH_INITIAL_TABLE_SIZE - 1;
+
+    result = INCALESCENT_Watch_Open(intermediate);
+
+    cleanup:
+    if (FAILED(result) && intermediate != NULL) {
+        INCALESCENT_Watch_Destroy(intermediate);
+        intermediate = NULL;
+    }
+    *watch = intermediate;
+    return result;
+}
+
+// Implementation for INCALESCENT_Watch_MarkKnown
+HRESULT INCALESCENT_Watch_MarkKnown(INCALESCENT_Watch *watch, PCWSTR name, SIZE_T nameLength) {
+    INCALESCENT_Watch_Entry *entry = NULL;
+    BOOL added = FALSE;
+
+    // A file that is already pending stays on the pending list, but won't be reported.
+    HRESULT result = INCALESCENT_Watch_Find(watch, name, nameLength, &entry, &added);
+    if (SUCCEEDED(result)) {
+        entry->state = INCALESCENT_WATCH_STATE_KNOWN;
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Watch_Hold
+HRESULT INCALESCENT_Watch_Hold(INCALESCENT_Watch *watch, PCWSTR name, SIZE_T nameLength) {
+    INCALESCENT_Watch_Entry *entry = NULL;
+    BOOL added = FALSE;
+
+    HRESULT result = INCALESCENT_Watch_Find(watch, name, nameLength, &entry, &added);
+    if (SUCCEEDED(result)) {
+        entry->retries++;
+        INCALESCENT_Watch_Defer(watch, entry);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Watch_Next
+HRESULT INCALESCENT_Watch_Next(INCALESCENT_Watch *watch, PWSTR **names, SIZE_T *count) {
+    HRESULT result = S_OK;
+
+    INCALESCENT_Arena_Reset(&watch->batch, 0);
+    *names = (PWSTR *) watch->batch.base;
+    *count = 0;
+
+    for (;;) {
+        // Move every settled file off the pending list and into the batch.
+        ULONGLONG now = GetTickCount64();
+        ULONGLONG wakeTime = 0;
+        INCALESCENT_Watch_Entry **link = &watch->pending;
+        while (*link != NULL) {
+            INCALESCENT_Watch_Entry *entry = *link;
+            if (entry->state != INCALESCENT_WATCH_STATE_PENDING) {
+                *link = entry->nextPending;
+                continue;
+            }
+            if (entry->settleTime > now) {
+                if (wakeTime == 0 || entry->settleTime < wakeTime) {
+                    wakeTime = entry->settleTime;
+                }
+                link = &entry->nextPending;
+                continue;
+            }
+
+            PWSTR *slot = NULL;
+            result = INCALESCENT_Arena_Allocate(&watch->batch, sizeof(PWSTR), sizeof(PWSTR), (PVOID *) &slot);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+            *slot = (PWSTR) (entry + 1);
+            (*count)++;
+            entry->state = INCALESCENT_WATCH_STATE_KNOWN;
+            *link = entry->nextPending;
+        }
+        if (*count != 0) {
+            goto cleanup;
+        }
+
+        DWORD timeout = wakeTime == 0 ? INFINITE : (DWORD) (wakeTime - now);
+        DWORD waitResult = WAIT_TIMEOUT;
+        result = INCALESCENT_Watch_Wait(watch, timeout, &waitResult);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        if (waitResult == WAIT_OBJECT_0) {
+            result = S_FALSE;
+            goto cleanup;
+        }
+        if (waitResult == WAIT_OBJECT_0 + 1) {
+            result = INCALESCENT_Watch_Collect(watch);
+            if (FAILED(result)) {
+                goto cleanup;
+            }
+        }
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Watch_Retry
+BOOL INCALESCENT_Watch_Retry(INCALESCENT_Watch *watch, PCWSTR name) {
+    INCALESCENT_Watch_Entry *entry = ((INCALESCENT_Watch_Entry *) name) - 1;
+    if (entry->retries == INCALESCENT_WATCH_MAX_RETRIES) {
+        return FALSE;
+    }
+    entry->retries++;
+    INCALESCENT_Watch_Defer(watch, entry);
+    return TRUE;
+}
+
+// Implementation for INCALESCENT_Watch_Destroy
+void INCALESCENT_Watch_Destroy(INCALESCENT_Watch *watch) {
+    if (watch == NULL) {
+        return;
+    }
+
+    INCALESCENT_Watch_Close(watch);
+    INCALESCENT_Arena_Destroy(&watch->batch);
+    INCALESCENT_Arena_Destroy(&watch->arena);
+}
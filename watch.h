@@ -0,0 +1,107 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_WATCH_H
+#define INCALESCENT_WATCH_H
+#include "arena.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef int BOOL;
+typedef unsigned short WCHAR;
+typedef WCHAR* PWSTR;
+typedef const WCHAR* PCWSTR;
+typedef void* HANDLE;
+typedef unsigned __int64 SIZE_T;
+
+#define INCALESCENT_WATCH_BUFFER_SIZE (64 * 1024)
+#define INCALESCENT_WATCH_ARENA_RESERVE (4ULL * 1024 * 1024 * 1024)
+#define INCALESCENT_WATCH_INITIAL_TABLE_SIZE 1024
+
+// How long a file has to go without changes before it counts as settled.
+#define INCALESCENT_WATCH_DEBOUNCE_MILLISECONDS 500
+
+typedef struct INCALESCENT_Watch INCALESCENT_Watch;
+
+/**
+ * @brief Starts watching a directory for new files.
+ *
+ * Changes are collected from the moment the watch is created, so a watch created before the
+ * directory is enumerated won't miss files that show up while the enumeration is running.
+ *
+ * @param[in] directory     The directory to watch. Subdirectories aren't watched.
+ * @param[in] suffix        Only files with names ending in this suffix (ignoring case) are reported.
+ * @param[in] stopEvent     An event that ends INCALESCENT_Watch_Next when it is signaled.
+ * @param[in] arena         The arena the watch is allocated from.
+ * @param[out] watch        Receives the watch. It must be released with INCALESCENT_Watch_Destroy.
+ *
+ * @return The result of the creation (S_OK if successful).
+ */
+HRESULT INCALESCENT_Watch_Create(PCWSTR directory, PCWSTR suffix, HANDLE stopEvent, INCALESCENT_Arena *arena, INCALESCENT_Watch **watch);
+
+/**
+ * @brief Marks a file as already handled, so changes to it are never reported.
+ *
+ * Every file is reported at most once. Reported files are marked automatically.
+ */
+HRESULT INCALESCENT_Watch_MarkKnown(INCALESCENT_Watch *watch, PCWSTR name, SIZE_T nameLength);
+
+/**
+ * @brief Holds a file back as if it had just changed, counting as its first retry.
+ *
+ * For files that were already there but turned out to still be in use or incomplete when they
+ * were first read, so they are reported once they have settled like new files.
+ */
+HRESULT INCALESCENT_Watch_Hold(INCALESCENT_Watch *watch, PCWSTR name, SIZE_T nameLength);
+
+/**
+ * @brief Waits for new files to settle.
+ *
+ * A new file is held back until it has gone INCALESCENT_WATCH_DEBOUNCE_MILLISECONDS without being
+ * changed, so files that are still being written aren't reported half-finished.
+ *
+ * @param[in] watch     The watch.
+ * @param[out] names    Receives the names of the settled files, which stay valid until the watch
+ *                      is destroyed. The array itself is only valid until the next call.
+ * @param[out] count    Receives the number of settled files.
+ *
+ * @return S_OK once at least one file has settled, S_FALSE once the stop event is signaled, or
+ *         the failure that ended the watch.
+ */
+HRESULT INCALESCENT_Watch_Next(INCALESCENT_Watch *watch, PWSTR **names, SIZE_T *count);
+
+/**
+ * @brief Puts a reported file back to wait for another debounce period.
+ *
+ * For files that turned out to still be in use or incomplete when they were read.
+ *
+ * @param[in] watch     The watch.
+ * @param[in] name      A name reported by INCALESCENT_Watch_Next.
+ *
+ * @return FALSE if the file has already been retried too many times and was given up on.
+ */
+BOOL INCALESCENT_Watch_Retry(INCALESCENT_Watch *watch, PCWSTR name);
+
+void INCALESCENT_Watch_Destroy(INCALESCENT_Watch *watch);
+
+#endif //INCALESCENT_WATCH_H
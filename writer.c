@@ -0,0 +1,225 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <windows.h>
+#include "writer.h"
+
+static const char INCALESCENT_Writer_DigitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+// Implementation for INCALESCENT_Writer_Create
+HRESULT INCALESCENT_Writer_Create(INCALESCENT_Writer *writer, HANDLE file, INCALESCENT_Writer_Encoding encoding, INCALESCENT_Arena *arena) {
+    HRESULT result = S_OK;
+
+    ZeroMemory(writer, sizeof(INCALESCENT_Writer));
+    writer->file = file;
+    writer->encoding = encoding;
+
+    result = INCALESCENT_Arena_Allocate(arena, INCALESCENT_WRITER_BUFFER_SIZE, INCALESCENT_ARENA_COMMIT_GRANULARITY, (PVOID *) &writer->buffer);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    if (encoding == INCALESCENT_WRITER_ENCODING_UTF16LE) {
+        writer->buffer[writer->used++] = 0xFF;
+        writer->buffer[writer->used++] = 0xFE;
+    }
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Writer_CreateCompressed
+HRESULT INCALESCENT_Writer_CreateCompressed(INCALESCENT_Writer *writer, HANDLE file, INCALESCENT_Writer_Encoding encoding,
+                                            INCALESCENT_Arena *arena) {
+    HRESULT result = INCALESCENT_Writer_Create(writer, file, encoding, arena);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+
+    result = INCALESCENT_Arena_Allocate(arena, INCALESCENT_WRITER_BUFFER_SIZE, INCALESCENT_ARENA_COMMIT_GRANULARITY, (PVOID *) &writer->spare);
+    if (FAILED(result)) {
+        goto cleanup;
+    }
+    result = INCALESCENT_Gzip_Create(file, INCALESCENT_WRITER_BUFFER_SIZE, &writer->gzip);
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Writer_Flush
+HRESULT INCALESCENT_Writer_Flush(INCALESCENT_Writer *writer) {
+    HRESULT result = S_OK;
+
+    if (writer->used == 0) {
+        goto cleanup;
+    }
+
+    // The full buffer goes to the stream's thread, and the text goes on into the other one.
+    if (writer->gzip != NULL) {
+        result = INCALESCENT_Gzip_Write(writer->gzip, writer->buffer, writer->used);
+        if (FAILED(result)) {
+            goto cleanup;
+        }
+        PBYTE written = writer->buffer;
+        writer->buffer = writer->spare;
+        writer->spare = written;
+    } else {
+        DWORD writeCount = 0;
+        BOOL writeResult = WriteFile(writer->file, writer->buffer, (DWORD) writer->used, &writeCount, NULL);
+        if (!writeResult) {
+            result = HRESULT_FROM_WIN32(GetLastError());
+            goto cleanup;
+        }
+        if (writeCount != writer->used) {
+            result = HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+            goto cleanup;
+        }
+    }
+    writer->bytesWritten += writer->used;
+    writer->used = 0;
+
+    cleanup:
+    return result;
+}
+
+// Implementation for INCALESCENT_Writer_Finish
+HRESULT INCALESCENT_Writer_Finish(INCALESCENT_Writer *writer) {
+    HRESULT result = INCALESCENT_Writer_Flush(writer);
+    if (SUCCEEDED(result) && writer->gzip != NULL) {
+        result = INCALESCENT_Gzip_Finish(writer->gzip);
+    }
+    return result;
+}
+
+// Implementation for INCALESCENT_Writer_Destroy
+void INCALESCENT_Writer_Destroy(INCALESCENT_Writer *writer) {
+    INCALESCENT_Gzip_Destroy(writer->gzip);
+    writer->gzip = NULL;
+}
+
+// Implementation for INCALESCENT_Writer_Reserve
+HRESULT INCALESCENT_Writer_Reserve(INCALESCENT_Writer *writer, SIZE_T size) {
+    if (size > INCALESCENT_WRITER_BUFFER_SIZE) {
+        return E_INVALIDARG;
+    }
+    if (INCALESCENT_WRITER_BUFFER_SIZE - writer->used >= size) {
+        return S_OK;
+    }
+    return INCALESCENT_Writer_Flush(writer);
+}
+
+// Implementation for INCALESCENT_Writer_AppendAscii
+void INCALESCENT_Writer_AppendAscii(INCALESCENT_Writer *writer, PCSTR string, SIZE_T length) {
+    PBYTE output = writer->buffer + writer->used;
+
+    if (writer->encoding == INCALESCENT_WRITER_ENCODING_UTF16LE) {
+        for (SIZE_T index = 0; index < length; index++) {
+            *output++ = (BYTE) string[index];
+            *output++ = 0;
+        }
+    } else {
+        CopyMemory(output, string, length);
+        output += length;
+    }
+
+    writer->used = output - writer->buffer;
+}
+
+// Implementation for INCALESCENT_Writer_AppendString
+void INCALESCENT_Writer_AppendString(INCALESCENT_Writer *writer, PCWSTR string, SIZE_T length) {
+    PBYTE output = writer->buffer + writer->used;
+
+    if (writer->encoding == INCALESCENT_WRITER_ENCODING_UTF16LE) {
+        CopyMemory(output, string, sizeof(WCHAR) * length);
+        writer->used += sizeof(WCHAR) * length;
+        return;
+    }
+
+    for (SIZE_T index = 0; index < length; index++) {
+        DWORD character = string[index];
+
+        if (character < 0x80) {
+            *output++ = (BYTE) character;
+            continue;
+        }
+        if (character < 0x800) {
+            *output++ = (BYTE) (0xC0 | (character >> 6));
+            *output++ = (BYTE) (0x80 | (character & 0x3F));
+            continue;
+        }
+
+        // Combine a surrogate pair into its code point. A surrogate without its other half can't be
+        // represented in UTF-8 and is replaced with U+FFFD.
+        if (character >= 0xD800 && character <= 0xDFFF) {
+            if (character <= 0xDBFF && index + 1 < length && string[index + 1] >= 0xDC00 && string[index + 1] <= 0xDFFF) {
+                character = 0x10000 + ((character - 0xD800) << 10) + (string[index + 1] - 0xDC00);
+                index++;
+
+                *output++ = (BYTE) (0xF0 | (character >> 18));
+                *output++ = (BYTE) (0x80 | ((character >> 12) & 0x3F));
+                *output++ = (BYTE) (0x80 | ((character >> 6) & 0x3F));
+                *output++ = (BYTE) (0x80 | (character & 0x3F));
+                continue;
+            }
+            character = 0xFFFD;
+        }
+
+        *output++ = (BYTE) (0xE0 | (character >> 12));
+        *output++ = (BYTE) (0x80 | ((character >> 6) & 0x3F));
+        *output++ = (BYTE) (0x80 | (character & 0x3F));
+    }
+
+    writer->used = output - writer->buffer;
+}
+
+// Implementation for INCALESCENT_Writer_AppendUnsigned
+void INCALESCENT_Writer_AppendUnsigned(INCALESCENT_Writer *writer, SIZE_T value) {
+    char digits[INCALESCENT_WRITER_UNSIGNED_MAX_DIGITS];
+    SIZE_T start = INCALESCENT_WRITER_UNSIGNED_MAX_DIGITS;
+
+    // Produce the digits from the back, two at a time.
+    while (value >= 100) {
+        SIZE_T pair = (value % 100) * 2;
+        value /= 100;
+        digits[--start] = INCALESCENT_Writer_DigitPairs[pair + 1];
+        digits[--start] = INCALESCENT_Writer_DigitPairs[pair];
+    }
+    if (value >= 10) {
+        digits[--start] = INCALESCENT_Writer_DigitPairs[(value * 2) + 1];
+        digits[--start] = INCALESCENT_Writer_DigitPairs[value * 2];
+    } else {
+        digits[--start] = (char) ('0' + value);
+    }
+
+    INCALESCENT_Writer_AppendAscii(writer, digits + start, INCALESCENT_WRITER_UNSIGNED_MAX_DIGITS - start);
+}
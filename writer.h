@@ -0,0 +1,115 @@
+/*
+ * The MIT License
+ *
+ * Copyright (c) 2023 Daniel Landeros
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCALESCENT_WRITER_H
+#define INCALESCENT_WRITER_H
+#include "arena.h"
+#include "gzip.h"
+#include "platform.h"
+
+// Forward declarations from <windows.h>
+typedef void* HANDLE;
+typedef unsigned short WCHAR;
+typedef const WCHAR* PCWSTR;
+typedef const char* PCSTR;
+typedef unsigned char* PBYTE;
+typedef unsigned __int64 SIZE_T;
+
+#define INCALESCENT_WRITER_BUFFER_SIZE (4 * 1024 * 1024)
+#define INCALESCENT_WRITER_UNSIGNED_MAX_DIGITS 20
+
+// The most bytes a single UTF-16 code unit can take in either output encoding. A surrogate pair
+// takes 4 bytes in UTF-8, which is 2 per code unit, while any other character takes at most 3.
+#define INCALESCENT_WRITER_MAX_BYTES_PER_UNIT 3
+
+typedef enum INCALESCENT_Writer_Encoding {
+    INCALESCENT_WRITER_ENCODING_UTF8 = 0,
+    INCALESCENT_WRITER_ENCODING_UTF16LE = 1,
+} INCALESCENT_Writer_Encoding;
+
+/**
+ * @brief A buffered writer for text output.
+ *
+ * Text is encoded straight into a large buffer, which is written to the file in blocks of
+ * INCALESCENT_WRITER_BUFFER_SIZE bytes. The output is UTF-8 without a byte order mark, or
+ * UTF-16LE with one for programs that otherwise don't recognize it.
+ *
+ * A compressed writer hands every block to a gzip stream instead, which compresses it on a thread
+ * of its own while the next block is encoded into a second buffer.
+ */
+typedef struct INCALESCENT_Writer {
+    HANDLE file;
+    INCALESCENT_Writer_Encoding encoding;
+    PBYTE buffer;
+    SIZE_T used;
+    SIZE_T bytesWritten;
+    INCALESCENT_Gzip *gzip;
+    PBYTE spare;
+} INCALESCENT_Writer;
+
+/**
+ * @brief Initializes a writer and writes the byte order mark, if the encoding has one.
+ *
+ * @param[out] writer   The writer to initialize.
+ * @param[in] file      The file to write to. The writer doesn't take ownership of it.
+ * @param[in] encoding  The encoding of the output.
+ * @param[in] arena     The arena the output buffer is allocated from.
+ *
+ * @return The result of the initialization (S_OK if successful).
+ */
+HRESULT INCALESCENT_Writer_Create(INCALESCENT_Writer *writer, HANDLE file, INCALESCENT_Writer_Encoding encoding, INCALESCENT_Arena *arena);
+
+/**
+ * @brief Initializes a writer whose output is written to the file as a gzip stream.
+ *
+ * The writer must be ended with INCALESCENT_Writer_Finish, which completes the stream, and released
+ * with INCALESCENT_Writer_Destroy.
+ *
+ * @return The result of the initialization (S_OK if successful).
+ */
+HRESULT INCALESCENT_Writer_CreateCompressed(INCALESCENT_Writer *writer, HANDLE file, INCALESCENT_Writer_Encoding encoding,
+                                            INCALESCENT_Arena *arena);
+
+/**
+ * @brief Makes sure that the buffer has room for the given number of bytes, flushing it if not.
+ *
+ * The Append functions don't check for room themselves, so a caller reserves the most space a
+ * group of them can take first. Callers can bound the size with INCALESCENT_WRITER_MAX_BYTES_PER_UNIT
+ * and INCALESCENT_WRITER_UNSIGNED_MAX_DIGITS.
+ */
+HRESULT INCALESCENT_Writer_Reserve(INCALESCENT_Writer *writer, SIZE_T size);
+
+void INCALESCENT_Writer_AppendAscii(INCALESCENT_Writer *writer, PCSTR string, SIZE_T length);
+void INCALESCENT_Writer_AppendString(INCALESCENT_Writer *writer, PCWSTR string, SIZE_T length);
+void INCALESCENT_Writer_AppendUnsigned(INCALESCENT_Writer *writer, SIZE_T value);
+
+HRESULT INCALESCENT_Writer_Flush(INCALESCENT_Writer *writer);
+
+// Flushes the writer and, for a compressed writer, completes the stream. Nothing can be appended
+// to a compressed writer afterward.
+HRESULT INCALESCENT_Writer_Finish(INCALESCENT_Writer *writer);
+
+// Stops the compression of a compressed writer. Does nothing for any other writer.
+void INCALESCENT_Writer_Destroy(INCALESCENT_Writer *writer);
+
+#endif //INCALESCENT_WRITER_H